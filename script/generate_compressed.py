@@ -0,0 +1,195 @@
+# This script compresses signed firmware images for the streaming
+# decompressor on the device (CONFIG_RPR_DFU_COMPRESSED).
+#
+# The coder is a heatshrink-style LZSS: the device needs only a window of
+# 2^W bytes to decode, so W must not be larger than
+# CONFIG_RPR_DFU_COMPRESSED_WINDOW_BITS. Every image is decompressed back on
+# the host and checked before it is written.
+#
+# Example:
+#   python generate_compressed.py image.bin -o image.hs
+#
+# Example, with a smaller window for a device with less RAM:
+#   python generate_compressed.py image.bin --window-bits 8 --lookahead-bits 4
+
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+MAGIC = b"RPRZ"
+VERSION = 1
+HEADER = struct.Struct("<4sBBBxI")
+
+WINDOW_BITS = 10
+MIN_WINDOW_BITS = 8    # range of CONFIG_RPR_DFU_COMPRESSED_WINDOW_BITS
+MAX_WINDOW_BITS = 12
+LOOKAHEAD_BITS = 4
+KEY = 3            # bytes hashed to find match candidates
+CHAIN = 32         # candidates tried per position
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.bits = 0
+        self.count = 0
+
+    def push(self, value, width):
+        self.bits = (self.bits << width) | value
+        self.count += width
+        while self.count >= 8:
+            self.count -= 8
+            self.out.append((self.bits >> self.count) & 0xFF)
+        self.bits &= (1 << self.count) - 1
+
+    def finish(self):
+        if self.count:
+            self.out.append((self.bits << (8 - self.count)) & 0xFF)
+        return bytes(self.out)
+
+
+def compress(data, window_bits=WINDOW_BITS, lookahead_bits=LOOKAHEAD_BITS):
+    """Returns the compressed stream of data, header included."""
+    window = 1 << window_bits
+    max_len = 1 << lookahead_bits
+    # A copy must take fewer bits than the literals it replaces
+    min_len = (1 + window_bits + lookahead_bits) // 9 + 1
+
+    chains = {}
+    writer = BitWriter()
+    i = 0
+
+    def find(pos):
+        best_len = 0
+        best_dist = 0
+        limit = min(max_len, len(data) - pos)
+        for cand in reversed(chains.get(data[pos:pos + KEY], ())[-CHAIN:]):
+            if pos - cand > window:
+                break
+            if data[cand + best_len] != data[pos + best_len]:
+                continue
+            n = 0
+            while n < limit and data[cand + n] == data[pos + n]:
+                n += 1
+            if n > best_len:
+                best_len = n
+                best_dist = pos - cand
+                if n == limit:
+                    break
+        return best_len, best_dist
+
+    def index(pos):
+        if pos + KEY <= len(data):
+            chain = chains.setdefault(data[pos:pos + KEY], [])
+            chain.append(pos)
+            if len(chain) > 4 * CHAIN:
+                del chain[:-CHAIN]
+
+    while i < len(data):
+        length, dist = find(i)
+        if length >= min_len:
+            writer.push(0, 1)
+            writer.push(dist - 1, window_bits)
+            writer.push(length - 1, lookahead_bits)
+            for pos in range(i, i + length):
+                index(pos)
+            i += length
+        else:
+            writer.push(1, 1)
+            writer.push(data[i], 8)
+            index(i)
+            i += 1
+
+    header = HEADER.pack(MAGIC, VERSION, window_bits, lookahead_bits,
+                         len(data))
+    return header + writer.finish()
+
+
+def decompress(stream):
+    """Decodes a stream like the device does, for checking."""
+    magic, version, window_bits, lookahead_bits, size = \
+        HEADER.unpack_from(stream)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a compressed image")
+
+    out = bytearray()
+    bits = 0
+    count = 0
+    pos = HEADER.size
+
+    def take(width):
+        nonlocal bits, count, pos
+        while count < width:
+            if pos == len(stream):
+                return None
+            bits = (bits << 8) | stream[pos]
+            pos += 1
+            count += 8
+        count -= width
+        value = (bits >> count) & ((1 << width) - 1)
+        bits &= (1 << count) - 1
+        return value
+
+    while len(out) < size:
+        tag = take(1)
+        if tag is None:
+            break
+        if tag:
+            out.append(take(8))
+        else:
+            dist = take(window_bits) + 1
+            length = take(lookahead_bits) + 1
+            for _ in range(length):
+                out.append(out[-dist] if dist <= len(out) else 0)
+
+    if len(out) != size:
+        raise ValueError("compressed image incomplete")
+    return bytes(out)
+
+
+def write_compressed(image_path, out_path, window_bits=WINDOW_BITS,
+                     lookahead_bits=LOOKAHEAD_BITS):
+    image = Path(image_path).read_bytes()
+    stream = compress(image, window_bits, lookahead_bits)
+
+    if decompress(stream) != image:
+        print(f"❌ {out_path} does not decompress to {image_path}")
+        return False
+
+    Path(out_path).write_bytes(stream)
+    print(f"📦 {Path(out_path).name}: {len(stream)} B instead of {len(image)} B "
+          f"({100 * len(stream) / len(image):.1f} %), "
+          f"decoder window {1 << window_bits} B")
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compress signed firmware images for streaming updates")
+    parser.add_argument("image", help="signed image to compress")
+    parser.add_argument("-o", "--output", help="compressed file to write")
+    parser.add_argument("--window-bits", type=int, default=WINDOW_BITS,
+                        help=f"window of 2^N bytes, {MIN_WINDOW_BITS}.."
+                             f"{MAX_WINDOW_BITS}, at most the device "
+                             f"CONFIG_RPR_DFU_COMPRESSED_WINDOW_BITS")
+    parser.add_argument("--lookahead-bits", type=int, default=LOOKAHEAD_BITS,
+                        help="copies of up to 2^N bytes, 3..window bits - 1")
+    args = parser.parse_args()
+
+    if not MIN_WINDOW_BITS <= args.window_bits <= MAX_WINDOW_BITS or \
+            not 3 <= args.lookahead_bits < args.window_bits:
+        parser.error("invalid window or lookahead bits")
+
+    if not Path(args.image).is_file():
+        print(f"❌ File {args.image} not found.")
+        return 1
+
+    out = args.output or str(Path(args.image).with_suffix(".hs"))
+    ok = write_compressed(args.image, out, args.window_bits,
+                          args.lookahead_bits)
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,291 @@
+# This script makes delta patches between signed firmware images, to be
+# applied on the device by the streaming applier (CONFIG_RPR_DFU_DELTA).
+#
+# A patch rebuilds the new image from the running one. Unchanged code is
+# copied from the running image with a byte diff that is mostly zeros, so
+# code that only moved or had a few addresses changed costs a few bytes;
+# new code is inserted as it is. Every patch is applied back on the host
+# and checked against the new image before it is written.
+#
+# Example, one patch:
+#   python generate_delta.py old.bin new.bin -o new_from_old.delta
+#
+# Example, patches to the newest image of every board in firmware_updates
+# from each older image of the same board (also run by generate_updates.py):
+#   python generate_delta.py --dir ../firmware_updates
+
+import argparse
+import hashlib
+import re
+import struct
+import sys
+from pathlib import Path
+
+MAGIC = b"RPRD"
+VERSION = 1
+HEADER = struct.Struct("<4sB3xII32s32s")
+
+OP_END = 0x00
+OP_COPY = 0x01
+OP_INSERT = 0x02
+
+SEED = 8           # bytes of an exact match to start a copy from
+CANDIDATES = 8     # source positions kept per seed
+GIVE_UP = 32       # score drop that ends the extension of a copy
+MIN_SCORE = 16     # 2 * matching bytes - length, for a copy to pay off
+ZERO_GAP = 3       # shorter zero runs stay inside a literal run
+
+IMAGE_NAME = re.compile(r"^(?P<board>.+)_rapidreach-fw_V(?P<ver>\d+\.\d+\.\d+)\.bin$")
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(value):
+    return (value << 1) ^ (value >> 31) if value >= 0 else ((-value) << 1) - 1
+
+
+def extend(old, new, s, t):
+    """Returns the length and score of the best approximate match."""
+    best_len = 0
+    best_score = 0
+    score = 0
+    limit = min(len(old) - s, len(new) - t)
+    i = 0
+    while i < limit:
+        score += 1 if old[s + i] == new[t + i] else -1
+        i += 1
+        if score > best_score:
+            best_score = score
+            best_len = i
+        elif score < best_score - GIVE_UP:
+            break
+    return best_len, best_score
+
+
+def encode_diff(old, new, s, t, length):
+    diff = bytes((new[t + i] - old[s + i]) & 0xFF for i in range(length))
+    out = bytearray()
+    pos = 0
+    while pos < length:
+        zeros = pos
+        while zeros < length and diff[zeros] == 0:
+            zeros += 1
+        lits = zeros
+        while lits < length:
+            if diff[lits] != 0:
+                lits += 1
+                continue
+            gap = lits
+            while gap < length and diff[gap] == 0 and gap - lits < ZERO_GAP:
+                gap += 1
+            if gap == length or gap - lits >= ZERO_GAP:
+                break
+            lits = gap
+        out += varint(zeros - pos)
+        if zeros == length:
+            break
+        out += varint(lits - zeros)
+        out += diff[zeros:lits]
+        pos = lits
+    return bytes(out)
+
+
+def make_delta(old, new):
+    """Returns the patch that rebuilds new from old."""
+    index = {}
+    for i in range(len(old) - SEED + 1):
+        positions = index.setdefault(old[i:i + SEED], [])
+        if len(positions) < CANDIDATES:
+            positions.append(i)
+
+    ops = bytearray()
+    src_pos = 0          # source position after the last copy
+    insert_from = 0      # start of the bytes not covered yet
+    t = 0
+
+    def flush_insert(end):
+        if end > insert_from:
+            ops.append(OP_INSERT)
+            ops.extend(varint(end - insert_from))
+            ops.extend(new[insert_from:end])
+
+    while t < len(new):
+        candidates = []
+        if src_pos < len(old):
+            ahead = min(SEED, len(old) - src_pos, len(new) - t)
+            same = sum(old[src_pos + i] == new[t + i] for i in range(ahead))
+            if ahead and same * 2 >= ahead:
+                candidates.append(src_pos)
+        candidates += index.get(new[t:t + SEED], [])
+
+        best = None
+        for s in candidates:
+            length, score = extend(old, new, s, t)
+            if best is None or score > best[2]:
+                best = (s, length, score)
+
+        if best is None or best[2] < MIN_SCORE:
+            t += 1
+            continue
+
+        s, length, _ = best
+        while t > insert_from and s > 0 and old[s - 1] == new[t - 1]:
+            s -= 1
+            t -= 1
+            length += 1
+
+        flush_insert(t)
+        ops.append(OP_COPY)
+        ops.extend(varint(zigzag(s - src_pos)))
+        ops.extend(varint(length))
+        ops.extend(encode_diff(old, new, s, t, length))
+
+        src_pos = s + length
+        t += length
+        insert_from = t
+
+    flush_insert(len(new))
+    ops.append(OP_END)
+
+    header = HEADER.pack(MAGIC, VERSION, len(old), len(new),
+                         hashlib.sha256(old).digest(),
+                         hashlib.sha256(new).digest())
+    return header + bytes(ops)
+
+
+def read_varint(patch, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = patch[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def apply_delta(old, patch):
+    """Rebuilds the new image like the device does, for checking."""
+    magic, version, old_size, new_size, old_hash, new_hash = \
+        HEADER.unpack_from(patch)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a delta patch")
+    if old_size != len(old) or hashlib.sha256(old).digest() != old_hash:
+        raise ValueError("patch made for another source image")
+
+    out = bytearray()
+    pos = HEADER.size
+    src = 0
+    while True:
+        op = patch[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_COPY:
+            seek, pos = read_varint(patch, pos)
+            src += (seek >> 1) ^ -(seek & 1)
+            left, pos = read_varint(patch, pos)
+            while left:
+                zeros, pos = read_varint(patch, pos)
+                out += old[src:src + zeros]
+                src += zeros
+                left -= zeros
+                if not left:
+                    break
+                lits, pos = read_varint(patch, pos)
+                for i in range(lits):
+                    out.append((old[src + i] + patch[pos + i]) & 0xFF)
+                pos += lits
+                src += lits
+                left -= lits
+        elif op == OP_INSERT:
+            length, pos = read_varint(patch, pos)
+            out += patch[pos:pos + length]
+            pos += length
+        else:
+            raise ValueError("unknown op 0x%02x" % op)
+
+    if len(out) != new_size or hashlib.sha256(out).digest() != new_hash:
+        raise ValueError("rebuilt image does not match")
+    return bytes(out)
+
+
+def write_delta(old_path, new_path, out_path):
+    old = Path(old_path).read_bytes()
+    new = Path(new_path).read_bytes()
+    patch = make_delta(old, new)
+
+    if apply_delta(old, patch) != new:
+        print(f"❌ Patch {out_path} does not rebuild {new_path}")
+        return False
+
+    Path(out_path).write_bytes(patch)
+    print(f"📦 {Path(out_path).name}: {len(patch)} B instead of {len(new)} B "
+          f"({100 * len(patch) / len(new):.1f} %)")
+    return True
+
+
+def version_key(version):
+    return tuple(int(v) for v in version.split("."))
+
+
+def generate_dir(folder):
+    """Makes patches to the newest image of each board from the older ones."""
+    boards = {}
+    for path in Path(folder).glob("*.bin"):
+        m = IMAGE_NAME.match(path.name)
+        if m:
+            boards.setdefault(m.group("board"), []).append(
+                (version_key(m.group("ver")), m.group("ver"), path))
+
+    made = []
+    for board, images in sorted(boards.items()):
+        images.sort()
+        _, newest, new_path = images[-1]
+        for _, version, old_path in images[:-1]:
+            out = new_path.with_name(
+                f"{new_path.stem}_from_V{version}.delta")
+            if write_delta(old_path, new_path, out):
+                made.append(out)
+    return made
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Make delta patches between signed firmware images")
+    parser.add_argument("old", nargs="?", help="image running on the device")
+    parser.add_argument("new", nargs="?", help="image to update to")
+    parser.add_argument("-o", "--output", help="patch file to write")
+    parser.add_argument("--dir",
+                        help="make patches for every board in this folder")
+    args = parser.parse_args()
+
+    if args.dir:
+        if not Path(args.dir).is_dir():
+            print(f"❌ Folder {args.dir} not found.")
+            return 1
+        made = generate_dir(args.dir)
+        if not made:
+            print("⚠️ No older images to make patches from.")
+        return 0
+
+    if not args.old or not args.new:
+        parser.error("give the old and new images, or --dir")
+
+    out = args.output or str(Path(args.new).with_suffix(".delta"))
+    return 0 if write_delta(args.old, args.new, out) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,221 @@
+# This script designs a speaker-correction EQ profile for the audio player.
+# Each filter is an RBJ cookbook biquad, quantized to the Q14 format used
+# by the firmware and written as one "b0 b1 b2 a1 a2" line per stage.
+#
+# Example:
+#   python generate_eq_profile.py -o eq.txt --highpass 80 --lowshelf 150,6 \
+#       --peak 2500,-4,2
+#
+# Pass --sample-rate when CONFIG_RPR_SAMPLE_FREQ is not 48000.
+#
+# With --golden the script also writes the golden vectors of the firmware
+# self test: a test signal filtered by a plain integer model of the Q14
+# biquads, independent of the firmware kernels.
+#   python generate_eq_profile.py -o /dev/null --highpass 80 \
+#       --peak 3000,6 --golden ../src/audio_player/audio_eq_golden.h
+#
+# Upload the resulting file to the device (default /lfs/eq.txt) and run
+# "rapidreach audio eq load".
+
+import argparse
+import cmath
+import math
+import sys
+
+SAMPLE_RATE = 48000
+COEF_SHIFT = 14
+COEF_ONE = 1 << COEF_SHIFT
+INT16_MIN = -32768
+INT16_MAX = 32767
+GOLDEN_SAMPLES = 256
+GOLDEN_SEED = 0x1234567
+
+
+def highpass(f0, q=0.7071):
+    w0 = 2 * math.pi * f0 / SAMPLE_RATE
+    alpha = math.sin(w0) / (2 * q)
+    cw = math.cos(w0)
+    b = [(1 + cw) / 2, -(1 + cw), (1 + cw) / 2]
+    a = [1 + alpha, -2 * cw, 1 - alpha]
+    return b, a
+
+
+def lowshelf(f0, gain_db, s=1.0):
+    amp = 10 ** (gain_db / 40)
+    w0 = 2 * math.pi * f0 / SAMPLE_RATE
+    cw = math.cos(w0)
+    alpha = math.sin(w0) / 2 * math.sqrt((amp + 1 / amp) * (1 / s - 1) + 2)
+    sq = 2 * math.sqrt(amp) * alpha
+    b = [amp * ((amp + 1) - (amp - 1) * cw + sq),
+         2 * amp * ((amp - 1) - (amp + 1) * cw),
+         amp * ((amp + 1) - (amp - 1) * cw - sq)]
+    a = [(amp + 1) + (amp - 1) * cw + sq,
+         -2 * ((amp - 1) + (amp + 1) * cw),
+         (amp + 1) + (amp - 1) * cw - sq]
+    return b, a
+
+
+def peak(f0, gain_db, q=1.0):
+    amp = 10 ** (gain_db / 40)
+    w0 = 2 * math.pi * f0 / SAMPLE_RATE
+    alpha = math.sin(w0) / (2 * q)
+    cw = math.cos(w0)
+    b = [1 + alpha * amp, -2 * cw, 1 - alpha * amp]
+    a = [1 + alpha / amp, -2 * cw, 1 - alpha / amp]
+    return b, a
+
+
+def quantize(b, a):
+    coef = [b[0] / a[0], b[1] / a[0], b[2] / a[0], a[1] / a[0], a[2] / a[0]]
+    q = [int(round(c * COEF_ONE)) for c in coef]
+    if any(v < INT16_MIN or v > INT16_MAX for v in q):
+        return None
+    return q
+
+
+def response_db(stages, freq):
+    z = cmath.exp(-2j * math.pi * freq / SAMPLE_RATE)
+    h = 1
+    for b0, b1, b2, a1, a2 in stages:
+        num = (b0 + b1 * z + b2 * z * z) / COEF_ONE
+        den = 1 + (a1 * z + a2 * z * z) / COEF_ONE
+        h *= num / den
+    return 20 * math.log10(max(abs(h), 1e-9))
+
+
+def filter_q14(stages, signal):
+    # y = (b0 x0 + b1 x1 + b2 x2 - a1 y1 - a2 y2 + 0.5) >> 14, saturated
+    out = list(signal)
+    for b0, b1, b2, a1, a2 in stages:
+        x1 = x2 = y1 = y2 = 0
+        for i, x in enumerate(out):
+            acc = (COEF_ONE >> 1) + b0 * x + b1 * x1 + b2 * x2 \
+                - a1 * y1 - a2 * y2
+            y = max(INT16_MIN, min(INT16_MAX, acc >> COEF_SHIFT))
+            x2, x1 = x1, x
+            y2, y1 = y1, y
+            out[i] = y
+    return out
+
+
+def golden_signal():
+    # Full-scale square wave to drive the stages into saturation, then
+    # pseudo-random noise
+    signal = [INT16_MAX if (i // 8) % 2 == 0 else INT16_MIN
+              for i in range(GOLDEN_SAMPLES // 4)]
+    seed = GOLDEN_SEED
+    while len(signal) < GOLDEN_SAMPLES:
+        seed = (seed * 1664525 + 1013904223) & 0xFFFFFFFF
+        value = seed >> 16
+        signal.append(value - 0x10000 if value > INT16_MAX else value)
+    return signal
+
+
+def c_array(values, indent="    ", per_line=8):
+    rows = []
+    for i in range(0, len(values), per_line):
+        rows.append(indent + ", ".join(f"{v:6d}" for v in
+                                       values[i:i + per_line]) + ",")
+    return "\n".join(rows)
+
+
+def write_golden(path, stages):
+    signal = golden_signal()
+    expected = filter_q14(stages, signal)
+    coef = "\n".join("    { " + ", ".join(str(v) for v in q) + " },"
+                     for q in stages)
+    with open(path, "w") as f:
+        f.write(f"""/**
+ * @file audio_eq_golden.h
+ * @brief Golden vectors of the equalizer self test.
+ *
+ * Generated by script/generate_eq_profile.py --golden, do not edit. The
+ * expected output comes from an integer model of the Q14 biquads in the
+ * script, not from the firmware kernels.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_EQ_GOLDEN_H_
+#define AUDIO_EQ_GOLDEN_H_
+
+#include <stdint.h>
+
+static const int16_t eq_golden_coef[][5] = {{
+{coef}
+}};
+
+static const int16_t eq_golden_in[{GOLDEN_SAMPLES}] = {{
+{c_array(signal)}
+}};
+
+static const int16_t eq_golden_out[{GOLDEN_SAMPLES}] = {{
+{c_array(expected)}
+}};
+
+#endif /* AUDIO_EQ_GOLDEN_H_ */
+""")
+
+
+def parse_args_list(value, count):
+    parts = [float(v) for v in value.split(",")]
+    if not 1 <= len(parts) <= count:
+        raise argparse.ArgumentTypeError(f"expected up to {count} values")
+    return parts
+
+
+parser = argparse.ArgumentParser(description="Generate Q14 biquad EQ profile")
+parser.add_argument("-o", "--output", default="eq.txt", help="Output file")
+parser.add_argument("--sample-rate", type=int, default=SAMPLE_RATE,
+                    help="Sample rate in Hz, CONFIG_RPR_SAMPLE_FREQ")
+parser.add_argument("--highpass", action="append", default=[],
+                    type=lambda v: parse_args_list(v, 2), metavar="F[,Q]")
+parser.add_argument("--lowshelf", action="append", default=[],
+                    type=lambda v: parse_args_list(v, 3), metavar="F,DB[,S]")
+parser.add_argument("--peak", action="append", default=[],
+                    type=lambda v: parse_args_list(v, 3), metavar="F,DB[,Q]")
+parser.add_argument("--golden", metavar="HEADER",
+                    help="Also write the self test vectors for the profile")
+args = parser.parse_args()
+
+if args.sample_rate <= 0:
+    print("❌ The sample rate must be positive.")
+    sys.exit(1)
+SAMPLE_RATE = args.sample_rate
+
+designs = []
+for p in args.highpass:
+    designs.append((f"highpass {p}", highpass(*p)))
+for p in args.lowshelf:
+    designs.append((f"lowshelf {p}", lowshelf(*p)))
+for p in args.peak:
+    designs.append((f"peak {p}", peak(*p)))
+
+if not designs:
+    print("❌ No filters specified.")
+    sys.exit(1)
+
+stages = []
+lines = ["# b0 b1 b2 a1 a2, Q14, generated by generate_eq_profile.py"]
+for name, (b, a) in designs:
+    q = quantize(b, a)
+    if q is None:
+        print(f"❌ {name}: coefficients exceed the Q14 range, reduce the gain.")
+        sys.exit(1)
+    stages.append(q)
+    lines.append(f"# {name}")
+    lines.append(" ".join(str(v) for v in q))
+
+with open(args.output, "w") as f:
+    f.write("\n".join(lines) + "\n")
+
+print(f"\n✅ EQ profile with {len(stages)} stages written to {args.output} "
+      f"for {SAMPLE_RATE} Hz\n")
+if args.golden:
+    write_golden(args.golden, stages)
+    print(f"✅ Golden vectors written to {args.golden}\n")
+for freq in (50, 100, 200, 500, 1000, 2000, 5000, 10000):
+    if freq >= SAMPLE_RATE / 2:
+        break
+    print(f"➡️  {freq:>5} Hz: {response_db(stages, freq):+6.2f} dB")
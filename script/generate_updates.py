@@ -2,11 +2,17 @@
 # checks for the presence of signed firmware binaries,
 # renames them according to the version, 
 # and copies them to the firmware_updates folder.
+# Compressed copies of the new images are made by generate_compressed.py,
+# delta patches to them from the older images already in that folder
+# by generate_delta.py.
 
 import os
 import shutil
 from pathlib import Path
 
+from generate_compressed import write_compressed
+from generate_delta import generate_dir
+
 script_dir = Path(__file__).resolve().parent
 project_root = script_dir.parent
 build_dir = project_root / "build"
@@ -65,5 +71,21 @@ if prepared_binaries:
     print(f"{output_dir}\n")
     for path in prepared_binaries:
         print(f"➡️  {path.name}\n")
+
+    compressed = []
+    for path in prepared_binaries:
+        out = path.with_suffix(".hs")
+        if write_compressed(path, out):
+            compressed.append(out)
+    if compressed:
+        print("\n✅ Compressed images prepared:")
+        for path in compressed:
+            print(f"➡️  {path.name}\n")
+
+    deltas = generate_dir(output_dir)
+    if deltas:
+        print("\n✅ Delta patches prepared:")
+        for path in deltas:
+            print(f"➡️  {path.name}\n")
 else:
     print("❌ No firmware binaries were prepared.")
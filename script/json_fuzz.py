@@ -0,0 +1,395 @@
+# This script fuzzes and benchmarks the incremental JSON parser of the HTTP
+# module (src/http_module/http_json.c, CONFIG_RPR_HTTP_JSON) on the host.
+#
+# The parser is built with the harness in json_host/ twice: with
+# AddressSanitizer and UndefinedBehaviorSanitizer for the fuzzing, and with
+# -O2 for the benchmark. The fuzzing has four parts:
+#   - random documents, each parsed in fragments of one byte and of a random
+#     size, whose events must match the ones derived from Python's json
+#     module, including the cutting of long keys and values;
+#   - mutated documents, which the parser must accept or reject as Python
+#     does, with the same events when accepted;
+#   - random numbers, checked against the JSON grammar the same way;
+#   - nesting at and past HTTP_JSON_MAX_DEPTH.
+# Any sanitizer report fails the run.
+#
+# The benchmark parses an audio list of many entries in fragments, as it
+# arrives from the server, and prints the throughput.
+#
+# Example:
+#   python json_fuzz.py
+#
+# Example, another seed, keeping the generated documents as a corpus:
+#   python json_fuzz.py --seed 7 --corpus json_corpus
+#
+# Example, the benchmark only, with a longer list:
+#   python json_fuzz.py --bench-only --bench-entries 200000
+
+import argparse
+import concurrent.futures
+import errno
+import json
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+HERE = Path(__file__).resolve().parent
+HARNESS = HERE / "json_host" / "json_host.c"
+MODULE = HERE.parent / "src" / "http_module"
+
+KEY_MAX_LEN = 32       # defaults of CONFIG_RPR_HTTP_JSON_KEY_MAX_LEN
+VALUE_MAX_LEN = 128    # and CONFIG_RPR_HTTP_JSON_VALUE_MAX_LEN
+MAX_DEPTH = 32         # HTTP_JSON_MAX_DEPTH
+
+SPACE = " \t\n\r"
+STRING_CHARS = ['a', 'b', 'Z', ' ', '"', '\\', '/', '\b', '\f', '\n', '\r',
+                '\t', '\x00', '\x01', '\x1f', '\x7f', 'é', 'ж', '€', '😀',
+                '\ud800', '\udbff', '\udc00', '\udfff']
+MUTATION_CHARS = b'{}[]:,"\\ \t\n0123456789-+eE.tfnulrsa\x01/'
+NUMBER_CHARS = "-+0123456789.eE"
+
+
+class Number(str):
+    """Text of a number, as the parser passes it."""
+
+
+class Object(list):
+    """Members of an object in order, duplicates kept."""
+
+
+def no_constant(name):
+    raise ValueError(f"{name} is not JSON")
+
+
+def py_parse(text):
+    """Parses like the device should, None if the document is invalid."""
+    try:
+        return [json.loads(text, object_pairs_hook=Object,
+                           parse_int=Number, parse_float=Number,
+                           parse_constant=no_constant)]
+    except (ValueError, RecursionError):
+        return None
+
+
+def depth_of(value):
+    if isinstance(value, Object):
+        return 1 + max((depth_of(v) for _, v in value), default=0)
+    if isinstance(value, list):
+        return 1 + max((depth_of(v) for v in value), default=0)
+    return 0
+
+
+def to_utf8(text):
+    """UTF-8 of a decoded string, lone surrogates replaced as the parser."""
+    return text.encode("utf-16-le", "surrogatepass") \
+        .decode("utf-16-le", "replace").encode("utf-8")
+
+
+def cut(data, max_len):
+    return data[:max_len - 1], len(data) > max_len - 1
+
+
+def expected_events(value, key=None, depth=0, out=None):
+    """Lines printed by json_host for a document parsed by py_parse()."""
+    out = [] if out is None else out
+
+    key_text, key_cut = "-", False
+    if key is not None:
+        data, key_cut = cut(to_utf8(key), KEY_MAX_LEN)
+        key_text = "k=" + data.split(b"\0")[0].hex()
+
+    def line(event, data=None, data_cut=False):
+        shown = "-" if data is None else "v=" + data.hex()
+        flag = "T" if key_cut or data_cut else "-"
+        out.append(f"{event} {depth} {key_text} {shown} {flag}")
+
+    if isinstance(value, Object):
+        line("OS")
+        for k, v in value:
+            expected_events(v, k, depth + 1, out)
+        out.append(f"OE {depth} - - -")
+    elif isinstance(value, list):
+        line("AS")
+        for v in value:
+            expected_events(v, None, depth + 1, out)
+        out.append(f"AE {depth} - - -")
+    elif isinstance(value, Number):
+        line("N", *cut(value.encode(), VALUE_MAX_LEN))
+    elif isinstance(value, str):
+        line("S", *cut(to_utf8(value), VALUE_MAX_LEN))
+    elif value is True:
+        line("T")
+    elif value is False:
+        line("F")
+    else:
+        line("Z")
+    return out
+
+
+def random_string(rng):
+    size = rng.choice([0, 1, 5, 20, KEY_MAX_LEN - 1, KEY_MAX_LEN,
+                       VALUE_MAX_LEN - 1, VALUE_MAX_LEN, 200])
+    return "".join(rng.choice(STRING_CHARS) for _ in range(size))
+
+
+def random_number(rng):
+    text = rng.choice(["", "-"])
+    text += rng.choice(["0", str(rng.randint(1, 9)),
+                        str(rng.randint(1, 10 ** rng.randint(1, 40)))])
+    if rng.random() < 0.4:
+        text += "." + str(rng.randint(0, 10 ** rng.randint(1, 20)))
+    if rng.random() < 0.3:
+        text += rng.choice("eE") + rng.choice(["", "+", "-"]) + \
+            str(rng.randint(0, 400))
+    if rng.random() < 0.02:
+        text += "1" * VALUE_MAX_LEN
+    return Number(text)
+
+
+def random_value(rng, depth=0):
+    r = rng.random()
+    if depth > 6 or r < 0.45:
+        return rng.choice([lambda: random_string(rng),
+                           lambda: random_number(rng),
+                           lambda: True, lambda: False, lambda: None])()
+    if r < 0.7:
+        return [random_value(rng, depth + 1)
+                for _ in range(rng.randint(0, 6))]
+    return Object((random_string(rng), random_value(rng, depth + 1))
+                  for _ in range(rng.randint(0, 6)))
+
+
+def dump(value, rng, ascii_only):
+    """Serializes with random whitespace between the tokens."""
+    def ws():
+        return "".join(rng.choice(SPACE) for _ in range(rng.choice(
+            [0, 0, 0, 1, 3])))
+
+    def string(text):
+        return json.dumps(text, ensure_ascii=ascii_only)
+
+    if isinstance(value, Object):
+        return "{" + ws() + ",".join(
+            ws() + string(k) + ws() + ":" + ws() + dump(v, rng, ascii_only) +
+            ws() for k, v in value) + "}"
+    if isinstance(value, list):
+        return "[" + ws() + ",".join(
+            ws() + dump(v, rng, ascii_only) + ws() for v in value) + "]"
+    if isinstance(value, Number):
+        return str(value)
+    if isinstance(value, str):
+        return string(value)
+    return json.dumps(value)
+
+
+def encode(text):
+    try:
+        return text.encode("utf-8")
+    except UnicodeEncodeError:
+        return None
+
+
+def build(work, cc):
+    """Builds the sanitized and the optimized harness."""
+    common = [cc, "-std=gnu11", "-Wall", "-Wextra", "-Werror",
+              "-I", str(HARNESS.parent), "-I", str(MODULE),
+              f"-DCONFIG_RPR_HTTP_JSON_KEY_MAX_LEN={KEY_MAX_LEN}",
+              f"-DCONFIG_RPR_HTTP_JSON_VALUE_MAX_LEN={VALUE_MAX_LEN}",
+              str(HARNESS), str(MODULE / "http_json.c")]
+    fuzz = work / "json_fuzz"
+    bench = work / "json_bench"
+    subprocess.run(common + ["-O1", "-g", "-fno-omit-frame-pointer",
+                             "-fsanitize=address,undefined",
+                             "-fno-sanitize-recover=all", "-o", str(fuzz)],
+                   check=True)
+    subprocess.run(common + ["-O2", "-o", str(bench)], check=True)
+    return fuzz, bench
+
+
+class Runner:
+    def __init__(self, binary, work, corpus):
+        self.binary = binary
+        self.work = work
+        self.corpus = corpus
+        self.failures = []
+
+    def run(self, name, data, chunk):
+        path = self.work / f"{name}.json"
+        path.write_bytes(data)
+        if self.corpus:
+            shutil.copy(path, self.corpus / path.name)
+        rsp = subprocess.run([str(self.binary), str(path), str(chunk)],
+                             capture_output=True)
+        path.unlink()
+        if rsp.returncode != 0 or rsp.stderr:
+            self.fail(name, data, "exit %d\n%s" % (
+                rsp.returncode, rsp.stderr.decode(errors="replace")[:2000]))
+            return None, None
+        lines = rsp.stdout.decode().splitlines()
+        return lines[:-1], int(lines[-1].split()[1])
+
+    def check(self, name, data, chunk):
+        """Compares the parser with Python, returns False on a mismatch."""
+        events, result = self.run(name, data, chunk)
+        if result is None:
+            return False
+        try:
+            parsed = py_parse(data.decode("utf-8"))
+        except UnicodeDecodeError:
+            parsed = None
+        if parsed is not None and depth_of(parsed[0]) > MAX_DEPTH:
+            if result != -errno.E2BIG:
+                self.fail(name, data, f"depth: RESULT {result}")
+                return False
+            return True
+        if (result == 0) != (parsed is not None):
+            self.fail(name, data, f"RESULT {result}, Python "
+                      f"{'accepts' if parsed is not None else 'rejects'}")
+            return False
+        if parsed is not None:
+            expected = expected_events(parsed[0])
+            if events != expected:
+                diff = next((i for i, (a, b) in enumerate(
+                    zip(events, expected)) if a != b),
+                    min(len(events), len(expected)))
+                self.fail(name, data, "event %d, chunk %d:\n  got %s\n"
+                          "  expected %s" % (
+                              diff, chunk,
+                              events[diff] if diff < len(events) else "end",
+                              expected[diff] if diff < len(expected)
+                              else "end"))
+                return False
+        return True
+
+    def fail(self, name, data, reason):
+        self.failures.append(name)
+        if len(self.failures) <= 5:
+            print(f"❌ {name}: {reason}\n  {data[:160]!r}")
+
+
+def run_all(runner, jobs, tasks):
+    with concurrent.futures.ThreadPoolExecutor(jobs) as pool:
+        return sum(pool.map(lambda t: runner.check(*t), tasks))
+
+
+def fuzz(args, runner, rng):
+    tasks = []
+    for i in range(args.docs):
+        value = random_value(rng)
+        data = encode(dump(value, rng, rng.random() < 0.5)) or \
+            dump(value, rng, True).encode()
+        tasks.append((f"doc{i}a", data, 1))
+        tasks.append((f"doc{i}b", data, rng.randint(2, len(data) + 1)))
+    ok = run_all(runner, args.jobs, tasks)
+    print(f"📄 Random documents: {ok}/{len(tasks)} runs matched")
+
+    tasks = []
+    for i in range(args.mutations):
+        data = bytearray(dump(random_value(rng), rng, True).encode())
+        for _ in range(rng.randint(1, 4)):
+            op = rng.random()
+            pos = rng.randrange(len(data) + 1)
+            if op < 0.35 and data:
+                del data[min(pos, len(data) - 1)]
+            elif op < 0.75:
+                data.insert(pos, rng.choice(MUTATION_CHARS))
+            elif op < 0.9:
+                end = rng.randrange(pos, len(data) + 1)
+                data[pos:pos] = data[pos:end]
+            else:
+                del data[pos:]
+        tasks.append((f"mut{i}", bytes(data), rng.choice([1, 3, 4096])))
+    ok = run_all(runner, args.jobs, tasks)
+    print(f"🧬 Mutated documents: {ok}/{len(tasks)} runs matched")
+
+    tasks = []
+    for i in range(args.numbers):
+        text = "".join(rng.choice(NUMBER_CHARS)
+                       for _ in range(rng.randint(1, 8)))
+        if rng.random() < 0.5:
+            text = "[" + text + rng.choice(["]", ",1]", " ]"])
+        tasks.append((f"num{i}", text.encode(), rng.choice([1, 64])))
+    ok = run_all(runner, args.jobs, tasks)
+    print(f"🔢 Random numbers: {ok}/{len(tasks)} runs matched")
+
+    tasks = []
+    for depth in (1, MAX_DEPTH - 1, MAX_DEPTH, MAX_DEPTH + 1, 1000):
+        tasks.append((f"deep{depth}a", b"[" * depth + b"]" * depth, 1))
+        tasks.append((f"deep{depth}o",
+                      b'{"a":' * depth + b"0" + b"}" * depth, 7))
+    ok = run_all(runner, args.jobs, tasks)
+    print(f"🪆 Nesting: {ok}/{len(tasks)} runs matched")
+
+
+def bench(args, binary, work):
+    entries = []
+    for i in range(args.bench_entries):
+        entries.append('{"name":"audio_%05d.opus","size":%d,'
+                       '"duration":%d.%d,"tags":["alarm","zone %d"]}'
+                       % (i, 4096 + i * 37, i % 600, i % 10, i % 8))
+    path = work / "bench.json"
+    path.write_text('{"files":[' + ",".join(entries) + "]}")
+
+    print(f"⏱️  {args.bench_entries} entries, "
+          f"{path.stat().st_size / 1e6:.1f} MB")
+    for chunk in (61, 1024, 4096):
+        rsp = subprocess.run([str(binary), str(path), str(chunk),
+                              str(args.bench_repeat)],
+                             capture_output=True, check=True)
+        print(f"  fragments of {chunk:>4} B: {rsp.stdout.decode().strip()}")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Fuzz and benchmark the JSON parser of the HTTP module")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--docs", type=int, default=1500,
+                        help="random documents, each parsed twice")
+    parser.add_argument("--mutations", type=int, default=4500,
+                        help="mutated documents")
+    parser.add_argument("--numbers", type=int, default=4000,
+                        help="random numbers")
+    parser.add_argument("--corpus",
+                        help="folder to keep the generated documents in")
+    parser.add_argument("--bench-only", action="store_true",
+                        help="run the benchmark only")
+    parser.add_argument("--bench-entries", type=int, default=60000,
+                        help="entries of the benchmark list")
+    parser.add_argument("--bench-repeat", type=int, default=10,
+                        help="times the benchmark list is parsed")
+    parser.add_argument("--cc", default=os.environ.get("CC", "cc"),
+                        help="host C compiler with ASan and UBSan support")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count(),
+                        help="parallel harness runs")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        work = Path(tmp)
+        try:
+            fuzz_bin, bench_bin = build(work, args.cc)
+        except (OSError, subprocess.CalledProcessError) as e:
+            print(f"❌ Build failed: {e}")
+            return 1
+
+        if not args.bench_only:
+            corpus = None
+            if args.corpus:
+                corpus = Path(args.corpus)
+                corpus.mkdir(parents=True, exist_ok=True)
+            runner = Runner(fuzz_bin, work, corpus)
+            fuzz(args, runner, random.Random(args.seed))
+            if runner.failures:
+                print(f"❌ {len(runner.failures)} runs failed.")
+                return 1
+            print("✅ The parser matched Python on every run.")
+
+        bench(args, bench_bin, work)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
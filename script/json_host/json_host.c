@@ -0,0 +1,215 @@
+/**
+ * @file json_host.c
+ * @brief Host harness of the incremental JSON parser (http_json.c).
+ *
+ * Feeds a file to the parser in fragments of a given size. Without a repeat
+ * count every event is printed on a line of its own,
+ *
+ *   <event> <depth> <key> <value> <truncated>
+ *
+ * with the key and the value in hexadecimal after "k=" and "v=", "-" if
+ * there is none, and "T" or "-" for the truncated flag. The last line is
+ * "RESULT <code>" with the result of the parser. With a repeat count the
+ * file is parsed that many times without output and the throughput is
+ * printed. Built and run by json_fuzz.py.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "http_json.h"
+
+static const char *const event_names[] = {
+    [HTTP_JSON_OBJECT_START] = "OS", [HTTP_JSON_OBJECT_END] = "OE",
+    [HTTP_JSON_ARRAY_START] = "AS",  [HTTP_JSON_ARRAY_END] = "AE",
+    [HTTP_JSON_STRING] = "S",        [HTTP_JSON_NUMBER] = "N",
+    [HTTP_JSON_TRUE] = "T",          [HTTP_JSON_FALSE] = "F",
+    [HTTP_JSON_NULL] = "Z",
+};
+
+static unsigned long event_count;
+
+/**
+ * @brief Prints bytes in hexadecimal.
+ *
+ * @param data Bytes to print.
+ * @param len  Number of bytes.
+ */
+static void print_hex(const char *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        printf("%02x", (unsigned char)data[i]);
+    }
+}
+
+/**
+ * @brief Prints an event of the parser.
+ *
+ * @param tok       Parsed value.
+ * @param user_data Not NULL to count the event only.
+ *
+ * @return Always 0.
+ */
+static int json_host_cb(const struct http_json_token *tok, void *user_data)
+{
+    event_count++;
+
+    if (user_data) {
+        return 0;
+    }
+
+    printf("%s %u ", event_names[tok->event], tok->depth);
+
+    if (tok->key) {
+        printf("k=");
+        print_hex(tok->key, strlen(tok->key));
+    } else {
+        printf("-");
+    }
+
+    if (tok->value) {
+        printf(" v=");
+        print_hex(tok->value, tok->len);
+    } else {
+        printf(" -");
+    }
+
+    printf(" %s\n", tok->truncated ? "T" : "-");
+    return 0;
+}
+
+/**
+ * @brief Parses a document in fragments.
+ *
+ * @param data  Document.
+ * @param len   Length of the document.
+ * @param chunk Size of the fragments.
+ * @param quiet Count the events without printing them, and pass the
+ *              fragments in place for the benchmark.
+ *
+ * @return Result of the parser.
+ */
+static int
+json_host_parse(const char *data, size_t len, size_t chunk, bool quiet)
+{
+    struct http_json_parser parser;
+    int                     ret = 0;
+
+    http_json_init(&parser, json_host_cb, quiet ? &parser : NULL);
+
+    for (size_t pos = 0; pos < len && ret == 0; pos += chunk) {
+        size_t n = len - pos < chunk ? len - pos : chunk;
+
+        if (quiet) {
+            ret = http_json_write(&parser, data + pos, n);
+            continue;
+        }
+
+        /* A copy of every fragment, so that reads past it are caught */
+        char *frag = malloc(n);
+        if (!frag) {
+            return -1;
+        }
+        memcpy(frag, data + pos, n);
+        ret = http_json_write(&parser, frag, n);
+        free(frag);
+    }
+
+    return ret ? ret : http_json_finish(&parser);
+}
+
+/**
+ * @brief Reads a whole file.
+ *
+ * @param path Path of the file.
+ * @param len  Pointer to store the length of the file.
+ *
+ * @return Contents of the file, NULL on error.
+ */
+static char *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+
+    char  *data = NULL;
+    size_t size = 0;
+    size_t n;
+    char   buf[4096];
+
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        char *grown = realloc(data, size + n);
+        if (!grown) {
+            free(data);
+            fclose(f);
+            return NULL;
+        }
+        data = grown;
+        memcpy(data + size, buf, n);
+        size += n;
+    }
+
+    fclose(f);
+    *len = size;
+    return data ? data : malloc(1);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 4) {
+        fprintf(stderr, "Usage: %s <file> [chunk] [repeat]\n", argv[0]);
+        return 2;
+    }
+
+    size_t len;
+    char  *data = read_file(argv[1], &len);
+    if (!data) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 2;
+    }
+
+    size_t chunk  = argc > 2 ? strtoul(argv[2], NULL, 10) : len;
+    long   repeat = argc > 3 ? strtol(argv[3], NULL, 10) : 0;
+    int    ret    = 0;
+
+    if (chunk == 0) {
+        chunk = len ? len : 1;
+    }
+
+    if (repeat <= 0) {
+        ret = json_host_parse(data, len, chunk, false);
+        printf("RESULT %d\n", ret);
+        free(data);
+        return 0;
+    }
+
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < repeat; i++) {
+        ret = json_host_parse(data, len, chunk, true);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double sec = (double)(end.tv_sec - start.tv_sec) +
+                 (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%zu B x %ld in %.3f s: %.1f MB/s, %lu events, parser %zu B, "
+           "RESULT %d\n",
+           len,
+           repeat,
+           sec,
+           (double)len * (double)repeat / sec / 1e6,
+           event_count / (unsigned long)repeat,
+           sizeof(struct http_json_parser),
+           ret);
+
+    free(data);
+    return 0;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file kernel.h
+ * @brief Host stand-in for the Zephyr kernel header, for json_host.c.
+ *
+ * http_json.c uses nothing from the kernel.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _JSON_HOST_KERNEL_H_
+#define _JSON_HOST_KERNEL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#endif // _JSON_HOST_KERNEL_H_
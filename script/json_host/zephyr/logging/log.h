@@ -0,0 +1,20 @@
+/**
+ * @file log.h
+ * @brief Host stand-in for the Zephyr logging header, for json_host.c.
+ *
+ * Messages are dropped, so the output of the harness holds only the events.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _JSON_HOST_LOG_H_
+#define _JSON_HOST_LOG_H_
+
+#define LOG_MODULE_DECLARE(...)
+#define LOG_ERR(...) ((void)0)
+#define LOG_WRN(...) ((void)0)
+#define LOG_INF(...) ((void)0)
+#define LOG_DBG(...) ((void)0)
+
+#endif // _JSON_HOST_LOG_H_
@@ -0,0 +1,20 @@
+/**
+ * @file util.h
+ * @brief Host stand-in for the Zephyr utility macros, for json_host.c.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _JSON_HOST_UTIL_H_
+#define _JSON_HOST_UTIL_H_
+
+#define BIT(n) (1UL << (n))
+
+#define WRITE_BIT(var, bit, set) \
+    ((var) = (set) ? ((var) | BIT(bit)) : ((var) & ~BIT(bit)))
+
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+#endif // _JSON_HOST_UTIL_H_
@@ -0,0 +1,141 @@
+# This script measures the playback skew between two speakers from the WAV
+# captures of the audio player WAV sink (CONFIG_RPR_AUDIO_WAV_SINK).
+#
+# Every capture carries a "sync" chunk with the time its first sample was
+# played: the host time on native_sim (common to all instances on one host)
+# and the network time as seen by the device. The captures are placed on
+# that time line and cross-correlated in a window at the start and at the
+# end of the stream, which gives the start skew and the residual drift.
+#
+# Example, two native_sim instances playing the same file:
+#   rapidreach audio sync play test.opus @10      (on both, within 10 s)
+#   python measure_sync_skew.py a/capture.wav b/capture.wav
+
+import argparse
+import struct
+import sys
+
+SYNC_NET_VALID = 1 << 0
+SYNC_HOST_VALID = 1 << 1
+
+
+def read_capture(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if data[0:4] != b"RIFF" or data[8:12] != b"WAVE":
+        sys.exit(f"❌ {path}: not a WAV file")
+
+    rate = None
+    sync = None
+    samples = None
+    pos = 12
+    while pos + 8 <= len(data):
+        tag, size = struct.unpack_from("<4sI", data, pos)
+        body = data[pos + 8:pos + 8 + size]
+        if tag == b"fmt ":
+            fmt, channels, rate, _, _, bits = struct.unpack_from("<HHIIHH",
+                                                                 body)
+            if fmt != 1 or channels != 1 or bits != 16:
+                sys.exit(f"❌ {path}: expected 16-bit mono PCM")
+        elif tag == b"sync":
+            _, flags, net_us, host_us = struct.unpack_from("<IIqq", body)
+            sync = (flags, net_us, host_us)
+        elif tag == b"data":
+            count = len(body) // 2
+            samples = struct.unpack_from(f"<{count}h", body)
+        pos += 8 + size + (size & 1)
+
+    if rate is None or samples is None:
+        sys.exit(f"❌ {path}: missing fmt or data chunk")
+    if sync is None:
+        sys.exit(f"❌ {path}: no sync chunk, not captured by the WAV sink")
+
+    return rate, sync, samples
+
+
+def correlate(a, b, start_a, start_b, window, max_lag):
+    """Returns the lag of b against a with the best normalized correlation."""
+    seg_a = a[start_a:start_a + window]
+    best_lag = 0
+    best_score = -1.0
+    energy_a = sum(x * x for x in seg_a) or 1
+    for lag in range(-max_lag, max_lag + 1):
+        s = start_b + lag
+        if s < 0 or s + window > len(b):
+            continue
+        seg_b = b[s:s + window]
+        dot = sum(x * y for x, y in zip(seg_a, seg_b))
+        energy_b = sum(y * y for y in seg_b) or 1
+        score = dot / (energy_a * energy_b) ** 0.5
+        if score > best_score:
+            best_score = score
+            best_lag = lag
+    return best_lag, best_score
+
+
+parser = argparse.ArgumentParser(description="Measure playback skew")
+parser.add_argument("capture_a", help="WAV capture of the first speaker")
+parser.add_argument("capture_b", help="WAV capture of the second speaker")
+parser.add_argument("--window-ms", type=float, default=50,
+                    help="correlation window (default 50 ms)")
+parser.add_argument("--max-lag-ms", type=float, default=5,
+                    help="search range around the time stamps (default 5)")
+parser.add_argument("--limit-us", type=float, default=100,
+                    help="skew accepted as synchronized (default 100 us)")
+args = parser.parse_args()
+
+rate_a, sync_a, pcm_a = read_capture(args.capture_a)
+rate_b, sync_b, pcm_b = read_capture(args.capture_b)
+if rate_a != rate_b:
+    sys.exit("❌ Captures have different sample rates")
+rate = rate_a
+
+if sync_a[0] & sync_b[0] & SYNC_HOST_VALID:
+    time_a, time_b = sync_a[2], sync_b[2]
+    print("➡️ Aligning on host time (ground truth)")
+elif sync_a[0] & sync_b[0] & SYNC_NET_VALID:
+    time_a, time_b = sync_a[1], sync_b[1]
+    print("⚠️ No host time, aligning on the device network time "
+          "(self-reported, shows residual trim only)")
+else:
+    sys.exit("❌ Captures have no common time base")
+
+# The capture that started first is the reference, skews are of the other
+sign = 1
+if time_b > time_a:
+    pcm_a, pcm_b = pcm_b, pcm_a
+    time_a, time_b = time_b, time_a
+    sign = -1
+
+# Sample of b played together with sample 0 of a, if both were perfect
+offset = round((time_a - time_b) * rate / 1_000_000)
+window = int(args.window_ms * rate / 1000)
+max_lag = int(args.max_lag_ms * rate / 1000)
+
+overlap = min(len(pcm_a), len(pcm_b) - offset) - window - max_lag
+if overlap <= 0:
+    sys.exit("❌ Captures do not overlap")
+
+print(f"➡️ {args.capture_a}: {len(pcm_a) / rate:.2f} s")
+print(f"➡️ {args.capture_b}: {len(pcm_b) / rate:.2f} s")
+print(f"➡️ Start time difference: {abs(time_a - time_b) / 1000:.3f} ms")
+
+results = []
+for name, start in (("start", 0), ("end", overlap)):
+    lag, score = correlate(pcm_a, pcm_b, start, start + offset, window,
+                           max_lag)
+    skew_us = sign * lag * 1_000_000 / rate
+    results.append(skew_us)
+    print(f"➡️ Skew of B at {name} ({start / rate:.2f} s): {skew_us:+.1f} us "
+          f"(correlation {score:.3f})")
+
+drift_ppm = (results[1] - results[0]) / (overlap / rate)
+print(f"➡️ Residual drift: {drift_ppm:+.2f} ppm")
+
+worst = max(abs(s) for s in results)
+if worst <= args.limit_us:
+    print(f"✅ Speakers are synchronized within {worst:.1f} us")
+else:
+    print(f"❌ Skew {worst:.1f} us exceeds {args.limit_us:.0f} us")
+    sys.exit(1)
@@ -0,0 +1,228 @@
+# This script converts Ogg Opus files into the pre-packetized container the
+# speaker plays without an Ogg demuxer (see src/audio_player/audio_packed.h).
+# The speaker converts downloaded Ogg files itself, so this is for loading
+# files directly onto the flash and for checking converted files.
+#
+# Example:
+#   python opus_pack.py pack alarm.opus alarm.rpak
+#   python opus_pack.py info alarm.rpak
+#   python opus_pack.py verify alarm.opus alarm.rpak
+#
+# On the speaker the parse cost of both formats is compared with:
+#   rapidreach audio pack bench alarm.opus
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"RPAK"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHIIIIHHI")
+RECORD_LEN = struct.Struct("<H")
+INDEX_ENTRY = struct.Struct("<II")
+MAX_PACKET = 1275
+INDEX_MAX = 256       # CONFIG_RPR_AUDIO_PACKED_INDEX_MAX
+INDEX_INTERVAL = 50   # Packets between entries to start with
+
+
+def read_ogg_packets(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    packets = []
+    partial = b""
+    pos = 0
+    while pos + 27 <= len(data):
+        if data[pos:pos + 4] != b"OggS":
+            sys.exit(f"❌ {path}: lost Ogg page sync at {pos}")
+        segments = data[pos + 26]
+        lacing = data[pos + 27:pos + 27 + segments]
+        body = pos + 27 + segments
+        for size in lacing:
+            partial += data[body:body + size]
+            body += size
+            if size < 255:
+                packets.append(partial)
+                partial = b""
+        pos = body
+
+    if len(packets) < 3 or not packets[0].startswith(b"OpusHead"):
+        sys.exit(f"❌ {path}: not an Ogg Opus file")
+
+    return packets[0], packets[2:]
+
+
+def packet_samples(packet):
+    """Samples at 48 kHz, as opus_packet_get_nb_samples()."""
+    toc = packet[0]
+    config = toc >> 3
+    if config < 12:
+        frame = (480, 960, 1920, 2880)[config & 3]
+    elif config < 16:
+        frame = (480, 960)[config & 1]
+    else:
+        frame = (120, 240, 480, 960)[config & 3]
+
+    code = toc & 3
+    if code == 0:
+        frames = 1
+    elif code < 3:
+        frames = 2
+    else:
+        if len(packet) < 2:
+            raise ValueError("truncated code 3 packet")
+        frames = packet[1] & 0x3F
+
+    if frames == 0 or frames * frame > 5760:
+        raise ValueError("bad frame count")
+    return frames * frame
+
+
+def pack(src, dst):
+    head, packets = read_ogg_packets(src)
+    channels = head[9]
+    pre_skip, input_rate = struct.unpack_from("<HI", head, 10)
+
+    body = bytearray()
+    index = []
+    interval = INDEX_INTERVAL
+    total = 0
+
+    for n, packet in enumerate(packets):
+        if not 0 < len(packet) <= MAX_PACKET:
+            sys.exit(f"❌ {src}: packet {n} has {len(packet)} bytes")
+
+        # Same decimation as the device, so both write identical files
+        if n % interval == 0:
+            if len(index) == INDEX_MAX:
+                index = index[::2]
+                interval *= 2
+            if n % interval == 0:
+                index.append((HEADER.size + len(body), total))
+
+        body += RECORD_LEN.pack(len(packet)) + packet
+        total += packet_samples(packet)
+
+    index_offset = HEADER.size + len(body)
+    header = HEADER.pack(MAGIC, VERSION, channels, pre_skip, len(packets),
+                         input_rate, total, index_offset, len(index),
+                         interval, 0)
+
+    with open(dst, "wb") as f:
+        f.write(header)
+        f.write(body)
+        for entry in index:
+            f.write(INDEX_ENTRY.pack(*entry))
+
+    print(f"✅ {dst}: {len(packets)} packets, {total // 48} ms, "
+          f"{len(index)} index entries")
+
+
+def read_container(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < HEADER.size:
+        sys.exit(f"❌ {path}: too short")
+
+    (magic, version, channels, pre_skip, count, input_rate, total,
+     index_offset, index_count, interval, _) = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        sys.exit(f"❌ {path}: not a container")
+    if version != VERSION:
+        sys.exit(f"❌ {path}: unsupported version {version}")
+
+    packets = []
+    pos = HEADER.size
+    while pos < index_offset:
+        (size,) = RECORD_LEN.unpack_from(data, pos)
+        if not 0 < size <= MAX_PACKET or pos + 2 + size > index_offset:
+            sys.exit(f"❌ {path}: bad record at {pos}")
+        packets.append((pos, data[pos + 2:pos + 2 + size]))
+        pos += 2 + size
+
+    index = [INDEX_ENTRY.unpack_from(data, index_offset + i * INDEX_ENTRY.size)
+             for i in range(index_count)]
+
+    header = {
+        "channels": channels,
+        "pre_skip": pre_skip,
+        "packets": count,
+        "input_rate": input_rate,
+        "samples": total,
+        "index_offset": index_offset,
+        "index_count": index_count,
+        "index_interval": interval,
+    }
+    return header, packets, index
+
+
+def info(path):
+    header, packets, index = read_container(path)
+    for key, value in header.items():
+        print(f"{key:>15}: {value}")
+    print(f"{'duration':>15}: {header['samples'] / 48000:.2f} s")
+    if len(packets) != header["packets"]:
+        print(f"⚠️ {len(packets)} records, header says {header['packets']}")
+
+
+def verify(src, dst):
+    _, ogg_packets = read_ogg_packets(src)
+    header, packets, index = read_container(dst)
+
+    if len(packets) != len(ogg_packets) or header["packets"] != len(packets):
+        sys.exit(f"❌ Packet count differs: {len(ogg_packets)} in Ogg, "
+                 f"{len(packets)} records, {header['packets']} in header")
+
+    starts = []
+    total = 0
+    for n, ((_, packet), ogg_packet) in enumerate(zip(packets, ogg_packets)):
+        if packet != ogg_packet:
+            sys.exit(f"❌ Packet {n} differs")
+        starts.append(total)
+        total += packet_samples(packet)
+
+    if total != header["samples"]:
+        sys.exit(f"❌ Sample count differs: {total}, header {header['samples']}")
+
+    for i, (offset, sample) in enumerate(index):
+        n = i * header["index_interval"]
+        if n >= len(packets) or packets[n][0] != offset or starts[n] != sample:
+            sys.exit(f"❌ Index entry {i} does not point at packet {n}")
+
+    print(f"✅ {dst} matches {src}: {len(packets)} packets, "
+          f"{len(index)} index entries")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert Ogg Opus files into the speaker audio container")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("pack", help="Convert an Ogg Opus file")
+    p.add_argument("src")
+    p.add_argument("dst")
+
+    p = sub.add_parser("info", help="Show a container header")
+    p.add_argument("path")
+
+    p = sub.add_parser("verify", help="Check a container against its Ogg file")
+    p.add_argument("src")
+    p.add_argument("dst")
+
+    args = parser.parse_args()
+
+    try:
+        if args.command == "pack":
+            print(f"➡️ Packing {args.src}")
+            pack(args.src, args.dst)
+        elif args.command == "info":
+            info(args.path)
+        else:
+            verify(args.src, args.dst)
+    except (OSError, ValueError, struct.error) as e:
+        sys.exit(f"❌ {e}")
+
+
+if __name__ == "__main__":
+    main()
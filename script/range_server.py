@@ -0,0 +1,263 @@
+# This script serves files over HTTP with Range, ETag and If-Range support
+# and emulates a high-latency link, as a stand-in for the update and audio
+# server when trying segmented downloads (CONFIG_RPR_HTTP_SEGMENTED).
+#
+# A TCP connection whose receive window is small sends one window per round
+# trip. Every response is delayed by one round trip and then sent one
+# window per round trip, so a connection is limited to window / RTT. An
+# optional link rate is shared by all connections.
+#
+# Example, serve the firmware_updates folder over an emulated LTE link:
+#   python range_server.py -d ../firmware_updates --rtt-ms 150 --window 1024
+#   rapidreach http segbench http://<host>:8080/<file> 2   (on the device)
+#
+# Example, measure the throughput against the number of segments and the
+# round-trip time on the host:
+#   python range_server.py --bench --rtt-ms 20,100,300 --segments 4
+
+import argparse
+import hashlib
+import http.server
+import os
+import re
+import socketserver
+import tempfile
+import threading
+import time
+import urllib.error
+import urllib.request
+
+
+class Link:
+    """Emulated link, shared by all connections of the server."""
+
+    def __init__(self, rtt_ms, window, link_kbps):
+        self.rtt = rtt_ms / 1000
+        self.window = window
+        self.rate = link_kbps * 1000 / 8 if link_kbps else 0
+        self.lock = threading.Lock()
+        self.next_free = 0.0
+
+    def send(self, wfile, data):
+        time.sleep(self.rtt)
+        for pos in range(0, len(data), self.window):
+            chunk = data[pos:pos + self.window]
+            start = time.monotonic()
+            if self.rate:
+                with self.lock:
+                    begin = max(start, self.next_free)
+                    self.next_free = begin + len(chunk) / self.rate
+                    done = self.next_free
+                time.sleep(max(0.0, done - start))
+            wfile.write(chunk)
+            wfile.flush()
+            if pos + self.window < len(data):
+                time.sleep(max(0.0, self.rtt - (time.monotonic() - start)))
+
+
+class RangeHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    root = "."
+    link = None
+    accept_ranges = True
+
+    def log_message(self, fmt, *args):
+        if not self.server.quiet:
+            super().log_message(fmt, *args)
+
+    def resource(self):
+        name = os.path.basename(self.path.split("?", 1)[0])
+        path = os.path.join(self.root, name)
+        if not name or not os.path.isfile(path):
+            self.send_error(404)
+            return None
+        with open(path, "rb") as f:
+            data = f.read()
+        etag = '"%s"' % hashlib.sha256(data).hexdigest()[:16]
+        return data, etag
+
+    def byte_range(self, size, etag):
+        header = self.headers.get("Range")
+        if not header or not self.accept_ranges:
+            return None
+        if_range = self.headers.get("If-Range")
+        if if_range and if_range != etag:
+            return None
+        m = re.fullmatch(r"bytes=(\d+)-(\d*)", header.strip())
+        if not m:
+            return None
+        first = int(m.group(1))
+        last = int(m.group(2)) if m.group(2) else size - 1
+        if first >= size or last < first:
+            return (size, size)
+        return (first, min(last, size - 1))
+
+    def respond(self, body):
+        found = self.resource()
+        if not found:
+            return
+        data, etag = found
+        rng = self.byte_range(len(data), etag)
+
+        if rng and rng[0] >= len(data):
+            self.send_response(416)
+            self.send_header("Content-Range", "bytes */%d" % len(data))
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+
+        if rng:
+            first, last = rng
+            self.send_response(206)
+            self.send_header("Content-Range",
+                             "bytes %d-%d/%d" % (first, last, len(data)))
+            data = data[first:last + 1]
+        else:
+            self.send_response(200)
+
+        if self.accept_ranges:
+            self.send_header("Accept-Ranges", "bytes")
+        self.send_header("ETag", etag)
+        self.send_header("Content-Length", str(len(data)))
+        self.send_header("Content-Type", "application/octet-stream")
+        self.end_headers()
+
+        if body:
+            self.link.send(self.wfile, data)
+
+    def do_HEAD(self):
+        self.respond(False)
+
+    def do_GET(self):
+        self.respond(True)
+
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+    quiet = False
+
+
+def start_server(root, port, link, accept_ranges, quiet):
+    handler = type("Handler", (RangeHandler,), {
+        "root": root,
+        "link": link,
+        "accept_ranges": accept_ranges,
+    })
+    server = Server(("", port), handler)
+    server.quiet = quiet
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    return server
+
+
+def fetch_range(url, first, last, etag, out, index):
+    req = urllib.request.Request(url, headers={
+        "Range": "bytes=%d-%d" % (first, last),
+        "If-Range": etag,
+    })
+    with urllib.request.urlopen(req) as rsp:
+        if rsp.status != 206:
+            raise RuntimeError("segment %d: status %d" % (index, rsp.status))
+        out[index] = rsp.read()
+
+
+def download(url, segments):
+    """Downloads like http_download_file_segmented(), returns the data."""
+    head = urllib.request.Request(url, method="HEAD")
+    with urllib.request.urlopen(head) as rsp:
+        size = int(rsp.headers["Content-Length"])
+        etag = rsp.headers["ETag"]
+
+    bounds = [size * i // segments for i in range(segments)] + [size]
+    out = [None] * segments
+    threads = [threading.Thread(target=fetch_range,
+                                args=(url, bounds[i], bounds[i + 1] - 1,
+                                      etag, out, i))
+               for i in range(segments)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    if any(part is None for part in out):
+        raise RuntimeError("a segment failed")
+    return b"".join(out)
+
+
+def bench(args):
+    rtts = [int(v) for v in args.rtt_ms.split(",")]
+    data = os.urandom(args.size * 1024)
+    digest = hashlib.sha256(data).hexdigest()
+
+    with tempfile.TemporaryDirectory() as root:
+        with open(os.path.join(root, "bench.bin"), "wb") as f:
+            f.write(data)
+
+        print(f"📦 {args.size} KiB, window {args.window} B, "
+              f"link {args.link_kbps or 'unlimited'} kbit/s")
+        print("RTT ms | " + " | ".join(f"N={n:<2} KiB/s"
+                                       for n in range(1, args.segments + 1)))
+
+        for rtt in rtts:
+            link = Link(rtt, args.window, args.link_kbps)
+            server = start_server(root, 0, link, True, True)
+            url = "http://127.0.0.1:%d/bench.bin" % server.server_address[1]
+            row = []
+            for n in range(1, args.segments + 1):
+                start = time.monotonic()
+                got = download(url, n)
+                elapsed = time.monotonic() - start
+                if hashlib.sha256(got).hexdigest() != digest:
+                    print("❌ Hash mismatch with %d segments" % n)
+                    return 1
+                row.append(len(data) / 1024 / elapsed)
+            server.shutdown()
+            server.server_close()
+            print(f"{rtt:>6} | " + " | ".join(f"{v:>10.1f}" for v in row))
+
+    print("✅ All downloads matched the file hash.")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="HTTP server with Range support over an emulated link")
+    parser.add_argument("-d", "--dir", default=".",
+                        help="folder with the files to serve")
+    parser.add_argument("-p", "--port", type=int, default=8080)
+    parser.add_argument("--rtt-ms", default="100",
+                        help="round-trip time, a list for --bench")
+    parser.add_argument("--window", type=int, default=1024,
+                        help="bytes sent per round trip and connection, "
+                             "CONFIG_NET_TCP_MAX_RECV_WINDOW_SIZE")
+    parser.add_argument("--link-kbps", type=int, default=0,
+                        help="rate shared by all connections, 0 = unlimited")
+    parser.add_argument("--no-ranges", action="store_true",
+                        help="ignore Range headers, as some servers do")
+    parser.add_argument("--bench", action="store_true",
+                        help="measure throughput on the host and exit")
+    parser.add_argument("--size", type=int, default=64,
+                        help="file size for --bench (in KiB)")
+    parser.add_argument("--segments", type=int, default=4,
+                        help="highest segment count for --bench")
+    args = parser.parse_args()
+
+    if args.bench:
+        return bench(args)
+
+    if not os.path.isdir(args.dir):
+        print(f"❌ Folder {args.dir} not found.")
+        return 1
+
+    link = Link(int(args.rtt_ms), args.window, args.link_kbps)
+    server = start_server(args.dir, args.port, link, not args.no_ranges,
+                          False)
+    print(f"✅ Serving {args.dir} on port {args.port}, RTT {args.rtt_ms} ms, "
+          f"window {args.window} B")
+    try:
+        threading.Event().wait()
+    except KeyboardInterrupt:
+        server.shutdown()
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,167 @@
+# This script is a local stand-in for a live announcement source. It sends
+# the packets of an Ogg Opus file as RTP (RFC 7587) to a speaker in real
+# time, with optional packet loss, loss bursts and arrival jitter, so the
+# jitter buffer, FEC and concealment of the RTP receiver can be measured.
+#
+# In-band FEC is only present if the encoder was told to add it and runs
+# in SILK or hybrid mode (speech up to ~32 kbps), for example:
+#   opusenc --bitrate 24 --framesize 20 --set-ctl-int 4012=1 \
+#       --set-ctl-int 4014=10 speech.wav speech.opus
+#
+# Example, 5% loss in bursts of 2 with up to 40 ms of jitter:
+#   rapidreach audio rtp listen                    (on the speaker)
+#   python rtp_opus_sender.py speech.opus 192.168.1.50 --loss 5 --burst 2 \
+#       --jitter-ms 40
+#   rapidreach audio rtp stats                     (after the stream)
+#
+# Mouth-to-speaker latency is the encoder frame (capture) plus the network
+# transit (below 1 ms on a local network) plus the "arrival to sound" time
+# reported by the speaker.
+
+import argparse
+import heapq
+import random
+import socket
+import struct
+import sys
+import time
+
+RTP_VERSION = 2
+OPUS_CLOCK = 48000
+
+
+def read_opus_packets(path):
+    with open(path, "rb") as f:
+        data = f.read()
+
+    packets = []
+    partial = b""
+    pos = 0
+    while pos + 27 <= len(data):
+        if data[pos:pos + 4] != b"OggS":
+            sys.exit(f"❌ {path}: lost Ogg page sync at {pos}")
+        segments = data[pos + 26]
+        lacing = data[pos + 27:pos + 27 + segments]
+        body = pos + 27 + segments
+        for size in lacing:
+            partial += data[body:body + size]
+            body += size
+            if size < 255:
+                packets.append(partial)
+                partial = b""
+        pos = body
+
+    if len(packets) < 3 or not packets[0].startswith(b"OpusHead"):
+        sys.exit(f"❌ {path}: not an Ogg Opus file")
+
+    # OpusHead and OpusTags are not sent
+    return packets[2:]
+
+
+def opus_samples(packet):
+    """Returns the packet duration in 48 kHz samples and the codec mode."""
+    toc = packet[0]
+    config = toc >> 3
+    if config < 12:
+        frame, mode = (480, 960, 1920, 2880)[config & 3], "silk"
+    elif config < 16:
+        frame, mode = (480, 960)[config & 1], "hybrid"
+    else:
+        frame, mode = (120, 240, 480, 960)[config & 3], "celt"
+
+    code = toc & 3
+    if code == 0:
+        count = 1
+    elif code in (1, 2):
+        count = 2
+    else:
+        count = packet[1] & 0x3F if len(packet) > 1 else 1
+    return frame * count, mode
+
+
+parser = argparse.ArgumentParser(description="Send an Opus file as RTP")
+parser.add_argument("file", help="Ogg Opus file (20 ms frames recommended)")
+parser.add_argument("host", help="speaker address")
+parser.add_argument("--port", type=int, default=5004,
+                    help="UDP port (default 5004)")
+parser.add_argument("--pt", type=int, default=96,
+                    help="RTP payload type (default 96)")
+parser.add_argument("--loss", type=float, default=0,
+                    help="chance in %% that a loss burst starts at a packet")
+parser.add_argument("--burst", type=int, default=1,
+                    help="packets lost per burst (default 1)")
+parser.add_argument("--jitter-ms", type=float, default=0,
+                    help="random extra delay per packet, may reorder")
+parser.add_argument("--seed", type=int, default=None,
+                    help="random seed for a repeatable run")
+args = parser.parse_args()
+
+rng = random.Random(args.seed)
+packets = read_opus_packets(args.file)
+
+ssrc = rng.getrandbits(32)
+seq = rng.getrandbits(16)
+timestamp = rng.getrandbits(32)
+
+# Build the send schedule first, the loss and jitter are decided up front
+schedule = []
+modes = {}
+offset_s = 0.0
+burst_left = 0
+lost = 0
+for index, payload in enumerate(packets):
+    samples, mode = opus_samples(payload)
+    modes[mode] = modes.get(mode, 0) + 1
+
+    if burst_left == 0 and rng.random() * 100 < args.loss:
+        burst_left = args.burst
+    if burst_left > 0:
+        burst_left -= 1
+        lost += 1
+    else:
+        header = struct.pack("!BBHII", RTP_VERSION << 6, args.pt & 0x7F,
+                             seq & 0xFFFF, timestamp & 0xFFFFFFFF, ssrc)
+        send_at = offset_s + rng.uniform(0, args.jitter_ms / 1000)
+        heapq.heappush(schedule, (send_at, index, header + payload))
+
+    seq += 1
+    timestamp += samples
+    offset_s += samples / OPUS_CLOCK
+
+duration_s = offset_s
+print(f"➡️ {args.file}: {len(packets)} packets, {duration_s:.1f} s, "
+      f"modes {modes}")
+if modes.get("celt", 0) == len(packets):
+    print("⚠️ CELT-only stream, lost packets can only be concealed (no FEC)")
+
+sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+target = (args.host, args.port)
+
+print(f"➡️ Sending to {args.host}:{args.port}, ssrc 0x{ssrc:08x}, "
+      f"loss {args.loss}% x{args.burst}, jitter {args.jitter_ms} ms")
+
+start = time.monotonic()
+sent = 0
+reordered = 0
+last_index = -1
+late_max = 0.0
+while schedule:
+    send_at, index, datagram = heapq.heappop(schedule)
+    wait = start + send_at - time.monotonic()
+    if wait > 0:
+        time.sleep(wait)
+    else:
+        late_max = max(late_max, -wait)
+
+    sock.sendto(datagram, target)
+    sent += 1
+    if index < last_index:
+        reordered += 1
+    last_index = max(last_index, index)
+
+elapsed = time.monotonic() - start
+print(f"✅ Sent {sent} packets in {elapsed:.1f} s, {lost} dropped "
+      f"({100 * lost / len(packets):.1f}%), {reordered} reordered")
+if late_max > 0.005:
+    print(f"⚠️ Sender fell behind by up to {late_max * 1000:.1f} ms")
+print("➡️ Read the receiver side with: rapidreach audio rtp stats")
@@ -0,0 +1,555 @@
+/**
+ * @file audio_eq.c
+ * @brief Speaker-correction equalizer for the audio player output path.
+ *
+ * A cascade of Direct Form I biquads with 16-bit history and Q14
+ * coefficients. Each stage keeps its coefficients and history packed as
+ * pairs of halfwords, so on cores with the DSP extension one stage costs
+ * two SMLALD dual-MACs, one MLA, a saturation and two pack instructions
+ * per sample. The portable kernel performs exactly the same integer
+ * arithmetic and is used as the reference by the self test, and both are
+ * checked against golden vectors from script/generate_eq_profile.py.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/fs/fs.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#if defined(CONFIG_ARMV8_M_DSP)
+#include <cmsis_core.h>
+#define AUDIO_EQ_DSP_KERNEL 1
+#endif
+
+#include "audio_eq.h"
+#include "audio_eq_golden.h"
+
+LOG_MODULE_REGISTER(audio_eq, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
+
+#define EQ_MAX_STAGES      CONFIG_RPR_AUDIO_EQ_MAX_STAGES
+#define EQ_COEF_PER_STAGE  5
+#define EQ_ROUND           (1 << (AUDIO_EQ_COEF_SHIFT - 1))
+#define EQ_LINE_MAX_LEN    64
+#define EQ_PROFILE_MAX_LEN (EQ_MAX_STAGES * EQ_LINE_MAX_LEN + 256)
+#define EQ_SELFTEST_SEED   0x1234567u
+
+struct eq_biquad {
+    int32_t  b0;
+    uint32_t b12; /* b1 in the low halfword, b2 in the high halfword */
+    uint32_t a12; /* -a1 and -a2, so the feedback is a plain MAC */
+    uint32_t x12; /* x[n-1] and x[n-2] */
+    uint32_t y12; /* y[n-1] and y[n-2] */
+};
+
+struct eq_profile {
+    struct eq_biquad stage[EQ_MAX_STAGES];
+    int16_t          coef[EQ_MAX_STAGES][EQ_COEF_PER_STAGE];
+    size_t           stages;
+};
+
+struct audio_eq_cfg {
+    struct eq_profile profile;
+    struct k_mutex    lock;
+    bool              enabled;
+};
+
+static struct audio_eq_cfg audio_eq_cfg = {
+    .lock    = Z_MUTEX_INITIALIZER(audio_eq_cfg.lock),
+    .enabled = true,
+};
+
+/* Scratch profiles, kept static so the shell and audio stacks stay small */
+static struct eq_profile eq_load_profile;
+static struct eq_profile eq_test_profile[2];
+static char              eq_file_buf[EQ_PROFILE_MAX_LEN + 1];
+
+/* Built-in stages for the self test: 80 Hz high-pass and +6 dB at 3 kHz */
+static const int16_t eq_test_coef[][EQ_COEF_PER_STAGE] = {
+    { 16263, -32526, 16263, -32525, 16143 },
+    { 18329, -26662, 10529, -26662, 12475 },
+};
+
+/**
+ * @brief Returns the signed low halfword of a packed pair.
+ */
+static inline int32_t eq_lo(uint32_t v)
+{
+    return (int16_t)(v & 0xFFFF);
+}
+
+/**
+ * @brief Returns the signed high halfword of a packed pair.
+ */
+static inline int32_t eq_hi(uint32_t v)
+{
+    return (int16_t)(v >> 16);
+}
+
+/**
+ * @brief Packs two halfwords into a word, `lo` in bits 0..15.
+ */
+static inline uint32_t eq_pack(int32_t lo, int32_t hi)
+{
+    return ((uint32_t)lo & 0xFFFF) | ((uint32_t)hi << 16);
+}
+
+/**
+ * @brief Saturates a value to the signed 16-bit range.
+ */
+static inline int32_t eq_sat16(int32_t v)
+{
+    return CLAMP(v, INT16_MIN, INT16_MAX);
+}
+
+/**
+ * @brief Negates a Q14 feedback coefficient without overflowing int16.
+ */
+static inline int32_t eq_negate(int32_t v)
+{
+    return (v == INT16_MIN) ? INT16_MAX : -v;
+}
+
+/**
+ * @brief Portable biquad kernel, the bit-exact reference.
+ *
+ * @param s       Stage state.
+ * @param pcm     Samples to filter in place.
+ * @param samples Number of samples.
+ */
+static void eq_stage_ref(struct eq_biquad *s, int16_t *pcm, size_t samples)
+{
+    uint32_t x12 = s->x12;
+    uint32_t y12 = s->y12;
+
+    for (size_t i = 0; i < samples; i++) {
+        int32_t x   = pcm[i];
+        int64_t acc = EQ_ROUND + (int64_t)s->b0 * x;
+
+        acc += (int64_t)eq_lo(s->b12) * eq_lo(x12);
+        acc += (int64_t)eq_hi(s->b12) * eq_hi(x12);
+        acc += (int64_t)eq_lo(s->a12) * eq_lo(y12);
+        acc += (int64_t)eq_hi(s->a12) * eq_hi(y12);
+
+        int32_t y = eq_sat16((int32_t)(acc >> AUDIO_EQ_COEF_SHIFT));
+
+        x12    = eq_pack(x, eq_lo(x12));
+        y12    = eq_pack(y, eq_lo(y12));
+        pcm[i] = (int16_t)y;
+    }
+
+    s->x12 = x12;
+    s->y12 = y12;
+}
+
+#ifdef AUDIO_EQ_DSP_KERNEL
+/**
+ * @brief Biquad kernel using the Cortex-M33 DSP dual-MAC instructions.
+ *
+ * @param s       Stage state.
+ * @param pcm     Samples to filter in place.
+ * @param samples Number of samples.
+ */
+static void eq_stage_dsp(struct eq_biquad *s, int16_t *pcm, size_t samples)
+{
+    const int32_t  b0  = s->b0;
+    const uint32_t b12 = s->b12;
+    const uint32_t a12 = s->a12;
+    uint32_t       x12 = s->x12;
+    uint32_t       y12 = s->y12;
+
+    for (size_t i = 0; i < samples; i++) {
+        int32_t x   = pcm[i];
+        int64_t acc = EQ_ROUND + (int64_t)(b0 * x);
+
+        acc = (int64_t)__SMLALD(x12, b12, (uint64_t)acc);
+        acc = (int64_t)__SMLALD(y12, a12, (uint64_t)acc);
+
+        int32_t y = __SSAT((int32_t)(acc >> AUDIO_EQ_COEF_SHIFT), 16);
+
+        x12    = __PKHBT(x, x12, 16);
+        y12    = __PKHBT(y, y12, 16);
+        pcm[i] = (int16_t)y;
+    }
+
+    s->x12 = x12;
+    s->y12 = y12;
+}
+#endif
+
+/**
+ * @brief Runs all stages of a profile over a block.
+ *
+ * @param profile   Profile to apply.
+ * @param pcm       Samples to filter in place.
+ * @param samples   Number of samples.
+ * @param reference true to force the portable kernel.
+ */
+static void eq_profile_run(struct eq_profile *profile,
+                           int16_t           *pcm,
+                           size_t             samples,
+                           bool               reference)
+{
+    for (size_t i = 0; i < profile->stages; i++) {
+#ifdef AUDIO_EQ_DSP_KERNEL
+        if (!reference) {
+            eq_stage_dsp(&profile->stage[i], pcm, samples);
+            continue;
+        }
+#endif
+        eq_stage_ref(&profile->stage[i], pcm, samples);
+    }
+}
+
+/**
+ * @brief Adds one stage to a profile and prepares its packed coefficients.
+ *
+ * @param profile Profile to extend.
+ * @param coef    b0, b1, b2, a1, a2 in Q14.
+ *
+ * @return 0 on success, -ENOSPC if the profile is full.
+ */
+static int eq_profile_add(struct eq_profile *profile, const int16_t *coef)
+{
+    if (profile->stages >= EQ_MAX_STAGES) {
+        return -ENOSPC;
+    }
+
+    struct eq_biquad *s = &profile->stage[profile->stages];
+
+    memcpy(profile->coef[profile->stages], coef, sizeof(profile->coef[0]));
+
+    s->b0  = coef[0];
+    s->b12 = eq_pack(coef[1], coef[2]);
+    s->a12 = eq_pack(eq_negate(coef[3]), eq_negate(coef[4]));
+    s->x12 = 0;
+    s->y12 = 0;
+
+    profile->stages++;
+
+    return 0;
+}
+
+/**
+ * @brief Parses one profile line into five Q14 coefficients.
+ *
+ * @param line Line to parse.
+ * @param coef Array to store b0, b1, b2, a1, a2.
+ *
+ * @return 1 if a stage was parsed, 0 for an empty or comment line,
+ *         -EINVAL on a malformed line.
+ */
+static int eq_parse_line(char *line, int16_t *coef)
+{
+    char *p = line;
+
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+
+    if (*p == '\0' || *p == '#') {
+        return 0;
+    }
+
+    for (int i = 0; i < EQ_COEF_PER_STAGE; i++) {
+        char *end;
+        long  v = strtol(p, &end, 10);
+
+        if (end == p || v < INT16_MIN || v > INT16_MAX) {
+            return -EINVAL;
+        }
+        coef[i] = (int16_t)v;
+        p       = end;
+    }
+
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+
+    return (*p == '\0' || *p == '#') ? 1 : -EINVAL;
+}
+
+/**
+ * @brief Loads an equalizer profile from the file system.
+ *
+ * The new profile replaces the active one only if the whole file is valid.
+ *
+ * @param path Full path to the profile file.
+ *
+ * @return Number of loaded stages on success, negative error code otherwise.
+ */
+int audio_eq_load(const char *path)
+{
+    struct fs_file_t file;
+    ssize_t          len;
+    int              line_no = 0;
+
+    if (!path) {
+        return -EINVAL;
+    }
+
+    fs_file_t_init(&file);
+
+    int ret = fs_open(&file, path, FS_O_READ);
+    if (ret < 0) {
+        LOG_DBG("No EQ profile at %s (%d)", path, ret);
+        return ret;
+    }
+
+    len = fs_read(&file, eq_file_buf, EQ_PROFILE_MAX_LEN);
+    fs_close(&file);
+
+    if (len < 0) {
+        LOG_ERR("Failed to read EQ profile: %d", (int)len);
+        return (int)len;
+    }
+    eq_file_buf[len] = '\0';
+
+    memset(&eq_load_profile, 0, sizeof(eq_load_profile));
+
+    char *save = NULL;
+    for (char *line = strtok_r(eq_file_buf, "\r\n", &save); line;
+         line       = strtok_r(NULL, "\r\n", &save)) {
+        int16_t coef[EQ_COEF_PER_STAGE];
+
+        line_no++;
+        ret = eq_parse_line(line, coef);
+        if (ret < 0) {
+            LOG_ERR("Malformed EQ profile line %d", line_no);
+            return ret;
+        }
+        if (ret == 0) {
+            continue;
+        }
+
+        ret = eq_profile_add(&eq_load_profile, coef);
+        if (ret < 0) {
+            LOG_ERR("EQ profile has more than %d stages", EQ_MAX_STAGES);
+            return ret;
+        }
+    }
+
+    k_mutex_lock(&audio_eq_cfg.lock, K_FOREVER);
+    audio_eq_cfg.profile = eq_load_profile;
+    k_mutex_unlock(&audio_eq_cfg.lock);
+
+    LOG_INF("EQ profile %s loaded: %d stages",
+            path,
+            (int)eq_load_profile.stages);
+
+    return (int)eq_load_profile.stages;
+}
+
+/**
+ * @brief Enables or disables the equalizer without dropping the profile.
+ *
+ * @param enable true to apply the loaded profile, false to bypass it.
+ */
+void audio_eq_set_enabled(bool enable)
+{
+    audio_eq_cfg.enabled = enable;
+}
+
+/**
+ * @brief Returns true if the equalizer is enabled and has stages loaded.
+ */
+bool audio_eq_is_active(void)
+{
+    return audio_eq_cfg.enabled && audio_eq_cfg.profile.stages > 0;
+}
+
+/**
+ * @brief Returns the number of stages in the active profile.
+ */
+size_t audio_eq_stage_count(void)
+{
+    return audio_eq_cfg.profile.stages;
+}
+
+/**
+ * @brief Gets the coefficients of one stage of the active profile.
+ *
+ * @param stage Stage index.
+ * @param coef  Array of 5 values to store b0, b1, b2, a1, a2 (Q14).
+ *
+ * @return 0 on success, -EINVAL if the stage does not exist.
+ */
+int audio_eq_get_stage(size_t stage, int16_t coef[5])
+{
+    int ret = -EINVAL;
+
+    k_mutex_lock(&audio_eq_cfg.lock, K_FOREVER);
+    if (stage < audio_eq_cfg.profile.stages) {
+        memcpy(coef,
+               audio_eq_cfg.profile.coef[stage],
+               sizeof(audio_eq_cfg.profile.coef[0]));
+        ret = 0;
+    }
+    k_mutex_unlock(&audio_eq_cfg.lock);
+
+    return ret;
+}
+
+/**
+ * @brief Clears the filter history, called at the start of every stream.
+ */
+void audio_eq_reset(void)
+{
+    k_mutex_lock(&audio_eq_cfg.lock, K_FOREVER);
+    for (size_t i = 0; i < audio_eq_cfg.profile.stages; i++) {
+        audio_eq_cfg.profile.stage[i].x12 = 0;
+        audio_eq_cfg.profile.stage[i].y12 = 0;
+    }
+    k_mutex_unlock(&audio_eq_cfg.lock);
+}
+
+/**
+ * @brief Filters mono PCM samples in place with the active profile.
+ *
+ * @param pcm     Samples to process.
+ * @param samples Number of samples.
+ */
+void audio_eq_process(int16_t *pcm, size_t samples)
+{
+    if (!pcm || !audio_eq_is_active()) {
+        return;
+    }
+
+    k_mutex_lock(&audio_eq_cfg.lock, K_FOREVER);
+    eq_profile_run(&audio_eq_cfg.profile, pcm, samples, false);
+    k_mutex_unlock(&audio_eq_cfg.lock);
+}
+
+/**
+ * @brief Checks both kernels against the golden vectors.
+ *
+ * The golden input is filtered with the golden profile in chunks of the
+ * scratch buffers, so the filter history is carried across chunks as it
+ * is across I2S blocks.
+ *
+ * @param buf_a   Scratch buffer of `samples` elements.
+ * @param buf_b   Scratch buffer of `samples` elements.
+ * @param samples Samples per chunk.
+ *
+ * @return 0 if both kernels match, index of the first mismatching sample
+ *         + 1 otherwise.
+ */
+static size_t eq_golden_check(int16_t *buf_a, int16_t *buf_b, size_t samples)
+{
+    memset(eq_test_profile, 0, sizeof(eq_test_profile));
+    for (size_t i = 0; i < ARRAY_SIZE(eq_golden_coef); i++) {
+        eq_profile_add(&eq_test_profile[0], eq_golden_coef[i]);
+    }
+    eq_test_profile[1] = eq_test_profile[0];
+
+    for (size_t pos = 0; pos < ARRAY_SIZE(eq_golden_in); pos += samples) {
+        size_t len = MIN(samples, ARRAY_SIZE(eq_golden_in) - pos);
+
+        memcpy(buf_a, &eq_golden_in[pos], len * sizeof(int16_t));
+        memcpy(buf_b, &eq_golden_in[pos], len * sizeof(int16_t));
+
+        eq_profile_run(&eq_test_profile[0], buf_a, len, false);
+        eq_profile_run(&eq_test_profile[1], buf_b, len, true);
+
+        for (size_t i = 0; i < len; i++) {
+            if (buf_a[i] != eq_golden_out[pos + i] ||
+                buf_b[i] != eq_golden_out[pos + i]) {
+                LOG_ERR("EQ golden mismatch at sample %u: %d, %d != %d",
+                        (uint32_t)(pos + i),
+                        buf_a[i],
+                        buf_b[i],
+                        eq_golden_out[pos + i]);
+                return pos + i + 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Checks the optimized kernel against the portable reference.
+ *
+ * Both kernels are first checked against the golden vectors, then
+ * pseudo-random PCM is filtered with the active profile (or a built-in
+ * test profile when none is loaded) by both kernels.
+ *
+ * @param buf_a   Scratch buffer of `samples` elements.
+ * @param buf_b   Scratch buffer of `samples` elements.
+ * @param samples Samples per block.
+ * @param blocks  Number of blocks to compare.
+ *
+ * @return 0 if the outputs are bit-exact, index of the first mismatching
+ *         sample + 1 otherwise.
+ */
+size_t audio_eq_selftest(int16_t *buf_a,
+                         int16_t *buf_b,
+                         size_t   samples,
+                         uint32_t blocks)
+{
+    uint32_t seed = EQ_SELFTEST_SEED;
+
+    size_t mismatch = eq_golden_check(buf_a, buf_b, samples);
+    if (mismatch) {
+        return mismatch;
+    }
+
+    memset(eq_test_profile, 0, sizeof(eq_test_profile));
+
+    k_mutex_lock(&audio_eq_cfg.lock, K_FOREVER);
+    eq_test_profile[0] = audio_eq_cfg.profile;
+    k_mutex_unlock(&audio_eq_cfg.lock);
+
+    if (eq_test_profile[0].stages == 0) {
+        for (size_t i = 0; i < ARRAY_SIZE(eq_test_coef); i++) {
+            eq_profile_add(&eq_test_profile[0], eq_test_coef[i]);
+        }
+    }
+
+    for (size_t i = 0; i < eq_test_profile[0].stages; i++) {
+        eq_test_profile[0].stage[i].x12 = 0;
+        eq_test_profile[0].stage[i].y12 = 0;
+    }
+    eq_test_profile[1] = eq_test_profile[0];
+
+    for (uint32_t block = 0; block < blocks; block++) {
+        for (size_t i = 0; i < samples; i++) {
+            // Full-scale noise with occasional clipping peaks
+            seed     = seed * 1664525u + 1013904223u;
+            buf_a[i] = (int16_t)(seed >> 16);
+            buf_b[i] = buf_a[i];
+        }
+
+        eq_profile_run(&eq_test_profile[0], buf_a, samples, false);
+        eq_profile_run(&eq_test_profile[1], buf_b, samples, true);
+
+        for (size_t i = 0; i < samples; i++) {
+            if (buf_a[i] != buf_b[i]) {
+                LOG_ERR("EQ mismatch in block %u sample %u: %d != %d",
+                        block,
+                        (uint32_t)i,
+                        buf_a[i],
+                        buf_b[i]);
+                return block * samples + i + 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Returns true if the DSP (dual-MAC) kernel is compiled in.
+ */
+bool audio_eq_has_dsp_kernel(void)
+{
+#ifdef AUDIO_EQ_DSP_KERNEL
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,106 @@
+/**
+ * @file audio_eq.h
+ * @brief Speaker-correction equalizer for the audio player output path.
+ *
+ * The equalizer is a cascade of fixed-point Direct Form I biquads applied to
+ * the decoded PCM before it is written to the I2S. Coefficients are loaded
+ * from a text profile on LittleFS, one stage per line:
+ *
+ *     # b0 b1 b2 a1 a2, Q14
+ *     16263 -32526 16263 -32525 16143
+ *
+ * On Cortex-M33 with the DSP extension the kernel uses dual 16x16 MAC
+ * instructions, a portable C kernel with identical arithmetic is kept as
+ * the bit-exact reference. Both are checked against golden vectors from
+ * an independent model in script/generate_eq_profile.py.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_EQ_H_
+#define AUDIO_EQ_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define AUDIO_EQ_COEF_SHIFT 14 // Coefficients are stored in Q14
+
+/**
+ * @brief Loads an equalizer profile from the file system.
+ *
+ * The new profile replaces the active one only if the whole file is valid.
+ *
+ * @param path Full path to the profile file.
+ *
+ * @return Number of loaded stages on success, negative error code otherwise.
+ */
+int audio_eq_load(const char *path);
+
+/**
+ * @brief Enables or disables the equalizer without dropping the profile.
+ *
+ * @param enable true to apply the loaded profile, false to bypass it.
+ */
+void audio_eq_set_enabled(bool enable);
+
+/**
+ * @brief Returns true if the equalizer is enabled and has stages loaded.
+ */
+bool audio_eq_is_active(void);
+
+/**
+ * @brief Returns the number of stages in the active profile.
+ */
+size_t audio_eq_stage_count(void);
+
+/**
+ * @brief Gets the coefficients of one stage of the active profile.
+ *
+ * @param stage Stage index.
+ * @param coef  Array of 5 values to store b0, b1, b2, a1, a2 (Q14).
+ *
+ * @return 0 on success, -EINVAL if the stage does not exist.
+ */
+int audio_eq_get_stage(size_t stage, int16_t coef[5]);
+
+/**
+ * @brief Clears the filter history, called at the start of every stream.
+ */
+void audio_eq_reset(void);
+
+/**
+ * @brief Filters mono PCM samples in place with the active profile.
+ *
+ * @param pcm     Samples to process.
+ * @param samples Number of samples.
+ */
+void audio_eq_process(int16_t *pcm, size_t samples);
+
+/**
+ * @brief Checks the optimized kernel against the portable reference.
+ *
+ * Both kernels are first checked against the golden vectors of
+ * audio_eq_golden.h, then pseudo-random PCM is filtered with the active
+ * profile (or a built-in test profile when none is loaded) by both.
+ *
+ * @param buf_a   Scratch buffer of `samples` elements.
+ * @param buf_b   Scratch buffer of `samples` elements.
+ * @param samples Samples per block.
+ * @param blocks  Number of blocks to compare.
+ *
+ * @return 0 if the outputs are bit-exact, index of the first mismatching
+ *         sample + 1 otherwise.
+ */
+size_t audio_eq_selftest(int16_t *buf_a,
+                         int16_t *buf_b,
+                         size_t   samples,
+                         uint32_t blocks);
+
+/**
+ * @brief Returns true if the DSP (dual-MAC) kernel is compiled in.
+ */
+bool audio_eq_has_dsp_kernel(void);
+
+#endif /* AUDIO_EQ_H_ */
@@ -0,0 +1,93 @@
+/**
+ * @file audio_eq_golden.h
+ * @brief Golden vectors of the equalizer self test.
+ *
+ * Generated by script/generate_eq_profile.py --golden, do not edit. The
+ * expected output comes from an integer model of the Q14 biquads in the
+ * script, not from the firmware kernels.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_EQ_GOLDEN_H_
+#define AUDIO_EQ_GOLDEN_H_
+
+#include <stdint.h>
+
+static const int16_t eq_golden_coef[][5] = {
+    { 16263, -32526, 16263, -32525, 16143 },
+    { 18329, -26662, 10529, -26662, 12475 },
+};
+
+static const int16_t eq_golden_in[256] = {
+     32767,  32767,  32767,  32767,  32767,  32767,  32767,  32767,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+     32767,  32767,  32767,  32767,  32767,  32767,  32767,  32767,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+     32767,  32767,  32767,  32767,  32767,  32767,  32767,  32767,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+     32767,  32767,  32767,  32767,  32767,  32767,  32767,  32767,
+    -32768, -32768, -32768, -32768, -32768, -32768, -32768, -32768,
+      8175,   9233,   3945, -28606,  32556,  13233,  31219,   4996,
+     -3293,   7268,   5930,  16337, -17794,  -8744,  20357,  30414,
+      6905,   9987, -20601,   3714,  23730, -28317,    574,  -7883,
+     -3907, -29051,  -1811, -30311, -10500,   3018, -27643,  -4307,
+    -26833,   4199, -16038,   1759,  24904,  -9812,  -7276,  -5135,
+     10498,  14727,  14053, -19169, -12110,  15176,  18171, -22017,
+    -18594,  21160,  -5578, -17239,  15885, -26362,  30235,  27545,
+      6238,  -8975,   8457,  28627,  31837, -30740, -15060,  -9402,
+    -31341, -24978,  30896, -29837,  24413,  24105, -20681,   5199,
+      2687,  16013, -10098, -30873, -11783,  22414, -20324, -17597,
+    -15589,  29346, -19299,  -2291, -17195,  18959,  29070,   9843,
+     -5551, -17820, -24600,  -1589, -17212,  -5562,  16530, -27018,
+    -18302, -21394,  12050, -17528, -22190, -24591,  -8956,  32422,
+      4610, -11584,  10957,   1328,  -5317,  -5521, -28271,  -8799,
+      1431,   5947,   4708,  -8907, -23822,  21831, -24898, -23094,
+      6910, -16345,  -4558,  14345, -24805,   -863,  -2720,  13766,
+     29030,   -847,  29224, -18267,   8976, -24117,  16673,  -7937,
+    -21006,    357,  28747, -32508,  32096,  20406,  17154, -30685,
+    -17861, -19271, -25805,   4776,  28235, -28810,  31699,  16806,
+     21196,  -5246, -26483,  16149,  24136,  11461,   9916,   4668,
+     26021,  13692,  25498,  10321,  25727, -30080, -31816, -19104,
+     16569,  14791,    -81,  20843,   7503, -30936,  29205,  30160,
+    -28560, -23708,  31411, -16656,  20682,  -3741,  23286,   5647,
+     11813, -25156,  16292,  10103,  26932, -29575,  27600, -14111,
+};
+
+static const int16_t eq_golden_out[256] = {
+     32767,  32767,  32442,  31850,  31072,  30195,  29298,  28445,
+    -32768, -32768, -30396, -26036, -20252, -13673,  -6892,   -393,
+     32767,   3062, -31510, -32768, -25853, -21509, -19702, -20066,
+    -22076,  32767,  32767,  32441,  32230,  32132,  32131,  32200,
+     32376, -32768, -32768, -32432, -32215, -32115, -32115, -32187,
+    -32367,  32767,  32767,  32431,  32214,  32114,  32114,  32186,
+     32366, -32768, -32768, -32432, -32215, -32115, -32115, -32187,
+    -32367,  32767,  32767,  32431,  32214,  32114,  32114,  32186,
+     32366, -11722, -32768, -32095,  32767,  22893,  32767,  -1770,
+    -20613, -17001, -21137, -10333, -32768, -18192,  17830,  32767,
+      7555,   3138, -25050,   4384,  32767, -11720,  25514,  31099,
+     32767,   2048,  24234,  -9002,   5760,  18982, -14395,   5526,
+    -19914,   9476, -11339,   4912,  30435,  -5558,  -9513, -13105,
+      -757,   2321,     50, -32768, -28131,   1752,  10284, -28562,
+    -27827,  15777,  -5891, -17737,  18231, -22466,  32767,  32767,
+     11239,  -7503,   8973,  28043,  31630, -32768, -24441, -21827,
+    -32768, -18180,  32767, -32336,  18370,  22311, -24056,   -953,
+     -2044,  14216, -10880, -32768, -14293,  25855, -13772, -13978,
+    -14005,  32767, -15379,  -2056, -19490,  17465,  32767,  15749,
+     -2839, -21114, -32768, -10532, -24725, -11434,  16430, -25213,
+    -19198, -23511,  12739, -14377, -21400, -26368, -10814,  32767,
+      7998, -11378,   9380,    -34,  -8265, -10122, -32768, -12934,
+      1486,  10785,  12802,  -1192, -20668,  24520, -23122, -27298,
+      2340, -19830,  -8037,  14758, -23817,  -1276,  -1661,  17380,
+     32767,    595,  28487, -22783,   -303, -32768,  10356, -10023,
+    -24007,  -2124,  32373, -27269,  32767,  23873,  21031, -32131,
+    -26201, -29366, -32768,   5186,  32767, -26149,  32062,  19181,
+     21875, -10442, -32768,  12444,  28879,  21911,  22397,  17203,
+     32767,  17456,  27758,  12362,  25830, -32768, -32768, -17118,
+     25994,  32155,  18646,  32767,  12665, -32768,  24909,  31563,
+    -29306, -31559,  25774, -18879,  20333,   -983,  28480,  13172,
+     18920, -22605,  15773,  11461,  30821, -28617,  26466, -14772,
+};
+
+#endif /* AUDIO_EQ_GOLDEN_H_ */
@@ -0,0 +1,570 @@
+/**
+ * @file audio_head_cache.c
+ * @brief RAM copy of the first packets of the switch-selectable clips.
+ *
+ * The clips share one static pool. On a reload every clip gets an even
+ * share of what the clips before it left over, and stops at
+ * RPR_AUDIO_HEAD_CACHE_MS of audio. A container can continue behind any
+ * record; an Ogg file only at a page boundary, so an Ogg head is cut back
+ * to the last complete page that fits.
+ *
+ * The cache is loaded and read only by the audio thread between streams,
+ * so playback never waits for it. The lock only keeps the statistics and
+ * entry copies consistent for other threads.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "opus.h"
+#include "audio_head_cache.h"
+
+LOG_MODULE_REGISTER(audio_head_cache, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
+
+#define HEAD_CACHE_RATE     48000
+#define HEAD_CACHE_SAMPLES \
+    (CONFIG_RPR_AUDIO_HEAD_CACHE_MS * (HEAD_CACHE_RATE / 1000))
+#define HEAD_CACHE_LEN_SIZE 2
+
+#define OPUS_HEAD_MAGIC     "OpusHead"
+#define OPUS_HEAD_MAGIC_LEN 8
+#define OPUS_HEAD_CHANNELS  9
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME  16777619u
+
+struct head_cache_file {
+    char     path[AUDIO_HEAD_CACHE_PATH_MAX_LEN];
+    uint32_t size;
+};
+
+static uint8_t                       pool[CONFIG_RPR_AUDIO_HEAD_CACHE_SIZE];
+static struct audio_head_cache_entry entries[AUDIO_HEAD_CACHE_CLIPS];
+static struct head_cache_file        scan[AUDIO_HEAD_CACHE_CLIPS];
+static uint32_t                      file_count;
+static uint32_t                      signature;
+static bool                          loaded;
+static struct audio_head_cache_stats cache_stats = {
+    .size = sizeof(pool),
+};
+
+K_MUTEX_DEFINE(head_cache_lock);
+
+/**
+ * @brief Adds bytes to an FNV-1a hash.
+ */
+static uint32_t head_cache_hash(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    while (len--) {
+        hash = (hash ^ *p++) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Lists the clips the switches can select.
+ *
+ * Files are counted the way the switch handler counts them: regular files
+ * of the audio directory, in directory order.
+ *
+ * @param count Pointer to store the number of clips found.
+ * @param sig   Pointer to store the hash of their names and sizes.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int head_cache_scan(uint32_t *count, uint32_t *sig)
+{
+    struct fs_dir_t  dir;
+    struct fs_dirent entry;
+    uint32_t         hash = FNV_OFFSET;
+    uint32_t         n    = 0;
+
+    fs_dir_t_init(&dir);
+
+    int ret = fs_opendir(&dir, CONFIG_RPR_AUDIO_DEFAULT_PATH);
+    if (ret < 0) {
+        return ret;
+    }
+
+    while (n < AUDIO_HEAD_CACHE_CLIPS &&
+           (ret = fs_readdir(&dir, &entry)) == 0 && entry.name[0] != 0) {
+        if (entry.type != FS_DIR_ENTRY_FILE) {
+            continue;
+        }
+
+        snprintf(scan[n].path,
+                 sizeof(scan[n].path),
+                 "%s/%s",
+                 CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                 entry.name);
+        scan[n].size = entry.size;
+
+        hash = head_cache_hash(hash, entry.name, strlen(entry.name) + 1);
+        hash = head_cache_hash(hash, &scan[n].size, sizeof(scan[n].size));
+        n++;
+    }
+
+    fs_closedir(&dir);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    *count = n;
+    *sig   = head_cache_hash(hash, &n, sizeof(n));
+
+    return 0;
+}
+
+/**
+ * @brief Appends a packet record to an entry.
+ *
+ * @return true if the packet fits the entry budget, false otherwise.
+ */
+static bool head_cache_put(struct audio_head_cache_entry *entry,
+                           uint32_t                       budget,
+                           const uint8_t                 *packet,
+                           size_t                         len)
+{
+    if (len == 0 || len > UINT16_MAX ||
+        entry->len + HEAD_CACHE_LEN_SIZE + len > budget) {
+        return false;
+    }
+
+    uint8_t *p = pool + entry->data + entry->len;
+
+    sys_put_le16(len, p);
+    memcpy(p + HEAD_CACHE_LEN_SIZE, packet, len);
+
+    entry->len += HEAD_CACHE_LEN_SIZE + len;
+    entry->packets++;
+
+    return true;
+}
+
+#ifdef CONFIG_RPR_AUDIO_PACKED
+/**
+ * @brief Caches the head of a container.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int head_cache_load_packed(struct audio_packed_reader    *reader,
+                                  struct audio_head_cache_entry *entry,
+                                  uint32_t                       budget)
+{
+    const uint8_t *packet;
+    size_t         len;
+    uint32_t       offset = AUDIO_PACKED_HEADER_SIZE;
+    int            ret    = 1;
+
+    entry->packed   = true;
+    entry->channels = reader->header.channels;
+
+    while (entry->samples < HEAD_CACHE_SAMPLES &&
+           (ret = audio_packed_next(reader, &packet, &len)) > 0) {
+        int samples = opus_packet_get_nb_samples(packet, len, HEAD_CACHE_RATE);
+        if (samples < 0) {
+            return -EBADMSG;
+        }
+
+        if (!head_cache_put(entry, budget, packet, len)) {
+            break;
+        }
+
+        entry->samples += samples;
+        offset += HEAD_CACHE_LEN_SIZE + len;
+    }
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    entry->resume.offset   = offset;
+    entry->resume.packetno = entry->packets;
+    entry->whole = (entry->packets == reader->header.packet_count);
+
+    return entry->packets > 0 ? 0 : -ENOSPC;
+}
+#endif
+
+/**
+ * @brief Caches the head of an Ogg Opus file, in whole pages.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int head_cache_load_ogg(const struct audio_head_cache_work *work,
+                               struct fs_file_t                   *file,
+                               struct audio_head_cache_entry      *entry,
+                               uint32_t                            budget)
+{
+    struct audio_ogg_packet packet;
+
+    /* Cache state at the last page boundary */
+    uint32_t mark_len     = 0;
+    uint32_t mark_packets = 0;
+    uint32_t mark_samples = 0;
+
+    int ret = audio_ogg_init(work->demux,
+                             file,
+                             work->buf,
+                             work->size,
+                             work->packet_buf,
+                             work->packet_size);
+
+    while (ret >= 0 && (ret = audio_ogg_next(work->demux, &packet)) > 0) {
+        if (packet.packetno == 0) {
+            if (packet.len <= OPUS_HEAD_CHANNELS ||
+                memcmp(packet.data, OPUS_HEAD_MAGIC, OPUS_HEAD_MAGIC_LEN)) {
+                return -ENOMSG;
+            }
+            entry->channels = packet.data[OPUS_HEAD_CHANNELS];
+            continue;
+        }
+
+        // Skip the second packet (OpusTags)
+        if (packet.packetno == 1) {
+            continue;
+        }
+
+        int samples = opus_packet_get_nb_samples(
+                packet.data, packet.len, HEAD_CACHE_RATE);
+        if (samples < 0 ||
+            !head_cache_put(entry, budget, packet.data, packet.len)) {
+            break;
+        }
+
+        entry->samples += samples;
+
+        if (audio_ogg_tell(work->demux, &entry->resume) == 0) {
+            mark_len     = entry->len;
+            mark_packets = entry->packets;
+            mark_samples = entry->samples;
+
+            if (entry->samples >= HEAD_CACHE_SAMPLES) {
+                break;
+            }
+        }
+    }
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (ret == 0) {
+        entry->whole = true;
+        return entry->packets > 0 ? 0 : -ENODATA;
+    }
+
+    // The file can only continue behind a complete page
+    entry->len     = mark_len;
+    entry->packets = mark_packets;
+    entry->samples = mark_samples;
+
+    return entry->packets > 0 ? 0 : -ENOSPC;
+}
+
+/**
+ * @brief Hashes the file bytes a head was read from.
+ *
+ * That is the whole file for a clip cached whole, otherwise the bytes
+ * before the position the file continues at.
+ *
+ * @param work  Buffers to read the file with.
+ * @param entry Loaded entry.
+ * @param hash  Pointer to store the hash.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int head_cache_hash_file(const struct audio_head_cache_work  *work,
+                                const struct audio_head_cache_entry *entry,
+                                uint32_t                            *hash)
+{
+    struct fs_file_t file;
+    uint32_t         left = entry->whole ? entry->size : entry->resume.offset;
+    uint32_t         h    = FNV_OFFSET;
+
+    fs_file_t_init(&file);
+
+    int ret = fs_open(&file, entry->path, FS_O_READ);
+    if (ret < 0) {
+        return ret;
+    }
+
+    while (left > 0) {
+        ssize_t len = fs_read(&file, work->buf, MIN(left, work->size));
+        if (len <= 0) {
+            ret = len < 0 ? len : -ENODATA;
+            break;
+        }
+
+        h = head_cache_hash(h, work->buf, len);
+        left -= len;
+    }
+
+    fs_close(&file);
+
+    *hash = h;
+
+    return ret;
+}
+
+/**
+ * @brief Checks the cached heads against their files.
+ *
+ * @param work Buffers to read the files with.
+ *
+ * @return true if a file the heads were read from has changed.
+ */
+static bool head_cache_changed(const struct audio_head_cache_work *work)
+{
+    for (uint32_t i = 0; i < file_count; i++) {
+        const struct audio_head_cache_entry *entry = &entries[i];
+        uint32_t                             hash;
+
+        if (entry->packets == 0) {
+            continue;
+        }
+
+        if (head_cache_hash_file(work, entry, &hash) < 0 ||
+            hash != entry->hash) {
+            LOG_INF("%s changed since it was cached", entry->path);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Caches the head of one clip at the current pool end.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int head_cache_load(const struct audio_head_cache_work *work,
+                           struct audio_head_cache_entry      *entry,
+                           uint32_t                            budget)
+{
+    struct fs_file_t file;
+    fs_file_t_init(&file);
+
+    int ret = fs_open(&file, entry->path, FS_O_READ);
+    if (ret < 0) {
+        return ret;
+    }
+
+#ifdef CONFIG_RPR_AUDIO_PACKED
+    ret = audio_packed_open(work->reader, &file);
+    if (ret == 0) {
+        ret = head_cache_load_packed(work->reader, entry, budget);
+    } else if (ret == -ENOMSG) {
+        ret = head_cache_load_ogg(work, &file, entry, budget);
+    }
+#else
+    ret = head_cache_load_ogg(work, &file, entry, budget);
+#endif
+
+    fs_close(&file);
+
+    return ret;
+}
+
+int audio_head_cache_refresh(const struct audio_head_cache_work *work,
+                             bool                                force)
+{
+    uint32_t count;
+    uint32_t sig;
+
+    if (!work) {
+        return -EINVAL;
+    }
+
+    int ret = head_cache_scan(&count, &sig);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (!force && loaded && sig == signature && !head_cache_changed(work)) {
+        return 0;
+    }
+
+    int64_t  start  = k_uptime_get();
+    uint32_t used   = 0;
+    uint32_t cached = 0;
+
+    k_mutex_lock(&head_cache_lock, K_FOREVER);
+
+    for (uint32_t i = 0; i < count; i++) {
+        struct audio_head_cache_entry *entry = &entries[i];
+        uint32_t budget = (sizeof(pool) - used) / (count - i);
+
+        memset(entry, 0, sizeof(*entry));
+        memcpy(entry->path, scan[i].path, sizeof(entry->path));
+        entry->size = scan[i].size;
+        entry->data = used;
+
+        ret = head_cache_load(work, entry, budget);
+        if (ret == 0) {
+            ret = head_cache_hash_file(work, entry, &entry->hash);
+        }
+        if (ret < 0) {
+            LOG_WRN("Cannot cache %s (%d)", entry->path, ret);
+            entry->len     = 0;
+            entry->packets = 0;
+            continue;
+        }
+
+        used += entry->len;
+        cached++;
+
+        LOG_DBG("Cached %u ms of %s%s",
+                entry->samples / (HEAD_CACHE_RATE / 1000),
+                entry->path,
+                entry->whole ? " (whole clip)" : "");
+    }
+
+    file_count          = count;
+    signature           = sig;
+    loaded              = true;
+    cache_stats.clips   = cached;
+    cache_stats.used    = used;
+    cache_stats.load_ms = k_uptime_get() - start;
+    cache_stats.refreshes++;
+
+    k_mutex_unlock(&head_cache_lock);
+
+    LOG_INF("Head cache: %u of %u clips, %u bytes, loaded in %u ms",
+            cached,
+            count,
+            used,
+            cache_stats.load_ms);
+
+    return cached;
+}
+
+const struct audio_head_cache_entry *audio_head_cache_find(const char *path)
+{
+    const struct audio_head_cache_entry *found = NULL;
+
+    if (!path) {
+        return NULL;
+    }
+
+    k_mutex_lock(&head_cache_lock, K_FOREVER);
+
+    for (uint32_t i = 0; i < file_count; i++) {
+        if (entries[i].packets > 0 && strcmp(entries[i].path, path) == 0) {
+            found = &entries[i];
+            break;
+        }
+    }
+
+    if (found) {
+        cache_stats.hits++;
+    } else {
+        cache_stats.misses++;
+    }
+
+    k_mutex_unlock(&head_cache_lock);
+
+    return found;
+}
+
+int audio_head_cache_next(const struct audio_head_cache_entry *entry,
+                          uint32_t                            *pos,
+                          const uint8_t                      **packet,
+                          size_t                              *len)
+{
+    if (!entry || !pos || !packet || !len) {
+        return -EINVAL;
+    }
+
+    if (*pos + HEAD_CACHE_LEN_SIZE > entry->len) {
+        return 0;
+    }
+
+    const uint8_t *p = pool + entry->data + *pos;
+
+    *len    = sys_get_le16(p);
+    *packet = p + HEAD_CACHE_LEN_SIZE;
+    *pos += HEAD_CACHE_LEN_SIZE + *len;
+
+    return 1;
+}
+
+void audio_head_cache_invalidate(const struct audio_head_cache_entry *entry)
+{
+    k_mutex_lock(&head_cache_lock, K_FOREVER);
+
+    if (entry >= entries && entry < entries + file_count) {
+        LOG_WRN("%s changed since it was cached", entry->path);
+        // Played from flash until the next refresh
+        entries[entry - entries].packets = 0;
+        cache_stats.stale++;
+    }
+    loaded = false;
+
+    k_mutex_unlock(&head_cache_lock);
+}
+
+int audio_head_cache_get_path(int index, char *path, size_t size)
+{
+    int ret = -ENOENT;
+
+    if (!path || size == 0) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&head_cache_lock, K_FOREVER);
+
+    if (loaded && index >= 1 && index <= file_count) {
+        strncpy(path, entries[index - 1].path, size - 1);
+        path[size - 1] = '\0';
+        ret            = 0;
+    }
+
+    k_mutex_unlock(&head_cache_lock);
+
+    return ret;
+}
+
+int audio_head_cache_get_entry(size_t                         index,
+                               struct audio_head_cache_entry *entry)
+{
+    int ret = -ENOENT;
+
+    if (!entry) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&head_cache_lock, K_FOREVER);
+
+    if (index < file_count) {
+        *entry = entries[index];
+        ret    = 0;
+    }
+
+    k_mutex_unlock(&head_cache_lock);
+
+    return ret;
+}
+
+void audio_head_cache_get_stats(struct audio_head_cache_stats *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    k_mutex_lock(&head_cache_lock, K_FOREVER);
+    *stats = cache_stats;
+    k_mutex_unlock(&head_cache_lock);
+}
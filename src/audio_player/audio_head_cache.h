@@ -0,0 +1,151 @@
+/**
+ * @file audio_head_cache.h
+ * @brief RAM copy of the first packets of the switch-selectable clips.
+ *
+ * The first files of RPR_AUDIO_DEFAULT_PATH, in the order the DIP switches
+ * select them, keep their first Opus packets in RAM. A cached clip starts
+ * decoding from RAM at once, and the file is opened and positioned behind
+ * the cached packets while the head is playing.
+ *
+ * The packets are stored compressed as u16 length + Opus packet records,
+ * the record format of audio_packed. Decoded PCM would take 96 KiB per
+ * second and clip.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_HEAD_CACHE_H_
+#define AUDIO_HEAD_CACHE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio_ogg.h"
+
+#ifdef CONFIG_RPR_AUDIO_PACKED
+#include "audio_packed.h"
+#endif
+
+#define AUDIO_HEAD_CACHE_CLIPS CONFIG_RPR_AUDIO_HEAD_CACHE_CLIPS
+#define AUDIO_HEAD_CACHE_PATH_MAX_LEN \
+    (CONFIG_RPR_FOLDER_PATH_MAX_LEN + CONFIG_RPR_FILENAME_MAX_LEN)
+
+struct audio_head_cache_entry {
+    char     path[AUDIO_HEAD_CACHE_PATH_MAX_LEN];
+    uint32_t size;    /* Size of the file the head was read from */
+    bool     packed;  /* Container, otherwise Ogg */
+    bool     whole;   /* The entire clip is cached */
+    uint8_t  channels;
+    uint32_t data;    /* Pool offset of the first record */
+    uint32_t len;     /* Record bytes */
+    uint32_t packets;
+    uint32_t samples; /* Cached audio at 48 kHz */
+    uint32_t hash;    /* Of the file bytes the head was read from */
+    /* Where the file continues. A container only uses the offset of the
+     * next record and its packet index (packetno). */
+    struct audio_ogg_position resume;
+};
+
+/* Playback buffers lent to the cache while the player is idle */
+struct audio_head_cache_work {
+    struct audio_ogg_demux     *demux;
+    uint8_t                    *buf;
+    size_t                      size;
+    uint8_t                    *packet_buf;
+    size_t                      packet_size;
+#ifdef CONFIG_RPR_AUDIO_PACKED
+    struct audio_packed_reader *reader;
+#endif
+};
+
+struct audio_head_cache_stats {
+    uint32_t clips;
+    uint32_t used;       /* Pool bytes holding records */
+    uint32_t size;       /* Pool size */
+    uint32_t refreshes;  /* Loads of the whole cache */
+    uint32_t load_ms;    /* Time the last load took */
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t stale;      /* Hits whose file had changed */
+};
+
+/**
+ * @brief Reloads the cache if the audio directory has changed.
+ *
+ * The directory is compared by the names and sizes of the clips, and each
+ * cached head by a hash of the file bytes it was read from, so a clip
+ * replaced by one of the same size is reloaded too. Must be called from
+ * the audio thread, between streams.
+ *
+ * @param work  Buffers to read the files with.
+ * @param force Reload even if the directory looks unchanged.
+ *
+ * @return Number of cached clips if reloaded, 0 if unchanged, negative
+ *         error code otherwise.
+ */
+int audio_head_cache_refresh(const struct audio_head_cache_work *work,
+                             bool                                force);
+
+/**
+ * @brief Looks up the cached head of a file.
+ *
+ * @param path Full path of the file.
+ *
+ * @return Cache entry, NULL if the file is not cached.
+ */
+const struct audio_head_cache_entry *audio_head_cache_find(const char *path);
+
+/**
+ * @brief Gets the next cached packet of a clip.
+ *
+ * @param entry  Entry returned by audio_head_cache_find().
+ * @param pos    Record offset within the entry, 0 to start.
+ * @param packet Pointer to store the packet address.
+ * @param len    Pointer to store the packet length.
+ *
+ * @return 1 if a packet was returned, 0 after the last cached packet.
+ */
+int audio_head_cache_next(const struct audio_head_cache_entry *entry,
+                          uint32_t                            *pos,
+                          const uint8_t                      **packet,
+                          size_t                              *len);
+
+/**
+ * @brief Marks a clip as changed, so the next refresh reloads the cache.
+ *
+ * @param entry Entry whose file no longer matches.
+ */
+void audio_head_cache_invalidate(const struct audio_head_cache_entry *entry);
+
+/**
+ * @brief Gets the path of a clip by its switch index.
+ *
+ * @param index Clip index, counted from 1 as the switches select it.
+ * @param path  Buffer to store the full path.
+ * @param size  Buffer size.
+ *
+ * @return 0 on success, -ENOENT if the index is not cached.
+ */
+int audio_head_cache_get_path(int index, char *path, size_t size);
+
+/**
+ * @brief Copies one entry of the cache.
+ *
+ * @param index Clip index, counted from 0.
+ * @param entry Pointer to store the entry.
+ *
+ * @return 0 on success, -ENOENT past the last clip.
+ */
+int audio_head_cache_get_entry(size_t                         index,
+                               struct audio_head_cache_entry *entry);
+
+/**
+ * @brief Gets the cache statistics.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void audio_head_cache_get_stats(struct audio_head_cache_stats *stats);
+
+#endif /* AUDIO_HEAD_CACHE_H_ */
@@ -0,0 +1,722 @@
+/**
+ * @file audio_ogg.c
+ * @brief Zero-allocation Ogg demuxer over a caller-owned buffer.
+ *
+ * libogg copies every byte twice on the way to the decoder: from the read
+ * buffer into its growing sync buffer and from there into the stream body
+ * buffer. Here the file is read straight into the caller's buffer and
+ * packets are handed out in place.
+ *
+ * A page must be contiguous for its packets to be views, so the buffer is
+ * not a wrapping ring: when the next page does not fit behind the current
+ * one, only the unread bytes are moved to the buffer start. The page CRC
+ * is updated with each read as the bytes arrive and is complete the moment
+ * the last byte of the page is in.
+ *
+ * Lost pages, continued packets and foreign streams are handled the way
+ * libogg does it, so both return the same packets with the same numbers.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ogg/ogg.h"
+#include "audio_ogg.h"
+
+#ifdef CONFIG_RPR_FLASH_QOS
+#include "flash_qos.h"
+#endif
+
+LOG_MODULE_REGISTER(audio_ogg, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
+
+#define OGG_CAPTURE        "OggS"
+#define OGG_CAPTURE_LEN    4
+#define OGG_VERSION        0
+#define OGG_FLAG_CONTINUED 0x01
+#define OGG_FLAG_EOS       0x04
+#define OGG_OFF_VERSION    4
+#define OGG_OFF_FLAGS      5
+#define OGG_OFF_GRANULE    6
+#define OGG_OFF_SERIAL     14
+#define OGG_OFF_SEQUENCE   18
+#define OGG_OFF_CRC        22
+#define OGG_CRC_LEN        4
+#define OGG_OFF_SEGMENTS   26
+#define OGG_LACING_MAX     255
+
+#define OGG_VERIFY_CHUNK 2048
+
+/* CRC-32, polynomial 0x04c11db7, no reflection, as in RFC 3533 */
+static const uint32_t ogg_crc_table[256] = {
+    0x00000000, 0x04c11db7, 0x09823b6e, 0x0d4326d9,
+    0x130476dc, 0x17c56b6b, 0x1a864db2, 0x1e475005,
+    0x2608edb8, 0x22c9f00f, 0x2f8ad6d6, 0x2b4bcb61,
+    0x350c9b64, 0x31cd86d3, 0x3c8ea00a, 0x384fbdbd,
+    0x4c11db70, 0x48d0c6c7, 0x4593e01e, 0x4152fda9,
+    0x5f15adac, 0x5bd4b01b, 0x569796c2, 0x52568b75,
+    0x6a1936c8, 0x6ed82b7f, 0x639b0da6, 0x675a1011,
+    0x791d4014, 0x7ddc5da3, 0x709f7b7a, 0x745e66cd,
+    0x9823b6e0, 0x9ce2ab57, 0x91a18d8e, 0x95609039,
+    0x8b27c03c, 0x8fe6dd8b, 0x82a5fb52, 0x8664e6e5,
+    0xbe2b5b58, 0xbaea46ef, 0xb7a96036, 0xb3687d81,
+    0xad2f2d84, 0xa9ee3033, 0xa4ad16ea, 0xa06c0b5d,
+    0xd4326d90, 0xd0f37027, 0xddb056fe, 0xd9714b49,
+    0xc7361b4c, 0xc3f706fb, 0xceb42022, 0xca753d95,
+    0xf23a8028, 0xf6fb9d9f, 0xfbb8bb46, 0xff79a6f1,
+    0xe13ef6f4, 0xe5ffeb43, 0xe8bccd9a, 0xec7dd02d,
+    0x34867077, 0x30476dc0, 0x3d044b19, 0x39c556ae,
+    0x278206ab, 0x23431b1c, 0x2e003dc5, 0x2ac12072,
+    0x128e9dcf, 0x164f8078, 0x1b0ca6a1, 0x1fcdbb16,
+    0x018aeb13, 0x054bf6a4, 0x0808d07d, 0x0cc9cdca,
+    0x7897ab07, 0x7c56b6b0, 0x71159069, 0x75d48dde,
+    0x6b93dddb, 0x6f52c06c, 0x6211e6b5, 0x66d0fb02,
+    0x5e9f46bf, 0x5a5e5b08, 0x571d7dd1, 0x53dc6066,
+    0x4d9b3063, 0x495a2dd4, 0x44190b0d, 0x40d816ba,
+    0xaca5c697, 0xa864db20, 0xa527fdf9, 0xa1e6e04e,
+    0xbfa1b04b, 0xbb60adfc, 0xb6238b25, 0xb2e29692,
+    0x8aad2b2f, 0x8e6c3698, 0x832f1041, 0x87ee0df6,
+    0x99a95df3, 0x9d684044, 0x902b669d, 0x94ea7b2a,
+    0xe0b41de7, 0xe4750050, 0xe9362689, 0xedf73b3e,
+    0xf3b06b3b, 0xf771768c, 0xfa325055, 0xfef34de2,
+    0xc6bcf05f, 0xc27dede8, 0xcf3ecb31, 0xcbffd686,
+    0xd5b88683, 0xd1799b34, 0xdc3abded, 0xd8fba05a,
+    0x690ce0ee, 0x6dcdfd59, 0x608edb80, 0x644fc637,
+    0x7a089632, 0x7ec98b85, 0x738aad5c, 0x774bb0eb,
+    0x4f040d56, 0x4bc510e1, 0x46863638, 0x42472b8f,
+    0x5c007b8a, 0x58c1663d, 0x558240e4, 0x51435d53,
+    0x251d3b9e, 0x21dc2629, 0x2c9f00f0, 0x285e1d47,
+    0x36194d42, 0x32d850f5, 0x3f9b762c, 0x3b5a6b9b,
+    0x0315d626, 0x07d4cb91, 0x0a97ed48, 0x0e56f0ff,
+    0x1011a0fa, 0x14d0bd4d, 0x19939b94, 0x1d528623,
+    0xf12f560e, 0xf5ee4bb9, 0xf8ad6d60, 0xfc6c70d7,
+    0xe22b20d2, 0xe6ea3d65, 0xeba91bbc, 0xef68060b,
+    0xd727bbb6, 0xd3e6a601, 0xdea580d8, 0xda649d6f,
+    0xc423cd6a, 0xc0e2d0dd, 0xcda1f604, 0xc960ebb3,
+    0xbd3e8d7e, 0xb9ff90c9, 0xb4bcb610, 0xb07daba7,
+    0xae3afba2, 0xaafbe615, 0xa7b8c0cc, 0xa379dd7b,
+    0x9b3660c6, 0x9ff77d71, 0x92b45ba8, 0x9675461f,
+    0x8832161a, 0x8cf30bad, 0x81b02d74, 0x857130c3,
+    0x5d8a9099, 0x594b8d2e, 0x5408abf7, 0x50c9b640,
+    0x4e8ee645, 0x4a4ffbf2, 0x470cdd2b, 0x43cdc09c,
+    0x7b827d21, 0x7f436096, 0x7200464f, 0x76c15bf8,
+    0x68860bfd, 0x6c47164a, 0x61043093, 0x65c52d24,
+    0x119b4be9, 0x155a565e, 0x18197087, 0x1cd86d30,
+    0x029f3d35, 0x065e2082, 0x0b1d065b, 0x0fdc1bec,
+    0x3793a651, 0x3352bbe6, 0x3e119d3f, 0x3ad08088,
+    0x2497d08d, 0x2056cd3a, 0x2d15ebe3, 0x29d4f654,
+    0xc5a92679, 0xc1683bce, 0xcc2b1d17, 0xc8ea00a0,
+    0xd6ad50a5, 0xd26c4d12, 0xdf2f6bcb, 0xdbee767c,
+    0xe3a1cbc1, 0xe760d676, 0xea23f0af, 0xeee2ed18,
+    0xf0a5bd1d, 0xf464a0aa, 0xf9278673, 0xfde69bc4,
+    0x89b8fd09, 0x8d79e0be, 0x803ac667, 0x84fbdbd0,
+    0x9abc8bd5, 0x9e7d9662, 0x933eb0bb, 0x97ffad0c,
+    0xafb010b1, 0xab710d06, 0xa6322bdf, 0xa2f33668,
+    0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
+};
+
+/**
+ * @brief Reads from the file as playback traffic.
+ */
+static ssize_t ogg_file_read(struct fs_file_t *file, void *buf, size_t len)
+{
+#ifdef CONFIG_RPR_FLASH_QOS
+    return flash_qos_read(file, buf, len);
+#else
+    return fs_read(file, buf, len);
+#endif
+}
+
+/**
+ * @brief Adds bytes to an Ogg page CRC.
+ */
+static uint32_t ogg_crc_update(uint32_t crc, const uint8_t *p, size_t len)
+{
+    while (len--) {
+        crc = (crc << 8) ^ ogg_crc_table[(crc >> 24) ^ *p++];
+    }
+
+    return crc;
+}
+
+/**
+ * @brief Adds the buffered bytes of the current page to its CRC.
+ *
+ * The CRC field itself counts as zero.
+ *
+ * @param demux Demuxer state.
+ * @param upto  Page bytes that should be covered, at most the buffered ones.
+ */
+static void ogg_crc_advance(struct audio_ogg_demux *demux, uint32_t upto)
+{
+    static const uint8_t zero[OGG_CRC_LEN];
+    const uint8_t       *page = demux->buf + demux->head;
+
+    upto = MIN(upto, demux->tail - demux->head);
+
+    while (demux->crc_len < upto) {
+        const uint8_t *p   = page + demux->crc_len;
+        uint32_t       end = upto;
+
+        if (demux->crc_len < OGG_OFF_CRC) {
+            end = MIN(upto, OGG_OFF_CRC);
+        } else if (demux->crc_len < OGG_OFF_CRC + OGG_CRC_LEN) {
+            end = MIN(upto, OGG_OFF_CRC + OGG_CRC_LEN);
+            p   = zero;
+        }
+
+        demux->crc = ogg_crc_update(demux->crc, p, end - demux->crc_len);
+        demux->crc_len = end;
+    }
+}
+
+/**
+ * @brief Reads more of the file behind the buffered data.
+ *
+ * The unread bytes are moved to the buffer start only when the wanted
+ * bytes would not fit behind them, or when half of the buffer is used up.
+ *
+ * @param demux Demuxer state.
+ * @param need  Bytes wanted from the current page start.
+ *
+ * @return Number of bytes read, 0 at the end of the file, negative error
+ *         code otherwise.
+ */
+static int ogg_refill(struct audio_ogg_demux *demux, uint32_t need)
+{
+    if (demux->eof) {
+        return 0;
+    }
+
+    if (demux->head > 0 &&
+        (demux->head + need > demux->size || demux->head >= demux->size / 2)) {
+        uint32_t left = demux->tail - demux->head;
+
+        memmove(demux->buf, demux->buf + demux->head, left);
+        demux->stats.carried += left;
+        demux->head = 0;
+        demux->tail = left;
+    }
+
+    uint32_t cycles = k_cycle_get_32();
+    ssize_t  ret    = ogg_file_read(
+            demux->file, demux->buf + demux->tail, demux->size - demux->tail);
+
+    demux->stats.read_cycles += k_cycle_get_32() - cycles;
+    demux->stats.reads++;
+
+    if (ret < 0) {
+        return ret;
+    }
+    if (ret == 0) {
+        demux->eof = true;
+        return 0;
+    }
+
+    demux->tail += ret;
+    demux->stats.bytes += ret;
+
+    return ret;
+}
+
+/**
+ * @brief Makes sure some bytes of the current page are buffered.
+ *
+ * Bytes that arrive are added to the page CRC right away.
+ *
+ * @return 1 on success, 0 at the end of the file, negative error code
+ *         otherwise.
+ */
+static int ogg_ensure(struct audio_ogg_demux *demux, uint32_t need)
+{
+    if (need > demux->size) {
+        return -EMSGSIZE;
+    }
+
+    while (demux->tail - demux->head < need) {
+        int ret = ogg_refill(demux, need);
+        if (ret <= 0) {
+            return ret;
+        }
+
+        ogg_crc_advance(demux, need);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Looks for the next capture pattern after a bad page start.
+ */
+static void ogg_resync(struct audio_ogg_demux *demux)
+{
+    uint32_t pos = demux->head + 1;
+
+    demux->stats.resyncs++;
+
+    while (pos + OGG_CAPTURE_LEN <= demux->tail) {
+        const uint8_t *p = memchr(demux->buf + pos, 'O', demux->tail - pos);
+        if (!p) {
+            break;
+        }
+
+        pos = p - demux->buf;
+        if (pos + OGG_CAPTURE_LEN <= demux->tail &&
+            memcmp(p, OGG_CAPTURE, OGG_CAPTURE_LEN) == 0) {
+            demux->head = pos;
+            return;
+        }
+        pos++;
+    }
+
+    /* Keep a capture pattern that may be cut by the buffer end */
+    pos = demux->tail > OGG_CAPTURE_LEN - 1 ? demux->tail - (OGG_CAPTURE_LEN - 1) :
+                                              0;
+    demux->head = MAX(pos, demux->head + 1);
+}
+
+/**
+ * @brief Forgets a packet continued from a lost or unrelated page.
+ */
+static void ogg_drop_partial(struct audio_ogg_demux *demux)
+{
+    if (demux->continued) {
+        demux->stats.dropped++;
+    }
+
+    demux->continued   = false;
+    demux->dropping    = false;
+    demux->packet_fill = 0;
+}
+
+/**
+ * @brief Buffers and checks the next page of the logical stream.
+ *
+ * @return 1 when a page is ready, 0 at the end of the file, negative error
+ *         code otherwise.
+ */
+static int ogg_page_start(struct audio_ogg_demux *demux)
+{
+    while (true) {
+        demux->crc     = 0;
+        demux->crc_len = 0;
+
+        int ret = ogg_ensure(demux, AUDIO_OGG_PAGE_HEADER_SIZE);
+        if (ret <= 0) {
+            return ret;
+        }
+
+        const uint8_t *page = demux->buf + demux->head;
+
+        if (memcmp(page, OGG_CAPTURE, OGG_CAPTURE_LEN) != 0 ||
+            page[OGG_OFF_VERSION] != OGG_VERSION) {
+            ogg_resync(demux);
+            continue;
+        }
+
+        uint32_t segments = page[OGG_OFF_SEGMENTS];
+        uint32_t len      = AUDIO_OGG_PAGE_HEADER_SIZE + segments;
+
+        ret = ogg_ensure(demux, len);
+        if (ret <= 0) {
+            return ret;
+        }
+
+        page = demux->buf + demux->head;
+        for (uint32_t i = 0; i < segments; i++) {
+            len += page[AUDIO_OGG_PAGE_HEADER_SIZE + i];
+        }
+
+        if (len > demux->size) {
+            LOG_ERR("Ogg page of %u bytes exceeds the %zu byte buffer",
+                    len,
+                    demux->size);
+            return -EMSGSIZE;
+        }
+
+        ogg_crc_advance(demux, len);
+        ret = ogg_ensure(demux, len);
+        if (ret <= 0) {
+            return ret;
+        }
+
+        page = demux->buf + demux->head;
+        if (demux->crc != sys_get_le32(page + OGG_OFF_CRC)) {
+            demux->stats.crc_errors++;
+            ogg_resync(demux);
+            continue;
+        }
+
+        uint32_t serial   = sys_get_le32(page + OGG_OFF_SERIAL);
+        uint32_t sequence = sys_get_le32(page + OGG_OFF_SEQUENCE);
+
+        if (!demux->serial_set) {
+            demux->serial     = serial;
+            demux->serial_set = true;
+        } else if (serial != demux->serial) {
+            demux->stats.skipped++;
+            demux->head += len;
+            continue;
+        } else if (sequence != demux->sequence) {
+            /* A lost page leaves a hole in the packet numbers */
+            ogg_drop_partial(demux);
+            demux->packetno++;
+        }
+
+        demux->sequence   = sequence + 1;
+        demux->flags      = page[OGG_OFF_FLAGS];
+        demux->granulepos = (int64_t)sys_get_le64(page + OGG_OFF_GRANULE);
+        demux->segments   = segments;
+        demux->seg        = 0;
+        demux->body       = demux->head + AUDIO_OGG_PAGE_HEADER_SIZE + segments;
+        demux->page_len   = len;
+        demux->in_page    = true;
+        demux->stats.pages++;
+
+        if (!(demux->flags & OGG_FLAG_CONTINUED)) {
+            ogg_drop_partial(demux);
+        } else if (!demux->continued) {
+            /* The start of this packet is lost, skip its tail */
+            const uint8_t *lacing = page + AUDIO_OGG_PAGE_HEADER_SIZE;
+
+            while (demux->seg < demux->segments) {
+                uint8_t val = lacing[demux->seg++];
+
+                demux->body += val;
+                if (val < OGG_LACING_MAX) {
+                    break;
+                }
+            }
+        }
+
+        return 1;
+    }
+}
+
+/**
+ * @brief Appends a fragment of a packet continued across pages.
+ */
+static void
+ogg_append(struct audio_ogg_demux *demux, const uint8_t *data, uint32_t len)
+{
+    if (demux->dropping) {
+        return;
+    }
+
+    if (demux->packet_fill + len > demux->packet_size) {
+        LOG_WRN("Continued Ogg packet exceeds %zu bytes", demux->packet_size);
+        demux->dropping    = true;
+        demux->packet_fill = 0;
+        return;
+    }
+
+    memcpy(demux->packet_buf + demux->packet_fill, data, len);
+    demux->packet_fill += len;
+}
+
+/**
+ * @brief Returns the next packet of the current page.
+ *
+ * @return true if a packet was returned, false when the page is done.
+ */
+static bool ogg_page_packet(struct audio_ogg_demux  *demux,
+                            struct audio_ogg_packet *packet)
+{
+    const uint8_t *lacing = demux->buf + demux->head + AUDIO_OGG_PAGE_HEADER_SIZE;
+
+    while (demux->seg < demux->segments) {
+        const uint8_t *data = demux->buf + demux->body;
+        uint32_t       len  = 0;
+        uint8_t        val;
+
+        do {
+            val = lacing[demux->seg++];
+            len += val;
+        } while (val == OGG_LACING_MAX && demux->seg < demux->segments);
+
+        demux->body += len;
+
+        if (val == OGG_LACING_MAX) {
+            /* Continues on the next page */
+            ogg_append(demux, data, len);
+            demux->continued = true;
+            break;
+        }
+
+        if (demux->continued) {
+            ogg_append(demux, data, len);
+            demux->continued = false;
+
+            if (demux->dropping) {
+                demux->dropping = false;
+                demux->stats.dropped++;
+                demux->packetno++;
+                continue;
+            }
+
+            data = demux->packet_buf;
+            len  = demux->packet_fill;
+            demux->stats.assembled += len;
+            demux->packet_fill = 0;
+        }
+
+        bool last = demux->seg == demux->segments;
+
+        packet->data       = data;
+        packet->len        = len;
+        packet->granulepos = last ? demux->granulepos : -1;
+        packet->eos        = last && (demux->flags & OGG_FLAG_EOS);
+        packet->packetno   = demux->packetno++;
+        demux->stats.packets++;
+
+        return true;
+    }
+
+    demux->head += demux->page_len;
+    demux->in_page = false;
+
+    return false;
+}
+
+int audio_ogg_init(struct audio_ogg_demux *demux,
+                   struct fs_file_t       *file,
+                   uint8_t                *buf,
+                   size_t                  size,
+                   uint8_t                *packet_buf,
+                   size_t                  packet_size)
+{
+    if (!demux || !file || !buf || !packet_buf ||
+        size < AUDIO_OGG_PAGE_HEADER_SIZE + OGG_LACING_MAX) {
+        return -EINVAL;
+    }
+
+    memset(demux, 0, sizeof(*demux));
+    demux->file        = file;
+    demux->buf         = buf;
+    demux->size        = size;
+    demux->packet_buf  = packet_buf;
+    demux->packet_size = packet_size;
+
+    return 0;
+}
+
+int audio_ogg_next(struct audio_ogg_demux *demux, struct audio_ogg_packet *packet)
+{
+    if (!demux || !packet) {
+        return -EINVAL;
+    }
+
+    while (true) {
+        if (!demux->in_page) {
+            int ret = ogg_page_start(demux);
+            if (ret <= 0) {
+                return ret;
+            }
+        }
+
+        if (ogg_page_packet(demux, packet)) {
+            return 1;
+        }
+    }
+}
+
+int audio_ogg_tell(const struct audio_ogg_demux *demux,
+                   struct audio_ogg_position    *pos)
+{
+    if (!demux || !pos) {
+        return -EINVAL;
+    }
+
+    uint32_t next = demux->head;
+
+    if (demux->in_page) {
+        if (demux->seg < demux->segments) {
+            return -EAGAIN;
+        }
+        next += demux->page_len;
+    }
+
+    if (demux->continued) {
+        return -EAGAIN;
+    }
+
+    /* The buffered bytes end at the file offset read up to */
+    pos->offset   = demux->start + demux->stats.bytes - (demux->tail - next);
+    pos->serial   = demux->serial;
+    pos->sequence = demux->sequence;
+    pos->packetno = demux->packetno;
+
+    return 0;
+}
+
+int audio_ogg_resume(struct audio_ogg_demux          *demux,
+                     const struct audio_ogg_position *pos)
+{
+    if (!demux || !pos) {
+        return -EINVAL;
+    }
+
+    int ret = fs_seek(demux->file, pos->offset, FS_SEEK_SET);
+    if (ret < 0) {
+        return ret;
+    }
+
+    demux->start      = pos->offset;
+    demux->serial     = pos->serial;
+    demux->serial_set = true;
+    demux->sequence   = pos->sequence;
+    demux->packetno   = pos->packetno;
+
+    return 0;
+}
+
+/* libogg side of the comparison */
+struct ogg_reference {
+    struct fs_file_t file;
+    ogg_sync_state   oy;
+    ogg_stream_state os;
+    bool             stream_init;
+};
+
+/**
+ * @brief Gets the next packet from libogg, holes skipped.
+ *
+ * @return 1 if a packet was returned, 0 at the end of the file, negative
+ *         error code otherwise.
+ */
+static int ogg_reference_next(struct ogg_reference *ref, ogg_packet *op)
+{
+    ogg_page og;
+
+    while (true) {
+        if (ref->stream_init) {
+            int ret = ogg_stream_packetout(&ref->os, op);
+            if (ret == 1) {
+                return 1;
+            }
+            if (ret < 0) {
+                continue;
+            }
+        }
+
+        if (ogg_sync_pageout(&ref->oy, &og) == 1) {
+            if (!ref->stream_init) {
+                if (ogg_stream_init(&ref->os, ogg_page_serialno(&og)) != 0) {
+                    return -ENOMEM;
+                }
+                ref->stream_init = true;
+            }
+            ogg_stream_pagein(&ref->os, &og);
+            continue;
+        }
+
+        char *buffer = ogg_sync_buffer(&ref->oy, OGG_VERIFY_CHUNK);
+        if (!buffer) {
+            return -ENOMEM;
+        }
+
+        ssize_t len = fs_read(&ref->file, buffer, OGG_VERIFY_CHUNK);
+        if (len <= 0) {
+            return len;
+        }
+
+        ogg_sync_wrote(&ref->oy, len);
+    }
+}
+
+int audio_ogg_verify(const char *path, struct audio_ogg_stats *stats)
+{
+    if (!path) {
+        return -EINVAL;
+    }
+
+    struct ogg_reference   ref = { 0 };
+    struct audio_ogg_demux demux;
+    struct fs_file_t       file;
+    uint32_t               count = 0;
+    int                    ret;
+
+    uint8_t *buf        = malloc(CONFIG_RPR_AUDIO_OGG_BUFFER_SIZE);
+    uint8_t *packet_buf = malloc(CONFIG_RPR_AUDIO_OGG_PACKET_SIZE);
+
+    fs_file_t_init(&file);
+    fs_file_t_init(&ref.file);
+    ogg_sync_init(&ref.oy);
+
+    if (!buf || !packet_buf) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    ret = fs_open(&file, path, FS_O_READ);
+    if (ret == 0) {
+        ret = fs_open(&ref.file, path, FS_O_READ);
+    }
+    if (ret < 0) {
+        goto out;
+    }
+
+    audio_ogg_init(&demux,
+                   &file,
+                   buf,
+                   CONFIG_RPR_AUDIO_OGG_BUFFER_SIZE,
+                   packet_buf,
+                   CONFIG_RPR_AUDIO_OGG_PACKET_SIZE);
+
+    while (true) {
+        struct audio_ogg_packet packet;
+        ogg_packet              op;
+
+        int ours   = audio_ogg_next(&demux, &packet);
+        int theirs = ogg_reference_next(&ref, &op);
+
+        if (ours < 0 || theirs < 0) {
+            ret = ours < 0 ? ours : theirs;
+            break;
+        }
+
+        if (ours != theirs) {
+            LOG_ERR("%s: packet count differs after %u packets", path, count);
+            ret = -EBADMSG;
+            break;
+        }
+
+        if (ours == 0) {
+            ret = count;
+            break;
+        }
+
+        if (packet.len != op.bytes ||
+            memcmp(packet.data, op.packet, packet.len) != 0 ||
+            packet.granulepos != op.granulepos ||
+            packet.packetno != op.packetno || packet.eos != !!op.e_o_s) {
+            LOG_ERR("%s: packet %u differs", path, count);
+            ret = -EBADMSG;
+            break;
+        }
+
+        count++;
+    }
+
+    if (stats) {
+        *stats = demux.stats;
+    }
+
+out:
+    if (ref.stream_init) {
+        ogg_stream_clear(&ref.os);
+    }
+    ogg_sync_clear(&ref.oy);
+    fs_close(&file);
+    fs_close(&ref.file);
+    free(buf);
+    free(packet_buf);
+
+    return ret;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file audio_ogg.h
+ * @brief Zero-allocation Ogg demuxer over a caller-owned buffer.
+ *
+ * Replaces libogg in the playback path. The file is read into one fixed
+ * buffer, every page is CRC checked while its bytes arrive and packets are
+ * returned as views into that buffer. Only packets continued across a page
+ * boundary are assembled in a separate, also caller-owned, packet buffer.
+ * Pages of other logical streams are skipped.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_OGG_H_
+#define AUDIO_OGG_H_
+
+#include <zephyr/fs/fs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define AUDIO_OGG_PAGE_HEADER_SIZE 27
+
+struct audio_ogg_packet {
+    const uint8_t *data;
+    size_t         len;
+    int64_t        granulepos; /* -1 unless the packet ends its page */
+    uint32_t       packetno;   /* Counted from 0, lost packets included */
+    bool           eos;
+};
+
+/* Page boundary a demuxer can continue from */
+struct audio_ogg_position {
+    uint32_t offset;   /* File offset of the next page */
+    uint32_t serial;
+    uint32_t sequence; /* Number of the next page */
+    uint32_t packetno; /* Number of the next packet */
+};
+
+struct audio_ogg_stats {
+    uint32_t bytes;       /* File bytes read */
+    uint32_t reads;
+    uint32_t read_cycles; /* Time spent in file reads */
+    uint32_t pages;
+    uint32_t packets;
+    uint32_t carried;     /* Bytes moved to the buffer start */
+    uint32_t assembled;   /* Bytes of packets continued across pages */
+    uint32_t crc_errors;
+    uint32_t resyncs;     /* Capture pattern searches */
+    uint32_t dropped;     /* Continued packets too large or cut short */
+    uint32_t skipped;     /* Pages of other logical streams */
+};
+
+struct audio_ogg_demux {
+    struct fs_file_t      *file;
+    uint32_t               start;     /* File offset reading started at */
+    uint8_t               *buf;
+    size_t                 size;
+    uint32_t               head;      /* Start of the current page */
+    uint32_t               tail;      /* End of the buffered data */
+    uint32_t               crc_len;   /* Page bytes already in the CRC */
+    uint32_t               crc;
+    uint32_t               serial;
+    uint32_t               sequence;  /* Expected next page number */
+    bool                   serial_set;
+    bool                   in_page;   /* Page checked, packets pending */
+    bool                   eof;
+    /* Current page */
+    uint8_t                flags;
+    uint8_t                segments;
+    uint8_t                seg;       /* Next lacing value */
+    uint32_t               body;      /* Next packet byte in the buffer */
+    uint32_t               page_len;
+    int64_t                granulepos;
+    /* Packet continued across pages */
+    uint8_t               *packet_buf;
+    size_t                 packet_size;
+    uint32_t               packet_fill;
+    bool                   continued;
+    bool                   dropping;
+    uint32_t               packetno;
+    struct audio_ogg_stats stats;
+};
+
+/**
+ * @brief Prepares a demuxer for a file.
+ *
+ * @param demux       Demuxer state.
+ * @param file        File opened for reading at the stream start.
+ * @param buf         Read buffer, must hold the largest page of the file.
+ * @param size        Read buffer size.
+ * @param packet_buf  Buffer for packets continued across pages.
+ * @param packet_size Packet buffer size, larger continued packets are
+ *                    dropped.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_ogg_init(struct audio_ogg_demux *demux,
+                   struct fs_file_t       *file,
+                   uint8_t                *buf,
+                   size_t                  size,
+                   uint8_t                *packet_buf,
+                   size_t                  packet_size);
+
+/**
+ * @brief Gets the next packet of the first logical stream.
+ *
+ * The packet data stays valid until the next call.
+ *
+ * @param demux  Demuxer prepared with audio_ogg_init().
+ * @param packet Pointer to store the packet view.
+ *
+ * @return 1 if a packet was returned, 0 at the end of the file, negative
+ *         error code otherwise. -EMSGSIZE means a page does not fit the
+ *         read buffer.
+ */
+int audio_ogg_next(struct audio_ogg_demux *demux, struct audio_ogg_packet *packet);
+
+/**
+ * @brief Gets the position behind the packet returned last.
+ *
+ * Only page boundaries are positions: this succeeds right after the last
+ * packet of a page was returned, when no packet continues on the next page.
+ *
+ * @param demux Demuxer prepared with audio_ogg_init().
+ * @param pos   Pointer to store the position.
+ *
+ * @return 0 on success, -EAGAIN if packets of the page are pending.
+ */
+int audio_ogg_tell(const struct audio_ogg_demux *demux,
+                   struct audio_ogg_position    *pos);
+
+/**
+ * @brief Continues a stream from a position taken with audio_ogg_tell().
+ *
+ * Call right after audio_ogg_init(). Packets are numbered on from the
+ * position, as if the stream had been demuxed from its start.
+ *
+ * @param demux Demuxer prepared with audio_ogg_init().
+ * @param pos   Position to continue from.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_ogg_resume(struct audio_ogg_demux          *demux,
+                     const struct audio_ogg_position *pos);
+
+/**
+ * @brief Checks a file against libogg.
+ *
+ * Demuxes the file with both and compares every packet: data, granule
+ * position, packet number and end of stream flag.
+ *
+ * @param path  Ogg file.
+ * @param stats Pointer to store the demuxer statistics, may be NULL.
+ *
+ * @return Number of packets compared, -EBADMSG on the first difference,
+ *         other negative error code otherwise.
+ */
+int audio_ogg_verify(const char *path, struct audio_ogg_stats *stats);
+
+#endif /* AUDIO_OGG_H_ */
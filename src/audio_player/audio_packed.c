@@ -0,0 +1,914 @@
+/**
+ * @file audio_packed.c
+ * @brief Pre-packetized Opus container for on-device playback.
+ *
+ * The reader fetches the file in aligned blocks of
+ * CONFIG_RPR_AUDIO_PACKED_READ_SIZE bytes and returns each packet as a
+ * pointer into its buffer. Only the part of a record that straddles a
+ * block boundary is moved to the start of the buffer before the next
+ * block is read, so nothing is copied or allocated per packet.
+ *
+ * The converter runs once per file at ingest and reads the Ogg file with
+ * libogg.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ogg/ogg.h"
+#include "opus.h"
+#include "opus_header.h"
+#include "audio_ogg.h"
+#include "audio_packed.h"
+
+#ifdef CONFIG_RPR_FLASH_QOS
+#include "flash_qos.h"
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_PACKED_INGEST
+#include "http_module.h"
+#endif
+
+LOG_MODULE_REGISTER(audio_packed, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
+
+#define PACKED_MAGIC          "RPAK"
+#define PACKED_MAGIC_LEN      4
+#define PACKED_VERSION        1
+#define PACKED_LEN_SIZE       2
+#define PACKED_INDEX_ENTRY    8
+#define PACKED_INDEX_MAX      CONFIG_RPR_AUDIO_PACKED_INDEX_MAX
+#define PACKED_INDEX_INTERVAL 50 /* 1 s of 20 ms packets to start with */
+#define PACKED_TMP_SUFFIX     "~"
+
+#define OGG_MAGIC        "OggS"
+#define OGG_CHUNK_SIZE   2048
+#define OPUS_RATE        48000
+#define OPUS_HEADER_PKTS 2 /* OpusHead and OpusTags */
+
+#define PACKED_PATH_MAX_LEN \
+    (CONFIG_RPR_FOLDER_PATH_MAX_LEN + CONFIG_RPR_FILENAME_MAX_LEN)
+
+BUILD_ASSERT(AUDIO_PACKED_READ_SIZE >= AUDIO_PACKED_HEADER_SIZE,
+             "Read size must hold the container header");
+
+/* State of one Ogg to container conversion */
+struct packed_conv {
+    struct audio_packed_header header;
+    struct fs_file_t           file;
+    uint8_t                   *buf;     /* Output block being filled */
+    uint32_t                   fill;
+    uint32_t                   written; /* File offset of buf[0] */
+    uint32_t                  *index;   /* Offset and sample pairs */
+    uint32_t                   headers; /* Opus header packets seen */
+};
+
+static struct audio_packed_reader bench_reader;
+
+/**
+ * @brief Reads from the file as playback traffic.
+ */
+static ssize_t packed_file_read(struct fs_file_t *file, void *buf, size_t len)
+{
+#ifdef CONFIG_RPR_FLASH_QOS
+    return flash_qos_read(file, buf, len);
+#else
+    return fs_read(file, buf, len);
+#endif
+}
+
+/**
+ * @brief Writes to the file as background traffic.
+ */
+static ssize_t
+packed_file_write(struct fs_file_t *file, const void *buf, size_t len)
+{
+#ifdef CONFIG_RPR_FLASH_QOS
+    return flash_qos_write(file, buf, len);
+#else
+    return fs_write(file, buf, len);
+#endif
+}
+
+/**
+ * @brief Serializes the container header.
+ *
+ * @param header Header to write.
+ * @param p      Output of AUDIO_PACKED_HEADER_SIZE bytes.
+ */
+static void packed_header_put(const struct audio_packed_header *header,
+                              uint8_t                          *p)
+{
+    memset(p, 0, AUDIO_PACKED_HEADER_SIZE);
+    memcpy(p, PACKED_MAGIC, PACKED_MAGIC_LEN);
+    p[4] = header->version;
+    p[5] = header->channels;
+    sys_put_le16(header->pre_skip, p + 6);
+    sys_put_le32(header->packet_count, p + 8);
+    sys_put_le32(header->input_rate, p + 12);
+    sys_put_le32(header->total_samples, p + 16);
+    sys_put_le32(header->index_offset, p + 20);
+    sys_put_le16(header->index_count, p + 24);
+    sys_put_le16(header->index_interval, p + 26);
+}
+
+/**
+ * @brief Parses and checks the container header.
+ *
+ * @param header Pointer to store the header.
+ * @param p      Input of AUDIO_PACKED_HEADER_SIZE bytes.
+ *
+ * @return 0 on success, -ENOMSG if the magic does not match, other
+ *         negative error code if the header is not usable.
+ */
+static int packed_header_get(struct audio_packed_header *header,
+                             const uint8_t              *p)
+{
+    if (memcmp(p, PACKED_MAGIC, PACKED_MAGIC_LEN) != 0) {
+        return -ENOMSG;
+    }
+
+    header->version        = p[4];
+    header->channels       = p[5];
+    header->pre_skip       = sys_get_le16(p + 6);
+    header->packet_count   = sys_get_le32(p + 8);
+    header->input_rate     = sys_get_le32(p + 12);
+    header->total_samples  = sys_get_le32(p + 16);
+    header->index_offset   = sys_get_le32(p + 20);
+    header->index_count    = sys_get_le16(p + 24);
+    header->index_interval = sys_get_le16(p + 26);
+
+    if (header->version != PACKED_VERSION) {
+        LOG_ERR("Unsupported container version %u", header->version);
+        return -ENOTSUP;
+    }
+
+    if (header->index_offset < AUDIO_PACKED_HEADER_SIZE ||
+        (header->index_count > 0 && header->index_interval == 0)) {
+        LOG_ERR("Damaged container header");
+        return -EBADMSG;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Reads the next block behind the buffered data.
+ *
+ * The unread tail is moved to the start of the buffer first. Blocks are
+ * read at multiples of the read size, so LittleFS can serve them straight
+ * from flash instead of through its cache.
+ *
+ * @return Number of packet bytes added, 0 at the end of the packets,
+ *         negative error code otherwise.
+ */
+static int packed_refill(struct audio_packed_reader *reader)
+{
+    uint32_t left = reader->tail - reader->head;
+    uint32_t end  = reader->header.index_offset;
+
+    if (left > 0 && reader->head > 0) {
+        memmove(reader->buf, reader->buf + reader->head, left);
+        reader->carried += left;
+    }
+    reader->head = 0;
+    reader->tail = left;
+
+    if (reader->file_pos >= end) {
+        return 0;
+    }
+
+    uint32_t cycles = k_cycle_get_32();
+    ssize_t  ret    = packed_file_read(
+            reader->file, reader->buf + left, AUDIO_PACKED_READ_SIZE);
+
+    reader->read_cycles += k_cycle_get_32() - cycles;
+    reader->reads++;
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    uint32_t got = MIN((uint32_t)ret, end - reader->file_pos);
+
+    reader->file_pos += ret;
+    reader->tail += got;
+
+    return got;
+}
+
+int audio_packed_open(struct audio_packed_reader *reader,
+                      struct fs_file_t           *file)
+{
+    if (!reader || !file) {
+        return -EINVAL;
+    }
+
+    reader->file        = file;
+    reader->file_pos    = 0;
+    reader->head        = 0;
+    reader->tail        = 0;
+    reader->packet      = 0;
+    reader->reads       = 1;
+    reader->carried     = 0;
+    reader->read_cycles = 0;
+
+    uint32_t cycles = k_cycle_get_32();
+    ssize_t  ret    = packed_file_read(file, reader->buf, AUDIO_PACKED_READ_SIZE);
+
+    reader->read_cycles = k_cycle_get_32() - cycles;
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    int err = ret < AUDIO_PACKED_HEADER_SIZE ?
+                      -ENOMSG :
+                      packed_header_get(&reader->header, reader->buf);
+    if (err == -ENOMSG) {
+        fs_seek(file, 0, FS_SEEK_SET);
+        return -ENOMSG;
+    }
+    if (err < 0) {
+        return err;
+    }
+
+    reader->file_pos = ret;
+    reader->head     = AUDIO_PACKED_HEADER_SIZE;
+    reader->tail = MAX(MIN((uint32_t)ret, reader->header.index_offset),
+                       reader->head);
+
+    return 0;
+}
+
+int audio_packed_next(struct audio_packed_reader *reader,
+                      const uint8_t             **packet,
+                      size_t                     *len)
+{
+    if (!reader || !packet || !len) {
+        return -EINVAL;
+    }
+
+    if (reader->packet >= reader->header.packet_count) {
+        return 0;
+    }
+
+    while (true) {
+        uint32_t avail = reader->tail - reader->head;
+
+        if (avail >= PACKED_LEN_SIZE) {
+            uint16_t size = sys_get_le16(reader->buf + reader->head);
+
+            if (size == 0 || size > AUDIO_PACKED_MAX_PACKET) {
+                LOG_ERR("Bad packet length %u at packet %u",
+                        size,
+                        reader->packet);
+                return -EBADMSG;
+            }
+
+            if (avail >= PACKED_LEN_SIZE + size) {
+                *packet = reader->buf + reader->head + PACKED_LEN_SIZE;
+                *len    = size;
+                reader->head += PACKED_LEN_SIZE + size;
+                reader->packet++;
+                return 1;
+            }
+        }
+
+        int ret = packed_refill(reader);
+        if (ret < 0) {
+            return ret;
+        }
+        if (ret == 0) {
+            LOG_ERR("Container truncated at packet %u", reader->packet);
+            return -EBADMSG;
+        }
+    }
+}
+
+/**
+ * @brief Reads one seek index entry.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int packed_index_entry(struct audio_packed_reader *reader,
+                              uint32_t                    idx,
+                              uint32_t                   *offset,
+                              uint32_t                   *sample)
+{
+    uint8_t entry[PACKED_INDEX_ENTRY];
+
+    int ret = fs_seek(reader->file,
+                      reader->header.index_offset + idx * PACKED_INDEX_ENTRY,
+                      FS_SEEK_SET);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (packed_file_read(reader->file, entry, sizeof(entry)) !=
+        sizeof(entry)) {
+        return -EBADMSG;
+    }
+
+    *offset = sys_get_le32(entry);
+    *sample = sys_get_le32(entry + 4);
+
+    return 0;
+}
+
+int64_t audio_packed_seek(struct audio_packed_reader *reader, uint32_t sample)
+{
+    if (!reader) {
+        return -EINVAL;
+    }
+
+    const struct audio_packed_header *header = &reader->header;
+
+    if (header->index_count == 0) {
+        return -ENOENT;
+    }
+
+    int32_t  lo          = 0;
+    int32_t  hi          = header->index_count - 1;
+    uint32_t best        = 0;
+    uint32_t best_offset = AUDIO_PACKED_HEADER_SIZE;
+    uint32_t best_sample = 0;
+
+    while (lo <= hi) {
+        int32_t  mid = (lo + hi) / 2;
+        uint32_t offset;
+        uint32_t start;
+
+        int ret = packed_index_entry(reader, mid, &offset, &start);
+        if (ret < 0) {
+            return ret;
+        }
+
+        if (start <= sample) {
+            best        = mid;
+            best_offset = offset;
+            best_sample = start;
+            lo          = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    int ret = audio_packed_resume(
+            reader, best_offset, best * header->index_interval);
+    if (ret < 0) {
+        return ret;
+    }
+
+    return best_sample;
+}
+
+int audio_packed_resume(struct audio_packed_reader *reader,
+                        uint32_t                    offset,
+                        uint32_t                    packet)
+{
+    if (!reader) {
+        return -EINVAL;
+    }
+
+    if (offset < AUDIO_PACKED_HEADER_SIZE ||
+        offset >= reader->header.index_offset ||
+        packet >= reader->header.packet_count) {
+        return -EBADMSG;
+    }
+
+    uint32_t aligned = ROUND_DOWN(offset, AUDIO_PACKED_READ_SIZE);
+
+    int ret = fs_seek(reader->file, aligned, FS_SEEK_SET);
+    if (ret < 0) {
+        return ret;
+    }
+
+    reader->file_pos = aligned;
+    reader->head     = 0;
+    reader->tail     = 0;
+
+    ret = packed_refill(reader);
+    if (ret < 0) {
+        return ret;
+    }
+
+    reader->head = offset - aligned;
+    if (reader->head > reader->tail) {
+        return -EBADMSG;
+    }
+
+    reader->packet = packet;
+
+    return 0;
+}
+
+/**
+ * @brief Writes the filled output block to the container file.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int packed_conv_flush(struct packed_conv *conv)
+{
+    if (conv->fill == 0) {
+        return 0;
+    }
+
+    ssize_t ret = packed_file_write(&conv->file, conv->buf, conv->fill);
+    if (ret < 0) {
+        return ret;
+    }
+    if ((uint32_t)ret != conv->fill) {
+        return -ENOSPC;
+    }
+
+    conv->written += conv->fill;
+    conv->fill = 0;
+
+    return 0;
+}
+
+/**
+ * @brief Appends bytes to the container, in whole blocks.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int packed_conv_put(struct packed_conv *conv, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    while (len > 0) {
+        size_t n = MIN(len, AUDIO_PACKED_READ_SIZE - conv->fill);
+
+        memcpy(conv->buf + conv->fill, p, n);
+        conv->fill += n;
+        p += n;
+        len -= n;
+
+        if (conv->fill == AUDIO_PACKED_READ_SIZE) {
+            int ret = packed_conv_flush(conv);
+            if (ret < 0) {
+                return ret;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Adds a seek index entry for the packet about to be written.
+ *
+ * When the index is full, every other entry is dropped and the interval
+ * is doubled, so long files still fit.
+ */
+static void packed_conv_index(struct packed_conv *conv)
+{
+    struct audio_packed_header *header = &conv->header;
+
+    if (header->packet_count % header->index_interval != 0) {
+        return;
+    }
+
+    if (header->index_count == PACKED_INDEX_MAX) {
+        for (uint32_t i = 0; i < PACKED_INDEX_MAX / 2; i++) {
+            conv->index[2 * i]     = conv->index[4 * i];
+            conv->index[2 * i + 1] = conv->index[4 * i + 1];
+        }
+        header->index_count = PACKED_INDEX_MAX / 2;
+        header->index_interval *= 2;
+
+        if (header->packet_count % header->index_interval != 0) {
+            return;
+        }
+    }
+
+    conv->index[2 * header->index_count]     = conv->written + conv->fill;
+    conv->index[2 * header->index_count + 1] = header->total_samples;
+    header->index_count++;
+}
+
+/**
+ * @brief Converts one Ogg packet: parses the Opus headers, stores audio.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int packed_conv_packet(struct packed_conv *conv, const ogg_packet *op)
+{
+    struct audio_packed_header *header = &conv->header;
+
+    if (conv->headers == 0) {
+        OpusHeader opus;
+
+        if (opus_header_parse(op->packet, op->bytes, &opus) == 0) {
+            LOG_ERR("Not an Ogg Opus stream");
+            return -EBADMSG;
+        }
+
+        header->channels   = opus.channels;
+        header->pre_skip   = opus.preskip;
+        header->input_rate = opus.input_sample_rate;
+        conv->headers++;
+        return 0;
+    }
+
+    if (conv->headers < OPUS_HEADER_PKTS) {
+        conv->headers++;
+        return 0;
+    }
+
+    if (op->bytes <= 0 || op->bytes > AUDIO_PACKED_MAX_PACKET) {
+        LOG_ERR("Bad Opus packet size %ld", (long)op->bytes);
+        return -EBADMSG;
+    }
+
+    int samples = opus_packet_get_nb_samples(op->packet, op->bytes, OPUS_RATE);
+    if (samples <= 0) {
+        LOG_ERR("Bad Opus packet %u", header->packet_count);
+        return -EBADMSG;
+    }
+
+    packed_conv_index(conv);
+
+    uint8_t len[PACKED_LEN_SIZE];
+    sys_put_le16(op->bytes, len);
+
+    int ret = packed_conv_put(conv, len, sizeof(len));
+    if (ret == 0) {
+        ret = packed_conv_put(conv, op->packet, op->bytes);
+    }
+
+    header->packet_count++;
+    header->total_samples += samples;
+
+    return ret;
+}
+
+/**
+ * @brief Writes the seek index and the final header.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int packed_conv_finish(struct packed_conv *conv)
+{
+    struct audio_packed_header *header = &conv->header;
+    uint8_t                     raw[AUDIO_PACKED_HEADER_SIZE];
+
+    header->index_offset = conv->written + conv->fill;
+
+    for (uint32_t i = 0; i < header->index_count; i++) {
+        uint8_t entry[PACKED_INDEX_ENTRY];
+
+        sys_put_le32(conv->index[2 * i], entry);
+        sys_put_le32(conv->index[2 * i + 1], entry + 4);
+
+        int ret = packed_conv_put(conv, entry, sizeof(entry));
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    int ret = packed_conv_flush(conv);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = fs_seek(&conv->file, 0, FS_SEEK_SET);
+    if (ret < 0) {
+        return ret;
+    }
+
+    packed_header_put(header, raw);
+    if (packed_file_write(&conv->file, raw, sizeof(raw)) != sizeof(raw)) {
+        return -EIO;
+    }
+
+    return 0;
+}
+
+int audio_packed_convert(const char                 *src,
+                         const char                 *dst,
+                         struct audio_packed_header *header)
+{
+    if (!src || !dst) {
+        return -EINVAL;
+    }
+
+    struct packed_conv conv = {
+        .header = {
+            .version        = PACKED_VERSION,
+            .index_interval = PACKED_INDEX_INTERVAL,
+        },
+    };
+    struct fs_file_t   in;
+    ogg_sync_state     oy;
+    ogg_stream_state   os;
+    ogg_page           og;
+    ogg_packet         op;
+    bool               stream_init = false;
+    int                ret;
+
+    fs_file_t_init(&in);
+    fs_file_t_init(&conv.file);
+
+    ret = fs_open(&in, src, FS_O_READ);
+    if (ret < 0) {
+        LOG_ERR("Cannot open %s: %d", src, ret);
+        return ret;
+    }
+
+    fs_unlink(dst);
+    ret = fs_open(&conv.file, dst, FS_O_CREATE | FS_O_WRITE);
+    if (ret < 0) {
+        LOG_ERR("Cannot create %s: %d", dst, ret);
+        fs_close(&in);
+        return ret;
+    }
+
+    ogg_sync_init(&oy);
+
+    conv.buf   = malloc(AUDIO_PACKED_READ_SIZE);
+    conv.index = malloc(PACKED_INDEX_MAX * 2 * sizeof(uint32_t));
+    if (!conv.buf || !conv.index) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    /* Header placeholder, completed once the totals are known */
+    memset(conv.buf, 0, AUDIO_PACKED_HEADER_SIZE);
+    conv.fill = AUDIO_PACKED_HEADER_SIZE;
+
+    while (ret >= 0) {
+        char *buffer = ogg_sync_buffer(&oy, OGG_CHUNK_SIZE);
+        if (!buffer) {
+            ret = -ENOMEM;
+            break;
+        }
+
+        ssize_t read_len = fs_read(&in, buffer, OGG_CHUNK_SIZE);
+        if (read_len < 0) {
+            ret = read_len;
+            break;
+        }
+        if (read_len == 0) {
+            break;
+        }
+
+        ogg_sync_wrote(&oy, read_len);
+
+        while (ret >= 0 && ogg_sync_pageout(&oy, &og) == 1) {
+            if (!stream_init) {
+                if (ogg_stream_init(&os, ogg_page_serialno(&og)) != 0) {
+                    ret = -ENOMEM;
+                    break;
+                }
+                stream_init = true;
+            }
+
+            /* Pages of other logical streams are not converted */
+            if (ogg_stream_pagein(&os, &og) != 0) {
+                continue;
+            }
+
+            while (ret >= 0 && ogg_stream_packetout(&os, &op) == 1) {
+                ret = packed_conv_packet(&conv, &op);
+            }
+        }
+    }
+
+    if (ret >= 0 && conv.header.packet_count == 0) {
+        LOG_ERR("No Opus packets in %s", src);
+        ret = -EBADMSG;
+    }
+
+    if (ret >= 0) {
+        ret = packed_conv_finish(&conv);
+    }
+
+out:
+    if (stream_init) {
+        ogg_stream_clear(&os);
+    }
+    ogg_sync_clear(&oy);
+    free(conv.buf);
+    free(conv.index);
+    fs_close(&in);
+    fs_close(&conv.file);
+
+    if (ret < 0) {
+        LOG_ERR("Conversion of %s failed: %d", src, ret);
+        fs_unlink(dst);
+        return ret;
+    }
+
+    if (header) {
+        *header = conv.header;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Checks whether a file starts with an Ogg page.
+ *
+ * @return 1 if it does, 0 if not, negative error code otherwise.
+ */
+static int packed_is_ogg(const char *path)
+{
+    struct fs_file_t file;
+    char             magic[PACKED_MAGIC_LEN];
+
+    fs_file_t_init(&file);
+
+    int ret = fs_open(&file, path, FS_O_READ);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ssize_t len = fs_read(&file, magic, sizeof(magic));
+    fs_close(&file);
+
+    if (len < 0) {
+        return len;
+    }
+
+    return len == sizeof(magic) && memcmp(magic, OGG_MAGIC, sizeof(magic)) == 0;
+}
+
+int audio_packed_ingest(const char *path)
+{
+    if (!path) {
+        return -EINVAL;
+    }
+
+    int ret = packed_is_ogg(path);
+    if (ret <= 0) {
+        return ret;
+    }
+
+    char tmp[PACKED_PATH_MAX_LEN + sizeof(PACKED_TMP_SUFFIX)];
+    if (snprintf(tmp, sizeof(tmp), "%s" PACKED_TMP_SUFFIX, path) >=
+        sizeof(tmp)) {
+        return -ENAMETOOLONG;
+    }
+
+    struct audio_packed_header header;
+    int64_t                    start = k_uptime_get();
+
+    ret = audio_packed_convert(path, tmp, &header);
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* LittleFS replaces the original atomically */
+    ret = fs_rename(tmp, path);
+    if (ret < 0) {
+        LOG_ERR("Cannot replace %s: %d", path, ret);
+        fs_unlink(tmp);
+        return ret;
+    }
+
+    LOG_INF("Packed %s: %u packets, %u ms, %u index entries, in %lld ms",
+            path,
+            header.packet_count,
+            header.total_samples / (OPUS_RATE / MSEC_PER_SEC),
+            header.index_count,
+            k_uptime_get() - start);
+
+    return 1;
+}
+
+/**
+ * @brief Demuxes an Ogg file the way the Ogg player path does.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int packed_bench_ogg(struct fs_file_t          *file,
+                            struct audio_packed_bench *result,
+                            uint32_t                  *read_cycles)
+{
+    struct audio_ogg_demux  demux;
+    struct audio_ogg_packet packet;
+    int                     ret;
+
+    uint8_t *buf        = malloc(CONFIG_RPR_AUDIO_OGG_BUFFER_SIZE);
+    uint8_t *packet_buf = malloc(CONFIG_RPR_AUDIO_OGG_PACKET_SIZE);
+
+    if (!buf || !packet_buf) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    audio_ogg_init(&demux,
+                   file,
+                   buf,
+                   CONFIG_RPR_AUDIO_OGG_BUFFER_SIZE,
+                   packet_buf,
+                   CONFIG_RPR_AUDIO_OGG_PACKET_SIZE);
+
+    while ((ret = audio_ogg_next(&demux, &packet)) > 0) {
+    }
+
+    /* Every byte read is covered by a page CRC */
+    result->packets   = demux.stats.packets > OPUS_HEADER_PKTS ?
+                                demux.stats.packets - OPUS_HEADER_PKTS :
+                                0;
+    result->bytes     = demux.stats.bytes;
+    result->reads     = demux.stats.reads;
+    result->copied    = demux.stats.carried + demux.stats.assembled;
+    result->crc_bytes = demux.stats.bytes;
+    *read_cycles      = demux.stats.read_cycles;
+
+out:
+    free(buf);
+    free(packet_buf);
+
+    return ret;
+}
+
+int audio_packed_bench(const char *path, struct audio_packed_bench *result)
+{
+    if (!path || !result) {
+        return -EINVAL;
+    }
+
+    struct fs_file_t file;
+    uint32_t         read_cycles = 0;
+
+    memset(result, 0, sizeof(*result));
+    fs_file_t_init(&file);
+
+    int ret = fs_open(&file, path, FS_O_READ);
+    if (ret < 0) {
+        return ret;
+    }
+
+    uint32_t cycles = k_cycle_get_32();
+
+    ret = audio_packed_open(&bench_reader, &file);
+    if (ret == 0) {
+        const uint8_t *packet;
+        size_t         len;
+
+        while ((ret = audio_packed_next(&bench_reader, &packet, &len)) > 0) {
+            result->packets++;
+        }
+
+        result->packed = true;
+        result->bytes  = bench_reader.file_pos;
+        result->reads  = bench_reader.reads;
+        result->copied = bench_reader.carried;
+        read_cycles    = bench_reader.read_cycles;
+    } else if (ret == -ENOMSG) {
+        ret = packed_bench_ogg(&file, result, &read_cycles);
+    }
+
+    cycles = k_cycle_get_32() - cycles;
+    fs_close(&file);
+
+    result->read_us  = k_cyc_to_us_floor32(read_cycles);
+    result->parse_us = k_cyc_to_us_floor32(cycles - read_cycles);
+
+    return ret < 0 ? ret : 0;
+}
+
+#ifdef CONFIG_RPR_AUDIO_PACKED_INGEST
+/**
+ * @brief Converts downloaded audio files once they are complete.
+ *
+ * @param filepath Path of the downloaded file.
+ */
+static void packed_download_cb(const char *filepath)
+{
+    size_t dir_len = strlen(CONFIG_RPR_AUDIO_DEFAULT_PATH);
+
+    if (strncmp(filepath, CONFIG_RPR_AUDIO_DEFAULT_PATH, dir_len) != 0 ||
+        filepath[dir_len] != '/') {
+        return;
+    }
+
+    int ret = audio_packed_ingest(filepath);
+    if (ret < 0) {
+        LOG_WRN("%s is kept as Ogg (%d)", filepath, ret);
+    }
+}
+
+/**
+ * @brief Registers the ingest conversion with the HTTP module.
+ */
+static int audio_packed_init(void)
+{
+    http_register_download_callback(packed_download_cb);
+    return 0;
+}
+
+SYS_INIT(audio_packed_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif
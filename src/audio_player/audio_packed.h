@@ -0,0 +1,174 @@
+/**
+ * @file audio_packed.h
+ * @brief Pre-packetized Opus container for on-device playback.
+ *
+ * Ogg is kept as the download format. On the device the packets are stored
+ * in a flat container that the player reads in aligned blocks, without
+ * libogg, page CRCs or a growing sync buffer. All fields are little endian:
+ *
+ *   offset size
+ *   0      4    magic "RPAK"
+ *   4      1    version (1)
+ *   5      1    channel count
+ *   6      2    pre-skip at 48 kHz
+ *   8      4    packet count
+ *   12     4    input sample rate
+ *   16     4    total samples at 48 kHz
+ *   20     4    index offset
+ *   24     2    index entry count
+ *   26     2    index interval, packets between entries
+ *   28     4    reserved, 0
+ *   32          packet records: u16 length + Opus packet, back to back
+ *   index       entries: u32 record offset + u32 start sample
+ *
+ * script/opus_pack.py writes the same format on a host. Files converted
+ * on the device keep their name, the player tells the formats apart by
+ * the magic.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_PACKED_H_
+#define AUDIO_PACKED_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define AUDIO_PACKED_HEADER_SIZE 32
+#define AUDIO_PACKED_MAX_PACKET  1275 /* Largest Opus packet, RFC 6716 */
+#define AUDIO_PACKED_RECORD_MAX  (2 + AUDIO_PACKED_MAX_PACKET)
+#define AUDIO_PACKED_READ_SIZE   CONFIG_RPR_AUDIO_PACKED_READ_SIZE
+
+struct audio_packed_header {
+    uint8_t  version;
+    uint8_t  channels;
+    uint16_t pre_skip;
+    uint32_t packet_count;
+    uint32_t input_rate;
+    uint32_t total_samples;  /* Stream length at 48 kHz */
+    uint32_t index_offset;   /* File offset of the seek index */
+    uint16_t index_count;
+    uint16_t index_interval; /* Packets between index entries */
+};
+
+struct audio_packed_reader {
+    struct fs_file_t          *file;
+    struct audio_packed_header header;
+    uint32_t                   file_pos; /* File offset after buffered data */
+    uint32_t                   head;     /* Next record in the buffer */
+    uint32_t                   tail;     /* End of the buffered data */
+    uint32_t                   packet;   /* Index of the next packet */
+    uint32_t                   reads;
+    uint32_t                   carried;  /* Bytes moved to the buffer start */
+    uint32_t                   read_cycles;
+    uint8_t                    buf[AUDIO_PACKED_READ_SIZE +
+                                   AUDIO_PACKED_RECORD_MAX] __aligned(4);
+};
+
+struct audio_packed_bench {
+    bool     packed;      /* Container, otherwise Ogg */
+    uint32_t packets;     /* Audio packets, Opus headers excluded */
+    uint32_t bytes;       /* File bytes read */
+    uint32_t reads;
+    uint32_t read_us;     /* Time spent in file reads */
+    uint32_t parse_us;    /* Demuxing time without the reads */
+    uint32_t copied;      /* Bytes copied by the demuxer */
+    uint32_t crc_bytes;   /* Bytes covered by page CRC checks */
+};
+
+/**
+ * @brief Starts reading a container from an open file.
+ *
+ * @param reader Reader with its buffer.
+ * @param file   File opened for reading at offset 0.
+ *
+ * @return 0 on success, -ENOMSG if the file is not a container (the file
+ *         is rewound then), other negative error code on failure.
+ */
+int audio_packed_open(struct audio_packed_reader *reader,
+                      struct fs_file_t           *file);
+
+/**
+ * @brief Gets the next packet.
+ *
+ * The packet points into the reader buffer and stays valid until the next
+ * call.
+ *
+ * @param reader Reader started with audio_packed_open().
+ * @param packet Pointer to store the packet address.
+ * @param len    Pointer to store the packet length.
+ *
+ * @return 1 if a packet was returned, 0 at the end of the stream, negative
+ *         error code if the file is damaged.
+ */
+int audio_packed_next(struct audio_packed_reader *reader,
+                      const uint8_t             **packet,
+                      size_t                     *len);
+
+/**
+ * @brief Moves the reader to the index entry at or before a position.
+ *
+ * @param reader Reader started with audio_packed_open().
+ * @param sample Target position at 48 kHz.
+ *
+ * @return Position of the next packet at 48 kHz, negative error code
+ *         otherwise.
+ */
+int64_t audio_packed_seek(struct audio_packed_reader *reader, uint32_t sample);
+
+/**
+ * @brief Moves the reader to a packet record.
+ *
+ * @param reader Reader started with audio_packed_open().
+ * @param offset File offset of the record.
+ * @param packet Index of the packet in the record.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_packed_resume(struct audio_packed_reader *reader,
+                        uint32_t                    offset,
+                        uint32_t                    packet);
+
+/**
+ * @brief Converts an Ogg Opus file into a container.
+ *
+ * @param src    Ogg Opus file.
+ * @param dst    Container to create, replaced if it exists.
+ * @param header Pointer to store the written header, may be NULL.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_packed_convert(const char                 *src,
+                         const char                 *dst,
+                         struct audio_packed_header *header);
+
+/**
+ * @brief Converts an Ogg Opus file into a container in place.
+ *
+ * The container is written next to the file and renamed over it, so the
+ * file is never left half converted.
+ *
+ * @param path Downloaded file.
+ *
+ * @return 1 if converted, 0 if the file is not Ogg, negative error code
+ *         otherwise.
+ */
+int audio_packed_ingest(const char *path);
+
+/**
+ * @brief Measures the demuxing cost of an Ogg file or a container.
+ *
+ * The whole file is demuxed without decoding.
+ *
+ * @param path   File to parse.
+ * @param result Pointer to store the measurement.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_packed_bench(const char *path, struct audio_packed_bench *result);
+
+#endif /* AUDIO_PACKED_H_ */
@@ -24,15 +24,18 @@
 #include <zephyr/fs/fs.h>
 
 #include "opus_interface.h"
-#include "ogg/ogg.h"
 #include "opus_header.h"
+#include "audio_ogg.h"
 #include "audio_player.h"
 
+#ifdef CONFIG_RPR_FLASH_QOS
+#include "flash_qos.h"
+#endif
+
 LOG_MODULE_REGISTER(audio_player, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
 
 #define AUDIO_THREAD_PRIORITY   5
-#define AUDIO_THREAD_STACK_SIZE 16384
-#define OGG_CHUNK_SIZE          2048
+#define AUDIO_THREAD_STACK_SIZE CONFIG_RPR_AUDIO_THREAD_STACK_SIZE
 
 #define I2S_CODEC_TX DT_ALIAS(i2s_codec_tx)
 
@@ -78,10 +81,57 @@ LOG_MODULE_REGISTER(audio_player, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
 
 #define BLOCK_SIZE (SAMPLES_PER_BLOCK * BYTES_PER_SAMPLE)
 
+#define MONO_SAMPLES_PER_BLOCK (SAMPLES_PER_BLOCK / DUPLICATION_FACTOR)
+
+#define BLOCK_DURATION_US \
+    ((MONO_SAMPLES_PER_BLOCK * USEC_PER_SEC) / SAMPLE_FREQUENCY)
+
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+/* The DMA frees one block per period, a whole queue period means a stall */
+#define AUDIO_BLOCK_TIMEOUT K_USEC(BLOCK_DURATION_US * (BLOCK_COUNT + 1))
+#else
+#define AUDIO_BLOCK_TIMEOUT Z_TIMEOUT_TICKS(TIMEOUT)
+#endif
+
 #define AUDIO_COUNT_SILENCE_BLOCK CONFIG_RPR_AUDIO_COUNT_SILENCE_BLOCK
 
+#if defined(CONFIG_RPR_AUDIO_IDLE_CLOCKED)
+#define AUDIO_IDLE_STATE AUDIO_POWER_CLOCKED
+#elif defined(CONFIG_RPR_AUDIO_IDLE_STANDBY)
+#define AUDIO_IDLE_STATE AUDIO_POWER_STANDBY
+#else
+#define AUDIO_IDLE_STATE AUDIO_POWER_WARM
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_ENABLE_STANDBY_WHEN_IDLE
+#define AUDIO_DEEPEST_IDLE_STATE AUDIO_POWER_STANDBY
+#else
+#define AUDIO_DEEPEST_IDLE_STATE AUDIO_POWER_WARM
+#endif
+
+#define AUDIO_IDLE_SLEEP_MS 100
+
+#ifdef CONFIG_RPR_AUDIO_SYNC
+/* Room for the sample a playout trim may insert, after duplication */
+#define AUDIO_TRIM_SLACK (DUPLICATION_FACTOR * BYTES_PER_SAMPLE)
+#else
+#define AUDIO_TRIM_SLACK 0
+#endif
+
 K_MEM_SLAB_DEFINE_STATIC(mem_slab, BLOCK_SIZE, BLOCK_COUNT, 4);
 
+#ifdef CONFIG_RPR_AUDIO_RTP
+/* Output queued ahead before the next frame is taken from the network */
+#define RTP_OUTPUT_LEAD_US (2 * BLOCK_DURATION_US)
+#define RTP_MAX_SAMPLES    ((SAMPLE_FREQUENCY / 1000) * DECODER_MS_FRAME)
+#endif
+
+typedef enum {
+    AUDIO_STREAM_FILE = 0,
+    AUDIO_STREAM_TONE,
+    AUDIO_STREAM_RTP,
+} audio_stream_type_t;
+
 struct audio_player_cfg {
     struct gpio_dt_spec codec_standby_gpio;
 #ifdef CONFIG_I2S
@@ -94,12 +144,49 @@ struct audio_player_cfg {
     audio_property_value_t mute;
     const struct device   *codec_dev;
 #endif
-    bool           is_codec_ready;
-    bool           pause;
-    bool           is_sound_playing;
-    struct k_event audio_event;
-    char           filepath[FULL_AUDIO_PATH_MAX_LEN];
-    bool           is_stream_init;
+    bool                is_codec_ready;
+    bool                pause;
+    bool                is_sound_playing;
+    bool                i2s_running;
+    struct k_event      audio_event;
+    char                filepath[FULL_AUDIO_PATH_MAX_LEN];
+    audio_stream_type_t stream_type;
+    audio_power_state_t power_state;
+    audio_power_state_t idle_state;
+    uint32_t            idle_timeout_ms;
+    int64_t             state_since_ms;
+    audio_power_state_t wake_from;
+    bool                wake_pending;
+    uint32_t            request_cycles;
+#ifdef CONFIG_RPR_AUDIO_TONE_GENERATOR
+    audio_tone_t tone;
+    uint32_t     tone_duration_ms;
+#endif
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+    uint32_t recovery_streak;
+#endif
+#ifdef CONFIG_RPR_AUDIO_TIMED_START
+    int64_t  start_at_us;    /* Uptime the stream must be heard at */
+    bool     start_pending;
+    int32_t  start_error_us; /* Error of the last scheduled start */
+    uint32_t start_count;
+#endif
+#ifdef CONFIG_I2S
+    void  *out_block; /* Block being filled, queued once full */
+    size_t out_fill;  /* Samples in the block being filled */
+#endif
+#ifdef CONFIG_RPR_AUDIO_RTP
+    uint16_t rtp_port;
+#endif
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+    struct k_work_delayable head_cache_check;
+    bool                    head_cache_force;
+#endif
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    bool     sync_stream;       /* Stream follows the network clock */
+    int64_t  sync_start_net_us; /* Network time the stream starts at */
+    uint64_t out_frames;        /* Mono frames output since the start */
+#endif
 };
 
 static DEC_Opus_ConfigTypeDef DecConfigOpus;
@@ -112,13 +199,88 @@ static struct audio_player_cfg audio_player_cfg = {
 #ifdef CONFIG_AUDIO_CODEC
     .codec_dev = DEVICE_DT_GET(DT_NODELABEL(audio_codec)),
 #endif
-    .is_codec_ready = false,
+    .is_codec_ready  = false,
+    .power_state     = AUDIO_POWER_STANDBY,
+    .idle_state      = AUDIO_IDLE_STATE,
+    .idle_timeout_ms = CONFIG_RPR_AUDIO_IDLE_TIMEOUT_MS,
+};
+
+static const char *const power_state_names[AUDIO_POWER_STATE_COUNT] = {
+    [AUDIO_POWER_ACTIVE]  = "active",
+    [AUDIO_POWER_CLOCKED] = "clocked",
+    [AUDIO_POWER_WARM]    = "warm",
+    [AUDIO_POWER_STANDBY] = "standby",
+};
+
+struct audio_power_log {
+    struct audio_power_stats stats;
+    uint64_t                 wake_sum_us[AUDIO_POWER_STATE_COUNT];
+};
+
+static struct audio_power_log power_log = {
+    .stats.state = AUDIO_POWER_STANDBY,
 };
+K_MUTEX_DEFINE(power_log_lock);
 
 #ifdef CONFIG_RPR_MEASURING_DECODE_TIME
 static int decoded_samples_total = 0;
 #endif
 
+#ifdef CONFIG_RPR_AUDIO_TONE_GENERATOR
+static struct tone_generator tone_gen;
+#endif
+
+static struct audio_ogg_demux ogg_demux;
+static uint8_t ogg_buf[CONFIG_RPR_AUDIO_OGG_BUFFER_SIZE] __aligned(4);
+static uint8_t ogg_packet_buf[CONFIG_RPR_AUDIO_OGG_PACKET_SIZE];
+
+#ifdef CONFIG_RPR_AUDIO_PACKED
+static struct audio_packed_reader packed_reader;
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+/* The cache is loaded between streams, with the playback buffers */
+static const struct audio_head_cache_work head_cache_work = {
+    .demux       = &ogg_demux,
+    .buf         = ogg_buf,
+    .size        = sizeof(ogg_buf),
+    .packet_buf  = ogg_packet_buf,
+    .packet_size = sizeof(ogg_packet_buf),
+#ifdef CONFIG_RPR_AUDIO_PACKED
+    .reader = &packed_reader,
+#endif
+};
+#endif
+
+#if defined(CONFIG_RPR_AUDIO_TONE_GENERATOR) || defined(CONFIG_RPR_AUDIO_EQ)
+/* Scratch blocks for the benchmarks and for playback without I2S */
+static int16_t bench_buf[SAMPLES_PER_BLOCK];
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+struct audio_recovery_log {
+    struct audio_recovery_event events[CONFIG_RPR_AUDIO_RECOVERY_LOG_SIZE];
+    uint32_t                    total;
+};
+
+static struct audio_recovery_log recovery_log;
+K_MUTEX_DEFINE(recovery_log_lock);
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_EQ
+static int16_t eq_ref_buf[MONO_SAMPLES_PER_BLOCK];
+
+#ifdef CONFIG_RPR_MEASURING_DECODE_TIME
+struct audio_eq_stats {
+    uint64_t cycles_sum;
+    uint32_t cycles_max;
+    uint32_t blocks;
+};
+
+static struct audio_eq_stats eq_stats;
+#endif
+#endif
+
 /**
  * @brief Audio playback thread function. Waits for start event and processes Opus data.
  */
@@ -229,7 +391,6 @@ static player_status_t audio_player_init(void)
     audio_player_cfg.is_codec_ready   = true;
     audio_player_cfg.pause            = false;
     audio_player_cfg.is_sound_playing = false;
-    audio_player_cfg.is_stream_init   = false;
 
 #ifdef CONFIG_AUDIO_CODEC
     ret_status = audio_player_set_volume(INITIAL_VOLUME);
@@ -365,13 +526,14 @@ player_status_t audio_player_set_mute(bool mute)
 /**
  * @brief Fills I2S buffer with silence blocks or starts I2S stream.
  * 
+ * @param count Number of silence blocks to queue.
  * @return PLAYER_OK or PLAYER_ERROR_I2S.
  */
-static player_status_t audio_player_fill_silence(void)
+static player_status_t audio_player_fill_silence(int count)
 {
 #ifdef CONFIG_I2S
     int ret = 0;
-    for (int i = 0; i < AUDIO_COUNT_SILENCE_BLOCK; i++) {
+    for (int i = 0; i < count; i++) {
 
         void *zero_block;
         ret = k_mem_slab_alloc(&mem_slab, &zero_block, K_FOREVER);
@@ -386,13 +548,13 @@ static player_status_t audio_player_fill_silence(void)
             return PLAYER_ERROR_I2S;
         }
 
-        if (!audio_player_cfg.is_sound_playing) {
+        if (!audio_player_cfg.i2s_running) {
             ret = trigger_i2s_command(I2S_TRIGGER_START);
             if (ret < 0) {
                 LOG_ERR("Failed to set trigger start");
                 return PLAYER_ERROR_I2S;
             }
-            audio_player_cfg.is_sound_playing = true;
+            audio_player_cfg.i2s_running = true;
         }
     }
 #endif
@@ -424,15 +586,21 @@ static void stop_audio_playback(void)
         if (trigger_i2s_command(I2S_TRIGGER_DROP) < 0) {
             LOG_ERR("Failed to set trigger drain");
         }
-
-    } else {
-        if (audio_player_fill_silence() != PLAYER_OK) {
+        audio_player_cfg.i2s_running = false;
+
+    } else if (audio_player_cfg.idle_state == AUDIO_POWER_CLOCKED &&
+               audio_player_cfg.i2s_running) {
+        // The idle loop keeps the stream running with silence
+    } else if (audio_player_cfg.i2s_running) {
+        if (audio_player_fill_silence(AUDIO_COUNT_SILENCE_BLOCK) !=
+            PLAYER_OK) {
             LOG_ERR("Failed to fill silence");
         }
 
         if (trigger_i2s_command(I2S_TRIGGER_DRAIN) < 0) {
             LOG_ERR("Failed to set trigger drain");
         }
+        audio_player_cfg.i2s_running = false;
     }
 #else
     LOG_WRN("Audio I2S not supported");
@@ -441,23 +609,16 @@ static void stop_audio_playback(void)
     audio_player_cfg.is_sound_playing = false;
     audio_player_cfg.pause            = false;
 
-#ifdef CONFIG_RPR_AUDIO_ENABLE_STANDBY_WHEN_IDLE
-    int ret = gpio_pin_set_dt(&audio_player_cfg.codec_standby_gpio,
-                              CODEC_DISABLE_VALUE);
-    if (ret != 0) {
-        LOG_ERR("Failed to disable codec GPIO (err %d)", ret);
-    }
-#endif
-
     LOG_DBG("Stoped audio playback");
 }
 
 /**
  * @brief Starts audio playback (or resumes if paused).
  * 
+ * @param preroll_blocks Number of silence blocks queued before the stream.
  * @return PLAYER_OK or error code.
  */
-static player_status_t start_audio_playback(void)
+static player_status_t start_audio_playback(int preroll_blocks)
 {
     if (audio_player_cfg.is_sound_playing && !audio_player_cfg.pause) {
         LOG_WRN("Audio is playing");
@@ -469,7 +630,7 @@ static player_status_t start_audio_playback(void)
 #ifdef CONFIG_I2S
 
     if (!audio_player_cfg.is_sound_playing) {
-        if (audio_player_fill_silence() != PLAYER_OK) {
+        if (audio_player_fill_silence(preroll_blocks) != PLAYER_OK) {
             return PLAYER_ERROR_I2S;
         }
     } else if (audio_player_cfg.pause) {
@@ -478,11 +639,12 @@ static player_status_t start_audio_playback(void)
             LOG_ERR("Failed to set trigger start");
             return PLAYER_ERROR_I2S;
         }
+        audio_player_cfg.i2s_running = true;
     }
 #else
     LOG_WRN("Audio I2S not supported");
-    audio_player_cfg.is_sound_playing = true;
 #endif
+    audio_player_cfg.is_sound_playing = true;
 
 #ifdef CONFIG_AUDIO_CODEC
 #ifdef CONFIG_RPR_AUDIO_AUTO_MUTE
@@ -523,7 +685,7 @@ static player_status_t pause_audio_playback(void)
 
 #ifdef CONFIG_I2S
 
-    if (audio_player_fill_silence() != PLAYER_OK) {
+    if (audio_player_fill_silence(AUDIO_COUNT_SILENCE_BLOCK) != PLAYER_OK) {
         LOG_ERR("Failed to fill_silence");
         return PLAYER_ERROR_I2S;
     }
@@ -532,6 +694,7 @@ static player_status_t pause_audio_playback(void)
         LOG_ERR("Failed to set trigger stop");
         return PLAYER_ERROR_I2S;
     }
+    audio_player_cfg.i2s_running = false;
 
 #else
     LOG_WRN("Audio I2S not supported");
@@ -543,47 +706,305 @@ static player_status_t pause_audio_playback(void)
 }
 
 /**
- * @brief Initializes Ogg stream and Opus decoder.
+ * @brief Sets the codec standby pin.
  * 
- * @param oy Ogg sync state.
- * @param os Ogg stream state.
- * @param og Pointer to the current Ogg page.
- * @param op Pointer to the current Ogg packet.
- * @return true if successful, false otherwise.
+ * @param value CODEC_ENABLE_VALUE or CODEC_DISABLE_VALUE.
  */
-static bool audio_player_stream_and_decoder_init(ogg_sync_state   *oy,
-                                                 ogg_stream_state *os,
-                                                 ogg_page         *og,
-                                                 ogg_packet       *op)
+static void audio_player_set_standby_pin(int value)
 {
-    int stream = ogg_stream_init(os, ogg_page_serialno(og));
-    if (!stream)
-        audio_player_cfg.is_stream_init = true;
-    else {
-        LOG_ERR("Failed stream init - %d", stream);
-        return false;
+    int ret = gpio_pin_set_dt(&audio_player_cfg.codec_standby_gpio, value);
+    if (ret != 0) {
+        LOG_ERR("Failed to %s codec GPIO (err %d)",
+                value == CODEC_ENABLE_VALUE ? "enable" : "disable",
+                ret);
     }
+}
+
+/**
+ * @brief Keeps the I2S clocks alive by queueing one block of silence.
+ *
+ * Waits for a free block, so the idle loop is paced by the DMA.
+ * 
+ * @return true on success, false if the stream has stalled or failed.
+ */
+static bool audio_player_feed_silence(void)
+{
+#ifdef CONFIG_I2S
+    void *zero_block;
 
-    ogg_stream_pagein(os, og);
+    if (k_mem_slab_alloc(&mem_slab, &zero_block, AUDIO_BLOCK_TIMEOUT) != 0) {
+        return false;
+    }
 
-    if (ogg_stream_packetout(os, op) != 1) {
-        LOG_ERR("Invalid Opus header packet");
+    memset(zero_block, 0, BLOCK_SIZE);
+    if (i2s_write(audio_player_cfg.i2s_dev, zero_block, BLOCK_SIZE) < 0) {
+        k_mem_slab_free(&mem_slab, zero_block);
         return false;
     }
+#endif
+    return true;
+}
+
+/**
+ * @brief Stops the I2S clocks and releases the queued blocks.
+ */
+static void audio_player_stop_clocks(void)
+{
+    if (!audio_player_cfg.i2s_running) {
+        return;
+    }
+
+    if (trigger_i2s_command(I2S_TRIGGER_DROP) < 0 &&
+        trigger_i2s_command(I2S_TRIGGER_PREPARE) < 0) {
+        LOG_ERR("Failed to stop I2S clocks");
+    }
+    audio_player_cfg.i2s_running = false;
+}
+
+/**
+ * @brief Moves the codec and the I2S to the given power state.
+ *
+ * Only called from the audio thread. The time spent in the previous state
+ * is added to its residency.
+ * 
+ * @param state New power state.
+ */
+static void audio_player_set_power_state(audio_power_state_t state)
+{
+    audio_power_state_t prev = audio_player_cfg.power_state;
+    int64_t             now  = k_uptime_get();
+
+    if (state == prev) {
+        return;
+    }
+
+    switch (state) {
+    case AUDIO_POWER_ACTIVE:
+        // The standby pin is released by the requester, see request_stream
+        audio_player_cfg.wake_from    = prev;
+        audio_player_cfg.wake_pending = true;
+        break;
+    case AUDIO_POWER_CLOCKED:
+        audio_player_set_standby_pin(CODEC_ENABLE_VALUE);
+        if (!audio_player_cfg.i2s_running &&
+            audio_player_fill_silence(BLOCK_COUNT) != PLAYER_OK) {
+            LOG_WRN("Failed to start I2S clocks, staying warm");
+            audio_player_stop_clocks();
+            state = AUDIO_POWER_WARM;
+        }
+        break;
+    case AUDIO_POWER_WARM:
+        audio_player_stop_clocks();
+        audio_player_set_standby_pin(CODEC_ENABLE_VALUE);
+        break;
+    case AUDIO_POWER_STANDBY:
+    default:
+        audio_player_stop_clocks();
+        audio_player_set_standby_pin(CODEC_DISABLE_VALUE);
+        break;
+    }
+
+    k_mutex_lock(&power_log_lock, K_FOREVER);
+    power_log.stats.residency_ms[prev] += now - audio_player_cfg.state_since_ms;
+    power_log.stats.entries[state]++;
+    power_log.stats.state           = state;
+    audio_player_cfg.state_since_ms = now;
+    audio_player_cfg.power_state    = state;
+    k_mutex_unlock(&power_log_lock);
+
+    LOG_DBG("Codec power state: %s -> %s",
+            power_state_names[prev],
+            power_state_names[state]);
+}
+
+/**
+ * @brief Returns the idle level the codec should be kept at.
+ */
+static audio_power_state_t audio_player_idle_target(void)
+{
+    return audio_player_cfg.is_codec_ready ? audio_player_cfg.idle_state :
+                                             AUDIO_POWER_STANDBY;
+}
+
+/**
+ * @brief Returns the silence preroll for a stream woken from the last level.
+ */
+static int audio_player_wake_preroll(void)
+{
+    switch (audio_player_cfg.wake_from) {
+    case AUDIO_POWER_CLOCKED:
+        return 0;
+    case AUDIO_POWER_WARM:
+        return CONFIG_RPR_AUDIO_WARM_PREROLL_BLOCKS;
+    default:
+        return AUDIO_COUNT_SILENCE_BLOCK;
+    }
+}
+
+/**
+ * @brief Keeps the clocks alive (if running) for the given time.
+ * 
+ * @param ms Time to wait in milliseconds.
+ */
+static void audio_player_idle_sleep(int32_t ms)
+{
+    if (!audio_player_cfg.i2s_running) {
+        k_msleep(ms);
+        return;
+    }
+
+    int64_t end = k_uptime_get() + ms;
+
+    while (k_uptime_get() < end) {
+        if (!audio_player_feed_silence()) {
+            audio_player_stop_clocks();
+            k_msleep(ms);
+            return;
+        }
+    }
+}
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+/**
+ * @brief Reloads the head cache if the clips have changed.
+ */
+static void audio_player_head_cache_check(void)
+{
+    bool force = audio_player_cfg.head_cache_force;
+
+    audio_player_cfg.head_cache_force = false;
+
+    int ret = audio_head_cache_refresh(&head_cache_work, force);
+    if (ret < 0) {
+        LOG_WRN("Head cache refresh failed (err %d)", ret);
+    }
+}
+
+/**
+ * @brief Periodically asks the audio thread to look for changed clips.
+ */
+static void audio_player_head_cache_timer(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+
+    k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_CACHE);
+    k_work_reschedule(dwork, K_SECONDS(CONFIG_RPR_AUDIO_HEAD_CACHE_CHECK_S));
+}
+#endif
+
+/**
+ * @brief Waits for the next stream request at the selected idle level.
+ *
+ * At the clocked level the I2S is fed with silence while waiting. When the
+ * idle timeout expires the codec drops to the deepest allowed level, and
+ * a policy change (AUDIO_EVT_STANDBY) is applied immediately. A head cache
+ * check (AUDIO_EVT_CACHE) is run here too, unless a stream is waiting.
+ * 
+ * @return AUDIO_EVT_START and/or AUDIO_EVT_PING.
+ */
+static uint32_t audio_player_idle_wait(void)
+{
+    const uint32_t mask = AUDIO_EVT_START | AUDIO_EVT_PING | AUDIO_EVT_STANDBY |
+                          AUDIO_EVT_CACHE;
+    int64_t        idle_since = k_uptime_get();
+
+    // Control events of the finished stream are stale from here on
+    k_event_clear(&audio_player_cfg.audio_event, (uint32_t)~AUDIO_EVT_CACHE);
+
+    audio_player_set_power_state(audio_player_idle_target());
+
+    while (1) {
+        k_timeout_t timeout = K_FOREVER;
+
+        if (audio_player_cfg.idle_timeout_ms > 0 &&
+            audio_player_cfg.power_state < AUDIO_DEEPEST_IDLE_STATE) {
+            int64_t left = idle_since + audio_player_cfg.idle_timeout_ms -
+                           k_uptime_get();
+            if (left <= 0) {
+                LOG_DBG("Idle timeout, codec steps down");
+                audio_player_set_power_state(AUDIO_DEEPEST_IDLE_STATE);
+                continue;
+            }
+            timeout = K_MSEC(left);
+        }
+
+        if (audio_player_cfg.power_state == AUDIO_POWER_CLOCKED) {
+            if (!audio_player_feed_silence()) {
+                LOG_WRN("I2S idle clock stalled, restarting");
+                audio_player_stop_clocks();
+                if (audio_player_fill_silence(BLOCK_COUNT) != PLAYER_OK) {
+                    audio_player_set_power_state(AUDIO_POWER_WARM);
+                }
+            }
+            timeout = K_NO_WAIT;
+        }
+
+        uint32_t evt = k_event_wait(
+                &audio_player_cfg.audio_event, mask, false, timeout);
+        if (evt == 0) {
+            continue;
+        }
+        k_event_clear(&audio_player_cfg.audio_event, evt);
+
+        if (evt & AUDIO_EVT_STANDBY) {
+            idle_since = k_uptime_get();
+            audio_player_set_power_state(audio_player_idle_target());
+        }
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+        if (evt & AUDIO_EVT_CACHE) {
+            if (evt & AUDIO_EVT_START) {
+                k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_CACHE);
+            } else {
+                audio_player_head_cache_check();
+            }
+        }
+#endif
+
+        evt &= AUDIO_EVT_START | AUDIO_EVT_PING;
+        if (evt) {
+            return evt;
+        }
+    }
+}
 
+static bool audio_player_decoder_init(void);
+
+/**
+ * @brief Parses the Opus header packet and initializes the Opus decoder.
+ * 
+ * @param packet First packet of the Ogg stream.
+ * @return true if successful, false otherwise.
+ */
+static bool
+audio_player_header_and_decoder_init(const struct audio_ogg_packet *packet)
+{
     OpusHeader header;
-    if (opus_header_parse(op->packet, op->bytes, &header) == 0) {
+    if (opus_header_parse(packet->data, packet->len, &header) == 0) {
         LOG_ERR("Cannot parse Opus header");
         return false;
     }
 
+    LOG_DBG("Sample_freq: %d, channel: %d",
+            header.input_sample_rate,
+            header.channels);
+
+    return audio_player_decoder_init();
+}
+
+/**
+ * @brief Configures the Opus decoder for mono output at the I2S rate.
+ *
+ * The decoder buffer has room for the duplicated output samples.
+ * 
+ * @return true if successful, false otherwise.
+ */
+static bool audio_player_decoder_init(void)
+{
     if (DEC_Opus_IsConfigured()) {
         LOG_ERR("Opus decoder is already configured");
         return false;
     }
-    LOG_DBG("Sample_freq: %d, channel: %d",
-            header.input_sample_rate,
-            header.channels);
 
     DecConfigOpus.sample_freq = SAMPLE_FREQUENCY;
     DecConfigOpus.channels    = MONO_CHANNELS;
@@ -593,7 +1014,8 @@ static bool audio_player_stream_and_decoder_init(ogg_sync_state   *oy,
 
     LOG_DBG("dec_size: %d", dec_size);
 
-    DecConfigOpus.pInternalMemory = malloc(dec_size * DUPLICATION_FACTOR);
+    DecConfigOpus.pInternalMemory =
+            malloc(dec_size * DUPLICATION_FACTOR + AUDIO_TRIM_SLACK);
     if (!DecConfigOpus.pInternalMemory) {
         LOG_ERR("Decoder memory allocation failed");
         return false;
@@ -634,281 +1056,1701 @@ static size_t duplicate_samples(int16_t *buffer, size_t samples)
     return samples * DUPLICATION_FACTOR;
 }
 
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
 /**
- * @brief Decodes an Opus packet and writes PCM data to I2S output.
+ * @brief Stores a recovery event in the ring log.
  * 
- * @param op Pointer to decoded Ogg Opus packet.
- * @return true on success, false on failure.
+ * @param event Event to record.
  */
-static bool audio_player_decode_and_write(ogg_packet *op)
+static void
+audio_player_record_recovery(const struct audio_recovery_event *event)
 {
-    int decoded_samples = DEC_Opus_Decode(
-            op->packet, op->bytes, DecConfigOpus.pInternalMemory);
-    if (decoded_samples < 0) {
-        LOG_ERR("Opus decoding error: %d", decoded_samples);
-        return true;
+    k_mutex_lock(&recovery_log_lock, K_FOREVER);
+    recovery_log.events[recovery_log.total %
+                        CONFIG_RPR_AUDIO_RECOVERY_LOG_SIZE] = *event;
+    recovery_log.total++;
+    k_mutex_unlock(&recovery_log_lock);
+}
+
+/**
+ * @brief Restarts a stalled or failed I2S stream.
+ *
+ * Drops whatever is left in the DMA queue (or clears the error state),
+ * re-primes the queue with a fixed number of silence blocks and starts the
+ * stream again, so playback resumes from the current packet after a
+ * bounded gap. Consecutive recoveries without a successful write in between
+ * are limited to CONFIG_RPR_AUDIO_RECOVERY_MAX_RETRIES.
+ * 
+ * @param cause Reason of the recovery.
+ * @param err   Error code reported by the failing call.
+ * @return true if the stream is running again, false otherwise.
+ */
+static bool audio_player_recover(audio_recovery_cause_t cause, int err)
+{
+    struct audio_recovery_event event = {
+        .timestamp_ms = k_uptime_get(),
+        .cause        = cause,
+        .error        = err,
+    };
+    uint32_t cycles = k_cycle_get_32();
+    int      ret;
+
+    if (audio_player_cfg.recovery_streak >=
+        CONFIG_RPR_AUDIO_RECOVERY_MAX_RETRIES) {
+        LOG_ERR("I2S recovery limit reached, giving up");
+        return false;
     }
+    audio_player_cfg.recovery_streak++;
 
-    int16_t *pcm_ptr           = (int16_t *)DecConfigOpus.pInternalMemory;
-    int      samples_remaining = duplicate_samples(pcm_ptr, decoded_samples);
+    LOG_WRN("I2S %s (err %d), recovering",
+            cause == AUDIO_RECOVERY_STALL ? "stall" : "write error",
+            err);
 
-    while (samples_remaining > 0) {
-        void *mem_block;
-        int   samples_to_copy = MIN(SAMPLES_PER_BLOCK, samples_remaining);
+    ret = trigger_i2s_command(I2S_TRIGGER_DROP);
+    if (ret < 0) {
+        // DROP is refused in the error state, PREPARE clears it instead
+        ret = trigger_i2s_command(I2S_TRIGGER_PREPARE);
+    }
 
-#ifdef CONFIG_I2S
-        if (k_mem_slab_alloc(&mem_slab, &mem_block, Z_TIMEOUT_TICKS(TIMEOUT))) {
-            LOG_ERR("Failed to allocate TX block");
-            return false;
-        }
+    for (int i = 0; i < CONFIG_RPR_AUDIO_RECOVERY_PRIME_BLOCKS && ret >= 0;
+         i++) {
+        void *zero_block;
 
-        memcpy(mem_block, pcm_ptr, samples_to_copy * BYTES_PER_SAMPLE);
-        memset((uint8_t *)mem_block + samples_to_copy * BYTES_PER_SAMPLE,
-               0,
-               BLOCK_SIZE - samples_to_copy * BYTES_PER_SAMPLE);
+        ret = k_mem_slab_alloc(&mem_slab, &zero_block, K_NO_WAIT);
+        if (ret < 0) {
+            break;
+        }
 
-        if (i2s_write(audio_player_cfg.i2s_dev, mem_block, BLOCK_SIZE) < 0) {
-            LOG_ERR("Failed to write I2S");
-            return false;
+        memset(zero_block, 0, BLOCK_SIZE);
+        ret = i2s_write(audio_player_cfg.i2s_dev, zero_block, BLOCK_SIZE);
+        if (ret < 0) {
+            k_mem_slab_free(&mem_slab, zero_block);
+            break;
         }
-#endif
+        event.silence_blocks++;
+    }
 
-#ifdef CONFIG_RPR_MEASURING_DECODE_TIME
-        decoded_samples_total++;
-#endif
-        pcm_ptr += samples_to_copy;
-        samples_remaining -= samples_to_copy;
+    if (ret >= 0) {
+        ret = trigger_i2s_command(I2S_TRIGGER_START);
+    }
+
+    event.success     = (ret >= 0);
+    event.duration_us = k_cyc_to_us_floor32(k_cycle_get_32() - cycles);
+
+    audio_player_record_recovery(&event);
+
+    if (!event.success) {
+        LOG_ERR("I2S recovery failed (err %d)", ret);
+        return false;
     }
 
+    LOG_INF("I2S recovered in %u us, %u silence blocks",
+            event.duration_us,
+            event.silence_blocks);
+
     return true;
 }
+#endif
 
+#ifdef CONFIG_I2S
 /**
- * @brief Releases all allocated audio resources after playback.
- * 
- * @param os Ogg stream state.
- * @param oy Ogg sync state.
+ * @brief Records the wake latency when the first block of a stream is queued.
+ *
+ * The block is heard after the blocks queued ahead of it, so the latency to
+ * sound is the time to queue it plus one block period per block ahead.
  */
-static void audio_player_cleanup(ogg_stream_state *os, ogg_sync_state *oy)
+static void audio_player_note_block_queued(void)
 {
-    if (DEC_Opus_IsConfigured()) {
-        DEC_Opus_Deinit();
-    }
-
-    if (DecConfigOpus.pInternalMemory) {
-        free(DecConfigOpus.pInternalMemory);
-        DecConfigOpus.pInternalMemory = NULL;
-    }
-
-    if (audio_player_cfg.is_stream_init) {
-        ogg_stream_clear(os);
-        audio_player_cfg.is_stream_init = false;
+    if (!audio_player_cfg.wake_pending) {
+        return;
     }
-
-    ogg_sync_clear(oy);
+    audio_player_cfg.wake_pending = false;
+
+    uint32_t queued_us = k_cyc_to_us_floor32(k_cycle_get_32() -
+                                             audio_player_cfg.request_cycles);
+    uint32_t ahead     = k_mem_slab_num_used_get(&mem_slab) - 1;
+    uint32_t sound_us  = queued_us + ahead * BLOCK_DURATION_US;
+
+    audio_power_state_t      from = audio_player_cfg.wake_from;
+    struct audio_wake_stats *wake = &power_log.stats.wake[from];
+
+    k_mutex_lock(&power_log_lock, K_FOREVER);
+    wake->count++;
+    wake->last_us = sound_us;
+    wake->max_us  = MAX(wake->max_us, sound_us);
+    power_log.wake_sum_us[from] += sound_us;
+    k_mutex_unlock(&power_log_lock);
+
+    LOG_INF("Wake from %s: first block queued in %u us, sound in %u us",
+            power_state_names[from],
+            queued_us,
+            sound_us);
 }
 
+#ifdef CONFIG_RPR_AUDIO_TIMED_START
 /**
- * @brief Handles STOP and PAUSE/RESUME events during playback.
+ * @brief Holds the first block of a scheduled stream until its start time.
+ *
+ * Silence is queued until the block allocated next would be heard at the
+ * scheduled instant. Once the queue is full the allocation returns right
+ * when the DMA moves to the next block, so the playout time of the new
+ * block is known and the start error is bounded by half a block period.
  * 
- * @return true if playback should be stopped, false otherwise.
+ * @param play_us Pointer to store the uptime the block is heard at.
+ * @return Pointer to the block for the first stream samples, or NULL.
  */
-static bool handle_audio_control_events(void)
+static void *audio_player_alloc_scheduled_block(int64_t *play_us)
 {
-    uint32_t new_evt =
-            k_event_wait(&audio_player_cfg.audio_event,
+    int64_t target = audio_player_cfg.start_at_us;
+
+    audio_player_cfg.start_pending = false;
+    // The start latency is set by the schedule, not by the wake-up
+    audio_player_cfg.wake_pending = false;
+
+    while (1) {
+        bool  paced = audio_player_cfg.i2s_running &&
+                      k_mem_slab_num_free_get(&mem_slab) == 0;
+        void *mem_block;
+
+        if (k_mem_slab_alloc(&mem_slab, &mem_block, AUDIO_BLOCK_TIMEOUT) !=
+            0) {
+            LOG_ERR("Failed to allocate TX block");
+            return NULL;
+        }
+
+        int64_t ahead   = k_mem_slab_num_used_get(&mem_slab) - 1;
+        int64_t play_at = k_ticks_to_us_floor64(k_uptime_ticks()) +
+                          ahead * BLOCK_DURATION_US;
+
+        if (play_at >= target ||
+            (paced && play_at + BLOCK_DURATION_US / 2 >= target)) {
+            audio_player_cfg.start_error_us = (int32_t)(play_at - target);
+            audio_player_cfg.start_count++;
+            LOG_INF("Scheduled start error: %d us",
+                    audio_player_cfg.start_error_us);
+            *play_us = play_at;
+            return mem_block;
+        }
+
+        if (k_event_test(&audio_player_cfg.audio_event, AUDIO_EVT_STOP)) {
+            LOG_INF("Scheduled start cancelled");
+            k_mem_slab_free(&mem_slab, mem_block);
+            return NULL;
+        }
+
+        memset(mem_block, 0, BLOCK_SIZE);
+        if (i2s_write(audio_player_cfg.i2s_dev, mem_block, BLOCK_SIZE) < 0) {
+            LOG_ERR("Failed to i2s write zero TX block");
+            k_mem_slab_free(&mem_slab, mem_block);
+            return NULL;
+        }
+
+        if (!audio_player_cfg.i2s_running) {
+            if (trigger_i2s_command(I2S_TRIGGER_START) < 0) {
+                LOG_ERR("Failed to set trigger start");
+                return NULL;
+            }
+            audio_player_cfg.i2s_running = true;
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Allocates an I2S block, recovering the stream if the DMA stalled.
+ *
+ * The first block of a scheduled stream is held until its start time.
+ * When the queue is full the allocation returns as the DMA moves to the
+ * next block, so the time the new block is heard at is known.
+ * 
+ * @param play_us Pointer to store the uptime the block is heard at, 0 if
+ *                the queue was not full.
+ * @return Pointer to the block, or NULL on failure.
+ */
+static void *audio_player_alloc_block(int64_t *play_us)
+{
+    void *mem_block;
+
+    *play_us = 0;
+
+#ifdef CONFIG_RPR_AUDIO_TIMED_START
+    if (audio_player_cfg.start_pending) {
+        return audio_player_alloc_scheduled_block(play_us);
+    }
+#endif
+
+    bool paced = audio_player_cfg.i2s_running &&
+                 k_mem_slab_num_free_get(&mem_slab) == 0;
+
+    if (k_mem_slab_alloc(&mem_slab, &mem_block, AUDIO_BLOCK_TIMEOUT) == 0) {
+        if (paced) {
+            int64_t ahead = k_mem_slab_num_used_get(&mem_slab) - 1;
+
+            *play_us = k_ticks_to_us_floor64(k_uptime_ticks()) +
+                       ahead * BLOCK_DURATION_US;
+        }
+        return mem_block;
+    }
+
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+    if (audio_player_recover(AUDIO_RECOVERY_STALL, -EAGAIN) &&
+        k_mem_slab_alloc(&mem_slab, &mem_block, AUDIO_BLOCK_TIMEOUT) == 0) {
+        return mem_block;
+    }
+#endif
+
+    LOG_ERR("Failed to allocate TX block");
+    return NULL;
+}
+
+/**
+ * @brief Queues a filled block to the I2S, recovering the stream on error.
+ *
+ * The block is released if it cannot be queued.
+ * 
+ * @param mem_block Block of BLOCK_SIZE bytes from the memory slab.
+ * @return true on success, false on failure.
+ */
+static bool audio_player_write_block(void *mem_block)
+{
+    int ret = i2s_write(audio_player_cfg.i2s_dev, mem_block, BLOCK_SIZE);
+
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+    if (ret < 0 && audio_player_recover(AUDIO_RECOVERY_WRITE_ERROR, ret)) {
+        ret = i2s_write(audio_player_cfg.i2s_dev, mem_block, BLOCK_SIZE);
+    }
+
+    if (ret == 0) {
+        audio_player_cfg.recovery_streak = 0;
+    }
+#endif
+
+    if (ret < 0) {
+        LOG_ERR("Failed to write I2S");
+        k_mem_slab_free(&mem_slab, mem_block);
+        return false;
+    }
+
+    // Streams without a silence preroll start on their first block
+    if (!audio_player_cfg.i2s_running) {
+        if (trigger_i2s_command(I2S_TRIGGER_START) < 0) {
+            LOG_ERR("Failed to set trigger start");
+            return false;
+        }
+        audio_player_cfg.i2s_running = true;
+    }
+
+    audio_player_note_block_queued();
+
+    return true;
+}
+
+#ifdef CONFIG_RPR_AUDIO_SYNC
+/**
+ * @brief Aligns the first block of a synchronized stream to the sample.
+ *
+ * Pads the new block with silence if it is heard early, or returns the
+ * number of leading samples to skip if it is heard late.
+ * 
+ * @param play_us Uptime in us the new block is heard at.
+ * @param samples Output samples available in the current packet.
+ * @return Number of output samples to skip.
+ */
+static size_t audio_player_sync_align(int64_t play_us, size_t samples)
+{
+    int32_t max_frames = MIN(MONO_SAMPLES_PER_BLOCK,
+                             samples / DUPLICATION_FACTOR);
+    int32_t skip       = audio_sync_stream_align(play_us, max_frames);
+
+    if (skip >= 0) {
+        return skip * DUPLICATION_FACTOR;
+    }
+
+    size_t pad = -skip * DUPLICATION_FACTOR;
+
+    memset(audio_player_cfg.out_block, 0, pad * BYTES_PER_SAMPLE);
+    audio_player_cfg.out_fill = pad;
+    audio_player_cfg.out_frames += -skip;
+
+    return 0;
+}
+#endif
+
+/**
+ * @brief Copies output samples into I2S blocks and queues the full ones.
+ *
+ * A block that is not full is kept for the next packet, so packets that
+ * do not fill whole blocks (other Opus frame sizes, trimmed packets) play
+ * without gaps.
+ * 
+ * @param pcm     Interleaved output samples.
+ * @param samples Number of samples.
+ * @return true on success, false on failure.
+ */
+static bool audio_player_queue_samples(const int16_t *pcm, size_t samples)
+{
+    while (samples > 0) {
+        if (!audio_player_cfg.out_block) {
+            int64_t play_us;
+
+            audio_player_cfg.out_block = audio_player_alloc_block(&play_us);
+            if (!audio_player_cfg.out_block) {
+                return false;
+            }
+            audio_player_cfg.out_fill = 0;
+
+#ifdef CONFIG_RPR_AUDIO_SYNC
+            if (audio_player_cfg.sync_stream && play_us > 0) {
+                if (audio_player_cfg.out_frames == 0) {
+                    size_t skip = audio_player_sync_align(play_us, samples);
+
+                    pcm += skip;
+                    samples -= skip;
+                } else {
+                    audio_sync_stream_playout(play_us,
+                                              audio_player_cfg.out_frames);
+                }
+            }
+#endif
+        }
+
+        size_t count = MIN(SAMPLES_PER_BLOCK - audio_player_cfg.out_fill,
+                           samples);
+
+        memcpy((int16_t *)audio_player_cfg.out_block +
+                       audio_player_cfg.out_fill,
+               pcm,
+               count * BYTES_PER_SAMPLE);
+        audio_player_cfg.out_fill += count;
+        pcm += count;
+        samples -= count;
+#ifdef CONFIG_RPR_AUDIO_SYNC
+        audio_player_cfg.out_frames += count / DUPLICATION_FACTOR;
+#endif
+
+        if (audio_player_cfg.out_fill == SAMPLES_PER_BLOCK) {
+            void *mem_block = audio_player_cfg.out_block;
+
+            audio_player_cfg.out_block = NULL;
+            if (!audio_player_write_block(mem_block)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Queues the partly filled block padded with silence, or drops it.
+ * 
+ * @param queue true at the end of the stream, false when it is stopped.
+ */
+static void audio_player_flush_block(bool queue)
+{
+    void *mem_block = audio_player_cfg.out_block;
+
+    if (!mem_block) {
+        return;
+    }
+    audio_player_cfg.out_block = NULL;
+
+    if (!queue) {
+        k_mem_slab_free(&mem_slab, mem_block);
+        return;
+    }
+
+    memset((int16_t *)mem_block + audio_player_cfg.out_fill,
+           0,
+           (SAMPLES_PER_BLOCK - audio_player_cfg.out_fill) * BYTES_PER_SAMPLE);
+    audio_player_write_block(mem_block);
+}
+#endif
+
+#if defined(CONFIG_RPR_AUDIO_TONE_GENERATOR) || defined(CONFIG_RPR_AUDIO_EQ)
+/**
+ * @brief Returns the number of CPU cycles available for one I2S block.
+ */
+static uint32_t audio_player_block_budget_cycles(void)
+{
+    return (uint32_t)(((uint64_t)sys_clock_hw_cycles_per_sec() *
+                       BLOCK_DURATION_US) /
+                      USEC_PER_SEC);
+}
+#endif
+
+/**
+ * @brief Prepares the output post-processing for a new stream.
+ */
+static void audio_player_eq_stream_start(void)
+{
+#ifdef CONFIG_RPR_AUDIO_EQ
+    audio_eq_reset();
+#ifdef CONFIG_RPR_MEASURING_DECODE_TIME
+    memset(&eq_stats, 0, sizeof(eq_stats));
+#endif
+#endif
+}
+
+/**
+ * @brief Applies the speaker-correction EQ to decoded mono samples.
+ * 
+ * @param pcm     Samples to filter in place.
+ * @param samples Number of samples.
+ */
+static void audio_player_apply_eq(int16_t *pcm, size_t samples)
+{
+#ifdef CONFIG_RPR_AUDIO_EQ
+#ifdef CONFIG_RPR_MEASURING_DECODE_TIME
+    if (!audio_eq_is_active() || samples == 0) {
+        return;
+    }
+
+    uint32_t cycles = k_cycle_get_32();
+    audio_eq_process(pcm, samples);
+    cycles = k_cycle_get_32() - cycles;
+
+    // Normalize to one I2S block, a decoded packet may span several blocks
+    cycles = (uint32_t)(((uint64_t)cycles * MONO_SAMPLES_PER_BLOCK) / samples);
+
+    eq_stats.cycles_sum += cycles;
+    eq_stats.cycles_max = MAX(eq_stats.cycles_max, cycles);
+    eq_stats.blocks++;
+#else
+    audio_eq_process(pcm, samples);
+#endif
+#endif
+}
+
+/**
+ * @brief Logs the EQ cost of the finished stream against its cycle budget.
+ */
+static void audio_player_eq_stream_report(void)
+{
+#if defined(CONFIG_RPR_AUDIO_EQ) && defined(CONFIG_RPR_MEASURING_DECODE_TIME)
+    if (eq_stats.blocks == 0) {
+        return;
+    }
+
+    uint32_t budget = audio_player_block_budget_cycles() *
+                      CONFIG_RPR_AUDIO_EQ_CYCLE_BUDGET_PERCENT / 100U;
+
+    LOG_INF("EQ: %u stages, avg %u / max %u cycles per block, budget %u",
+            (uint32_t)audio_eq_stage_count(),
+            (uint32_t)(eq_stats.cycles_sum / eq_stats.blocks),
+            eq_stats.cycles_max,
+            budget);
+
+    if (eq_stats.cycles_max > budget) {
+        LOG_WRN("EQ exceeded its cycle budget");
+    }
+#endif
+}
+
+/**
+ * @brief Prepares the output timeline of a new file stream.
+ *
+ * Starts the playout trim of a synchronized stream and opens the WAV sink
+ * that stands in for the I2S on boards without one.
+ */
+static void audio_player_output_start(void)
+{
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    audio_player_cfg.out_frames = 0;
+    if (audio_player_cfg.sync_stream) {
+        audio_sync_stream_start(audio_player_cfg.sync_start_net_us,
+                                SAMPLE_FREQUENCY);
+    }
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_WAV_SINK
+    int64_t start_us = 0;
+
+#ifdef CONFIG_RPR_AUDIO_TIMED_START
+    // The sink timeline starts at the requested instant by construction
+    if (audio_player_cfg.start_pending) {
+        start_us                        = audio_player_cfg.start_at_us;
+        audio_player_cfg.start_pending  = false;
+        audio_player_cfg.start_error_us = 0;
+        audio_player_cfg.start_count++;
+    }
+#endif
+
+    audio_wav_sink_open(
+            CONFIG_RPR_AUDIO_WAV_SINK_PATH, SAMPLE_FREQUENCY, start_us);
+#endif
+}
+
+/**
+ * @brief Completes the output of a file stream.
+ * 
+ * @param stopped true if the stream ended before the end of the file.
+ */
+static void audio_player_output_finish(bool stopped)
+{
+#ifdef CONFIG_I2S
+    audio_player_flush_block(!stopped);
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_WAV_SINK
+    audio_wav_sink_close();
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    if (audio_player_cfg.sync_stream) {
+        audio_sync_stream_stop();
+        audio_player_cfg.sync_stream = false;
+    }
+#endif
+}
+
+/**
+ * @brief Writes the samples in the decoder buffer to the output.
+ *
+ * Trims a synchronized stream, equalizes, duplicates the mono samples to
+ * the output frame and queues them.
+ * 
+ * @param decoded_samples Number of mono samples decoded.
+ * @return true on success, false on failure.
+ */
+static bool audio_player_write_pcm(int decoded_samples)
+{
+    int16_t *pcm_ptr = (int16_t *)DecConfigOpus.pInternalMemory;
+
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    if (audio_player_cfg.sync_stream) {
+#ifdef CONFIG_RPR_AUDIO_WAV_SINK
+        audio_sync_stream_playout(audio_wav_sink_play_time(),
+                                  audio_player_cfg.out_frames);
+#endif
+        decoded_samples = audio_sync_stream_trim(pcm_ptr, decoded_samples);
+    }
+#endif
+
+    audio_player_apply_eq(pcm_ptr, decoded_samples);
+
+#ifdef CONFIG_RPR_AUDIO_WAV_SINK
+    if (audio_wav_sink_write(pcm_ptr, decoded_samples) < 0) {
+        return false;
+    }
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    audio_player_cfg.out_frames += decoded_samples;
+#endif
+#endif
+
+    int samples_remaining = duplicate_samples(pcm_ptr, decoded_samples);
+
+#ifdef CONFIG_I2S
+    if (!audio_player_queue_samples(pcm_ptr, samples_remaining)) {
+        return false;
+    }
+#endif
+
+#ifdef CONFIG_RPR_MEASURING_DECODE_TIME
+    decoded_samples_total += DIV_ROUND_UP(samples_remaining, SAMPLES_PER_BLOCK);
+#endif
+
+    return true;
+}
+
+/**
+ * @brief Decodes an Opus packet and writes PCM data to I2S output.
+ * 
+ * @param data Opus packet.
+ * @param len  Packet length in bytes.
+ * @return true on success, false on failure.
+ */
+static bool audio_player_decode_and_write(const uint8_t *data, size_t len)
+{
+    int decoded_samples = DEC_Opus_Decode(
+            (uint8_t *)data, len, DecConfigOpus.pInternalMemory);
+    if (decoded_samples < 0) {
+        LOG_ERR("Opus decoding error: %d", decoded_samples);
+        return true;
+    }
+
+    return audio_player_write_pcm(decoded_samples);
+}
+
+/**
+ * @brief Releases the Opus decoder and its buffer.
+ */
+static void audio_player_decoder_deinit(void)
+{
+    if (DEC_Opus_IsConfigured()) {
+        DEC_Opus_Deinit();
+    }
+
+    if (DecConfigOpus.pInternalMemory) {
+        free(DecConfigOpus.pInternalMemory);
+        DecConfigOpus.pInternalMemory = NULL;
+    }
+}
+
+/**
+ * @brief Handles STOP and PAUSE/RESUME events during playback.
+ * 
+ * @return true if playback should be stopped, false otherwise.
+ */
+static bool handle_audio_control_events(void)
+{
+    uint32_t new_evt =
+            k_event_wait(&audio_player_cfg.audio_event,
                          AUDIO_EVT_PAUSE | AUDIO_EVT_STOP | AUDIO_EVT_PING,
                          false,
                          K_NO_WAIT);
 
-    if (new_evt & AUDIO_EVT_STOP) {
-        LOG_DBG("Stop event received");
-        return true;
+    if (new_evt & AUDIO_EVT_STOP) {
+        LOG_DBG("Stop event received");
+        return true;
+    }
+
+    if (new_evt & AUDIO_EVT_PAUSE) {
+        LOG_DBG("Pause event received");
+
+#ifdef CONFIG_RPR_AUDIO_SYNC
+        // A paused stream has left the common timeline for good
+        if (audio_player_cfg.sync_stream) {
+            audio_sync_stream_stop();
+            audio_player_cfg.sync_stream = false;
+        }
+#endif
+
+        pause_audio_playback();
+
+        LOG_DBG("Waiting for Resume (START) or Stop (STOP) event...");
+
+        new_evt = k_event_wait(&audio_player_cfg.audio_event,
+                               AUDIO_EVT_START | AUDIO_EVT_STOP,
+                               true,
+                               K_FOREVER);
+
+        if (new_evt & AUDIO_EVT_STOP) {
+            LOG_DBG("Stop event received during pause");
+            return true;
+        }
+
+        if (new_evt & AUDIO_EVT_START) {
+            LOG_DBG("Resume event received");
+            start_audio_playback(AUDIO_COUNT_SILENCE_BLOCK);
+        }
+    }
+
+    if (new_evt & AUDIO_EVT_PING) {
+        k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_PING_REPLY);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Plays the packets of the prepared Ogg demuxer.
+ *
+ * The Opus decoder is set up from the header packet, unless the demuxer
+ * continues behind it.
+ *
+ * @return true if playback was stopped, false at the end of the file.
+ */
+static bool audio_player_ogg_loop(void)
+{
+    struct audio_ogg_packet packet;
+    bool                    stopped = false;
+    int                     ret     = 0;
+
+    while (!stopped && (ret = audio_ogg_next(&ogg_demux, &packet)) > 0) {
+        if (packet.packetno == 0) {
+            stopped = !audio_player_header_and_decoder_init(&packet);
+            continue;
+        }
+
+        // Skip the second packet (OpusTags)
+        if (packet.packetno == 1) {
+            continue;
+        }
+
+        if (!DEC_Opus_IsConfigured()) {
+            LOG_ERR("Opus header packet is missing");
+            stopped = true;
+            break;
+        }
+
+        if (!audio_player_decode_and_write(packet.data, packet.len)) {
+            stopped = true;
+            break;
+        }
+
+        stopped = handle_audio_control_events();
+    }
+
+    if (!stopped && ret < 0) {
+        LOG_ERR("Ogg demuxing failed: %d", ret);
+    }
+
+    return stopped;
+}
+
+/**
+ * @brief Demuxes and plays an Ogg/Opus file.
+ *
+ * @param file Audio file opened at offset 0.
+ * @return true if playback was stopped, false at the end of the file.
+ */
+static bool audio_player_play_ogg(struct fs_file_t *file)
+{
+    bool stopped = true;
+
+    int ret = audio_ogg_init(&ogg_demux,
+                             file,
+                             ogg_buf,
+                             sizeof(ogg_buf),
+                             ogg_packet_buf,
+                             sizeof(ogg_packet_buf));
+    if (ret < 0) {
+        LOG_ERR("Ogg demuxer init failed: %d", ret);
+    } else {
+        stopped = audio_player_ogg_loop();
+    }
+
+    audio_player_decoder_deinit();
+
+    return stopped;
+}
+
+#ifdef CONFIG_RPR_AUDIO_PACKED
+/**
+ * @brief Plays the packets of a container from the reader position.
+ *
+ * Packets are decoded straight from the reader buffer.
+ *
+ * @param reader Reader started on the audio file.
+ * @return true if playback was stopped, false at the end of the file.
+ */
+static bool audio_player_packed_loop(struct audio_packed_reader *reader)
+{
+    const uint8_t *packet;
+    size_t         len;
+    int            ret     = 0;
+    bool           stopped = false;
+
+    while (!stopped && (ret = audio_packed_next(reader, &packet, &len)) > 0) {
+        if (!audio_player_decode_and_write(packet, len)) {
+            stopped = true;
+            break;
+        }
+
+        stopped = handle_audio_control_events();
+    }
+
+    if (!stopped && ret < 0) {
+        LOG_ERR("Container read failed: %d", ret);
+    }
+
+    return stopped;
+}
+
+/**
+ * @brief Plays a pre-packetized container.
+ *
+ * @param reader Reader started on the audio file.
+ * @return true if playback was stopped, false at the end of the file.
+ */
+static bool audio_player_play_packed(struct audio_packed_reader *reader)
+{
+    bool stopped = true;
+
+    LOG_DBG("Container: %u packets, channel: %d",
+            reader->header.packet_count,
+            reader->header.channels);
+
+    if (audio_player_decoder_init()) {
+        stopped = audio_player_packed_loop(reader);
+    }
+
+    audio_player_decoder_deinit();
+
+    return stopped;
+}
+#endif
+
+/**
+ * @brief Plays an opened audio file from its start.
+ *
+ * Containers written by audio_packed are played without the Ogg demuxer,
+ * any other file is played as Ogg/Opus.
+ *
+ * @param file Audio file opened at offset 0.
+ * @return true if playback was stopped, false at the end of the file.
+ */
+static bool audio_player_play_opened(struct fs_file_t *file)
+{
+#ifdef CONFIG_RPR_AUDIO_PACKED
+    if (audio_packed_open(&packed_reader, file) == 0) {
+        return audio_player_play_packed(&packed_reader);
+    }
+#endif
+    return audio_player_play_ogg(file);
+}
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+/**
+ * @brief Opens a cached clip and moves its reader behind the cached head.
+ *
+ * @param head Cache entry of the clip.
+ * @param file File object to open.
+ * @return 0 on success, -ESTALE if the file has changed since it was
+ *         cached, other negative error code otherwise.
+ */
+static int
+audio_player_open_behind_head(const struct audio_head_cache_entry *head,
+                              struct fs_file_t                    *file)
+{
+    int ret = fs_open(file, head->path, FS_O_READ);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = fs_seek(file, 0, FS_SEEK_END);
+    if (ret == 0 && fs_tell(file) != head->size) {
+        return -ESTALE;
+    }
+    if (ret == 0) {
+        ret = fs_seek(file, 0, FS_SEEK_SET);
+    }
+    if (ret < 0) {
+        return ret;
+    }
+
+#ifdef CONFIG_RPR_AUDIO_PACKED
+    if (head->packed) {
+        ret = audio_packed_open(&packed_reader, file);
+        if (ret == 0) {
+            ret = audio_packed_resume(&packed_reader,
+                                      head->resume.offset,
+                                      head->resume.packetno);
+        }
+        return ret;
+    }
+#endif
+
+    ret = audio_ogg_init(&ogg_demux,
+                         file,
+                         ogg_buf,
+                         sizeof(ogg_buf),
+                         ogg_packet_buf,
+                         sizeof(ogg_packet_buf));
+    if (ret == 0) {
+        ret = audio_ogg_resume(&ogg_demux, &head->resume);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Plays a clip whose head is cached in RAM.
+ *
+ * Decoding starts from the cache without touching the flash. The file is
+ * opened once the first packet is queued, so the flash access overlaps
+ * the cached audio, and playback continues from the file behind the head.
+ *
+ * @param head Cache entry of the clip.
+ * @param file File object for the rest of the clip.
+ * @return true if playback was stopped, false at the end of the file.
+ */
+static bool audio_player_play_cached(const struct audio_head_cache_entry *head,
+                                     struct fs_file_t                    *file)
+{
+    const uint8_t *packet;
+    size_t         len;
+    uint32_t       pos     = 0;
+    bool           opened  = head->whole;
+    bool           stopped = false;
+
+    LOG_DBG("Cached head: %u packets, channel: %d",
+            head->packets,
+            head->channels);
+
+    if (!audio_player_decoder_init()) {
+        audio_player_decoder_deinit();
+        return true;
+    }
+
+    while (!stopped && audio_head_cache_next(head, &pos, &packet, &len) > 0) {
+        if (!audio_player_decode_and_write(packet, len)) {
+            stopped = true;
+            break;
+        }
+
+        if (!opened) {
+            opened  = true;
+            int ret = audio_player_open_behind_head(head, file);
+            if (ret == -ESTALE) {
+                audio_head_cache_invalidate(head);
+                audio_player_refresh_head_cache(false);
+            }
+            if (ret < 0) {
+                LOG_ERR("Cannot continue %s from flash: %d", head->path, ret);
+                stopped = true;
+                break;
+            }
+        }
+
+        stopped = handle_audio_control_events();
+    }
+
+    if (!stopped && !head->whole) {
+#ifdef CONFIG_RPR_AUDIO_PACKED
+        if (head->packed) {
+            stopped = audio_player_packed_loop(&packed_reader);
+        } else {
+            stopped = audio_player_ogg_loop();
+        }
+#else
+        stopped = audio_player_ogg_loop();
+#endif
+    }
+
+    audio_player_decoder_deinit();
+
+    return stopped;
+}
+#endif
+
+/**
+ * @brief Plays the audio file selected in the player configuration.
+ *
+ * A clip with a cached head starts from RAM, any other file from flash.
+ */
+static void audio_player_play_file(void)
+{
+    struct fs_file_t file;
+    fs_file_t_init(&file);
+
+    bool stopped;
+
+    if (start_audio_playback(audio_player_wake_preroll()) != PLAYER_OK) {
+        return;
+    }
+
+    bool cached = false;
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+    const struct audio_head_cache_entry *head =
+            audio_head_cache_find(audio_player_cfg.filepath);
+    cached = (head != NULL);
+#endif
+
+    if (!cached && fs_open(&file, audio_player_cfg.filepath, FS_O_READ) < 0) {
+        LOG_ERR("Cannot open audio file: %s", audio_player_cfg.filepath);
+        return;
+    }
+
+    audio_player_eq_stream_start();
+    audio_player_output_start();
+
+#ifdef CONFIG_RPR_MEASURING_DECODE_TIME
+    decoded_samples_total = 0;
+    uint64_t time_stamp   = k_uptime_get();
+#endif
+
+    LOG_INF("Playback start");
+
+#ifndef CONFIG_I2S
+    LOG_WRN("Sound output is disabled");
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+    if (cached) {
+        stopped = audio_player_play_cached(head, &file);
+    } else {
+        stopped = audio_player_play_opened(&file);
+    }
+#else
+    stopped = audio_player_play_opened(&file);
+#endif
+
+#ifdef CONFIG_RPR_MEASURING_DECODE_TIME
+    int64_t delta_time = k_uptime_delta(&time_stamp);
+    LOG_INF("The opus file was decoded in %lld ms", delta_time);
+    LOG_INF("Samples decoded %d", decoded_samples_total);
+#endif
+    audio_player_eq_stream_report();
+    audio_player_output_finish(stopped);
+
+    LOG_INF("Playback finished");
+    stop_audio_playback();
+    fs_close(&file);
+}
+
+#ifdef CONFIG_RPR_AUDIO_TONE_GENERATOR
+/**
+ * @brief Synthesizes one I2S block of the active tone.
+ *
+ * The generator writes mono samples to the head of the block, which are
+ * then spread over the output frame in place.
+ *
+ * @param block Output block of BLOCK_SIZE bytes.
+ */
+static void audio_player_tone_render(int16_t *block)
+{
+    tone_generator_fill(&tone_gen, block, MONO_SAMPLES_PER_BLOCK);
+    audio_player_apply_eq(block, MONO_SAMPLES_PER_BLOCK);
+    duplicate_samples(block, MONO_SAMPLES_PER_BLOCK);
+}
+
+/**
+ * @brief Plays the synthesized tone selected in the player configuration.
+ *
+ * Blocks are generated directly into the I2S memory slab, so nothing is read
+ * from the file system and the first tone block is queued right after the
+ * silence preroll, which depends on the level the codec is woken from.
+ */
+static void audio_player_play_tone(void)
+{
+    uint32_t cycles_max = 0;
+    uint64_t cycles_sum = 0;
+    uint32_t blocks     = 0;
+
+    int ret = tone_generator_init(&tone_gen,
+                                  audio_player_cfg.tone,
+                                  SAMPLE_FREQUENCY,
+                                  audio_player_cfg.tone_duration_ms,
+                                  CONFIG_RPR_AUDIO_TONE_AMPLITUDE);
+    if (ret) {
+        LOG_ERR("Failed to init tone generator: %d", ret);
+        return;
+    }
+
+    audio_player_eq_stream_start();
+
+    if (start_audio_playback(MAX(CONFIG_RPR_AUDIO_TONE_PREROLL_BLOCKS,
+                                 audio_player_wake_preroll())) != PLAYER_OK) {
+        return;
+    }
+
+    LOG_INF("Tone playback start: %s",
+            tone_generator_name(audio_player_cfg.tone));
+
+    while (!tone_generator_is_finished(&tone_gen)) {
+        void    *mem_block;
+        uint32_t cycles;
+
+#ifdef CONFIG_I2S
+        int64_t play_us;
+
+        mem_block = audio_player_alloc_block(&play_us);
+        if (!mem_block) {
+            break;
+        }
+#else
+        mem_block = bench_buf;
+#endif
+
+        cycles = k_cycle_get_32();
+        audio_player_tone_render(mem_block);
+        cycles = k_cycle_get_32() - cycles;
+
+        cycles_sum += cycles;
+        cycles_max = MAX(cycles_max, cycles);
+        blocks++;
+
+#ifdef CONFIG_I2S
+        if (!audio_player_write_block(mem_block)) {
+            break;
+        }
+#else
+        k_usleep(BLOCK_DURATION_US);
+#endif
+
+        if (handle_audio_control_events()) {
+            break;
+        }
+    }
+
+    if (blocks > 0) {
+        LOG_INF("Tone synthesis: %u blocks, avg %u / max %u cycles per block",
+                blocks,
+                (uint32_t)(cycles_sum / blocks),
+                cycles_max);
+    }
+    audio_player_eq_stream_report();
+
+    LOG_INF("Tone playback finished");
+    stop_audio_playback();
+}
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_RTP
+/**
+ * @brief Returns the time in us the output takes to play what is queued.
+ */
+static uint32_t audio_player_output_delay_us(void)
+{
+#if defined(CONFIG_I2S)
+    uint32_t queued = k_mem_slab_num_used_get(&mem_slab);
+
+    // The block being filled is not queued yet
+    if (audio_player_cfg.out_block) {
+        queued--;
+    }
+    return queued * BLOCK_DURATION_US;
+#elif defined(CONFIG_RPR_AUDIO_WAV_SINK)
+    int64_t ahead = audio_wav_sink_play_time() -
+                    k_ticks_to_us_floor64(k_uptime_ticks());
+
+    return (uint32_t)MAX(ahead, 0);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Waits until the output has drained down to the RTP lead.
+ *
+ * Frames are taken from the jitter buffer as late as possible, so the
+ * playout delay is held by the jitter buffer and not by the I2S queue.
+ */
+static void audio_player_rtp_pace(void)
+{
+#if defined(CONFIG_I2S) || defined(CONFIG_RPR_AUDIO_WAV_SINK)
+    uint32_t delay_us = audio_player_output_delay_us();
+
+    if (delay_us > RTP_OUTPUT_LEAD_US) {
+        k_sleep(K_USEC(delay_us - RTP_OUTPUT_LEAD_US));
+    }
+#else
+    k_usleep(DECODER_MS_FRAME * USEC_PER_MSEC);
+#endif
+}
+
+/**
+ * @brief Decodes, rebuilds or conceals one frame of the jitter buffer.
+ * 
+ * @param frame Frame taken from the jitter buffer.
+ * @return Number of decoded samples, negative Opus error code on failure.
+ */
+static int audio_player_rtp_decode(const struct audio_rtp_frame *frame)
+{
+    uint8_t *out     = DecConfigOpus.pInternalMemory;
+    int      samples = MIN(frame->samples, RTP_MAX_SAMPLES);
+
+    switch (frame->kind) {
+    case AUDIO_RTP_FRAME_PACKET:
+        if (frame->data) {
+            return DEC_Opus_Decode((uint8_t *)frame->data, frame->len, out);
+        }
+        break;
+    case AUDIO_RTP_FRAME_FEC:
+        if (frame->data) {
+            return DEC_Opus_DecodeFEC(
+                    (uint8_t *)frame->data, frame->len, out, samples);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return DEC_Opus_Conceal(out, samples);
+}
+
+/**
+ * @brief Plays the live RTP stream on the port selected in the player
+ *        configuration.
+ *
+ * Silence is played while the jitter buffer fills up, then one frame is
+ * decoded each time the output drains to the RTP lead.
+ */
+static void audio_player_play_rtp(void)
+{
+    struct audio_rtp_frame frame;
+    bool                   stopped = false;
+
+    if (audio_rtp_open(audio_player_cfg.rtp_port) < 0) {
+        return;
+    }
+
+    if (!audio_player_decoder_init() ||
+        start_audio_playback(audio_player_wake_preroll()) != PLAYER_OK) {
+        audio_player_decoder_deinit();
+        audio_rtp_close();
+        return;
+    }
+
+    LOG_INF("Waiting for RTP stream on port %u", audio_player_cfg.rtp_port);
+
+    while (!stopped) {
+        audio_player_rtp_pace();
+
+        k_timeout_t timeout = audio_player_cfg.i2s_running ?
+                                      K_NO_WAIT :
+                                      K_USEC(BLOCK_DURATION_US);
+        if (audio_rtp_wait(timeout) == 0) {
+            break;
+        }
+
+        if (audio_player_cfg.i2s_running && !audio_player_feed_silence()) {
+            stopped = true;
+        }
+        if (handle_audio_control_events()) {
+            stopped = true;
+        }
+    }
+
+    bool playing = !stopped;
+
+    if (playing) {
+        LOG_INF("RTP playback start");
+        audio_player_eq_stream_start();
+        audio_player_output_start();
+    }
+
+    while (!stopped) {
+        audio_player_rtp_pace();
+
+        audio_rtp_next(&frame);
+        if (frame.kind == AUDIO_RTP_FRAME_NONE) {
+            LOG_INF("RTP talker went silent");
+            break;
+        }
+
+        uint32_t output_us       = audio_player_output_delay_us();
+        int      decoded_samples = audio_player_rtp_decode(&frame);
+
+        audio_rtp_frame_done(&frame, output_us);
+
+        if (decoded_samples < 0) {
+            LOG_ERR("Opus decoding error: %d", decoded_samples);
+            decoded_samples = DEC_Opus_Conceal(DecConfigOpus.pInternalMemory,
+                                               RTP_MAX_SAMPLES);
+        }
+
+        if (decoded_samples > 0 && !audio_player_write_pcm(decoded_samples)) {
+            stopped = true;
+        }
+        if (handle_audio_control_events()) {
+            stopped = true;
+        }
+    }
+
+    if (playing) {
+        audio_player_eq_stream_report();
+        audio_player_output_finish(stopped);
+    }
+
+    LOG_INF("RTP playback finished");
+    stop_audio_playback();
+    audio_rtp_close();
+    audio_player_decoder_deinit();
+}
+#endif
+
+/**
+ * @brief Audio playback thread function. Waits for start event and processes Opus data.
+ */
+static void audio_thread_func(void)
+{
+    k_event_init(&audio_player_cfg.audio_event);
+    if (audio_player_init() != PLAYER_OK) {
+        LOG_ERR("Failed to initialize audio player");
+    }
+
+#ifdef CONFIG_RPR_AUDIO_EQ
+    if (audio_eq_load(CONFIG_RPR_AUDIO_EQ_PROFILE_PATH) < 0) {
+        LOG_INF("No EQ profile, output is not equalized");
+    }
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+    k_work_init_delayable(&audio_player_cfg.head_cache_check,
+                          audio_player_head_cache_timer);
+    audio_player_refresh_head_cache(true);
+#if CONFIG_RPR_AUDIO_HEAD_CACHE_CHECK_S > 0
+    k_work_schedule(&audio_player_cfg.head_cache_check,
+                    K_SECONDS(CONFIG_RPR_AUDIO_HEAD_CACHE_CHECK_S));
+#endif
+#endif
+
+    while (1) {
+        uint32_t evt = audio_player_idle_wait();
+
+        if (evt & AUDIO_EVT_START) {
+            audio_player_set_power_state(AUDIO_POWER_ACTIVE);
+
+            switch (audio_player_cfg.stream_type) {
+#ifdef CONFIG_RPR_AUDIO_TONE_GENERATOR
+            case AUDIO_STREAM_TONE:
+                audio_player_play_tone();
+                break;
+#endif
+#ifdef CONFIG_RPR_AUDIO_RTP
+            case AUDIO_STREAM_RTP:
+                audio_player_play_rtp();
+                break;
+#endif
+            case AUDIO_STREAM_FILE:
+            default:
+                audio_player_play_file();
+                break;
+            }
+#ifdef CONFIG_RPR_AUDIO_TIMED_START
+            audio_player_cfg.start_pending = false;
+#endif
+        }
+
+        k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_PING_STOP);
+        audio_player_idle_sleep(AUDIO_IDLE_SLEEP_MS);
+    }
+}
+
+/**
+ * @brief Checks that the player is ready and not busy with another stream.
+ * 
+ * @return PLAYER_OK if a new stream can be started, error code otherwise.
+ */
+static player_status_t audio_player_check_idle(void)
+{
+    if (!audio_player_cfg.is_codec_ready) {
+        LOG_ERR("Device is not ready");
+        return PLAYER_ERROR_CODEC_INIT;
+    }
+
+    if (audio_player_cfg.is_sound_playing) {
+        LOG_ERR("Device is busy");
+        return PLAYER_ERROR_BUSY;
+    }
+
+    return PLAYER_OK;
+}
+
+/**
+ * @brief Wakes the codec and hands the selected stream to the audio thread.
+ * 
+ * @param type Stream type to play.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+static player_status_t audio_player_request_stream(audio_stream_type_t type)
+{
+    audio_player_cfg.request_cycles = k_cycle_get_32();
+
+    // Released here, the codec wakes up while the audio thread is scheduled
+    if (audio_player_cfg.power_state == AUDIO_POWER_STANDBY) {
+        int ret = gpio_pin_set_dt(&audio_player_cfg.codec_standby_gpio,
+                                  CODEC_ENABLE_VALUE);
+        if (ret != 0) {
+            LOG_ERR("Failed to enable codec GPIO (err %d)", ret);
+            return PLAYER_ERROR_GPIO_SET;
+        }
+    }
+
+    audio_player_cfg.stream_type = type;
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+    audio_player_cfg.recovery_streak = 0;
+#endif
+
+    k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_START);
+    return PLAYER_OK;
+}
+
+/**
+ * @brief Checks the file path and hands the file stream to the audio thread.
+ * 
+ * @param filepath     Full path to the Opus audio file to play.
+ * @param start_us     Uptime in us the audio must start at, 0 to start at
+ *                     once.
+ * @param net_start_us Network time matching start_us for a synchronized
+ *                     stream, 0 otherwise.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+static player_status_t audio_player_request_file(const char *filepath,
+                                                 int64_t     start_us,
+                                                 int64_t     net_start_us)
+{
+    player_status_t status = audio_player_check_idle();
+    if (status != PLAYER_OK) {
+        return status;
+    }
+
+    if (!filepath) {
+        LOG_ERR("Filepath is empty");
+        return PLAYER_EMPTY_DATA;
     }
 
-    if (new_evt & AUDIO_EVT_PAUSE) {
-        LOG_DBG("Pause event received");
+    if (strlen(filepath) >= FULL_AUDIO_PATH_MAX_LEN) {
+        LOG_ERR("Audio path is too long");
+        return PLAYER_ERROR_INVALID_PARAM;
+    }
 
-        pause_audio_playback();
+    strncpy(audio_player_cfg.filepath,
+            filepath,
+            sizeof(audio_player_cfg.filepath) - 1);
+    audio_player_cfg.filepath[sizeof(audio_player_cfg.filepath) - 1] = '\0';
 
-        LOG_DBG("Waiting for Resume (START) or Stop (STOP) event...");
+#ifdef CONFIG_RPR_AUDIO_TIMED_START
+    audio_player_cfg.start_at_us   = start_us;
+    audio_player_cfg.start_pending = (start_us > 0);
+#endif
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    audio_player_cfg.sync_stream       = (net_start_us > 0);
+    audio_player_cfg.sync_start_net_us = net_start_us;
+#endif
 
-        new_evt = k_event_wait(&audio_player_cfg.audio_event,
-                               AUDIO_EVT_START | AUDIO_EVT_STOP,
-                               true,
-                               K_FOREVER);
+    return audio_player_request_stream(AUDIO_STREAM_FILE);
+}
 
-        if (new_evt & AUDIO_EVT_STOP) {
-            LOG_DBG("Stop event received during pause");
-            return true;
-        }
+/**
+ * @brief Starts playback of an Opus audio stream.
+ * 
+ * @param filepath Full path to the Opus audio file to play.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t audio_player_start(const char *filepath)
+{
+    return audio_player_request_file(filepath, 0, 0);
+}
 
-        if (new_evt & AUDIO_EVT_START) {
-            LOG_DBG("Resume event received");
-            start_audio_playback();
-        }
+#ifdef CONFIG_RPR_AUDIO_TIMED_START
+/**
+ * @brief Starts playback of an Opus file so that it is heard at a given time.
+ *
+ * The stream is prepared right away: the codec is woken, the file opened,
+ * the decoder initialized and the first packet decoded. The first block is
+ * then held back until the start time while the I2S plays silence. Call
+ * this at least the codec wake-up time plus the file open time ahead.
+ * 
+ * @param filepath Full path to the Opus audio file to play.
+ * @param start_us System uptime in microseconds the audio must start at.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t audio_player_start_at(const char *filepath, int64_t start_us)
+{
+    if (start_us <= 0) {
+        return PLAYER_ERROR_INVALID_PARAM;
     }
 
-    if (new_evt & AUDIO_EVT_PING) {
-        k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_PING_REPLY);
+    return audio_player_request_file(filepath, start_us, 0);
+}
+
+/**
+ * @brief Gets the timing error of the last scheduled start.
+ * 
+ * @param error_us Pointer to store the error in us, positive if late.
+ * @return Number of scheduled starts since boot.
+ */
+uint32_t audio_player_get_start_error(int32_t *error_us)
+{
+    if (error_us) {
+        *error_us = audio_player_cfg.start_error_us;
     }
 
-    return false;
+    return audio_player_cfg.start_count;
 }
+#endif
 
+#ifdef CONFIG_RPR_AUDIO_SYNC
 /**
- * @brief Audio playback thread function. Waits for start event and processes Opus data.
+ * @brief Starts playback of an Opus file at a network time.
+ *
+ * Speakers given the same file and time start it together. The start is
+ * mapped to the local clock through the SNTP discipline and the playout
+ * is trimmed against the network clock while the stream plays.
+ * 
+ * @param filepath     Full path to the Opus audio file to play.
+ * @param net_start_us Network (Unix epoch) time in microseconds.
+ * @return PLAYER_OK on success, PLAYER_ERROR_INVALID_PARAM if the clock is
+ *         not synchronized or the time has passed, error code otherwise.
  */
-static void audio_thread_func(void)
+player_status_t audio_player_start_synced(const char *filepath,
+                                          int64_t     net_start_us)
 {
-    k_event_init(&audio_player_cfg.audio_event);
-    if (audio_player_init() != PLAYER_OK) {
-        LOG_ERR("Failed to initialize audio player");
+    int64_t start_us;
+
+    if (audio_sync_to_local(net_start_us, &start_us) < 0) {
+        LOG_ERR("Network clock is not synchronized");
+        return PLAYER_ERROR_INVALID_PARAM;
     }
 
-    while (1) {
-        uint32_t evt = k_event_wait(&audio_player_cfg.audio_event,
-                                    AUDIO_EVT_START | AUDIO_EVT_PING,
-                                    true,
-                                    K_FOREVER);
+    if (start_us <= k_ticks_to_us_floor64(k_uptime_ticks())) {
+        LOG_ERR("Start time has passed");
+        return PLAYER_ERROR_INVALID_PARAM;
+    }
 
-        if (evt & AUDIO_EVT_START) {
+    return audio_player_request_file(filepath, start_us, net_start_us);
+}
+#endif
 
-            ogg_sync_state   oy;
-            ogg_page         og;
-            ogg_packet       op;
-            ogg_stream_state os;
+#ifdef CONFIG_RPR_AUDIO_RTP
+/**
+ * @brief Starts playing a live RTP/Opus stream received on a UDP port.
+ *
+ * The I2S keeps running with silence until the first talker fills the
+ * jitter buffer. The stream ends when the talker has been silent for
+ * CONFIG_RPR_AUDIO_RTP_IDLE_TIMEOUT_MS, or with audio_player_stop().
+ * 
+ * @param port UDP port to listen on, 0 for CONFIG_RPR_AUDIO_RTP_PORT.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t audio_player_start_rtp(uint16_t port)
+{
+    player_status_t status = audio_player_check_idle();
+    if (status != PLAYER_OK) {
+        return status;
+    }
 
-            struct fs_file_t file;
-            fs_file_t_init(&file);
+    audio_player_cfg.rtp_port = port ? port : CONFIG_RPR_AUDIO_RTP_PORT;
 
-            ogg_sync_init(&oy);
+#ifdef CONFIG_RPR_AUDIO_TIMED_START
+    audio_player_cfg.start_pending = false;
+#endif
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    audio_player_cfg.sync_stream = false;
+#endif
 
-            bool first_packet_skipped = false;
-            bool stopped              = false;
+    return audio_player_request_stream(AUDIO_STREAM_RTP);
+}
+#endif
 
-            if (start_audio_playback() != PLAYER_OK) {
-                continue;
-            }
+#ifdef CONFIG_RPR_AUDIO_TONE_GENERATOR
+/**
+ * @brief Starts playback of a synthesized siren or test tone.
+ * 
+ * @param tone        Tone or siren pattern to play.
+ * @param duration_ms Tone duration in milliseconds, 0 to play until stopped.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t audio_player_start_tone(audio_tone_t tone, uint32_t duration_ms)
+{
+    player_status_t status = audio_player_check_idle();
+    if (status != PLAYER_OK) {
+        return status;
+    }
 
-            if (fs_open(&file, audio_player_cfg.filepath, FS_O_READ) < 0) {
-                LOG_ERR("Cannot open audio file: %s",
-                        audio_player_cfg.filepath);
-                continue;
-            }
+    if (tone >= AUDIO_TONE_COUNT) {
+        LOG_ERR("Unknown tone %d", tone);
+        return PLAYER_ERROR_INVALID_PARAM;
+    }
 
-#ifdef CONFIG_RPR_MEASURING_DECODE_TIME
-            decoded_samples_total = 0;
-            uint64_t time_stamp   = k_uptime_get();
-#endif
+    audio_player_cfg.tone             = tone;
+    audio_player_cfg.tone_duration_ms = duration_ms;
 
-            LOG_INF("Playback start");
+    return audio_player_request_stream(AUDIO_STREAM_TONE);
+}
 
-#ifndef CONFIG_I2S
-            LOG_WRN("Sound output is disabled");
-#endif
+/**
+ * @brief Measures the CPU cost of tone synthesis without touching the I2S.
+ *
+ * Renders the requested number of blocks into a scratch buffer and reports
+ * the cycle count per block against the real-time budget of one block.
+ * 
+ * @param tone   Tone or siren pattern to render.
+ * @param blocks Number of blocks to render.
+ * @param result Pointer to store the measurement.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t
+audio_player_tone_benchmark(audio_tone_t                  tone,
+                            uint32_t                      blocks,
+                            struct audio_block_benchmark *result)
+{
+    struct tone_generator gen;
+    uint64_t              cycles_sum = 0;
+
+    if (!result || blocks == 0) {
+        return PLAYER_ERROR_INVALID_PARAM;
+    }
 
-            while (!stopped) {
-                char   *buffer   = ogg_sync_buffer(&oy, OGG_CHUNK_SIZE);
-                ssize_t read_len = fs_read(&file, buffer, OGG_CHUNK_SIZE);
+    if (tone_generator_init(&gen,
+                            tone,
+                            SAMPLE_FREQUENCY,
+                            0,
+                            CONFIG_RPR_AUDIO_TONE_AMPLITUDE)) {
+        return PLAYER_ERROR_INVALID_PARAM;
+    }
 
-                if (read_len <= 0) {
-                    break;
-                }
+    memset(result, 0, sizeof(*result));
+    result->cycles_min = UINT32_MAX;
 
-                ogg_sync_wrote(&oy, read_len);
-
-                while (ogg_sync_pageout(&oy, &og) == 1 && !stopped) {
-                    if (!audio_player_cfg.is_stream_init) {
-                        if (!audio_player_stream_and_decoder_init(
-                                    &oy, &os, &og, &op)) {
-                            stopped = true;
-                        }
-                        continue;
-                    }
-
-                    ogg_stream_pagein(&os, &og);
-                    while (ogg_stream_packetout(&os, &op) == 1 && !stopped) {
-                        // Skip the first packet (OpusTags)
-                        if (!first_packet_skipped) {
-                            first_packet_skipped = true;
-                            continue;
-                        }
-
-                        if (!audio_player_decode_and_write(&op)) {
-                            stopped = true;
-                            break;
-                        }
-                        if (handle_audio_control_events()) {
-                            stopped = true;
-                            break;
-                        }
-                    }
-                }
-            }
+    for (uint32_t i = 0; i < blocks; i++) {
+        uint32_t cycles = k_cycle_get_32();
 
-#ifdef CONFIG_RPR_MEASURING_DECODE_TIME
-            int64_t delta_time = k_uptime_delta(&time_stamp);
-            LOG_INF("The opus file was decoded in %lld ms", delta_time);
-            LOG_INF("Samples decoded %d", decoded_samples_total);
-#endif
+        tone_generator_fill(&gen, bench_buf, MONO_SAMPLES_PER_BLOCK);
+        duplicate_samples(bench_buf, MONO_SAMPLES_PER_BLOCK);
 
-            LOG_INF("Playback finished");
-            stop_audio_playback();
-            fs_close(&file);
-            audio_player_cleanup(&os, &oy);
-        }
+        cycles = k_cycle_get_32() - cycles;
 
-        k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_PING_STOP);
-        k_msleep(100);
+        cycles_sum += cycles;
+        result->cycles_min = MIN(result->cycles_min, cycles);
+        result->cycles_max = MAX(result->cycles_max, cycles);
     }
+
+    result->blocks              = blocks;
+    result->cycles_avg          = (uint32_t)(cycles_sum / blocks);
+    result->block_duration_us   = BLOCK_DURATION_US;
+    result->block_budget_cycles = audio_player_block_budget_cycles();
+
+    return PLAYER_OK;
 }
+#endif
 
+#ifdef CONFIG_RPR_AUDIO_EQ
 /**
- * @brief Starts playback of an Opus audio stream.
+ * @brief Checks and measures the speaker-correction EQ on one I2S block.
+ *
+ * The optimized kernel is first compared with the portable reference, then
+ * the active profile is timed on pseudo-random blocks. The filter history
+ * is reset afterwards, so the player must be idle.
  * 
- * @param filepath Full path to the Opus audio file to play.
+ * @param blocks    Number of blocks to process.
+ * @param result    Pointer to store the measurement.
+ * @param bit_exact Pointer to store the result of the reference comparison.
  * @return PLAYER_OK on success, error code otherwise.
  */
-player_status_t audio_player_start(const char *filepath)
+player_status_t
+audio_player_eq_benchmark(uint32_t                      blocks,
+                          struct audio_block_benchmark *result,
+                          bool                         *bit_exact)
 {
-    if (!audio_player_cfg.is_codec_ready) {
-        LOG_ERR("Device is not ready");
-        return PLAYER_ERROR_CODEC_INIT;
+    uint64_t cycles_sum = 0;
+    uint32_t seed       = 1;
+
+    if (!result || !bit_exact || blocks == 0) {
+        return PLAYER_ERROR_INVALID_PARAM;
     }
 
     if (audio_player_cfg.is_sound_playing) {
-        LOG_ERR("Device is busy");
         return PLAYER_ERROR_BUSY;
     }
 
-    if (!filepath) {
-        LOG_ERR("Filepath is empty");
-        return PLAYER_EMPTY_DATA;
-    }
+    size_t mismatch = audio_eq_selftest(
+            bench_buf, eq_ref_buf, MONO_SAMPLES_PER_BLOCK, blocks);
+    *bit_exact = (mismatch == 0);
 
-    if (strlen(filepath) >= FULL_AUDIO_PATH_MAX_LEN) {
-        LOG_ERR("Audio path is too long");
-        return PLAYER_ERROR_INVALID_PARAM;
-    }
+    memset(result, 0, sizeof(*result));
+    result->cycles_min = UINT32_MAX;
 
-#ifdef CONFIG_RPR_AUDIO_ENABLE_STANDBY_WHEN_IDLE
-    int ret = gpio_pin_set_dt(&audio_player_cfg.codec_standby_gpio,
-                              CODEC_ENABLE_VALUE);
-    if (ret != 0) {
-        LOG_ERR("Failed to enable codec GPIO (err %d)", ret);
-        return PLAYER_ERROR_GPIO_SET;
+    for (uint32_t i = 0; i < blocks; i++) {
+        for (size_t j = 0; j < MONO_SAMPLES_PER_BLOCK; j++) {
+            seed         = seed * 1664525u + 1013904223u;
+            bench_buf[j] = (int16_t)(seed >> 16);
+        }
+
+        uint32_t cycles = k_cycle_get_32();
+        audio_eq_process(bench_buf, MONO_SAMPLES_PER_BLOCK);
+        cycles = k_cycle_get_32() - cycles;
+
+        cycles_sum += cycles;
+        result->cycles_min = MIN(result->cycles_min, cycles);
+        result->cycles_max = MAX(result->cycles_max, cycles);
     }
-#endif
 
-    strncpy(audio_player_cfg.filepath,
-            filepath,
-            sizeof(audio_player_cfg.filepath) - 1);
-    audio_player_cfg.filepath[sizeof(audio_player_cfg.filepath) - 1] = '\0';
+    audio_eq_reset();
+
+    result->blocks              = blocks;
+    result->cycles_avg          = (uint32_t)(cycles_sum / blocks);
+    result->block_duration_us   = BLOCK_DURATION_US;
+    result->block_budget_cycles = audio_player_block_budget_cycles();
 
-    k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_START);
     return PLAYER_OK;
 }
+#endif
 
 /**
  * @brief Pauses or resumes playback.
@@ -1009,6 +2851,11 @@ bool get_pause_status(void)
  */
 player_status_t codec_enable(void)
 {
+    if (audio_player_cfg.is_codec_ready) {
+        // Already configured, the codec is kept at the idle level
+        LOG_DBG("Audio codec is already enabled");
+        return PLAYER_OK;
+    }
 
     if (!gpio_is_ready_dt(&audio_player_cfg.codec_standby_gpio)) {
         LOG_ERR("Codec standby GPIO not ready");
@@ -1030,6 +2877,8 @@ player_status_t codec_enable(void)
         return init_result;
     }
 
+    k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_STANDBY);
+
     LOG_DBG("Audio codec ENABLED and initialized");
     return PLAYER_OK;
 }
@@ -1065,6 +2914,7 @@ player_status_t codec_disable(void)
     }
 
     audio_player_cfg.is_codec_ready = false;
+    k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_STANDBY);
 
     LOG_DBG("Audio codec DISABLED");
     return PLAYER_OK;
@@ -1087,4 +2937,196 @@ uint32_t audio_player_ping(void)
                                    K_MSEC(CODEC_PING_TIME_MS));
 
     return result;
-}
\ No newline at end of file
+}
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+/**
+ * @brief Asks the audio thread to reload the head cache of changed clips.
+ * 
+ * @param force Reload even if the audio directory looks unchanged.
+ */
+void audio_player_refresh_head_cache(bool force)
+{
+    if (force) {
+        audio_player_cfg.head_cache_force = true;
+    }
+
+    k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_CACHE);
+}
+#endif
+
+/**
+ * @brief Gets the audio thread stack size and its deepest use so far.
+ *
+ * @param size Pointer to store the stack size.
+ * @param used Pointer to store the high-water mark.
+ * @return 0 on success, -ENOTSUP without CONFIG_RPR_AUDIO_STACK_REPORT,
+ *         other negative error code otherwise.
+ */
+int audio_player_get_stack_usage(size_t *size, size_t *used)
+{
+    if (!size || !used) {
+        return -EINVAL;
+    }
+
+#ifdef CONFIG_RPR_AUDIO_STACK_REPORT
+    size_t unused;
+
+    int ret = k_thread_stack_space_get(audio_thread_id, &unused);
+    if (ret < 0) {
+        return ret;
+    }
+
+    *size = audio_thread_id->stack_info.size;
+    *used = *size - unused;
+
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
+
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+/**
+ * @brief Copies the most recent I2S recovery events, newest first.
+ * 
+ * @param events     Array to store the events.
+ * @param max_events Size of the array.
+ * @param total      Pointer to store the number of recoveries since boot,
+ *                   may be NULL.
+ * @return Number of events copied.
+ */
+size_t audio_player_get_recovery_events(struct audio_recovery_event *events,
+                                        size_t                       max_events,
+                                        uint32_t                    *total)
+{
+    size_t count;
+
+    k_mutex_lock(&recovery_log_lock, K_FOREVER);
+
+    count = MIN(max_events,
+                MIN(recovery_log.total, CONFIG_RPR_AUDIO_RECOVERY_LOG_SIZE));
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t idx = (recovery_log.total - 1 - i) %
+                       CONFIG_RPR_AUDIO_RECOVERY_LOG_SIZE;
+        events[i] = recovery_log.events[idx];
+    }
+
+    if (total) {
+        *total = recovery_log.total;
+    }
+
+    k_mutex_unlock(&recovery_log_lock);
+
+    return count;
+}
+#endif
+
+/**
+ * @brief Selects the level the codec is kept at between streams.
+ *
+ * After `timeout_ms` without playback the codec drops to the deepest
+ * allowed level (standby with CONFIG_RPR_AUDIO_ENABLE_STANDBY_WHEN_IDLE,
+ * warm otherwise).
+ * 
+ * @param state      AUDIO_POWER_CLOCKED, AUDIO_POWER_WARM or
+ *                   AUDIO_POWER_STANDBY.
+ * @param timeout_ms Idle time before stepping down, 0 to stay at the level.
+ * @return PLAYER_OK on success, PLAYER_ERROR_INVALID_PARAM otherwise.
+ */
+player_status_t audio_player_set_idle_policy(audio_power_state_t state,
+                                             uint32_t            timeout_ms)
+{
+    if (state == AUDIO_POWER_ACTIVE || state > AUDIO_DEEPEST_IDLE_STATE) {
+        LOG_ERR("Idle level %s is not available",
+                audio_player_power_state_name(state));
+        return PLAYER_ERROR_INVALID_PARAM;
+    }
+
+    audio_player_cfg.idle_state      = state;
+    audio_player_cfg.idle_timeout_ms = timeout_ms;
+
+    k_event_post(&audio_player_cfg.audio_event, AUDIO_EVT_STANDBY);
+
+    return PLAYER_OK;
+}
+
+/**
+ * @brief Gets the current idle policy.
+ * 
+ * @param state      Pointer to store the idle level.
+ * @param timeout_ms Pointer to store the step-down timeout.
+ */
+void audio_player_get_idle_policy(audio_power_state_t *state,
+                                  uint32_t            *timeout_ms)
+{
+    if (state) {
+        *state = audio_player_cfg.idle_state;
+    }
+    if (timeout_ms) {
+        *timeout_ms = audio_player_cfg.idle_timeout_ms;
+    }
+}
+
+/**
+ * @brief Gets the time spent in every power state and the wake latencies.
+ * 
+ * @param stats Pointer to store the statistics.
+ */
+void audio_player_get_power_stats(struct audio_power_stats *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    k_mutex_lock(&power_log_lock, K_FOREVER);
+    *stats = power_log.stats;
+    stats->residency_ms[stats->state] +=
+            k_uptime_get() - audio_player_cfg.state_since_ms;
+    for (int i = 0; i < AUDIO_POWER_STATE_COUNT; i++) {
+        if (stats->wake[i].count > 0) {
+            stats->wake[i].avg_us = (uint32_t)(power_log.wake_sum_us[i] /
+                                               stats->wake[i].count);
+        }
+    }
+    k_mutex_unlock(&power_log_lock);
+}
+
+/**
+ * @brief Returns the printable name of a power state.
+ * 
+ * @param state Power state.
+ * @return State name, or "unknown".
+ */
+const char *audio_player_power_state_name(audio_power_state_t state)
+{
+    if (state >= AUDIO_POWER_STATE_COUNT) {
+        return "unknown";
+    }
+
+    return power_state_names[state];
+}
+
+/**
+ * @brief Parses a power state name ("clocked", "warm", "standby").
+ * 
+ * @param name  State name.
+ * @param state Pointer to store the parsed state.
+ * @return 0 on success, -EINVAL if the name is unknown.
+ */
+int audio_player_parse_power_state(const char *name, audio_power_state_t *state)
+{
+    if (!name || !state) {
+        return -EINVAL;
+    }
+
+    for (int i = AUDIO_POWER_CLOCKED; i < AUDIO_POWER_STATE_COUNT; i++) {
+        if (strcmp(name, power_state_names[i]) == 0) {
+            *state = (audio_power_state_t)i;
+            return 0;
+        }
+    }
+
+    return -EINVAL;
+}
@@ -16,10 +16,44 @@
 #ifndef AUDIO_PLAYER_H_
 #define AUDIO_PLAYER_H_
 
+#ifdef CONFIG_RPR_AUDIO_TONE_GENERATOR
+#include "tone_generator.h"
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_EQ
+#include "audio_eq.h"
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_SCHEDULE
+#include "audio_schedule.h"
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_SYNC
+#include "audio_sync.h"
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_WAV_SINK
+#include "audio_wav_sink.h"
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_RTP
+#include "audio_rtp.h"
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_PACKED
+#include "audio_packed.h"
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+#include "audio_head_cache.h"
+#endif
+
 #define AUDIO_EVT_START BIT(0)
 #define AUDIO_EVT_STOP  BIT(1)
 #define AUDIO_EVT_PAUSE BIT(2)
 #define AUDIO_EVT_PING       BIT(4)
+#define AUDIO_EVT_STANDBY    BIT(5)
+#define AUDIO_EVT_CACHE      BIT(6)
 #define AUDIO_EVT_PING_REPLY BIT(8)
 #define AUDIO_EVT_PING_STOP  BIT(16)
 
@@ -55,6 +89,53 @@ typedef enum {
     PLAYER_ERROR_CODEC_STOP
 } player_status_t;
 
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+typedef enum {
+    AUDIO_RECOVERY_WRITE_ERROR = 0,
+    AUDIO_RECOVERY_STALL,
+} audio_recovery_cause_t;
+
+struct audio_recovery_event {
+    int64_t                timestamp_ms;   /* Uptime of the failure */
+    audio_recovery_cause_t cause;
+    int                    error;          /* Error of the failing call */
+    uint32_t               duration_us;    /* Time to restart the stream */
+    uint16_t               silence_blocks; /* Blocks primed before resuming */
+    bool                   success;
+};
+#endif
+
+typedef enum {
+    AUDIO_POWER_ACTIVE = 0, /* Stream is playing */
+    AUDIO_POWER_CLOCKED,    /* Codec muted, I2S clocked with silence */
+    AUDIO_POWER_WARM,       /* Codec configured and muted, I2S stopped */
+    AUDIO_POWER_STANDBY,    /* Codec standby pin asserted */
+    AUDIO_POWER_STATE_COUNT
+} audio_power_state_t;
+
+struct audio_wake_stats {
+    uint32_t count;
+    uint32_t last_us; /* Request to first stream sample at the output */
+    uint32_t avg_us;
+    uint32_t max_us;
+};
+
+struct audio_power_stats {
+    audio_power_state_t     state;
+    uint64_t                residency_ms[AUDIO_POWER_STATE_COUNT];
+    uint32_t                entries[AUDIO_POWER_STATE_COUNT];
+    struct audio_wake_stats wake[AUDIO_POWER_STATE_COUNT]; /* By level */
+};
+
+struct audio_block_benchmark {
+    uint32_t blocks;
+    uint32_t cycles_min;
+    uint32_t cycles_avg;
+    uint32_t cycles_max;
+    uint32_t block_budget_cycles; /* Cycles available for one I2S block */
+    uint32_t block_duration_us;
+};
+
 /**
  * @brief Sets the output volume of the audio codec.
  * 
@@ -79,6 +160,118 @@ player_status_t audio_player_set_mute(bool mute);
  */
 player_status_t audio_player_start(const char *filepath);
 
+#ifdef CONFIG_RPR_AUDIO_TIMED_START
+/**
+ * @brief Starts playback of an Opus file so that it is heard at a given time.
+ *
+ * The stream is prepared right away: the codec is woken, the file opened,
+ * the decoder initialized and the first packet decoded. The first block is
+ * then held back until the start time while the I2S plays silence. Call
+ * this at least the codec wake-up time plus the file open time ahead.
+ * 
+ * @param filepath Full path to the Opus audio file to play.
+ * @param start_us System uptime in microseconds the audio must start at.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t audio_player_start_at(const char *filepath, int64_t start_us);
+
+/**
+ * @brief Gets the timing error of the last scheduled start.
+ * 
+ * @param error_us Pointer to store the error in us, positive if late.
+ * @return Number of scheduled starts since boot.
+ */
+uint32_t audio_player_get_start_error(int32_t *error_us);
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_SYNC
+/**
+ * @brief Starts playback of an Opus file at a network time.
+ *
+ * Speakers given the same file and time start it together. The start is
+ * mapped to the local clock through the SNTP discipline and the playout
+ * is trimmed against the network clock while the stream plays.
+ * 
+ * @param filepath     Full path to the Opus audio file to play.
+ * @param net_start_us Network (Unix epoch) time in microseconds.
+ * @return PLAYER_OK on success, PLAYER_ERROR_INVALID_PARAM if the clock is
+ *         not synchronized or the time has passed, error code otherwise.
+ */
+player_status_t audio_player_start_synced(const char *filepath,
+                                          int64_t     net_start_us);
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_RTP
+/**
+ * @brief Starts playing a live RTP/Opus stream received on a UDP port.
+ *
+ * The I2S keeps running with silence until the first talker fills the
+ * jitter buffer. The stream ends when the talker has been silent for
+ * CONFIG_RPR_AUDIO_RTP_IDLE_TIMEOUT_MS, or with audio_player_stop().
+ * 
+ * @param port UDP port to listen on, 0 for CONFIG_RPR_AUDIO_RTP_PORT.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t audio_player_start_rtp(uint16_t port);
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+/**
+ * @brief Asks the audio thread to reload the head cache of changed clips.
+ *
+ * The reload runs between streams, with the playback buffers.
+ * 
+ * @param force Reload even if the audio directory looks unchanged.
+ */
+void audio_player_refresh_head_cache(bool force);
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_TONE_GENERATOR
+/**
+ * @brief Starts playback of a synthesized siren or test tone.
+ * 
+ * @param tone        Tone or siren pattern to play.
+ * @param duration_ms Tone duration in milliseconds, 0 to play until stopped.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t audio_player_start_tone(audio_tone_t tone, uint32_t duration_ms);
+
+/**
+ * @brief Measures the CPU cost of tone synthesis without touching the I2S.
+ *
+ * Renders the requested number of blocks into a scratch buffer and reports
+ * the cycle count per block against the real-time budget of one block.
+ * 
+ * @param tone   Tone or siren pattern to render.
+ * @param blocks Number of blocks to render.
+ * @param result Pointer to store the measurement.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t
+audio_player_tone_benchmark(audio_tone_t                  tone,
+                            uint32_t                      blocks,
+                            struct audio_block_benchmark *result);
+#endif
+
+#ifdef CONFIG_RPR_AUDIO_EQ
+/**
+ * @brief Checks and measures the speaker-correction EQ on one I2S block.
+ *
+ * The optimized kernel is first compared with the portable reference, then
+ * the active profile is timed on pseudo-random blocks. The filter history
+ * is reset afterwards, so the player must be idle.
+ * 
+ * @param blocks    Number of blocks to process.
+ * @param result    Pointer to store the measurement.
+ * @param bit_exact Pointer to store the result of the reference comparison.
+ * @return PLAYER_OK on success, error code otherwise.
+ */
+player_status_t
+audio_player_eq_benchmark(uint32_t                      blocks,
+                          struct audio_block_benchmark *result,
+                          bool                         *bit_exact);
+#endif
+
 /**
  * @brief Stops current audio playback.
  * 
@@ -147,4 +340,77 @@ player_status_t codec_disable(void);
  */
 uint32_t audio_player_ping(void);
 
+/**
+ * @brief Gets the audio thread stack size and its deepest use so far.
+ *
+ * @param size Pointer to store the stack size.
+ * @param used Pointer to store the high-water mark.
+ * @return 0 on success, -ENOTSUP without CONFIG_RPR_AUDIO_STACK_REPORT,
+ *         other negative error code otherwise.
+ */
+int audio_player_get_stack_usage(size_t *size, size_t *used);
+
+/**
+ * @brief Selects the level the codec is kept at between streams.
+ *
+ * After `timeout_ms` without playback the codec drops to the deepest
+ * allowed level (standby with CONFIG_RPR_AUDIO_ENABLE_STANDBY_WHEN_IDLE,
+ * warm otherwise).
+ * 
+ * @param state      AUDIO_POWER_CLOCKED, AUDIO_POWER_WARM or
+ *                   AUDIO_POWER_STANDBY.
+ * @param timeout_ms Idle time before stepping down, 0 to stay at the level.
+ * @return PLAYER_OK on success, PLAYER_ERROR_INVALID_PARAM otherwise.
+ */
+player_status_t audio_player_set_idle_policy(audio_power_state_t state,
+                                             uint32_t            timeout_ms);
+
+/**
+ * @brief Gets the current idle policy.
+ * 
+ * @param state      Pointer to store the idle level.
+ * @param timeout_ms Pointer to store the step-down timeout.
+ */
+void audio_player_get_idle_policy(audio_power_state_t *state,
+                                  uint32_t            *timeout_ms);
+
+/**
+ * @brief Gets the time spent in every power state and the wake latencies.
+ * 
+ * @param stats Pointer to store the statistics.
+ */
+void audio_player_get_power_stats(struct audio_power_stats *stats);
+
+/**
+ * @brief Returns the printable name of a power state.
+ * 
+ * @param state Power state.
+ * @return State name, or "unknown".
+ */
+const char *audio_player_power_state_name(audio_power_state_t state);
+
+/**
+ * @brief Parses a power state name ("clocked", "warm", "standby").
+ * 
+ * @param name  State name.
+ * @param state Pointer to store the parsed state.
+ * @return 0 on success, -EINVAL if the name is unknown.
+ */
+int audio_player_parse_power_state(const char *name, audio_power_state_t *state);
+
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+/**
+ * @brief Copies the most recent I2S recovery events, newest first.
+ * 
+ * @param events     Array to store the events.
+ * @param max_events Size of the array.
+ * @param total      Pointer to store the number of recoveries since boot,
+ *                   may be NULL.
+ * @return Number of events copied.
+ */
+size_t audio_player_get_recovery_events(struct audio_recovery_event *events,
+                                        size_t                       max_events,
+                                        uint32_t                    *total);
+#endif
+
 #endif /* AUDIO_PLAYER_H_ */
\ No newline at end of file
@@ -0,0 +1,666 @@
+/**
+ * @file audio_rtp.c
+ * @brief Live RTP/Opus receiver with an adaptive jitter buffer.
+ *
+ * The UDP receive callback parses the RTP header in place and files the
+ * network packet itself in a slot indexed by sequence number, nothing is
+ * copied. The player takes one frame per Opus frame period and decodes
+ * it straight from the network buffer, then releases the packet.
+ *
+ * The playout delay target is the frame period plus three times the
+ * RFC 3550 interarrival jitter, raised by one frame for every underrun
+ * (counted once the missing frames turn out late, not the end of a talk
+ * spurt) and relaxed again when the stream runs clean. Frames above the target are
+ * dropped to bring the delay back down, silent (DTX) frames first.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/net_context.h>
+#include <zephyr/net/net_pkt.h>
+#include <zephyr/net/udp.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+#include "audio_rtp.h"
+
+LOG_MODULE_REGISTER(audio_rtp, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
+
+#define RTP_SLOTS      CONFIG_RPR_AUDIO_RTP_SLOTS
+#define RTP_SLOT_MASK  (RTP_SLOTS - 1)
+#define RTP_MIN_US     (CONFIG_RPR_AUDIO_RTP_MIN_DELAY_MS * USEC_PER_MSEC)
+#define RTP_MAX_US     (CONFIG_RPR_AUDIO_RTP_MAX_DELAY_MS * USEC_PER_MSEC)
+#define RTP_IDLE_MS    CONFIG_RPR_AUDIO_RTP_IDLE_TIMEOUT_MS
+#define RTP_PT         CONFIG_RPR_AUDIO_RTP_PAYLOAD_TYPE
+
+#define RTP_VERSION     2
+#define RTP_HDR_LEN     12
+#define RTP_CLOCK_HZ    48000 // Opus RTP clock, RFC 7587
+#define RTP_MAX_PAYLOAD 1275  // Largest Opus packet
+
+#define RTP_DEFAULT_FRAME  960  // 20 ms until the sender frame size is seen
+#define RTP_MIN_FRAME      120  // 2.5 ms
+#define RTP_MAX_FRAME      5760 // 120 ms
+#define RTP_SILENCE_BYTES  8    // DTX and silent frames are a few bytes
+#define RTP_SHRINK_HOLD    50   // Frames over target before speech is cut
+#define RTP_BOOST_DECAY_MS 5000 // Clean time before an underrun boost ends
+#define RTP_RESYNC_COUNT   8    // Out-of-window packets before a restart
+
+BUILD_ASSERT(IS_POWER_OF_TWO(RTP_SLOTS), "RTP slots must be a power of two");
+BUILD_ASSERT(RTP_SLOTS < CONFIG_NET_PKT_RX_COUNT,
+             "A full jitter buffer would hold every RX packet");
+
+struct rtp_slot {
+    struct net_pkt *pkt;
+    const uint8_t  *payload; /* In the network buffer, NULL if fragmented */
+    uint16_t        offset;  /* Payload offset in the packet */
+    uint16_t        len;
+    uint16_t        seq;
+    uint32_t        timestamp;
+    int64_t         arrival_us;
+};
+
+struct audio_rtp_receiver {
+    struct net_context    *ctx;
+    struct k_spinlock      lock;
+    struct k_sem           ready;
+    struct rtp_slot        slots[RTP_SLOTS];
+    bool                   started;  /* First packet of the talker seen */
+    bool                   playing;  /* Prefill done, frames are taken */
+    bool                   resync;   /* Talker changed, flush the buffer */
+    uint16_t               next_seq; /* Next frame to play */
+    uint16_t               high_seq; /* Highest sequence received */
+    uint32_t               high_ts;
+    uint32_t               frame_ts; /* Frame period in clock ticks */
+    int64_t                last_arrival_us;
+    uint32_t               last_ts;
+    uint32_t               jitter_q4; /* Jitter in us, times 16 */
+    uint32_t               boost_us;  /* Delay added after underruns */
+    int64_t                boost_since_ms;
+    uint32_t               over_target;
+    uint32_t               pending_underruns;
+    uint32_t               out_of_window;
+    int64_t                last_rx_ms;
+    uint64_t               latency_sum_us;
+    uint32_t               latency_count;
+    struct audio_rtp_stats stats;
+};
+
+static struct audio_rtp_receiver rtp_rx;
+
+/* Fragmented payloads are linearized here, one frame is decoded at a time */
+static uint8_t rtp_scratch[RTP_MAX_PAYLOAD];
+
+/**
+ * @brief Converts RTP clock ticks to microseconds.
+ */
+static inline int64_t rtp_ticks_to_us(int64_t ticks)
+{
+    return ticks * USEC_PER_SEC / RTP_CLOCK_HZ;
+}
+
+/**
+ * @brief Returns the playout delay target in frames.
+ *
+ * Must be called with the lock held.
+ */
+static int rtp_target_frames(void)
+{
+    uint32_t frame_us  = rtp_ticks_to_us(rtp_rx.frame_ts);
+    uint32_t target_us = frame_us + 3 * (rtp_rx.jitter_q4 >> 4) +
+                         rtp_rx.boost_us;
+
+    target_us              = CLAMP(target_us, RTP_MIN_US, RTP_MAX_US);
+    rtp_rx.stats.target_us = target_us;
+
+    // Keep room in the ring for the frames arriving while one plays
+    return MIN(DIV_ROUND_UP(target_us, frame_us), RTP_SLOTS - 2);
+}
+
+/**
+ * @brief Returns the number of frames from the playout point to the
+ *        newest packet, holes included.
+ *
+ * Must be called with the lock held.
+ */
+static int rtp_depth(void)
+{
+    if (!rtp_rx.started) {
+        return 0;
+    }
+
+    return (int16_t)(rtp_rx.high_seq - rtp_rx.next_seq) + 1;
+}
+
+/**
+ * @brief Files a received packet in the jitter buffer.
+ *
+ * Must be called with the lock held.
+ *
+ * @param in   Parsed packet.
+ * @param ssrc Synchronization source of the packet.
+ * @return true if the buffer took the packet, false to drop it.
+ */
+static bool rtp_insert(const struct rtp_slot *in, uint32_t ssrc)
+{
+    if (rtp_rx.resync) {
+        return false;
+    }
+
+    if (rtp_rx.started && ssrc != rtp_rx.stats.ssrc) {
+        LOG_INF("New RTP talker 0x%08x", ssrc);
+        rtp_rx.resync = true;
+        return false;
+    }
+
+    if (!rtp_rx.started) {
+        rtp_rx.started         = true;
+        rtp_rx.stats.ssrc      = ssrc;
+        rtp_rx.next_seq        = in->seq;
+        rtp_rx.high_seq        = in->seq;
+        rtp_rx.high_ts         = in->timestamp;
+        rtp_rx.last_arrival_us = in->arrival_us;
+        rtp_rx.last_ts         = in->timestamp;
+    }
+
+    int16_t ahead = (int16_t)(in->seq - rtp_rx.next_seq);
+
+    if (ahead < 0) {
+        rtp_rx.stats.late++;
+        return false;
+    }
+
+    if (ahead >= RTP_SLOTS) {
+        rtp_rx.stats.overflows++;
+        // A sender restart jumps the sequence for good
+        if (++rtp_rx.out_of_window >= RTP_RESYNC_COUNT) {
+            rtp_rx.resync = true;
+        }
+        return false;
+    }
+    rtp_rx.out_of_window = 0;
+
+    struct rtp_slot *slot = &rtp_rx.slots[in->seq & RTP_SLOT_MASK];
+    if (slot->pkt) {
+        rtp_rx.stats.duplicates++;
+        return false;
+    }
+    *slot = *in;
+
+    int16_t newer = (int16_t)(in->seq - rtp_rx.high_seq);
+    if (newer > 0) {
+        uint32_t delta = in->timestamp - rtp_rx.high_ts;
+
+        if (newer == 1 && delta >= RTP_MIN_FRAME && delta <= RTP_MAX_FRAME) {
+            rtp_rx.frame_ts = delta;
+        }
+        rtp_rx.high_seq = in->seq;
+        rtp_rx.high_ts  = in->timestamp;
+    }
+
+    // Interarrival jitter, RFC 3550 A.8
+    int64_t transit = (in->arrival_us - rtp_rx.last_arrival_us) -
+                      rtp_ticks_to_us((int32_t)(in->timestamp -
+                                                rtp_rx.last_ts));
+    uint32_t d = (uint32_t)MIN(transit < 0 ? -transit : transit, RTP_MAX_US);
+
+    rtp_rx.jitter_q4 += d - (rtp_rx.jitter_q4 >> 4);
+    rtp_rx.last_arrival_us = in->arrival_us;
+    rtp_rx.last_ts         = in->timestamp;
+    rtp_rx.stats.jitter_us = rtp_rx.jitter_q4 >> 4;
+
+    // The stream went on, so the frames missed before were late, not
+    // the end of a talk spurt
+    if (rtp_rx.pending_underruns > 0) {
+        rtp_rx.stats.underruns += rtp_rx.pending_underruns;
+        rtp_rx.boost_us = MIN(rtp_rx.boost_us +
+                                      rtp_rx.pending_underruns *
+                                              rtp_ticks_to_us(rtp_rx.frame_ts),
+                              RTP_MAX_US);
+        rtp_rx.boost_since_ms    = k_uptime_get();
+        rtp_rx.pending_underruns = 0;
+    }
+
+    rtp_rx.stats.received++;
+    return true;
+}
+
+/**
+ * @brief Returns true once the buffer holds the target delay.
+ *
+ * Must be called with the lock held.
+ */
+static bool rtp_is_ready(void)
+{
+    return rtp_rx.started && !rtp_rx.resync &&
+           rtp_depth() >= rtp_target_frames();
+}
+
+/**
+ * @brief UDP receive callback, files the packet without copying it.
+ */
+static void rtp_recv_cb(struct net_context     *context,
+                        struct net_pkt         *pkt,
+                        union net_ip_header    *ip_hdr,
+                        union net_proto_header *proto_hdr,
+                        int                     status,
+                        void                   *user_data)
+{
+    ARG_UNUSED(context);
+    ARG_UNUSED(ip_hdr);
+    ARG_UNUSED(proto_hdr);
+    ARG_UNUSED(user_data);
+
+    uint8_t         hdr[RTP_HDR_LEN];
+    struct rtp_slot in;
+
+    if (!pkt || status < 0) {
+        return;
+    }
+
+    in.arrival_us = k_ticks_to_us_floor64(k_uptime_ticks());
+
+    net_pkt_cursor_init(pkt);
+    net_pkt_set_overwrite(pkt, true);
+
+    if (net_pkt_skip(pkt,
+                     net_pkt_ip_hdr_len(pkt) + net_pkt_ip_opts_len(pkt) +
+                             sizeof(struct net_udp_hdr)) < 0 ||
+        net_pkt_read(pkt, hdr, sizeof(hdr)) < 0) {
+        goto drop;
+    }
+
+    if ((hdr[0] >> 6) != RTP_VERSION || (hdr[1] & 0x7f) != RTP_PT) {
+        goto drop;
+    }
+
+    // Contributing sources and the header extension are not used
+    if (net_pkt_skip(pkt, (hdr[0] & 0x0f) * sizeof(uint32_t)) < 0) {
+        goto drop;
+    }
+
+    if (hdr[0] & 0x10) {
+        uint8_t ext[4];
+
+        if (net_pkt_read(pkt, ext, sizeof(ext)) < 0 ||
+            net_pkt_skip(pkt, sys_get_be16(&ext[2]) * sizeof(uint32_t)) < 0) {
+            goto drop;
+        }
+    }
+
+    size_t len = net_pkt_remaining_data(pkt);
+
+    in.offset  = net_pkt_get_current_offset(pkt);
+    in.payload = net_pkt_is_contiguous(pkt, len) ?
+                         net_pkt_cursor_get_pos(pkt) :
+                         NULL;
+
+    if (hdr[0] & 0x20) {
+        uint8_t pad = 0;
+
+        if (len == 0 || net_pkt_skip(pkt, len - 1) < 0 ||
+            net_pkt_read_u8(pkt, &pad) < 0 || pad > len) {
+            goto drop;
+        }
+        len -= pad;
+    }
+
+    if (len == 0 || len > RTP_MAX_PAYLOAD) {
+        goto drop;
+    }
+
+    in.pkt       = pkt;
+    in.len       = len;
+    in.seq       = sys_get_be16(&hdr[2]);
+    in.timestamp = sys_get_be32(&hdr[4]);
+
+    k_spinlock_key_t key = k_spin_lock(&rtp_rx.lock);
+
+    bool taken = rtp_insert(&in, sys_get_be32(&hdr[8]));
+    bool ready = rtp_is_ready();
+
+    rtp_rx.last_rx_ms = k_uptime_get();
+    k_spin_unlock(&rtp_rx.lock, key);
+
+    if (ready) {
+        k_sem_give(&rtp_rx.ready);
+    }
+
+    if (taken) {
+        return;
+    }
+
+drop:
+    net_pkt_unref(pkt);
+}
+
+/**
+ * @brief Releases all buffered packets and restarts on the next talker.
+ *
+ * Only called from the player thread, which owns the filed packets.
+ */
+static void rtp_flush(void)
+{
+    struct net_pkt *pkts[RTP_SLOTS];
+    size_t          count = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&rtp_rx.lock);
+
+    for (size_t i = 0; i < RTP_SLOTS; i++) {
+        if (rtp_rx.slots[i].pkt) {
+            pkts[count++] = rtp_rx.slots[i].pkt;
+        }
+        rtp_rx.slots[i].pkt = NULL;
+    }
+
+    rtp_rx.started           = false;
+    rtp_rx.playing           = false;
+    rtp_rx.resync            = false;
+    rtp_rx.out_of_window     = 0;
+    rtp_rx.over_target       = 0;
+    rtp_rx.jitter_q4         = 0;
+    rtp_rx.pending_underruns = 0;
+    rtp_rx.stats.playing     = false;
+    k_spin_unlock(&rtp_rx.lock, key);
+
+    for (size_t i = 0; i < count; i++) {
+        net_pkt_unref(pkts[i]);
+    }
+}
+
+/**
+ * @brief Opens the receiver on a UDP port and starts buffering frames.
+ *
+ * @param port UDP port to listen on.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_rtp_open(uint16_t port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port   = htons(port),
+        .sin_addr   = INADDR_ANY_INIT,
+    };
+
+    if (rtp_rx.ctx) {
+        audio_rtp_close();
+    }
+
+    rtp_flush();
+    k_sem_init(&rtp_rx.ready, 0, 1);
+
+    k_spinlock_key_t key = k_spin_lock(&rtp_rx.lock);
+    memset(&rtp_rx.stats, 0, sizeof(rtp_rx.stats));
+    rtp_rx.frame_ts       = RTP_DEFAULT_FRAME;
+    rtp_rx.boost_us       = 0;
+    rtp_rx.boost_since_ms = k_uptime_get();
+    rtp_rx.last_rx_ms     = k_uptime_get();
+    rtp_rx.latency_sum_us = 0;
+    rtp_rx.latency_count  = 0;
+    rtp_rx.stats.port     = port;
+    k_spin_unlock(&rtp_rx.lock, key);
+
+    int ret = net_context_get(AF_INET, SOCK_DGRAM, IPPROTO_UDP, &rtp_rx.ctx);
+    if (ret < 0) {
+        LOG_ERR("Cannot get UDP context (%d)", ret);
+        rtp_rx.ctx = NULL;
+        return ret;
+    }
+
+    ret = net_context_bind(
+            rtp_rx.ctx, (struct sockaddr *)&addr, sizeof(addr));
+    if (ret == 0) {
+        ret = net_context_recv(rtp_rx.ctx, rtp_recv_cb, K_NO_WAIT, NULL);
+    }
+
+    if (ret < 0) {
+        LOG_ERR("Cannot listen on UDP port %u (%d)", port, ret);
+        net_context_put(rtp_rx.ctx);
+        rtp_rx.ctx = NULL;
+        return ret;
+    }
+
+    rtp_rx.stats.active = true;
+    LOG_INF("RTP receiver on port %u", port);
+
+    return 0;
+}
+
+/**
+ * @brief Closes the receiver and releases the buffered packets.
+ */
+void audio_rtp_close(void)
+{
+    if (!rtp_rx.ctx) {
+        return;
+    }
+
+    net_context_put(rtp_rx.ctx);
+    rtp_rx.ctx = NULL;
+    rtp_flush();
+
+    rtp_rx.stats.active = false;
+
+    LOG_INF("RTP receiver closed: %u received, %u lost (%u FEC), "
+            "%u concealed, %u late, %u underruns",
+            rtp_rx.stats.received,
+            rtp_rx.stats.lost,
+            rtp_rx.stats.fec,
+            rtp_rx.stats.concealed,
+            rtp_rx.stats.late,
+            rtp_rx.stats.underruns);
+}
+
+/**
+ * @brief Waits until the jitter buffer holds its target delay.
+ *
+ * @param timeout Maximum time to wait.
+ *
+ * @return 0 when playout can start, -EAGAIN on timeout.
+ */
+int audio_rtp_wait(k_timeout_t timeout)
+{
+    if (rtp_rx.resync) {
+        rtp_flush();
+    }
+
+    k_spinlock_key_t key   = k_spin_lock(&rtp_rx.lock);
+    bool             ready = rtp_is_ready();
+    k_spin_unlock(&rtp_rx.lock, key);
+
+    if (ready) {
+        return 0;
+    }
+
+    return k_sem_take(&rtp_rx.ready, timeout) == 0 ? 0 : -EAGAIN;
+}
+
+/**
+ * @brief Takes the packet of a slot out of the buffer into a frame.
+ *
+ * Must be called with the lock held.
+ */
+static void rtp_take(struct rtp_slot        *slot,
+                     struct audio_rtp_frame *frame,
+                     audio_rtp_frame_kind_t  kind)
+{
+    frame->kind       = kind;
+    frame->data       = slot->payload;
+    frame->len        = slot->len;
+    frame->arrival_us = slot->arrival_us;
+    frame->pkt        = slot->pkt;
+}
+
+/**
+ * @brief Takes the frame due for playout.
+ *
+ * Never blocks: a frame that is not there yet is concealed. The payload
+ * points into the network buffer when it is contiguous and is copied to
+ * a scratch buffer otherwise, it stays valid until audio_rtp_frame_done().
+ *
+ * @param frame Pointer to store the frame.
+ */
+void audio_rtp_next(struct audio_rtp_frame *frame)
+{
+    struct net_pkt *drop_pkt = NULL;
+    uint16_t        offset   = 0;
+    int64_t         now_ms   = k_uptime_get();
+
+    memset(frame, 0, sizeof(*frame));
+
+    if (rtp_rx.resync) {
+        rtp_flush();
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&rtp_rx.lock);
+
+    frame->samples = rtp_rx.frame_ts;
+
+    if (now_ms - rtp_rx.last_rx_ms > RTP_IDLE_MS) {
+        frame->kind = AUDIO_RTP_FRAME_NONE;
+        goto out;
+    }
+
+    // After a talker change the buffer fills up to the target again
+    if (!rtp_rx.playing) {
+        if (!rtp_is_ready()) {
+            frame->kind = AUDIO_RTP_FRAME_CONCEAL;
+            rtp_rx.stats.concealed++;
+            goto out;
+        }
+        rtp_rx.playing       = true;
+        rtp_rx.stats.playing = true;
+    }
+
+    if (rtp_rx.boost_us > 0 &&
+        now_ms - rtp_rx.boost_since_ms > RTP_BOOST_DECAY_MS) {
+        rtp_rx.boost_us -= MIN(rtp_rx.boost_us,
+                               rtp_ticks_to_us(rtp_rx.frame_ts));
+        rtp_rx.boost_since_ms = now_ms;
+    }
+
+    int              target = rtp_target_frames();
+    int              depth  = rtp_depth();
+    struct rtp_slot *slot   = &rtp_rx.slots[rtp_rx.next_seq & RTP_SLOT_MASK];
+
+    rtp_rx.stats.depth_us = MAX(depth, 0) * rtp_ticks_to_us(rtp_rx.frame_ts);
+
+    if (slot->pkt && depth > target + 1 &&
+        (slot->len <= RTP_SILENCE_BYTES ||
+         ++rtp_rx.over_target >= RTP_SHRINK_HOLD)) {
+        // Too much delay built up, skip this frame
+        drop_pkt           = slot->pkt;
+        slot->pkt          = NULL;
+        rtp_rx.over_target = 0;
+        rtp_rx.next_seq++;
+        rtp_rx.stats.dropped++;
+        depth--;
+        slot = &rtp_rx.slots[rtp_rx.next_seq & RTP_SLOT_MASK];
+    } else if (depth <= target + 1) {
+        rtp_rx.over_target = 0;
+    }
+
+    if (slot->pkt) {
+        rtp_take(slot, frame, AUDIO_RTP_FRAME_PACKET);
+        offset    = slot->offset;
+        slot->pkt = NULL;
+        rtp_rx.next_seq++;
+        rtp_rx.stats.played++;
+    } else if (depth > 0) {
+        // Frames after this one arrived, it is lost
+        struct rtp_slot *next =
+                &rtp_rx.slots[(rtp_rx.next_seq + 1) & RTP_SLOT_MASK];
+
+        rtp_rx.stats.lost++;
+        if (next->pkt && next->seq == (uint16_t)(rtp_rx.next_seq + 1)) {
+            // The next packet stays buffered, only its FEC is decoded now
+            rtp_take(next, frame, AUDIO_RTP_FRAME_FEC);
+            offset = next->offset;
+            rtp_rx.stats.fec++;
+        } else {
+            frame->kind = AUDIO_RTP_FRAME_CONCEAL;
+            rtp_rx.stats.concealed++;
+        }
+        rtp_rx.next_seq++;
+    } else {
+        // Nothing arrived yet, play over it and wait for it a frame longer
+        frame->kind = AUDIO_RTP_FRAME_CONCEAL;
+        rtp_rx.stats.concealed++;
+        if (k_ticks_to_us_floor64(k_uptime_ticks()) - rtp_rx.last_arrival_us <
+            RTP_MAX_US) {
+            rtp_rx.pending_underruns++;
+        }
+    }
+
+out:
+    k_spin_unlock(&rtp_rx.lock, key);
+
+    if (drop_pkt) {
+        net_pkt_unref(drop_pkt);
+    }
+
+    // The slot is only emptied by this thread, its packet is safe to read
+    if (frame->pkt && !frame->data) {
+        net_pkt_cursor_init(frame->pkt);
+        net_pkt_set_overwrite(frame->pkt, true);
+        if (net_pkt_skip(frame->pkt, offset) == 0 &&
+            net_pkt_read(frame->pkt, rtp_scratch, frame->len) == 0) {
+            frame->data = rtp_scratch;
+            rtp_rx.stats.copied++;
+        } else {
+            frame->len = 0;
+        }
+    }
+
+    // A buffered FEC source is not handed over
+    if (frame->kind == AUDIO_RTP_FRAME_FEC) {
+        frame->pkt = NULL;
+    }
+}
+
+/**
+ * @brief Releases a frame after decoding and records its latency.
+ *
+ * @param frame     Frame returned by audio_rtp_next().
+ * @param output_us Time the output takes to play what is queued ahead.
+ */
+void audio_rtp_frame_done(struct audio_rtp_frame *frame, uint32_t output_us)
+{
+    if (frame->kind != AUDIO_RTP_FRAME_PACKET) {
+        return;
+    }
+
+    int64_t  now_us     = k_ticks_to_us_floor64(k_uptime_ticks());
+    uint32_t latency_us = (uint32_t)(now_us - frame->arrival_us) + output_us;
+
+    if (frame->pkt) {
+        net_pkt_unref(frame->pkt);
+        frame->pkt = NULL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&rtp_rx.lock);
+    rtp_rx.latency_sum_us += latency_us;
+    rtp_rx.latency_count++;
+    rtp_rx.stats.latency_last_us = latency_us;
+    rtp_rx.stats.latency_max_us =
+            MAX(rtp_rx.stats.latency_max_us, latency_us);
+    rtp_rx.stats.latency_avg_us =
+            (uint32_t)(rtp_rx.latency_sum_us / rtp_rx.latency_count);
+    k_spin_unlock(&rtp_rx.lock, key);
+}
+
+/**
+ * @brief Gets the receiver and jitter buffer statistics.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void audio_rtp_get_stats(struct audio_rtp_stats *stats)
+{
+    k_spinlock_key_t key = k_spin_lock(&rtp_rx.lock);
+    *stats = rtp_rx.stats;
+    k_spin_unlock(&rtp_rx.lock, key);
+}
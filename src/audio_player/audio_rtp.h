@@ -0,0 +1,114 @@
+/**
+ * @file audio_rtp.h
+ * @brief Live RTP/Opus receiver with an adaptive jitter buffer.
+ *
+ * Opus frames sent as RTP (RFC 7587) to a UDP port are kept in the
+ * network buffers they arrived in until the player decodes them. The
+ * playout delay follows the measured arrival jitter, lost frames are
+ * rebuilt from the in-band FEC of the next frame when it is there and
+ * concealed by the decoder otherwise.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_RTP_H_
+#define AUDIO_RTP_H_
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct net_pkt;
+
+typedef enum {
+    AUDIO_RTP_FRAME_NONE = 0, /* The talker went silent, end of stream */
+    AUDIO_RTP_FRAME_PACKET,   /* Received frame, decode `data` */
+    AUDIO_RTP_FRAME_FEC,      /* Lost frame, decode the FEC of `data` */
+    AUDIO_RTP_FRAME_CONCEAL,  /* Lost frame or underrun, conceal it */
+} audio_rtp_frame_kind_t;
+
+struct audio_rtp_frame {
+    audio_rtp_frame_kind_t kind;
+    const uint8_t         *data;       /* Opus packet, NULL to conceal */
+    size_t                 len;
+    uint32_t               samples;    /* Frame duration at 48 kHz */
+    int64_t                arrival_us; /* Uptime the packet arrived at */
+    struct net_pkt        *pkt;        /* Held until the frame is done */
+};
+
+struct audio_rtp_stats {
+    bool     active;          /* Receiver is open */
+    bool     playing;         /* Playout has started */
+    uint16_t port;
+    uint32_t ssrc;
+    uint32_t received;        /* Packets accepted in the jitter buffer */
+    uint32_t played;          /* Frames decoded from their own packet */
+    uint32_t lost;            /* Frames missing at their playout time */
+    uint32_t fec;             /* Lost frames rebuilt from in-band FEC */
+    uint32_t concealed;       /* Frames concealed (losses and underruns) */
+    uint32_t late;            /* Packets arrived after their playout */
+    uint32_t duplicates;
+    uint32_t dropped;         /* Frames dropped to shrink the delay */
+    uint32_t overflows;       /* Packets beyond the buffer window */
+    uint32_t underruns;       /* Playout found the buffer empty */
+    uint32_t copied;          /* Fragmented payloads copied to decode */
+    uint32_t jitter_us;       /* Interarrival jitter (RFC 3550) */
+    uint32_t target_us;       /* Current playout delay target */
+    uint32_t depth_us;        /* Buffered frames at the last playout */
+    uint32_t latency_last_us; /* Packet arrival to sound */
+    uint32_t latency_avg_us;
+    uint32_t latency_max_us;
+};
+
+/**
+ * @brief Opens the receiver on a UDP port and starts buffering frames.
+ *
+ * @param port UDP port to listen on.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_rtp_open(uint16_t port);
+
+/**
+ * @brief Closes the receiver and releases the buffered packets.
+ */
+void audio_rtp_close(void);
+
+/**
+ * @brief Waits until the jitter buffer holds its target delay.
+ *
+ * @param timeout Maximum time to wait.
+ *
+ * @return 0 when playout can start, -EAGAIN on timeout.
+ */
+int audio_rtp_wait(k_timeout_t timeout);
+
+/**
+ * @brief Takes the frame due for playout.
+ *
+ * Never blocks: a frame that is not there yet is concealed. The payload
+ * points into the network buffer when it is contiguous and is copied to
+ * a scratch buffer otherwise, it stays valid until audio_rtp_frame_done().
+ *
+ * @param frame Pointer to store the frame.
+ */
+void audio_rtp_next(struct audio_rtp_frame *frame);
+
+/**
+ * @brief Releases a frame after decoding and records its latency.
+ *
+ * @param frame     Frame returned by audio_rtp_next().
+ * @param output_us Time the output takes to play what is queued ahead.
+ */
+void audio_rtp_frame_done(struct audio_rtp_frame *frame, uint32_t output_us);
+
+/**
+ * @brief Gets the receiver and jitter buffer statistics.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void audio_rtp_get_stats(struct audio_rtp_stats *stats);
+
+#endif /* AUDIO_RTP_H_ */
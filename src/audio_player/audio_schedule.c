@@ -0,0 +1,564 @@
+/**
+ * @file audio_schedule.c
+ * @brief RTC-driven schedule of audio announcements.
+ *
+ * The schedule thread sleeps until an entry is due within the configured
+ * lead time, locks onto the RTC second boundary to map the RTC time to the
+ * system uptime, and hands the file to the audio player with the exact
+ * start time. The player prepares the stream ahead and holds the first
+ * block until it is due, so the audio starts within one I2S block of the
+ * scheduled second.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/sys/timeutil.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "audio_player.h"
+#include "audio_schedule.h"
+#include "rtc.h"
+
+LOG_MODULE_REGISTER(audio_schedule, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
+
+#define SCHEDULE_THREAD_STACK_SIZE 2048
+#define SCHEDULE_THREAD_PRIORITY   7
+
+#define SCHEDULE_MAX_ENTRIES CONFIG_RPR_AUDIO_SCHEDULE_MAX_ENTRIES
+#define SCHEDULE_FILE_MAX_LEN \
+    (SCHEDULE_MAX_ENTRIES * (CONFIG_RPR_FILENAME_MAX_LEN + 32))
+
+#define SCHEDULE_SEC_PER_DAY 86400
+#define SCHEDULE_EPOCH_WDAY  4 // 1970-01-01 was a Thursday
+
+/* Whole seconds of lead, plus one for the RTC second boundary search */
+#define SCHEDULE_LEAD_S \
+    (DIV_ROUND_UP(CONFIG_RPR_AUDIO_SCHEDULE_LEAD_MS, MSEC_PER_SEC) + 1)
+
+#define SCHEDULE_RECHECK_S    60   // Re-read the RTC at least this often
+#define SCHEDULE_RETRY_S      10   // Retry period while the RTC is not set
+#define SCHEDULE_CONFIRM_MS   5000 // Wait for the start after the due time
+#define SCHEDULE_CONFIRM_POLL 50
+
+struct audio_schedule_cfg {
+    struct audio_schedule_entry  entries[SCHEDULE_MAX_ENTRIES];
+    size_t                       count;
+    struct audio_schedule_status status;
+    struct k_mutex               lock;
+};
+
+static struct audio_schedule_cfg schedule_cfg = {
+    .status.next_index = -1,
+    .lock              = Z_MUTEX_INITIALIZER(schedule_cfg.lock),
+};
+
+/* Scratch buffers, kept static so the shell and schedule stacks stay small */
+static struct audio_schedule_entry schedule_entries_buf[SCHEDULE_MAX_ENTRIES];
+static char                        schedule_file_buf[SCHEDULE_FILE_MAX_LEN + 1];
+
+static const char *const schedule_day_names[] = {
+    "sun", "mon", "tue", "wed", "thu", "fri", "sat",
+};
+
+K_SEM_DEFINE(schedule_sem, 0, 1);
+
+/**
+ * @brief Parses a decimal number followed by a separator.
+ *
+ * @param str Pointer to the current parse position, advanced past the
+ *            separator.
+ * @param sep Expected separator, '\0' for the end of the string.
+ * @param max Maximum accepted value.
+ *
+ * @return Parsed value, or -1 on error.
+ */
+static int schedule_parse_number(const char **str, char sep, int max)
+{
+    char *end;
+    long  value = strtol(*str, &end, 10);
+
+    if (end == *str || *end != sep || value < 0 || value > max) {
+        return -1;
+    }
+
+    *str = (sep != '\0') ? end + 1 : end;
+
+    return (int)value;
+}
+
+/**
+ * @brief Parses the "when" field: daily, a weekday list or a date.
+ */
+static int schedule_parse_when(const char                  *when,
+                               struct audio_schedule_entry *e)
+{
+    if (strcmp(when, "daily") == 0) {
+        e->days = AUDIO_SCHEDULE_DAILY;
+        return 0;
+    }
+
+    if (strchr(when, '-')) {
+        struct tm tm = { 0 };
+
+        tm.tm_year = schedule_parse_number(&when, '-', 9999) - 1900;
+        tm.tm_mon  = schedule_parse_number(&when, '-', 12) - 1;
+        tm.tm_mday = schedule_parse_number(&when, '\0', 31);
+
+        if (tm.tm_year < 70 || tm.tm_mon < 0 || tm.tm_mday < 1) {
+            return -EINVAL;
+        }
+
+        e->date = timeutil_timegm64(&tm);
+        return 0;
+    }
+
+    while (*when) {
+        int day;
+
+        for (day = 0; day < ARRAY_SIZE(schedule_day_names); day++) {
+            if (strncmp(when, schedule_day_names[day], 3) == 0) {
+                break;
+            }
+        }
+        if (day == ARRAY_SIZE(schedule_day_names) ||
+            (when[3] != ',' && when[3] != '\0')) {
+            return -EINVAL;
+        }
+
+        e->days |= BIT(day);
+        when += (when[3] == ',') ? 4 : 3;
+    }
+
+    return (e->days != 0) ? 0 : -EINVAL;
+}
+
+/**
+ * @brief Parses one line of the schedule table.
+ *
+ * @param line Line to parse, modified in place.
+ * @param e    Entry to fill.
+ *
+ * @return 1 if an entry was parsed, 0 for blank or comment lines,
+ *         -EINVAL if the line is malformed.
+ */
+static int schedule_parse_line(char *line, struct audio_schedule_entry *e)
+{
+    char       *save = NULL;
+    char       *when = strtok_r(line, " \t", &save);
+    const char *time = strtok_r(NULL, " \t", &save);
+    const char *file = strtok_r(NULL, " \t", &save);
+
+    if (!when || when[0] == '#') {
+        return 0;
+    }
+
+    if (!time || !file || strtok_r(NULL, " \t", &save) ||
+        strlen(file) >= sizeof(e->file)) {
+        return -EINVAL;
+    }
+
+    memset(e, 0, sizeof(*e));
+
+    if (schedule_parse_when(when, e) < 0) {
+        return -EINVAL;
+    }
+
+    int hour   = schedule_parse_number(&time, ':', 23);
+    int minute = schedule_parse_number(&time, ':', 59);
+    int second = schedule_parse_number(&time, '\0', 59);
+
+    if (hour < 0 || minute < 0 || second < 0) {
+        return -EINVAL;
+    }
+
+    e->second = hour * 3600 + minute * 60 + second;
+    strcpy(e->file, file);
+
+    return 1;
+}
+
+/**
+ * @brief Returns the next RTC time an entry is due after `now`, 0 if never.
+ */
+static int64_t schedule_next_time(const struct audio_schedule_entry *e,
+                                  int64_t                            now)
+{
+    if (e->date != 0) {
+        int64_t t = e->date + e->second;
+        return (t > now) ? t : 0;
+    }
+
+    int64_t day = now - (now % SCHEDULE_SEC_PER_DAY);
+
+    // Today plus a full week covers every weekday mask
+    for (int i = 0; i <= 7; i++) {
+        int64_t t    = day + (int64_t)i * SCHEDULE_SEC_PER_DAY + e->second;
+        int64_t days = t / SCHEDULE_SEC_PER_DAY;
+        int     wday = (int)((days + SCHEDULE_EPOCH_WDAY) % 7);
+
+        if (t > now && (e->days & BIT(wday))) {
+            return t;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Finds the entry due next and stores it in the status.
+ *
+ * @param now   Current RTC time.
+ * @param entry Pointer to store a copy of the entry.
+ *
+ * @return RTC time the entry is due at, 0 if nothing is scheduled.
+ */
+static int64_t schedule_find_next(int64_t                      now,
+                                  struct audio_schedule_entry *entry)
+{
+    int64_t next  = 0;
+    int     index = -1;
+
+    k_mutex_lock(&schedule_cfg.lock, K_FOREVER);
+
+    for (size_t i = 0; i < schedule_cfg.count; i++) {
+        int64_t t = schedule_next_time(&schedule_cfg.entries[i], now);
+
+        if (t != 0 && (next == 0 || t < next)) {
+            next  = t;
+            index = (int)i;
+        }
+    }
+
+    if (index >= 0) {
+        *entry = schedule_cfg.entries[index];
+    }
+    schedule_cfg.status.next_time  = next;
+    schedule_cfg.status.next_index = index;
+
+    k_mutex_unlock(&schedule_cfg.lock);
+
+    return next;
+}
+
+/**
+ * @brief Records the result of a scheduled start.
+ */
+static void schedule_record(int64_t time, bool started, int32_t error_us)
+{
+    k_mutex_lock(&schedule_cfg.lock, K_FOREVER);
+    if (started) {
+        schedule_cfg.status.last_time     = time;
+        schedule_cfg.status.last_error_us = error_us;
+        schedule_cfg.status.started++;
+    } else {
+        schedule_cfg.status.failed++;
+    }
+    k_mutex_unlock(&schedule_cfg.lock);
+}
+
+/**
+ * @brief Hands a due entry to the audio player and logs its timing error.
+ *
+ * @param entry Entry to play.
+ * @param due   RTC time the audio must start at.
+ */
+static void schedule_start(const struct audio_schedule_entry *entry,
+                           int64_t                            due)
+{
+    char    path[FULL_AUDIO_PATH_MAX_LEN];
+    int64_t edge;
+    int64_t edge_us;
+    int32_t error_us;
+
+    if (rtc_sync_second(&edge, &edge_us) < 0) {
+        LOG_ERR("Cannot sync to the RTC, %s skipped", entry->file);
+        schedule_record(due, false, 0);
+        k_sleep(K_SECONDS(SCHEDULE_LEAD_S));
+        return;
+    }
+
+    int64_t start_us = edge_us + (due - edge) * USEC_PER_SEC;
+
+    if (entry->file[0] == '/') {
+        snprintf(path, sizeof(path), "%s", entry->file);
+    } else {
+        snprintf(path,
+                 sizeof(path),
+                 "%s/%s",
+                 CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                 entry->file);
+    }
+
+    uint32_t        starts = audio_player_get_start_error(NULL);
+    player_status_t status = audio_player_start_at(path, start_us);
+
+    if (status != PLAYER_OK) {
+        LOG_ERR("Scheduled %s not started (%d)", path, status);
+    } else {
+        LOG_INF("Scheduled %s prepared %lld ms ahead",
+                path,
+                (start_us - k_ticks_to_us_floor64(k_uptime_ticks())) /
+                        USEC_PER_MSEC);
+    }
+
+    // Stay past the due second, so the entry is not picked up again
+    int64_t wait_us = start_us - k_ticks_to_us_floor64(k_uptime_ticks());
+    if (wait_us > 0) {
+        k_sleep(K_USEC(wait_us));
+    }
+
+    if (status != PLAYER_OK) {
+        schedule_record(due, false, 0);
+        k_sleep(K_SECONDS(1));
+        return;
+    }
+
+    for (int t = 0; t < SCHEDULE_CONFIRM_MS; t += SCHEDULE_CONFIRM_POLL) {
+        if (audio_player_get_start_error(&error_us) != starts) {
+            LOG_INF("Scheduled %s started, timing error %d us",
+                    path,
+                    error_us);
+            schedule_record(due, true, error_us);
+            return;
+        }
+        k_msleep(SCHEDULE_CONFIRM_POLL);
+    }
+
+    LOG_WRN("Scheduled %s did not start within %d ms",
+            path,
+            SCHEDULE_CONFIRM_MS);
+    schedule_record(due, false, 0);
+}
+
+/**
+ * @brief Schedule thread, fires the table entries at their RTC time.
+ */
+static void audio_schedule_thread(void)
+{
+    struct audio_schedule_entry entry;
+    int64_t                     now;
+
+    audio_schedule_load();
+
+    while (1) {
+        if (get_epoch_time(&now) < 0) {
+            k_sem_take(&schedule_sem, K_SECONDS(SCHEDULE_RETRY_S));
+            continue;
+        }
+
+        int64_t next = schedule_find_next(now, &entry);
+        if (next == 0) {
+            k_sem_take(&schedule_sem, K_FOREVER);
+            continue;
+        }
+
+        int64_t wait_s = next - now - SCHEDULE_LEAD_S;
+        if (wait_s > 0) {
+            k_sem_take(&schedule_sem,
+                       K_SECONDS(MIN(wait_s, SCHEDULE_RECHECK_S)));
+            continue;
+        }
+
+        schedule_start(&entry, next);
+    }
+}
+
+K_THREAD_DEFINE(audio_schedule_thread_id,
+                SCHEDULE_THREAD_STACK_SIZE,
+                audio_schedule_thread,
+                NULL,
+                NULL,
+                NULL,
+                SCHEDULE_THREAD_PRIORITY,
+                0,
+                0);
+
+/**
+ * @brief Reloads the schedule table from the file system.
+ *
+ * @return Number of entries on success, negative error code otherwise.
+ */
+int audio_schedule_load(void)
+{
+    struct fs_file_t file;
+    ssize_t          len;
+    size_t           count   = 0;
+    int              line_no = 0;
+    int              ret;
+
+    fs_file_t_init(&file);
+
+    ret = fs_open(&file, CONFIG_RPR_AUDIO_SCHEDULE_PATH, FS_O_READ);
+    if (ret == -ENOENT) {
+        len = 0;
+    } else if (ret < 0) {
+        LOG_ERR("Failed to open schedule: %d", ret);
+        return ret;
+    } else {
+        len = fs_read(&file, schedule_file_buf, SCHEDULE_FILE_MAX_LEN);
+        fs_close(&file);
+    }
+
+    if (len < 0) {
+        LOG_ERR("Failed to read schedule: %d", (int)len);
+        return (int)len;
+    }
+    schedule_file_buf[len] = '\0';
+
+    char *save = NULL;
+    for (char *line = strtok_r(schedule_file_buf, "\r\n", &save); line;
+         line       = strtok_r(NULL, "\r\n", &save)) {
+        line_no++;
+
+        if (count == SCHEDULE_MAX_ENTRIES) {
+            LOG_WRN("Schedule has more than %d entries", SCHEDULE_MAX_ENTRIES);
+            break;
+        }
+
+        ret = schedule_parse_line(line, &schedule_entries_buf[count]);
+        if (ret < 0) {
+            LOG_WRN("Malformed schedule line %d skipped", line_no);
+            continue;
+        }
+        count += ret;
+    }
+
+    k_mutex_lock(&schedule_cfg.lock, K_FOREVER);
+    memcpy(schedule_cfg.entries,
+           schedule_entries_buf,
+           count * sizeof(schedule_entries_buf[0]));
+    schedule_cfg.count = count;
+    k_mutex_unlock(&schedule_cfg.lock);
+
+    k_sem_give(&schedule_sem);
+
+    LOG_INF("Audio schedule loaded: %d entries", (int)count);
+
+    return (int)count;
+}
+
+/**
+ * @brief Validates a schedule line, appends it to the table and reloads.
+ *
+ * @param line Entry in the table format, e.g. "daily 12:00:00 test.opus".
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_schedule_add(const char *line)
+{
+    struct audio_schedule_entry entry;
+    struct fs_file_t            file;
+    char                        copy[CONFIG_RPR_FILENAME_MAX_LEN + 32];
+
+    if (!line || strlen(line) >= sizeof(copy)) {
+        return -EINVAL;
+    }
+
+    strcpy(copy, line);
+    if (schedule_parse_line(copy, &entry) != 1) {
+        return -EINVAL;
+    }
+
+    if (audio_schedule_count() >= SCHEDULE_MAX_ENTRIES) {
+        return -ENOMEM;
+    }
+
+    fs_file_t_init(&file);
+
+    int ret = fs_open(&file,
+                      CONFIG_RPR_AUDIO_SCHEDULE_PATH,
+                      FS_O_CREATE | FS_O_WRITE | FS_O_APPEND);
+    if (ret < 0) {
+        LOG_ERR("Failed to open schedule: %d", ret);
+        return ret;
+    }
+
+    ssize_t written = fs_write(&file, line, strlen(line));
+    if (written == (ssize_t)strlen(line)) {
+        written = fs_write(&file, "\n", 1);
+    }
+    fs_close(&file);
+
+    if (written < 0) {
+        LOG_ERR("Failed to write schedule: %d", (int)written);
+        return (int)written;
+    }
+
+    ret = audio_schedule_load();
+
+    return (ret < 0) ? ret : 0;
+}
+
+/**
+ * @brief Deletes the schedule table.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_schedule_clear(void)
+{
+    int ret = fs_unlink(CONFIG_RPR_AUDIO_SCHEDULE_PATH);
+    if (ret < 0 && ret != -ENOENT) {
+        LOG_ERR("Failed to delete schedule: %d", ret);
+        return ret;
+    }
+
+    ret = audio_schedule_load();
+
+    return (ret < 0) ? ret : 0;
+}
+
+/**
+ * @brief Returns the number of loaded entries.
+ */
+size_t audio_schedule_count(void)
+{
+    return schedule_cfg.count;
+}
+
+/**
+ * @brief Gets one entry of the loaded table.
+ *
+ * @param index Entry index.
+ * @param entry Pointer to store the entry.
+ *
+ * @return 0 on success, -EINVAL if the entry does not exist.
+ */
+int audio_schedule_get(size_t index, struct audio_schedule_entry *entry)
+{
+    int ret = -EINVAL;
+
+    if (!entry) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&schedule_cfg.lock, K_FOREVER);
+    if (index < schedule_cfg.count) {
+        *entry = schedule_cfg.entries[index];
+        ret    = 0;
+    }
+    k_mutex_unlock(&schedule_cfg.lock);
+
+    return ret;
+}
+
+/**
+ * @brief Gets the next due entry and the result of the last start.
+ *
+ * @param status Pointer to store the status.
+ */
+void audio_schedule_get_status(struct audio_schedule_status *status)
+{
+    if (!status) {
+        return;
+    }
+
+    k_mutex_lock(&schedule_cfg.lock, K_FOREVER);
+    *status = schedule_cfg.status;
+    k_mutex_unlock(&schedule_cfg.lock);
+}
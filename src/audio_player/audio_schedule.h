@@ -0,0 +1,91 @@
+/**
+ * @file audio_schedule.h
+ * @brief RTC-driven schedule of audio announcements.
+ *
+ * The schedule is a text table on LittleFS, one announcement per line:
+ *
+ *     # when            time      file
+ *     daily             12:00:00  test.opus
+ *     mon,wed,fri       08:30:00  drill.opus
+ *     2025-09-01        10:00:00  /lfs/audio/evac.opus
+ *
+ * Shortly before an entry is due the stream is prepared (codec woken, file
+ * opened, first packet decoded) and handed to the audio player with the
+ * exact start time, derived from the RTC second boundary. The timing error
+ * of every start is logged.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_SCHEDULE_H_
+#define AUDIO_SCHEDULE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define AUDIO_SCHEDULE_DAILY 0x7F // Weekday mask with all days set
+
+struct audio_schedule_entry {
+    int64_t  date;   /* Day of a one-shot entry (00:00:00), 0 if weekly */
+    uint32_t second; /* Second of the day */
+    uint8_t  days;   /* Weekday mask, bit 0 is Sunday */
+    char     file[CONFIG_RPR_FILENAME_MAX_LEN];
+};
+
+struct audio_schedule_status {
+    int64_t  next_time;     /* RTC time of the next entry, 0 if none */
+    int      next_index;    /* Index of the next entry, -1 if none */
+    int64_t  last_time;     /* RTC time of the last started entry */
+    int32_t  last_error_us; /* Start error of the last entry, + is late */
+    uint32_t started;
+    uint32_t failed;
+};
+
+/**
+ * @brief Reloads the schedule table from the file system.
+ *
+ * @return Number of entries on success, negative error code otherwise.
+ */
+int audio_schedule_load(void);
+
+/**
+ * @brief Validates a schedule line, appends it to the table and reloads.
+ *
+ * @param line Entry in the table format, e.g. "daily 12:00:00 test.opus".
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_schedule_add(const char *line);
+
+/**
+ * @brief Deletes the schedule table.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_schedule_clear(void);
+
+/**
+ * @brief Returns the number of loaded entries.
+ */
+size_t audio_schedule_count(void);
+
+/**
+ * @brief Gets one entry of the loaded table.
+ *
+ * @param index Entry index.
+ * @param entry Pointer to store the entry.
+ *
+ * @return 0 on success, -EINVAL if the entry does not exist.
+ */
+int audio_schedule_get(size_t index, struct audio_schedule_entry *entry);
+
+/**
+ * @brief Gets the next due entry and the result of the last start.
+ *
+ * @param status Pointer to store the status.
+ */
+void audio_schedule_get_status(struct audio_schedule_status *status);
+
+#endif /* AUDIO_SCHEDULE_H_ */
@@ -0,0 +1,566 @@
+/**
+ * @file audio_sync.c
+ * @brief Network clock discipline and playout trim for synchronized audio.
+ *
+ * Every SNTP sample gives the offset between the network time and the
+ * local uptime at the midpoint of the query. The offsets of the last
+ * samples are fitted with a line, its slope is the drift of the local
+ * crystal. A sample far off the fit (server change, network stall) restarts
+ * the fit instead of pulling it.
+ *
+ * The I2S clock is derived from the same crystal as the uptime, so a
+ * synchronized stream drifts against the other speakers at the same rate.
+ * The player reports the uptime each output block is heard at, the error
+ * against the network schedule is low-pass filtered and trimmed one sample
+ * at a time, rate-limited by CONFIG_RPR_AUDIO_SYNC_MAX_TRIM_PPM.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/sntp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_sync.h"
+
+LOG_MODULE_REGISTER(audio_sync, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
+
+#define SYNC_THREAD_STACK_SIZE 2048
+#define SYNC_THREAD_PRIORITY   8
+
+#define SYNC_WINDOW      CONFIG_RPR_AUDIO_SYNC_WINDOW
+#define SYNC_MAX_RTT_US  (CONFIG_RPR_AUDIO_SYNC_MAX_RTT_MS * USEC_PER_MSEC)
+#define SYNC_SNTP_PORT   "123"
+#define SYNC_TIMEOUT_MS  1000
+#define SYNC_FAST_POLL_S 4  // Poll period until the fit window is full
+#define SYNC_RETRY_S     10 // Retry period after a failed query
+
+#define SYNC_MAX_DRIFT_PPB  500000 // Fitted drift is clamped to 500 ppm
+#define SYNC_ERROR_FILTER_N 8      // Playout error filter length, in blocks
+
+struct sync_sample {
+    int64_t local_us;  /* Uptime at the middle of the query */
+    int64_t offset_us; /* Network time minus uptime */
+};
+
+struct audio_sync_cfg {
+    struct sync_sample samples[SYNC_WINDOW];
+    size_t             count;
+    size_t             head;
+    int64_t            ref_local_us;  /* Fit reference uptime */
+    int64_t            ref_offset_us; /* Fitted offset at the reference */
+    struct k_mutex     lock;
+};
+
+struct audio_sync_stream {
+    int64_t  net_start_us;
+    uint32_t sample_rate;
+    int64_t  trimmed;           /* Inserted minus dropped samples */
+    bool     error_valid;
+    uint64_t frames_since_trim;
+    uint64_t trim_interval;     /* Minimum output frames between trims */
+};
+
+static struct audio_sync_cfg sync_cfg = {
+    .lock = Z_MUTEX_INITIALIZER(sync_cfg.lock),
+};
+
+static struct audio_sync_stream sync_stream;
+static struct audio_sync_status sync_status;
+
+/**
+ * @brief Returns the fitted network offset at a local uptime.
+ *
+ * Must be called with the lock held and the clock synchronized.
+ */
+static int64_t sync_offset_at(int64_t local_us)
+{
+    int64_t dt = local_us - sync_cfg.ref_local_us;
+
+    return sync_cfg.ref_offset_us + dt * sync_status.drift_ppb / NSEC_PER_SEC;
+}
+
+/**
+ * @brief Fits the offset and the drift over the sample window.
+ *
+ * The fit is referenced to the newest sample, so the values stay small
+ * and the offset is valid from the latest query on. With one sample the
+ * previous drift estimate is kept.
+ */
+static void sync_fit(void)
+{
+    size_t                    last_idx = (sync_cfg.head + SYNC_WINDOW - 1) %
+                                         SYNC_WINDOW;
+    const struct sync_sample *last     = &sync_cfg.samples[last_idx];
+
+    sync_cfg.ref_local_us  = last->local_us;
+    sync_cfg.ref_offset_us = last->offset_us;
+
+    if (sync_cfg.count < 2) {
+        return;
+    }
+
+    double n   = (double)sync_cfg.count;
+    double sx  = 0;
+    double sy  = 0;
+    double sxx = 0;
+    double sxy = 0;
+
+    for (size_t i = 0; i < sync_cfg.count; i++) {
+        const struct sync_sample *s = &sync_cfg.samples[i];
+
+        double x = (double)(s->local_us - last->local_us) / USEC_PER_MSEC;
+        double y = (double)(s->offset_us - last->offset_us);
+
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+
+    double den = n * sxx - sx * sx;
+    if (den <= 0) {
+        return;
+    }
+
+    // Slope in us per ms, i.e. 1e-3, so ppb is the slope times 1e6
+    double slope     = (n * sxy - sx * sy) / den;
+    double intercept = (sy - slope * sx) / n;
+    double ppb       = slope * 1e6;
+
+    ppb = CLAMP(ppb, -SYNC_MAX_DRIFT_PPB, SYNC_MAX_DRIFT_PPB);
+
+    sync_status.drift_ppb  = (int32_t)ppb;
+    sync_cfg.ref_offset_us = last->offset_us + (int64_t)intercept;
+}
+
+/**
+ * @brief Queries the time server once.
+ *
+ * The server address is resolved before the timed part, so the round trip
+ * only covers the SNTP exchange.
+ *
+ * @param sample Pointer to store the offset sample.
+ * @param rtt_us Pointer to store the round-trip time.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int sync_query(struct sync_sample *sample, uint32_t *rtt_us)
+{
+    struct zsock_addrinfo  hints = {
+         .ai_family   = AF_INET,
+         .ai_socktype = SOCK_DGRAM,
+    };
+    struct zsock_addrinfo *res = NULL;
+    struct sntp_ctx        ctx;
+    struct sntp_time       ts;
+
+    int ret = zsock_getaddrinfo(
+            CONFIG_RPR_AUDIO_SYNC_SERVER, SYNC_SNTP_PORT, &hints, &res);
+    if (ret != 0) {
+        LOG_DBG("Cannot resolve %s (%d)", CONFIG_RPR_AUDIO_SYNC_SERVER, ret);
+        return -EHOSTUNREACH;
+    }
+
+    ret = sntp_init(&ctx, res->ai_addr, res->ai_addrlen);
+    zsock_freeaddrinfo(res);
+    if (ret < 0) {
+        return ret;
+    }
+
+    int64_t t0 = k_ticks_to_us_floor64(k_uptime_ticks());
+    ret        = sntp_query(&ctx, SYNC_TIMEOUT_MS, &ts);
+    int64_t t1 = k_ticks_to_us_floor64(k_uptime_ticks());
+
+    sntp_close(&ctx);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    *rtt_us = (uint32_t)(t1 - t0);
+    if (*rtt_us > SYNC_MAX_RTT_US) {
+        LOG_DBG("SNTP round trip %u us rejected", *rtt_us);
+        return -ERANGE;
+    }
+
+    int64_t net_us = (int64_t)ts.seconds * USEC_PER_SEC +
+                     (int64_t)(((uint64_t)ts.fraction * USEC_PER_SEC) >> 32);
+
+    sample->local_us  = t0 + *rtt_us / 2;
+    sample->offset_us = net_us - sample->local_us;
+
+    return 0;
+}
+
+/**
+ * @brief Queries the time server now and updates the clock fit.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_sync_update(void)
+{
+    struct sync_sample sample;
+    uint32_t           rtt_us = 0;
+
+    int ret = sync_query(&sample, &rtt_us);
+
+    k_mutex_lock(&sync_cfg.lock, K_FOREVER);
+
+    if (ret < 0) {
+        sync_status.failures++;
+        k_mutex_unlock(&sync_cfg.lock);
+        LOG_DBG("SNTP query failed (%d)", ret);
+        return ret;
+    }
+
+    int64_t error_us = 0;
+
+    if (sync_status.synced) {
+        error_us = sample.offset_us - sync_offset_at(sample.local_us);
+    }
+
+    if (!sync_status.synced ||
+        llabs(error_us) > CONFIG_RPR_AUDIO_SYNC_STEP_US) {
+        sync_cfg.count = 0;
+        sync_cfg.head  = 0;
+        sync_status.steps++;
+        LOG_INF("Network clock %s, offset %lld us",
+                sync_status.synced ? "stepped" : "synchronized",
+                sample.offset_us);
+    }
+
+    sync_cfg.samples[sync_cfg.head] = sample;
+    sync_cfg.head                   = (sync_cfg.head + 1) % SYNC_WINDOW;
+    sync_cfg.count                  = MIN(sync_cfg.count + 1, SYNC_WINDOW);
+
+    sync_fit();
+
+    sync_status.synced        = true;
+    sync_status.samples       = sync_cfg.count;
+    sync_status.last_sync_ms  = sample.local_us / USEC_PER_MSEC;
+    sync_status.last_rtt_us   = rtt_us;
+    sync_status.last_error_us = (int32_t)CLAMP(error_us, INT32_MIN, INT32_MAX);
+
+    k_mutex_unlock(&sync_cfg.lock);
+
+    LOG_DBG("SNTP sample: rtt %u us, error %lld us, drift %d ppb",
+            rtt_us,
+            error_us,
+            sync_status.drift_ppb);
+
+    return 0;
+}
+
+/**
+ * @brief Converts a local uptime to network time.
+ *
+ * @param local_us System uptime in microseconds.
+ * @param net_us   Pointer to store the network (Unix epoch) time in us.
+ *
+ * @return 0 on success, -EAGAIN if the clock is not synchronized yet.
+ */
+int audio_sync_to_network(int64_t local_us, int64_t *net_us)
+{
+    int ret = -EAGAIN;
+
+    k_mutex_lock(&sync_cfg.lock, K_FOREVER);
+    if (sync_status.synced) {
+        *net_us = local_us + sync_offset_at(local_us);
+        ret     = 0;
+    }
+    k_mutex_unlock(&sync_cfg.lock);
+
+    return ret;
+}
+
+/**
+ * @brief Converts a network time to local uptime.
+ *
+ * @param net_us   Network (Unix epoch) time in microseconds.
+ * @param local_us Pointer to store the system uptime in us.
+ *
+ * @return 0 on success, -EAGAIN if the clock is not synchronized yet.
+ */
+int audio_sync_to_local(int64_t net_us, int64_t *local_us)
+{
+    int ret = -EAGAIN;
+
+    k_mutex_lock(&sync_cfg.lock, K_FOREVER);
+    if (sync_status.synced) {
+        // One refinement step, the drift over the offset is negligible
+        int64_t guess = net_us - sync_cfg.ref_offset_us;
+
+        *local_us = net_us - sync_offset_at(guess);
+        ret       = 0;
+    }
+    k_mutex_unlock(&sync_cfg.lock);
+
+    return ret;
+}
+
+/**
+ * @brief Gets the current network time.
+ *
+ * @param net_us Pointer to store the network (Unix epoch) time in us.
+ *
+ * @return 0 on success, -EAGAIN if the clock is not synchronized yet.
+ */
+int audio_sync_now(int64_t *net_us)
+{
+    return audio_sync_to_network(k_ticks_to_us_floor64(k_uptime_ticks()),
+                                 net_us);
+}
+
+/**
+ * @brief Starts tracking the playout of a synchronized stream.
+ *
+ * @param net_start_us Network time the first stream sample is due at.
+ * @param sample_rate  Output sample rate in Hz.
+ */
+void audio_sync_stream_start(int64_t net_start_us, uint32_t sample_rate)
+{
+    k_mutex_lock(&sync_cfg.lock, K_FOREVER);
+
+    memset(&sync_stream, 0, sizeof(sync_stream));
+    sync_stream.net_start_us      = net_start_us;
+    sync_stream.sample_rate       = sample_rate;
+    sync_stream.trim_interval     = USEC_PER_SEC /
+                                CONFIG_RPR_AUDIO_SYNC_MAX_TRIM_PPM;
+    sync_stream.frames_since_trim = sync_stream.trim_interval;
+
+    sync_status.stream_active = true;
+    sync_status.play_error_us = 0;
+    sync_status.inserted      = 0;
+    sync_status.dropped       = 0;
+
+    k_mutex_unlock(&sync_cfg.lock);
+}
+
+/**
+ * @brief Aligns the first output sample to the network start time.
+ *
+ * The start hold of the player is accurate to half a block, the rest is
+ * removed by delaying the stream with silence or skipping its first
+ * samples.
+ *
+ * @param play_us    Uptime in us the first output sample is heard at.
+ * @param max_frames Maximum number of frames to pad or skip.
+ *
+ * @return Frames to skip from the stream start, negative to pad with
+ *         silence.
+ */
+int32_t audio_sync_stream_align(int64_t play_us, int32_t max_frames)
+{
+    int32_t frames = 0;
+
+    k_mutex_lock(&sync_cfg.lock, K_FOREVER);
+
+    if (sync_status.stream_active && sync_status.synced) {
+        int64_t late_us = play_us + sync_offset_at(play_us) -
+                          sync_stream.net_start_us;
+        int64_t late    = late_us * sync_stream.sample_rate / USEC_PER_SEC;
+
+        frames              = (int32_t)CLAMP(late, -max_frames, max_frames);
+        sync_stream.trimmed = -frames;
+    }
+
+    k_mutex_unlock(&sync_cfg.lock);
+
+    return frames;
+}
+
+/**
+ * @brief Reports when an output sample is heard.
+ *
+ * @param play_us   Uptime in us the sample leaves the output.
+ * @param out_frame Index of the sample in the output since the start.
+ */
+void audio_sync_stream_playout(int64_t play_us, uint64_t out_frame)
+{
+    k_mutex_lock(&sync_cfg.lock, K_FOREVER);
+
+    if (!sync_status.stream_active || !sync_status.synced) {
+        k_mutex_unlock(&sync_cfg.lock);
+        return;
+    }
+
+    int64_t net_play_us = play_us + sync_offset_at(play_us);
+    int64_t frame       = (int64_t)out_frame - sync_stream.trimmed;
+    int64_t due_us      = sync_stream.net_start_us +
+                     frame * USEC_PER_SEC / sync_stream.sample_rate;
+    int32_t error_us =
+            (int32_t)CLAMP(net_play_us - due_us, INT32_MIN, INT32_MAX);
+
+    if (!sync_stream.error_valid) {
+        sync_status.play_error_us = error_us;
+        sync_stream.error_valid   = true;
+    } else {
+        sync_status.play_error_us += (error_us - sync_status.play_error_us) /
+                                     SYNC_ERROR_FILTER_N;
+    }
+
+    k_mutex_unlock(&sync_cfg.lock);
+}
+
+/**
+ * @brief Resamples a packet by one sample with linear interpolation.
+ *
+ * The first and the last samples are kept, the samples in between are
+ * spread evenly. Growing runs backwards and shrinking forwards, so the
+ * samples still to be read are never overwritten.
+ *
+ * @param pcm Samples, with room for `out` samples.
+ * @param in  Number of input samples.
+ * @param out Number of output samples, in + 1 or in - 1.
+ *
+ * @return Number of output samples.
+ */
+static size_t sync_resample(int16_t *pcm, size_t in, size_t out)
+{
+    uint32_t step = (uint32_t)(((uint64_t)(in - 1) << 16) / (out - 1));
+
+    if (out > in) {
+        pcm[out - 1] = pcm[in - 1];
+        for (size_t i = out - 2; i > 0; i--) {
+            uint32_t pos  = i * step;
+            size_t   idx  = pos >> 16;
+            int32_t  diff = pcm[idx + 1] - pcm[idx];
+
+            pcm[i] = pcm[idx] + (int16_t)(((int64_t)diff * (pos & 0xFFFF)) >>
+                                          16);
+        }
+    } else {
+        for (size_t i = 1; i < out - 1; i++) {
+            uint32_t pos  = i * step;
+            size_t   idx  = pos >> 16;
+            int32_t  diff = pcm[idx + 1] - pcm[idx];
+
+            pcm[i] = pcm[idx] + (int16_t)(((int64_t)diff * (pos & 0xFFFF)) >>
+                                          16);
+        }
+        pcm[out - 1] = pcm[in - 1];
+    }
+
+    return out;
+}
+
+/**
+ * @brief Trims one packet of mono samples towards the network clock.
+ *
+ * At most one sample is inserted or dropped per call, the buffer must
+ * have room for one sample more than `samples`.
+ *
+ * @param pcm     Samples to trim in place.
+ * @param samples Number of samples, at least 3.
+ *
+ * @return Number of samples after the trim.
+ */
+size_t audio_sync_stream_trim(int16_t *pcm, size_t samples)
+{
+    int step = 0;
+
+    k_mutex_lock(&sync_cfg.lock, K_FOREVER);
+
+    if (sync_status.stream_active && sync_stream.error_valid && samples >= 3) {
+        int32_t sample_us = USEC_PER_SEC / sync_stream.sample_rate;
+
+        sync_stream.frames_since_trim += samples;
+
+        if (sync_stream.frames_since_trim >= sync_stream.trim_interval) {
+            // The filter is moved right away, the trim shows up in the
+            // playout reports only after the queued blocks are heard
+            if (sync_status.play_error_us > sample_us) {
+                step = -1;
+                sync_status.dropped++;
+                sync_status.play_error_us -= sample_us;
+            } else if (sync_status.play_error_us < -sample_us) {
+                step = 1;
+                sync_status.inserted++;
+                sync_status.play_error_us += sample_us;
+            }
+        }
+
+        if (step != 0) {
+            sync_stream.trimmed += step;
+            sync_stream.frames_since_trim = 0;
+        }
+    }
+
+    k_mutex_unlock(&sync_cfg.lock);
+
+    if (step == 0) {
+        return samples;
+    }
+
+    return sync_resample(pcm, samples, samples + step);
+}
+
+/**
+ * @brief Stops tracking the synchronized stream and logs its trim.
+ */
+void audio_sync_stream_stop(void)
+{
+    k_mutex_lock(&sync_cfg.lock, K_FOREVER);
+
+    if (sync_status.stream_active) {
+        LOG_INF("Synchronized stream: %u inserted, %u dropped, error %d us",
+                sync_status.inserted,
+                sync_status.dropped,
+                sync_status.play_error_us);
+    }
+    sync_status.stream_active = false;
+
+    k_mutex_unlock(&sync_cfg.lock);
+}
+
+/**
+ * @brief Gets the state of the clock discipline and of the stream trim.
+ *
+ * @param status Pointer to store the status.
+ */
+void audio_sync_get_status(struct audio_sync_status *status)
+{
+    if (!status) {
+        return;
+    }
+
+    k_mutex_lock(&sync_cfg.lock, K_FOREVER);
+    *status = sync_status;
+    k_mutex_unlock(&sync_cfg.lock);
+}
+
+/**
+ * @brief Clock discipline thread, polls the time server.
+ *
+ * Polls fast until the fit window is full, then every
+ * CONFIG_RPR_AUDIO_SYNC_POLL_S seconds.
+ */
+static void audio_sync_thread(void)
+{
+    while (1) {
+        uint32_t wait_s = CONFIG_RPR_AUDIO_SYNC_POLL_S;
+
+        if (audio_sync_update() < 0) {
+            wait_s = SYNC_RETRY_S;
+        } else if (sync_status.samples < SYNC_WINDOW) {
+            wait_s = SYNC_FAST_POLL_S;
+        }
+
+        k_sleep(K_SECONDS(wait_s));
+    }
+}
+
+K_THREAD_DEFINE(audio_sync_thread_id,
+                SYNC_THREAD_STACK_SIZE,
+                audio_sync_thread,
+                NULL,
+                NULL,
+                NULL,
+                SYNC_THREAD_PRIORITY,
+                0,
+                0);
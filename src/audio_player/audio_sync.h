@@ -0,0 +1,133 @@
+/**
+ * @file audio_sync.h
+ * @brief Network clock discipline and playout trim for synchronized audio.
+ *
+ * A background thread queries an SNTP server and fits the offset and the
+ * drift of the local uptime clock against the network time over a window
+ * of samples. Speakers that agree on a network start time map it to their
+ * own uptime with this fit and hold the stream until then.
+ *
+ * While a synchronized stream plays, the player reports when each block
+ * is heard. The error against the network clock is filtered and cancelled
+ * by inserting or dropping single samples, spread over one packet by
+ * linear interpolation.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_SYNC_H_
+#define AUDIO_SYNC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct audio_sync_status {
+    bool     synced;
+    uint32_t samples;       /* Samples in the current fit */
+    uint32_t steps;         /* Fit restarts (first sync included) */
+    uint32_t failures;      /* Failed or rejected queries */
+    int64_t  last_sync_ms;  /* Uptime of the last accepted sample */
+    uint32_t last_rtt_us;   /* Round trip of the last accepted sample */
+    int32_t  last_error_us; /* Last sample against the fit before it */
+    int32_t  drift_ppb;     /* Network minus local clock rate */
+    bool     stream_active; /* A synchronized stream is playing */
+    int32_t  play_error_us; /* Filtered playout error, + is late */
+    uint32_t inserted;      /* Samples inserted in the current stream */
+    uint32_t dropped;       /* Samples dropped in the current stream */
+};
+
+/**
+ * @brief Queries the time server now and updates the clock fit.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_sync_update(void);
+
+/**
+ * @brief Converts a local uptime to network time.
+ *
+ * @param local_us System uptime in microseconds.
+ * @param net_us   Pointer to store the network (Unix epoch) time in us.
+ *
+ * @return 0 on success, -EAGAIN if the clock is not synchronized yet.
+ */
+int audio_sync_to_network(int64_t local_us, int64_t *net_us);
+
+/**
+ * @brief Converts a network time to local uptime.
+ *
+ * @param net_us   Network (Unix epoch) time in microseconds.
+ * @param local_us Pointer to store the system uptime in us.
+ *
+ * @return 0 on success, -EAGAIN if the clock is not synchronized yet.
+ */
+int audio_sync_to_local(int64_t net_us, int64_t *local_us);
+
+/**
+ * @brief Gets the current network time.
+ *
+ * @param net_us Pointer to store the network (Unix epoch) time in us.
+ *
+ * @return 0 on success, -EAGAIN if the clock is not synchronized yet.
+ */
+int audio_sync_now(int64_t *net_us);
+
+/**
+ * @brief Starts tracking the playout of a synchronized stream.
+ *
+ * @param net_start_us Network time the first stream sample is due at.
+ * @param sample_rate  Output sample rate in Hz.
+ */
+void audio_sync_stream_start(int64_t net_start_us, uint32_t sample_rate);
+
+/**
+ * @brief Aligns the first output sample to the network start time.
+ *
+ * The start hold of the player is accurate to half a block, the rest is
+ * removed by delaying the stream with silence or skipping its first
+ * samples.
+ *
+ * @param play_us    Uptime in us the first output sample is heard at.
+ * @param max_frames Maximum number of frames to pad or skip.
+ *
+ * @return Frames to skip from the stream start, negative to pad with
+ *         silence.
+ */
+int32_t audio_sync_stream_align(int64_t play_us, int32_t max_frames);
+
+/**
+ * @brief Reports when an output sample is heard.
+ *
+ * @param play_us   Uptime in us the sample leaves the output.
+ * @param out_frame Index of the sample in the output since the start.
+ */
+void audio_sync_stream_playout(int64_t play_us, uint64_t out_frame);
+
+/**
+ * @brief Trims one packet of mono samples towards the network clock.
+ *
+ * At most one sample is inserted or dropped per call, the buffer must
+ * have room for one sample more than `samples`.
+ *
+ * @param pcm     Samples to trim in place.
+ * @param samples Number of samples, at least 3.
+ *
+ * @return Number of samples after the trim.
+ */
+size_t audio_sync_stream_trim(int16_t *pcm, size_t samples);
+
+/**
+ * @brief Stops tracking the synchronized stream and logs its trim.
+ */
+void audio_sync_stream_stop(void);
+
+/**
+ * @brief Gets the state of the clock discipline and of the stream trim.
+ *
+ * @param status Pointer to store the status.
+ */
+void audio_sync_get_status(struct audio_sync_status *status);
+
+#endif /* AUDIO_SYNC_H_ */
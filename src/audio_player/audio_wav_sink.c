@@ -0,0 +1,230 @@
+/**
+ * @file audio_wav_sink.c
+ * @brief Real-time paced WAV file output for boards without I2S.
+ *
+ * The header is written with empty sizes when the stream opens and is
+ * completed on close. Writes sleep until the samples are due, so the
+ * player and the synchronized playout trim see the same timing as with
+ * a DMA-driven I2S.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+#ifdef CONFIG_ARCH_POSIX
+#include <native_rtc.h>
+#endif
+
+#include "audio_player.h"
+#include "audio_wav_sink.h"
+
+LOG_MODULE_REGISTER(audio_wav_sink, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
+
+#define WAV_FMT_SIZE   16
+#define WAV_SYNC_SIZE  24
+#define WAV_HEADER_LEN (12 + 8 + WAV_FMT_SIZE + 8 + WAV_SYNC_SIZE + 8)
+
+#define WAV_SYNC_VERSION    1
+#define WAV_SYNC_NET_VALID  BIT(0)
+#define WAV_SYNC_HOST_VALID BIT(1)
+
+struct audio_wav_sink {
+    struct fs_file_t file;
+    bool             is_open;
+    uint32_t         sample_rate;
+    int64_t          start_us;
+    uint64_t         samples;
+};
+
+static struct audio_wav_sink wav_sink;
+
+/**
+ * @brief Builds the WAV header for the given data size.
+ *
+ * @param hdr      Buffer of WAV_HEADER_LEN bytes.
+ * @param data_len Size of the sample data in bytes.
+ * @param flags    WAV_SYNC_* validity flags.
+ * @param net_us   Network time of the first sample.
+ * @param host_us  Host time of the first sample.
+ */
+static void wav_build_header(uint8_t *hdr,
+                             uint32_t data_len,
+                             uint32_t flags,
+                             int64_t  net_us,
+                             int64_t  host_us)
+{
+    uint8_t *p = hdr;
+
+    memcpy(p, "RIFF", 4);
+    sys_put_le32(WAV_HEADER_LEN - 8 + data_len, p + 4);
+    memcpy(p + 8, "WAVE", 4);
+    p += 12;
+
+    memcpy(p, "fmt ", 4);
+    sys_put_le32(WAV_FMT_SIZE, p + 4);
+    sys_put_le16(1, p + 8); // PCM
+    sys_put_le16(1, p + 10);
+    sys_put_le32(wav_sink.sample_rate, p + 12);
+    sys_put_le32(wav_sink.sample_rate * sizeof(int16_t), p + 16);
+    sys_put_le16(sizeof(int16_t), p + 20);
+    sys_put_le16(16, p + 22);
+    p += 8 + WAV_FMT_SIZE;
+
+    memcpy(p, "sync", 4);
+    sys_put_le32(WAV_SYNC_SIZE, p + 4);
+    sys_put_le32(WAV_SYNC_VERSION, p + 8);
+    sys_put_le32(flags, p + 12);
+    sys_put_le64((uint64_t)net_us, p + 16);
+    sys_put_le64((uint64_t)host_us, p + 24);
+    p += 8 + WAV_SYNC_SIZE;
+
+    memcpy(p, "data", 4);
+    sys_put_le32(data_len, p + 4);
+}
+
+/**
+ * @brief Creates the capture file and starts the output timeline.
+ *
+ * @param path        Path of the WAV file, overwritten if it exists.
+ * @param sample_rate Sample rate in Hz.
+ * @param start_us    Uptime in us the first sample is played at, 0 for now.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_wav_sink_open(const char *path,
+                        uint32_t    sample_rate,
+                        int64_t     start_us)
+{
+    uint8_t  hdr[WAV_HEADER_LEN];
+    int64_t  now_us  = k_ticks_to_us_floor64(k_uptime_ticks());
+    int64_t  net_us  = 0;
+    int64_t  host_us = 0;
+    uint32_t flags   = 0;
+
+    if (wav_sink.is_open) {
+        audio_wav_sink_close();
+    }
+
+    wav_sink.sample_rate = sample_rate;
+    wav_sink.start_us    = MAX(start_us, now_us);
+    wav_sink.samples     = 0;
+
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    if (audio_sync_to_network(wav_sink.start_us, &net_us) == 0) {
+        flags |= WAV_SYNC_NET_VALID;
+    }
+#endif
+#ifdef CONFIG_ARCH_POSIX
+    host_us = (int64_t)native_rtc_gettime_us(RTC_CLOCK_PSEUDOHOSTREALTIME) +
+              (wav_sink.start_us - now_us);
+    flags |= WAV_SYNC_HOST_VALID;
+#endif
+
+    fs_file_t_init(&wav_sink.file);
+    fs_unlink(path);
+
+    int ret = fs_open(&wav_sink.file, path, FS_O_CREATE | FS_O_RDWR);
+    if (ret < 0) {
+        LOG_ERR("Cannot create %s (%d)", path, ret);
+        return ret;
+    }
+
+    wav_build_header(hdr, 0, flags, net_us, host_us);
+    if (fs_write(&wav_sink.file, hdr, sizeof(hdr)) != sizeof(hdr)) {
+        fs_close(&wav_sink.file);
+        return -EIO;
+    }
+
+    wav_sink.is_open = true;
+    LOG_INF("WAV sink %s, first sample at net %lld us", path, net_us);
+
+    return 0;
+}
+
+/**
+ * @brief Returns the uptime in us the next written sample is played at.
+ */
+int64_t audio_wav_sink_play_time(void)
+{
+    return wav_sink.start_us +
+           (int64_t)(wav_sink.samples * USEC_PER_SEC / wav_sink.sample_rate);
+}
+
+/**
+ * @brief Writes mono samples, waiting until they are due like a DMA would.
+ *
+ * @param pcm     Samples to write.
+ * @param samples Number of samples.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_wav_sink_write(const int16_t *pcm, size_t samples)
+{
+    if (!wav_sink.is_open) {
+        return -EBADF;
+    }
+
+    int64_t wait_us = audio_wav_sink_play_time() -
+                      k_ticks_to_us_floor64(k_uptime_ticks());
+    if (wait_us > 0) {
+        k_sleep(K_USEC(wait_us));
+    }
+
+    size_t  len = samples * sizeof(int16_t);
+    ssize_t ret = fs_write(&wav_sink.file, pcm, len);
+    if (ret != (ssize_t)len) {
+        LOG_ERR("WAV sink write failed (%d)", (int)ret);
+        return ret < 0 ? (int)ret : -ENOSPC;
+    }
+
+    wav_sink.samples += samples;
+    return 0;
+}
+
+/**
+ * @brief Completes the WAV header and closes the capture file.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_wav_sink_close(void)
+{
+    uint8_t size[4];
+
+    if (!wav_sink.is_open) {
+        return 0;
+    }
+    wav_sink.is_open = false;
+
+    uint32_t data_len = (uint32_t)(wav_sink.samples * sizeof(int16_t));
+
+    // Only the two sizes change, the time stamps are kept as written
+    int ret = fs_seek(&wav_sink.file, 4, FS_SEEK_SET);
+    if (ret == 0) {
+        sys_put_le32(WAV_HEADER_LEN - 8 + data_len, size);
+        ret = fs_write(&wav_sink.file, size, sizeof(size)) == sizeof(size)
+                      ? 0
+                      : -EIO;
+    }
+
+    if (ret == 0) {
+        ret = fs_seek(&wav_sink.file, WAV_HEADER_LEN - 4, FS_SEEK_SET);
+    }
+
+    if (ret == 0) {
+        sys_put_le32(data_len, size);
+        ret = fs_write(&wav_sink.file, size, sizeof(size)) == sizeof(size)
+                      ? 0
+                      : -EIO;
+    }
+
+    fs_close(&wav_sink.file);
+
+    LOG_INF("WAV sink closed, %llu samples", wav_sink.samples);
+    return ret;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file audio_wav_sink.h
+ * @brief Real-time paced WAV file output for boards without I2S.
+ *
+ * The sink stands in for the I2S on test targets such as native_sim. Each
+ * stream is written to a 16-bit mono WAV file at the pace it would be
+ * played, starting at the requested uptime. A "sync" chunk records the
+ * network time and, on native_sim, the host time of the first sample, so
+ * the captures of two instances can be aligned and compared with
+ * script/measure_sync_skew.py.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef AUDIO_WAV_SINK_H_
+#define AUDIO_WAV_SINK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Creates the capture file and starts the output timeline.
+ *
+ * @param path        Path of the WAV file, overwritten if it exists.
+ * @param sample_rate Sample rate in Hz.
+ * @param start_us    Uptime in us the first sample is played at, 0 for now.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_wav_sink_open(const char *path,
+                        uint32_t    sample_rate,
+                        int64_t     start_us);
+
+/**
+ * @brief Returns the uptime in us the next written sample is played at.
+ */
+int64_t audio_wav_sink_play_time(void);
+
+/**
+ * @brief Writes mono samples, waiting until they are due like a DMA would.
+ *
+ * @param pcm     Samples to write.
+ * @param samples Number of samples.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_wav_sink_write(const int16_t *pcm, size_t samples);
+
+/**
+ * @brief Completes the WAV header and closes the capture file.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int audio_wav_sink_close(void);
+
+#endif /* AUDIO_WAV_SINK_H_ */
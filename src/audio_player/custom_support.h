@@ -0,0 +1,25 @@
+/**
+ * @file custom_support.h
+ * @brief Opus allocation overrides, included by os_support.h.
+ *
+ * Only used when Opus is built with CUSTOM_SUPPORT, see
+ * CONFIG_RPR_AUDIO_OPUS_SCRATCH. The pseudo-stack of Opus is served from
+ * the scratch arena instead of the heap.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef CUSTOM_SUPPORT_H_
+#define CUSTOM_SUPPORT_H_
+
+#include "opus_scratch.h"
+
+#define OVERRIDE_OPUS_ALLOC_SCRATCH
+
+static inline void *opus_alloc_scratch(size_t size)
+{
+    return opus_scratch_alloc(size);
+}
+
+#endif /* CUSTOM_SUPPORT_H_ */
@@ -20,6 +20,10 @@
 /* Includes ------------------------------------------------------------------*/
 #include "opus_interface.h"
 
+#ifdef CONFIG_RPR_AUDIO_OPUS_SCRATCH
+#include "opus_scratch.h"
+#endif
+
 /** @addtogroup OPT
   * @{
   */
@@ -74,6 +78,7 @@ static OPUS_HandleTypeDef hOpus = {.ENC_configured = 0, .DEC_configured = 0};
 
 /* Global variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
+static int DEC_Opus_Result(int ret);
 
 /** @defgroup OPT_OPUS_INTERFACE_Exported_Functions OPT_OPUS_INTERFACE_Exported_Functions
   * @{
@@ -180,6 +185,11 @@ Opus_Status DEC_Opus_Init(DEC_Opus_ConfigTypeDef *DEC_configOpus, int *opus_err)
   *opus_err = 0;
   hOpus.DEC_frame_size = ((uint32_t)(((float)(DEC_configOpus->sample_freq/1000))*DEC_configOpus->ms_frame));
 
+#ifdef CONFIG_RPR_AUDIO_OPUS_SCRATCH
+  /*Scratch arena painted for the high-water mark*/
+  opus_scratch_reset();
+#endif
+
   /*Decoder Init*/
   hOpus.Decoder = opus_decoder_create(DEC_configOpus->sample_freq, DEC_configOpus->channels, opus_err);
   
@@ -339,7 +349,47 @@ int ENC_Opus_Encode(uint8_t * buf_in, uint8_t * buf_out)
  */
 int DEC_Opus_Decode(uint8_t * buf_in, uint32_t len, uint8_t * buf_out) 
 {
-  return opus_decode(hOpus.Decoder, (unsigned char *) buf_in, (opus_int32) len, (opus_int16 *) buf_out, hOpus.DEC_frame_size, 0);
+  return DEC_Opus_Result(opus_decode(hOpus.Decoder, (unsigned char *) buf_in, (opus_int32) len, (opus_int16 *) buf_out, hOpus.DEC_frame_size, 0));
+}
+
+/**
+ * @brief  Decodes a lost frame from the in-band FEC of the next packet
+ * @param  buf_in: pointer to the Encoded packet following the lost one.
+ * @param  len: length of the buffer in.
+ * @param  buf_out: pointer to the Decoded buffer.
+ * @param  frame_size: number of samples of the lost frame.
+ * @retval Number of decoded samples or @ref opus_errorcodes.
+ */
+int DEC_Opus_DecodeFEC(uint8_t * buf_in, uint32_t len, uint8_t * buf_out, int frame_size) 
+{
+  return DEC_Opus_Result(opus_decode(hOpus.Decoder, (unsigned char *) buf_in, (opus_int32) len, (opus_int16 *) buf_out, frame_size, 1));
+}
+
+/**
+ * @brief  Conceals a lost frame (packet loss concealment)
+ * @param  buf_out: pointer to the Decoded buffer.
+ * @param  frame_size: number of samples of the lost frame.
+ * @retval Number of decoded samples or @ref opus_errorcodes.
+ */
+int DEC_Opus_Conceal(uint8_t * buf_out, int frame_size) 
+{
+  return DEC_Opus_Result(opus_decode(hOpus.Decoder, NULL, 0, (opus_int16 *) buf_out, frame_size, 0));
+}
+
+/**
+ * @brief  Checks the scratch arena after a decoder call
+ * @param  ret: result of the decoder call.
+ * @retval The result, or OPUS_INTERNAL_ERROR if the scratch arena overflowed.
+ */
+static int DEC_Opus_Result(int ret)
+{
+#ifdef CONFIG_RPR_AUDIO_OPUS_SCRATCH
+  if (opus_scratch_check() != 0)
+  {
+    return OPUS_INTERNAL_ERROR;
+  }
+#endif
+  return ret;
 }
 
 /**
@@ -121,6 +121,8 @@ Opus_Status ENC_Opus_Force_SILKmode(void);
 Opus_Status ENC_Opus_Force_CELTmode(void);
 int ENC_Opus_Encode(uint8_t * buf_in, uint8_t * buf_out);
 int DEC_Opus_Decode(uint8_t * buf_in, uint32_t len, uint8_t * buf_out);
+int DEC_Opus_DecodeFEC(uint8_t * buf_in, uint32_t len, uint8_t * buf_out, int frame_size);
+int DEC_Opus_Conceal(uint8_t * buf_out, int frame_size);
 
 #ifdef __cplusplus
 }
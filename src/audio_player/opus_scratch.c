@@ -0,0 +1,110 @@
+/**
+ * @file opus_scratch.c
+ * @brief Scratch arena for Opus temporaries.
+ *
+ * The arena is a static buffer followed by a guard. It is painted with a
+ * fixed byte when a decoder is created; the highest byte that lost the
+ * paint is the high-water mark, so measuring costs nothing while decoding.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include "opus_scratch.h"
+
+LOG_MODULE_REGISTER(opus_scratch, CONFIG_RPR_MODULE_AUDIO_PLAYER_LOG_LEVEL);
+
+#define SCRATCH_SIZE  CONFIG_RPR_AUDIO_OPUS_SCRATCH_SIZE
+#define SCRATCH_GUARD 64
+#define SCRATCH_PAINT 0xAA
+
+static uint8_t arena[SCRATCH_SIZE + SCRATCH_GUARD] __aligned(8);
+
+static struct opus_scratch_stats scratch_stats = {
+    .size = SCRATCH_SIZE,
+};
+
+static bool painted;
+
+static K_MUTEX_DEFINE(scratch_mutex);
+
+/**
+ * @brief Raises the peak to the highest byte that lost the paint.
+ *
+ * Only the bytes above the known peak are scanned.
+ */
+static void opus_scratch_measure(void)
+{
+    if (!painted) {
+        return;
+    }
+
+    uint32_t used = SCRATCH_SIZE;
+
+    while (used > scratch_stats.peak && arena[used - 1] == SCRATCH_PAINT) {
+        used--;
+    }
+
+    scratch_stats.peak = MAX(scratch_stats.peak, used);
+}
+
+void *opus_scratch_alloc(size_t size)
+{
+    if (size > SCRATCH_SIZE) {
+        LOG_WRN("Opus expects %zu bytes of scratch, the arena has %u",
+                size,
+                SCRATCH_SIZE);
+    }
+
+    scratch_stats.attached = true;
+
+    return arena;
+}
+
+void opus_scratch_reset(void)
+{
+    k_mutex_lock(&scratch_mutex, K_FOREVER);
+
+    opus_scratch_measure();
+    memset(arena, SCRATCH_PAINT, sizeof(arena));
+    painted = true;
+
+    k_mutex_unlock(&scratch_mutex);
+}
+
+int opus_scratch_check(void)
+{
+    if (!painted) {
+        return 0;
+    }
+
+    for (uint32_t i = SCRATCH_SIZE; i < sizeof(arena); i++) {
+        if (arena[i] != SCRATCH_PAINT) {
+            scratch_stats.overflows++;
+            LOG_ERR("Opus scratch arena of %u bytes overflowed", SCRATCH_SIZE);
+            memset(arena + SCRATCH_SIZE, SCRATCH_PAINT, SCRATCH_GUARD);
+            return -EOVERFLOW;
+        }
+    }
+
+    return 0;
+}
+
+void opus_scratch_get_stats(struct opus_scratch_stats *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    k_mutex_lock(&scratch_mutex, K_FOREVER);
+
+    opus_scratch_measure();
+    *stats = scratch_stats;
+
+    k_mutex_unlock(&scratch_mutex);
+}
@@ -0,0 +1,67 @@
+/**
+ * @file opus_scratch.h
+ * @brief Scratch arena for Opus temporaries.
+ *
+ * With CONFIG_RPR_AUDIO_OPUS_SCRATCH, Opus is built with
+ * NONTHREADSAFE_PSEUDOSTACK instead of VAR_ARRAYS: the temporaries the codec
+ * would put on the calling thread stack are pushed onto a fixed arena
+ * instead. custom_support.h routes the arena request of Opus here. The
+ * arena is painted when a decoder is created, which gives its high-water
+ * mark, and ends with a guard that catches an overflow after each call.
+ *
+ * The pseudo-stack is shared by all Opus calls, so Opus must only be used
+ * from the audio thread.
+ *
+ * This header is included by every Opus source file.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef OPUS_SCRATCH_H_
+#define OPUS_SCRATCH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct opus_scratch_stats {
+    uint32_t size;      /* Arena size without the guard */
+    uint32_t peak;      /* Highest use measured since boot */
+    uint32_t overflows; /* Calls that reached the guard */
+    bool     attached;  /* Opus has taken the arena */
+};
+
+/**
+ * @brief Hands the arena to Opus.
+ *
+ * Called by Opus once, on its first call that needs temporaries.
+ *
+ * @param size Requested size, GLOBAL_STACK_SIZE of the Opus build.
+ *
+ * @return Start of the arena.
+ */
+void *opus_scratch_alloc(size_t size);
+
+/**
+ * @brief Paints the arena before a new decoder starts using it.
+ *
+ * Must not be called while an Opus call is running.
+ */
+void opus_scratch_reset(void);
+
+/**
+ * @brief Checks the guard behind the arena after an Opus call.
+ *
+ * @return 0 if the arena held, -EOVERFLOW if the guard was written.
+ */
+int opus_scratch_check(void);
+
+/**
+ * @brief Measures the arena use and gets the statistics.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void opus_scratch_get_stats(struct opus_scratch_stats *stats);
+
+#endif /* OPUS_SCRATCH_H_ */
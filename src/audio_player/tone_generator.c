@@ -0,0 +1,304 @@
+/**
+ * @file tone_generator.c
+ * @brief Fixed-point siren and test tone synthesizer for the audio player.
+ *
+ * The generator produces standard warning sirens (wail, yelp, hi-lo) and a
+ * steady test tone without any stored audio. Samples are synthesized with a
+ * 32-bit phase accumulator driving an interpolated sine wavetable, while a
+ * second accumulator sweeps the oscillator frequency between two limits.
+ * A short linear attack/release envelope avoids clicks at the edges.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "tone_generator.h"
+
+#define TONE_TABLE_BITS      8
+#define TONE_INDEX_SHIFT     (32 - TONE_TABLE_BITS)
+#define TONE_FRAC_SHIFT      (TONE_INDEX_SHIFT - 16)
+#define TONE_Q15_ONE         32767
+#define TONE_ENVELOPE_MS     5
+#define TONE_CONTROL_SAMPLES 16 // Sweep is re-evaluated every 16 samples
+#define TONE_HALF_TURN       0x80000000u
+
+struct tone_profile {
+    const char  *name;
+    uint16_t     freq_low_hz;
+    uint16_t     freq_high_hz;
+    uint16_t     sweep_period_ms;
+    tone_sweep_t sweep;
+};
+
+static const struct tone_profile tone_profiles[AUDIO_TONE_COUNT] = {
+    [AUDIO_TONE_TEST]  = { "test", 1000, 1000, 0, TONE_SWEEP_NONE },
+    [AUDIO_TONE_WAIL]  = { "wail", 600, 1200, 4000, TONE_SWEEP_TRIANGLE },
+    [AUDIO_TONE_YELP]  = { "yelp", 600, 1200, 320, TONE_SWEEP_TRIANGLE },
+    [AUDIO_TONE_HI_LO] = { "hilo", 770, 960, 1000, TONE_SWEEP_STEP },
+};
+
+/* One full sine period in Q15, the extra entry simplifies interpolation. */
+static const int16_t sine_table[(1 << TONE_TABLE_BITS) + 1] = {
+         0,    804,   1608,   2410,   3212,   4011,   4808,   5602,
+      6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793,
+     12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+     18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+     23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,
+     27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+     30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,
+     32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+     32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+     32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+     30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,
+     27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+     23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,
+     18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+     12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+      6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,
+         0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602,
+     -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530,
+    -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971,
+    -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285,
+    -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868,
+    -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,
+     -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804,
+         0,
+};
+
+/**
+ * @brief Converts a frequency to a 32-bit phase increment per sample.
+ */
+static uint32_t tone_freq_to_inc(uint32_t freq_hz, uint32_t sample_rate)
+{
+    return (uint32_t)(((uint64_t)freq_hz << 32) / sample_rate);
+}
+
+/**
+ * @brief Evaluates the oscillator phase increment at the current sweep position.
+ */
+static uint32_t tone_sweep_increment(const struct tone_generator *gen)
+{
+    uint32_t pos;
+
+    switch (gen->sweep) {
+    case TONE_SWEEP_TRIANGLE:
+        // Rising during the first half of the period, falling in the second
+        pos = gen->sweep_phase << 1;
+        if (gen->sweep_phase & TONE_HALF_TURN) {
+            pos = ~pos;
+        }
+        break;
+    case TONE_SWEEP_STEP:
+        return (gen->sweep_phase & TONE_HALF_TURN) ? gen->inc_low :
+                                                     gen->inc_high;
+    default:
+        return gen->inc_low;
+    }
+
+    return gen->inc_low +
+           (uint32_t)(((uint64_t)(gen->inc_high - gen->inc_low) * pos) >> 32);
+}
+
+/**
+ * @brief Initializes the generator for the selected tone.
+ *
+ * @param gen         Generator state to initialize.
+ * @param tone        Tone or siren pattern.
+ * @param sample_rate Output sample rate in Hz.
+ * @param duration_ms Tone duration in milliseconds, 0 to play until stopped.
+ * @param amplitude   Peak amplitude in Q15 (0..32767).
+ *
+ * @return 0 on success, -EINVAL on invalid parameters.
+ */
+int tone_generator_init(struct tone_generator *gen,
+                        audio_tone_t           tone,
+                        uint32_t               sample_rate,
+                        uint32_t               duration_ms,
+                        int32_t                amplitude)
+{
+    if (!gen || tone >= AUDIO_TONE_COUNT || sample_rate == 0 ||
+        amplitude < 0 || amplitude > TONE_Q15_ONE) {
+        return -EINVAL;
+    }
+
+    const struct tone_profile *profile = &tone_profiles[tone];
+
+    memset(gen, 0, sizeof(*gen));
+
+    gen->sweep     = profile->sweep;
+    gen->inc_low   = tone_freq_to_inc(profile->freq_low_hz, sample_rate);
+    gen->inc_high  = tone_freq_to_inc(profile->freq_high_hz, sample_rate);
+    gen->phase_inc = gen->inc_low;
+    gen->amplitude = amplitude;
+
+    if (profile->sweep_period_ms > 0) {
+        uint64_t period_samples =
+                (uint64_t)profile->sweep_period_ms * sample_rate / 1000;
+        gen->sweep_inc = (uint32_t)((1ULL << 32) / period_samples);
+    }
+
+    gen->env_len = sample_rate * TONE_ENVELOPE_MS / 1000;
+    if (gen->env_len == 0) {
+        gen->env_len = 1;
+    }
+    gen->env_step = TONE_Q15_ONE / gen->env_len;
+    if (gen->env_step == 0) {
+        gen->env_step = 1;
+    }
+
+    gen->infinite = (duration_ms == 0);
+    gen->samples_left =
+            (uint32_t)((uint64_t)duration_ms * sample_rate / 1000);
+
+    return 0;
+}
+
+/**
+ * @brief Synthesizes the next mono samples of the tone.
+ *
+ * When the tone ends inside the requested range, the rest of the buffer
+ * is filled with silence.
+ *
+ * @param gen     Initialized generator state.
+ * @param buf     Output buffer for 16-bit PCM samples.
+ * @param samples Number of samples to produce.
+ *
+ * @return Number of tone samples produced (less than `samples` at the end).
+ */
+size_t tone_generator_fill(struct tone_generator *gen,
+                           int16_t               *buf,
+                           size_t                 samples)
+{
+    if (!gen || !buf) {
+        return 0;
+    }
+
+    size_t produced = 0;
+
+    while (produced < samples) {
+        size_t chunk = samples - produced;
+
+        if (chunk > TONE_CONTROL_SAMPLES) {
+            chunk = TONE_CONTROL_SAMPLES;
+        }
+        if (!gen->infinite && chunk > gen->samples_left) {
+            chunk = gen->samples_left;
+        }
+        if (chunk == 0) {
+            break;
+        }
+
+        uint32_t phase     = gen->phase;
+        uint32_t phase_inc = tone_sweep_increment(gen);
+        int32_t  gain      = gen->env_gain;
+
+        for (size_t i = 0; i < chunk; i++) {
+            uint32_t idx  = phase >> TONE_INDEX_SHIFT;
+            int32_t  frac = (phase >> TONE_FRAC_SHIFT) & 0xFFFF;
+            int32_t  a    = sine_table[idx];
+            int32_t  b    = sine_table[idx + 1];
+            int32_t  s    = a + (((b - a) * frac) >> 16);
+            int32_t  g    = gain;
+
+            if (gain < TONE_Q15_ONE) {
+                gain += gen->env_step;
+                if (gain > TONE_Q15_ONE) {
+                    gain = TONE_Q15_ONE;
+                }
+            }
+
+            if (!gen->infinite) {
+                uint32_t left = gen->samples_left - i;
+                if (left < gen->env_len) {
+                    int32_t release = (int32_t)left * gen->env_step;
+                    if (release < g) {
+                        g = release;
+                    }
+                }
+            }
+
+            s                 = (s * gen->amplitude) >> 15;
+            buf[produced + i] = (int16_t)((s * g) >> 15);
+            phase += phase_inc;
+        }
+
+        gen->phase     = phase;
+        gen->phase_inc = phase_inc;
+        gen->env_gain  = gain;
+        gen->sweep_phase += gen->sweep_inc * (uint32_t)chunk;
+        if (!gen->infinite) {
+            gen->samples_left -= chunk;
+        }
+        produced += chunk;
+    }
+
+    if (produced < samples) {
+        memset(&buf[produced], 0, (samples - produced) * sizeof(int16_t));
+    }
+
+    return produced;
+}
+
+/**
+ * @brief Returns true once a tone with finite duration has been fully played.
+ *
+ * @param gen Generator state.
+ *
+ * @return true if finished, false otherwise.
+ */
+bool tone_generator_is_finished(const struct tone_generator *gen)
+{
+    return gen && !gen->infinite && gen->samples_left == 0;
+}
+
+/**
+ * @brief Parses a tone name ("test", "wail", "yelp", "hilo").
+ *
+ * @param name Tone name.
+ * @param tone Pointer to store the parsed tone.
+ *
+ * @return 0 on success, -EINVAL if the name is unknown.
+ */
+int tone_generator_parse_name(const char *name, audio_tone_t *tone)
+{
+    if (!name || !tone) {
+        return -EINVAL;
+    }
+
+    for (int i = 0; i < AUDIO_TONE_COUNT; i++) {
+        if (strcmp(name, tone_profiles[i].name) == 0) {
+            *tone = (audio_tone_t)i;
+            return 0;
+        }
+    }
+
+    return -EINVAL;
+}
+
+/**
+ * @brief Returns the printable name of a tone.
+ *
+ * @param tone Tone identifier.
+ *
+ * @return Tone name, or "unknown".
+ */
+const char *tone_generator_name(audio_tone_t tone)
+{
+    if (tone >= AUDIO_TONE_COUNT) {
+        return "unknown";
+    }
+
+    return tone_profiles[tone].name;
+}
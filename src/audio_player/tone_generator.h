@@ -0,0 +1,116 @@
+/**
+ * @file tone_generator.h
+ * @brief Fixed-point siren and test tone synthesizer for the audio player.
+ *
+ * The generator produces standard warning sirens (wail, yelp, hi-lo) and a
+ * steady test tone without any stored audio. Samples are synthesized with a
+ * 32-bit phase accumulator driving an interpolated sine wavetable, while a
+ * second accumulator sweeps the oscillator frequency between two limits.
+ * A short linear attack/release envelope avoids clicks at the edges.
+ *
+ * All arithmetic is integer-only, so the generator can run on every block
+ * in the audio thread without touching the flash or the FPU.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef TONE_GENERATOR_H_
+#define TONE_GENERATOR_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    AUDIO_TONE_TEST = 0,
+    AUDIO_TONE_WAIL,
+    AUDIO_TONE_YELP,
+    AUDIO_TONE_HI_LO,
+    AUDIO_TONE_COUNT
+} audio_tone_t;
+
+typedef enum {
+    TONE_SWEEP_NONE = 0,
+    TONE_SWEEP_TRIANGLE,
+    TONE_SWEEP_STEP,
+} tone_sweep_t;
+
+struct tone_generator {
+    tone_sweep_t sweep;
+    uint32_t     phase;      /* Oscillator phase, full turn = 2^32 */
+    uint32_t     phase_inc;  /* Current oscillator phase increment */
+    uint32_t     inc_low;    /* Phase increment of the lower frequency */
+    uint32_t     inc_high;   /* Phase increment of the upper frequency */
+    uint32_t     sweep_phase;
+    uint32_t     sweep_inc;  /* Sweep phase increment per sample */
+    int32_t      amplitude;  /* Peak amplitude, Q15 */
+    int32_t      env_gain;   /* Current envelope gain, Q15 */
+    int32_t      env_step;   /* Envelope gain change per sample, Q15 */
+    uint32_t     env_len;    /* Attack/release length in samples */
+    uint32_t     samples_left;
+    bool         infinite;
+};
+
+/**
+ * @brief Initializes the generator for the selected tone.
+ *
+ * @param gen         Generator state to initialize.
+ * @param tone        Tone or siren pattern.
+ * @param sample_rate Output sample rate in Hz.
+ * @param duration_ms Tone duration in milliseconds, 0 to play until stopped.
+ * @param amplitude   Peak amplitude in Q15 (0..32767).
+ *
+ * @return 0 on success, -EINVAL on invalid parameters.
+ */
+int tone_generator_init(struct tone_generator *gen,
+                        audio_tone_t           tone,
+                        uint32_t               sample_rate,
+                        uint32_t               duration_ms,
+                        int32_t                amplitude);
+
+/**
+ * @brief Synthesizes the next mono samples of the tone.
+ *
+ * When the tone ends inside the requested range, the rest of the buffer
+ * is filled with silence.
+ *
+ * @param gen     Initialized generator state.
+ * @param buf     Output buffer for 16-bit PCM samples.
+ * @param samples Number of samples to produce.
+ *
+ * @return Number of tone samples produced (less than `samples` at the end).
+ */
+size_t tone_generator_fill(struct tone_generator *gen,
+                           int16_t               *buf,
+                           size_t                 samples);
+
+/**
+ * @brief Returns true once a tone with finite duration has been fully played.
+ *
+ * @param gen Generator state.
+ *
+ * @return true if finished, false otherwise.
+ */
+bool tone_generator_is_finished(const struct tone_generator *gen);
+
+/**
+ * @brief Parses a tone name ("test", "wail", "yelp", "hilo").
+ *
+ * @param name Tone name.
+ * @param tone Pointer to store the parsed tone.
+ *
+ * @return 0 on success, -EINVAL if the name is unknown.
+ */
+int tone_generator_parse_name(const char *name, audio_tone_t *tone);
+
+/**
+ * @brief Returns the printable name of a tone.
+ *
+ * @param tone Tone identifier.
+ *
+ * @return Tone name, or "unknown".
+ */
+const char *tone_generator_name(audio_tone_t tone);
+
+#endif /* TONE_GENERATOR_H_ */
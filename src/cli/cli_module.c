@@ -17,6 +17,7 @@
 #include <zephyr/sys/printk.h>
 #include <zephyr/fs/fs.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "battery.h"
 #include "charger.h"
@@ -25,6 +26,11 @@
 #include "led_control.h"
 
 #include "audio_player.h"
+#include "audio_ogg.h"
+
+#ifdef CONFIG_RPR_AUDIO_OPUS_SCRATCH
+#include "opus_scratch.h"
+#endif
 
 #include "dev_info.h"
 #include "switch_module.h"
@@ -48,10 +54,34 @@
 #include "http_module.h"
 #endif
 
+#ifdef CONFIG_RPR_HTTP_ASYNC
+#include "http_async.h"
+#endif
+
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+#include "http_outbox.h"
+#endif
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+#include "http_cache.h"
+#endif
+
+#ifdef CONFIG_RPR_HTTP_SYNC
+#include "http_sync.h"
+#endif
+
 #ifdef CONFIG_RPR_MODULE_DFU
 #include "dfu_manager.h"
 #endif
 
+#ifdef CONFIG_RPR_FLASH_QOS
+#include "flash_qos.h"
+#endif
+
+#ifdef CONFIG_RPR_WRITE_BEHIND
+#include "write_behind.h"
+#endif
+
 #ifdef CONFIG_EXAMPLES_ENABLE_MAIN_EXAMPLES
 #include "power_supervisor.h"
 #endif
@@ -59,6 +89,8 @@
 #define FULL_FILE_PATH_MAX_LEN \
     (CONFIG_RPR_FOLDER_PATH_MAX_LEN + CONFIG_RPR_FILENAME_MAX_LEN)
 
+#define HTTP_BENCH_DIR CONFIG_RPR_FS_MNT_POINT "/bench"
+
 /**
  * @brief Command to set the RTC date and time.
  * 
@@ -1366,250 +1398,1483 @@ static int cmd_audio_ping(const struct shell *sh, size_t argc, char **argv)
 }
 
 /**
- * @brief Display a list of audio files in the default audio directory.
+ * @brief Shell command to list the recorded I2S recovery events.
  */
-static int
-cmd_audio_playlist_show(const struct shell *sh, size_t argc, char **argv)
+static int cmd_audio_recovery(const struct shell *sh, size_t argc, char **argv)
 {
-    struct fs_dir_t  dir;
-    struct fs_dirent entry;
-    int              index = 1;
+#ifdef CONFIG_RPR_AUDIO_RECOVERY
+    struct audio_recovery_event events[CONFIG_RPR_AUDIO_RECOVERY_LOG_SIZE];
+    uint32_t                    total = 0;
 
-    fs_dir_t_init(&dir);
-    if (fs_opendir(&dir, CONFIG_RPR_AUDIO_DEFAULT_PATH) != 0) {
-        shell_error(sh, "Failed to open directory");
-        return -ENOENT;
-    }
+    size_t count =
+            audio_player_get_recovery_events(events, ARRAY_SIZE(events), &total);
 
-    while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != 0) {
-        if (entry.type == FS_DIR_ENTRY_FILE) {
-            shell_print(sh, "%d: %s", index++, entry.name);
-        }
-    }
+    shell_print(sh, "I2S recoveries since boot: %u", total);
 
-    fs_closedir(&dir);
+    for (size_t i = 0; i < count; i++) {
+        shell_print(sh,
+                    "[%lld ms] %s, err %d, %u silence blocks, %u us, %s",
+                    events[i].timestamp_ms,
+                    events[i].cause == AUDIO_RECOVERY_STALL ? "stall" :
+                                                              "write error",
+                    events[i].error,
+                    events[i].silence_blocks,
+                    events[i].duration_us,
+                    events[i].success ? "resumed" : "failed");
+    }
+#else
+    shell_info(sh, "Set CONFIG_RPR_AUDIO_RECOVERY to enable I2S recovery.");
+#endif
     return 0;
 }
 
 /**
- * @brief Delete audio files from the default audio directory.
+ * @brief Shows or selects the codec level between streams.
  * 
- * Usage: playlist delete <index|all>
- *
- * @param sh    Shell context.
- * @param argc  Argument count (expects at least 2).
- * @param argv  Argument values (expects "index" or "all").
- * @return 0 on success, -EINVAL for invalid usage, -ENOENT if file or folder not found.
+ * Usage: standby [clocked|warm|standby] [idle_timeout_ms]
  */
-static int
-cmd_audio_playlist_delete(const struct shell *sh, size_t argc, char **argv)
+static int cmd_audio_standby(const struct shell *sh, size_t argc, char **argv)
 {
-    if (argc < 2) {
-        shell_error(sh, "Usage: playlist delete <index|all>");
-        return -EINVAL;
-    }
-
-    struct fs_dir_t  dir;
-    struct fs_dirent entry;
-    char             full_path[FULL_AUDIO_PATH_MAX_LEN];
-    int              index        = 1;
-    int              target_index = -1;
-    bool             delete_all   = false;
-    bool             file_deleted = false;
-
-    fs_dir_t_init(&dir);
+    struct audio_power_stats stats;
+    audio_power_state_t      state;
+    uint32_t                 timeout_ms;
 
-    if (fs_opendir(&dir, CONFIG_RPR_AUDIO_DEFAULT_PATH) != 0) {
-        shell_error(sh, "Failed to open directory");
-        return -ENOENT;
-    }
+    audio_player_get_idle_policy(&state, &timeout_ms);
 
-    if (strcmp(argv[1], "all") == 0) {
-        delete_all = true;
-    } else {
-        target_index = atoi(argv[1]);
-        if (target_index <= 0) {
-            shell_error(sh, "Invalid index value");
+    if (argc > 1) {
+        if (audio_player_parse_power_state(argv[1], &state) != 0) {
+            shell_error(sh, "Unknown level: %s", argv[1]);
             return -EINVAL;
         }
-    }
 
-    while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != 0) {
-        if (entry.type == FS_DIR_ENTRY_FILE) {
-            if (delete_all || index == target_index) {
-                snprintf(full_path,
-                         sizeof(full_path),
-                         "%s/%s",
-                         CONFIG_RPR_AUDIO_DEFAULT_PATH,
-                         entry.name);
-                fs_unlink(full_path);
-                shell_print(sh, "Deleted: %s", entry.name);
-                file_deleted = true;
+        if (argc > 2) {
+            timeout_ms = strtoul(argv[2], NULL, 10);
+        }
 
-                if (!delete_all) {
-                    break;
-                }
-            }
-            index++;
+        if (audio_player_set_idle_policy(state, timeout_ms) != PLAYER_OK) {
+            shell_error(sh, "Level %s is not available", argv[1]);
+            return -EINVAL;
         }
     }
 
-    fs_closedir(&dir);
+    audio_player_get_power_stats(&stats);
 
-    if (delete_all && file_deleted) {
-        shell_print(sh, "All audio files deleted.");
-    }
+    shell_print(sh,
+                "Idle level: %s, step down after: %u ms, now: %s",
+                audio_player_power_state_name(state),
+                timeout_ms,
+                audio_player_power_state_name(stats.state));
 
-    if (!file_deleted) {
-        shell_warn(sh, "File not found or nothing deleted.");
-        return -ENOENT;
+    for (int i = 0; i < AUDIO_POWER_STATE_COUNT; i++) {
+        const struct audio_wake_stats *wake = &stats.wake[i];
+
+        shell_print(sh,
+                    "%-8s %10llu ms, %u entries",
+                    audio_player_power_state_name(i),
+                    stats.residency_ms[i],
+                    stats.entries[i]);
+
+        if (wake->count > 0) {
+            shell_print(sh,
+                        "         wake to sound: %u wakes, last %u, "
+                        "avg %u, max %u us",
+                        wake->count,
+                        wake->last_us,
+                        wake->avg_us,
+                        wake->max_us);
+        }
     }
 
     return 0;
 }
 
-SHELL_STATIC_SUBCMD_SET_CREATE(audio_playlist_cmds,
-                               SHELL_CMD(show,
-                                         NULL,
-                                         "Show list of audio files",
-                                         cmd_audio_playlist_show),
-                               SHELL_CMD(delete,
-                                         NULL,
-                                         "Delete audio file by index or all",
-                                         cmd_audio_playlist_delete),
-                               SHELL_SUBCMD_SET_END);
+/**
+ * @brief Prints per-block cycle statistics of an audio benchmark.
+ */
+static void print_block_benchmark(const struct shell                 *sh,
+                                  const struct audio_block_benchmark *bench)
+{
+    shell_print(sh,
+                "Cycles per block: min %u, avg %u, max %u",
+                bench->cycles_min,
+                bench->cycles_avg,
+                bench->cycles_max);
 
-SHELL_STATIC_SUBCMD_SET_CREATE(
-        audio_set,
-        SHELL_CMD_ARG(volume, NULL, "Set volume level", cmd_audio_volume, 2, 0),
-        SHELL_CMD(mute, NULL, "Enable mute", cmd_audio_mute_true),
-        SHELL_CMD(unmute, NULL, "Disable mute", cmd_audio_mute_false),
-        SHELL_SUBCMD_SET_END);
+    uint32_t load = (uint32_t)(((uint64_t)bench->cycles_avg * 10000U) /
+                               MAX(bench->block_budget_cycles, 1U));
 
-SHELL_STATIC_SUBCMD_SET_CREATE(
-        audio_cmds,
-        SHELL_CMD(playlist, &audio_playlist_cmds, "Manage audio playlist", NULL),
-        SHELL_CMD(play, NULL, "Play audio by index", cmd_audio_play),
-        SHELL_CMD(stop, NULL, "Stop audio", cmd_audio_stop),
-        SHELL_CMD(pause, NULL, "Pause audio", cmd_audio_pause),
-        SHELL_CMD(info, NULL, "Show playback info", cmd_audio_info),
-        SHELL_CMD(set, &audio_set, "Set volume/mute", NULL),
-        SHELL_CMD(reset, NULL, "Reset the audio codec", cmd_audio_reset),
-        SHELL_CMD(ping, NULL, "Ping audio playback thread", cmd_audio_ping),
-        SHELL_SUBCMD_SET_END);
+    shell_print(sh,
+                "Block budget: %u cycles, CPU load %u.%02u%%",
+                bench->block_budget_cycles,
+                load / 100U,
+                load % 100U);
+}
 
 /**
- * @brief Turns on the specified LED.
- *
- * @param sh Shell context
- * @param argc Argument count
- * @param argv Argument vector: argv[1] = LED index (int)
- * @return 0 on success
+ * @brief Starts playback of a synthesized siren or test tone.
+ * 
+ * Usage: tone <test|wail|yelp|hilo> [duration_ms]
  */
-static int cmd_led_on(const struct shell *sh, size_t argc, char **argv)
+static int cmd_audio_tone(const struct shell *sh, size_t argc, char **argv)
 {
+#ifdef CONFIG_RPR_AUDIO_TONE_GENERATOR
+    audio_tone_t tone;
+    uint32_t     duration_ms = 0;
 
-    int          index      = atoi(argv[1]);
-    led_status_t led_status = led_on(index);
+    if (argc < 2) {
+        shell_error(sh, "Usage: tone <test|wail|yelp|hilo> [duration_ms]");
+        return -EINVAL;
+    }
 
-    switch (led_status) {
-    case LED_INVALID_INDEX:
-        shell_warn(sh, "Wrong LED index");
+    if (tone_generator_parse_name(argv[1], &tone) != 0) {
+        shell_error(sh, "Unknown tone: %s", argv[1]);
+        return -EINVAL;
+    }
+
+    if (argc > 2) {
+        duration_ms = strtoul(argv[2], NULL, 10);
+    }
+
+    player_status_t status = audio_player_start_tone(tone, duration_ms);
+
+    switch (status) {
+    case PLAYER_OK:
+        if (duration_ms) {
+            shell_print(sh, "Tone %s started for %u ms", argv[1], duration_ms);
+        } else {
+            shell_print(sh, "Tone %s started, use 'stop' to end it", argv[1]);
+        }
         break;
-    case LED_FAILED:
-        shell_error(sh, "LED operation failed");
+    case PLAYER_ERROR_CODEC_INIT:
+        shell_error(sh, "Error: Audio device is not initialized");
         break;
-    case LED_OK:
-        shell_print(sh, "LED %d ON", index);
+    case PLAYER_ERROR_BUSY:
+        shell_error(sh, "Error: Audio device is already playing");
         break;
     default:
-        shell_error(sh, "Unknown LED status");
+        shell_error(sh, "Error: Unknown playback error (code %d)", status);
         break;
     }
-
+    return (status == PLAYER_OK) ? 0 : -EINVAL;
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_TONE_GENERATOR to enable tone support.");
     return 0;
+#endif
 }
 
 /**
- * @brief Turns off the specified LED.
- *
- * @param sh Shell context
- * @param argc Argument count
- * @param argv Argument vector: argv[1] = LED index (int)
- * @return 0 on success
+ * @brief Measures the CPU cost of tone synthesis per I2S block.
+ * 
+ * Usage: bench [test|wail|yelp|hilo] [blocks]
  */
-static int cmd_led_off(const struct shell *sh, size_t argc, char **argv)
+static int
+cmd_audio_tone_bench(const struct shell *sh, size_t argc, char **argv)
 {
+#ifdef CONFIG_RPR_AUDIO_TONE_GENERATOR
+    struct audio_block_benchmark bench;
+    audio_tone_t                 tone   = AUDIO_TONE_WAIL;
+    uint32_t                     blocks = 100;
 
-    int          index      = atoi(argv[1]);
-    led_status_t led_status = led_off(index);
+    if (argc > 1 && tone_generator_parse_name(argv[1], &tone) != 0) {
+        shell_error(sh, "Unknown tone: %s", argv[1]);
+        return -EINVAL;
+    }
 
-    switch (led_status) {
-    case LED_INVALID_INDEX:
-        shell_warn(sh, "Wrong LED index");
-        break;
-    case LED_FAILED:
-        shell_error(sh, "LED operation failed");
-        break;
-    case LED_OK:
-        shell_print(sh, "LED %d OFF", index);
-        break;
-    default:
-        shell_error(sh, "Unknown LED status");
-        break;
+    if (argc > 2) {
+        blocks = strtoul(argv[2], NULL, 10);
+    }
+
+    if (audio_player_tone_benchmark(tone, blocks, &bench) != PLAYER_OK) {
+        shell_error(sh, "Benchmark failed");
+        return -EINVAL;
     }
 
+    shell_print(sh,
+                "Tone %s: %u blocks of %u us",
+                tone_generator_name(tone),
+                bench.blocks,
+                bench.block_duration_us);
+    print_block_benchmark(sh, &bench);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_TONE_GENERATOR to enable tone support.");
+#endif
     return 0;
 }
 
 /**
- * @brief Blinks the specified LED with given on/off durations.
- *
- * @param sh Shell context
- * @param argc Argument count
- * @param argv Argument vector: 
- *             argv[1] = LED index (int), 
- *             argv[2] = ON time (ms), 
- *             argv[3] = OFF time (ms)
- * @return 0 on success or -EINVAL for invalid params
+ * @brief Loads the speaker-correction EQ profile.
+ * 
+ * Usage: eq load [path]
  */
-static int cmd_led_blink(const struct shell *sh, size_t argc, char **argv)
+static int cmd_audio_eq_load(const struct shell *sh, size_t argc, char **argv)
 {
+#ifdef CONFIG_RPR_AUDIO_EQ
+    const char *path = (argc > 1) ? argv[1] : CONFIG_RPR_AUDIO_EQ_PROFILE_PATH;
 
-    int index  = atoi(argv[1]);
-    int on_ms  = atoi(argv[2]);
-    int off_ms = atoi(argv[3]);
-
-    if (on_ms <= 0 || off_ms <= 0) {
-        shell_error(sh, "Invalid time values");
-        return -EINVAL;
+    int ret = audio_eq_load(path);
+    if (ret < 0) {
+        shell_error(sh, "Failed to load EQ profile %s (err %d)", path, ret);
+        return ret;
     }
 
-    led_status_t led_status = led_blink(index, on_ms, off_ms);
-
-    switch (led_status) {
-    case LED_INVALID_INDEX:
-        shell_warn(sh, "Wrong LED index");
-        break;
-    case LED_FAILED:
-        shell_error(sh, "LED operation failed");
-        break;
-    case LED_OK:
-        shell_print(sh,
-                    "LED %d set to blink (ON=%dms, OFF=%dms)",
-                    index,
-                    on_ms,
-                    off_ms);
-        break;
-    default:
-        shell_error(sh, "Unknown LED status");
-        break;
-    }
+    shell_print(sh, "EQ profile loaded: %d stages", ret);
+#else
+    shell_info(sh, "Set CONFIG_RPR_AUDIO_EQ to enable EQ support.");
+#endif
+    return 0;
+}
 
+/**
+ * @brief Enables the speaker-correction EQ.
+ */
+static int cmd_audio_eq_on(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_EQ
+    audio_eq_set_enabled(true);
+    shell_print(sh, "EQ enabled");
+#else
+    shell_info(sh, "Set CONFIG_RPR_AUDIO_EQ to enable EQ support.");
+#endif
     return 0;
 }
 
-SHELL_STATIC_SUBCMD_SET_CREATE(
+/**
+ * @brief Bypasses the speaker-correction EQ.
+ */
+static int cmd_audio_eq_off(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_EQ
+    audio_eq_set_enabled(false);
+    shell_print(sh, "EQ bypassed");
+#else
+    shell_info(sh, "Set CONFIG_RPR_AUDIO_EQ to enable EQ support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Displays the EQ state and the coefficients of the active profile.
+ */
+static int cmd_audio_eq_info(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_EQ
+    shell_print(sh, "EQ: %s", audio_eq_is_active() ? "active" : "bypassed");
+    shell_print(sh,
+                "Kernel: %s",
+                audio_eq_has_dsp_kernel() ? "DSP dual-MAC" : "portable C");
+
+    for (size_t i = 0; i < audio_eq_stage_count(); i++) {
+        int16_t coef[5];
+
+        if (audio_eq_get_stage(i, coef) == 0) {
+            shell_print(sh,
+                        "Stage %u: %d %d %d %d %d",
+                        (uint32_t)i,
+                        coef[0],
+                        coef[1],
+                        coef[2],
+                        coef[3],
+                        coef[4]);
+        }
+    }
+#else
+    shell_info(sh, "Set CONFIG_RPR_AUDIO_EQ to enable EQ support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Checks the EQ kernel against the reference and measures its cost.
+ * 
+ * Usage: eq bench [blocks]
+ */
+static int cmd_audio_eq_bench(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_EQ
+    struct audio_block_benchmark bench;
+    uint32_t                     blocks    = 100;
+    bool                         bit_exact = false;
+
+    if (argc > 1) {
+        blocks = strtoul(argv[1], NULL, 10);
+    }
+
+    player_status_t status =
+            audio_player_eq_benchmark(blocks, &bench, &bit_exact);
+
+    if (status == PLAYER_ERROR_BUSY) {
+        shell_error(sh, "Error: Audio device is playing");
+        return -EBUSY;
+    }
+
+    if (status != PLAYER_OK) {
+        shell_error(sh, "Benchmark failed");
+        return -EINVAL;
+    }
+
+    shell_print(sh,
+                "Reference check: %s",
+                bit_exact ? "bit-exact" : "MISMATCH");
+
+    if (audio_eq_stage_count() == 0) {
+        shell_warn(sh, "No EQ profile loaded, nothing to measure");
+        return bit_exact ? 0 : -EIO;
+    }
+
+    shell_print(sh,
+                "EQ %u stages: %u blocks of %u us",
+                (uint32_t)audio_eq_stage_count(),
+                bench.blocks,
+                bench.block_duration_us);
+    print_block_benchmark(sh, &bench);
+
+    uint32_t budget = bench.block_budget_cycles *
+                      CONFIG_RPR_AUDIO_EQ_CYCLE_BUDGET_PERCENT / 100U;
+
+    shell_print(sh,
+                "EQ budget: %u cycles (%d%%), %s",
+                budget,
+                CONFIG_RPR_AUDIO_EQ_CYCLE_BUDGET_PERCENT,
+                bench.cycles_max <= budget ? "OK" : "EXCEEDED");
+
+    return bit_exact ? 0 : -EIO;
+#else
+    shell_info(sh, "Set CONFIG_RPR_AUDIO_EQ to enable EQ support.");
+    return 0;
+#endif
+}
+
+#ifdef CONFIG_RPR_AUDIO_SCHEDULE
+/**
+ * @brief Prints an RTC epoch time as "YYYY-MM-DD hh:mm:ss".
+ */
+static void print_schedule_time(const struct shell *sh,
+                                const char         *label,
+                                int64_t             epoch)
+{
+    time_t    t = (time_t)epoch;
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    shell_print(sh,
+                "%s%04d-%02d-%02d %02d:%02d:%02d",
+                label,
+                tm.tm_year + 1900,
+                tm.tm_mon + 1,
+                tm.tm_mday,
+                tm.tm_hour,
+                tm.tm_min,
+                tm.tm_sec);
+}
+#endif
+
+/**
+ * @brief Shows the playback schedule and the result of the last start.
+ */
+static int
+cmd_audio_schedule_show(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_SCHEDULE
+    static const char *const day_names[] = { "sun", "mon", "tue", "wed",
+                                             "thu", "fri", "sat" };
+    struct audio_schedule_entry  entry;
+    struct audio_schedule_status status;
+    size_t                       count = audio_schedule_count();
+
+    shell_print(sh, "Schedule: %u entries", (uint32_t)count);
+
+    for (size_t i = 0; i < count; i++) {
+        char when[32] = "daily";
+        int  len      = 0;
+
+        if (audio_schedule_get(i, &entry) != 0) {
+            continue;
+        }
+
+        if (entry.date != 0) {
+            time_t    t = (time_t)entry.date;
+            struct tm tm;
+
+            gmtime_r(&t, &tm);
+            snprintf(when,
+                     sizeof(when),
+                     "%04d-%02d-%02d",
+                     tm.tm_year + 1900,
+                     tm.tm_mon + 1,
+                     tm.tm_mday);
+        } else if (entry.days != AUDIO_SCHEDULE_DAILY) {
+            for (size_t d = 0; d < ARRAY_SIZE(day_names); d++) {
+                if (entry.days & BIT(d)) {
+                    len += snprintf(when + len,
+                                    sizeof(when) - len,
+                                    "%s%s",
+                                    len ? "," : "",
+                                    day_names[d]);
+                }
+            }
+        }
+
+        shell_print(sh,
+                    "%u: %-16s %02u:%02u:%02u  %s",
+                    (uint32_t)i + 1,
+                    when,
+                    entry.second / 3600,
+                    (entry.second / 60) % 60,
+                    entry.second % 60,
+                    entry.file);
+    }
+
+    audio_schedule_get_status(&status);
+
+    if (status.next_index >= 0) {
+        print_schedule_time(sh, "Next:  ", status.next_time);
+    } else {
+        shell_print(sh, "Next:  none");
+    }
+
+    if (status.last_time != 0) {
+        print_schedule_time(sh, "Last:  ", status.last_time);
+        shell_print(sh, "Error: %d us", status.last_error_us);
+    }
+
+    shell_print(sh,
+                "Started: %u, failed: %u",
+                status.started,
+                status.failed);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_SCHEDULE to enable scheduled playback "
+               "support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Adds an entry to the playback schedule.
+ * 
+ * Usage: schedule add <daily|mon,wed,...|YYYY-MM-DD> <hh:mm:ss> <file>
+ */
+static int
+cmd_audio_schedule_add(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_SCHEDULE
+    char line[CONFIG_RPR_FILENAME_MAX_LEN + 48];
+
+    snprintf(line, sizeof(line), "%s %s %s", argv[1], argv[2], argv[3]);
+
+    int ret = audio_schedule_add(line);
+    if (ret < 0) {
+        shell_error(sh, "Failed to add schedule entry (%d)", ret);
+        return ret;
+    }
+
+    shell_print(sh, "Schedule entry added: %s", line);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_SCHEDULE to enable scheduled playback "
+               "support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Deletes all entries of the playback schedule.
+ */
+static int
+cmd_audio_schedule_clear(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_SCHEDULE
+    int ret = audio_schedule_clear();
+    if (ret < 0) {
+        shell_error(sh, "Failed to clear schedule (%d)", ret);
+        return ret;
+    }
+
+    shell_print(sh, "Schedule cleared");
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_SCHEDULE to enable scheduled playback "
+               "support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Reloads the playback schedule from the file system.
+ */
+static int
+cmd_audio_schedule_reload(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_SCHEDULE
+    int ret = audio_schedule_load();
+    if (ret < 0) {
+        shell_error(sh, "Failed to load schedule (%d)", ret);
+        return ret;
+    }
+
+    shell_print(sh, "Schedule loaded: %d entries", ret);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_SCHEDULE to enable scheduled playback "
+               "support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Shows the network clock discipline and the playout trim.
+ */
+static int cmd_audio_sync_show(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    struct audio_sync_status status;
+    int64_t                  net_us;
+
+    audio_sync_get_status(&status);
+
+    if (!status.synced) {
+        shell_print(sh,
+                    "Network clock: not synchronized (%u failed queries)",
+                    status.failures);
+        return 0;
+    }
+
+    audio_sync_now(&net_us);
+
+    shell_print(sh, "Network clock: %lld ms", net_us / USEC_PER_MSEC);
+    shell_print(sh,
+                "Samples: %u, steps: %u, failed: %u",
+                status.samples,
+                status.steps,
+                status.failures);
+    shell_print(sh,
+                "Last sample: %lld ms ago, rtt %u us, error %d us",
+                k_uptime_get() - status.last_sync_ms,
+                status.last_rtt_us,
+                status.last_error_us);
+    shell_print(sh, "Drift: %d ppb", status.drift_ppb);
+    shell_print(sh,
+                "Stream: %s, playout error %d us, %u inserted, %u dropped",
+                status.stream_active ? "synchronized" : "idle",
+                status.play_error_us,
+                status.inserted,
+                status.dropped);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_SYNC to enable synchronized playback "
+               "support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Queries the time server now.
+ */
+static int
+cmd_audio_sync_update(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    int ret = audio_sync_update();
+    if (ret < 0) {
+        shell_error(sh, "SNTP query failed (%d)", ret);
+        return ret;
+    }
+
+    return cmd_audio_sync_show(sh, argc, argv);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_SYNC to enable synchronized playback "
+               "support.");
+    return 0;
+#endif
+}
+
+/**
+ * @brief Plays a file at a network time.
+ * 
+ * Usage: sync play <file> <epoch_ms|+ms|@s>
+ *
+ * "+ms" starts the given time from now, "@s" at the next multiple of s
+ * seconds of network time, so speakers given the same command within
+ * one period start together.
+ */
+static int cmd_audio_sync_play(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_SYNC
+    char    path[FULL_AUDIO_PATH_MAX_LEN];
+    int64_t now_us;
+    int64_t start_us;
+
+    if (audio_sync_now(&now_us) < 0) {
+        shell_error(sh, "Network clock is not synchronized");
+        return -EAGAIN;
+    }
+
+    const char *when = argv[2];
+
+    if (when[0] == '+') {
+        start_us = now_us + strtoll(when + 1, NULL, 10) * USEC_PER_MSEC;
+    } else if (when[0] == '@') {
+        int64_t period_us = strtoll(when + 1, NULL, 10) * USEC_PER_SEC;
+        if (period_us <= 0) {
+            shell_error(sh, "Invalid period");
+            return -EINVAL;
+        }
+        start_us = (now_us / period_us + 1) * period_us;
+    } else {
+        start_us = strtoll(when, NULL, 10) * USEC_PER_MSEC;
+    }
+
+    if (argv[1][0] == '/') {
+        snprintf(path, sizeof(path), "%s", argv[1]);
+    } else {
+        snprintf(path,
+                 sizeof(path),
+                 "%s/%s",
+                 CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                 argv[1]);
+    }
+
+    player_status_t status = audio_player_start_synced(path, start_us);
+    if (status != PLAYER_OK) {
+        shell_error(sh, "Failed to start synchronized playback (%d)", status);
+        return -EIO;
+    }
+
+    shell_print(sh,
+                "%s starts at %lld ms, in %lld ms",
+                path,
+                start_us / USEC_PER_MSEC,
+                (start_us - now_us) / USEC_PER_MSEC);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_SYNC to enable synchronized playback "
+               "support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Starts playing a live RTP/Opus stream.
+ * 
+ * Usage: rtp listen [port]
+ */
+static int
+cmd_audio_rtp_listen(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_RTP
+    long port = 0;
+
+    if (argc > 1) {
+        port = strtol(argv[1], NULL, 10);
+        if (port <= 0 || port > UINT16_MAX) {
+            shell_error(sh, "Invalid port");
+            return -EINVAL;
+        }
+    }
+
+    player_status_t status = audio_player_start_rtp((uint16_t)port);
+    if (status != PLAYER_OK) {
+        shell_error(sh, "Failed to start RTP playback (%d)", status);
+        return -EIO;
+    }
+
+    shell_print(sh,
+                "Listening for RTP/Opus on port %ld, stop with 'audio stop'",
+                port ? port : CONFIG_RPR_AUDIO_RTP_PORT);
+#else
+    shell_info(sh, "Set CONFIG_RPR_AUDIO_RTP to enable RTP streaming support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Shows the RTP receiver and jitter buffer statistics.
+ */
+static int cmd_audio_rtp_stats(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_RTP
+    struct audio_rtp_stats stats;
+
+    audio_rtp_get_stats(&stats);
+
+    shell_print(sh,
+                "Receiver: %s, port %u, talker 0x%08x",
+                stats.active ? (stats.playing ? "playing" : "buffering") :
+                               "closed",
+                stats.port,
+                stats.ssrc);
+    shell_print(sh,
+                "Packets: %u received, %u late, %u duplicate, %u overflow",
+                stats.received,
+                stats.late,
+                stats.duplicates,
+                stats.overflows);
+    shell_print(sh,
+                "Frames: %u played, %u lost (%u FEC), %u concealed, "
+                "%u dropped, %u underruns",
+                stats.played,
+                stats.lost,
+                stats.fec,
+                stats.concealed,
+                stats.dropped,
+                stats.underruns);
+    shell_print(sh,
+                "Jitter %u us, delay target %u us, buffered %u us",
+                stats.jitter_us,
+                stats.target_us,
+                stats.depth_us);
+    shell_print(sh,
+                "Arrival to sound: last %u us, avg %u us, max %u us",
+                stats.latency_last_us,
+                stats.latency_avg_us,
+                stats.latency_max_us);
+    shell_print(sh, "Copied payloads: %u", stats.copied);
+#else
+    shell_info(sh, "Set CONFIG_RPR_AUDIO_RTP to enable RTP streaming support.");
+#endif
+    return 0;
+}
+
+#ifdef CONFIG_RPR_AUDIO_PACKED
+/**
+ * @brief Builds a file path from an absolute path or a default folder name.
+ */
+static void audio_pack_path(char *path, size_t size, const char *name)
+{
+    if (name[0] == '/') {
+        snprintf(path, size, "%s", name);
+    } else {
+        snprintf(path, size, "%s/%s", CONFIG_RPR_AUDIO_DEFAULT_PATH, name);
+    }
+}
+
+/**
+ * @brief Prints one demuxing measurement.
+ */
+static void audio_pack_print_bench(const struct shell              *sh,
+                                   const struct audio_packed_bench *bench)
+{
+    shell_print(sh,
+                "%-6s %u packets, %u bytes, %u reads: read %u us, parse %u us, "
+                "copied %u B, CRC %u B",
+                bench->packed ? "Packed" : "Ogg",
+                bench->packets,
+                bench->bytes,
+                bench->reads,
+                bench->read_us,
+                bench->parse_us,
+                bench->copied,
+                bench->crc_bytes);
+}
+#endif
+
+/**
+ * @brief Converts an Ogg Opus file into a container in place.
+ *
+ * Usage: pack convert <file>
+ */
+static int
+cmd_audio_pack_convert(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_PACKED
+    char path[FULL_FILE_PATH_MAX_LEN];
+
+    audio_pack_path(path, sizeof(path), argv[1]);
+
+    int ret = audio_packed_ingest(path);
+    if (ret < 0) {
+        shell_error(sh, "Conversion failed (%d)", ret);
+        return ret;
+    }
+    if (ret == 0) {
+        shell_print(sh, "%s is not an Ogg file", path);
+        return 0;
+    }
+
+    shell_print(sh, "%s converted", path);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_PACKED to enable audio container "
+               "support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Compares the demuxing cost of Ogg and the container for a file.
+ *
+ * The file is parsed as it is, converted to a temporary container and
+ * parsed again.
+ *
+ * Usage: pack bench <file>
+ */
+static int cmd_audio_pack_bench(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_PACKED
+    char                      path[FULL_FILE_PATH_MAX_LEN];
+    char                      tmp[FULL_FILE_PATH_MAX_LEN + 1];
+    struct audio_packed_bench ogg;
+    struct audio_packed_bench packed;
+
+    if (get_playing_status()) {
+        shell_error(sh, "Stop playback first");
+        return -EBUSY;
+    }
+
+    audio_pack_path(path, sizeof(path), argv[1]);
+
+    int ret = audio_packed_bench(path, &ogg);
+    if (ret < 0) {
+        shell_error(sh, "Cannot parse %s (%d)", path, ret);
+        return ret;
+    }
+
+    if (ogg.packed) {
+        audio_pack_print_bench(sh, &ogg);
+        shell_print(sh, "Already a container, nothing to compare");
+        return 0;
+    }
+
+    snprintf(tmp, sizeof(tmp), "%s~", path);
+
+    ret = audio_packed_convert(path, tmp, NULL);
+    if (ret < 0) {
+        shell_error(sh, "Conversion failed (%d)", ret);
+        return ret;
+    }
+
+    ret = audio_packed_bench(tmp, &packed);
+    fs_unlink(tmp);
+
+    if (ret < 0) {
+        shell_error(sh, "Cannot parse the container (%d)", ret);
+        return ret;
+    }
+
+    audio_pack_print_bench(sh, &ogg);
+    audio_pack_print_bench(sh, &packed);
+
+    if (packed.parse_us > 0) {
+        shell_print(sh,
+                    "Parse cost: %u.%02ux lower with the container",
+                    ogg.parse_us / packed.parse_us,
+                    (ogg.parse_us % packed.parse_us) * 100 / packed.parse_us);
+    }
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_PACKED to enable audio container "
+               "support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Shows the audio thread stack high-water mark and where Opus keeps
+ *        its temporaries.
+ */
+static int cmd_audio_stack(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t size;
+    size_t used;
+
+    int ret = audio_player_get_stack_usage(&size, &used);
+    if (ret == 0) {
+        shell_print(sh,
+                    "Audio thread stack: %zu of %zu bytes used (%zu%%)",
+                    used,
+                    size,
+                    used * 100 / size);
+    } else if (ret == -ENOTSUP) {
+        shell_info(sh,
+                   "Set CONFIG_RPR_AUDIO_STACK_REPORT to enable stack "
+                   "high-water reporting.");
+    } else {
+        shell_error(sh, "Cannot read the audio thread stack (%d)", ret);
+    }
+
+#ifdef CONFIG_RPR_AUDIO_OPUS_SCRATCH
+    struct opus_scratch_stats stats;
+
+    opus_scratch_get_stats(&stats);
+
+    shell_print(sh,
+                "Opus scratch arena: %u of %u bytes used (%u%%), "
+                "%u overflows%s",
+                stats.peak,
+                stats.size,
+                stats.peak * 100 / stats.size,
+                stats.overflows,
+                stats.attached ? "" : ", not used yet");
+#else
+    shell_print(sh, "Opus temporaries: on the audio thread stack");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Shows the clips whose heads are cached in RAM.
+ */
+static int
+cmd_audio_cache_show(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+    struct audio_head_cache_stats stats;
+    struct audio_head_cache_entry entry;
+
+    audio_head_cache_get_stats(&stats);
+
+    shell_print(sh,
+                "Head cache: %u clips, %u of %u bytes, %u loads "
+                "(last %u ms)",
+                stats.clips,
+                stats.used,
+                stats.size,
+                stats.refreshes,
+                stats.load_ms);
+    shell_print(sh,
+                "Starts: %u from RAM, %u from flash, %u stale",
+                stats.hits,
+                stats.misses,
+                stats.stale);
+
+    for (size_t i = 0; audio_head_cache_get_entry(i, &entry) == 0; i++) {
+        if (entry.packets == 0) {
+            shell_print(sh, "%2zu: %s (not cached)", i + 1, entry.path);
+            continue;
+        }
+
+        shell_print(sh,
+                    "%2zu: %s, %s, %u ms in %u packets, %u bytes%s",
+                    i + 1,
+                    entry.path,
+                    entry.packed ? "container" : "Ogg",
+                    entry.samples / 48,
+                    entry.packets,
+                    entry.len,
+                    entry.whole ? ", whole clip" : "");
+    }
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_HEAD_CACHE to enable head cache support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Reloads the head cache between streams.
+ */
+static int
+cmd_audio_cache_refresh(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+    audio_player_refresh_head_cache(true);
+    shell_print(sh, "Head cache reload requested");
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_AUDIO_HEAD_CACHE to enable head cache support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Checks one file against libogg and prints the demuxer statistics.
+ *
+ * @return 1 if the packets match, 0 if the file is not Ogg, negative error
+ *         code otherwise.
+ */
+static int audio_ogg_verify_file(const struct shell *sh, const char *path)
+{
+    struct audio_ogg_stats stats;
+
+    int ret = audio_ogg_verify(path, &stats);
+    if (ret < 0) {
+        shell_error(sh, "%s: %s (%d)",
+                    path,
+                    ret == -EBADMSG ? "packets differ" : "failed",
+                    ret);
+        return ret;
+    }
+    if (ret == 0) {
+        shell_print(sh, "%s: no Ogg packets, skipped", path);
+        return 0;
+    }
+
+    shell_print(sh,
+                "%s: %d packets identical, %u pages, %u reads, "
+                "%u B moved, %u B assembled, %u CRC errors",
+                path,
+                ret,
+                stats.pages,
+                stats.reads,
+                stats.carried,
+                stats.assembled,
+                stats.crc_errors);
+    return 1;
+}
+
+/**
+ * @brief Checks the Ogg demuxer against libogg on one or all audio files.
+ *
+ * Usage: ogg verify [file]
+ */
+static int cmd_audio_ogg_verify(const struct shell *sh, size_t argc, char **argv)
+{
+    char path[FULL_FILE_PATH_MAX_LEN];
+
+    if (get_playing_status()) {
+        shell_error(sh, "Stop playback first");
+        return -EBUSY;
+    }
+
+    if (argc > 1) {
+        if (argv[1][0] == '/') {
+            snprintf(path, sizeof(path), "%s", argv[1]);
+        } else {
+            snprintf(path,
+                     sizeof(path),
+                     "%s/%s",
+                     CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                     argv[1]);
+        }
+
+        int ret = audio_ogg_verify_file(sh, path);
+        return ret < 0 ? ret : 0;
+    }
+
+    struct fs_dir_t  dir;
+    struct fs_dirent entry;
+    int              files  = 0;
+    int              passed = 0;
+    int              failed = 0;
+
+    fs_dir_t_init(&dir);
+    if (fs_opendir(&dir, CONFIG_RPR_AUDIO_DEFAULT_PATH) != 0) {
+        shell_error(sh, "Failed to open directory");
+        return -ENOENT;
+    }
+
+    while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != 0) {
+        if (entry.type != FS_DIR_ENTRY_FILE) {
+            continue;
+        }
+
+        snprintf(path,
+                 sizeof(path),
+                 "%s/%s",
+                 CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                 entry.name);
+
+        int ret = audio_ogg_verify_file(sh, path);
+
+        files++;
+        if (ret > 0) {
+            passed++;
+        } else if (ret < 0) {
+            failed++;
+        }
+    }
+
+    fs_closedir(&dir);
+
+    shell_print(sh,
+                "%d files: %d identical, %d failed, %d not Ogg",
+                files,
+                passed,
+                failed,
+                files - passed - failed);
+    return failed ? -EBADMSG : 0;
+}
+
+/**
+ * @brief Display a list of audio files in the default audio directory.
+ */
+static int
+cmd_audio_playlist_show(const struct shell *sh, size_t argc, char **argv)
+{
+    struct fs_dir_t  dir;
+    struct fs_dirent entry;
+    int              index = 1;
+
+    fs_dir_t_init(&dir);
+    if (fs_opendir(&dir, CONFIG_RPR_AUDIO_DEFAULT_PATH) != 0) {
+        shell_error(sh, "Failed to open directory");
+        return -ENOENT;
+    }
+
+    while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != 0) {
+        if (entry.type == FS_DIR_ENTRY_FILE) {
+            shell_print(sh, "%d: %s", index++, entry.name);
+        }
+    }
+
+    fs_closedir(&dir);
+    return 0;
+}
+
+/**
+ * @brief Delete audio files from the default audio directory.
+ * 
+ * Usage: playlist delete <index|all>
+ *
+ * @param sh    Shell context.
+ * @param argc  Argument count (expects at least 2).
+ * @param argv  Argument values (expects "index" or "all").
+ * @return 0 on success, -EINVAL for invalid usage, -ENOENT if file or folder not found.
+ */
+static int
+cmd_audio_playlist_delete(const struct shell *sh, size_t argc, char **argv)
+{
+    if (argc < 2) {
+        shell_error(sh, "Usage: playlist delete <index|all>");
+        return -EINVAL;
+    }
+
+    struct fs_dir_t  dir;
+    struct fs_dirent entry;
+    char             full_path[FULL_AUDIO_PATH_MAX_LEN];
+    int              index        = 1;
+    int              target_index = -1;
+    bool             delete_all   = false;
+    bool             file_deleted = false;
+
+    fs_dir_t_init(&dir);
+
+    if (fs_opendir(&dir, CONFIG_RPR_AUDIO_DEFAULT_PATH) != 0) {
+        shell_error(sh, "Failed to open directory");
+        return -ENOENT;
+    }
+
+    if (strcmp(argv[1], "all") == 0) {
+        delete_all = true;
+    } else {
+        target_index = atoi(argv[1]);
+        if (target_index <= 0) {
+            shell_error(sh, "Invalid index value");
+            return -EINVAL;
+        }
+    }
+
+    while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != 0) {
+        if (entry.type == FS_DIR_ENTRY_FILE) {
+            if (delete_all || index == target_index) {
+                snprintf(full_path,
+                         sizeof(full_path),
+                         "%s/%s",
+                         CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                         entry.name);
+                fs_unlink(full_path);
+                shell_print(sh, "Deleted: %s", entry.name);
+                file_deleted = true;
+
+                if (!delete_all) {
+                    break;
+                }
+            }
+            index++;
+        }
+    }
+
+    fs_closedir(&dir);
+
+    if (delete_all && file_deleted) {
+        shell_print(sh, "All audio files deleted.");
+    }
+
+    if (!file_deleted) {
+        shell_warn(sh, "File not found or nothing deleted.");
+        return -ENOENT;
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(audio_playlist_cmds,
+                               SHELL_CMD(show,
+                                         NULL,
+                                         "Show list of audio files",
+                                         cmd_audio_playlist_show),
+                               SHELL_CMD(delete,
+                                         NULL,
+                                         "Delete audio file by index or all",
+                                         cmd_audio_playlist_delete),
+                               SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(audio_tone_cmds,
+                               SHELL_CMD_ARG(bench,
+                                             NULL,
+                                             "Measure tone synthesis cost",
+                                             cmd_audio_tone_bench,
+                                             1,
+                                             2),
+                               SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        audio_eq_cmds,
+        SHELL_CMD_ARG(load,
+                      NULL,
+                      "Load EQ profile: load [path]",
+                      cmd_audio_eq_load,
+                      1,
+                      1),
+        SHELL_CMD(on, NULL, "Enable EQ", cmd_audio_eq_on),
+        SHELL_CMD(off, NULL, "Bypass EQ", cmd_audio_eq_off),
+        SHELL_CMD(info, NULL, "Show EQ profile", cmd_audio_eq_info),
+        SHELL_CMD_ARG(bench,
+                      NULL,
+                      "Check and measure EQ: bench [blocks]",
+                      cmd_audio_eq_bench,
+                      1,
+                      1),
+        SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        audio_schedule_cmds,
+        SHELL_CMD(show, NULL, "Show schedule", cmd_audio_schedule_show),
+        SHELL_CMD_ARG(add,
+                      NULL,
+                      "Add entry: add <daily|mon,wed|YYYY-MM-DD> "
+                      "<hh:mm:ss> <file>",
+                      cmd_audio_schedule_add,
+                      4,
+                      0),
+        SHELL_CMD(clear, NULL, "Delete schedule", cmd_audio_schedule_clear),
+        SHELL_CMD(reload,
+                  NULL,
+                  "Reload schedule file",
+                  cmd_audio_schedule_reload),
+        SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        audio_sync_cmds,
+        SHELL_CMD(show, NULL, "Show network clock", cmd_audio_sync_show),
+        SHELL_CMD(update, NULL, "Query time server", cmd_audio_sync_update),
+        SHELL_CMD_ARG(play,
+                      NULL,
+                      "Play at network time: play <file> <epoch_ms|+ms|@s>",
+                      cmd_audio_sync_play,
+                      3,
+                      0),
+        SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        audio_rtp_cmds,
+        SHELL_CMD_ARG(listen,
+                      NULL,
+                      "Play live RTP/Opus: listen [port]",
+                      cmd_audio_rtp_listen,
+                      1,
+                      1),
+        SHELL_CMD(stats, NULL, "Show RTP statistics", cmd_audio_rtp_stats),
+        SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        audio_cache_cmds,
+        SHELL_CMD(refresh,
+                  NULL,
+                  "Reload the cached clip heads",
+                  cmd_audio_cache_refresh),
+        SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        audio_ogg_cmds,
+        SHELL_CMD_ARG(verify,
+                      NULL,
+                      "Compare packets with libogg: verify [file]",
+                      cmd_audio_ogg_verify,
+                      1,
+                      1),
+        SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        audio_pack_cmds,
+        SHELL_CMD_ARG(convert,
+                      NULL,
+                      "Convert an Ogg file in place: convert <file>",
+                      cmd_audio_pack_convert,
+                      2,
+                      0),
+        SHELL_CMD_ARG(bench,
+                      NULL,
+                      "Compare Ogg and container parsing: bench <file>",
+                      cmd_audio_pack_bench,
+                      2,
+                      0),
+        SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        audio_set,
+        SHELL_CMD_ARG(volume, NULL, "Set volume level", cmd_audio_volume, 2, 0),
+        SHELL_CMD(mute, NULL, "Enable mute", cmd_audio_mute_true),
+        SHELL_CMD(unmute, NULL, "Disable mute", cmd_audio_mute_false),
+        SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        audio_cmds,
+        SHELL_CMD(playlist, &audio_playlist_cmds, "Manage audio playlist", NULL),
+        SHELL_CMD(play, NULL, "Play audio by index", cmd_audio_play),
+        SHELL_CMD(tone,
+                  &audio_tone_cmds,
+                  "Play siren/test tone: tone <test|wail|yelp|hilo> [ms]",
+                  cmd_audio_tone),
+        SHELL_CMD(stop, NULL, "Stop audio", cmd_audio_stop),
+        SHELL_CMD(pause, NULL, "Pause audio", cmd_audio_pause),
+        SHELL_CMD(info, NULL, "Show playback info", cmd_audio_info),
+        SHELL_CMD(set, &audio_set, "Set volume/mute", NULL),
+        SHELL_CMD(eq, &audio_eq_cmds, "Speaker-correction EQ", NULL),
+        SHELL_CMD(schedule,
+                  &audio_schedule_cmds,
+                  "RTC-scheduled playback",
+                  NULL),
+        SHELL_CMD(sync,
+                  &audio_sync_cmds,
+                  "Network-synchronized playback",
+                  cmd_audio_sync_show),
+        SHELL_CMD(rtp,
+                  &audio_rtp_cmds,
+                  "Live RTP/Opus streaming",
+                  cmd_audio_rtp_stats),
+        SHELL_CMD(ogg, &audio_ogg_cmds, "Ogg demuxer checks", NULL),
+        SHELL_CMD(stack,
+                  NULL,
+                  "Show audio stack and Opus scratch use",
+                  cmd_audio_stack),
+        SHELL_CMD(cache,
+                  &audio_cache_cmds,
+                  "Clip heads cached in RAM",
+                  cmd_audio_cache_show),
+        SHELL_CMD(pack,
+                  &audio_pack_cmds,
+                  "Pre-packetized audio container",
+                  NULL),
+        SHELL_CMD(reset, NULL, "Reset the audio codec", cmd_audio_reset),
+        SHELL_CMD(ping, NULL, "Ping audio playback thread", cmd_audio_ping),
+        SHELL_CMD(recovery,
+                  NULL,
+                  "Show I2S recovery events",
+                  cmd_audio_recovery),
+        SHELL_CMD_ARG(standby,
+                      NULL,
+                      "Codec idle level: standby [clocked|warm|standby] [ms]",
+                      cmd_audio_standby,
+                      1,
+                      2),
+        SHELL_SUBCMD_SET_END);
+
+/**
+ * @brief Turns on the specified LED.
+ *
+ * @param sh Shell context
+ * @param argc Argument count
+ * @param argv Argument vector: argv[1] = LED index (int)
+ * @return 0 on success
+ */
+static int cmd_led_on(const struct shell *sh, size_t argc, char **argv)
+{
+
+    int          index      = atoi(argv[1]);
+    led_status_t led_status = led_on(index);
+
+    switch (led_status) {
+    case LED_INVALID_INDEX:
+        shell_warn(sh, "Wrong LED index");
+        break;
+    case LED_FAILED:
+        shell_error(sh, "LED operation failed");
+        break;
+    case LED_OK:
+        shell_print(sh, "LED %d ON", index);
+        break;
+    default:
+        shell_error(sh, "Unknown LED status");
+        break;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Turns off the specified LED.
+ *
+ * @param sh Shell context
+ * @param argc Argument count
+ * @param argv Argument vector: argv[1] = LED index (int)
+ * @return 0 on success
+ */
+static int cmd_led_off(const struct shell *sh, size_t argc, char **argv)
+{
+
+    int          index      = atoi(argv[1]);
+    led_status_t led_status = led_off(index);
+
+    switch (led_status) {
+    case LED_INVALID_INDEX:
+        shell_warn(sh, "Wrong LED index");
+        break;
+    case LED_FAILED:
+        shell_error(sh, "LED operation failed");
+        break;
+    case LED_OK:
+        shell_print(sh, "LED %d OFF", index);
+        break;
+    default:
+        shell_error(sh, "Unknown LED status");
+        break;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Blinks the specified LED with given on/off durations.
+ *
+ * @param sh Shell context
+ * @param argc Argument count
+ * @param argv Argument vector: 
+ *             argv[1] = LED index (int), 
+ *             argv[2] = ON time (ms), 
+ *             argv[3] = OFF time (ms)
+ * @return 0 on success or -EINVAL for invalid params
+ */
+static int cmd_led_blink(const struct shell *sh, size_t argc, char **argv)
+{
+
+    int index  = atoi(argv[1]);
+    int on_ms  = atoi(argv[2]);
+    int off_ms = atoi(argv[3]);
+
+    if (on_ms <= 0 || off_ms <= 0) {
+        shell_error(sh, "Invalid time values");
+        return -EINVAL;
+    }
+
+    led_status_t led_status = led_blink(index, on_ms, off_ms);
+
+    switch (led_status) {
+    case LED_INVALID_INDEX:
+        shell_warn(sh, "Wrong LED index");
+        break;
+    case LED_FAILED:
+        shell_error(sh, "LED operation failed");
+        break;
+    case LED_OK:
+        shell_print(sh,
+                    "LED %d set to blink (ON=%dms, OFF=%dms)",
+                    index,
+                    on_ms,
+                    off_ms);
+        break;
+    default:
+        shell_error(sh, "Unknown LED status");
+        break;
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
         sub_led,
         SHELL_CMD_ARG(on,
                       NULL,
@@ -2181,182 +3446,719 @@ SHELL_STATIC_SUBCMD_SET_CREATE(
                   cmd_modem_set_default),
         SHELL_SUBCMD_SET_END);
 
-SHELL_STATIC_SUBCMD_SET_CREATE(
-        sub_modem,
-        SHELL_CMD(init, NULL, "Start modem", cmd_modem_init),
-        SHELL_CMD(reset, NULL, "Reset modem", cmd_modem_reset),
-        SHELL_CMD(poweroff, NULL, "Power down modem", cmd_modem_poweroff),
-        SHELL_CMD(status, NULL, "Check modem status", cmd_modem_status),
-        SHELL_CMD(info, NULL, "Get modem info", cmd_modem_info),
-        SHELL_CMD(rssi, NULL, "Get RSSI value", cmd_modem_rssi),
-        SHELL_CMD(default, &cmd_modem_default, "Modem interface control", NULL),
-        SHELL_SUBCMD_SET_END);
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        sub_modem,
+        SHELL_CMD(init, NULL, "Start modem", cmd_modem_init),
+        SHELL_CMD(reset, NULL, "Reset modem", cmd_modem_reset),
+        SHELL_CMD(poweroff, NULL, "Power down modem", cmd_modem_poweroff),
+        SHELL_CMD(status, NULL, "Check modem status", cmd_modem_status),
+        SHELL_CMD(info, NULL, "Get modem info", cmd_modem_info),
+        SHELL_CMD(rssi, NULL, "Get RSSI value", cmd_modem_rssi),
+        SHELL_CMD(default, &cmd_modem_default, "Modem interface control", NULL),
+        SHELL_SUBCMD_SET_END);
+
+#define HTTP_GET_RESPONSE_BUF_LEN 512
+
+/**
+ * @brief CLI command handler for performing an HTTP GET request.
+ * CONFIG_RPR_MODULE_HTTP must be enabled
+ */
+static int cmd_http_get(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_MODULE_HTTP
+
+    if (argc < 2) {
+        shell_error(sh, "Usage: http get <url>");
+        return -EINVAL;
+    }
+
+    const char *url                                     = argv[1];
+    uint16_t    http_status_code                        = 0;
+    char        response_buf[HTTP_GET_RESPONSE_BUF_LEN] = { 0 };
+    ;
+
+    struct get_context get_ctx = {
+        .response_buffer = response_buf,
+        .buffer_capacity = sizeof(response_buf),
+        .response_len    = 0,
+    };
+
+    shell_print(sh, "Sending GET request to: %s", url);
+
+    http_status_t ret = http_get_request(url, &get_ctx, &http_status_code);
+
+    if (ret == HTTP_CLIENT_OK) {
+        shell_print(sh, "HTTP %d OK", http_status_code);
+        shell_print(sh, "GET: %s", response_buf);
+    } else {
+        shell_error(sh, "GET failed: ret=%d", ret);
+    }
+
+    return ret;
+
+#else
+    shell_info(sh, "Set CONFIG_RPR_MODULE_HTTP to enable http support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief CLI command handler for performing an HTTP POST request.
+ * CONFIG_RPR_MODULE_HTTP must be enabled.
+ */
+static int cmd_http_post(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_MODULE_HTTP
+
+    if (argc < 3) {
+        shell_error(sh, "Usage: http post <url> <payload>");
+        return -EINVAL;
+    }
+
+    const char *url     = argv[1];
+    const char *payload = argv[2];
+
+    uint16_t http_status_code                        = 0;
+    char     response_buf[HTTP_GET_RESPONSE_BUF_LEN] = { 0 };
+
+    const char *post_headers[] = { "Content-Type: application/json\r\n", NULL };
+
+    struct post_context post_ctx = {
+        .response = {
+            .response_buffer = response_buf,
+            .buffer_capacity = sizeof(response_buf),
+            .response_len    = 0,
+        },
+        .payload     = payload,
+        .payload_len = strlen(payload),
+        .headers     = post_headers,
+        
+    };
+
+    shell_print(sh, "Sending POST request to: %s", url);
+
+    http_status_t ret = http_post_request(url, &post_ctx, &http_status_code);
+
+    if (ret == HTTP_CLIENT_OK) {
+        shell_print(sh, "HTTP %d OK", http_status_code);
+        shell_print(sh, "POST response: %s", response_buf);
+    } else {
+        shell_error(sh, "POST failed: ret=%d", ret);
+    }
+    return ret;
+
+#else
+    shell_info(sh, "Set CONFIG_RPR_MODULE_HTTP to enable http support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief CLI command handler for downloading a file via HTTP/HTTPS.
+ * CONFIG_RPR_MODULE_HTTP must be enabled.
+ */
+static int cmd_http_download(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_MODULE_HTTP
+
+    if (argc < 2) {
+        shell_print(sh, "Usage: http download audio <url> [segments]");
+        return -EINVAL;
+    }
+
+    const char *url              = argv[1];
+    uint16_t    http_status_code = 0;
+    int         ret;
+
+    shell_print(sh, "Downloading audio from: %s", url);
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+    if (argc > 2) {
+        ret = http_download_file_segmented(url,
+                                           CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                                           &http_status_code,
+                                           atoi(argv[2]));
+    } else
+#endif
+    {
+        ret = http_download_file_request(
+                url, CONFIG_RPR_AUDIO_DEFAULT_PATH, &http_status_code);
+    }
+
+    if (ret == 0) {
+        shell_print(sh,
+                    "Download audio successful. Status code: %d",
+                    http_status_code);
+    } else {
+        shell_error(sh, "Download failed. Error code: %d", ret);
+    }
+    return ret;
+
+#else
+    shell_info(sh, "Set CONFIG_RPR_MODULE_HTTP to enable http support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief CLI command handler for downloading and flashing a firmware update via HTTP/HTTPS.
+ */
+static int
+cmd_http_download_update(const struct shell *sh, size_t argc, char **argv)
+{
+#if defined(CONFIG_RPR_MODULE_DFU) && defined(CONFIG_RPR_MODULE_HTTP)
+
+    if (argc < 2) {
+        shell_print(sh, "Usage: http download update <url> [segments]");
+        return -EINVAL;
+    }
+
+    const char *url              = argv[1];
+    uint16_t    http_status_code = 0;
+    int         ret;
+
+    shell_print(sh, "Downloading update from: %s", url);
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+    if (argc > 2) {
+        ret = http_download_update_segmented(
+                url, &http_status_code, atoi(argv[2]));
+    } else
+#endif
+    {
+        ret = http_download_update_request(url, &http_status_code);
+    }
+
+    if (ret == 0) {
+        shell_print(sh,
+                    "Firmware update downloaded successfully. HTTP status: %d",
+                    http_status_code);
+    } else {
+        shell_error(sh, "Update download failed. Error code: %d", ret);
+    }
+
+    return ret;
+
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_MODULE_HTTP to enable http support.\n"
+               "Set CONFIG_RPR_MODULE_DFU to enable DFU support.");
+
+#endif
+    return 0;
+}
+
+/**
+ * @brief CLI command handler for applying a delta firmware update via HTTP/HTTPS.
+ * CONFIG_RPR_DFU_DELTA must be enabled.
+ */
+static int
+cmd_http_download_delta(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_DFU_DELTA
+    if (argc < 2) {
+        shell_print(sh, "Usage: http download delta <url>");
+        return -EINVAL;
+    }
+
+    uint16_t http_status_code = 0;
+
+    shell_print(sh, "Downloading delta update from: %s", argv[1]);
+
+    int ret = http_download_update_delta(argv[1], &http_status_code);
+
+    if (ret == 0) {
+        shell_print(sh,
+                    "Firmware update rebuilt successfully. HTTP status: %d",
+                    http_status_code);
+    } else {
+        shell_error(sh, "Delta update failed. Error code: %d", ret);
+    }
+
+    return ret;
+#else
+    shell_info(sh, "Set CONFIG_RPR_DFU_DELTA to enable delta update support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief CLI command handler printing the timings of the last HTTP request
+ *        and the connection statistics.
+ * CONFIG_RPR_MODULE_HTTP must be enabled.
+ */
+static int cmd_http_stats(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_MODULE_HTTP
+    struct http_request_timing timing;
+    struct http_conn_stats     stats;
+
+    http_get_last_timing(&timing);
+    http_get_conn_stats(&stats);
+
+    shell_print(sh,
+                "Last request: %s connection, dns %u ms, connect %u ms, "
+                "response %u ms, total %u ms",
+                timing.reused ? "kept-alive" : "new",
+                timing.dns_ms,
+                timing.connect_ms,
+                timing.response_ms,
+                timing.total_ms);
+    shell_print(sh,
+                "Requests: %u, reused: %u, connects: %u, pre-warmed: %u",
+                stats.requests,
+                stats.reused,
+                stats.connects,
+                stats.prewarmed);
+    shell_print(sh,
+                "Retries: %u, expired: %u, open: %u",
+                stats.retries,
+                stats.expired,
+                stats.open);
+    shell_print(sh,
+                "Setup time: %u ms, saved by reuse: ~%u ms",
+                stats.setup_ms,
+                stats.saved_ms);
+    shell_print(sh,
+                "DNS cache hits: %u, stale: %u, cached failures: %u",
+                stats.dns_hits,
+                stats.dns_stale,
+                stats.dns_negative);
+    shell_print(sh,
+                "TLS full handshakes: %u (avg %u ms), resumed: %u (avg %u ms)",
+                stats.tls_full,
+                stats.tls_full_ms / MAX(stats.tls_full, 1U),
+                stats.tls_resumed,
+                stats.tls_resumed_ms / MAX(stats.tls_resumed, 1U));
+    shell_print(sh,
+                "Downloads resumed: %u, restarted: %u, re-transferred: %u B",
+                stats.resumed,
+                stats.restarted,
+                stats.retransferred);
+    shell_print(sh,
+                "Segmented downloads: %u, segment retries: %u",
+                stats.segmented,
+                stats.segment_retries);
+    shell_print(sh,
+                "Delta updates: %u, patch %u B for %u B of image",
+                stats.delta_updates,
+                stats.delta_bytes,
+                stats.delta_image);
+    shell_print(sh,
+                "Compressed updates: %u, %u B for %u B of image in %u ms",
+                stats.packed_updates,
+                stats.packed_bytes,
+                stats.packed_image,
+                stats.packed_ms);
+#else
+    shell_info(sh, "Set CONFIG_RPR_MODULE_HTTP to enable http support.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief CLI command handler for opening a kept-alive connection ahead.
+ * CONFIG_RPR_HTTP_POOL must be enabled.
+ */
+static int cmd_http_prewarm(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_HTTP_POOL
+    if (argc < 2) {
+        shell_error(sh, "Usage: http prewarm <url>");
+        return -EINVAL;
+    }
+
+    int ret = http_pool_prewarm(argv[1]);
 
-#define HTTP_GET_RESPONSE_BUF_LEN 512
+    if (ret == 0) {
+        shell_print(sh, "Connection queued, see 'http stats'");
+    } else if (ret == -EALREADY) {
+        shell_print(sh, "Host already has a connection");
+    } else {
+        shell_error(sh, "Pre-warm failed: %d", ret);
+    }
+    return ret == -EALREADY ? 0 : ret;
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_HTTP_POOL to enable connection pool support.");
+#endif
+    return 0;
+}
 
 /**
- * @brief CLI command handler for performing an HTTP GET request.
- * CONFIG_RPR_MODULE_HTTP must be enabled
+ * @brief CLI command handler for comparing the download throughput of direct
+ * writes and the write-behind queue. CONFIG_RPR_WRITE_BEHIND must be enabled.
+ *
+ * Each run downloads the file once per write path into a scratch folder.
  */
-static int cmd_http_get(const struct shell *sh, size_t argc, char **argv)
+static int cmd_http_bench(const struct shell *sh, size_t argc, char **argv)
 {
-#ifdef CONFIG_RPR_MODULE_HTTP
-
+#ifdef CONFIG_RPR_WRITE_BEHIND
     if (argc < 2) {
-        shell_error(sh, "Usage: http get <url>");
+        shell_error(sh, "Usage: http bench <url> [runs]");
         return -EINVAL;
     }
 
-    const char *url                                     = argv[1];
-    uint16_t    http_status_code                        = 0;
-    char        response_buf[HTTP_GET_RESPONSE_BUF_LEN] = { 0 };
-    ;
+    static const char *const modes[] = { "direct", "write-behind" };
+    const char              *url     = argv[1];
+    const char              *name    = strrchr(url, '/');
+    int                      runs    = argc > 2 ? atoi(argv[2]) : 1;
+    uint64_t                 bytes[ARRAY_SIZE(modes)] = { 0 };
+    uint32_t                 ms[ARRAY_SIZE(modes)]    = { 0 };
+    char                     path[FULL_FILE_PATH_MAX_LEN];
 
-    struct get_context get_ctx = {
-        .response_buffer = response_buf,
-        .buffer_capacity = sizeof(response_buf),
-        .response_len    = 0,
-    };
+    if (!name || name[1] == '\0' || runs < 1) {
+        shell_error(sh, "Usage: http bench <url> [runs]");
+        return -EINVAL;
+    }
 
-    shell_print(sh, "Sending GET request to: %s", url);
+    snprintf(path, sizeof(path), "%s/%s", HTTP_BENCH_DIR, name + 1);
+    fs_mkdir(HTTP_BENCH_DIR);
+    write_behind_reset_stats();
 
-    http_status_t ret = http_get_request(url, &get_ctx, &http_status_code);
+    for (int run = 1; run <= runs; run++) {
+        for (size_t mode = 0; mode < ARRAY_SIZE(modes); mode++) {
+            struct fs_dirent entry;
+            uint16_t         http_status_code = 0;
 
-    if (ret == HTTP_CLIENT_OK) {
-        shell_print(sh, "HTTP %d OK", http_status_code);
-        shell_print(sh, "GET: %s", response_buf);
-    } else {
-        shell_error(sh, "GET failed: ret=%d", ret);
+            write_behind_set_bypass(mode == 0);
+
+            int64_t start = k_uptime_get();
+            int     ret   = http_download_file_request(
+                    url, HTTP_BENCH_DIR, &http_status_code);
+            uint32_t elapsed = (uint32_t)(k_uptime_get() - start);
+
+            if (ret != 0 || fs_stat(path, &entry) < 0) {
+                shell_error(sh, "%s download failed: %d", modes[mode], ret);
+                write_behind_set_bypass(false);
+                return -EIO;
+            }
+            fs_unlink(path);
+
+            bytes[mode] += entry.size;
+            ms[mode] += elapsed;
+            shell_print(sh,
+                        "Run %d, %s: %u bytes in %u ms",
+                        run,
+                        modes[mode],
+                        (uint32_t)entry.size,
+                        elapsed);
+        }
     }
 
-    return ret;
+    write_behind_set_bypass(false);
 
+    for (size_t mode = 0; mode < ARRAY_SIZE(modes); mode++) {
+        shell_print(sh,
+                    "%s: %u KiB/s",
+                    modes[mode],
+                    (uint32_t)(bytes[mode] * MSEC_PER_SEC / 1024 /
+                               MAX(ms[mode], 1U)));
+    }
 #else
-    shell_info(sh, "Set CONFIG_RPR_MODULE_HTTP to enable http support.");
+    shell_info(sh,
+               "Set CONFIG_RPR_WRITE_BEHIND to enable write-behind support.");
 #endif
     return 0;
 }
 
 /**
- * @brief CLI command handler for performing an HTTP POST request.
- * CONFIG_RPR_MODULE_HTTP must be enabled.
+ * @brief CLI command handler for measuring the download throughput as a
+ * function of the number of segments. CONFIG_RPR_HTTP_SEGMENTED must be
+ * enabled.
+ *
+ * Each run downloads the file once per segment count into a scratch folder.
+ * Run it against a server that emulates the link, see script/range_server.py.
  */
-static int cmd_http_post(const struct shell *sh, size_t argc, char **argv)
+static int
+cmd_http_segbench(const struct shell *sh, size_t argc, char **argv)
 {
-#ifdef CONFIG_RPR_MODULE_HTTP
-
-    if (argc < 3) {
-        shell_error(sh, "Usage: http post <url> <payload>");
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+    if (argc < 2) {
+        shell_error(sh, "Usage: http segbench <url> [runs]");
         return -EINVAL;
     }
 
-    const char *url     = argv[1];
-    const char *payload = argv[2];
-
-    uint16_t http_status_code                        = 0;
-    char     response_buf[HTTP_GET_RESPONSE_BUF_LEN] = { 0 };
+    const char *url  = argv[1];
+    const char *name = strrchr(url, '/');
+    int         runs = argc > 2 ? atoi(argv[2]) : 1;
+    uint64_t    bytes[CONFIG_RPR_HTTP_SEGMENTS] = { 0 };
+    uint32_t    ms[CONFIG_RPR_HTTP_SEGMENTS]    = { 0 };
+    char        path[FULL_FILE_PATH_MAX_LEN];
 
-    const char *post_headers[] = { "Content-Type: application/json\r\n", NULL };
+    if (!name || name[1] == '\0' || runs < 1) {
+        shell_error(sh, "Usage: http segbench <url> [runs]");
+        return -EINVAL;
+    }
 
-    struct post_context post_ctx = {
-        .response = {
-            .response_buffer = response_buf,
-            .buffer_capacity = sizeof(response_buf),
-            .response_len    = 0,
-        },
-        .payload     = payload,
-        .payload_len = strlen(payload),
-        .headers     = post_headers,
-        
-    };
+    snprintf(path, sizeof(path), "%s/%s", HTTP_BENCH_DIR, name + 1);
+    fs_mkdir(HTTP_BENCH_DIR);
 
-    shell_print(sh, "Sending POST request to: %s", url);
+    for (int run = 1; run <= runs; run++) {
+        for (int n = 1; n <= CONFIG_RPR_HTTP_SEGMENTS; n++) {
+            struct fs_dirent entry;
+            uint16_t         http_status_code = 0;
 
-    http_status_t ret = http_post_request(url, &post_ctx, &http_status_code);
+            int64_t start = k_uptime_get();
+            int     ret   = http_download_file_segmented(
+                    url, HTTP_BENCH_DIR, &http_status_code, n);
+            uint32_t elapsed = (uint32_t)(k_uptime_get() - start);
 
-    if (ret == HTTP_CLIENT_OK) {
-        shell_print(sh, "HTTP %d OK", http_status_code);
-        shell_print(sh, "POST response: %s", response_buf);
-    } else {
-        shell_error(sh, "POST failed: ret=%d", ret);
+            if (ret != 0 || fs_stat(path, &entry) < 0) {
+                shell_error(sh, "%d segments: download failed: %d", n, ret);
+                return -EIO;
+            }
+            fs_unlink(path);
+
+            bytes[n - 1] += entry.size;
+            ms[n - 1] += elapsed;
+            shell_print(sh,
+                        "Run %d, %d segments: %u bytes in %u ms",
+                        run,
+                        n,
+                        (uint32_t)entry.size,
+                        elapsed);
+        }
     }
-    return ret;
 
+    for (int n = 1; n <= CONFIG_RPR_HTTP_SEGMENTS; n++) {
+        shell_print(sh,
+                    "%d segments: %u KiB/s",
+                    n,
+                    (uint32_t)(bytes[n - 1] * MSEC_PER_SEC / 1024 /
+                               MAX(ms[n - 1], 1U)));
+    }
 #else
-    shell_info(sh, "Set CONFIG_RPR_MODULE_HTTP to enable http support.");
+    shell_info(sh,
+               "Set CONFIG_RPR_HTTP_SEGMENTED to enable segmented download "
+               "support.");
 #endif
     return 0;
 }
 
+#ifdef CONFIG_RPR_HTTP_ASYNC
 /**
- * @brief CLI command handler for downloading a file via HTTP/HTTPS.
- * CONFIG_RPR_MODULE_HTTP must be enabled.
+ * @brief Prints the result of a GET request queued by 'http async'.
+ *
+ * @param result    Result of the request.
+ * @param user_data Shell that queued the request.
  */
-static int cmd_http_download(const struct shell *sh, size_t argc, char **argv)
+static void http_async_print(const struct http_async_result *result,
+                             void                           *user_data)
 {
-#ifdef CONFIG_RPR_MODULE_HTTP
+    const struct shell *sh = user_data;
+
+    if (result->status != HTTP_CLIENT_OK) {
+        shell_error(sh, "Async GET failed: %d", result->status);
+        return;
+    }
+
+    shell_print(sh,
+                "Async GET: HTTP %u, %u bytes",
+                result->http_status_code,
+                (uint32_t)result->body_len);
+    shell_print(sh, "%s", result->body);
+}
+#endif
 
+/**
+ * @brief CLI command handler for queuing a GET request.
+ * CONFIG_RPR_HTTP_ASYNC must be enabled.
+ *
+ * Returns at once, the response is printed when the request completes.
+ */
+static int cmd_http_async(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_HTTP_ASYNC
     if (argc < 2) {
-        shell_print(sh, "Usage: http download audio <url>");
+        shell_error(sh, "Usage: http async <url> [high|normal|low]");
         return -EINVAL;
     }
 
-    const char *url              = argv[1];
-    uint16_t    http_status_code = 0;
+    struct http_async_request req = {
+        .method    = HTTP_ASYNC_GET,
+        .prio      = HTTP_ASYNC_PRIO_NORMAL,
+        .url       = argv[1],
+        .cb        = http_async_print,
+        .user_data = (void *)sh,
+    };
 
-    shell_print(sh, "Downloading audio from: %s", url);
-    int ret = http_download_file_request(
-            url, CONFIG_RPR_AUDIO_DEFAULT_PATH, &http_status_code);
+    if (argc > 2) {
+        if (strcmp(argv[2], "high") == 0) {
+            req.prio = HTTP_ASYNC_PRIO_HIGH;
+        } else if (strcmp(argv[2], "low") == 0) {
+            req.prio = HTTP_ASYNC_PRIO_LOW;
+        } else if (strcmp(argv[2], "normal") != 0) {
+            shell_error(sh, "Usage: http async <url> [high|normal|low]");
+            return -EINVAL;
+        }
+    }
+
+    int ret = http_async_submit(&req);
 
     if (ret == 0) {
-        shell_print(sh,
-                    "Download audio successful. Status code: %d",
-                    http_status_code);
+        shell_print(sh, "Request queued");
+    } else if (ret == 1) {
+        shell_print(sh, "Request joined a pending one");
     } else {
-        shell_error(sh, "Download failed. Error code: %d", ret);
+        shell_error(sh, "Queueing failed: %d", ret);
+        return ret;
     }
-    return ret;
-
 #else
-    shell_info(sh, "Set CONFIG_RPR_MODULE_HTTP to enable http support.");
+    shell_info(sh,
+               "Set CONFIG_RPR_HTTP_ASYNC to enable asynchronous request "
+               "support.");
 #endif
     return 0;
 }
 
 /**
- * @brief CLI command handler for downloading and flashing a firmware update via HTTP/HTTPS.
+ * @brief CLI command handler printing the statistics of the request queue.
+ * CONFIG_RPR_HTTP_ASYNC must be enabled.
  */
-static int
-cmd_http_download_update(const struct shell *sh, size_t argc, char **argv)
+static int cmd_http_queue(const struct shell *sh, size_t argc, char **argv)
 {
-#if defined(CONFIG_RPR_MODULE_DFU) && defined(CONFIG_RPR_MODULE_HTTP)
+#ifdef CONFIG_RPR_HTTP_ASYNC
+    struct http_async_stats stats;
 
-    if (argc < 2) {
-        shell_print(sh, "Usage: http download update <url>");
-        return -EINVAL;
-    }
+    http_async_get_stats(&stats);
 
-    const char *url              = argv[1];
-    uint16_t    http_status_code = 0;
+    shell_print(sh,
+                "Queued: %u, running: %u, longest wait: %u ms",
+                stats.queued,
+                stats.running,
+                stats.max_wait_ms);
+    shell_print(sh,
+                "Submitted: %u, coalesced: %u, rejected: %u",
+                stats.submitted,
+                stats.coalesced,
+                stats.rejected);
+    shell_print(sh,
+                "Completed: %u, failed: %u",
+                stats.completed,
+                stats.failed);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_HTTP_ASYNC to enable asynchronous request "
+               "support.");
+#endif
+    return 0;
+}
 
-    shell_print(sh, "Downloading update from: %s", url);
-    int ret = http_download_update_request(url, &http_status_code);
+/**
+ * @brief CLI command handler printing the statistics of the message queue.
+ *
+ * The overhead is the framing of the batches, the bytes of the request
+ * bodies that are not messages, and the request time, both per delivered
+ * message. CONFIG_RPR_HTTP_OUTBOX must be enabled.
+ */
+static int cmd_http_outbox(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+    struct http_outbox_stats stats;
 
-    if (ret == 0) {
+    http_outbox_get_stats(&stats);
+
+    shell_print(sh,
+                "Queued: %u, delivered: %u, dropped: %u, rejected: %u, "
+                "pending: %u",
+                stats.queued,
+                stats.delivered,
+                stats.dropped,
+                stats.rejected,
+                stats.pending);
+    shell_print(sh,
+                "Batches: %u, failed requests: %u, retry in: %u ms",
+                stats.batches,
+                stats.failures,
+                stats.backoff_ms);
+
+    if (stats.delivered > 0) {
         shell_print(sh,
-                    "Firmware update downloaded successfully. HTTP status: %d",
-                    http_status_code);
-    } else {
-        shell_error(sh, "Update download failed. Error code: %d", ret);
+                    "Per message: %u B framing, %u ms request, %u per batch",
+                    (stats.payload_bytes - stats.message_bytes) /
+                            stats.delivered,
+                    stats.request_ms / stats.delivered,
+                    stats.delivered / stats.batches);
+    }
+    if (stats.latency_count > 0) {
+        shell_print(sh,
+                    "Delivery latency: avg %u ms, max %u ms",
+                    stats.latency_ms / stats.latency_count,
+                    stats.max_latency_ms);
     }
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_HTTP_OUTBOX to enable the message queue.");
+#endif
+    return 0;
+}
 
-    return ret;
+/**
+ * @brief CLI command handler printing the hit ratio of every cached URL.
+ *
+ * A hit is a 304 Not Modified answer to a conditional request; the
+ * counters start at boot. CONFIG_RPR_HTTP_CACHE must be enabled.
+ */
+static int cmd_http_cache(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_HTTP_CACHE
+    struct http_cache_stats stats;
+    int                     i = 0;
+
+    for (; http_cache_get_stats(i, &stats) == 0; i++) {
+        shell_print(sh,
+                    "%s: %u of %u not modified (%u%%), %u KiB saved",
+                    stats.url,
+                    stats.hits,
+                    stats.requests,
+                    stats.requests ? stats.hits * 100 / stats.requests : 0,
+                    stats.saved / 1024);
+    }
 
+    if (i == 0) {
+        shell_print(sh, "No cached URLs");
+    }
 #else
     shell_info(sh,
-               "Set CONFIG_RPR_MODULE_HTTP to enable http support.\n"
-               "Set CONFIG_RPR_MODULE_DFU to enable DFU support.");
+               "Set CONFIG_RPR_HTTP_CACHE to enable conditional requests.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief CLI command handler printing what the last library sync did.
+ *
+ * CONFIG_RPR_HTTP_SYNC must be enabled.
+ */
+static int cmd_http_sync(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_HTTP_SYNC
+    struct http_sync_stats stats;
+
+    http_sync_get_stats(&stats);
+
+    if (stats.duration_ms == 0) {
+        shell_print(sh, "No sync since start");
+        return 0;
+    }
 
+    shell_print(sh,
+                "Version: %u, files: %u, result: %d, took %u ms",
+                stats.version,
+                stats.files,
+                stats.result,
+                stats.duration_ms);
+    shell_print(sh,
+                "Kept: %u, reused: %u, fetched: %u, removed: %u",
+                stats.kept,
+                stats.reused,
+                stats.fetched,
+                stats.removed);
+    shell_print(sh,
+                "Transferred: %u KiB, not transferred: %u KiB",
+                stats.fetched_bytes / 1024,
+                stats.kept_bytes / 1024);
+#else
+    shell_info(sh, "Set CONFIG_RPR_HTTP_SYNC to enable the library sync.");
 #endif
     return 0;
 }
@@ -2366,20 +4168,27 @@ SHELL_STATIC_SUBCMD_SET_CREATE(
         SHELL_CMD(
                 audio,
                 NULL,
-                "Download audio file via HTTP. Usage: http download audio <url>",
+                "Download audio file via HTTP. Usage: http download audio <url> "
+                "[segments]",
                 cmd_http_download),
         SHELL_CMD(
                 update,
                 NULL,
-                "Download firmware update via HTTP. Usage: http download update <url>",
+                "Download firmware update via HTTP. Usage: http download update "
+                "<url> [segments]",
                 cmd_http_download_update),
+        SHELL_CMD(delta,
+                  NULL,
+                  "Apply a delta firmware update via HTTP. Usage: http "
+                  "download delta <url>",
+                  cmd_http_download_delta),
         SHELL_SUBCMD_SET_END);
 
 SHELL_STATIC_SUBCMD_SET_CREATE(
         sub_http,
         SHELL_CMD(download,
                   &sub_http_download,
-                  "Download files via HTTP (audio, update)",
+                  "Download files via HTTP (audio, update, delta)",
                   NULL),
         SHELL_CMD(get,
                   NULL,
@@ -2389,6 +4198,45 @@ SHELL_STATIC_SUBCMD_SET_CREATE(
                   NULL,
                   "POST request. Usage: http post <url> <payload>",
                   cmd_http_post),
+        SHELL_CMD(stats,
+                  NULL,
+                  "Last request timings and connection statistics",
+                  cmd_http_stats),
+        SHELL_CMD(prewarm,
+                  NULL,
+                  "Open a kept-alive connection. Usage: http prewarm <url>",
+                  cmd_http_prewarm),
+        SHELL_CMD(bench,
+                  NULL,
+                  "Compare download throughput with and without write-behind. "
+                  "Usage: http bench <url> [runs]",
+                  cmd_http_bench),
+        SHELL_CMD(segbench,
+                  NULL,
+                  "Compare download throughput over 1 to N segments. "
+                  "Usage: http segbench <url> [runs]",
+                  cmd_http_segbench),
+        SHELL_CMD(async,
+                  NULL,
+                  "Queue a GET request, print the response when done. "
+                  "Usage: http async <url> [high|normal|low]",
+                  cmd_http_async),
+        SHELL_CMD(queue,
+                  NULL,
+                  "Asynchronous request queue statistics",
+                  cmd_http_queue),
+        SHELL_CMD(outbox,
+                  NULL,
+                  "Queued server message statistics",
+                  cmd_http_outbox),
+        SHELL_CMD(cache,
+                  NULL,
+                  "Conditional request hit ratio per URL",
+                  cmd_http_cache),
+        SHELL_CMD(sync,
+                  NULL,
+                  "Statistics of the last library sync",
+                  cmd_http_sync),
         SHELL_SUBCMD_SET_END);
 
 SHELL_STATIC_SUBCMD_SET_CREATE(
@@ -2436,6 +4284,123 @@ static int cmd_device_info(const struct shell *sh, size_t argc, char **argv)
     return 0;
 }
 
+#ifdef CONFIG_RPR_FLASH_QOS
+/**
+ * @brief Prints the read latency percentiles of one load class.
+ */
+static void print_flash_qos_latency(const struct shell             *sh,
+                                    const char                     *name,
+                                    const struct flash_qos_latency *lat)
+{
+    shell_print(sh,
+                "%s: %u reads, p50 %u us, p90 %u us, p99 %u us, max %u us",
+                name,
+                lat->count,
+                lat->p50_us,
+                lat->p90_us,
+                lat->p99_us,
+                lat->max_us);
+}
+#endif
+
+/**
+ * @brief Shows the flash I/O scheduler statistics and read latency.
+ */
+static int cmd_flash_qos_stats(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_FLASH_QOS
+    struct flash_qos_stats stats;
+
+    flash_qos_get_stats(&stats);
+
+    print_flash_qos_latency(sh, "Reads, idle", &stats.read_idle);
+    print_flash_qos_latency(sh, "Reads, under write load", &stats.read_loaded);
+    shell_print(sh,
+                "Read %u bytes, playback read period %u ms",
+                stats.read_bytes,
+                stats.read_period_ms);
+    shell_print(sh,
+                "Wrote %u bytes in %u chunks, longest chunk %u us",
+                stats.write_bytes,
+                stats.write_chunks,
+                stats.write_max_us);
+    shell_print(sh,
+                "Writes deferred for reads %u times (%u ms), throttled %u ms",
+                stats.deferred,
+                stats.defer_ms,
+                stats.throttle_ms);
+#else
+    shell_info(sh, "Set CONFIG_RPR_FLASH_QOS to enable flash I/O scheduling.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Clears the flash I/O scheduler statistics.
+ */
+static int cmd_flash_qos_reset(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_FLASH_QOS
+    flash_qos_reset_stats();
+    shell_print(sh, "Flash I/O statistics cleared");
+#else
+    shell_info(sh, "Set CONFIG_RPR_FLASH_QOS to enable flash I/O scheduling.");
+#endif
+    return 0;
+}
+
+/**
+ * @brief Shows the write-behind queue statistics.
+ */
+static int cmd_flash_wb_stats(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_WRITE_BEHIND
+    struct write_behind_stats stats;
+
+    write_behind_get_stats(&stats);
+
+    shell_print(sh,
+                "Wrote %u bytes in %u blocks (%u partial), %u direct writes",
+                stats.bytes,
+                stats.blocks,
+                stats.partial,
+                stats.direct);
+    shell_print(sh,
+                "Block write avg %u us, max %u us",
+                stats.write_us / MAX(stats.blocks, 1U),
+                stats.write_max_us);
+    shell_print(sh,
+                "Receive path waited for a buffer %u times (%u ms)",
+                stats.stalls,
+                stats.stall_ms);
+#else
+    shell_info(sh,
+               "Set CONFIG_RPR_WRITE_BEHIND to enable write-behind support.");
+#endif
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        flash_qos_cmds,
+        SHELL_CMD(stats,
+                  NULL,
+                  "Show read latency percentiles and write scheduling",
+                  cmd_flash_qos_stats),
+        SHELL_CMD(reset, NULL, "Clear the statistics", cmd_flash_qos_reset),
+        SHELL_SUBCMD_SET_END);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+        flash_cmds,
+        SHELL_CMD(qos,
+                  &flash_qos_cmds,
+                  "Flash I/O scheduler (playback vs downloads)",
+                  cmd_flash_qos_stats),
+        SHELL_CMD(wb,
+                  NULL,
+                  "Write-behind queue of downloads",
+                  cmd_flash_wb_stats),
+        SHELL_SUBCMD_SET_END);
+
 /* ------------ Root rapidreach Command ------------ */
 SHELL_STATIC_SUBCMD_SET_CREATE(
         sub_rapidreach,
@@ -2456,6 +4421,7 @@ SHELL_STATIC_SUBCMD_SET_CREATE(
         SHELL_CMD(poweroff, NULL, "System shutdown", cmd_poweroff),
         SHELL_CMD(dfu, &sub_dfu, "DFU management commands", NULL),
         SHELL_CMD(rtc, &rtc_cmds, "RTC commands", NULL),
+        SHELL_CMD(flash, &flash_cmds, "Flash storage commands", NULL),
         SHELL_SUBCMD_SET_END);
 
 SHELL_CMD_REGISTER(rapidreach, &sub_rapidreach, "RapidReach commands", NULL);
\ No newline at end of file
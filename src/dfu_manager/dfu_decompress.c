@@ -0,0 +1,385 @@
+/**
+ * @file dfu_decompress.c
+ * @brief Streaming decompression of compressed firmware images.
+ *
+ * The bit stream is decoded as bytes arrive, so it may be fed in fragments
+ * of any size. Decoded bytes are stored in the window ring only; the part
+ * of the ring not given to the sink yet is passed on each time the ring
+ * wraps, before it is overwritten, and at the end of the stream.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+#include <string.h>
+
+#include "dfu_decompress.h"
+
+LOG_MODULE_DECLARE(dfu_manager, CONFIG_RPR_MODULE_DFU_LOG_LEVEL);
+
+#define DFU_DECOMPRESS_MIN_WINDOW_BITS    4
+#define DFU_DECOMPRESS_MIN_LOOKAHEAD_BITS 3
+
+/**
+ * @brief Start decompressing a firmware image.
+ *
+ * @param ctx       Pointer to the decompression context to initialize.
+ * @param sink      Function the decompressed image is passed to.
+ * @param user_data User data for the sink.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_decompress_init(struct dfu_decompress_context *ctx,
+                        dfu_decompress_sink_t          sink,
+                        void                          *user_data)
+{
+    if (ctx == NULL || sink == NULL) {
+        LOG_ERR("Invalid arguments for decompress init");
+        return -EINVAL;
+    }
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->sink      = sink;
+    ctx->user_data = user_data;
+    ctx->state     = DFU_DECOMPRESS_DETECT;
+
+    return 0;
+}
+
+/**
+ * @brief Check whether the stream started with a compression header.
+ *
+ * @param ctx Pointer to the decompression context.
+ *
+ * @return true for a compressed stream, false for a plain one or if the
+ *         header is not complete yet.
+ */
+bool dfu_decompress_is_compressed(const struct dfu_decompress_context *ctx)
+{
+    return ctx != NULL && ctx->state >= DFU_DECOMPRESS_TAG;
+}
+
+/**
+ * @brief Checks whether the collected header bytes start with the magic.
+ *
+ * @param ctx Pointer to the decompression context, at least
+ *            DFU_DECOMPRESS_MAGIC_LEN header bytes are collected.
+ *
+ * @return true if the stream is compressed.
+ */
+static bool decompress_has_magic(const struct dfu_decompress_context *ctx)
+{
+    uint8_t magic[DFU_DECOMPRESS_MAGIC_LEN];
+
+    sys_put_le32(DFU_DECOMPRESS_MAGIC, magic);
+    return memcmp(&ctx->header, magic, sizeof(magic)) == 0;
+}
+
+/**
+ * @brief Checks the stream header.
+ *
+ * @param ctx Pointer to the decompression context, the header is complete.
+ *
+ * @return 0 on success, -EBADMSG if the header is invalid, -ENOTSUP if the
+ *         window does not fit the window buffer.
+ */
+static int decompress_check_header(struct dfu_decompress_context *ctx)
+{
+    struct dfu_decompress_header *hdr = &ctx->header;
+
+    hdr->magic      = sys_le32_to_cpu(hdr->magic);
+    hdr->image_size = sys_le32_to_cpu(hdr->image_size);
+
+    if (hdr->version != DFU_DECOMPRESS_VERSION || hdr->image_size == 0 ||
+        hdr->window_bits < DFU_DECOMPRESS_MIN_WINDOW_BITS ||
+        hdr->lookahead_bits < DFU_DECOMPRESS_MIN_LOOKAHEAD_BITS ||
+        hdr->lookahead_bits >= hdr->window_bits) {
+        LOG_ERR("Invalid compressed image header (version %u, window %u, "
+                "lookahead %u)",
+                hdr->version,
+                hdr->window_bits,
+                hdr->lookahead_bits);
+        return -EBADMSG;
+    }
+
+    if (hdr->window_bits > CONFIG_RPR_DFU_COMPRESSED_WINDOW_BITS) {
+        LOG_ERR("Compressed image window of %u bits is not supported",
+                hdr->window_bits);
+        return -ENOTSUP;
+    }
+
+    LOG_INF("Compressed image: %u B, window %u B, lookahead %u B",
+            hdr->image_size,
+            (uint32_t)BIT(hdr->window_bits),
+            (uint32_t)BIT(hdr->lookahead_bits));
+
+    ctx->state = DFU_DECOMPRESS_TAG;
+    return 0;
+}
+
+/**
+ * @brief Passes the decoded bytes not given to the sink yet.
+ *
+ * The bytes are contiguous in the window, which is flushed each time it
+ * wraps.
+ *
+ * @param ctx Pointer to the decompression context.
+ *
+ * @return 0 on success, or the error returned by the sink.
+ */
+static int decompress_flush(struct dfu_decompress_context *ctx)
+{
+    uint32_t mask = BIT(ctx->header.window_bits) - 1;
+    uint32_t len  = ctx->out_pos - ctx->flushed;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    int ret = ctx->sink(
+            &ctx->window[ctx->flushed & mask], len, ctx->user_data);
+
+    ctx->flushed = ctx->out_pos;
+    return ret;
+}
+
+/**
+ * @brief Adds a decoded byte to the window.
+ *
+ * @param ctx  Pointer to the decompression context.
+ * @param byte Decoded byte.
+ *
+ * @return 0 on success, -EBADMSG past the image size, or the error
+ *         returned by the sink.
+ */
+static int decompress_emit(struct dfu_decompress_context *ctx, uint8_t byte)
+{
+    uint32_t mask = BIT(ctx->header.window_bits) - 1;
+
+    if (ctx->out_pos >= ctx->header.image_size) {
+        return -EBADMSG;
+    }
+
+    ctx->window[ctx->out_pos & mask] = byte;
+    ctx->out_pos++;
+
+    if ((ctx->out_pos & mask) == 0) {
+        return decompress_flush(ctx);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Decodes the complete fields of the collected bits.
+ *
+ * @param ctx Pointer to the decompression context.
+ *
+ * @return 0 on success, -EBADMSG if the stream is malformed, or the error
+ *         returned by the sink.
+ */
+static int decompress_bits(struct dfu_decompress_context *ctx)
+{
+    const struct dfu_decompress_header *hdr  = &ctx->header;
+    uint32_t                            mask = BIT(hdr->window_bits) - 1;
+    int                                 ret  = 0;
+
+    while (ret == 0) {
+        uint8_t need;
+
+        switch (ctx->state) {
+        case DFU_DECOMPRESS_TAG:
+            need = 1;
+            break;
+        case DFU_DECOMPRESS_LITERAL:
+            need = 8;
+            break;
+        case DFU_DECOMPRESS_DISTANCE:
+            need = hdr->window_bits;
+            break;
+        case DFU_DECOMPRESS_LENGTH:
+            need = hdr->lookahead_bits;
+            break;
+        default:
+            return -EBADMSG;
+        }
+
+        if (ctx->bit_count < need) {
+            break;
+        }
+
+        ctx->bit_count -= need;
+
+        uint32_t value = (ctx->bits >> ctx->bit_count) & (BIT(need) - 1);
+
+        ctx->bits &= BIT(ctx->bit_count) - 1;
+
+        switch (ctx->state) {
+        case DFU_DECOMPRESS_TAG:
+            ctx->state = value ? DFU_DECOMPRESS_LITERAL :
+                                 DFU_DECOMPRESS_DISTANCE;
+            break;
+
+        case DFU_DECOMPRESS_LITERAL:
+            ret        = decompress_emit(ctx, (uint8_t)value);
+            ctx->state = DFU_DECOMPRESS_TAG;
+            break;
+
+        case DFU_DECOMPRESS_DISTANCE:
+            ctx->distance = (uint16_t)(value + 1);
+            ctx->state    = DFU_DECOMPRESS_LENGTH;
+            break;
+
+        case DFU_DECOMPRESS_LENGTH:
+        default:
+            if (value + 1 > hdr->image_size - ctx->out_pos) {
+                return -EBADMSG;
+            }
+
+            for (uint32_t i = 0; i <= value && ret == 0; i++) {
+                uint32_t from = (ctx->out_pos - ctx->distance) & mask;
+
+                ret = decompress_emit(ctx, ctx->window[from]);
+            }
+            ctx->state = DFU_DECOMPRESS_TAG;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Decompress the next bytes of a firmware image.
+ *
+ * @param ctx  Pointer to the decompression context.
+ * @param data Stream bytes.
+ * @param len  Number of stream bytes.
+ *
+ * @return 0 on success, -EBADMSG if the stream is malformed, -ENOTSUP if
+ *         its window is larger than CONFIG_RPR_DFU_COMPRESSED_WINDOW_BITS,
+ *         or the error returned by the sink. Errors are sticky.
+ */
+int dfu_decompress_write(struct dfu_decompress_context *ctx,
+                         const uint8_t                 *data,
+                         size_t                         len)
+{
+    if (ctx == NULL || (len > 0 && data == NULL)) {
+        return -EINVAL;
+    }
+
+    if (ctx->error) {
+        return ctx->error;
+    }
+
+    size_t pos = 0;
+    int    ret = 0;
+
+    while (pos < len && ret == 0) {
+        size_t n;
+
+        switch (ctx->state) {
+        case DFU_DECOMPRESS_DETECT:
+            n = MIN(len - pos, sizeof(ctx->header) - ctx->header_len);
+            memcpy((uint8_t *)&ctx->header + ctx->header_len, &data[pos], n);
+            ctx->header_len += n;
+            pos += n;
+
+            if (ctx->header_len < DFU_DECOMPRESS_MAGIC_LEN) {
+                break;
+            }
+
+            if (!decompress_has_magic(ctx)) {
+                ctx->state = DFU_DECOMPRESS_RAW;
+                ret        = ctx->sink((const uint8_t *)&ctx->header,
+                                       ctx->header_len,
+                                       ctx->user_data);
+            } else if (ctx->header_len == sizeof(ctx->header)) {
+                ret = decompress_check_header(ctx);
+            }
+            break;
+
+        case DFU_DECOMPRESS_RAW:
+            n   = len - pos;
+            ret = ctx->sink(&data[pos], n, ctx->user_data);
+            pos += n;
+            break;
+
+        default:
+            ctx->bits = (ctx->bits << 8) | data[pos++];
+            ctx->bit_count += 8;
+            ret = decompress_bits(ctx);
+            break;
+        }
+    }
+
+    ctx->in_len += pos;
+
+    if (ret < 0) {
+        if (ret == -EBADMSG) {
+            LOG_ERR("Malformed compressed image at byte %zu", ctx->in_len);
+        }
+        ctx->error = ret;
+        return ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Finish decompressing and pass the rest of the image to the sink.
+ *
+ * @param ctx Pointer to the decompression context.
+ *
+ * @return 0 if the image is complete, -EBADMSG if the stream is
+ *         incomplete, negative errno code otherwise.
+ */
+int dfu_decompress_finish(struct dfu_decompress_context *ctx)
+{
+    if (ctx == NULL) {
+        return -EINVAL;
+    }
+
+    if (ctx->error) {
+        return ctx->error;
+    }
+
+    if (ctx->state == DFU_DECOMPRESS_RAW) {
+        return 0;
+    }
+
+    if (ctx->state == DFU_DECOMPRESS_DETECT) {
+        /* Shorter than the magic, or a header cut short */
+        if (ctx->header_len < DFU_DECOMPRESS_MAGIC_LEN) {
+            ctx->state = DFU_DECOMPRESS_RAW;
+            return ctx->sink((const uint8_t *)&ctx->header,
+                             ctx->header_len,
+                             ctx->user_data);
+        }
+        LOG_ERR("Compressed image header incomplete");
+        return -EBADMSG;
+    }
+
+    /* The rest of the bits are padding */
+    if (ctx->out_pos != ctx->header.image_size) {
+        LOG_ERR("Compressed image incomplete: %u of %u bytes decoded",
+                ctx->out_pos,
+                ctx->header.image_size);
+        return -EBADMSG;
+    }
+
+    int ret = decompress_flush(ctx);
+
+    if (ret == 0) {
+        LOG_INF("Image decompressed: %zu B stream, %u B image",
+                ctx->in_len,
+                ctx->out_pos);
+    }
+
+    return ret;
+}
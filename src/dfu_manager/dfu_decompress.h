@@ -0,0 +1,134 @@
+/**
+ * @file dfu_decompress.h
+ * @brief Streaming decompression of compressed firmware images.
+ *
+ * A compressed image is made on the host by script/generate_compressed.py
+ * with a heatshrink-style LZSS coder, chosen for its small decoder: the only
+ * buffer is the window of the last 2^W output bytes, which also holds the
+ * output until it is passed on. The stream is decoded as it is downloaded
+ * and handed to a sink in window-sized pieces at most.
+ *
+ * Stream layout, integers little endian:
+ *  - header: "RPRZ", version, window bits W, lookahead bits L, a reserved
+ *    byte, size of the decompressed image;
+ *  - a bit stream, most significant bit first: a 1 bit followed by 8 bits
+ *    of a literal byte, or a 0 bit followed by W bits of distance - 1 and
+ *    L bits of length - 1 of a copy from the window; the last byte is
+ *    padded with zero bits.
+ *
+ * A stream without the header is passed to the sink as it is, so a plain
+ * image may be fed through the same path.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef __DFU_DECOMPRESS_H__
+#define __DFU_DECOMPRESS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#define DFU_DECOMPRESS_MAGIC      0x5A525052 /* "RPRZ" */
+#define DFU_DECOMPRESS_VERSION    1
+#define DFU_DECOMPRESS_MAGIC_LEN  4
+#define DFU_DECOMPRESS_WINDOW_LEN BIT(CONFIG_RPR_DFU_COMPRESSED_WINDOW_BITS)
+
+struct dfu_decompress_header {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  window_bits;
+    uint8_t  lookahead_bits;
+    uint8_t  reserved;
+    uint32_t image_size;
+} __packed;
+
+typedef enum {
+    DFU_DECOMPRESS_DETECT = 0, /* Collecting the header */
+    DFU_DECOMPRESS_RAW,        /* No header, passed through */
+    DFU_DECOMPRESS_TAG,
+    DFU_DECOMPRESS_LITERAL,
+    DFU_DECOMPRESS_DISTANCE,
+    DFU_DECOMPRESS_LENGTH,
+} dfu_decompress_state_t;
+
+/**
+ * @brief Receives the decompressed image.
+ *
+ * @param data      Image bytes.
+ * @param len       Number of image bytes.
+ * @param user_data User data given to dfu_decompress_init().
+ *
+ * @return 0 on success, negative errno code to stop the decompression.
+ */
+typedef int (*dfu_decompress_sink_t)(const uint8_t *data,
+                                     size_t         len,
+                                     void          *user_data);
+
+struct dfu_decompress_context {
+    dfu_decompress_sink_t        sink;
+    void                        *user_data;
+    dfu_decompress_state_t       state;
+    struct dfu_decompress_header header;
+    size_t                       header_len;
+    uint32_t                     bits;     /* Bits not decoded yet */
+    uint8_t                      bit_count;
+    uint16_t                     distance; /* Of the copy being decoded */
+    uint32_t                     out_pos;  /* Image bytes decoded */
+    uint32_t                     flushed;  /* Image bytes given to the sink */
+    size_t                       in_len;   /* Stream bytes consumed */
+    int                          error;    /* First error, sticky */
+    uint8_t                      window[DFU_DECOMPRESS_WINDOW_LEN];
+};
+
+/**
+ * @brief Start decompressing a firmware image.
+ *
+ * @param ctx       Pointer to the decompression context to initialize.
+ * @param sink      Function the decompressed image is passed to.
+ * @param user_data User data for the sink.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_decompress_init(struct dfu_decompress_context *ctx,
+                        dfu_decompress_sink_t          sink,
+                        void                          *user_data);
+
+/**
+ * @brief Decompress the next bytes of a firmware image.
+ *
+ * @param ctx  Pointer to the decompression context.
+ * @param data Stream bytes.
+ * @param len  Number of stream bytes.
+ *
+ * @return 0 on success, -EBADMSG if the stream is malformed, -ENOTSUP if
+ *         its window is larger than CONFIG_RPR_DFU_COMPRESSED_WINDOW_BITS,
+ *         or the error returned by the sink. Errors are sticky.
+ */
+int dfu_decompress_write(struct dfu_decompress_context *ctx,
+                         const uint8_t                 *data,
+                         size_t                         len);
+
+/**
+ * @brief Finish decompressing and pass the rest of the image to the sink.
+ *
+ * @param ctx Pointer to the decompression context.
+ *
+ * @return 0 if the image is complete, -EBADMSG if the stream is
+ *         incomplete, negative errno code otherwise.
+ */
+int dfu_decompress_finish(struct dfu_decompress_context *ctx);
+
+/**
+ * @brief Check whether the stream started with a compression header.
+ *
+ * @param ctx Pointer to the decompression context.
+ *
+ * @return true for a compressed stream, false for a plain one or if the
+ *         header is not complete yet.
+ */
+bool dfu_decompress_is_compressed(const struct dfu_decompress_context *ctx);
+
+#endif // __DFU_DECOMPRESS_H__
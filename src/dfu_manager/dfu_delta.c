@@ -0,0 +1,419 @@
+/**
+ * @file dfu_delta.c
+ * @brief Streaming applier of delta firmware updates.
+ *
+ * The patch is parsed byte by byte with a state machine, so it may be fed
+ * in fragments of any size. Copies read the source from slot0 one chunk at
+ * a time, add the diff bytes of the chunk and write the result to the
+ * update slot; zero runs of the diff are copies of the source as it is.
+ *
+ * The source image is checked against the hash in the patch header before
+ * anything is written, so a patch made for another release is refused
+ * instead of producing an image that only fails the final check.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+#include <string.h>
+
+#include "dfu_delta.h"
+
+LOG_MODULE_DECLARE(dfu_manager, CONFIG_RPR_MODULE_DFU_LOG_LEVEL);
+
+#define DFU_SLOT_PARTITION_0 FIXED_PARTITION_ID(slot0_partition)
+
+#define DFU_DELTA_VARINT_MAX_SHIFT 28
+
+/**
+ * @brief Start applying a delta patch to the update image slot.
+ *
+ * @param ctx     Pointer to the delta context to initialize.
+ * @param storage Storage the rebuilt image is written to.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_delta_init(struct dfu_delta_context   *ctx,
+                   struct dfu_storage_context *storage)
+{
+    if (ctx == NULL || storage == NULL) {
+        LOG_ERR("Invalid arguments for delta init");
+        return -EINVAL;
+    }
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->storage = storage;
+    ctx->state   = DFU_DELTA_HEADER;
+
+    int ret = flash_area_open(DFU_SLOT_PARTITION_0, &ctx->source);
+    if (ret < 0) {
+        LOG_ERR("Failed to open the running image bank (code: %d)", ret);
+        ctx->source = NULL;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Checks the patch header against both slots and the running image.
+ *
+ * @param ctx Pointer to the delta context, the header is complete.
+ *
+ * @return 0 on success, -ESTALE if the running image is not the source of
+ *         the patch, -EBADMSG if the header is invalid.
+ */
+static int delta_check_header(struct dfu_delta_context *ctx)
+{
+    struct dfu_delta_header *hdr = &ctx->header;
+
+    hdr->magic       = sys_le32_to_cpu(hdr->magic);
+    hdr->source_size = sys_le32_to_cpu(hdr->source_size);
+    hdr->target_size = sys_le32_to_cpu(hdr->target_size);
+
+    if (hdr->magic != DFU_DELTA_MAGIC || hdr->version != DFU_DELTA_VERSION) {
+        LOG_ERR("Not a delta patch (magic 0x%08x, version %u)",
+                hdr->magic,
+                hdr->version);
+        return -EBADMSG;
+    }
+
+    if (hdr->source_size == 0 || hdr->source_size > ctx->source->fa_size ||
+        hdr->target_size == 0 ||
+        hdr->target_size > ctx->storage->flash_ctx.flash_area->fa_size) {
+        LOG_ERR("Delta sizes do not fit the slots (source %u, target %u)",
+                hdr->source_size,
+                hdr->target_size);
+        return -EBADMSG;
+    }
+
+    const struct flash_img_check fic = {
+        .match = hdr->source_hash,
+        .clen  = hdr->source_size,
+    };
+
+    int ret = flash_img_check(
+            &ctx->storage->flash_ctx, &fic, DFU_SLOT_PARTITION_0);
+    if (ret != 0) {
+        LOG_ERR("The running image is not the source of the delta patch");
+        return -ESTALE;
+    }
+
+    LOG_INF("Applying delta patch: source %u B, target %u B",
+            hdr->source_size,
+            hdr->target_size);
+
+    ctx->state = DFU_DELTA_OP;
+    return 0;
+}
+
+/**
+ * @brief Writes source bytes plus a diff to the update slot.
+ *
+ * @param ctx  Pointer to the delta context.
+ * @param diff Diff bytes, NULL for a run of zeros.
+ * @param len  Number of bytes, checked against both images by the caller.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+static int
+delta_copy(struct dfu_delta_context *ctx, const uint8_t *diff, size_t len)
+{
+    while (len > 0) {
+        size_t chunk = MIN(len, sizeof(ctx->buf));
+
+        int ret = flash_area_read(ctx->source, ctx->src_pos, ctx->buf, chunk);
+        if (ret < 0) {
+            LOG_ERR("Failed to read the running image at %u (code: %d)",
+                    ctx->src_pos,
+                    ret);
+            return ret;
+        }
+
+        if (diff) {
+            for (size_t i = 0; i < chunk; i++) {
+                ctx->buf[i] += diff[i];
+            }
+            diff += chunk;
+        }
+
+        ret = dfu_storage_write(ctx->storage, ctx->buf, chunk, false);
+        if (ret < 0) {
+            return ret;
+        }
+
+        ctx->src_pos += chunk;
+        ctx->out_pos += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Adds a byte to the varint being decoded.
+ *
+ * @param ctx  Pointer to the delta context.
+ * @param byte Next patch byte.
+ *
+ * @return 1 if the varint is complete, 0 if more bytes follow, -EBADMSG if
+ *         it does not fit 32 bits.
+ */
+static int delta_varint(struct dfu_delta_context *ctx, uint8_t byte)
+{
+    if (ctx->varint_shift > DFU_DELTA_VARINT_MAX_SHIFT) {
+        return -EBADMSG;
+    }
+
+    ctx->varint |= (uint32_t)(byte & 0x7F) << ctx->varint_shift;
+
+    if (byte & 0x80) {
+        ctx->varint_shift += 7;
+        return 0;
+    }
+
+    ctx->varint_shift = 0;
+    return 1;
+}
+
+/**
+ * @brief Acts on a decoded varint according to the parser state.
+ *
+ * @param ctx   Pointer to the delta context.
+ * @param value Decoded value.
+ *
+ * @return 0 on success, -EBADMSG if the value does not fit the images,
+ *         negative errno code on a flash error.
+ */
+static int delta_field(struct dfu_delta_context *ctx, uint32_t value)
+{
+    const struct dfu_delta_header *hdr = &ctx->header;
+
+    switch (ctx->state) {
+    case DFU_DELTA_COPY_SEEK: {
+        int64_t pos = (int64_t)ctx->src_pos +
+                      (int32_t)((value >> 1) ^ -(int32_t)(value & 1));
+
+        if (pos < 0 || pos > hdr->source_size) {
+            return -EBADMSG;
+        }
+
+        ctx->src_pos = (uint32_t)pos;
+        ctx->state   = DFU_DELTA_COPY_LEN;
+        return 0;
+    }
+
+    case DFU_DELTA_COPY_LEN:
+        if (value > hdr->target_size - ctx->out_pos ||
+            value > hdr->source_size - ctx->src_pos) {
+            return -EBADMSG;
+        }
+
+        ctx->copy_left = value;
+        ctx->state     = value ? DFU_DELTA_DIFF_ZEROS : DFU_DELTA_OP;
+        return 0;
+
+    case DFU_DELTA_DIFF_ZEROS: {
+        if (value > ctx->copy_left) {
+            return -EBADMSG;
+        }
+
+        int ret = delta_copy(ctx, NULL, value);
+
+        ctx->copy_left -= value;
+        ctx->state = ctx->copy_left ? DFU_DELTA_DIFF_LITERALS : DFU_DELTA_OP;
+        return ret;
+    }
+
+    case DFU_DELTA_DIFF_LITERALS:
+        if (value > ctx->copy_left) {
+            return -EBADMSG;
+        }
+
+        ctx->run_left = value;
+        ctx->state    = value ? DFU_DELTA_DIFF_BYTES : DFU_DELTA_DIFF_ZEROS;
+        return 0;
+
+    case DFU_DELTA_INSERT_LEN:
+        if (value > hdr->target_size - ctx->out_pos) {
+            return -EBADMSG;
+        }
+
+        ctx->run_left = value;
+        ctx->state    = value ? DFU_DELTA_INSERT_BYTES : DFU_DELTA_OP;
+        return 0;
+
+    default:
+        return -EBADMSG;
+    }
+}
+
+/**
+ * @brief Apply the next bytes of a delta patch.
+ *
+ * @param ctx  Pointer to the delta context.
+ * @param data Patch bytes.
+ * @param len  Number of patch bytes.
+ *
+ * @return 0 on success, -ESTALE if the running image is not the source of
+ *         the patch, -EBADMSG if the patch is malformed, negative errno
+ *         code on a flash error. Errors are sticky.
+ */
+int dfu_delta_write(struct dfu_delta_context *ctx,
+                    const uint8_t            *data,
+                    size_t                    len)
+{
+    if (ctx == NULL || ctx->source == NULL || (len > 0 && data == NULL)) {
+        return -EINVAL;
+    }
+
+    if (ctx->error) {
+        return ctx->error;
+    }
+
+    size_t pos = 0;
+    int    ret = 0;
+
+    while (pos < len && ret == 0) {
+        size_t n;
+
+        switch (ctx->state) {
+        case DFU_DELTA_HEADER:
+            n = MIN(len - pos, sizeof(ctx->header) - ctx->header_len);
+            memcpy((uint8_t *)&ctx->header + ctx->header_len, &data[pos], n);
+            ctx->header_len += n;
+            pos += n;
+
+            if (ctx->header_len == sizeof(ctx->header)) {
+                ret = delta_check_header(ctx);
+            }
+            break;
+
+        case DFU_DELTA_OP:
+            switch (data[pos++]) {
+            case DFU_DELTA_OP_END:
+                ctx->state = DFU_DELTA_DONE;
+                break;
+            case DFU_DELTA_OP_COPY:
+                ctx->state = DFU_DELTA_COPY_SEEK;
+                break;
+            case DFU_DELTA_OP_INSERT:
+                ctx->state = DFU_DELTA_INSERT_LEN;
+                break;
+            default:
+                ret = -EBADMSG;
+                break;
+            }
+            ctx->varint       = 0;
+            ctx->varint_shift = 0;
+            break;
+
+        case DFU_DELTA_COPY_SEEK:
+        case DFU_DELTA_COPY_LEN:
+        case DFU_DELTA_DIFF_ZEROS:
+        case DFU_DELTA_DIFF_LITERALS:
+        case DFU_DELTA_INSERT_LEN:
+            ret = delta_varint(ctx, data[pos++]);
+            if (ret == 1) {
+                uint32_t value = ctx->varint;
+
+                ctx->varint = 0;
+                ret         = delta_field(ctx, value);
+            }
+            break;
+
+        case DFU_DELTA_DIFF_BYTES:
+            n   = MIN(len - pos, ctx->run_left);
+            ret = delta_copy(ctx, &data[pos], n);
+            pos += n;
+            ctx->run_left -= n;
+            ctx->copy_left -= n;
+
+            if (ctx->run_left == 0) {
+                ctx->state = ctx->copy_left ? DFU_DELTA_DIFF_ZEROS :
+                                              DFU_DELTA_OP;
+            }
+            break;
+
+        case DFU_DELTA_INSERT_BYTES:
+            n   = MIN(len - pos, ctx->run_left);
+            ret = dfu_storage_write(ctx->storage, &data[pos], n, false);
+            pos += n;
+            ctx->out_pos += n;
+            ctx->run_left -= n;
+
+            if (ctx->run_left == 0) {
+                ctx->state = DFU_DELTA_OP;
+            }
+            break;
+
+        case DFU_DELTA_DONE:
+        default:
+            LOG_ERR("Data after the end of the delta patch");
+            ret = -EBADMSG;
+            break;
+        }
+    }
+
+    ctx->patch_len += pos;
+
+    if (ret < 0) {
+        if (ret == -EBADMSG) {
+            LOG_ERR("Malformed delta patch at byte %zu", ctx->patch_len);
+        }
+        ctx->error = ret;
+        return ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Finish applying a delta patch and check the rebuilt image.
+ *
+ * @param ctx Pointer to the delta context.
+ *
+ * @return 0 if the image is complete and valid, -EBADMSG if the patch is
+ *         incomplete, negative errno code otherwise.
+ */
+int dfu_delta_finish(struct dfu_delta_context *ctx)
+{
+    if (ctx == NULL) {
+        return -EINVAL;
+    }
+
+    int ret = ctx->error;
+
+    if (ret == 0 && (ctx->state != DFU_DELTA_DONE ||
+                     ctx->out_pos != ctx->header.target_size)) {
+        LOG_ERR("Delta patch incomplete: %u of %u bytes rebuilt",
+                ctx->out_pos,
+                ctx->header.target_size);
+        ret = -EBADMSG;
+    }
+
+    if (ret == 0) {
+        ret = dfu_storage_write(ctx->storage, NULL, 0, true);
+    }
+
+    if (ret == 0) {
+        LOG_INF("Delta patch applied: %zu B patch, %u B image",
+                ctx->patch_len,
+                ctx->out_pos);
+
+        ret = dfu_update_flash_img_check(
+                ctx->storage, ctx->header.target_hash, ctx->out_pos);
+    }
+
+    if (ctx->source) {
+        flash_area_close(ctx->source);
+        ctx->source = NULL;
+    }
+
+    return ret;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file dfu_delta.h
+ * @brief Streaming applier of delta firmware updates.
+ *
+ * A delta patch rebuilds the new image from the running image in slot0.
+ * It is made on the host by script/generate_delta.py and applied while it
+ * is downloaded: the patch bytes are parsed as they arrive, the source is
+ * read from slot0 and the rebuilt image is written to slot1 through
+ * dfu_storage_write(). No part of the patch or of the image is buffered
+ * beyond one chunk.
+ *
+ * Patch layout, integers little endian:
+ *  - header: "RPRD", version, 3 reserved bytes, source size, target size,
+ *    SHA-256 of the source image, SHA-256 of the target image;
+ *  - DFU_DELTA_OP_COPY: seek, length, then a diff of that length as pairs
+ *    of a zero run and literal bytes; each output byte is the source byte
+ *    plus the diff byte, the source position advances with the output;
+ *  - DFU_DELTA_OP_INSERT: length, then the bytes themselves;
+ *  - DFU_DELTA_OP_END.
+ * Lengths are LEB128 varints, the seek is a zigzag varint relative to the
+ * source position after the previous copy.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef __DFU_DELTA_H__
+#define __DFU_DELTA_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/storage/flash_map.h>
+
+#include "dfu_manager.h"
+
+#define DFU_DELTA_MAGIC     0x44525052 /* "RPRD" */
+#define DFU_DELTA_VERSION   1
+#define DFU_DELTA_HASH_LEN  32
+#define DFU_DELTA_CHUNK_LEN 256
+
+#define DFU_DELTA_OP_END    0x00
+#define DFU_DELTA_OP_COPY   0x01
+#define DFU_DELTA_OP_INSERT 0x02
+
+struct dfu_delta_header {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  reserved[3];
+    uint32_t source_size;
+    uint32_t target_size;
+    uint8_t  source_hash[DFU_DELTA_HASH_LEN];
+    uint8_t  target_hash[DFU_DELTA_HASH_LEN];
+} __packed;
+
+typedef enum {
+    DFU_DELTA_HEADER = 0,
+    DFU_DELTA_OP,
+    DFU_DELTA_COPY_SEEK,
+    DFU_DELTA_COPY_LEN,
+    DFU_DELTA_DIFF_ZEROS,
+    DFU_DELTA_DIFF_LITERALS,
+    DFU_DELTA_DIFF_BYTES,
+    DFU_DELTA_INSERT_LEN,
+    DFU_DELTA_INSERT_BYTES,
+    DFU_DELTA_DONE,
+} dfu_delta_state_t;
+
+struct dfu_delta_context {
+    struct dfu_storage_context *storage;
+    const struct flash_area    *source; /* slot0 */
+    dfu_delta_state_t           state;
+    struct dfu_delta_header     header;
+    size_t                      header_len;
+    uint32_t                    varint; /* Value being decoded */
+    uint8_t                     varint_shift;
+    uint32_t                    src_pos;
+    uint32_t                    out_pos;
+    uint32_t                    copy_left; /* Output left in the copy */
+    uint32_t                    run_left;  /* Bytes left in the run */
+    size_t                      patch_len; /* Patch bytes consumed */
+    int                         error;     /* First error, sticky */
+    uint8_t                     buf[DFU_DELTA_CHUNK_LEN];
+};
+
+/**
+ * @brief Start applying a delta patch to the update image slot.
+ *
+ * The slot must be erased and the storage initialized with
+ * dfu_update_storage_init().
+ *
+ * @param ctx     Pointer to the delta context to initialize.
+ * @param storage Storage the rebuilt image is written to.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_delta_init(struct dfu_delta_context   *ctx,
+                   struct dfu_storage_context *storage);
+
+/**
+ * @brief Apply the next bytes of a delta patch.
+ *
+ * The source image is checked against the patch header as soon as the
+ * header is complete.
+ *
+ * @param ctx  Pointer to the delta context.
+ * @param data Patch bytes.
+ * @param len  Number of patch bytes.
+ *
+ * @return 0 on success, -ESTALE if the running image is not the source of
+ *         the patch, -EBADMSG if the patch is malformed, negative errno
+ *         code on a flash error. Errors are sticky.
+ */
+int dfu_delta_write(struct dfu_delta_context *ctx,
+                    const uint8_t            *data,
+                    size_t                    len);
+
+/**
+ * @brief Finish applying a delta patch and check the rebuilt image.
+ *
+ * Flushes the storage, then checks the slot against the target hash of the
+ * patch with dfu_update_flash_img_check(). Releases the source in any case.
+ *
+ * @param ctx Pointer to the delta context.
+ *
+ * @return 0 if the image is complete and valid, -EBADMSG if the patch is
+ *         incomplete, negative errno code otherwise.
+ */
+int dfu_delta_finish(struct dfu_delta_context *ctx);
+
+#endif // __DFU_DELTA_H__
@@ -7,6 +7,8 @@
  *
  * - Initializing flash storage for image updates.
  * - Writing data chunks to the secondary image slot.
+ * - Resuming an interrupted write of the secondary image slot.
+ * - Writing segments of the secondary image slot concurrently.
  * - Reading secondary firmware version.
  * - Confirming or checking the currently running image.
  * - Triggering firmware upgrades on the next boot (temporary or permanent).
@@ -18,6 +20,8 @@
 
 #include <zephyr/kernel.h>
 #include <zephyr/storage/flash_map.h>
+#include <zephyr/storage/stream_flash.h>
+#include <zephyr/drivers/flash.h>
 #include <zephyr/dfu/mcuboot.h>
 #include <zephyr/logging/log.h>
 
@@ -205,6 +209,277 @@ int dfu_storage_write(struct dfu_storage_context *ctx,
     return ret;
 }
 
+/**
+ * @brief Continue writing the update image slot from an offset.
+ *
+ * @param ctx    Pointer to the DFU storage context to initialize.
+ * @param offset Offset to continue from, set to the offset actually used.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_storage_resume(struct dfu_storage_context *ctx, size_t *offset)
+{
+    if (ctx == NULL || offset == NULL) {
+        LOG_ERR("Invalid arguments for storage resume");
+        return -EINVAL;
+    }
+
+    int ret = flash_img_init(&ctx->flash_ctx);
+    if (ret < 0) {
+        LOG_ERR("Failed to init flash image context (code: %d)", ret);
+        return ret;
+    }
+
+    const struct flash_area *fa  = ctx->flash_ctx.flash_area;
+    const struct device     *dev = flash_area_get_device(fa);
+    struct flash_pages_info  info;
+
+    if (*offset >= fa->fa_size) {
+        LOG_ERR("Resume offset %zu is outside the slot", *offset);
+        return -EINVAL;
+    }
+
+    ret = flash_get_page_info_by_offs(dev, fa->fa_off + *offset, &info);
+    if (ret < 0) {
+        LOG_ERR("Failed to get flash page info (code: %d)", ret);
+        return ret;
+    }
+
+    size_t start = info.start_offset - fa->fa_off;
+
+    ret = flash_area_erase(fa, start, fa->fa_size - start);
+    if (ret < 0) {
+        LOG_ERR("Failed to erase image bank from %zu (code: %d)", start, ret);
+        return ret;
+    }
+
+    ret = stream_flash_init(&ctx->flash_ctx.stream,
+                            dev,
+                            ctx->flash_ctx.buf,
+                            sizeof(ctx->flash_ctx.buf),
+                            fa->fa_off + start,
+                            fa->fa_size - start,
+                            NULL);
+    if (ret < 0) {
+        LOG_ERR("Failed to init flash stream (code: %d)", ret);
+        return ret;
+    }
+
+    LOG_INF("Resuming image write at %zu", start);
+    *offset = start;
+
+    return 0;
+}
+
+/**
+ * @brief Get the number of bytes written to the update image slot.
+ *
+ * @param ctx Pointer to the DFU storage context.
+ *
+ * @return Bytes written since dfu_update_storage_init() or
+ *         dfu_update_storage_resume().
+ */
+size_t dfu_storage_bytes_written(struct dfu_storage_context *ctx)
+{
+    if (ctx == NULL) {
+        return 0;
+    }
+
+    return flash_img_bytes_written(&ctx->flash_ctx);
+}
+
+/**
+ * @brief Read data back from the update image slot.
+ *
+ * @param offset Offset within the slot.
+ * @param buf    Buffer to store the data.
+ * @param len    Number of bytes to read.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_slot_read(size_t offset, void *buf, size_t len)
+{
+    const struct flash_area *fa;
+
+    int ret = flash_area_open(DFU_SLOT_PARTITION_1, &fa);
+    if (ret < 0) {
+        LOG_ERR("Failed to open image bank (code: %d)", ret);
+        return ret;
+    }
+
+    ret = flash_area_read(fa, offset, buf, len);
+    flash_area_close(fa);
+
+    if (ret < 0) {
+        LOG_ERR("Failed to read image bank at %zu (code: %d)", offset, ret);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Get the start of the flash page an offset of the update slot is in.
+ *
+ * @param offset Offset within the slot.
+ * @param start  Pointer to store the offset of the page within the slot.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_slot_page_start(size_t offset, size_t *start)
+{
+    const struct flash_area *fa;
+    struct flash_pages_info  info;
+
+    if (start == NULL) {
+        return -EINVAL;
+    }
+
+    int ret = flash_area_open(DFU_SLOT_PARTITION_1, &fa);
+    if (ret < 0) {
+        LOG_ERR("Failed to open image bank (code: %d)", ret);
+        return ret;
+    }
+
+    if (offset >= fa->fa_size) {
+        ret = -EINVAL;
+    } else {
+        ret = flash_get_page_info_by_offs(
+                flash_area_get_device(fa), fa->fa_off + offset, &info);
+    }
+
+    if (ret == 0) {
+        *start = info.start_offset - fa->fa_off;
+    }
+
+    flash_area_close(fa);
+
+    return ret;
+}
+
+/**
+ * @brief Initialize the writing of a region of the update image slot.
+ *
+ * @param ctx    Pointer to the segment context to initialize.
+ * @param offset Offset to start at, set to the offset actually used.
+ * @param end    Offset the region ends at.
+ * @param erase  Erase the region from the offset before writing.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_segment_init(struct dfu_segment_context *ctx,
+                            size_t                     *offset,
+                            size_t                      end,
+                            bool                        erase)
+{
+    if (ctx == NULL || offset == NULL || *offset >= end) {
+        LOG_ERR("Invalid arguments for segment init");
+        return -EINVAL;
+    }
+
+    const struct flash_area *fa;
+    struct flash_pages_info  info;
+    size_t                   start;
+
+    int ret = flash_area_open(DFU_SLOT_PARTITION_1, &fa);
+    if (ret < 0) {
+        LOG_ERR("Failed to open image bank (code: %d)", ret);
+        return ret;
+    }
+
+    const struct device *dev = flash_area_get_device(fa);
+
+    if (end > fa->fa_size) {
+        LOG_ERR("Segment end %zu is outside the slot", end);
+        ret = -EINVAL;
+        goto out;
+    }
+
+    ret = dfu_update_slot_page_start(*offset, &start);
+    if (ret < 0) {
+        goto out;
+    }
+
+    if (erase) {
+        /* The last page may hold the end of the region only */
+        ret = flash_get_page_info_by_offs(dev, fa->fa_off + end - 1, &info);
+        if (ret < 0) {
+            LOG_ERR("Failed to get flash page info (code: %d)", ret);
+            goto out;
+        }
+
+        size_t erase_end = info.start_offset + info.size - fa->fa_off;
+
+        ret = flash_area_erase(fa, start, erase_end - start);
+        if (ret < 0) {
+            LOG_ERR("Failed to erase segment at %zu (code: %d)", start, ret);
+            goto out;
+        }
+    }
+
+    ret = stream_flash_init(&ctx->stream,
+                            dev,
+                            ctx->buf,
+                            sizeof(ctx->buf),
+                            fa->fa_off + start,
+                            end - start,
+                            NULL);
+    if (ret < 0) {
+        LOG_ERR("Failed to init segment stream (code: %d)", ret);
+        goto out;
+    }
+
+    *offset = start;
+
+out:
+    flash_area_close(fa);
+
+    return ret;
+}
+
+/**
+ * @brief Write data to a region of the update image slot.
+ *
+ * @param ctx   Pointer to the segment context.
+ * @param data  Pointer to the data buffer to write.
+ * @param size  Size of the data in bytes.
+ * @param flush When true this forces any buffered data to be written to flash.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_segment_write(struct dfu_segment_context *ctx,
+                             const uint8_t              *data,
+                             const size_t                size,
+                             const bool                  flush)
+{
+    if (ctx == NULL || (size > 0 && data == NULL)) {
+        LOG_ERR("Invalid arguments: ctx=%p, data=%p, size=%zu", ctx, data, size);
+        return -EINVAL;
+    }
+
+    int ret = stream_flash_buffered_write(&ctx->stream, data, size, flush);
+    if (ret < 0) {
+        LOG_ERR("Failed to write segment to flash (code: %d)", ret);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Get the number of bytes written to a region of the update slot.
+ *
+ * @param ctx Pointer to the segment context.
+ *
+ * @return Bytes written since dfu_update_segment_init().
+ */
+size_t dfu_update_segment_bytes_written(struct dfu_segment_context *ctx)
+{
+    if (ctx == NULL) {
+        return 0;
+    }
+
+    return stream_flash_bytes_written(&ctx->stream);
+}
+
 #ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
 
 /**
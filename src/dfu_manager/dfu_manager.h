@@ -7,6 +7,8 @@
  *
  * - Initializing flash storage for image updates.
  * - Writing data chunks to the secondary image slot.
+ * - Resuming an interrupted write of the secondary image slot.
+ * - Writing segments of the secondary image slot concurrently.
  * - Reading secondary firmware version.
  * - Confirming or checking the currently running image.
  * - Triggering firmware upgrades on the next boot (temporary or permanent).
@@ -26,6 +28,12 @@ struct dfu_storage_context {
     struct flash_img_context flash_ctx;
 };
 
+/* Writes one region of the update image slot */
+struct dfu_segment_context {
+    struct stream_flash_ctx stream;
+    uint8_t                 buf[CONFIG_IMG_BLOCK_BUF_SIZE];
+};
+
 struct dfu_fw_update_version {
     int major;
     int minor;
@@ -97,6 +105,99 @@ int dfu_storage_write(struct dfu_storage_context *ctx,
                       const size_t                size,
                       const bool                  flush);
 
+/**
+ * @brief Continue writing the update image slot from an offset.
+ *
+ * Flash that was programmed cannot be written again without an erase, so
+ * the offset is moved back to the start of its flash page. The slot is
+ * erased from there to its end; the data before it is kept.
+ *
+ * @param ctx    Pointer to the DFU storage context to initialize.
+ * @param offset Offset to continue from, set to the offset actually used.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_storage_resume(struct dfu_storage_context *ctx, size_t *offset);
+
+/**
+ * @brief Get the number of bytes written to the update image slot.
+ *
+ * Buffered data that was not flushed yet is not counted.
+ *
+ * @param ctx Pointer to the DFU storage context.
+ *
+ * @return Bytes written since dfu_update_storage_init() or
+ *         dfu_update_storage_resume().
+ */
+size_t dfu_storage_bytes_written(struct dfu_storage_context *ctx);
+
+/**
+ * @brief Read data back from the update image slot.
+ *
+ * @param offset Offset within the slot.
+ * @param buf    Buffer to store the data.
+ * @param len    Number of bytes to read.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_slot_read(size_t offset, void *buf, size_t len);
+
+/**
+ * @brief Get the start of the flash page an offset of the update slot is in.
+ *
+ * @param offset Offset within the slot.
+ * @param start  Pointer to store the offset of the page within the slot.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_slot_page_start(size_t offset, size_t *start);
+
+/**
+ * @brief Initialize the writing of a region of the update image slot.
+ *
+ * Regions must start on a flash page so that several of them can be written
+ * at the same time. The offset is moved back to the start of its flash page.
+ * The slot is expected to be erased by dfu_update_storage_init(); a region
+ * written before must be erased again.
+ *
+ * @param ctx    Pointer to the segment context to initialize.
+ * @param offset Offset to start at, set to the offset actually used.
+ * @param end    Offset the region ends at.
+ * @param erase  Erase the region from the offset before writing.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_segment_init(struct dfu_segment_context *ctx,
+                            size_t                     *offset,
+                            size_t                      end,
+                            bool                        erase);
+
+/**
+ * @brief Write data to a region of the update image slot.
+ *
+ * @param ctx   Pointer to the segment context.
+ * @param data  Pointer to the data buffer to write.
+ * @param size  Size of the data in bytes.
+ * @param flush When true this forces any buffered data to be written to flash.
+ *
+ * @return 0 on success, negative errno code on fail.
+ */
+int dfu_update_segment_write(struct dfu_segment_context *ctx,
+                             const uint8_t              *data,
+                             const size_t                size,
+                             const bool                  flush);
+
+/**
+ * @brief Get the number of bytes written to a region of the update slot.
+ *
+ * Buffered data that was not flushed yet is not counted.
+ *
+ * @param ctx Pointer to the segment context.
+ *
+ * @return Bytes written since dfu_update_segment_init().
+ */
+size_t dfu_update_segment_bytes_written(struct dfu_segment_context *ctx);
+
 #ifdef CONFIG_IMG_ENABLE_IMAGE_CHECK
 
 /**
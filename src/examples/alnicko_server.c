@@ -7,7 +7,9 @@
  * - Retrieve and update device time (RTC) from the server,
  * - List and download audio files by name or index,
  * - Check for available firmware updates and download them,
- * - Send messages to the server via HTTP POST.
+ * - Send messages to the server via HTTP POST,
+ * - Queue messages that are delivered in batches once the server is reachable,
+ * - Synchronise the audio directory with the library on the server.
  *
  * @author Eugene K.
  * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
@@ -20,18 +22,338 @@
 
 #include "alnicko_server.h"
 
+#ifdef CONFIG_RPR_HTTP_ASYNC
+#include "http_async.h"
+#endif
+
+#ifdef CONFIG_RPR_DFU_DELTA
+#include "dev_info.h"
+#endif
+
+#ifdef CONFIG_RPR_HTTP_JSON
+#include <stdlib.h>
+#include "http_json.h"
+#endif
+
+#if defined(CONFIG_RPR_HTTP_OUTBOX) || defined(CONFIG_RPR_HTTP_SYNC)
+#include <errno.h>
+#endif
+
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+#include "http_outbox.h"
+#endif
+
 #define HTTP_GET_RESPONSE_BUF_LEN 512
 #define SERVER_DELAY_MS           2000
 
 #define ALNICKO_SERVER_AUDIO_LIST   "http://209.38.240.207/api/files/audio"
+#define ALNICKO_SERVER_AUDIO_SYNC   "http://209.38.240.207/api/files/audio/manifest"
 #define ALNICKO_SERVER_FW_NAME      "http://209.38.240.207/api/files/firmware"
 #define ALNICKO_SERVER_GET_TIME     "http://209.38.240.207/api/datetime"
 #define ALNICKO_SERVER_POST_MESSAGE "http://209.38.240.207/api/messages"
+#define ALNICKO_SERVER_POST_BATCH   "http://209.38.240.207/api/messages/batch"
 #define ALNICKO_SERVER_GET_FW       "http://209.38.240.207:5000/download/firmware/"
 #define ALNICKO_SERVER_GET_AUDIO    "http://209.38.240.207:5000/download/audio/"
 
 LOG_MODULE_REGISTER(alnicko_server, CONFIG_EXAMPLES_ALNICKO_SERVER_LOG_LEVEL);
 
+#ifdef CONFIG_RPR_HTTP_ASYNC
+#define SERVER_ASYNC_CALLS \
+    (CONFIG_RPR_HTTP_ASYNC_QUEUE_SIZE * CONFIG_RPR_HTTP_ASYNC_WAITERS)
+
+struct server_async_call {
+    alnicko_server_cb_t cb;
+    void               *user_data;
+};
+
+K_MEM_SLAB_DEFINE_STATIC(server_calls,
+                         sizeof(struct server_async_call),
+                         SERVER_ASYNC_CALLS,
+                         4);
+#endif
+
+/**
+ * @brief Parses a datetime value and fills rtc_time struct.
+ *
+ * The value has the format: "[YYYY-MM-DD] <HH:MM:SS>".
+ *
+ * @param str Pointer to the datetime value.
+ * @param t Pointer to rtc_time structure to store parsed values.
+ *
+ * @return SERVER_OK on success,
+ *         SERVER_ERR_INVALID_FORMAT if the datetime format is incorrect.
+ */
+static server_status_t parse_datetime_value(const char      *str,
+                                            struct rtc_time *t)
+{
+    int y, M, d, h, m, s;
+    if (sscanf(str, "[%d-%d-%d] <%d:%d:%d>", &y, &M, &d, &h, &m, &s) != 6) {
+        return SERVER_ERR_INVALID_FORMAT;
+    }
+
+    t->tm_year = y;
+    t->tm_mon  = M;
+    t->tm_mday = d;
+    t->tm_hour = h;
+    t->tm_min  = m;
+    t->tm_sec  = s;
+    return SERVER_OK;
+}
+
+#ifdef CONFIG_RPR_HTTP_JSON
+struct datetime_json {
+    struct rtc_time *t;
+    server_status_t  status;
+};
+
+struct fw_name_json {
+    char           *buffer;
+    size_t          buffer_size;
+    server_status_t status;
+};
+
+struct audio_list_json {
+    char (*names)[AUDIO_NAME_MAX_LEN];
+    size_t rows;  /* Names to store */
+    size_t skip;  /* Names to pass over before storing */
+    size_t found; /* Names in the list so far */
+    long   count; /* Value of "count", -1 if not received */
+    bool   in_files;
+    bool   has_files;
+};
+
+/**
+ * @brief Checks whether a token is a member of the top-level object.
+ *
+ * @param tok   Parsed value.
+ * @param event Expected type of the value.
+ * @param key   Expected member name.
+ *
+ * @return true if the token is the member, false otherwise.
+ */
+static bool json_is_member(const struct http_json_token *tok,
+                           http_json_event_t             event,
+                           const char                   *key)
+{
+    return tok->depth == 1 && tok->event == event && tok->key &&
+           strcmp(tok->key, key) == 0;
+}
+
+/**
+ * @brief Takes the "datetime" member of the time response.
+ *
+ * @param tok       Parsed value.
+ * @param user_data Pointer to a datetime_json structure.
+ *
+ * @return Always 0, the rest of the response is read.
+ */
+static int datetime_json_cb(const struct http_json_token *tok, void *user_data)
+{
+    struct datetime_json *dt = user_data;
+
+    if (json_is_member(tok, HTTP_JSON_STRING, "datetime")) {
+        dt->status = parse_datetime_value(tok->value, dt->t);
+    }
+    return 0;
+}
+
+#ifdef CONFIG_RPR_HTTP_ASYNC
+/**
+ * @brief Parses a JSON string to extract datetime and fill rtc_time struct.
+ *
+ * @param json_str Pointer to the JSON string containing the datetime field.
+ * @param t Pointer to rtc_time structure to store parsed values.
+ *
+ * @return SERVER_OK on success,
+ *         SERVER_ERR_FIELD_NOT_FOUND if the key is missing,
+ *         SERVER_ERR_INVALID_FORMAT if the JSON or the datetime is malformed.
+ */
+static server_status_t parse_datetime_json(const char      *json_str,
+                                           struct rtc_time *t)
+{
+    struct datetime_json dt = {
+        .t      = t,
+        .status = SERVER_ERR_FIELD_NOT_FOUND,
+    };
+    struct http_json_parser parser;
+
+    http_json_init(&parser, datetime_json_cb, &dt);
+    http_json_write(&parser, json_str, strlen(json_str));
+    if (http_json_finish(&parser) < 0) {
+        return SERVER_ERR_INVALID_FORMAT;
+    }
+    return dt.status;
+}
+#endif
+
+/**
+ * @brief Takes the "name" member of the firmware response.
+ *
+ * @param tok       Parsed value.
+ * @param user_data Pointer to a fw_name_json structure.
+ *
+ * @return Always 0, the rest of the response is read.
+ */
+static int fw_name_json_cb(const struct http_json_token *tok, void *user_data)
+{
+    struct fw_name_json *fw = user_data;
+
+    if (json_is_member(tok, HTTP_JSON_STRING, "name")) {
+        size_t len = MIN(tok->len, fw->buffer_size - 1);
+
+        memcpy(fw->buffer, tok->value, len);
+        fw->buffer[len] = '\0';
+        fw->status      = SERVER_OK;
+    }
+    return 0;
+}
+
+/**
+ * @brief Takes the count and the file names of the audio list response.
+ *
+ * The names are the "name" members of the objects in the "files" array.
+ * Only the ones in the window given by skip and rows are stored, the
+ * others are counted.
+ *
+ * @param tok       Parsed value.
+ * @param user_data Pointer to an audio_list_json structure.
+ *
+ * @return Always 0, the rest of the response is read.
+ */
+static int audio_list_json_cb(const struct http_json_token *tok,
+                              void                         *user_data)
+{
+    struct audio_list_json *list = user_data;
+
+    if (json_is_member(tok, HTTP_JSON_NUMBER, "count")) {
+        list->count = strtol(tok->value, NULL, 10);
+    } else if (json_is_member(tok, HTTP_JSON_ARRAY_START, "files")) {
+        list->in_files  = true;
+        list->has_files = true;
+    } else if (tok->depth == 1 && tok->event == HTTP_JSON_ARRAY_END) {
+        list->in_files = false;
+    } else if (list->in_files && tok->depth == 3 &&
+               tok->event == HTTP_JSON_STRING && tok->key &&
+               strcmp(tok->key, "name") == 0) {
+        size_t index = list->found++;
+
+        if (index < list->skip || index - list->skip >= list->rows) {
+            return 0;
+        }
+        if (tok->truncated) {
+            LOG_WRN("Audio name %zu is too long, truncated", index + 1);
+        }
+
+        char  *name = list->names[index - list->skip];
+        size_t len  = MIN(tok->len, AUDIO_NAME_MAX_LEN - 1);
+
+        memcpy(name, tok->value, len);
+        name[len] = '\0';
+    }
+    return 0;
+}
+
+/**
+ * @brief Passes a fragment of a response body to the JSON parser.
+ *
+ * @param data      Fragment of the body.
+ * @param len       Length of the fragment.
+ * @param user_data Pointer to the http_json_parser.
+ */
+static void server_json_body(const uint8_t *data, size_t len, void *user_data)
+{
+    /* Errors are kept by the parser and reported by http_json_finish() */
+    http_json_write(user_data, (const char *)data, len);
+}
+
+/**
+ * @brief Sends a GET request and parses the JSON response as it arrives.
+ *
+ * @param url       The target URL.
+ * @param cache     Resource that changes seldom, sent as a conditional
+ *                  request with CONFIG_RPR_HTTP_CACHE.
+ * @param cb        Function called for every value of the response.
+ * @param user_data User data for the callback.
+ *
+ * @return SERVER_OK on success,
+ *         SERVER_ERR_HTTP on HTTP failure,
+ *         SERVER_ERR_INVALID_FORMAT if the response is not valid JSON.
+ */
+static server_status_t server_get_json(const char    *url,
+                                       bool           cache,
+                                       http_json_cb_t cb,
+                                       void          *user_data)
+{
+    struct http_json_parser parser;
+    uint16_t                http_status_code = 0;
+
+    struct get_context get_ctx = {
+        .body_cb   = server_json_body,
+        .user_data = &parser,
+        .cache     = cache,
+    };
+
+    http_json_init(&parser, cb, user_data);
+
+    http_status_t ret = http_get_request(url, &get_ctx, &http_status_code);
+
+    if (ret != HTTP_CLIENT_OK) {
+        LOG_ERR("GET failed: ret=%d", ret);
+        return SERVER_ERR_HTTP;
+    }
+
+    LOG_INF("HTTP %d OK", http_status_code);
+    LOG_DBG("GET: %zu bytes parsed", get_ctx.response_len);
+
+    if (http_json_finish(&parser) < 0) {
+        return SERVER_ERR_INVALID_FORMAT;
+    }
+    return SERVER_OK;
+}
+
+/**
+ * @brief Retrieves a window of the audio file names from the Alnicko server.
+ *
+ * The list is parsed as it arrives, so it may be of any length.
+ *
+ * @param names  Output buffer to store audio filenames.
+ * @param rows   Maximum number of filenames to store.
+ * @param skip   Number of filenames to pass over before storing.
+ * @param listed Pointer to variable to receive the number of files listed.
+ *
+ * @return SERVER_OK on success.
+ *         SERVER_ERR_HTTP on name list retrieval failure.
+ *         SERVER_ERR_INVALID_FORMAT or SERVER_ERR_FIELD_NOT_FOUND if JSON parsing fails.
+ */
+static server_status_t
+server_get_audio_names(char (*names)[AUDIO_NAME_MAX_LEN],
+                       size_t  rows,
+                       size_t  skip,
+                       size_t *listed)
+{
+    struct audio_list_json list = {
+        .names = names,
+        .rows  = rows,
+        .skip  = skip,
+        .count = -1,
+    };
+
+    server_status_t res = server_get_json(
+            ALNICKO_SERVER_AUDIO_LIST, true, audio_list_json_cb, &list);
+
+    if (res != SERVER_OK)
+        return res;
+
+    if (list.count < 0)
+        return SERVER_ERR_INVALID_FORMAT;
+
+    if (!list.has_files)
+        return SERVER_ERR_FIELD_NOT_FOUND;
+
+    *listed = MIN(list.found, (size_t)list.count);
+    return SERVER_OK;
+}
+#else
 /**
  * @brief Parses a JSON string to extract datetime and fill rtc_time struct.
  *
@@ -58,18 +380,7 @@ static server_status_t parse_datetime_json(const char      *json_str,
     while (*start && (*start == ' ' || *start == '"'))
         start++;
 
-    int y, M, d, h, m, s;
-    if (sscanf(start, "[%d-%d-%d] <%d:%d:%d>", &y, &M, &d, &h, &m, &s) != 6) {
-        return SERVER_ERR_INVALID_FORMAT;
-    }
-
-    t->tm_year = y;
-    t->tm_mon  = M;
-    t->tm_mday = d;
-    t->tm_hour = h;
-    t->tm_min  = m;
-    t->tm_sec  = s;
-    return SERVER_OK;
+    return parse_datetime_value(start, t);
 }
 
 /**
@@ -173,6 +484,7 @@ static server_status_t parse_audio_list_json(const char *json_str,
     *count = parsed;
     return SERVER_OK;
 }
+#endif // CONFIG_RPR_HTTP_JSON
 
 /**
  * @brief Retrieves the current datetime from the Alnicko server.
@@ -189,6 +501,17 @@ static server_status_t parse_audio_list_json(const char *json_str,
  */
 server_status_t alnicko_server_get_time(struct rtc_time *t)
 {
+#ifdef CONFIG_RPR_HTTP_JSON
+    struct datetime_json dt = {
+        .t      = t,
+        .status = SERVER_ERR_FIELD_NOT_FOUND,
+    };
+
+    server_status_t res = server_get_json(
+            ALNICKO_SERVER_GET_TIME, false, datetime_json_cb, &dt);
+
+    return res == SERVER_OK ? dt.status : res;
+#else
     const char *url              = ALNICKO_SERVER_GET_TIME;
     uint16_t    http_status_code = 0;
     char        response_buf[HTTP_GET_RESPONSE_BUF_LEN] = { 0 };
@@ -210,6 +533,7 @@ server_status_t alnicko_server_get_time(struct rtc_time *t)
     LOG_DBG("GET: %s", response_buf);
 
     return parse_datetime_json(response_buf, t);
+#endif
 }
 
 /**
@@ -255,6 +579,18 @@ server_status_t alnicko_server_update_time(void)
 server_status_t alnicko_server_get_update_fw_name(char  *buffer,
                                                   size_t buffer_size)
 {
+#ifdef CONFIG_RPR_HTTP_JSON
+    struct fw_name_json fw = {
+        .buffer      = buffer,
+        .buffer_size = buffer_size,
+        .status      = SERVER_ERR_FIELD_NOT_FOUND,
+    };
+
+    server_status_t res = server_get_json(
+            ALNICKO_SERVER_FW_NAME, false, fw_name_json_cb, &fw);
+
+    return res == SERVER_OK ? fw.status : res;
+#else
     const char *url              = ALNICKO_SERVER_FW_NAME;
     uint16_t    http_status_code = 0;
     char        response_buf[HTTP_GET_RESPONSE_BUF_LEN] = { 0 };
@@ -276,13 +612,71 @@ server_status_t alnicko_server_get_update_fw_name(char  *buffer,
     LOG_DBG("GET: %s", response_buf);
 
     return parse_fw_name_json(response_buf, buffer, buffer_size);
+#endif
+}
+
+#ifdef CONFIG_RPR_DFU_DELTA
+/**
+ * @brief Applies the delta patch from the running firmware to an update.
+ *
+ * Patches are named after the full image and the version they apply to,
+ * as script/generate_delta.py writes them:
+ * "<name>_from_V<running version>.delta" for "<name>.bin".
+ *
+ * @param fw_name File name of the full update image.
+ *
+ * @return SERVER_OK if the update was rebuilt from the patch,
+ *         SERVER_ERR_INVALID_FORMAT if the name is not a .bin image,
+ *         SERVER_ERR_HTTP if there is no usable patch.
+ */
+static server_status_t alnicko_server_get_update_delta(const char *fw_name)
+{
+    const char *ext     = strrchr(fw_name, '.');
+    const char *version = dev_info_get_fw_version_str(NULL);
+
+    if (!ext || strcmp(ext, ".bin") != 0) {
+        return SERVER_ERR_INVALID_FORMAT;
+    }
+
+    char url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
+    int  len = snprintf(url,
+                       sizeof(url),
+                       "%s%.*s_from_V%s.delta",
+                       ALNICKO_SERVER_GET_FW,
+                       (int)(ext - fw_name),
+                       fw_name,
+                       version);
+
+    if (len < 0 || len >= sizeof(url)) {
+        return SERVER_ERR_INVALID_FORMAT;
+    }
+
+    LOG_INF("Downloading delta update from: %s", url);
+
+    uint16_t      http_status_code = 0;
+    http_status_t ret = http_download_update_delta(url, &http_status_code);
+
+    if (ret != HTTP_CLIENT_OK) {
+        LOG_WRN("Delta update not applied (error %d, HTTP %d), "
+                "falling back to the full image",
+                ret,
+                http_status_code);
+        return SERVER_ERR_HTTP;
+    }
+
+    LOG_INF("Firmware update rebuilt from delta. HTTP status: %d",
+            http_status_code);
+    return SERVER_OK;
 }
+#endif
 
 /**
  * @brief Downloads the latest firmware update from the Alnicko server.
  *
  * First retrieves the firmware filename using a GET request to the firmware name endpoint.
  * Then constructs the full firmware download URL and sends an HTTP request to download the file.
+ * With CONFIG_RPR_DFU_DELTA the patch from the running version is tried
+ * first, the full image is downloaded if there is none or it fails.
  *
  * @return SERVER_OK on success,
  *         SERVER_ERR_HTTP on download failure or name retrieval failure.
@@ -301,13 +695,24 @@ server_status_t alnicko_server_get_update_fw(void)
     char url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
     snprintf(url, sizeof(url), "%s%s", ALNICKO_SERVER_GET_FW, fw_name);
 
-    LOG_INF("Downloading update from: %s", url);
-
     uint16_t http_status_code = 0;
 
     k_msleep(SERVER_DELAY_MS);
 
+#ifdef CONFIG_RPR_DFU_DELTA
+    if (alnicko_server_get_update_delta(fw_name) == SERVER_OK) {
+        return SERVER_OK;
+    }
+#endif
+
+    LOG_INF("Downloading update from: %s", url);
+
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+    http_status_t ret = http_download_update_segmented(
+            url, &http_status_code, CONFIG_RPR_HTTP_SEGMENTS);
+#else
     http_status_t ret = http_download_update_request(url, &http_status_code);
+#endif
 
     if (ret == HTTP_CLIENT_OK) {
         LOG_INF("Firmware update downloaded successfully. HTTP status: %d",
@@ -338,6 +743,16 @@ server_status_t alnicko_server_get_audio_list(char (*names)[AUDIO_NAME_MAX_LEN],
                                               size_t  rows,
                                               size_t *count)
 {
+#ifdef CONFIG_RPR_HTTP_JSON
+    size_t          listed = 0;
+    server_status_t res    = server_get_audio_names(names, rows, 0, &listed);
+
+    if (res != SERVER_OK)
+        return res;
+
+    *count = MIN(listed, rows);
+    return SERVER_OK;
+#else
     const char *url              = ALNICKO_SERVER_AUDIO_LIST;
     uint16_t    http_status_code = 0;
     char        response_buf[HTTP_GET_RESPONSE_BUF_LEN] = { 0 };
@@ -346,6 +761,7 @@ server_status_t alnicko_server_get_audio_list(char (*names)[AUDIO_NAME_MAX_LEN],
         .response_buffer = response_buf,
         .buffer_capacity = sizeof(response_buf),
         .response_len    = 0,
+        .cache           = true,
     };
 
     http_status_t ret = http_get_request(url, &get_ctx, &http_status_code);
@@ -358,6 +774,7 @@ server_status_t alnicko_server_get_audio_list(char (*names)[AUDIO_NAME_MAX_LEN],
     LOG_DBG("GET: %s", response_buf);
 
     return parse_audio_list_json(response_buf, names, rows, count);
+#endif
 }
 
 /**
@@ -378,8 +795,16 @@ server_status_t alnicko_server_get_audio_by_name(const char *filename)
     LOG_INF("Downloading audio from: %s", url);
     uint16_t http_status_code = 0;
 
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+    http_status_t ret =
+            http_download_file_segmented(url,
+                                         CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                                         &http_status_code,
+                                         CONFIG_RPR_HTTP_SEGMENTS);
+#else
     http_status_t ret = http_download_file_request(
             url, CONFIG_RPR_AUDIO_DEFAULT_PATH, &http_status_code);
+#endif
 
     if (ret == HTTP_CLIENT_OK) {
         LOG_INF("Download audio successful. Status code: %d", http_status_code);
@@ -394,7 +819,9 @@ server_status_t alnicko_server_get_audio_by_name(const char *filename)
  * @brief Downloads an audio file from the Alnicko server by its index in the list.
  *
  * Retrieves the full list of audio filenames from the server, then downloads
- * the audio file corresponding to the given index.
+ * the audio file corresponding to the given index. With CONFIG_RPR_HTTP_JSON
+ * the list is parsed as it arrives and only the name at the index is kept,
+ * so the index is not limited to AUDIO_FILES_MAX.
  *
  * @param num      Index of the audio file in the server's list.
  *
@@ -405,11 +832,20 @@ server_status_t alnicko_server_get_audio_by_name(const char *filename)
  */
 server_status_t alnicko_server_get_audio_by_num(uint8_t num)
 {
+#ifdef CONFIG_RPR_HTTP_JSON
+    /* Only the wanted name is stored, the list may be of any length */
+    char   names[1][AUDIO_NAME_MAX_LEN];
+    size_t count = 0;
+
+    server_status_t res =
+            server_get_audio_names(names, 1, num > 0 ? num - 1 : 0, &count);
+#else
     char   names[AUDIO_FILES_MAX][AUDIO_NAME_MAX_LEN];
     size_t count = 0;
 
     server_status_t res =
             alnicko_server_get_audio_list(names, AUDIO_FILES_MAX, &count);
+#endif
 
     if (res != SERVER_OK)
         return res;
@@ -419,7 +855,11 @@ server_status_t alnicko_server_get_audio_by_num(uint8_t num)
     if (num > count || num == 0)
         return SERVER_ERR_INVALID_INDEX;
 
+#ifdef CONFIG_RPR_HTTP_JSON
+    return alnicko_server_get_audio_by_name(names[0]);
+#else
     return alnicko_server_get_audio_by_name(names[--num]);
+#endif
 }
 
 /**
@@ -468,3 +908,378 @@ server_status_t alnicko_server_post_message(const char *msg)
         return SERVER_ERR_HTTP;
     }
 }
+
+#ifdef CONFIG_RPR_HTTP_POOL
+/**
+ * @brief Opens connections to the Alnicko server ahead of the first request.
+ *
+ * Queues one connection to the API port and one to the download port, so
+ * the requests made right after connecting skip the connection setup.
+ */
+void alnicko_server_prewarm(void)
+{
+    const char *urls[] = { ALNICKO_SERVER_GET_TIME, ALNICKO_SERVER_GET_AUDIO };
+
+    for (size_t i = 0; i < ARRAY_SIZE(urls); i++) {
+        int ret = http_pool_prewarm(urls[i]);
+
+        if (ret < 0 && ret != -EALREADY) {
+            LOG_WRN("Pre-warming %s failed: %d", urls[i], ret);
+        }
+    }
+}
+#endif
+
+#ifdef CONFIG_RPR_HTTP_ASYNC
+/**
+ * @brief Completes an asynchronous request for the caller.
+ *
+ * @param call   Callback of the caller, NULL if none. Freed here.
+ * @param status Result to report.
+ */
+static void server_async_done(struct server_async_call *call,
+                              server_status_t           status)
+{
+    if (!call) {
+        return;
+    }
+
+    call->cb(status, call->user_data);
+    k_mem_slab_free(&server_calls, call);
+}
+
+/**
+ * @brief Queues a request with a completion handler of this module.
+ *
+ * @param req       Request to queue, its callback is the module handler.
+ * @param cb        Callback of the caller, NULL if none.
+ * @param user_data User data for the callback of the caller.
+ *
+ * @return SERVER_OK if queued,
+ *         SERVER_ERR_BUSY if the request queue is full,
+ *         SERVER_ERR_HTTP if the request could not be queued.
+ */
+static server_status_t server_async_submit(struct http_async_request *req,
+                                           alnicko_server_cb_t        cb,
+                                           void                      *user_data)
+{
+    struct server_async_call *call = NULL;
+
+    if (cb) {
+        if (k_mem_slab_alloc(&server_calls, (void **)&call, K_NO_WAIT) != 0) {
+            return SERVER_ERR_BUSY;
+        }
+        call->cb        = cb;
+        call->user_data = user_data;
+    }
+
+    req->user_data = call;
+
+    int ret = http_async_submit(req);
+    if (ret >= 0) {
+        return SERVER_OK;
+    }
+
+    if (call) {
+        k_mem_slab_free(&server_calls, call);
+    }
+
+    LOG_ERR("Queueing %s failed: %d", req->url, ret);
+    return ret == -ENOMEM ? SERVER_ERR_BUSY : SERVER_ERR_HTTP;
+}
+
+/**
+ * @brief Sets the RTC from the response of an asynchronous time request.
+ *
+ * @param result    Result of the GET request.
+ * @param user_data Callback of the caller.
+ */
+static void server_time_done(const struct http_async_result *result,
+                             void                           *user_data)
+{
+    server_status_t res = SERVER_ERR_HTTP;
+    struct rtc_time t;
+
+    if (result->status != HTTP_CLIENT_OK) {
+        LOG_ERR("GET failed: ret=%d", result->status);
+        goto out;
+    }
+
+    LOG_INF("HTTP %d OK", result->http_status_code);
+    LOG_DBG("GET: %s", result->body);
+
+    res = parse_datetime_json(result->body, &t);
+    if (res != SERVER_OK) {
+        goto out;
+    }
+
+    if (set_date_time(&t) < 0) {
+        LOG_ERR("RTC update failed");
+        res = SERVER_ERR_RTC_SET_FAILED;
+    }
+
+out:
+    server_async_done(user_data, res);
+}
+
+/**
+ * @brief Queues an update of the local RTC time from the Alnicko server.
+ *
+ * @param cb        Completion callback, NULL if not needed.
+ * @param user_data User data for the callback.
+ *
+ * @return SERVER_OK if queued,
+ *         SERVER_ERR_BUSY if the request queue is full,
+ *         SERVER_ERR_HTTP if the request could not be queued.
+ */
+server_status_t alnicko_server_update_time_async(alnicko_server_cb_t cb,
+                                                 void               *user_data)
+{
+    struct http_async_request req = {
+        .method = HTTP_ASYNC_GET,
+        .prio   = HTTP_ASYNC_PRIO_HIGH,
+        .url    = ALNICKO_SERVER_GET_TIME,
+        .cb     = server_time_done,
+    };
+
+    return server_async_submit(&req, cb, user_data);
+}
+
+/**
+ * @brief Reports the result of an asynchronous POST request.
+ *
+ * @param result    Result of the POST request.
+ * @param user_data Callback of the caller.
+ */
+static void server_post_done(const struct http_async_result *result,
+                             void                           *user_data)
+{
+    if (result->status == HTTP_CLIENT_OK) {
+        LOG_INF("HTTP %d OK", result->http_status_code);
+        LOG_DBG("POST response: %s", result->body);
+        server_async_done(user_data, SERVER_OK);
+    } else {
+        LOG_ERR("POST failed: ret=%d", result->status);
+        server_async_done(user_data, SERVER_ERR_HTTP);
+    }
+}
+
+/**
+ * @brief Queues a message to the Alnicko server.
+ *
+ * @param msg       String message to be sent in the POST body, copied.
+ * @param cb        Completion callback, NULL if not needed.
+ * @param user_data User data for the callback.
+ *
+ * @return SERVER_OK if queued,
+ *         SERVER_ERR_BUSY if the request queue is full,
+ *         SERVER_ERR_HTTP if the request could not be queued.
+ */
+server_status_t
+alnicko_server_post_message_async(const char         *msg,
+                                  alnicko_server_cb_t cb,
+                                  void               *user_data)
+{
+    char payload[POST_PAYLOAD_MAX_SIZE];
+
+    snprintf(payload, sizeof(payload), "{\"message\":\"%s\"}", msg);
+
+    struct http_async_request req = {
+        .method       = HTTP_ASYNC_POST,
+        .prio         = HTTP_ASYNC_PRIO_NORMAL,
+        .url          = ALNICKO_SERVER_POST_MESSAGE,
+        .payload      = payload,
+        .content_type = "application/json",
+        .cb           = server_post_done,
+    };
+
+    LOG_INF("Queueing POST request to: %s", req.url);
+
+    return server_async_submit(&req, cb, user_data);
+}
+
+/**
+ * @brief Reports the result of an asynchronous audio download.
+ *
+ * @param result    Result of the download.
+ * @param user_data Callback of the caller.
+ */
+static void server_audio_done(const struct http_async_result *result,
+                              void                           *user_data)
+{
+    if (result->status == HTTP_CLIENT_OK) {
+        LOG_INF("Download audio successful. Status code: %d",
+                result->http_status_code);
+        server_async_done(user_data, SERVER_OK);
+    } else {
+        LOG_ERR("Download failed. Error code: %d", result->status);
+        server_async_done(user_data, SERVER_ERR_HTTP);
+    }
+}
+
+/**
+ * @brief Queues the download of an audio file from the Alnicko server.
+ *
+ * @param filename  Name of the audio file to download.
+ * @param cb        Completion callback, NULL if not needed.
+ * @param user_data User data for the callback.
+ *
+ * @return SERVER_OK if queued,
+ *         SERVER_ERR_BUSY if the request queue is full,
+ *         SERVER_ERR_HTTP if the request could not be queued.
+ */
+server_status_t
+alnicko_server_get_audio_by_name_async(const char         *filename,
+                                       alnicko_server_cb_t cb,
+                                       void               *user_data)
+{
+    char url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
+    snprintf(url, sizeof(url), "%s%s", ALNICKO_SERVER_GET_AUDIO, filename);
+
+    struct http_async_request req = {
+        .method   = HTTP_ASYNC_DOWNLOAD,
+        .prio     = HTTP_ASYNC_PRIO_LOW,
+        .url      = url,
+        .base_dir = CONFIG_RPR_AUDIO_DEFAULT_PATH,
+        .cb       = server_audio_done,
+    };
+
+    LOG_INF("Queueing audio download from: %s", url);
+
+    return server_async_submit(&req, cb, user_data);
+}
+#endif // CONFIG_RPR_HTTP_ASYNC
+
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+/**
+ * @brief Writes a string as the contents of a JSON string.
+ *
+ * Quotes, backslashes and control characters are escaped.
+ *
+ * @param dst  Buffer to write to.
+ * @param size Size of the buffer.
+ * @param src  String to escape.
+ *
+ * @return Length of the escaped string, -ENOSPC if it does not fit.
+ */
+static int server_json_escape(char *dst, size_t size, const char *src)
+{
+    size_t len = 0;
+
+    dst[0] = '\0';
+
+    for (; *src; src++) {
+        unsigned char c = *src;
+        int           n;
+
+        if (c == '"' || c == '\\') {
+            n = snprintf(dst + len, size - len, "\\%c", c);
+        } else if (c < 0x20) {
+            n = snprintf(dst + len, size - len, "\\u%04x", c);
+        } else {
+            n = snprintf(dst + len, size - len, "%c", c);
+        }
+
+        if (n < 0 || n >= size - len) {
+            return -ENOSPC;
+        }
+        len += n;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Starts the delivery of queued messages to the Alnicko server.
+ *
+ * Messages queued before a reboot are sent once the network is up.
+ *
+ * @return SERVER_OK on success,
+ *         SERVER_ERR_HTTP if the message queue cannot be opened.
+ */
+server_status_t alnicko_server_outbox_start(void)
+{
+    int ret = http_outbox_init(ALNICKO_SERVER_POST_BATCH);
+
+    if (ret < 0 && ret != -EALREADY) {
+        LOG_ERR("Failed to open the message queue: %d", ret);
+        return SERVER_ERR_HTTP;
+    }
+    return SERVER_OK;
+}
+
+/**
+ * @brief Queues a message to the Alnicko server.
+ *
+ * The message is stored on the filesystem and posted with others in one
+ * request when the server is reachable, also after a reboot.
+ *
+ * @param msg String message to be sent.
+ *
+ * @return SERVER_OK if stored,
+ *         SERVER_ERR_INVALID_FORMAT if the message is too long,
+ *         SERVER_ERR_HTTP if the message could not be stored.
+ */
+server_status_t alnicko_server_queue_message(const char *msg)
+{
+    char payload[POST_PAYLOAD_MAX_SIZE];
+    char text[POST_PAYLOAD_MAX_SIZE];
+
+    /* A message the server cannot parse would stay at the head of the queue */
+    if (server_json_escape(text, sizeof(text), msg) < 0) {
+        return SERVER_ERR_INVALID_FORMAT;
+    }
+
+    int len = snprintf(payload, sizeof(payload), "{\"message\":\"%s\"}", text);
+    if (len < 0 || len >= sizeof(payload)) {
+        return SERVER_ERR_INVALID_FORMAT;
+    }
+
+    int ret = http_outbox_push(payload);
+    if (ret < 0) {
+        LOG_ERR("Failed to queue message: %d", ret);
+        return ret == -EMSGSIZE ? SERVER_ERR_INVALID_FORMAT : SERVER_ERR_HTTP;
+    }
+
+    LOG_INF("Message queued");
+    return SERVER_OK;
+}
+#endif // CONFIG_RPR_HTTP_OUTBOX
+
+#ifdef CONFIG_RPR_HTTP_SYNC
+/**
+ * @brief Synchronises the audio directory with the library on the Alnicko
+ *        server.
+ *
+ * @param stats Pointer to store the statistics of the sync, may be NULL.
+ *
+ * @return SERVER_OK on success,
+ *         SERVER_ERR_BUSY if a sync is already running,
+ *         SERVER_ERR_INVALID_FORMAT if the manifest is not valid, lists too
+ *         many files or a file does not match it,
+ *         SERVER_ERR_HTTP on request or file system failure.
+ */
+server_status_t alnicko_server_sync_audio(struct http_sync_stats *stats)
+{
+    LOG_INF("Synchronising audio library from: %s", ALNICKO_SERVER_AUDIO_SYNC);
+
+    int ret = http_sync_run(ALNICKO_SERVER_AUDIO_SYNC,
+                            ALNICKO_SERVER_GET_AUDIO,
+                            CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                            stats);
+
+    switch (ret) {
+    case 0:
+        return SERVER_OK;
+    case -EBUSY:
+        return SERVER_ERR_BUSY;
+    case -EBADMSG:
+    case -ENOMEM:
+        LOG_ERR("Audio manifest is not usable: %d", ret);
+        return SERVER_ERR_INVALID_FORMAT;
+    default:
+        LOG_ERR("Audio sync failed: %d", ret);
+        return SERVER_ERR_HTTP;
+    }
+}
+#endif // CONFIG_RPR_HTTP_SYNC
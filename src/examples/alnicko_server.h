@@ -7,7 +7,9 @@
  * - Retrieve and update device time (RTC) from the server,
  * - List and download audio files by name or index,
  * - Check for available firmware updates and download them,
- * - Send messages to the server via HTTP POST.
+ * - Send messages to the server via HTTP POST,
+ * - Queue messages that are delivered in batches once the server is reachable,
+ * - Synchronise the audio directory with the library on the server.
  *
  * @author Eugene K.
  * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
@@ -18,6 +20,10 @@
 
 #include "rtc.h"
 
+#ifdef CONFIG_RPR_HTTP_SYNC
+#include "http_sync.h"
+#endif
+
 #define AUDIO_NAME_MAX_LEN     128
 #define AUDIO_FILES_MAX        16
 #define FW_UPDATE_NAME_MAX_LEN 128
@@ -29,7 +35,8 @@ typedef enum {
     SERVER_ERR_FIELD_NOT_FOUND = -2,
     SERVER_ERR_INVALID_FORMAT  = -3,
     SERVER_ERR_RTC_SET_FAILED  = -4,
-    SERVER_ERR_INVALID_INDEX   = -5
+    SERVER_ERR_INVALID_INDEX   = -5,
+    SERVER_ERR_BUSY            = -6
 } server_status_t;
 
 /**
@@ -95,7 +102,9 @@ server_status_t alnicko_server_get_audio_by_name(const char *filename);
  * @brief Downloads an audio file from the Alnicko server by its index in the list.
  *
  * Retrieves the full list of audio filenames from the server, then downloads
- * the audio file corresponding to the given index.
+ * the audio file corresponding to the given index. With CONFIG_RPR_HTTP_JSON
+ * the list is parsed as it arrives and only the name at the index is kept,
+ * so the index is not limited to AUDIO_FILES_MAX.
  *
  * @param num      Index of the audio file in the server's list.
  *
@@ -127,6 +136,8 @@ server_status_t alnicko_server_get_update_fw_name(char  *buffer,
  *
  * First retrieves the firmware filename using a GET request to the firmware name endpoint.
  * Then constructs the full firmware download URL and sends an HTTP request to download the file.
+ * With CONFIG_RPR_DFU_DELTA the patch from the running version is tried
+ * first, the full image is downloaded if there is none or it fails.
  *
  * @return SERVER_OK on success,
  *         SERVER_ERR_HTTP on download failure or name retrieval failure.
@@ -147,4 +158,123 @@ server_status_t alnicko_server_get_update_fw(void);
  */
 server_status_t alnicko_server_post_message(const char *msg);
 
+#ifdef CONFIG_RPR_HTTP_ASYNC
+/**
+ * @brief Completion callback of an asynchronous server request.
+ *
+ * Runs in an HTTP worker thread and must not block on further requests.
+ *
+ * @param status    Result, as returned by the blocking variant.
+ * @param user_data User data given with the request.
+ */
+typedef void (*alnicko_server_cb_t)(server_status_t status, void *user_data);
+
+/**
+ * @brief Queues an update of the local RTC time from the Alnicko server.
+ *
+ * Returns at once; the RTC is set by an HTTP worker, then the callback is
+ * called with the result of alnicko_server_update_time().
+ *
+ * @param cb        Completion callback, NULL if not needed.
+ * @param user_data User data for the callback.
+ *
+ * @return SERVER_OK if queued,
+ *         SERVER_ERR_BUSY if the request queue is full,
+ *         SERVER_ERR_HTTP if the request could not be queued.
+ */
+server_status_t alnicko_server_update_time_async(alnicko_server_cb_t cb,
+                                                 void               *user_data);
+
+/**
+ * @brief Queues a message to the Alnicko server.
+ *
+ * @param msg       String message to be sent in the POST body, copied.
+ * @param cb        Completion callback, NULL if not needed.
+ * @param user_data User data for the callback.
+ *
+ * @return SERVER_OK if queued,
+ *         SERVER_ERR_BUSY if the request queue is full,
+ *         SERVER_ERR_HTTP if the request could not be queued.
+ */
+server_status_t
+alnicko_server_post_message_async(const char         *msg,
+                                  alnicko_server_cb_t cb,
+                                  void               *user_data);
+
+/**
+ * @brief Queues the download of an audio file from the Alnicko server.
+ *
+ * A download of the same file that is already pending is not repeated,
+ * the callback gets its result.
+ *
+ * @param filename  Name of the audio file to download.
+ * @param cb        Completion callback, NULL if not needed.
+ * @param user_data User data for the callback.
+ *
+ * @return SERVER_OK if queued,
+ *         SERVER_ERR_BUSY if the request queue is full,
+ *         SERVER_ERR_HTTP if the request could not be queued.
+ */
+server_status_t
+alnicko_server_get_audio_by_name_async(const char         *filename,
+                                       alnicko_server_cb_t cb,
+                                       void               *user_data);
+#endif // CONFIG_RPR_HTTP_ASYNC
+
+#ifdef CONFIG_RPR_HTTP_POOL
+/**
+ * @brief Opens connections to the Alnicko server ahead of the first request.
+ *
+ * Returns at once, the connections are made by the HTTP pool thread.
+ */
+void alnicko_server_prewarm(void);
+#endif
+
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+/**
+ * @brief Starts the delivery of queued messages to the Alnicko server.
+ *
+ * Messages queued before a reboot are sent once the network is up.
+ *
+ * @return SERVER_OK on success,
+ *         SERVER_ERR_HTTP if the message queue cannot be opened.
+ */
+server_status_t alnicko_server_outbox_start(void);
+
+/**
+ * @brief Queues a message to the Alnicko server.
+ *
+ * The message is stored on the filesystem and posted with others in one
+ * request when the server is reachable, also after a reboot.
+ *
+ * @param msg String message to be sent.
+ *
+ * @return SERVER_OK if stored,
+ *         SERVER_ERR_INVALID_FORMAT if the message is too long,
+ *         SERVER_ERR_HTTP if the message could not be stored.
+ */
+server_status_t alnicko_server_queue_message(const char *msg);
+#endif // CONFIG_RPR_HTTP_OUTBOX
+
+#ifdef CONFIG_RPR_HTTP_SYNC
+/**
+ * @brief Synchronises the audio directory with the library on the Alnicko
+ *        server.
+ *
+ * Fetches the manifest of the library and downloads only the audio files
+ * that are new or changed; files of an earlier sync that are no longer
+ * listed are deleted. The directory changes at once when all files are
+ * downloaded, a failed sync leaves it as it was.
+ *
+ * @param stats Pointer to store the statistics of the sync, may be NULL.
+ *
+ * @return SERVER_OK on success,
+ *         SERVER_ERR_BUSY if a sync is already running,
+ *         SERVER_ERR_INVALID_FORMAT if the manifest is not valid, lists too
+ *         many files or a file does not match it,
+ *         SERVER_ERR_HTTP on request or file system failure.
+ */
+server_status_t alnicko_server_sync_audio(struct http_sync_stats *stats);
+#endif // CONFIG_RPR_HTTP_SYNC
+
 #endif // ALNICKO_SERVER_H
@@ -229,6 +229,69 @@ cmd_alnicko_post_message(const struct shell *sh, size_t argc, char **argv)
     return ret;
 }
 
+/**
+ * @brief Shell command to queue a message to the server.
+ *
+ * The message is stored and sent in a batch once the server is reachable.
+ * CONFIG_RPR_HTTP_OUTBOX must be enabled.
+ */
+static int
+cmd_alnicko_queue_message(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+    if (argc < 2) {
+        shell_error(sh, "Usage: alnicko queue <message>");
+        return -EINVAL;
+    }
+
+    server_status_t ret = alnicko_server_queue_message(argv[1]);
+
+    if (ret == SERVER_OK) {
+        shell_info(sh, "Message queued successfully.");
+    } else {
+        shell_error(sh, "Failed to queue message. Error code: %d", ret);
+    }
+
+    return ret;
+#else
+    shell_info(sh, "Set CONFIG_RPR_HTTP_OUTBOX to enable the message queue.");
+    return 0;
+#endif
+}
+
+/**
+ * @brief Shell command to synchronise the audio directory with the server.
+ *
+ * Downloads only the new or changed audio files and prints what the sync
+ * did. CONFIG_RPR_HTTP_SYNC must be enabled.
+ */
+static int
+cmd_alnicko_audio_sync(const struct shell *sh, size_t argc, char **argv)
+{
+#ifdef CONFIG_RPR_HTTP_SYNC
+    struct http_sync_stats stats;
+    server_status_t        ret = alnicko_server_sync_audio(&stats);
+
+    if (ret != SERVER_OK) {
+        shell_error(sh, "Audio sync failed. Error code: %d", ret);
+        return ret;
+    }
+
+    shell_info(sh,
+               "Library version %u: %u files, %u fetched (%u KiB), "
+               "%u removed",
+               stats.version,
+               stats.files,
+               stats.fetched,
+               stats.fetched_bytes / 1024,
+               stats.removed);
+    return 0;
+#else
+    shell_info(sh, "Set CONFIG_RPR_HTTP_SYNC to enable the audio sync.");
+    return 0;
+#endif
+}
+
 SHELL_STATIC_SUBCMD_SET_CREATE(
         alnicko_time_subcmds,
         SHELL_CMD(get, NULL, "Get time from server", cmd_alnicko_time_get),
@@ -263,6 +326,10 @@ SHELL_STATIC_SUBCMD_SET_CREATE(
                   &alnicko_audio_get_cmds,
                   "Download audio by name or index",
                   NULL),
+        SHELL_CMD(sync,
+                  NULL,
+                  "Download only new or changed audio files",
+                  cmd_alnicko_audio_sync),
         SHELL_SUBCMD_SET_END);
 
 SHELL_STATIC_SUBCMD_SET_CREATE(alnicko_update_cmds,
@@ -290,6 +357,12 @@ SHELL_STATIC_SUBCMD_SET_CREATE(
                       cmd_alnicko_post_message,
                       2,
                       SHELL_OPT_ARG_MAX),
+        SHELL_CMD_ARG(queue,
+                      NULL,
+                      "Queue message to server: alnicko queue <message>",
+                      cmd_alnicko_queue_message,
+                      2,
+                      SHELL_OPT_ARG_MAX),
         SHELL_SUBCMD_SET_END);
 
 SHELL_CMD_REGISTER(alnicko, &alnicko_subcmds, "Alnicko server command", NULL);
@@ -45,9 +45,18 @@
 
 #ifdef CONFIG_RPR_MODULE_HTTP
 #include "alnicko_server.h"
+#include "http_module.h"
 
 #endif
 
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+#include "http_outbox.h"
+#endif
+
+#ifdef CONFIG_RPR_HTTP_SYNC
+#include "http_sync.h"
+#endif
+
 #ifdef CONFIG_RPR_MODULE_DFU
 #include "dfu_manager.h"
 #endif
@@ -148,35 +157,44 @@ static void audio_play(void)
             return;
         }
 
-        struct fs_dir_t  dir;
-        struct fs_dirent entry;
-        fs_dir_t_init(&dir);
-
-        if (fs_opendir(&dir, CONFIG_RPR_AUDIO_DEFAULT_PATH) != 0) {
-            LOG_ERR("Failed to open directory");
-            return;
-        }
-
-        int  index      = 1;
         bool file_found = false;
         char full_path[FULL_AUDIO_PATH_MAX_LEN];
 
-        while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != 0) {
-            if (entry.type == FS_DIR_ENTRY_FILE) {
-                if (index == target_index) {
-                    snprintf(full_path,
-                             sizeof(full_path),
-                             "%s/%s",
-                             CONFIG_RPR_AUDIO_DEFAULT_PATH,
-                             entry.name);
-                    file_found = true;
-                    break;
+#ifdef CONFIG_RPR_AUDIO_HEAD_CACHE
+        // The head cache lists the clips, the flash is not touched
+        file_found = (audio_head_cache_get_path(
+                              target_index, full_path, sizeof(full_path)) == 0);
+#endif
+
+        if (!file_found) {
+            struct fs_dir_t  dir;
+            struct fs_dirent entry;
+            fs_dir_t_init(&dir);
+
+            if (fs_opendir(&dir, CONFIG_RPR_AUDIO_DEFAULT_PATH) != 0) {
+                LOG_ERR("Failed to open directory");
+                return;
+            }
+
+            int index = 1;
+
+            while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != 0) {
+                if (entry.type == FS_DIR_ENTRY_FILE) {
+                    if (index == target_index) {
+                        snprintf(full_path,
+                                 sizeof(full_path),
+                                 "%s/%s",
+                                 CONFIG_RPR_AUDIO_DEFAULT_PATH,
+                                 entry.name);
+                        file_found = true;
+                        break;
+                    }
+                    index++;
                 }
-                index++;
             }
-        }
 
-        fs_closedir(&dir);
+            fs_closedir(&dir);
+        }
 
         if (!file_found) {
             LOG_ERR("File with index %d not found", target_index);
@@ -285,6 +303,12 @@ static void net_mgmt_event_handler(struct net_mgmt_event_callback *cb,
         LOG_INF("Network connected");
         net_ctx.connected = true;
         led_on(NET_LINK_LED);
+#ifdef CONFIG_RPR_HTTP_POOL
+        alnicko_server_prewarm();
+#endif
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+        http_outbox_set_online(true);
+#endif
         k_sem_give(&net_ctx.net_app_sem);
         return;
     }
@@ -298,6 +322,12 @@ static void net_mgmt_event_handler(struct net_mgmt_event_callback *cb,
             net_ctx.connected = false;
             net_ctx.status    = NET_CONNECT_NO_INTERFACE;
         }
+#ifdef CONFIG_RPR_HTTP_POOL
+        http_pool_flush();
+#endif
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+        http_outbox_set_online(false);
+#endif
         k_sem_reset(&net_ctx.net_app_sem);
         return;
     }
@@ -372,7 +402,13 @@ static void domain_logic_deinit(void)
             t.tm_hour,
             t.tm_min);
 
-    if (net_ctx.connected) {
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+    bool report = true; // Queued, sent after the next start if offline
+#else
+    bool report = net_ctx.connected;
+#endif
+
+    if (report) {
 #ifdef CONFIG_RPR_MODULE_HTTP
 
         const char *dev_name = dev_info_get_board_name_str();
@@ -395,7 +431,11 @@ static void domain_logic_deinit(void)
                  dev_id,
                  dev_name);
 
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+        alnicko_server_queue_message(msg);
+#else
         alnicko_server_post_message(msg);
+#endif
     }
 #endif
 
@@ -645,79 +685,73 @@ void network_attempt_connect(void)
 
 #ifdef CONFIG_RPR_MODULE_HTTP
 /**
- * @brief Demonstration example of network application logic.
+ * @brief Builds the message announcing the device to the server.
  *
- * This function showcases how to use HTTP-based server communication in Zephyr.
- * It demonstrates time synchronization with a remote server, device information reporting,
- * and conditional downloading of an audio file if it is not present in the filesystem.
+ * @param msg  Buffer to store the message.
+ * @param size Size of the buffer.
+ *
+ * @return true on success, false if a device information is missing.
  */
-void net_application_start(void)
+static bool net_app_connect_message(char *msg, size_t size)
 {
-    if (k_sem_take(&net_ctx.net_app_sem, K_NO_WAIT) != 0) {
-        return;
-    }
-
-    LOG_INF("Updating time from server...");
-
-    server_status_t ret = alnicko_server_update_time();
-    if (ret != SERVER_OK) {
-        LOG_ERR("Failed to update time. Error code: %d", ret);
-        return;
-    }
-
-    LOG_INF("Time successfully updated from server.");
-
     size_t      len    = 0;
     const char *fw_ver = dev_info_get_fw_version_str(&len);
     if (len == 0 || fw_ver == NULL) {
         LOG_ERR("Failed to retrieve firmware version.");
-        return;
+        return false;
     }
 
     len                = 0;
     const char *hw_rev = dev_info_get_hw_revision_str(&len);
     if (len == 0 || hw_rev == NULL) {
         LOG_ERR("Failed to retrieve hardware version.");
-        return;
+        return false;
     }
 
     const char *dev_name = dev_info_get_board_name_str();
     if (!dev_name) {
         LOG_ERR("Failed to retrieve board name.");
-        return;
+        return false;
     }
 
     len                = 0;
     const char *dev_id = dev_info_get_device_id_str(&len);
     if (len == 0 || dev_id == NULL) {
         LOG_ERR("Failed to retrieve device ID.");
-        return;
+        return false;
     }
 
-    k_msleep(NET_APP_DELAY_MS);
-
-    char msg[MSG_BUF_SIZE];
     snprintf(
             msg,
-            sizeof(msg),
+            size,
             "Device %s (%s) connected to network. HW version: %s, FW version: %s",
             dev_id,
             dev_name,
             hw_rev,
             fw_ver);
-
-    alnicko_server_post_message(msg);
+    return true;
+}
 
 #ifdef CONFIG_EXAMPLES_DOMAIN_LOGIC_AUTO_DOWNLOAD_AUDIO
+/**
+ * @brief Checks whether the target audio file has to be downloaded.
+ *
+ * @return true if the file is missing and may be downloaded now.
+ */
+static bool net_app_audio_missing(void)
+{
     if (!TARGET_AUDIO_FILE || strlen(TARGET_AUDIO_FILE) == 0) {
         LOG_ERR("No target audio file defined.");
-        return;
+        return false;
     }
 
+#ifndef CONFIG_RPR_FLASH_QOS
+    /* Without the flash I/O scheduler the download would starve playback */
     if (get_playing_status()) {
         LOG_WRN("Cannot download audio file while playback is active.");
-        return;
+        return false;
     }
+#endif
 
     char path[FULL_AUDIO_PATH_MAX_LEN];
     snprintf(path,
@@ -731,10 +765,141 @@ void net_application_start(void)
 
     if (fs_res == 0 && file_info.type == FS_DIR_ENTRY_FILE) {
         LOG_INF("Audio file '%s' found at %s", TARGET_AUDIO_FILE, path);
+        return false;
+    }
+
+    LOG_INF("Audio file not found, downloading...");
+    return true;
+}
+#endif
+
+#ifdef CONFIG_RPR_HTTP_ASYNC
+#ifdef CONFIG_EXAMPLES_DOMAIN_LOGIC_AUTO_DOWNLOAD_AUDIO
+/**
+ * @brief Reports the end of the target audio file download.
+ *
+ * @param status    Result of the download.
+ * @param user_data Unused.
+ */
+static void net_app_audio_done(server_status_t status, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    if (status != SERVER_OK) {
+        LOG_ERR("Failed to download audio '%s'. Error code: %d",
+                TARGET_AUDIO_FILE,
+                status);
     } else {
-        k_msleep(NET_APP_DELAY_MS);
+        LOG_INF("Audio file '%s' successfully downloaded.", TARGET_AUDIO_FILE);
+    }
+}
+#endif
+
+/**
+ * @brief Continues the network application once the time is updated.
+ *
+ * Runs in an HTTP worker thread; it only queues the next requests.
+ *
+ * @param status    Result of the time update.
+ * @param user_data Unused.
+ */
+static void net_app_time_done(server_status_t status, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    if (status != SERVER_OK) {
+        LOG_ERR("Failed to update time. Error code: %d", status);
+        return;
+    }
+
+    LOG_INF("Time successfully updated from server.");
+
+    char msg[MSG_BUF_SIZE];
+    if (!net_app_connect_message(msg, sizeof(msg))) {
+        return;
+    }
+
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+    alnicko_server_queue_message(msg);
+#else
+    alnicko_server_post_message_async(msg, NULL, NULL);
+#endif
+
+#ifdef CONFIG_EXAMPLES_DOMAIN_LOGIC_AUTO_DOWNLOAD_AUDIO
+    if (net_app_audio_missing()) {
+        server_status_t ret = alnicko_server_get_audio_by_name_async(
+                TARGET_AUDIO_FILE, net_app_audio_done, NULL);
+        if (ret != SERVER_OK) {
+            net_app_audio_done(ret, NULL);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Demonstration example of network application logic.
+ *
+ * This function showcases how to use HTTP-based server communication in Zephyr.
+ * It demonstrates time synchronization with a remote server, device information reporting,
+ * and conditional downloading of an audio file if it is not present in the filesystem.
+ *
+ * The requests are queued and run by the HTTP workers, the caller does not
+ * wait for the network.
+ */
+void net_application_start(void)
+{
+    if (k_sem_take(&net_ctx.net_app_sem, K_NO_WAIT) != 0) {
+        return;
+    }
+
+    LOG_INF("Updating time from server...");
+
+    server_status_t ret =
+            alnicko_server_update_time_async(net_app_time_done, NULL);
+    if (ret != SERVER_OK) {
+        LOG_ERR("Failed to update time. Error code: %d", ret);
+    }
+}
+#else
+/**
+ * @brief Demonstration example of network application logic.
+ *
+ * This function showcases how to use HTTP-based server communication in Zephyr.
+ * It demonstrates time synchronization with a remote server, device information reporting,
+ * and conditional downloading of an audio file if it is not present in the filesystem.
+ */
+void net_application_start(void)
+{
+    if (k_sem_take(&net_ctx.net_app_sem, K_NO_WAIT) != 0) {
+        return;
+    }
+
+    LOG_INF("Updating time from server...");
+
+    server_status_t ret = alnicko_server_update_time();
+    if (ret != SERVER_OK) {
+        LOG_ERR("Failed to update time. Error code: %d", ret);
+        return;
+    }
 
-        LOG_INF("Audio file not found, downloading...");
+    LOG_INF("Time successfully updated from server.");
+
+    char msg[MSG_BUF_SIZE];
+    if (!net_app_connect_message(msg, sizeof(msg))) {
+        return;
+    }
+
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+    alnicko_server_queue_message(msg);
+#else
+    k_msleep(NET_APP_DELAY_MS);
+
+    alnicko_server_post_message(msg);
+#endif
+
+#ifdef CONFIG_EXAMPLES_DOMAIN_LOGIC_AUTO_DOWNLOAD_AUDIO
+    if (net_app_audio_missing()) {
+        k_msleep(NET_APP_DELAY_MS);
 
         ret = alnicko_server_get_audio_by_name(TARGET_AUDIO_FILE);
         if (ret != SERVER_OK) {
@@ -748,6 +913,7 @@ void net_application_start(void)
     }
 #endif
 }
+#endif // CONFIG_RPR_HTTP_ASYNC
 #endif
 
 #ifdef CONFIG_RPR_MODULE_DFU
@@ -838,6 +1004,18 @@ void domain_logic_func(void)
     supervisor_ping_register_callback(domain_logic_ping);
     supervisor_poweroff_register_callback(domain_logic_deinit);
 
+#ifdef CONFIG_RPR_HTTP_OUTBOX
+    // Deliver the messages queued before the last power down
+    if (alnicko_server_outbox_start() != SERVER_OK) {
+        LOG_ERR("Message queue is not available");
+    }
+#endif
+
+#ifdef CONFIG_RPR_HTTP_SYNC
+    // Finish an audio library commit cut by the last power down
+    http_sync_recover();
+#endif
+
     // Setup network event handling
     net_mgmt_init_event_callback(
             &net_ctx.mgmt_cb, net_mgmt_event_handler, EVENT_MASK);
@@ -0,0 +1,375 @@
+/**
+ * @file flash_qos.c
+ * @brief Flash I/O scheduler for playback reads and background writes.
+ *
+ * LittleFS serializes all operations on the mount, so a playback read that
+ * arrives while a download programs a page or erases a block waits for it.
+ * The scheduler bounds that wait and keeps it away from the reads:
+ *  - writes are issued in chunks of at most one flash block, so a read is
+ *    never queued behind more than one erase;
+ *  - the interval between playback reads is learned, and a chunk that would
+ *    start within the guard time before the next read is held until that
+ *    read is done (bounded, so the download never stalls);
+ *  - while playback runs, writes are paced by a byte budget.
+ *
+ * Read latency goes into log-linear histograms (four steps per octave),
+ * one for reads with no background write active and one under load.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+
+#include "flash_qos.h"
+
+LOG_MODULE_REGISTER(flash_qos, CONFIG_RPR_FILE_MANAGER_LOG_LEVEL);
+
+#define QOS_WRITE_CHUNK  CONFIG_RPR_FLASH_QOS_WRITE_CHUNK
+#define QOS_RATE_BPS     (CONFIG_RPR_FLASH_QOS_WRITE_RATE_KBPS * 1024U)
+#define QOS_GUARD_MS     CONFIG_RPR_FLASH_QOS_READ_GUARD_MS
+#define QOS_MAX_DEFER_MS CONFIG_RPR_FLASH_QOS_MAX_DEFER_MS
+#define QOS_IDLE_MS      CONFIG_RPR_FLASH_QOS_IDLE_MS
+
+/* Values below 4 us get their own bucket, then four buckets per octave */
+#define QOS_HIST_SUB_BITS 2
+#define QOS_HIST_SUB      (1U << QOS_HIST_SUB_BITS)
+#define QOS_HIST_BUCKETS  88
+
+struct flash_qos_hist {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t bucket[QOS_HIST_BUCKETS];
+};
+
+struct flash_qos_state {
+    struct k_mutex   lock;
+    struct k_condvar read_done;
+
+    uint32_t readers;        /* Reads in flight */
+    uint32_t writers;        /* Write calls in progress */
+    uint32_t read_seq;       /* Completed reads */
+    int64_t  last_read_ms;   /* End of the last read, 0 if none */
+    int64_t  last_write_ms;  /* End of the last write, 0 if none */
+    uint32_t read_period_ms; /* Smoothed interval between reads */
+    uint32_t budget;         /* Bytes writable without waiting */
+    int64_t  budget_ms;      /* Uptime the budget was last refilled */
+
+    struct flash_qos_hist read_idle;
+    struct flash_qos_hist read_loaded;
+
+    struct flash_qos_stats stats;
+};
+
+static struct flash_qos_state qos = {
+    .lock      = Z_MUTEX_INITIALIZER(qos.lock),
+    .read_done = Z_CONDVAR_INITIALIZER(qos.read_done),
+    .budget    = QOS_WRITE_CHUNK,
+};
+
+/**
+ * @brief Maps a latency to its histogram bucket.
+ *
+ * @param us Latency in microseconds.
+ *
+ * @return Bucket index.
+ */
+static uint32_t flash_qos_bucket(uint32_t us)
+{
+    if (us < QOS_HIST_SUB) {
+        return us;
+    }
+
+    uint32_t msb = find_msb_set(us) - 1;
+    uint32_t sub = (us >> (msb - QOS_HIST_SUB_BITS)) & (QOS_HIST_SUB - 1);
+    uint32_t idx = QOS_HIST_SUB + (msb - QOS_HIST_SUB_BITS) * QOS_HIST_SUB +
+                   sub;
+
+    return MIN(idx, QOS_HIST_BUCKETS - 1);
+}
+
+/**
+ * @brief Gets the largest latency that falls into a histogram bucket.
+ *
+ * @param idx Bucket index.
+ *
+ * @return Upper bound of the bucket in microseconds.
+ */
+static uint32_t flash_qos_bucket_max(uint32_t idx)
+{
+    if (idx < QOS_HIST_SUB) {
+        return idx;
+    }
+
+    uint32_t octave = (idx - QOS_HIST_SUB) / QOS_HIST_SUB;
+    uint32_t sub    = (idx - QOS_HIST_SUB) % QOS_HIST_SUB;
+
+    return ((QOS_HIST_SUB + sub + 1) << octave) - 1;
+}
+
+/**
+ * @brief Computes the percentiles of a latency histogram.
+ *
+ * Percentiles are reported as the upper bound of their bucket, which
+ * overstates them by less than a quarter.
+ *
+ * @param hist Histogram to read.
+ * @param out  Pointer to store the percentiles.
+ */
+static void flash_qos_percentiles(const struct flash_qos_hist *hist,
+                                  struct flash_qos_latency    *out)
+{
+    static const uint8_t percents[] = { 50, 90, 99 };
+    uint32_t            *results[]  = { &out->p50_us,
+                                        &out->p90_us,
+                                        &out->p99_us };
+
+    memset(out, 0, sizeof(*out));
+    out->count  = hist->count;
+    out->max_us = hist->max_us;
+
+    if (hist->count == 0) {
+        return;
+    }
+
+    uint32_t idx  = 0;
+    uint32_t seen = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(percents); i++) {
+        uint32_t rank =
+                DIV_ROUND_UP((uint64_t)hist->count * percents[i], 100U);
+
+        while (idx < QOS_HIST_BUCKETS && seen + hist->bucket[idx] < rank) {
+            seen += hist->bucket[idx];
+            idx++;
+        }
+
+        *results[i] = MIN(flash_qos_bucket_max(idx), hist->max_us);
+    }
+}
+
+/**
+ * @brief Checks whether an activity happened within the idle window.
+ *
+ * @param last_ms Uptime of the last activity, 0 if none.
+ * @param now     Current uptime in milliseconds.
+ *
+ * @return true if the activity is still considered ongoing.
+ */
+static bool flash_qos_recent(int64_t last_ms, int64_t now)
+{
+    return last_ms != 0 && now - last_ms < QOS_IDLE_MS;
+}
+
+ssize_t flash_qos_read(struct fs_file_t *file, void *buf, size_t len)
+{
+    k_mutex_lock(&qos.lock, K_FOREVER);
+    qos.readers++;
+    bool loaded = qos.writers > 0 ||
+                  flash_qos_recent(qos.last_write_ms, k_uptime_get());
+    k_mutex_unlock(&qos.lock);
+
+    int64_t start = k_uptime_ticks();
+    ssize_t ret   = fs_read(file, buf, len);
+    int64_t ticks = k_uptime_ticks() - start;
+    int64_t now   = k_uptime_get();
+
+    uint32_t us = (uint32_t)MIN(k_ticks_to_us_ceil64(ticks), UINT32_MAX);
+
+    k_mutex_lock(&qos.lock, K_FOREVER);
+    qos.readers--;
+    qos.read_seq++;
+
+    if (flash_qos_recent(qos.last_read_ms, now)) {
+        uint32_t interval = (uint32_t)(now - qos.last_read_ms);
+
+        qos.read_period_ms = qos.read_period_ms == 0 ?
+                                     interval :
+                                     (qos.read_period_ms * 7 + interval) / 8;
+    } else {
+        qos.read_period_ms = 0;
+    }
+    qos.last_read_ms = now;
+
+    loaded = loaded || qos.writers > 0;
+
+    struct flash_qos_hist *hist = loaded ? &qos.read_loaded : &qos.read_idle;
+
+    hist->count++;
+    hist->max_us = MAX(hist->max_us, us);
+    hist->bucket[flash_qos_bucket(us)]++;
+
+    if (ret > 0) {
+        qos.stats.read_bytes += ret;
+    }
+
+    k_condvar_broadcast(&qos.read_done);
+    k_mutex_unlock(&qos.lock);
+
+    return ret;
+}
+
+/**
+ * @brief Holds a write chunk back while a playback read is due.
+ *
+ * Must be called with the lock held. A read in flight is always waited
+ * for. Otherwise the chunk waits if the next read, predicted from the
+ * learned read period, falls within the guard time.
+ */
+static void flash_qos_wait_for_reads(void)
+{
+    int64_t  start    = k_uptime_get();
+    uint32_t seq      = qos.read_seq;
+    bool     deferred = false;
+
+    while (true) {
+        int64_t now = k_uptime_get();
+
+        if (now - start >= QOS_MAX_DEFER_MS) {
+            break;
+        }
+
+        bool due = qos.readers > 0;
+
+        if (!due && qos.read_seq == seq && qos.read_period_ms > 0 &&
+            flash_qos_recent(qos.last_read_ms, now)) {
+            int64_t next = qos.last_read_ms + qos.read_period_ms;
+
+            due = now + QOS_GUARD_MS >= next && now < next + QOS_GUARD_MS;
+        }
+
+        if (!due) {
+            break;
+        }
+
+        deferred = true;
+        k_condvar_wait(&qos.read_done,
+                       &qos.lock,
+                       K_MSEC(QOS_MAX_DEFER_MS - (now - start)));
+    }
+
+    if (deferred) {
+        qos.stats.deferred++;
+        qos.stats.defer_ms += (uint32_t)(k_uptime_get() - start);
+    }
+}
+
+/**
+ * @brief Takes write budget for a chunk, waiting for it while playback runs.
+ *
+ * Must be called with the lock held, it is released while waiting.
+ *
+ * @param len Chunk size in bytes.
+ */
+static void flash_qos_take_budget(size_t len)
+{
+    int64_t now = k_uptime_get();
+
+    if (!flash_qos_recent(qos.last_read_ms, now)) {
+        /* No playback, writes run at full speed */
+        qos.budget    = QOS_WRITE_CHUNK;
+        qos.budget_ms = now;
+        return;
+    }
+
+    uint64_t refill = (uint64_t)(now - qos.budget_ms) * QOS_RATE_BPS /
+                      MSEC_PER_SEC;
+
+    qos.budget    = (uint32_t)MIN(qos.budget + refill, QOS_WRITE_CHUNK);
+    qos.budget_ms = now;
+
+    if (qos.budget < len) {
+        uint32_t wait_ms = DIV_ROUND_UP((len - qos.budget) * MSEC_PER_SEC,
+                                        QOS_RATE_BPS);
+
+        k_mutex_unlock(&qos.lock);
+        k_msleep(wait_ms);
+        k_mutex_lock(&qos.lock, K_FOREVER);
+
+        qos.stats.throttle_ms += wait_ms;
+        qos.budget             = len;
+        qos.budget_ms          = k_uptime_get();
+    }
+
+    qos.budget -= len;
+}
+
+ssize_t flash_qos_write(struct fs_file_t *file, const void *buf, size_t len)
+{
+    const uint8_t *data    = buf;
+    size_t         written = 0;
+    ssize_t        ret     = 0;
+
+    k_mutex_lock(&qos.lock, K_FOREVER);
+    qos.writers++;
+
+    while (written < len) {
+        size_t chunk = MIN(len - written, QOS_WRITE_CHUNK);
+
+        flash_qos_take_budget(chunk);
+        flash_qos_wait_for_reads();
+        k_mutex_unlock(&qos.lock);
+
+        int64_t start = k_uptime_ticks();
+        ret           = fs_write(file, data + written, chunk);
+        int64_t ticks = k_uptime_ticks() - start;
+
+        k_mutex_lock(&qos.lock, K_FOREVER);
+        qos.last_write_ms = k_uptime_get();
+
+        if (ret < 0) {
+            break;
+        }
+
+        uint32_t us = (uint32_t)MIN(k_ticks_to_us_ceil64(ticks), UINT32_MAX);
+
+        qos.stats.write_chunks++;
+        qos.stats.write_bytes += ret;
+        qos.stats.write_max_us = MAX(qos.stats.write_max_us, us);
+        written += ret;
+
+        if ((size_t)ret < chunk) {
+            /* Filesystem full */
+            break;
+        }
+    }
+
+    qos.writers--;
+    k_mutex_unlock(&qos.lock);
+
+    if (ret < 0) {
+        LOG_ERR("Background write failed: %d", (int)ret);
+        return ret;
+    }
+
+    return written;
+}
+
+void flash_qos_get_stats(struct flash_qos_stats *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    k_mutex_lock(&qos.lock, K_FOREVER);
+    *stats = qos.stats;
+    flash_qos_percentiles(&qos.read_idle, &stats->read_idle);
+    flash_qos_percentiles(&qos.read_loaded, &stats->read_loaded);
+    stats->read_period_ms =
+            flash_qos_recent(qos.last_read_ms, k_uptime_get()) ?
+                    qos.read_period_ms :
+                    0;
+    k_mutex_unlock(&qos.lock);
+}
+
+void flash_qos_reset_stats(void)
+{
+    k_mutex_lock(&qos.lock, K_FOREVER);
+    memset(&qos.stats, 0, sizeof(qos.stats));
+    memset(&qos.read_idle, 0, sizeof(qos.read_idle));
+    memset(&qos.read_loaded, 0, sizeof(qos.read_loaded));
+    k_mutex_unlock(&qos.lock);
+}
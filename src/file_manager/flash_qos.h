@@ -0,0 +1,81 @@
+/**
+ * @file flash_qos.h
+ * @brief Flash I/O scheduler for playback reads and background writes.
+ *
+ * Playback and downloads share one SPI-NOR LittleFS. Playback reads go
+ * through flash_qos_read() and always take precedence: background writes
+ * issued with flash_qos_write() are cut into chunks, held back while a read
+ * is in flight or about to be due, and rate limited while playback runs.
+ * Read latency is kept in histograms, split by whether a background write
+ * was active, so its percentiles can be compared under load.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef FLASH_QOS_H_
+#define FLASH_QOS_H_
+
+#include <zephyr/fs/fs.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+struct flash_qos_latency {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+struct flash_qos_stats {
+    struct flash_qos_latency read_idle;      /* No background write active */
+    struct flash_qos_latency read_loaded;    /* During background writes */
+    uint32_t                 read_bytes;
+    uint32_t                 read_period_ms; /* Learned playback read period */
+    uint32_t                 write_chunks;
+    uint32_t                 write_bytes;
+    uint32_t                 write_max_us;   /* Longest chunk, erase included */
+    uint32_t                 deferred;       /* Chunks held for a due read */
+    uint32_t                 defer_ms;
+    uint32_t                 throttle_ms;    /* Waiting for the rate budget */
+};
+
+/**
+ * @brief Reads from a file with playback priority.
+ *
+ * @param file File opened with fs_open().
+ * @param buf  Destination buffer.
+ * @param len  Number of bytes to read.
+ *
+ * @return Number of bytes read, negative error code otherwise.
+ */
+ssize_t flash_qos_read(struct fs_file_t *file, void *buf, size_t len);
+
+/**
+ * @brief Writes to a file as background traffic.
+ *
+ * Blocks while the scheduler holds the write back, so the caller is slowed
+ * down to what playback leaves of the flash.
+ *
+ * @param file File opened with fs_open().
+ * @param buf  Data to write.
+ * @param len  Number of bytes to write.
+ *
+ * @return Number of bytes written, negative error code otherwise.
+ */
+ssize_t flash_qos_write(struct fs_file_t *file, const void *buf, size_t len);
+
+/**
+ * @brief Gets the scheduler statistics and read latency percentiles.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void flash_qos_get_stats(struct flash_qos_stats *stats);
+
+/**
+ * @brief Clears the statistics and the latency histograms.
+ */
+void flash_qos_reset_stats(void);
+
+#endif /* FLASH_QOS_H_ */
@@ -0,0 +1,266 @@
+/**
+ * @file write_behind.c
+ * @brief Write-behind queue for download data.
+ *
+ * Buffers of one LittleFS block come from a memory slab. A stream fills one
+ * buffer at a time; the first buffer after open only takes the data up to
+ * the next block boundary of the file, so every later buffer covers exactly
+ * one block of the file. Full buffers go through a FIFO to the writer
+ * thread, which writes them in order, through the flash I/O scheduler when
+ * that is enabled, and returns them to the slab.
+ *
+ * A stream counts the buffers it queued and the writer gives the stream
+ * semaphore once per buffer, so a flush waits for exactly its own data.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <string.h>
+
+#include "write_behind.h"
+
+#ifdef CONFIG_RPR_FLASH_QOS
+#include "flash_qos.h"
+#endif
+
+LOG_MODULE_REGISTER(write_behind, CONFIG_RPR_FILE_MANAGER_LOG_LEVEL);
+
+#define WB_BLOCK_SIZE  CONFIG_RPR_WRITE_BEHIND_BLOCK_SIZE
+#define WB_BLOCKS      CONFIG_RPR_WRITE_BEHIND_BLOCKS
+#define WB_STALL_LIMIT K_MSEC(CONFIG_RPR_WRITE_BEHIND_STALL_TIMEOUT_MS)
+
+struct write_behind_block {
+    void                     *fifo_reserved; /* Used by the FIFO */
+    struct write_behind_file *owner;
+    size_t                    len;
+    size_t                    capacity; /* Bytes up to the block boundary */
+    uint8_t                   data[WB_BLOCK_SIZE];
+};
+
+K_MEM_SLAB_DEFINE_STATIC(wb_slab,
+                         sizeof(struct write_behind_block),
+                         WB_BLOCKS,
+                         4);
+K_FIFO_DEFINE(wb_queue);
+K_MUTEX_DEFINE(wb_stats_lock);
+
+static struct write_behind_stats wb_stats;
+static bool                      wb_bypass;
+
+/**
+ * @brief Writes data to a file, through the flash I/O scheduler if enabled.
+ *
+ * @param file File to write to.
+ * @param buf  Data to write.
+ * @param len  Number of bytes to write.
+ *
+ * @return Number of bytes written, negative error code otherwise.
+ */
+static ssize_t
+write_behind_fs_write(struct fs_file_t *file, const void *buf, size_t len)
+{
+#ifdef CONFIG_RPR_FLASH_QOS
+    return flash_qos_write(file, buf, len);
+#else
+    return fs_write(file, buf, len);
+#endif
+}
+
+/**
+ * @brief Hands the buffer being filled to the writer thread.
+ *
+ * @param wb Stream of the file.
+ */
+static void write_behind_queue(struct write_behind_file *wb)
+{
+    wb->queued++;
+    k_fifo_put(&wb_queue, wb->block);
+    wb->block = NULL;
+}
+
+int write_behind_open(struct write_behind_file *wb,
+                      struct fs_file_t         *file,
+                      off_t                     offset)
+{
+    if (!wb || !file || offset < 0) {
+        return -EINVAL;
+    }
+
+    wb->file   = file;
+    wb->block  = NULL;
+    wb->offset = offset;
+    wb->queued = 0;
+    wb->error  = 0;
+    k_sem_init(&wb->written, 0, K_SEM_MAX_LIMIT);
+
+    return 0;
+}
+
+ssize_t
+write_behind_write(struct write_behind_file *wb, const void *buf, size_t len)
+{
+    if (!wb || (!buf && len)) {
+        return -EINVAL;
+    }
+
+    if (wb->error) {
+        return wb->error;
+    }
+
+    if (wb_bypass) {
+        ssize_t ret = write_behind_fs_write(wb->file, buf, len);
+
+        if (ret > 0) {
+            wb->offset += ret;
+        }
+        k_mutex_lock(&wb_stats_lock, K_FOREVER);
+        wb_stats.direct++;
+        k_mutex_unlock(&wb_stats_lock);
+        return ret;
+    }
+
+    const uint8_t *src  = buf;
+    size_t         left = len;
+
+    while (left) {
+        if (!wb->block) {
+            bool    full  = k_mem_slab_num_free_get(&wb_slab) == 0;
+            int64_t start = k_uptime_get();
+            void   *mem;
+
+            if (k_mem_slab_alloc(&wb_slab, &mem, WB_STALL_LIMIT) != 0) {
+                LOG_ERR("No write buffer freed within %d ms",
+                        CONFIG_RPR_WRITE_BEHIND_STALL_TIMEOUT_MS);
+                wb->error = -ETIMEDOUT;
+                return wb->error;
+            }
+
+            if (full) {
+                k_mutex_lock(&wb_stats_lock, K_FOREVER);
+                wb_stats.stalls++;
+                wb_stats.stall_ms += (uint32_t)(k_uptime_get() - start);
+                k_mutex_unlock(&wb_stats_lock);
+            }
+
+            wb->block           = mem;
+            wb->block->owner    = wb;
+            wb->block->len      = 0;
+            wb->block->capacity = WB_BLOCK_SIZE - wb->offset % WB_BLOCK_SIZE;
+        }
+
+        struct write_behind_block *block = wb->block;
+        size_t n = MIN(left, block->capacity - block->len);
+
+        memcpy(&block->data[block->len], src, n);
+        block->len += n;
+        wb->offset += n;
+        src += n;
+        left -= n;
+
+        if (block->len == block->capacity) {
+            write_behind_queue(wb);
+        }
+    }
+
+    return len;
+}
+
+int write_behind_flush(struct write_behind_file *wb)
+{
+    if (!wb) {
+        return -EINVAL;
+    }
+
+    if (wb->block) {
+        if (wb->block->len) {
+            write_behind_queue(wb);
+        } else {
+            k_mem_slab_free(&wb_slab, wb->block);
+            wb->block = NULL;
+        }
+    }
+
+    for (; wb->queued; wb->queued--) {
+        k_sem_take(&wb->written, K_FOREVER);
+    }
+
+    return wb->error;
+}
+
+void write_behind_set_bypass(bool bypass)
+{
+    wb_bypass = bypass;
+}
+
+void write_behind_get_stats(struct write_behind_stats *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    k_mutex_lock(&wb_stats_lock, K_FOREVER);
+    *stats = wb_stats;
+    k_mutex_unlock(&wb_stats_lock);
+}
+
+void write_behind_reset_stats(void)
+{
+    k_mutex_lock(&wb_stats_lock, K_FOREVER);
+    memset(&wb_stats, 0, sizeof(wb_stats));
+    k_mutex_unlock(&wb_stats_lock);
+}
+
+/**
+ * @brief Writer thread: commits queued buffers in order.
+ *
+ * The stream semaphore is given after the buffer is returned to the slab;
+ * a flushing stream may be gone right after that.
+ */
+static void write_behind_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1) {
+        struct write_behind_block *block = k_fifo_get(&wb_queue, K_FOREVER);
+        struct write_behind_file  *wb    = block->owner;
+
+        int64_t start = k_uptime_ticks();
+        ssize_t ret   = write_behind_fs_write(wb->file, block->data, block->len);
+        int64_t ticks = k_uptime_ticks() - start;
+
+        uint32_t us = (uint32_t)MIN(k_ticks_to_us_ceil64(ticks), UINT32_MAX);
+
+        if (ret != (ssize_t)block->len && !wb->error) {
+            LOG_ERR("Block write failed: %d", (int)ret);
+            wb->error = ret < 0 ? (int)ret : -ENOSPC;
+        }
+
+        k_mutex_lock(&wb_stats_lock, K_FOREVER);
+        wb_stats.blocks++;
+        wb_stats.partial += block->len < block->capacity;
+        wb_stats.bytes += block->len;
+        wb_stats.write_us += us;
+        wb_stats.write_max_us = MAX(wb_stats.write_max_us, us);
+        k_mutex_unlock(&wb_stats_lock);
+
+        k_mem_slab_free(&wb_slab, block);
+        k_sem_give(&wb->written);
+    }
+}
+
+K_THREAD_DEFINE(write_behind_thread_id,
+                CONFIG_RPR_WRITE_BEHIND_THREAD_STACK_SIZE,
+                write_behind_thread,
+                NULL,
+                NULL,
+                NULL,
+                CONFIG_RPR_WRITE_BEHIND_THREAD_PRIORITY,
+                0,
+                0);
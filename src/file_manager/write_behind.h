@@ -0,0 +1,110 @@
+/**
+ * @file write_behind.h
+ * @brief Write-behind queue for download data.
+ *
+ * Downloads receive their body in fragments of the HTTP receive buffer.
+ * Writing each fragment to the SPI-NOR LittleFS holds the receive path for
+ * the program time of the flash. The write-behind queue copies fragments
+ * into buffers of one LittleFS block, aligned to the block boundaries of
+ * the file, and a writer thread commits full buffers while the next ones
+ * are received. When all buffers wait for the flash, the caller blocks,
+ * which closes the TCP window and slows the sender down.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef WRITE_BEHIND_H_
+#define WRITE_BEHIND_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+struct write_behind_block;
+
+/* Write stream of one open file, owned by the writing thread */
+struct write_behind_file {
+    struct fs_file_t          *file;
+    struct write_behind_block *block;   /* Being filled, NULL if none */
+    off_t                      offset;  /* File offset of the next byte */
+    uint32_t                   queued;  /* Blocks handed to the writer */
+    int                        error;   /* First failed write, 0 if none */
+    struct k_sem               written; /* Given per block written */
+};
+
+struct write_behind_stats {
+    uint32_t blocks;       /* Blocks written by the writer thread */
+    uint32_t partial;      /* Of those, written before they were full */
+    uint32_t bytes;
+    uint32_t write_us;     /* Time spent writing, erases included */
+    uint32_t write_max_us; /* Longest block write */
+    uint32_t stalls;       /* Writes that waited for a free buffer */
+    uint32_t stall_ms;     /* Time spent waiting */
+    uint32_t direct;       /* Writes done in the caller while bypassed */
+};
+
+/**
+ * @brief Starts a write stream on an open file.
+ *
+ * @param wb     Stream to initialize.
+ * @param file   File opened for writing, positioned at offset.
+ * @param offset Current position in the file, for block alignment.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int write_behind_open(struct write_behind_file *wb,
+                      struct fs_file_t         *file,
+                      off_t                     offset);
+
+/**
+ * @brief Queues data to be written to the file of a stream.
+ *
+ * The data is copied; the call only blocks while every buffer is waiting
+ * for the writer thread. A write error of an earlier block is returned
+ * here or by write_behind_flush().
+ *
+ * @param wb  Stream of the file.
+ * @param buf Data to write.
+ * @param len Number of bytes to write.
+ *
+ * @return Number of bytes accepted, negative error code otherwise.
+ */
+ssize_t
+write_behind_write(struct write_behind_file *wb, const void *buf, size_t len);
+
+/**
+ * @brief Writes the queued data of a stream and waits until it is written.
+ *
+ * Must be called before the file is read, synced, truncated or closed.
+ *
+ * @param wb Stream of the file.
+ *
+ * @return 0 on success, the first write error of the stream otherwise.
+ */
+int write_behind_flush(struct write_behind_file *wb);
+
+/**
+ * @brief Writes through to the file system in the calling thread.
+ *
+ * Used to compare the download throughput with and without the queue.
+ *
+ * @param bypass true to write directly, false to queue.
+ */
+void write_behind_set_bypass(bool bypass);
+
+/**
+ * @brief Gets the write-behind statistics.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void write_behind_get_stats(struct write_behind_stats *stats);
+
+/**
+ * @brief Clears the write-behind statistics.
+ */
+void write_behind_reset_stats(void);
+
+#endif /* WRITE_BEHIND_H_ */
@@ -0,0 +1,504 @@
+/**
+ * @file http_async.c
+ * @brief Asynchronous request queue on top of the blocking HTTP client.
+ *
+ * The queue is a fixed array of entries guarded by a mutex; a semaphore
+ * counts the queued entries. A worker takes the queued entry with the
+ * highest priority and, among those, the oldest one. Firmware updates
+ * write the single update slot, so only one of them runs at a time.
+ *
+ * An entry keeps a list of waiters. A submission equal to a queued or
+ * running entry adds a waiter to it and raises its priority if needed.
+ * The callbacks run after the entry is freed and outside the lock.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "http_async.h"
+
+LOG_MODULE_DECLARE(http_module, CONFIG_RPR_MODULE_HTTP_LOG_LEVEL);
+
+#define ASYNC_QUEUE_SIZE  CONFIG_RPR_HTTP_ASYNC_QUEUE_SIZE
+#define ASYNC_WORKERS     CONFIG_RPR_HTTP_ASYNC_WORKERS
+#define ASYNC_WAITERS     CONFIG_RPR_HTTP_ASYNC_WAITERS
+#define ASYNC_PAYLOAD_LEN CONFIG_RPR_HTTP_ASYNC_PAYLOAD_MAX_LEN
+#define ASYNC_BUF_SIZE    CONFIG_RPR_HTTP_ASYNC_RESPONSE_BUF_SIZE
+
+#define ASYNC_DIR_MAX_LEN          64
+#define ASYNC_CONTENT_TYPE_MAX_LEN 48
+#define ASYNC_HEADER_MAX_LEN       (ASYNC_CONTENT_TYPE_MAX_LEN + 16)
+
+typedef enum {
+    ASYNC_FREE = 0,
+    ASYNC_QUEUED,
+    ASYNC_RUNNING,
+} async_state_t;
+
+struct async_waiter {
+    http_async_cb_t cb;
+    void           *user_data;
+};
+
+struct async_entry {
+    async_state_t       state;
+    http_async_method_t method;
+    http_async_prio_t   prio;
+    uint32_t            seq;       /* Submission order */
+    int64_t             queued_ms; /* Uptime at submission */
+    char                url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
+    char                base_dir[ASYNC_DIR_MAX_LEN];
+    char                payload[ASYNC_PAYLOAD_LEN];
+    char                content_type[ASYNC_CONTENT_TYPE_MAX_LEN];
+    struct async_waiter waiter[ASYNC_WAITERS];
+    size_t              waiters;
+};
+
+static struct async_entry      async_queue[ASYNC_QUEUE_SIZE];
+static struct http_async_stats async_stats;
+static uint32_t                async_seq;
+static uint32_t                async_deferred; /* Updates set aside */
+
+K_MUTEX_DEFINE(async_lock);
+K_SEM_DEFINE(async_pending, 0, ASYNC_QUEUE_SIZE);
+
+K_THREAD_STACK_ARRAY_DEFINE(async_stacks,
+                            ASYNC_WORKERS,
+                            CONFIG_RPR_HTTP_ASYNC_THREAD_STACK_SIZE);
+static struct k_thread async_threads[ASYNC_WORKERS];
+static char            async_bufs[ASYNC_WORKERS][ASYNC_BUF_SIZE];
+
+/**
+ * @brief Copies a string into a fixed buffer.
+ *
+ * @param dst  Destination buffer.
+ * @param size Size of the destination buffer.
+ * @param src  String to copy, NULL for an empty string.
+ *
+ * @return 0 on success, -EINVAL if the string does not fit.
+ */
+static int async_copy(char *dst, size_t size, const char *src)
+{
+    size_t len = src ? strlen(src) : 0;
+
+    if (len >= size) {
+        return -EINVAL;
+    }
+
+    memcpy(dst, src ? src : "", len);
+    dst[len] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Copies the strings of a request into a free entry.
+ *
+ * @param entry Free entry.
+ * @param req   Submitted request.
+ *
+ * @return 0 on success, -EINVAL if a string does not fit.
+ */
+static int async_fill(struct async_entry              *entry,
+                      const struct http_async_request *req)
+{
+    if (async_copy(entry->url, sizeof(entry->url), req->url) < 0) {
+        return -EINVAL;
+    }
+
+    if (async_copy(entry->base_dir, sizeof(entry->base_dir), req->base_dir) <
+        0) {
+        return -EINVAL;
+    }
+
+    if (async_copy(entry->payload, sizeof(entry->payload), req->payload) < 0) {
+        return -EINVAL;
+    }
+
+    return async_copy(entry->content_type,
+                      sizeof(entry->content_type),
+                      req->content_type);
+}
+
+/**
+ * @brief Checks whether a request may be merged into an entry.
+ *
+ * POST requests have side effects on the server and are never merged.
+ *
+ * @param entry Queued or running entry.
+ * @param req   Submitted request.
+ *
+ * @return true if the request would fetch the same resource to the same
+ *         place.
+ */
+static bool async_same(const struct async_entry        *entry,
+                       const struct http_async_request *req)
+{
+    if (entry->state == ASYNC_FREE || req->method == HTTP_ASYNC_POST ||
+        entry->method != req->method || strcmp(entry->url, req->url) != 0) {
+        return false;
+    }
+
+    if (req->method == HTTP_ASYNC_DOWNLOAD) {
+        return strcmp(entry->base_dir, req->base_dir) == 0;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Checks the fields of a submitted request.
+ *
+ * @param req Submitted request.
+ *
+ * @return 0 if the request is valid, -EINVAL otherwise.
+ */
+static int async_check(const struct http_async_request *req)
+{
+    if (!req || !req->url || req->prio >= HTTP_ASYNC_PRIO_COUNT) {
+        return -EINVAL;
+    }
+
+    switch (req->method) {
+    case HTTP_ASYNC_GET:
+        return 0;
+    case HTTP_ASYNC_POST:
+        return req->payload ? 0 : -EINVAL;
+    case HTTP_ASYNC_DOWNLOAD:
+        return req->base_dir ? 0 : -EINVAL;
+    case HTTP_ASYNC_UPDATE:
+#ifdef CONFIG_RPR_MODULE_DFU
+        return 0;
+#else
+        return -EINVAL;
+#endif
+    default:
+        return -EINVAL;
+    }
+}
+
+/**
+ * @brief Queues a request.
+ *
+ * @param req Request to queue.
+ *
+ * @return 0 if queued, 1 if merged into an identical request, -ENOMEM if
+ *         the queue is full, -EINVAL if the request is invalid or a string
+ *         is too long.
+ */
+int http_async_submit(const struct http_async_request *req)
+{
+    struct async_entry *entry = NULL;
+    int                 ret   = async_check(req);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    k_mutex_lock(&async_lock, K_FOREVER);
+
+    for (size_t i = 0; i < ASYNC_QUEUE_SIZE; i++) {
+        if (async_same(&async_queue[i], req) &&
+            async_queue[i].waiters < ASYNC_WAITERS) {
+            entry = &async_queue[i];
+            break;
+        }
+    }
+
+    if (entry) {
+        entry->waiter[entry->waiters].cb        = req->cb;
+        entry->waiter[entry->waiters].user_data = req->user_data;
+        entry->waiters++;
+        entry->prio = MIN(entry->prio, req->prio);
+
+        async_stats.submitted++;
+        async_stats.coalesced++;
+        k_mutex_unlock(&async_lock);
+
+        LOG_DBG("Request for %s joined a pending one", req->url);
+        return 1;
+    }
+
+    for (size_t i = 0; i < ASYNC_QUEUE_SIZE; i++) {
+        if (async_queue[i].state == ASYNC_FREE) {
+            entry = &async_queue[i];
+            break;
+        }
+    }
+
+    if (!entry) {
+        async_stats.rejected++;
+        k_mutex_unlock(&async_lock);
+
+        LOG_WRN("Request queue full, %s refused", req->url);
+        return -ENOMEM;
+    }
+
+    if (async_fill(entry, req) < 0) {
+        k_mutex_unlock(&async_lock);
+        return -EINVAL;
+    }
+
+    entry->state               = ASYNC_QUEUED;
+    entry->method              = req->method;
+    entry->prio                = req->prio;
+    entry->seq                 = async_seq++;
+    entry->queued_ms           = k_uptime_get();
+    entry->waiter[0].cb        = req->cb;
+    entry->waiter[0].user_data = req->user_data;
+    entry->waiters             = 1;
+
+    async_stats.submitted++;
+    async_stats.queued++;
+    k_mutex_unlock(&async_lock);
+
+    k_sem_give(&async_pending);
+    return 0;
+}
+
+/**
+ * @brief Takes the next queued entry and marks it running.
+ *
+ * Must be called with the queue lock held. An update is skipped while
+ * another one runs; it stays queued and its count of the pending semaphore
+ * is given back once that one is done.
+ *
+ * @return Entry to run, NULL if none may run now.
+ */
+static struct async_entry *async_take(void)
+{
+    struct async_entry *next   = NULL;
+    bool                update = false;
+
+    for (size_t i = 0; i < ASYNC_QUEUE_SIZE; i++) {
+        if (async_queue[i].state == ASYNC_RUNNING &&
+            async_queue[i].method == HTTP_ASYNC_UPDATE) {
+            update = true;
+        }
+    }
+
+    for (size_t i = 0; i < ASYNC_QUEUE_SIZE; i++) {
+        struct async_entry *entry = &async_queue[i];
+
+        if (entry->state != ASYNC_QUEUED ||
+            (update && entry->method == HTTP_ASYNC_UPDATE)) {
+            continue;
+        }
+
+        if (!next || entry->prio < next->prio ||
+            (entry->prio == next->prio &&
+             (int32_t)(entry->seq - next->seq) < 0)) {
+            next = entry;
+        }
+    }
+
+    if (next) {
+        uint32_t wait_ms = (uint32_t)(k_uptime_get() - next->queued_ms);
+
+        next->state = ASYNC_RUNNING;
+        async_stats.queued--;
+        async_stats.running++;
+        async_stats.max_wait_ms = MAX(async_stats.max_wait_ms, wait_ms);
+    }
+
+    return next;
+}
+
+/**
+ * @brief Runs a request with the blocking HTTP client.
+ *
+ * @param entry  Running entry. Its fields are not changed by other threads
+ *               while it runs, except the waiters and the priority.
+ * @param buf    Response buffer of the worker.
+ * @param result Pointer to store the result.
+ */
+static void async_run(const struct async_entry  *entry,
+                      char                      *buf,
+                      struct http_async_result *result)
+{
+    struct get_context response = {
+        .response_buffer = buf,
+        .buffer_capacity = ASYNC_BUF_SIZE - 1, /* Room for the NUL */
+        .response_len    = 0,
+    };
+
+    buf[0] = '\0';
+
+    switch (entry->method) {
+    case HTTP_ASYNC_GET:
+        result->status = http_get_request(
+                entry->url, &response, &result->http_status_code);
+        break;
+
+    case HTTP_ASYNC_POST: {
+        char        header[ASYNC_HEADER_MAX_LEN];
+        const char *headers[] = { header, NULL };
+
+        snprintf(header,
+                 sizeof(header),
+                 "Content-Type: %s\r\n",
+                 entry->content_type);
+
+        struct post_context post_ctx = {
+            .response    = response,
+            .payload     = entry->payload,
+            .payload_len = strlen(entry->payload),
+            .headers     = entry->content_type[0] ? headers : NULL,
+        };
+
+        result->status = http_post_request(
+                entry->url, &post_ctx, &result->http_status_code);
+        response = post_ctx.response;
+        break;
+    }
+
+    case HTTP_ASYNC_DOWNLOAD:
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+        result->status =
+                http_download_file_segmented(entry->url,
+                                             entry->base_dir,
+                                             &result->http_status_code,
+                                             CONFIG_RPR_HTTP_SEGMENTS);
+#else
+        result->status = http_download_file_request(
+                entry->url, entry->base_dir, &result->http_status_code);
+#endif
+        break;
+
+#ifdef CONFIG_RPR_MODULE_DFU
+    case HTTP_ASYNC_UPDATE:
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+        result->status =
+                http_download_update_segmented(entry->url,
+                                               &result->http_status_code,
+                                               CONFIG_RPR_HTTP_SEGMENTS);
+#else
+        result->status = http_download_update_request(
+                entry->url, &result->http_status_code);
+#endif
+        break;
+#endif // CONFIG_RPR_MODULE_DFU
+
+    default:
+        result->status = HTTP_ERR_INVALID_PARAM;
+        break;
+    }
+
+    if (entry->method == HTTP_ASYNC_GET || entry->method == HTTP_ASYNC_POST) {
+        /* The worker buffer is reused, callbacks read the body as a string */
+        buf[response.response_len] = '\0';
+        result->body               = buf;
+        result->body_len           = response.response_len;
+    }
+}
+
+/**
+ * @brief Worker thread, runs the queued requests one after another.
+ *
+ * @param p1 Index of the worker.
+ */
+static void async_worker(void *p1, void *p2, void *p3)
+{
+    char *buf = async_bufs[(uintptr_t)p1];
+
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1) {
+        struct async_waiter waiter[ASYNC_WAITERS];
+        struct async_entry *entry;
+        size_t              waiters;
+
+        k_sem_take(&async_pending, K_FOREVER);
+
+        k_mutex_lock(&async_lock, K_FOREVER);
+        entry = async_take();
+        if (!entry) {
+            /* Only updates waiting for the running one are left */
+            async_deferred++;
+        }
+        k_mutex_unlock(&async_lock);
+
+        if (!entry) {
+            continue;
+        }
+
+        struct http_async_result result = { 0 };
+
+        async_run(entry, buf, &result);
+
+        LOG_DBG("Request for %s done: %d, HTTP %u",
+                entry->url,
+                result.status,
+                result.http_status_code);
+
+        k_mutex_lock(&async_lock, K_FOREVER);
+        waiters = entry->waiters;
+        memcpy(waiter, entry->waiter, waiters * sizeof(waiter[0]));
+        entry->state = ASYNC_FREE;
+        async_stats.running--;
+        async_stats.completed++;
+        async_stats.failed += result.status != HTTP_CLIENT_OK;
+        if (entry->method == HTTP_ASYNC_UPDATE) {
+            for (; async_deferred > 0; async_deferred--) {
+                k_sem_give(&async_pending);
+            }
+        }
+        k_mutex_unlock(&async_lock);
+
+        for (size_t i = 0; i < waiters; i++) {
+            if (waiter[i].cb) {
+                waiter[i].cb(&result, waiter[i].user_data);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Gets the statistics of the request queue.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void http_async_get_stats(struct http_async_stats *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    k_mutex_lock(&async_lock, K_FOREVER);
+    *stats = async_stats;
+    k_mutex_unlock(&async_lock);
+}
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @return 0 always.
+ */
+static int http_async_init(void)
+{
+    for (int i = 0; i < ASYNC_WORKERS; i++) {
+        k_thread_create(&async_threads[i],
+                        async_stacks[i],
+                        K_THREAD_STACK_SIZEOF(async_stacks[i]),
+                        async_worker,
+                        (void *)(uintptr_t)i,
+                        NULL,
+                        NULL,
+                        CONFIG_RPR_HTTP_ASYNC_THREAD_PRIORITY,
+                        0,
+                        K_NO_WAIT);
+        k_thread_name_set(&async_threads[i], "http_async");
+    }
+
+    return 0;
+}
+
+SYS_INIT(http_async_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
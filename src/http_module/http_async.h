@@ -0,0 +1,101 @@
+/**
+ * @file http_async.h
+ * @brief Asynchronous request queue on top of the blocking HTTP client.
+ *
+ * Requests are submitted with a completion callback and return at once.
+ * A bounded queue orders them by priority, then by submission, and a pool
+ * of worker threads runs them with the blocking http_module calls; the
+ * receive buffers live on the worker stacks.
+ *
+ * A GET, download or update of a URL that is already queued or running is
+ * not sent again: the submitter is added to that request and its callback
+ * gets the same result. POST requests are never merged.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _HTTP_ASYNC_H_
+#define _HTTP_ASYNC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "http_module.h"
+
+typedef enum {
+    HTTP_ASYNC_GET = 0,
+    HTTP_ASYNC_POST,
+    HTTP_ASYNC_DOWNLOAD, /* File into base_dir */
+    HTTP_ASYNC_UPDATE,   /* Firmware image into the update slot */
+} http_async_method_t;
+
+typedef enum {
+    HTTP_ASYNC_PRIO_HIGH = 0, /* Control and user requests */
+    HTTP_ASYNC_PRIO_NORMAL,
+    HTTP_ASYNC_PRIO_LOW, /* Bulk transfers */
+    HTTP_ASYNC_PRIO_COUNT,
+} http_async_prio_t;
+
+struct http_async_result {
+    http_status_t status;
+    uint16_t      http_status_code;
+    const char   *body;     /* GET and POST response, NUL terminated */
+    size_t        body_len; /* Truncated to the worker response buffer */
+};
+
+/**
+ * @brief Completion callback of an asynchronous request.
+ *
+ * Runs in a worker thread. The body is only valid during the call. The
+ * callback may submit further requests but must not wait for them.
+ *
+ * @param result    Result of the request.
+ * @param user_data User data given at submission.
+ */
+typedef void (*http_async_cb_t)(const struct http_async_result *result,
+                                void                           *user_data);
+
+struct http_async_request {
+    http_async_method_t method;
+    http_async_prio_t   prio;
+    const char         *url;
+    const char         *base_dir;     /* HTTP_ASYNC_DOWNLOAD only */
+    const char         *payload;      /* HTTP_ASYNC_POST only */
+    const char         *content_type; /* HTTP_ASYNC_POST, NULL for none */
+    http_async_cb_t     cb;           /* NULL if the result is not needed */
+    void               *user_data;
+};
+
+struct http_async_stats {
+    uint32_t submitted;   /* Requests accepted, merged ones included */
+    uint32_t coalesced;   /* Merged into a queued or running request */
+    uint32_t rejected;    /* Refused because the queue was full */
+    uint32_t completed;   /* Requests run, merged ones counted once */
+    uint32_t failed;      /* Completed with an error */
+    uint32_t queued;      /* Currently waiting for a worker */
+    uint32_t running;     /* Currently run by a worker */
+    uint32_t max_wait_ms; /* Longest time a request waited for a worker */
+};
+
+/**
+ * @brief Queues a request.
+ *
+ * The strings of the request are copied, they may be released on return.
+ *
+ * @param req Request to queue.
+ *
+ * @return 0 if queued, 1 if merged into an identical request, -ENOMEM if
+ *         the queue is full, -EINVAL if the request is invalid or a string
+ *         is too long.
+ */
+int http_async_submit(const struct http_async_request *req);
+
+/**
+ * @brief Gets the statistics of the request queue.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void http_async_get_stats(struct http_async_stats *stats);
+
+#endif /* _HTTP_ASYNC_H_ */
@@ -0,0 +1,442 @@
+/**
+ * @file http_cache.c
+ * @brief Table of the validators of cached HTTP resources.
+ *
+ * The table is a file of CONFIG_RPR_HTTP_CACHE_SIZE fixed-size records in
+ * CONFIG_RPR_HTTP_CACHE_DIR, read once and kept in memory. It is written
+ * whole when an entry changes; LittleFS makes the new content visible on
+ * close, so a power loss leaves either the old or the new table. A 304
+ * answer changes nothing on the file system.
+ *
+ * GET response bodies are named after the CRC-32 of their URL.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "http_cache.h"
+
+LOG_MODULE_DECLARE(http_module, CONFIG_RPR_MODULE_HTTP_LOG_LEVEL);
+
+#define CACHE_DIR        CONFIG_RPR_HTTP_CACHE_DIR
+#define CACHE_TABLE_PATH CACHE_DIR "/table.dat"
+#define CACHE_TEMP_PATH  CACHE_DIR "/body%u.tmp"
+#define CACHE_SIZE       CONFIG_RPR_HTTP_CACHE_SIZE
+#define CACHE_MAGIC      0x48434143 /* "CACH" */
+
+struct cache_record {
+    uint32_t magic;
+    uint32_t size; /* Record size, a layout change drops old records */
+    uint32_t used; /* Last use, the oldest entry is replaced first */
+    struct http_cache_entry entry;
+};
+
+struct cache_slot {
+    struct cache_record rec; /* Unused without the magic */
+    uint32_t            requests;
+    uint32_t            hits;
+    uint32_t            saved;
+};
+
+static struct cache_slot cache_slots[CACHE_SIZE];
+static uint32_t          cache_clock; /* Bumped on every use of an entry */
+static bool              cache_loaded;
+static atomic_t          cache_temp_seq; /* Numbers the body temp files */
+K_MUTEX_DEFINE(cache_table_lock);
+
+/**
+ * @brief Creates the directory of the cache if it does not exist.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int cache_mkdir(void)
+{
+    int ret = fs_mkdir(CACHE_DIR);
+
+    if (ret < 0 && ret != -EEXIST) {
+        LOG_ERR("Failed to create %s: %d", CACHE_DIR, ret);
+        return ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Reads the table on first use.
+ *
+ * Records that are not valid are left out.
+ */
+static void cache_load(void)
+{
+    struct fs_file_t file;
+
+    if (cache_loaded) {
+        return;
+    }
+    cache_loaded = true;
+
+    fs_file_t_init(&file);
+    if (fs_open(&file, CACHE_TABLE_PATH, FS_O_READ) < 0) {
+        return;
+    }
+
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        struct cache_record *rec = &cache_slots[i].rec;
+
+        if (fs_read(&file, rec, sizeof(*rec)) != sizeof(*rec)) {
+            memset(rec, 0, sizeof(*rec));
+            break;
+        }
+
+        if (rec->magic != CACHE_MAGIC || rec->size != sizeof(*rec)) {
+            memset(rec, 0, sizeof(*rec));
+            continue;
+        }
+
+        struct http_cache_entry *entry = &rec->entry;
+
+        entry->url[sizeof(entry->url) - 1]                     = '\0';
+        entry->path[sizeof(entry->path) - 1]                   = '\0';
+        entry->etag[sizeof(entry->etag) - 1]                   = '\0';
+        entry->last_modified[sizeof(entry->last_modified) - 1] = '\0';
+        cache_clock = MAX(cache_clock, rec->used);
+    }
+
+    fs_close(&file);
+}
+
+/**
+ * @brief Writes the table.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int cache_save(void)
+{
+    struct fs_file_t file;
+
+    int ret = cache_mkdir();
+    if (ret < 0) {
+        return ret;
+    }
+
+    fs_file_t_init(&file);
+    ret = fs_open(&file, CACHE_TABLE_PATH, FS_O_CREATE | FS_O_WRITE);
+    if (ret < 0) {
+        LOG_ERR("Failed to open %s: %d", CACHE_TABLE_PATH, ret);
+        return ret;
+    }
+
+    for (int i = 0; i < CACHE_SIZE && ret >= 0; i++) {
+        const struct cache_record *rec = &cache_slots[i].rec;
+
+        ret = fs_write(&file, rec, sizeof(*rec));
+        if (ret >= 0 && ret != sizeof(*rec)) {
+            ret = -EIO;
+        }
+    }
+
+    fs_close(&file);
+
+    if (ret < 0) {
+        LOG_ERR("Failed to write %s: %d", CACHE_TABLE_PATH, ret);
+        return ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Finds the slot of a URL.
+ *
+ * @param url URL of the resource.
+ *
+ * @return Slot of the URL, NULL if it is not cached.
+ */
+static struct cache_slot *cache_find(const char *url)
+{
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (cache_slots[i].rec.magic == CACHE_MAGIC &&
+            strcmp(cache_slots[i].rec.entry.url, url) == 0) {
+            return &cache_slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Empties a slot and deletes the body file of the cache it points to.
+ *
+ * Downloaded files are left alone.
+ *
+ * @param slot Slot to empty.
+ */
+static void cache_drop(struct cache_slot *slot)
+{
+    const char *path = slot->rec.entry.path;
+
+    if (strncmp(path, CACHE_DIR "/", sizeof(CACHE_DIR)) == 0) {
+        fs_unlink(path);
+    }
+
+    memset(slot, 0, sizeof(*slot));
+}
+
+/**
+ * @brief Finds the validators of a URL.
+ *
+ * An entry whose file is missing or has another size is dropped.
+ *
+ * @param url   URL of the resource.
+ * @param entry Pointer to store the entry.
+ *
+ * @return 0 on success, -ENOENT if the URL is not cached.
+ */
+int http_cache_lookup(const char *url, struct http_cache_entry *entry)
+{
+    struct fs_dirent dirent;
+
+    if (!url || !entry) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&cache_table_lock, K_FOREVER);
+
+    cache_load();
+
+    struct cache_slot *slot = cache_find(url);
+    if (!slot) {
+        k_mutex_unlock(&cache_table_lock);
+        return -ENOENT;
+    }
+
+    if (fs_stat(slot->rec.entry.path, &dirent) < 0 ||
+        dirent.size != slot->rec.entry.size) {
+        LOG_INF("Cached copy of %s is gone", url);
+        cache_drop(slot);
+        cache_save();
+        k_mutex_unlock(&cache_table_lock);
+        return -ENOENT;
+    }
+
+    slot->rec.used = ++cache_clock;
+    *entry         = slot->rec.entry;
+
+    k_mutex_unlock(&cache_table_lock);
+
+    return 0;
+}
+
+/**
+ * @brief Stores the validators of a URL.
+ *
+ * The least recently used entry makes room if the table is full, a body
+ * file of the cache it points to is deleted. The table is written only if
+ * the entry changed.
+ *
+ * @param entry Entry to store, with at least one validator.
+ *
+ * @return 0 on success, -EINVAL if the entry has no validator, negative
+ *         error code if the table cannot be written.
+ */
+int http_cache_store(const struct http_cache_entry *entry)
+{
+    if (!entry || entry->url[0] == '\0' ||
+        (entry->etag[0] == '\0' && entry->last_modified[0] == '\0')) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&cache_table_lock, K_FOREVER);
+
+    cache_load();
+
+    struct cache_slot *slot = cache_find(entry->url);
+
+    if (slot && memcmp(&slot->rec.entry, entry, sizeof(*entry)) == 0) {
+        slot->rec.used = ++cache_clock;
+        k_mutex_unlock(&cache_table_lock);
+        return 0;
+    }
+
+    if (!slot) {
+        slot = &cache_slots[0];
+        for (int i = 0; i < CACHE_SIZE; i++) {
+            if (cache_slots[i].rec.magic != CACHE_MAGIC) {
+                slot = &cache_slots[i];
+                break;
+            }
+            if (cache_slots[i].rec.used < slot->rec.used) {
+                slot = &cache_slots[i];
+            }
+        }
+
+        if (slot->rec.magic == CACHE_MAGIC) {
+            LOG_DBG("Replacing cached %s", slot->rec.entry.url);
+            cache_drop(slot);
+        }
+    }
+
+    slot->rec.magic = CACHE_MAGIC;
+    slot->rec.size  = sizeof(slot->rec);
+    slot->rec.used  = ++cache_clock;
+    slot->rec.entry = *entry;
+
+    int ret = cache_save();
+
+    k_mutex_unlock(&cache_table_lock);
+
+    return ret;
+}
+
+/**
+ * @brief Drops the validators of a URL.
+ *
+ * @param url URL of the resource.
+ */
+void http_cache_forget(const char *url)
+{
+    if (!url) {
+        return;
+    }
+
+    k_mutex_lock(&cache_table_lock, K_FOREVER);
+
+    cache_load();
+
+    struct cache_slot *slot = cache_find(url);
+    if (slot) {
+        cache_drop(slot);
+        cache_save();
+    }
+
+    k_mutex_unlock(&cache_table_lock);
+}
+
+/**
+ * @brief Counts a response to a request of a cached URL.
+ *
+ * @param url   URL of the resource.
+ * @param hit   true for a 304 Not Modified response.
+ * @param saved Body bytes not transferred, for a hit.
+ */
+void http_cache_count(const char *url, bool hit, uint32_t saved)
+{
+    if (!url) {
+        return;
+    }
+
+    k_mutex_lock(&cache_table_lock, K_FOREVER);
+
+    struct cache_slot *slot = cache_find(url);
+    if (slot) {
+        slot->requests++;
+        if (hit) {
+            slot->hits++;
+            slot->saved += saved;
+        }
+    }
+
+    k_mutex_unlock(&cache_table_lock);
+}
+
+/**
+ * @brief Gets the statistics of a cached URL.
+ *
+ * @param index Index of the entry, from 0.
+ * @param stats Pointer to store the statistics.
+ *
+ * @return 0 on success, -ENOENT if there is no entry at the index.
+ */
+int http_cache_get_stats(int index, struct http_cache_stats *stats)
+{
+    int ret = -ENOENT;
+
+    if (!stats) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&cache_table_lock, K_FOREVER);
+
+    cache_load();
+
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        const struct cache_slot *slot = &cache_slots[i];
+
+        if (slot->rec.magic != CACHE_MAGIC || index-- > 0) {
+            continue;
+        }
+
+        strcpy(stats->url, slot->rec.entry.url);
+        stats->requests = slot->requests;
+        stats->hits     = slot->hits;
+        stats->saved    = slot->saved;
+        ret             = 0;
+        break;
+    }
+
+    k_mutex_unlock(&cache_table_lock);
+
+    return ret;
+}
+
+/**
+ * @brief Gets the path of the body file of a GET response.
+ *
+ * @param url  URL of the resource.
+ * @param path Buffer to store the path.
+ */
+void http_cache_body_path(const char *url, char path[HTTP_CACHE_PATH_MAX_LEN])
+{
+    uint32_t crc = crc32_ieee((const uint8_t *)url, strlen(url));
+
+    snprintf(path, HTTP_CACHE_PATH_MAX_LEN, CACHE_DIR "/%08x.bdy", crc);
+}
+
+/**
+ * @brief Gets a path of its own to receive a GET response body into.
+ *
+ * @param path Buffer to store the path.
+ */
+void http_cache_temp_path(char path[HTTP_CACHE_PATH_MAX_LEN])
+{
+    snprintf(path,
+             HTTP_CACHE_PATH_MAX_LEN,
+             CACHE_TEMP_PATH,
+             (uint32_t)atomic_inc(&cache_temp_seq));
+}
+
+/**
+ * @brief Opens the file a GET response body is received into.
+ *
+ * @param path Path from http_cache_temp_path().
+ * @param file File object to open, initialized with fs_file_t_init().
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int http_cache_open_temp(const char *path, struct fs_file_t *file)
+{
+    int ret = cache_mkdir();
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = fs_open(file, path, FS_O_CREATE | FS_O_WRITE);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = fs_truncate(file, 0);
+    if (ret < 0) {
+        fs_close(file);
+    }
+
+    return ret;
+}
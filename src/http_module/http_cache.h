@@ -0,0 +1,127 @@
+/**
+ * @file http_cache.h
+ * @brief Table of the validators of cached HTTP resources.
+ *
+ * For every cached URL the table keeps the ETag and the Last-Modified date
+ * of the last full response and the file holding its body: the downloaded
+ * file, or a body file of the cache for GET responses. A request of the
+ * same URL sends the validators back in If-None-Match and
+ * If-Modified-Since; a 304 Not Modified answer means the file is still
+ * current and counts as a hit of the URL.
+ *
+ * The table is kept on LittleFS and survives a reboot, the hit counters
+ * are kept in memory.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _HTTP_CACHE_H_
+#define _HTTP_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/fs/fs.h>
+
+#define HTTP_CACHE_VALIDATOR_MAX_LEN 64
+#define HTTP_CACHE_PATH_MAX_LEN \
+    (CONFIG_RPR_FOLDER_PATH_MAX_LEN + CONFIG_RPR_FILENAME_MAX_LEN)
+
+struct http_cache_entry {
+    char     url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
+    char     path[HTTP_CACHE_PATH_MAX_LEN]; /* File holding the body */
+    char     etag[HTTP_CACHE_VALIDATOR_MAX_LEN];          /* Empty if none */
+    char     last_modified[HTTP_CACHE_VALIDATOR_MAX_LEN]; /* Empty if none */
+    uint32_t size;                                         /* Of the body */
+};
+
+struct http_cache_stats {
+    char     url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
+    uint32_t requests; /* Full and not modified responses */
+    uint32_t hits;     /* Not modified responses */
+    uint32_t saved;    /* Body bytes the hits did not transfer */
+};
+
+/**
+ * @brief Finds the validators of a URL.
+ *
+ * An entry whose file is missing or has another size is dropped.
+ *
+ * @param url   URL of the resource.
+ * @param entry Pointer to store the entry.
+ *
+ * @return 0 on success, -ENOENT if the URL is not cached.
+ */
+int http_cache_lookup(const char *url, struct http_cache_entry *entry);
+
+/**
+ * @brief Stores the validators of a URL.
+ *
+ * The least recently used entry makes room if the table is full, a body
+ * file of the cache it points to is deleted.
+ *
+ * @param entry Entry to store, with at least one validator.
+ *
+ * @return 0 on success, -EINVAL if the entry has no validator, negative
+ *         error code if the table cannot be written.
+ */
+int http_cache_store(const struct http_cache_entry *entry);
+
+/**
+ * @brief Drops the validators of a URL.
+ *
+ * @param url URL of the resource.
+ */
+void http_cache_forget(const char *url);
+
+/**
+ * @brief Counts a response to a request of a cached URL.
+ *
+ * @param url   URL of the resource.
+ * @param hit   true for a 304 Not Modified response.
+ * @param saved Body bytes not transferred, for a hit.
+ */
+void http_cache_count(const char *url, bool hit, uint32_t saved);
+
+/**
+ * @brief Gets the statistics of a cached URL.
+ *
+ * @param index Index of the entry, from 0.
+ * @param stats Pointer to store the statistics.
+ *
+ * @return 0 on success, -ENOENT if there is no entry at the index.
+ */
+int http_cache_get_stats(int index, struct http_cache_stats *stats);
+
+/**
+ * @brief Gets the path of the body file of a GET response.
+ *
+ * @param url  URL of the resource.
+ * @param path Buffer to store the path.
+ */
+void http_cache_body_path(const char *url, char path[HTTP_CACHE_PATH_MAX_LEN]);
+
+/**
+ * @brief Gets a path of its own to receive a GET response body into.
+ *
+ * Concurrent requests get different paths. A file left by a reboot is
+ * reused, and emptied, by a later request.
+ *
+ * @param path Buffer to store the path.
+ */
+void http_cache_temp_path(char path[HTTP_CACHE_PATH_MAX_LEN]);
+
+/**
+ * @brief Opens the file a GET response body is received into.
+ *
+ * The file is emptied; it is renamed to the body path once the response
+ * is complete.
+ *
+ * @param path Path from http_cache_temp_path().
+ * @param file File object to open, initialized with fs_file_t_init().
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int http_cache_open_temp(const char *path, struct fs_file_t *file);
+
+#endif /* _HTTP_CACHE_H_ */
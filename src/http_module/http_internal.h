@@ -0,0 +1,311 @@
+/**
+ * @file http_internal.h
+ * @brief Internals of the HTTP module shared by its source files.
+ *
+ * The request contexts and the helpers of http_module.c that the feature
+ * sources of the module build their requests with. Not for use outside of
+ * the HTTP module.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _HTTP_INTERNAL_H_
+#define _HTTP_INTERNAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/net/http/client.h>
+
+#include "http_module.h"
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+#include "http_cache.h"
+#endif
+
+#define HTTP_STATUS_OK        200
+#define HTTP_STATUS_PARTIAL   206
+#define INTERNAL_SERVER_ERROR 500
+#define bytes2KiB(Bytes)      (Bytes / (1024u))
+#define HASH_SIZE_MAX_LEN     32
+
+#define FULL_FILE_PATH_MAX_LEN \
+    (CONFIG_RPR_FOLDER_PATH_MAX_LEN + CONFIG_RPR_FILENAME_MAX_LEN)
+
+#ifdef CONFIG_RPR_HTTP_RESPONSE_HEADERS
+#define HTTP_HEADER_FIELD_MAX_LEN 16
+#define HTTP_HEADER_VALUE_MAX_LEN 64
+#define HTTP_RANGE_MAX_LEN        48
+#define HTTP_IF_RANGE_MAX_LEN     (HTTP_HEADER_VALUE_MAX_LEN + 16)
+#endif
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+#define HTTP_STATUS_NOT_MODIFIED 304
+#endif
+
+typedef enum {
+    HTTP_CTX_NONE = 0,
+    HTTP_CTX_DOWNLOAD,
+    HTTP_CTX_UPDATE,
+    HTTP_CTX_GET,
+    HTTP_CTX_POST,
+    HTTP_CTX_SEGMENT,
+    HTTP_CTX_DELTA,
+} http_context_type_t;
+
+struct url_context {
+    const char *host;
+    const char *port;
+    char        url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
+    bool        is_tls;
+    const char *path;
+};
+
+struct download_context;
+struct update_context;
+struct get_context;
+struct post_context;
+struct segment_context;
+struct delta_context;
+
+union http_context_union {
+    struct download_context *download;
+    struct update_context   *update;
+    struct get_context      *get;
+    struct post_context     *post;
+    struct segment_context  *segment;
+    struct delta_context    *delta;
+};
+
+#ifdef CONFIG_RPR_HTTP_RESPONSE_HEADERS
+typedef enum {
+    HTTP_HDR_NONE = 0,
+    HTTP_HDR_ETAG,
+    HTTP_HDR_LAST_MODIFIED,
+    HTTP_HDR_CONTENT_RANGE,
+    HTTP_HDR_ACCEPT_RANGES,
+    HTTP_HDR_COUNT,
+} http_header_t;
+
+/* Response headers used for validation and ranges */
+struct http_headers {
+    char          field[HTTP_HEADER_FIELD_MAX_LEN]; /* Name being parsed */
+    size_t        field_len;
+    bool          in_value;
+    http_header_t header; /* Header the value being parsed belongs to */
+    char          value[HTTP_HDR_COUNT][HTTP_HEADER_VALUE_MAX_LEN];
+};
+#endif
+
+struct http_pool_conn;
+struct resume_context;
+struct cache_context;
+
+struct http_context {
+    http_context_type_t        type;
+    struct url_context         url_context;
+    uint16_t                  *http_status_code;
+    union http_context_union   ctx;
+    struct http_request_timing timing;
+    int64_t                    start_ms; /* Setup started */
+    int64_t                    sent_ms;  /* Request sent, 0 once data arrived */
+#ifdef CONFIG_RPR_HTTP_POOL
+    struct http_pool_conn *conn; /* Pool slot of the socket, NULL if none */
+#endif
+#ifdef CONFIG_RPR_HTTP_RESPONSE_HEADERS
+    struct http_headers *headers; /* Response headers to keep, or NULL */
+#endif
+#ifdef CONFIG_RPR_HTTP_RESUME
+    struct resume_context *resume; /* NULL if the transfer is not journaled */
+#endif
+#ifdef CONFIG_RPR_HTTP_CACHE
+    struct cache_context *cache; /* NULL if the response is not cached */
+#endif
+};
+
+/* Counters of http_get_conn_stats(), see http_stats_count() */
+extern struct http_conn_stats conn_stats;
+
+/* Callback for completed file downloads, NULL if none */
+extern http_download_callback_t download_callback;
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+/**
+ * @brief Prints the hexadecimal representation of a hash.
+ *
+ * @param p   Pointer to the binary hash data.
+ * @param len Length of the hash data in bytes.
+ */
+void print_hash(const unsigned char *p, int len);
+#endif
+
+/**
+ * @brief Increments one of the connection counters.
+ *
+ * @param counter Member of conn_stats.
+ */
+void http_stats_count(uint32_t *counter);
+
+/**
+ * @brief Constructs the local path of a download from the URL path.
+ *
+ * @param folder   Folder to download into.
+ * @param path     Path part of the URL.
+ * @param filepath Buffer of FULL_FILE_PATH_MAX_LEN to store the path.
+ *
+ * @return HTTP_URL_OK on success, HTTP_ERR_NO_FILENAME if the URL names
+ *         no file.
+ */
+http_status_t
+download_filepath(const char *folder, const char *path, char *filepath);
+
+/**
+ * @brief Initializes and prepares an HTTP client connection.
+ *
+ * @param url        The full HTTP or HTTPS URL to connect to.
+ * @param sock       Pointer to store the connected socket.
+ * @param http_ctx   HTTP context holding URL components and state.
+ *
+ * @return HTTP_CLIENT_OK on success, or appropriate `http_status_t` error
+ *         code on failure.
+ */
+http_status_t
+setup_http_client(const char *url, int *sock, struct http_context *http_ctx);
+
+/**
+ * @brief Sends a request on a connection from setup_http_client() and gives
+ *        up the connection.
+ *
+ * @param sock      Socket returned by setup_http_client().
+ * @param req       Request to send.
+ * @param http_ctx  HTTP context of the request.
+ *
+ * @return Result of http_client_req().
+ */
+int send_request(int                  sock,
+                 struct http_request *req,
+                 struct http_context *http_ctx);
+
+/**
+ * @brief Gives up the socket of a request.
+ *
+ * @param sock      Socket of the request.
+ * @param http_ctx  HTTP context of the request.
+ * @param keep      The connection may serve another request.
+ */
+void release_socket(int sock, struct http_context *http_ctx, bool keep);
+
+/**
+ * @brief HTTP response callback of all requests, passes the body to the
+ *        context of the request.
+ *
+ * @param rsp         Pointer to the received HTTP response fragment.
+ * @param final_data  Indicates if this is the final callback call.
+ * @param user_data   Pointer to the `http_context` of the request.
+ */
+void response_cb(struct http_response *rsp,
+                 enum http_final_call  final_data,
+                 void                 *user_data);
+
+#ifdef CONFIG_RPR_HTTP_RESPONSE_HEADERS
+/* Parser callbacks that keep the response headers of http_context */
+extern const struct http_parser_settings http_header_settings;
+
+/**
+ * @brief Gets the validator of a response for If-Range.
+ *
+ * @param hdrs Response headers.
+ *
+ * @return Strong ETag or Last-Modified date, NULL if there is neither.
+ */
+const char *http_headers_validator(const struct http_headers *hdrs);
+
+/**
+ * @brief Parses the Content-Range header of a 206 response.
+ *
+ * @param hdrs  Response headers.
+ * @param first Pointer to store the offset of the first byte.
+ * @param total Pointer to store the size of the resource, 0 if unknown.
+ *
+ * @return 0 on success, -EINVAL if the header is missing or malformed.
+ */
+int http_headers_range(const struct http_headers *hdrs,
+                       uint32_t                  *first,
+                       uint32_t                  *total);
+
+/**
+ * @brief Builds the Range and If-Range request headers.
+ *
+ * @param range      Buffer of the Range header.
+ * @param if_range   Buffer of the If-Range header.
+ * @param fields     Header list to fill, NULL terminated.
+ * @param first      First byte to request.
+ * @param last       Last byte to request, 0 for the rest of the resource.
+ * @param validator  Validator for If-Range, NULL or empty to leave it out.
+ */
+void http_range_headers(char        range[HTTP_RANGE_MAX_LEN],
+                        char        if_range[HTTP_IF_RANGE_MAX_LEN],
+                        const char *fields[3],
+                        uint32_t    first,
+                        uint32_t    last,
+                        const char *validator);
+#endif // CONFIG_RPR_HTTP_RESPONSE_HEADERS
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+/**
+ * @brief Sets up the cache for a request and makes the request conditional.
+ *
+ * @param url       URL of the request.
+ * @param path      Destination file of a download, NULL for a GET request.
+ * @param http_ctx  HTTP context of the request.
+ * @param req       Request to send.
+ *
+ * @return Cache context of the request, NULL if none is free.
+ */
+struct cache_context *cache_begin(const char          *url,
+                                  const char          *path,
+                                  struct http_context *http_ctx,
+                                  struct http_request *req);
+
+/**
+ * @brief Stores the validators of a downloaded file in the cache.
+ *
+ * @param entry Buffer to build the entry in.
+ * @param url   URL of the request.
+ * @param hdrs  Headers of the response.
+ * @param path  Downloaded file.
+ */
+void cache_store_file(struct http_cache_entry   *entry,
+                      const char                *url,
+                      const struct http_headers *hdrs,
+                      const char                *path);
+
+/**
+ * @brief Checks for a 304 Not Modified answer to a conditional request.
+ *
+ * @param cctx   Cache context of the request.
+ * @param status HTTP status of the response.
+ *
+ * @return true if the cached copy is current.
+ */
+bool cache_not_modified(struct cache_context *cctx, uint16_t status);
+
+/**
+ * @brief Releases the cache context of a request.
+ *
+ * @param http_ctx HTTP context of the request.
+ */
+void cache_end(struct http_context *http_ctx);
+#endif // CONFIG_RPR_HTTP_CACHE
+
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+/**
+ * @brief Stores a fragment of the response to a segment request.
+ *
+ * @param seg Segment the request belongs to.
+ * @param rsp Received response fragment.
+ */
+void segment_store(struct segment_context *seg, struct http_response *rsp);
+#endif
+
+#endif // _HTTP_INTERNAL_H_
@@ -0,0 +1,661 @@
+/**
+ * @file http_json.c
+ * @brief Incremental event-based JSON parser for HTTP responses.
+ *
+ * A character level state machine; the nesting is kept as one bit per
+ * level telling objects from arrays. A number has no end marker, so the
+ * character after it is parsed again in the state that follows the number.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <string.h>
+
+#include "http_json.h"
+
+LOG_MODULE_DECLARE(http_module, CONFIG_RPR_MODULE_HTTP_LOG_LEVEL);
+
+#define JSON_REPLACEMENT_CHAR 0xFFFD
+
+/**
+ * @brief Start parsing a document.
+ *
+ * @param parser    Pointer to the parser to initialize.
+ * @param cb        Function called for every value.
+ * @param user_data User data for the callback.
+ */
+void http_json_init(struct http_json_parser *parser,
+                    http_json_cb_t           cb,
+                    void                    *user_data)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->cb        = cb;
+    parser->user_data = user_data;
+    parser->state     = HTTP_JSON_VALUE;
+}
+
+/**
+ * @brief Checks for JSON whitespace.
+ *
+ * @param c Character.
+ *
+ * @return true for a space, tab, line feed or carriage return.
+ */
+static bool json_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * @brief Checks whether the innermost container is an object.
+ *
+ * @param parser Pointer to the parser.
+ *
+ * @return true inside an object, false inside an array or at the top.
+ */
+static bool json_in_object(const struct http_json_parser *parser)
+{
+    return parser->depth > 0 && (parser->objects & BIT(parser->depth - 1));
+}
+
+/**
+ * @brief Calls back for a value with the key it belongs to.
+ *
+ * @param parser Pointer to the parser.
+ * @param event  Kind of the value.
+ * @param value  Text of a string or a number, NULL otherwise.
+ * @param len    Length of the text.
+ *
+ * @return The result of the callback.
+ */
+static int json_emit(struct http_json_parser *parser,
+                     http_json_event_t        event,
+                     const char              *value,
+                     size_t                   len)
+{
+    struct http_json_token tok = {
+        .event     = event,
+        .key       = parser->has_key ? parser->key : NULL,
+        .value     = value,
+        .len       = len,
+        .depth     = parser->depth,
+        .truncated = (parser->has_key && parser->key_truncated) ||
+                     (value && parser->truncated),
+    };
+
+    parser->has_key = false;
+
+    return parser->cb ? parser->cb(&tok, parser->user_data) : 0;
+}
+
+/**
+ * @brief Moves past a complete value.
+ *
+ * @param parser Pointer to the parser.
+ */
+static void json_value_done(struct http_json_parser *parser)
+{
+    parser->state = parser->depth ? HTTP_JSON_NEXT : HTTP_JSON_DONE;
+}
+
+/**
+ * @brief Opens an object or an array.
+ *
+ * @param parser Pointer to the parser.
+ * @param object true for an object.
+ *
+ * @return 0 on success, -E2BIG if nested too deep, or the error returned by
+ *         the callback.
+ */
+static int json_open(struct http_json_parser *parser, bool object)
+{
+    if (parser->depth >= HTTP_JSON_MAX_DEPTH) {
+        return -E2BIG;
+    }
+
+    int ret = json_emit(parser,
+                        object ? HTTP_JSON_OBJECT_START : HTTP_JSON_ARRAY_START,
+                        NULL,
+                        0);
+
+    WRITE_BIT(parser->objects, parser->depth, object);
+    parser->depth++;
+    parser->state = object ? HTTP_JSON_FIRST_KEY : HTTP_JSON_FIRST_VALUE;
+
+    return ret;
+}
+
+/**
+ * @brief Closes the innermost object or array.
+ *
+ * @param parser Pointer to the parser.
+ * @param object true for '}', false for ']'.
+ *
+ * @return 0 on success, -EBADMSG if it does not match the open container,
+ *         or the error returned by the callback.
+ */
+static int json_close(struct http_json_parser *parser, bool object)
+{
+    if (parser->depth == 0 || json_in_object(parser) != object) {
+        return -EBADMSG;
+    }
+
+    http_json_event_t event =
+            object ? HTTP_JSON_OBJECT_END : HTTP_JSON_ARRAY_END;
+
+    parser->depth--;
+    json_value_done(parser);
+
+    return json_emit(parser, event, NULL, 0);
+}
+
+/**
+ * @brief Adds a byte to the key or the value being read.
+ *
+ * @param parser Pointer to the parser.
+ * @param c      Byte to add.
+ */
+static void json_append(struct http_json_parser *parser, char c)
+{
+    if (parser->in_key) {
+        if (parser->key_len < sizeof(parser->key) - 1) {
+            parser->key[parser->key_len++] = c;
+        } else {
+            parser->key_truncated = true;
+        }
+    } else {
+        if (parser->len < sizeof(parser->buf) - 1) {
+            parser->buf[parser->len++] = c;
+        } else {
+            parser->truncated = true;
+        }
+    }
+}
+
+/**
+ * @brief Adds a code point to the string being read, in UTF-8.
+ *
+ * @param parser Pointer to the parser.
+ * @param cp     Code point.
+ */
+static void json_append_code(struct http_json_parser *parser, uint32_t cp)
+{
+    if (cp < 0x80) {
+        json_append(parser, (char)cp);
+    } else if (cp < 0x800) {
+        json_append(parser, (char)(0xC0 | (cp >> 6)));
+        json_append(parser, (char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        json_append(parser, (char)(0xE0 | (cp >> 12)));
+        json_append(parser, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        json_append(parser, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        json_append(parser, (char)(0xF0 | (cp >> 18)));
+        json_append(parser, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        json_append(parser, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        json_append(parser, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+/**
+ * @brief Replaces a high surrogate that got no low one.
+ *
+ * @param parser Pointer to the parser.
+ */
+static void json_flush_surrogate(struct http_json_parser *parser)
+{
+    if (parser->surrogate) {
+        parser->surrogate = 0;
+        json_append_code(parser, JSON_REPLACEMENT_CHAR);
+    }
+}
+
+/**
+ * @brief Adds the code unit of a complete \u escape.
+ *
+ * @param parser Pointer to the parser.
+ */
+static void json_unicode(struct http_json_parser *parser)
+{
+    uint16_t code = parser->code;
+
+    if (code >= 0xD800 && code <= 0xDBFF) {
+        json_flush_surrogate(parser);
+        parser->surrogate = code;
+    } else if (code >= 0xDC00 && code <= 0xDFFF) {
+        if (parser->surrogate) {
+            json_append_code(parser,
+                             0x10000 + ((parser->surrogate - 0xD800) << 10) +
+                                     (code - 0xDC00));
+            parser->surrogate = 0;
+        } else {
+            json_append_code(parser, JSON_REPLACEMENT_CHAR);
+        }
+    } else {
+        json_flush_surrogate(parser);
+        json_append_code(parser, code);
+    }
+}
+
+/**
+ * @brief Starts reading a string.
+ *
+ * @param parser Pointer to the parser.
+ * @param key    true for a member name.
+ */
+static void json_start_string(struct http_json_parser *parser, bool key)
+{
+    parser->in_key = key;
+    if (key) {
+        parser->key_len       = 0;
+        parser->key_truncated = false;
+    } else {
+        parser->len       = 0;
+        parser->truncated = false;
+    }
+    parser->state = HTTP_JSON_IN_STRING;
+}
+
+/**
+ * @brief Ends the string being read.
+ *
+ * @param parser Pointer to the parser.
+ *
+ * @return 0 on success, or the error returned by the callback.
+ */
+static int json_end_string(struct http_json_parser *parser)
+{
+    json_flush_surrogate(parser);
+
+    if (parser->in_key) {
+        parser->key[parser->key_len] = '\0';
+        parser->has_key              = true;
+        parser->state                = HTTP_JSON_COLON;
+        return 0;
+    }
+
+    parser->buf[parser->len] = '\0';
+    json_value_done(parser);
+
+    return json_emit(parser, HTTP_JSON_STRING, parser->buf, parser->len);
+}
+
+/**
+ * @brief Checks the next character of a number against the JSON grammar.
+ *
+ * @param parser Pointer to the parser.
+ * @param c      Character.
+ *
+ * @return true if the character continues the number, false if it does not
+ *         belong to it.
+ */
+static bool json_number_char(struct http_json_parser *parser, char c)
+{
+    bool digit = c >= '0' && c <= '9';
+
+    switch (parser->number) {
+    case HTTP_JSON_NUM_SIGN:
+        if (digit) {
+            parser->number = c == '0' ? HTTP_JSON_NUM_ZERO : HTTP_JSON_NUM_INT;
+        }
+        return digit;
+    case HTTP_JSON_NUM_DOT:
+        if (digit) {
+            parser->number = HTTP_JSON_NUM_FRAC;
+        }
+        return digit;
+    case HTTP_JSON_NUM_EXP:
+        if (c == '+' || c == '-') {
+            parser->number = HTTP_JSON_NUM_EXP_SIGN;
+            return true;
+        }
+        /* fall through */
+    case HTTP_JSON_NUM_EXP_SIGN:
+        if (digit) {
+            parser->number = HTTP_JSON_NUM_EXP_INT;
+        }
+        return digit;
+    case HTTP_JSON_NUM_EXP_INT:
+        return digit;
+    default:
+        break;
+    }
+
+    /* An integer, a leading zero or a fraction */
+    if (digit) {
+        return parser->number != HTTP_JSON_NUM_ZERO;
+    }
+    if (c == '.' && parser->number != HTTP_JSON_NUM_FRAC) {
+        parser->number = HTTP_JSON_NUM_DOT;
+        return true;
+    }
+    if (c == 'e' || c == 'E') {
+        parser->number = HTTP_JSON_NUM_EXP;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Ends the number being read.
+ *
+ * @param parser Pointer to the parser.
+ *
+ * @return 0 on success, -EBADMSG if the number is incomplete, or the error
+ *         returned by the callback.
+ */
+static int json_end_number(struct http_json_parser *parser)
+{
+    switch (parser->number) {
+    case HTTP_JSON_NUM_ZERO:
+    case HTTP_JSON_NUM_INT:
+    case HTTP_JSON_NUM_FRAC:
+    case HTTP_JSON_NUM_EXP_INT:
+        break;
+    default:
+        return -EBADMSG;
+    }
+
+    parser->buf[parser->len] = '\0';
+    json_value_done(parser);
+
+    return json_emit(parser, HTTP_JSON_NUMBER, parser->buf, parser->len);
+}
+
+/**
+ * @brief Starts the value that begins with a character.
+ *
+ * @param parser Pointer to the parser.
+ * @param c      First character of the value.
+ *
+ * @return 0 on success, -EBADMSG if no value starts with it, or the error
+ *         returned by the callback.
+ */
+static int json_start_value(struct http_json_parser *parser, char c)
+{
+    switch (c) {
+    case '{':
+        return json_open(parser, true);
+    case '[':
+        return json_open(parser, false);
+    case '"':
+        json_start_string(parser, false);
+        return 0;
+    case 't':
+        parser->literal = "true";
+        break;
+    case 'f':
+        parser->literal = "false";
+        break;
+    case 'n':
+        parser->literal = "null";
+        break;
+    default:
+        if (c != '-' && (c < '0' || c > '9')) {
+            return -EBADMSG;
+        }
+        parser->in_key    = false;
+        parser->len       = 0;
+        parser->truncated = false;
+        parser->number    = HTTP_JSON_NUM_SIGN;
+        if (c != '-') {
+            json_number_char(parser, c);
+        }
+        json_append(parser, c);
+        parser->state = HTTP_JSON_IN_NUMBER;
+        return 0;
+    }
+
+    parser->literal_pos = 1;
+    parser->state       = HTTP_JSON_IN_LITERAL;
+    return 0;
+}
+
+/**
+ * @brief Parses one character.
+ *
+ * @param parser   Pointer to the parser.
+ * @param c        Character.
+ * @param consumed Set to false if the character must be parsed again.
+ *
+ * @return 0 on success, negative errno code otherwise.
+ */
+static int json_char(struct http_json_parser *parser, char c, bool *consumed)
+{
+    int value;
+
+    switch (parser->state) {
+    case HTTP_JSON_VALUE:
+    case HTTP_JSON_FIRST_VALUE:
+        if (json_is_space(c)) {
+            return 0;
+        }
+        if (c == ']' && parser->state == HTTP_JSON_FIRST_VALUE) {
+            return json_close(parser, false);
+        }
+        return json_start_value(parser, c);
+
+    case HTTP_JSON_FIRST_KEY:
+    case HTTP_JSON_KEY:
+        if (json_is_space(c)) {
+            return 0;
+        }
+        if (c == '}' && parser->state == HTTP_JSON_FIRST_KEY) {
+            return json_close(parser, true);
+        }
+        if (c != '"') {
+            return -EBADMSG;
+        }
+        json_start_string(parser, true);
+        return 0;
+
+    case HTTP_JSON_COLON:
+        if (json_is_space(c)) {
+            return 0;
+        }
+        if (c != ':') {
+            return -EBADMSG;
+        }
+        parser->state = HTTP_JSON_VALUE;
+        return 0;
+
+    case HTTP_JSON_NEXT:
+        if (json_is_space(c)) {
+            return 0;
+        }
+        if (c == ',') {
+            parser->state =
+                    json_in_object(parser) ? HTTP_JSON_KEY : HTTP_JSON_VALUE;
+            return 0;
+        }
+        if (c == '}' || c == ']') {
+            return json_close(parser, c == '}');
+        }
+        return -EBADMSG;
+
+    case HTTP_JSON_IN_STRING:
+        if (c == '"') {
+            return json_end_string(parser);
+        }
+        if (c == '\\') {
+            parser->state = HTTP_JSON_ESCAPE;
+            return 0;
+        }
+        if ((uint8_t)c < 0x20) {
+            return -EBADMSG;
+        }
+        json_flush_surrogate(parser);
+        json_append(parser, c);
+        return 0;
+
+    case HTTP_JSON_ESCAPE:
+        parser->state = HTTP_JSON_IN_STRING;
+
+        switch (c) {
+        case 'u':
+            parser->code    = 0;
+            parser->hex_len = 0;
+            parser->state   = HTTP_JSON_UNICODE;
+            return 0;
+        case '"':
+        case '\\':
+        case '/':
+            break;
+        case 'b':
+            c = '\b';
+            break;
+        case 'f':
+            c = '\f';
+            break;
+        case 'n':
+            c = '\n';
+            break;
+        case 'r':
+            c = '\r';
+            break;
+        case 't':
+            c = '\t';
+            break;
+        default:
+            return -EBADMSG;
+        }
+        json_flush_surrogate(parser);
+        json_append(parser, c);
+        return 0;
+
+    case HTTP_JSON_UNICODE:
+        if (c >= '0' && c <= '9') {
+            value = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            value = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            value = c - 'A' + 10;
+        } else {
+            return -EBADMSG;
+        }
+
+        parser->code = (parser->code << 4) | value;
+        if (++parser->hex_len == 4) {
+            json_unicode(parser);
+            parser->state = HTTP_JSON_IN_STRING;
+        }
+        return 0;
+
+    case HTTP_JSON_IN_NUMBER:
+        if (json_number_char(parser, c)) {
+            json_append(parser, c);
+            return 0;
+        }
+        *consumed = false;
+        return json_end_number(parser);
+
+    case HTTP_JSON_IN_LITERAL:
+        if (c != parser->literal[parser->literal_pos]) {
+            return -EBADMSG;
+        }
+        if (parser->literal[++parser->literal_pos] != '\0') {
+            return 0;
+        }
+        json_value_done(parser);
+
+        switch (parser->literal[0]) {
+        case 't':
+            return json_emit(parser, HTTP_JSON_TRUE, NULL, 0);
+        case 'f':
+            return json_emit(parser, HTTP_JSON_FALSE, NULL, 0);
+        default:
+            return json_emit(parser, HTTP_JSON_NULL, NULL, 0);
+        }
+
+    case HTTP_JSON_DONE:
+    default:
+        return json_is_space(c) ? 0 : -EBADMSG;
+    }
+}
+
+/**
+ * @brief Parse the next fragment of a document.
+ *
+ * @param parser Pointer to the parser.
+ * @param data   Fragment.
+ * @param len    Length of the fragment.
+ *
+ * @return 0 on success, -EBADMSG if the document is malformed, -E2BIG if
+ *         it is nested deeper than HTTP_JSON_MAX_DEPTH, or the error
+ *         returned by the callback. Errors are sticky.
+ */
+int http_json_write(struct http_json_parser *parser,
+                    const char              *data,
+                    size_t                   len)
+{
+    if (!parser || (len > 0 && !data)) {
+        return -EINVAL;
+    }
+
+    if (parser->error) {
+        return parser->error;
+    }
+
+    size_t pos = 0;
+    int    ret = 0;
+
+    while (pos < len && ret == 0) {
+        bool consumed = true;
+
+        ret = json_char(parser, data[pos], &consumed);
+        if (consumed) {
+            pos++;
+        }
+    }
+
+    parser->consumed += pos;
+
+    if (ret < 0) {
+        if (ret == -EBADMSG || ret == -E2BIG) {
+            LOG_WRN("Invalid JSON at byte %zu", parser->consumed);
+        }
+        parser->error = ret;
+        return ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Finish parsing a document.
+ *
+ * @param parser Pointer to the parser.
+ *
+ * @return 0 if a complete document was parsed, -EBADMSG if it is
+ *         incomplete, or the first error of http_json_write().
+ */
+int http_json_finish(struct http_json_parser *parser)
+{
+    if (!parser) {
+        return -EINVAL;
+    }
+
+    if (parser->error) {
+        return parser->error;
+    }
+
+    if (parser->state == HTTP_JSON_IN_NUMBER && parser->depth == 0) {
+        parser->error = json_end_number(parser);
+        if (parser->error) {
+            return parser->error;
+        }
+    }
+
+    if (parser->state != HTTP_JSON_DONE) {
+        LOG_WRN("Incomplete JSON after %zu bytes", parser->consumed);
+        parser->error = -EBADMSG;
+    }
+
+    return parser->error;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file http_json.h
+ * @brief Incremental event-based JSON parser for HTTP responses.
+ *
+ * The parser is fed the body as it arrives, in fragments of any size, and
+ * calls back for every value with the member name it belongs to. Only the
+ * current member name and the current string or number are buffered, so
+ * a response of any length, such as a long list, is parsed in the memory
+ * of the parser structure.
+ *
+ * Strings longer than the buffers are cut and flagged as truncated.
+ * Numbers are checked against the JSON grammar and passed as the text
+ * received.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _HTTP_JSON_H_
+#define _HTTP_JSON_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HTTP_JSON_MAX_DEPTH 32
+
+typedef enum {
+    HTTP_JSON_OBJECT_START = 0,
+    HTTP_JSON_OBJECT_END,
+    HTTP_JSON_ARRAY_START,
+    HTTP_JSON_ARRAY_END,
+    HTTP_JSON_STRING,
+    HTTP_JSON_NUMBER,
+    HTTP_JSON_TRUE,
+    HTTP_JSON_FALSE,
+    HTTP_JSON_NULL,
+} http_json_event_t;
+
+struct http_json_token {
+    http_json_event_t event;
+    const char       *key;       /* Member name, NULL in arrays */
+    const char       *value;     /* String or number text, NULL otherwise */
+    size_t            len;       /* Length of the value */
+    uint8_t           depth;     /* Nesting of the value, 0 at the top */
+    bool              truncated; /* The value or the key was cut */
+};
+
+/**
+ * @brief Receives the values of the document.
+ *
+ * The token and the strings it points to are valid during the call only.
+ * Start and end events of a container have the same depth and the key
+ * is given with the start event.
+ *
+ * @param tok       Parsed value.
+ * @param user_data User data given to http_json_init().
+ *
+ * @return 0 to continue, negative errno code to stop the parser.
+ */
+typedef int (*http_json_cb_t)(const struct http_json_token *tok,
+                              void                         *user_data);
+
+typedef enum {
+    HTTP_JSON_VALUE = 0,   /* A value */
+    HTTP_JSON_FIRST_VALUE, /* A value or the end of an empty array */
+    HTTP_JSON_FIRST_KEY,   /* A key or the end of an empty object */
+    HTTP_JSON_KEY,         /* A key after a comma */
+    HTTP_JSON_COLON,
+    HTTP_JSON_NEXT, /* A comma or the end of the container */
+    HTTP_JSON_IN_STRING,
+    HTTP_JSON_ESCAPE,
+    HTTP_JSON_UNICODE,
+    HTTP_JSON_IN_NUMBER,
+    HTTP_JSON_IN_LITERAL,
+    HTTP_JSON_DONE, /* Only whitespace may follow */
+} http_json_state_t;
+
+typedef enum {
+    HTTP_JSON_NUM_SIGN = 0, /* After a minus sign */
+    HTTP_JSON_NUM_ZERO,     /* After a leading zero */
+    HTTP_JSON_NUM_INT,
+    HTTP_JSON_NUM_DOT,
+    HTTP_JSON_NUM_FRAC,
+    HTTP_JSON_NUM_EXP,      /* After e or E */
+    HTTP_JSON_NUM_EXP_SIGN,
+    HTTP_JSON_NUM_EXP_INT,
+} http_json_number_t;
+
+struct http_json_parser {
+    http_json_cb_t     cb;
+    void              *user_data;
+    http_json_state_t  state;
+    http_json_number_t number; /* Part of the number being read */
+    uint8_t            depth;
+    uint32_t           objects; /* Bit per level, set for an object */
+    bool               in_key;  /* The string being read is a key */
+    bool               has_key; /* The key belongs to the next value */
+    bool               key_truncated;
+    bool               truncated;
+    const char        *literal; /* true, false or null being matched */
+    uint8_t            literal_pos;
+    uint8_t            hex_len;   /* Digits of a \u escape read */
+    uint16_t           code;      /* Code unit of a \u escape */
+    uint16_t           surrogate; /* High surrogate waiting for its pair */
+    size_t             key_len;
+    size_t             len;
+    size_t             consumed; /* Bytes parsed, for error messages */
+    int                error;    /* First error, sticky */
+    char               key[CONFIG_RPR_HTTP_JSON_KEY_MAX_LEN];
+    char               buf[CONFIG_RPR_HTTP_JSON_VALUE_MAX_LEN];
+};
+
+/**
+ * @brief Start parsing a document.
+ *
+ * @param parser    Pointer to the parser to initialize.
+ * @param cb        Function called for every value.
+ * @param user_data User data for the callback.
+ */
+void http_json_init(struct http_json_parser *parser,
+                    http_json_cb_t           cb,
+                    void                    *user_data);
+
+/**
+ * @brief Parse the next fragment of a document.
+ *
+ * @param parser Pointer to the parser.
+ * @param data   Fragment.
+ * @param len    Length of the fragment.
+ *
+ * @return 0 on success, -EBADMSG if the document is malformed, -E2BIG if
+ *         it is nested deeper than HTTP_JSON_MAX_DEPTH, or the error
+ *         returned by the callback. Errors are sticky.
+ */
+int http_json_write(struct http_json_parser *parser,
+                    const char              *data,
+                    size_t                   len);
+
+/**
+ * @brief Finish parsing a document.
+ *
+ * A number at the top level ends here.
+ *
+ * @param parser Pointer to the parser.
+ *
+ * @return 0 if a complete document was parsed, -EBADMSG if it is
+ *         incomplete, or the first error of http_json_write().
+ */
+int http_json_finish(struct http_json_parser *parser);
+
+#endif // _HTTP_JSON_H_
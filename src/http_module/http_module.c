@@ -10,14 +10,25 @@
  *  - Socket connection and timeout configuration
  *  - Response parsing and buffer management
  *  - Optional file storage and hash computation for downloads
+ *  - Optional keep-alive connection pool with pre-warming
+ *  - Optional host name cache with stale serving and negative caching
+ *  - Optional TLS session resumption for HTTPS
+ *  - Optional resumption of interrupted downloads with Range requests
+ *  - Optional write-behind queue between the socket and the file system
+ *  - Optional segmented downloads over several connections
  *
  * The module supports both text-based API usage (GET/POST with in-memory buffers)
  * and binary file download via the Zephyr filesystem API.
+ *
+ * Every request records how long name resolution, connect, the first response
+ * data and the whole request took, see http_get_last_timing().
  * 
  * @author Eugene K.
  * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
  */
 
+#include <stdlib.h>
+
 #include <zephyr/kernel.h>
 #include <zephyr/net/socket.h>
 #include <zephyr/fs/fs.h>
@@ -27,15 +38,44 @@
 #include <zephyr/net/http/client.h>
 
 #include "http_module.h"
+#include "http_internal.h"
 
-#ifdef CONFIG_MBEDTLS
-#include "mbedtls/md.h"
+#ifdef CONFIG_RPR_HASH_CALCULATION
+#include "mbedtls/sha256.h"
 #endif
 
 #ifdef CONFIG_RPR_MODULE_DFU
 #include "dfu_manager.h"
 #endif
 
+#ifdef CONFIG_RPR_DFU_DELTA
+#include "dfu_delta.h"
+#endif
+
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+#include "dfu_decompress.h"
+#endif
+
+#ifdef CONFIG_RPR_FLASH_QOS
+#include "flash_qos.h"
+#endif
+
+#ifdef CONFIG_RPR_WRITE_BEHIND
+#include "write_behind.h"
+#endif
+
+#ifdef CONFIG_RPR_HTTP_RESPONSE_HEADERS
+#include <strings.h>
+#endif
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+#include "http_resume.h"
+#endif
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+#include "http_cache.h"
+#endif
+
 #ifdef CONFIG_NET_SOCKETS_SOCKOPT_TLS
 #include <zephyr/net/tls_credentials.h>
 #include "ca_certificate.h"
@@ -47,38 +87,47 @@ LOG_MODULE_REGISTER(http_module, CONFIG_RPR_MODULE_HTTP_LOG_LEVEL);
 #define SOCKET_TIMEOUT_MS     (5 * MSEC_PER_SEC)
 #define ADDRINFO_TIMEOUT_MS   (2 * MSEC_PER_SEC)
 #define RESOLVE_ATTEMPTS      5
-#define HTTP_STATUS_OK        200
-#define bytes2KiB(Bytes)      (Bytes / (1024u))
-#define HASH_SIZE_MAX_LEN     32
 #define HTTPS_PORT            "443"
 #define HTTP_PORT             "80"
 #define HTTP_PATH_SHIFT_RIGHT 1
-#define INTERNAL_SERVER_ERROR 500
 
-#define FULL_FILE_PATH_MAX_LEN \
-    (CONFIG_RPR_FOLDER_PATH_MAX_LEN + CONFIG_RPR_FILENAME_MAX_LEN)
+#define DOWNLOAD_TEMP_SUFFIX ".tmp"
+#define DOWNLOAD_TEMP_PATH_MAX_LEN \
+    (FULL_FILE_PATH_MAX_LEN + sizeof(DOWNLOAD_TEMP_SUFFIX))
+
+#ifdef CONFIG_RPR_HTTP_POOL
+#define POOL_SIZE            CONFIG_RPR_HTTP_POOL_SIZE
+#define POOL_IDLE_MS \
+    (CONFIG_RPR_HTTP_POOL_IDLE_TIMEOUT_S * MSEC_PER_SEC)
+#define POOL_HOST_MAX_LEN    CONFIG_RPR_HTTP_POOL_HOST_MAX_LEN
+#define POOL_PORT_MAX_LEN    6
+#define POOL_PREWARM_WAIT_MS (10 * MSEC_PER_SEC)
+#endif
 
-typedef enum {
-    HTTP_CTX_NONE = 0,
-    HTTP_CTX_DOWNLOAD,
-    HTTP_CTX_UPDATE,
-    HTTP_CTX_GET,
-    HTTP_CTX_POST,
-} http_context_type_t;
-
-struct url_context {
-    const char *host;
-    const char *port;
-    char        url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
-    bool        is_tls;
-    const char *path;
-};
+#ifdef CONFIG_RPR_HTTP_CACHE
+#define HTTP_CONDITIONAL_MAX_LEN (HTTP_HEADER_VALUE_MAX_LEN + 24)
+#define CACHE_BODY_MAX_LEN       CONFIG_RPR_HTTP_CACHE_BODY_MAX_LEN
+#define CACHE_REPLAY_CHUNK       128
+#endif
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+#define RESUME_CHECKPOINT_BYTES (CONFIG_RPR_HTTP_RESUME_CHECKPOINT_KB * 1024)
+#define RESUME_SERVER_ERROR_MIN 500
+#endif
+
+#ifdef CONFIG_RPR_HTTP_DNS_CACHE
+#define DNS_CACHE_SIZE   CONFIG_RPR_HTTP_DNS_CACHE_SIZE
+#define DNS_HOST_MAX_LEN CONFIG_RPR_HTTP_DNS_CACHE_HOST_MAX_LEN
+#define DNS_TTL_MS       (CONFIG_RPR_HTTP_DNS_CACHE_TTL_S * MSEC_PER_SEC)
+#define DNS_STALE_MS     (CONFIG_RPR_HTTP_DNS_CACHE_STALE_S * MSEC_PER_SEC)
+#define DNS_NEGATIVE_TTL_MS \
+    (CONFIG_RPR_HTTP_DNS_CACHE_NEGATIVE_TTL_S * MSEC_PER_SEC)
+#endif
 
 #ifdef CONFIG_RPR_HASH_CALCULATION
 struct http_dwn_hash_context {
-    char                     response_hash[HASH_SIZE_MAX_LEN];
-    mbedtls_md_context_t     hash_ctx;
-    const mbedtls_md_info_t *hash_info;
+    unsigned char          response_hash[HASH_SIZE_MAX_LEN];
+    mbedtls_sha256_context hash_ctx;
 };
 #endif
 
@@ -87,6 +136,9 @@ struct download_context {
     char             filepath[FULL_FILE_PATH_MAX_LEN];
     size_t           filesize;
     struct fs_file_t file;
+#ifdef CONFIG_RPR_WRITE_BEHIND
+    struct write_behind_file wb;
+#endif
 #ifdef CONFIG_RPR_HASH_CALCULATION
     struct http_dwn_hash_context dwn_hash_ctx;
 #endif
@@ -100,21 +152,160 @@ struct update_context {
 #ifdef CONFIG_RPR_HASH_CALCULATION
     struct http_dwn_hash_context dwn_hash_ctx;
 #endif
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+    size_t                         received; /* Stream bytes */
+    struct dfu_decompress_context *unpack;   /* update_unpack */
+#endif
+};
+
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+/* One update at a time, the decoder window is too large for a stack */
+static struct dfu_decompress_context update_unpack;
+K_MUTEX_DEFINE(update_unpack_lock);
+#endif
+
+#ifdef CONFIG_RPR_DFU_DELTA
+struct delta_context {
+    size_t                     received; /* Patch bytes */
+    struct dfu_storage_context dfu_ctx;
+    struct dfu_delta_context   delta;
+};
+#endif
+
+#ifdef CONFIG_RPR_HTTP_POOL
+typedef enum {
+    HTTP_POOL_FREE = 0,
+    HTTP_POOL_PREWARM,    /* Queued for the pool thread */
+    HTTP_POOL_CONNECTING, /* Being connected by the pool thread */
+    HTTP_POOL_IDLE,       /* Connected, waiting for a request */
+    HTTP_POOL_BUSY,       /* Used by a request */
+} http_pool_state_t;
+
+struct http_pool_conn {
+    http_pool_state_t state;
+    int               sock;
+    bool              is_tls;
+    char              host[POOL_HOST_MAX_LEN];
+    char              port[POOL_PORT_MAX_LEN];
+    uint32_t          generation; /* Pool generation the socket was made in */
+    int64_t           idle_since;
+    uint32_t          requests; /* Requests served on the connection */
+};
+
+struct http_pool {
+    struct k_mutex        lock;
+    struct k_condvar      changed; /* A pre-warmed connection is ready */
+    struct k_sem          wake;    /* Work for the pool thread */
+    uint32_t              generation; /* Bumped by http_pool_flush() */
+    struct http_pool_conn conn[POOL_SIZE];
+};
+
+static struct http_pool pool = {
+    .lock    = Z_MUTEX_INITIALIZER(pool.lock),
+    .changed = Z_CONDVAR_INITIALIZER(pool.changed),
+    .wake    = Z_SEM_INITIALIZER(pool.wake, 0, 1),
+};
+#endif
+
+#ifdef CONFIG_RPR_HTTP_RESPONSE_HEADERS
+static const char *const http_header_names[HTTP_HDR_COUNT] = {
+    [HTTP_HDR_ETAG]          = "ETag",
+    [HTTP_HDR_LAST_MODIFIED] = "Last-Modified",
+    [HTTP_HDR_CONTENT_RANGE] = "Content-Range",
+    [HTTP_HDR_ACCEPT_RANGES] = "Accept-Ranges",
+};
+#endif
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+struct resume_context {
+    int                        slot;
+    struct http_resume_journal jnl;
+    bool                busy;       /* Slot taken by a transfer */
+    bool                active;     /* Progress is journaled */
+    bool                checked;    /* Status of the response checked */
+    bool                failed;     /* Response does not continue the data */
+    uint32_t            start;      /* Offset asked for, 0 if none */
+    uint32_t            checkpoint; /* Bytes received at the last update */
+    struct http_headers headers;
+    /* Request headers */
+    char        range[HTTP_RANGE_MAX_LEN];
+    char        if_range[HTTP_IF_RANGE_MAX_LEN];
+    const char *req_headers[3];
+};
+
+/* One transfer per slot at a time, each slot has its own journal */
+static struct resume_context resume_ctx[HTTP_RESUME_SLOTS];
+K_MUTEX_DEFINE(resume_slot_lock);
+K_CONDVAR_DEFINE(resume_slot_free);
+#endif
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+struct cache_context {
+    const char                *url;
+    const char                *path;        /* File holding the body */
+    const struct http_headers *hdrs;        /* Headers of the response */
+    bool                       conditional; /* Validators were sent */
+    uint32_t                   size;        /* Size of the cached body */
+    struct http_headers        headers; /* Unless another feature keeps them */
+    /* Body of a GET response being received */
+    struct fs_file_t body;
+    bool             body_open;
+    uint32_t         body_len;
+    char             body_path[HTTP_CACHE_PATH_MAX_LEN];
+    char             temp_path[HTTP_CACHE_PATH_MAX_LEN];
+    /* Request headers */
+    char        if_none_match[HTTP_CONDITIONAL_MAX_LEN];
+    char        if_modified_since[HTTP_CONDITIONAL_MAX_LEN];
+    const char *req_headers[3];
+    /* Validators looked up or stored */
+    struct http_cache_entry entry;
+};
+
+/* Contexts of the cached transfers, too large for a stack */
+K_MEM_SLAB_DEFINE_STATIC(cache_slab,
+                         sizeof(struct cache_context),
+                         CONFIG_RPR_HTTP_CACHE_TRANSFERS,
+                         4);
+#endif
+
+#ifdef CONFIG_RPR_HTTP_TLS_SESSION_CACHE
+#define TLS_SESSION_HOSTS        CONFIG_RPR_HTTP_TLS_SESSION_CACHE_SIZE
+#define TLS_SESSION_HOST_MAX_LEN 64
+
+/* Hosts with a session in the socket layer cache, for the statistics */
+struct tls_session_host {
+    char    host[TLS_SESSION_HOST_MAX_LEN]; /* Empty if unused */
+    int64_t used_ms;
+};
+
+static struct tls_session_host tls_sessions[TLS_SESSION_HOSTS];
+#endif
+
+#ifdef CONFIG_RPR_HTTP_DNS_CACHE
+struct http_dns_entry {
+    char            host[DNS_HOST_MAX_LEN]; /* Empty if unused */
+    bool            resolved;   /* false for a cached failure */
+    bool            refreshing; /* Queued for the DNS thread */
+    struct sockaddr addr;
+    socklen_t       addrlen;
+    int64_t         updated_ms; /* Resolved or failed at */
 };
 
-union http_context_union {
-    struct download_context *download;
-    struct update_context   *update;
-    struct get_context      *get;
-    struct post_context     *post;
+struct http_dns_cache {
+    struct k_mutex        lock;
+    struct k_sem          wake; /* Entries to refresh */
+    struct http_dns_entry entry[DNS_CACHE_SIZE];
 };
 
-struct http_context {
-    http_context_type_t      type;
-    struct url_context       url_context;
-    uint16_t                *http_status_code;
-    union http_context_union ctx;
+static struct http_dns_cache dns_cache = {
+    .lock = Z_MUTEX_INITIALIZER(dns_cache.lock),
+    .wake = Z_SEM_INITIALIZER(dns_cache.wake, 0, 1),
 };
+#endif
+
+struct http_conn_stats            conn_stats;
+static struct http_request_timing last_timing;
+K_MUTEX_DEFINE(http_stats_lock);
 
 #ifdef CONFIG_RPR_HASH_CALCULATION
 
@@ -143,6 +334,30 @@ void print_hash(const unsigned char *p, int len)
 }
 #endif
 
+http_download_callback_t download_callback;
+
+/**
+ * @brief Increments one of the connection counters.
+ *
+ * @param counter Member of conn_stats.
+ */
+void http_stats_count(uint32_t *counter)
+{
+    k_mutex_lock(&http_stats_lock, K_FOREVER);
+    (*counter)++;
+    k_mutex_unlock(&http_stats_lock);
+}
+
+/**
+ * @brief Register a callback for completed file downloads.
+ *
+ * @param cb Callback function, NULL to remove it.
+ */
+void http_register_download_callback(http_download_callback_t cb)
+{
+    download_callback = cb;
+}
+
 /**
  * @brief Logs detailed information from a given addrinfo structure.
  *
@@ -202,6 +417,33 @@ SYS_INIT(http_register_certificates,
          APPLICATION,
          CONFIG_APPLICATION_INIT_PRIORITY);
 
+/**
+ * @brief Constructs the local path of a download from the URL path.
+ *
+ * @param folder   Folder to download into.
+ * @param path     Path part of the URL.
+ * @param filepath Buffer of FULL_FILE_PATH_MAX_LEN to store the path.
+ *
+ * @return HTTP_URL_OK on success, HTTP_ERR_NO_FILENAME if the URL names
+ *         no file.
+ */
+http_status_t
+download_filepath(const char *folder, const char *path, char *filepath)
+{
+    const char *filename = strrchr(path, '/');
+
+    filename = filename ? filename + 1 : path;
+    if (*filename == '\0') {
+        LOG_ERR("Filename could not be determined from URL");
+        return HTTP_ERR_NO_FILENAME;
+    }
+    snprintf(filepath, FULL_FILE_PATH_MAX_LEN, "%s/%s", folder, filename);
+
+    LOG_DBG("Download to: %s", filepath);
+
+    return HTTP_URL_OK;
+}
+
 /**
  * @brief Parses the given URL and fills the HTTP context with its components.
  *
@@ -295,54 +537,284 @@ static http_status_t parse_url(const char *url, struct http_context *http_ctx)
     ctx->path = path_ptr;
 
     if (http_ctx->type == HTTP_CTX_DOWNLOAD) {
-        const char              *filename = strrchr(path_ptr, '/');
-        struct download_context *dl_ctx   = http_ctx->ctx.download;
+        struct download_context *dl_ctx = http_ctx->ctx.download;
+
+        return download_filepath(
+                dl_ctx->folder_path, path_ptr, dl_ctx->filepath);
+    }
+
+    return HTTP_URL_OK;
+}
+
+/**
+ * @brief Resolves a host name with a single getaddrinfo() call.
+ *
+ * @param host    Host name.
+ * @param port    Service, NULL to leave the port 0.
+ * @param addr    Pointer to store the first address found.
+ * @param addrlen Pointer to store the address length.
+ *
+ * @return 0 on success, getaddrinfo() error code otherwise.
+ */
+static int lookup_addr(const char      *host,
+                       const char      *port,
+                       struct sockaddr *addr,
+                       socklen_t       *addrlen)
+{
+    struct addrinfo  hints = { .ai_family   = AF_INET,
+                               .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res   = NULL;
+
+    int ret = getaddrinfo(host, port, &hints, &res);
+    if (ret != 0) {
+        return ret;
+    }
+
+    dbg_print_addrinfo(res);
+
+    *addrlen = MIN(res->ai_addrlen, sizeof(*addr));
+    memcpy(addr, res->ai_addr, *addrlen);
+
+    freeaddrinfo(res);
+    return 0;
+}
+
+#ifdef CONFIG_RPR_HTTP_DNS_CACHE
+/**
+ * @brief Finds the cache entry of a host.
+ *
+ * @param host Host name, the cache lock must be held.
+ *
+ * @return Cache entry, NULL if the host is not cached.
+ */
+static struct http_dns_entry *http_dns_find(const char *host)
+{
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        if (strcmp(dns_cache.entry[i].host, host) == 0) {
+            return &dns_cache.entry[i];
+        }
+    }
+    return NULL;
+}
 
-        filename = filename ? filename + 1 : path_ptr;
-        if (*filename == '\0') {
-            LOG_ERR("Filename could not be determined from URL");
-            return HTTP_ERR_NO_FILENAME;
+/**
+ * @brief Looks up a host in the cache.
+ *
+ * An entry older than the TTL is still returned within the stale window,
+ * and queued for the DNS thread to refresh.
+ *
+ * @param host    Host name.
+ * @param addr    Pointer to store the cached address.
+ * @param addrlen Pointer to store the address length.
+ *
+ * @return 0 on a hit, -EHOSTUNREACH if the last resolution failed within
+ *         the negative TTL, -ENOENT if the host must be resolved.
+ */
+static int
+http_dns_lookup(const char *host, struct sockaddr *addr, socklen_t *addrlen)
+{
+    int  ret     = -ENOENT;
+    bool refresh = false;
+
+    k_mutex_lock(&dns_cache.lock, K_FOREVER);
+
+    struct http_dns_entry *entry = http_dns_find(host);
+
+    if (entry) {
+        int64_t age = k_uptime_get() - entry->updated_ms;
+
+        if (!entry->resolved) {
+            if (age < DNS_NEGATIVE_TTL_MS) {
+                ret = -EHOSTUNREACH;
+                http_stats_count(&conn_stats.dns_negative);
+            }
+        } else if (age < DNS_TTL_MS + DNS_STALE_MS) {
+            memcpy(addr, &entry->addr, entry->addrlen);
+            *addrlen = entry->addrlen;
+            ret      = 0;
+
+            if (age < DNS_TTL_MS) {
+                http_stats_count(&conn_stats.dns_hits);
+            } else {
+                http_stats_count(&conn_stats.dns_stale);
+                refresh           = !entry->refreshing;
+                entry->refreshing = true;
+            }
         }
-        snprintf(dl_ctx->filepath,
-                 FULL_FILE_PATH_MAX_LEN,
-                 "%s/%s",
-                 dl_ctx->folder_path,
-                 filename);
+    }
+
+    k_mutex_unlock(&dns_cache.lock);
 
-        LOG_DBG("Download to: %s", dl_ctx->filepath);
+    if (refresh) {
+        LOG_DBG("Serving stale address of %s, refreshing", host);
+        k_sem_give(&dns_cache.wake);
     }
 
-    return HTTP_URL_OK;
+    return ret;
 }
 
 /**
- * @brief Resolves the remote host and establishes a TCP (or with TLS) socket connection.
+ * @brief Stores the result of a resolution.
  *
- * @param sock       Pointer to the socket file descriptor to be initialized.
- * @param http_ctx   Pointer to the HTTP context containing connection parameters.
+ * Replaces the entry of the host, an unused entry, or the least recently
+ * updated one.
  *
- * @return HTTP_SOCK_OK on success, or a corresponding error code from `http_status_t`
+ * @param host    Host name, not cached if longer than the cache allows.
+ * @param addr    Resolved address, NULL if the resolution failed.
+ * @param addrlen Address length.
+ */
+static void http_dns_store(const char            *host,
+                           const struct sockaddr *addr,
+                           socklen_t              addrlen)
+{
+    if (strlen(host) >= DNS_HOST_MAX_LEN) {
+        return;
+    }
+
+    k_mutex_lock(&dns_cache.lock, K_FOREVER);
+
+    struct http_dns_entry *entry = http_dns_find(host);
+
+    for (int i = 0; i < DNS_CACHE_SIZE && !entry; i++) {
+        if (dns_cache.entry[i].host[0] == '\0') {
+            entry = &dns_cache.entry[i];
+        }
+    }
+
+    bool found = entry != NULL;
+
+    for (int i = 0; i < DNS_CACHE_SIZE && !found; i++) {
+        /* Evict the oldest, unless it is being refreshed */
+        if (!dns_cache.entry[i].refreshing &&
+            (!entry || dns_cache.entry[i].updated_ms < entry->updated_ms)) {
+            entry = &dns_cache.entry[i];
+        }
+    }
+
+    if (entry) {
+        strcpy(entry->host, host);
+        entry->resolved   = addr != NULL;
+        entry->refreshing = false;
+        entry->updated_ms = k_uptime_get();
+        if (addr) {
+            memcpy(&entry->addr, addr, addrlen);
+            entry->addrlen = addrlen;
+        }
+    }
+
+    k_mutex_unlock(&dns_cache.lock);
+}
+
+/**
+ * @brief Drops the cached address of a host that could not be connected.
+ *
+ * The server may have moved, the next connection resolves the host again
+ * instead of using the address until the stale window ends.
+ *
+ * @param host Host name.
  */
-static http_status_t connect_socket(int *sock, struct http_context *http_ctx)
+static void http_dns_forget(const char *host)
 {
+    k_mutex_lock(&dns_cache.lock, K_FOREVER);
 
-    if (!sock || !http_ctx) {
-        LOG_ERR("Invalid arguments for connect socket");
-        return HTTP_ERR_INVALID_PARAM;
+    struct http_dns_entry *entry = http_dns_find(host);
+
+    if (entry && entry->resolved) {
+        entry->host[0]    = '\0';
+        entry->refreshing = false;
+        LOG_DBG("Dropped cached address of %s", host);
     }
 
-    struct url_context *ctx = &http_ctx->url_context;
+    k_mutex_unlock(&dns_cache.lock);
+}
 
-    struct addrinfo hints   = { .ai_family   = AF_INET,
-                                .ai_socktype = SOCK_STREAM };
-    struct timeval  timeout = { .tv_sec = SOCKET_TIMEOUT_MS };
+/**
+ * @brief DNS thread: refreshes the stale entries served by the cache.
+ *
+ * A failed refresh keeps serving the stale address until the stale
+ * window ends.
+ */
+static void http_dns_thread(void *p1, void *p2, void *p3)
+{
+    while (true) {
+        k_sem_take(&dns_cache.wake, K_FOREVER);
+
+        for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+            struct http_dns_entry *entry = &dns_cache.entry[i];
+            char                   host[DNS_HOST_MAX_LEN];
+            struct sockaddr        addr;
+            socklen_t              addrlen;
+
+            k_mutex_lock(&dns_cache.lock, K_FOREVER);
+            bool queued = entry->refreshing;
+            strcpy(host, entry->host);
+            k_mutex_unlock(&dns_cache.lock);
+
+            if (!queued) {
+                continue;
+            }
+
+            int ret = lookup_addr(host, NULL, &addr, &addrlen);
+
+            if (ret == 0) {
+                http_dns_store(host, &addr, addrlen);
+                LOG_DBG("Refreshed address of %s", host);
+            } else {
+                k_mutex_lock(&dns_cache.lock, K_FOREVER);
+                entry->refreshing = false;
+                k_mutex_unlock(&dns_cache.lock);
+                LOG_WRN("Refreshing %s failed: %d", host, ret);
+            }
+        }
+    }
+}
+
+K_THREAD_DEFINE(http_dns_thread_id,
+                CONFIG_RPR_HTTP_DNS_CACHE_THREAD_STACK_SIZE,
+                http_dns_thread,
+                NULL,
+                NULL,
+                NULL,
+                CONFIG_RPR_HTTP_DNS_CACHE_THREAD_PRIORITY,
+                0,
+                0);
+#endif // CONFIG_RPR_HTTP_DNS_CACHE
+
+/**
+ * @brief Resolves the host of a URL.
+ *
+ * With CONFIG_RPR_HTTP_DNS_CACHE, a cached address is used if there is one,
+ * and a recent failure fails at once instead of retrying.
+ *
+ * @param ctx     Parsed URL.
+ * @param addr    Pointer to store the address, with the port of the URL.
+ * @param addrlen Pointer to store the address length.
+ *
+ * @return HTTP_SOCK_OK on success, HTTP_ERR_ADDR_RESOLVE otherwise.
+ */
+static http_status_t resolve_host(const struct url_context *ctx,
+                                  struct sockaddr          *addr,
+                                  socklen_t                *addrlen)
+{
+    int ret = -1;
+
+#ifdef CONFIG_RPR_HTTP_DNS_CACHE
+    ret = http_dns_lookup(ctx->host, addr, addrlen);
+    if (ret == 0) {
+        ((struct sockaddr_in *)addr)->sin_port =
+                htons((uint16_t)strtoul(ctx->port, NULL, 10));
+        return HTTP_SOCK_OK;
+    }
 
-    struct addrinfo *res = NULL;
-    int              ret = -1;
+    if (ret == -EHOSTUNREACH) {
+        LOG_ERR("Unable to resolve address (cached failure)");
+        return HTTP_ERR_ADDR_RESOLVE;
+    }
+#endif
 
     for (int i = 0; i <= RESOLVE_ATTEMPTS; i++) {
 
-        ret = getaddrinfo(ctx->host, ctx->port, &hints, &res);
+        ret = lookup_addr(ctx->host, ctx->port, addr, addrlen);
         if (ret == 0)
             break;
 
@@ -350,27 +822,159 @@ static http_status_t connect_socket(int *sock, struct http_context *http_ctx)
         k_msleep(ADDRINFO_TIMEOUT_MS);
     }
 
+#ifdef CONFIG_RPR_HTTP_DNS_CACHE
+    http_dns_store(ctx->host, ret == 0 ? addr : NULL, *addrlen);
+#endif
+
     if (ret != 0) {
         LOG_ERR("Unable to resolve address");
         return HTTP_ERR_ADDR_RESOLVE;
     }
 
-    dbg_print_addrinfo(res);
+    return HTTP_SOCK_OK;
+}
+
+#ifdef CONFIG_RPR_HTTP_TLS_SESSION_CACHE
+/**
+ * @brief Checks whether a handshake with a host can resume a session.
+ *
+ * @param host Host name.
+ *
+ * @return true if a handshake with the host completed since the last purge.
+ */
+static bool tls_session_known(const char *host)
+{
+    bool known = false;
+
+    k_mutex_lock(&http_stats_lock, K_FOREVER);
+    for (int i = 0; i < TLS_SESSION_HOSTS && !known; i++) {
+        known = strcmp(tls_sessions[i].host, host) == 0;
+    }
+    k_mutex_unlock(&http_stats_lock);
+
+    return known;
+}
+
+/**
+ * @brief Records a completed handshake.
+ *
+ * The socket layer keeps the sessions least recently used first, the same
+ * order is kept here.
+ *
+ * @param host       Host name.
+ * @param resumable  A cached session was offered.
+ * @param connect_ms Time of the TCP connect and the handshake.
+ */
+static void
+tls_session_done(const char *host, bool resumable, uint32_t connect_ms)
+{
+    struct tls_session_host *slot = NULL;
+
+    k_mutex_lock(&http_stats_lock, K_FOREVER);
+
+    if (resumable) {
+        conn_stats.tls_resumed++;
+        conn_stats.tls_resumed_ms += connect_ms;
+    } else {
+        conn_stats.tls_full++;
+        conn_stats.tls_full_ms += connect_ms;
+    }
+
+    for (int i = 0; i < TLS_SESSION_HOSTS && !slot; i++) {
+        if (strcmp(tls_sessions[i].host, host) == 0) {
+            slot = &tls_sessions[i];
+        }
+    }
+
+    for (int i = 0; i < TLS_SESSION_HOSTS && !slot; i++) {
+        if (tls_sessions[i].host[0] == '\0') {
+            slot = &tls_sessions[i];
+        }
+    }
+
+    if (!slot) {
+        slot = &tls_sessions[0];
+        for (int i = 1; i < TLS_SESSION_HOSTS; i++) {
+            if (tls_sessions[i].used_ms < slot->used_ms) {
+                slot = &tls_sessions[i];
+            }
+        }
+    }
+
+    if (strlen(host) < TLS_SESSION_HOST_MAX_LEN) {
+        strcpy(slot->host, host);
+        slot->used_ms = k_uptime_get();
+    }
+
+    k_mutex_unlock(&http_stats_lock);
+}
+
+/**
+ * @brief Drops all cached sessions after a failed handshake.
+ *
+ * A session the server no longer accepts would otherwise be offered again.
+ *
+ * @param sock TLS socket of the failed connect.
+ */
+static void tls_session_purge(int sock)
+{
+    int ret = setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE_PURGE, NULL, 0);
+    if (ret < 0) {
+        LOG_WRN("Failed to purge TLS session cache (%d)", ret);
+    }
+
+    k_mutex_lock(&http_stats_lock, K_FOREVER);
+    memset(tls_sessions, 0, sizeof(tls_sessions));
+    k_mutex_unlock(&http_stats_lock);
+}
+#endif // CONFIG_RPR_HTTP_TLS_SESSION_CACHE
+
+/**
+ * @brief Resolves the remote host and establishes a TCP (or with TLS) socket connection.
+ *
+ * @param sock    Pointer to the socket file descriptor to be initialized.
+ * @param ctx     Pointer to the parsed URL containing connection parameters.
+ * @param timing  Pointer to store the resolution and connect times.
+ *
+ * @return HTTP_SOCK_OK on success, or a corresponding error code from `http_status_t`
+ */
+static http_status_t connect_socket(int                        *sock,
+                                    const struct url_context   *ctx,
+                                    struct http_request_timing *timing)
+{
+
+    if (!sock || !ctx || !timing) {
+        LOG_ERR("Invalid arguments for connect socket");
+        return HTTP_ERR_INVALID_PARAM;
+    }
+
+    struct timeval  timeout = { .tv_sec = SOCKET_TIMEOUT_MS };
+    struct sockaddr addr;
+    socklen_t       addrlen = 0;
+    int             ret     = -1;
+    int64_t         start   = k_uptime_get();
+
+    if (resolve_host(ctx, &addr, &addrlen) != HTTP_SOCK_OK) {
+        return HTTP_ERR_ADDR_RESOLVE;
+    }
+
+    timing->dns_ms = (uint32_t)(k_uptime_get() - start);
+    start          = k_uptime_get();
 
     if (ctx->is_tls) {
 #ifdef CONFIG_NET_SOCKETS_SOCKOPT_TLS
-        *sock = socket(res->ai_family, res->ai_socktype, IPPROTO_TLS_1_2);
+        *sock = socket(addr.sa_family, SOCK_STREAM, IPPROTO_TLS_1_2);
 #else
         LOG_ERR("TLS not supported");
-        goto err_free_addrinfo;
+        return HTTP_ERR_SOCK_CONNECT;
 #endif
     } else {
-        *sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        *sock = socket(addr.sa_family, SOCK_STREAM, IPPROTO_TCP);
     }
 
     if (*sock < 0) {
         LOG_ERR("Failed to create socket (%d)", *sock);
-        goto err_free_addrinfo;
+        return HTTP_ERR_SOCK_CONNECT;
     }
 
     LOG_DBG("Socket is %d", *sock);
@@ -398,6 +1002,21 @@ static http_status_t connect_socket(int *sock, struct http_context *http_ctx)
             LOG_ERR("Failed to set TLS_HOSTNAME (%d)", ret);
             goto err_close_socket;
         }
+
+#ifdef CONFIG_RPR_HTTP_TLS_SESSION_CACHE
+        int session_cache = TLS_SESSION_CACHE_ENABLED;
+
+        ret = setsockopt(*sock,
+                         SOL_TLS,
+                         TLS_SESSION_CACHE,
+                         &session_cache,
+                         sizeof(session_cache));
+        if (ret < 0) {
+            LOG_WRN("Failed to set TLS_SESSION_CACHE (%d)", ret);
+        } else {
+            timing->tls_resumed = tls_session_known(ctx->host);
+        }
+#endif
     }
 #endif
 
@@ -413,46 +1032,1454 @@ static http_status_t connect_socket(int *sock, struct http_context *http_ctx)
         goto err_close_socket;
     }
 
-    ret = connect(*sock, res->ai_addr, res->ai_addrlen);
+    ret = connect(*sock, &addr, addrlen);
     if (ret < 0) {
         LOG_ERR("Cannot connect to remote (%d)", ret);
+#ifdef CONFIG_RPR_HTTP_DNS_CACHE
+        http_dns_forget(ctx->host);
+#endif
+#ifdef CONFIG_RPR_HTTP_TLS_SESSION_CACHE
+        if (ctx->is_tls) {
+            tls_session_purge(*sock);
+        }
+#endif
         goto err_close_socket;
     }
 
-    freeaddrinfo(res);
-    return HTTP_SOCK_OK;
+    timing->connect_ms = (uint32_t)(k_uptime_get() - start);
 
-err_close_socket:
+#ifdef CONFIG_RPR_HTTP_TLS_SESSION_CACHE
+    if (ctx->is_tls) {
+        tls_session_done(ctx->host, timing->tls_resumed, timing->connect_ms);
+    }
+#endif
+
+    k_mutex_lock(&http_stats_lock, K_FOREVER);
+    conn_stats.connects++;
+    conn_stats.setup_ms += timing->dns_ms + timing->connect_ms;
+    k_mutex_unlock(&http_stats_lock);
+
+    return HTTP_SOCK_OK;
+
+err_close_socket:
     close(*sock);
-err_free_addrinfo:
-    freeaddrinfo(res);
     return HTTP_ERR_SOCK_CONNECT;
 }
 
+#ifdef CONFIG_RPR_HTTP_POOL
+/**
+ * @brief Checks whether a pooled connection leads to the host of a URL.
+ *
+ * @param conn Pool slot.
+ * @param ctx  Parsed URL.
+ *
+ * @return true if host, port and scheme are the same.
+ */
+static bool http_pool_match(const struct http_pool_conn *conn,
+                            const struct url_context    *ctx)
+{
+    return conn->is_tls == ctx->is_tls && strcmp(conn->host, ctx->host) == 0 &&
+           strcmp(conn->port, ctx->port) == 0;
+}
+
+/**
+ * @brief Fills a pool slot with the host of a URL.
+ *
+ * @param conn Pool slot, the pool lock must be held.
+ * @param ctx  Parsed URL.
+ *
+ * @return true on success, false if the host name is too long to keep.
+ */
+static bool http_pool_assign(struct http_pool_conn    *conn,
+                             const struct url_context *ctx)
+{
+    if (strlen(ctx->host) >= POOL_HOST_MAX_LEN ||
+        strlen(ctx->port) >= POOL_PORT_MAX_LEN) {
+        return false;
+    }
+
+    strcpy(conn->host, ctx->host);
+    strcpy(conn->port, ctx->port);
+    conn->is_tls     = ctx->is_tls;
+    conn->generation = pool.generation;
+    conn->requests   = 0;
+    return true;
+}
+
+/**
+ * @brief Closes the socket of a pool slot and frees the slot.
+ *
+ * @param conn Pool slot, the pool lock must be held.
+ */
+static void http_pool_close(struct http_pool_conn *conn)
+{
+    LOG_DBG("Closing connection %d to %s:%s",
+            conn->sock,
+            conn->host,
+            conn->port);
+    close(conn->sock);
+    conn->state = HTTP_POOL_FREE;
+}
+
+/**
+ * @brief Takes a kept-alive connection to the host of a URL.
+ *
+ * If the host is being pre-warmed, waits for that connection instead of
+ * opening a second one.
+ *
+ * @param ctx Parsed URL.
+ *
+ * @return Pool slot marked busy, NULL if there is no usable connection.
+ */
+static struct http_pool_conn *http_pool_acquire(const struct url_context *ctx)
+{
+    struct http_pool_conn *found    = NULL;
+    int64_t                deadline = k_uptime_get() + POOL_PREWARM_WAIT_MS;
+
+    k_mutex_lock(&pool.lock, K_FOREVER);
+
+    while (!found) {
+        bool    pending = false;
+        int64_t now     = k_uptime_get();
+
+        for (int i = 0; i < POOL_SIZE; i++) {
+            struct http_pool_conn *conn = &pool.conn[i];
+
+            if (conn->state == HTTP_POOL_FREE ||
+                conn->state == HTTP_POOL_BUSY || !http_pool_match(conn, ctx)) {
+                continue;
+            }
+
+            if (conn->state != HTTP_POOL_IDLE) {
+                pending = true;
+            } else if (now - conn->idle_since >= POOL_IDLE_MS) {
+                http_pool_close(conn);
+                http_stats_count(&conn_stats.expired);
+            } else {
+                conn->state = HTTP_POOL_BUSY;
+                found       = conn;
+                break;
+            }
+        }
+
+        if (found || !pending || now >= deadline) {
+            break;
+        }
+
+        LOG_DBG("Waiting for pre-warmed connection to %s", ctx->host);
+        k_condvar_wait(&pool.changed, &pool.lock, K_MSEC(deadline - now));
+    }
+
+    k_mutex_unlock(&pool.lock);
+    return found;
+}
+
+/**
+ * @brief Puts a new connection into the pool.
+ *
+ * Takes a free slot, or closes the connection idle for the longest time
+ * if all slots are used.
+ *
+ * @param ctx  Parsed URL the socket is connected to.
+ * @param sock Connected socket.
+ *
+ * @return Pool slot marked busy, NULL if the connection is not kept.
+ */
+static struct http_pool_conn *http_pool_claim(const struct url_context *ctx,
+                                              int                       sock)
+{
+    struct http_pool_conn *slot = NULL;
+
+    k_mutex_lock(&pool.lock, K_FOREVER);
+
+    for (int i = 0; i < POOL_SIZE && !slot; i++) {
+        if (pool.conn[i].state == HTTP_POOL_FREE) {
+            slot = &pool.conn[i];
+        }
+    }
+
+    bool have_free = slot != NULL;
+
+    for (int i = 0; i < POOL_SIZE && !have_free; i++) {
+        struct http_pool_conn *conn = &pool.conn[i];
+
+        if (conn->state == HTTP_POOL_IDLE &&
+            (!slot || conn->idle_since < slot->idle_since)) {
+            slot = conn;
+        }
+    }
+
+    if (slot && slot->state == HTTP_POOL_IDLE) {
+        http_pool_close(slot);
+    }
+
+    if (slot && http_pool_assign(slot, ctx)) {
+        slot->sock  = sock;
+        slot->state = HTTP_POOL_BUSY;
+    } else {
+        slot = NULL;
+    }
+
+    k_mutex_unlock(&pool.lock);
+    return slot;
+}
+
+/**
+ * @brief Returns a connection to the pool after a request.
+ *
+ * @param conn Pool slot taken by the request.
+ * @param keep Keep the connection open for the next request.
+ */
+static void http_pool_release(struct http_pool_conn *conn, bool keep)
+{
+    k_mutex_lock(&pool.lock, K_FOREVER);
+
+    conn->requests++;
+
+    if (keep && conn->generation == pool.generation) {
+        conn->state      = HTTP_POOL_IDLE;
+        conn->idle_since = k_uptime_get();
+    } else {
+        http_pool_close(conn);
+    }
+
+    k_mutex_unlock(&pool.lock);
+
+    /* Let the pool thread schedule the idle timeout */
+    k_sem_give(&pool.wake);
+}
+
+/**
+ * @brief Opens the connections queued by http_pool_prewarm().
+ */
+static void http_pool_connect_queued(void)
+{
+    while (true) {
+        struct http_pool_conn     *conn = NULL;
+        struct http_request_timing timing;
+        struct url_context         ctx;
+        int                        sock = -1;
+
+        k_mutex_lock(&pool.lock, K_FOREVER);
+        for (int i = 0; i < POOL_SIZE; i++) {
+            if (pool.conn[i].state == HTTP_POOL_PREWARM) {
+                conn        = &pool.conn[i];
+                conn->state = HTTP_POOL_CONNECTING;
+                break;
+            }
+        }
+        k_mutex_unlock(&pool.lock);
+
+        if (!conn) {
+            return;
+        }
+
+        /* Host and port of a connecting slot are only changed by this thread */
+        ctx.host   = conn->host;
+        ctx.port   = conn->port;
+        ctx.is_tls = conn->is_tls;
+
+        http_status_t status = connect_socket(&sock, &ctx, &timing);
+
+        k_mutex_lock(&pool.lock, K_FOREVER);
+        if (status == HTTP_SOCK_OK && conn->generation == pool.generation) {
+            conn->sock       = sock;
+            conn->state      = HTTP_POOL_IDLE;
+            conn->idle_since = k_uptime_get();
+            http_stats_count(&conn_stats.prewarmed);
+            LOG_INF("Pre-warmed connection to %s:%s (dns %u ms, connect %u ms)",
+                    conn->host,
+                    conn->port,
+                    timing.dns_ms,
+                    timing.connect_ms);
+        } else {
+            if (status == HTTP_SOCK_OK) {
+                close(sock);
+            }
+            conn->state = HTTP_POOL_FREE;
+            LOG_WRN("Pre-warming %s:%s failed", ctx.host, ctx.port);
+        }
+        k_condvar_broadcast(&pool.changed);
+        k_mutex_unlock(&pool.lock);
+    }
+}
+
+/**
+ * @brief Closes the connections that reached the idle timeout.
+ *
+ * @return Time until the next connection times out, K_FOREVER if none.
+ */
+static k_timeout_t http_pool_expire_idle(void)
+{
+    int64_t now  = k_uptime_get();
+    int64_t next = -1;
+
+    k_mutex_lock(&pool.lock, K_FOREVER);
+    for (int i = 0; i < POOL_SIZE; i++) {
+        struct http_pool_conn *conn = &pool.conn[i];
+
+        if (conn->state != HTTP_POOL_IDLE) {
+            continue;
+        }
+
+        int64_t left = conn->idle_since + POOL_IDLE_MS - now;
+
+        if (left <= 0) {
+            LOG_DBG("Connection to %s:%s idle after %u requests",
+                    conn->host,
+                    conn->port,
+                    conn->requests);
+            http_pool_close(conn);
+            http_stats_count(&conn_stats.expired);
+        } else if (next < 0 || left < next) {
+            next = left;
+        }
+    }
+    k_mutex_unlock(&pool.lock);
+
+    return next < 0 ? K_FOREVER : K_MSEC(next);
+}
+
+/**
+ * @brief Pool thread: pre-warms connections and closes idle ones.
+ */
+static void http_pool_thread(void *p1, void *p2, void *p3)
+{
+    k_timeout_t timeout = K_FOREVER;
+
+    while (true) {
+        k_sem_take(&pool.wake, timeout);
+
+        http_pool_connect_queued();
+        timeout = http_pool_expire_idle();
+    }
+}
+
+K_THREAD_DEFINE(http_pool_thread_id,
+                CONFIG_RPR_HTTP_POOL_THREAD_STACK_SIZE,
+                http_pool_thread,
+                NULL,
+                NULL,
+                NULL,
+                CONFIG_RPR_HTTP_POOL_THREAD_PRIORITY,
+                0,
+                0);
+#endif // CONFIG_RPR_HTTP_POOL
+
+/**
+ * @brief Gives up the socket of a request.
+ *
+ * @param sock      Socket of the request.
+ * @param http_ctx  HTTP context of the request.
+ * @param keep      The connection may serve another request.
+ */
+void release_socket(int sock, struct http_context *http_ctx, bool keep)
+{
+#ifdef CONFIG_RPR_HTTP_POOL
+    if (http_ctx->conn) {
+        http_pool_release(http_ctx->conn, keep);
+        http_ctx->conn = NULL;
+        return;
+    }
+#endif
+    close(sock);
+}
+
+#ifdef CONFIG_RPR_HTTP_RESPONSE_HEADERS
+/**
+ * @brief Gets the header store of the request a parser belongs to.
+ *
+ * @param parser Parser of the request.
+ *
+ * @return Header store, NULL if the request keeps no headers.
+ */
+static struct http_headers *http_headers_of_parser(struct http_parser *parser)
+{
+    struct http_request *req =
+            CONTAINER_OF(parser, struct http_request, internal.parser);
+    struct http_context *http_ctx = req->internal.user_data;
+
+    return http_ctx ? http_ctx->headers : NULL;
+}
+
+/**
+ * @brief Collects the name of a response header.
+ *
+ * The parser may deliver a name in several pieces.
+ *
+ * @param parser Parser of the request.
+ * @param at     Piece of the header name.
+ * @param length Length of the piece.
+ *
+ * @return Always 0, to continue parsing.
+ */
+static int
+http_on_header_field(struct http_parser *parser, const char *at, size_t length)
+{
+    struct http_headers *hdrs = http_headers_of_parser(parser);
+
+    if (!hdrs) {
+        return 0;
+    }
+
+    if (hdrs->in_value) {
+        hdrs->in_value  = false;
+        hdrs->field_len = 0;
+    }
+
+    size_t len = MIN(length, sizeof(hdrs->field) - 1 - hdrs->field_len);
+
+    memcpy(&hdrs->field[hdrs->field_len], at, len);
+    hdrs->field_len += len;
+    hdrs->field[hdrs->field_len] = '\0';
+
+    return 0;
+}
+
+/**
+ * @brief Collects the value of a response header listed in
+ *        http_header_names.
+ *
+ * @param parser Parser of the request.
+ * @param at     Piece of the header value.
+ * @param length Length of the piece.
+ *
+ * @return Always 0, to continue parsing.
+ */
+static int
+http_on_header_value(struct http_parser *parser, const char *at, size_t length)
+{
+    struct http_headers *hdrs = http_headers_of_parser(parser);
+
+    if (!hdrs) {
+        return 0;
+    }
+
+    if (!hdrs->in_value) {
+        hdrs->in_value = true;
+        hdrs->header   = HTTP_HDR_NONE;
+
+        for (int i = HTTP_HDR_NONE + 1; i < HTTP_HDR_COUNT; i++) {
+            if (strcasecmp(hdrs->field, http_header_names[i]) == 0) {
+                hdrs->header = i;
+                break;
+            }
+        }
+    }
+
+    if (hdrs->header == HTTP_HDR_NONE) {
+        return 0;
+    }
+
+    char  *value = hdrs->value[hdrs->header];
+    size_t used  = strlen(value);
+    size_t len   = MIN(length, HTTP_HEADER_VALUE_MAX_LEN - 1 - used);
+
+    memcpy(&value[used], at, len);
+    value[used + len] = '\0';
+
+    return 0;
+}
+
+const struct http_parser_settings http_header_settings = {
+    .on_header_field = http_on_header_field,
+    .on_header_value = http_on_header_value,
+};
+
+/**
+ * @brief Gets the validator of a response for If-Range.
+ *
+ * Weak ETags cannot be used with If-Range, the Last-Modified date is taken
+ * instead.
+ *
+ * @param hdrs Response headers.
+ *
+ * @return Strong ETag or Last-Modified date, NULL if there is neither.
+ */
+const char *http_headers_validator(const struct http_headers *hdrs)
+{
+    const char *etag = hdrs->value[HTTP_HDR_ETAG];
+
+    if (etag[0] != '\0' && strncmp(etag, "W/", 2) != 0) {
+        return etag;
+    }
+
+    if (hdrs->value[HTTP_HDR_LAST_MODIFIED][0] != '\0') {
+        return hdrs->value[HTTP_HDR_LAST_MODIFIED];
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Parses the Content-Range header of a 206 response.
+ *
+ * @param hdrs  Response headers.
+ * @param first Pointer to store the offset of the first byte.
+ * @param total Pointer to store the size of the resource, 0 if unknown.
+ *
+ * @return 0 on success, -EINVAL if the header is missing or malformed.
+ */
+int http_headers_range(const struct http_headers *hdrs,
+                       uint32_t                  *first,
+                       uint32_t                  *total)
+{
+    const char *range = hdrs->value[HTTP_HDR_CONTENT_RANGE];
+    const char *space = strchr(range, ' ');
+    const char *slash = strchr(range, '/');
+
+    if (strncasecmp(range, "bytes ", 6) != 0 || !space || !slash) {
+        return -EINVAL;
+    }
+
+    *first = strtoul(space + 1, NULL, 10);
+    *total = slash[1] == '*' ? 0 : strtoul(slash + 1, NULL, 10);
+
+    return 0;
+}
+
+/**
+ * @brief Builds the Range and If-Range headers of a request.
+ *
+ * @param range      Buffer for the Range header.
+ * @param if_range   Buffer for the If-Range header.
+ * @param fields     Array of three header pointers to fill.
+ * @param first      First byte to request.
+ * @param last       Last byte to request, 0 for the rest of the resource.
+ * @param validator  Validator for If-Range, NULL or empty to leave it out.
+ */
+void http_range_headers(char        range[HTTP_RANGE_MAX_LEN],
+                        char        if_range[HTTP_IF_RANGE_MAX_LEN],
+                        const char *fields[3],
+                        uint32_t    first,
+                        uint32_t    last,
+                        const char *validator)
+{
+    int i = 0;
+
+    if (last) {
+        snprintf(range,
+                 HTTP_RANGE_MAX_LEN,
+                 "Range: bytes=%u-%u\r\n",
+                 first,
+                 last);
+    } else {
+        snprintf(range, HTTP_RANGE_MAX_LEN, "Range: bytes=%u-\r\n", first);
+    }
+    fields[i++] = range;
+
+    if (validator && validator[0] != '\0') {
+        snprintf(if_range,
+                 HTTP_IF_RANGE_MAX_LEN,
+                 "If-Range: %s\r\n",
+                 validator);
+        fields[i++] = if_range;
+    }
+
+    fields[i] = NULL;
+}
+#endif // CONFIG_RPR_HTTP_RESPONSE_HEADERS
+
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+/**
+ * @brief Writes decompressed update data to the update slot.
+ *
+ * The hash is taken over the decompressed image, so it matches the image
+ * in the slot whether the download was compressed or not.
+ *
+ * @param data      Image bytes.
+ * @param len       Number of image bytes.
+ * @param user_data Update context of the download.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int update_sink(const uint8_t *data, size_t len, void *user_data)
+{
+    struct update_context *ctx = user_data;
+
+    int ret = dfu_storage_write(&ctx->dfu_ctx, data, len, false);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ctx->filesize += len;
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    mbedtls_sha256_update(&ctx->dwn_hash_ctx.hash_ctx, data, len);
+#endif
+
+    return 0;
+}
+#endif // CONFIG_RPR_DFU_COMPRESSED
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+/**
+ * @brief Picks the journal slot of a file download.
+ *
+ * An idle slot journaling the same transfer is preferred, then an idle slot
+ * without a journal, then any idle slot. Must be called with
+ * resume_slot_lock held.
+ *
+ * @param url       URL of the download.
+ * @param filepath  Destination file.
+ *
+ * @return Slot number, -EBUSY if the download has to wait for a slot.
+ */
+static int resume_pick_slot(const char *url, const char *filepath)
+{
+    struct http_resume_journal jnl;
+    int                        empty = -1;
+    int                        idle  = -1;
+
+    for (int i = 0; i < HTTP_RESUME_FILE_SLOTS; i++) {
+        if (resume_ctx[i].busy) {
+            if (strcmp(resume_ctx[i].jnl.filepath, filepath) == 0) {
+                /* The same file is being written */
+                return -EBUSY;
+            }
+            continue;
+        }
+
+        int ret = http_resume_load(i, &jnl);
+        if (ret == 0 && strcmp(jnl.url, url) == 0 &&
+            strcmp(jnl.filepath, filepath) == 0) {
+            return i;
+        }
+
+        if (ret < 0 && empty < 0) {
+            empty = i;
+        }
+        if (idle < 0) {
+            idle = i;
+        }
+    }
+
+    return empty >= 0 ? empty : (idle >= 0 ? idle : -EBUSY);
+}
+
+/**
+ * @brief Takes a journal slot for a new transfer.
+ *
+ * If the journal of the slot describes an interrupted transfer of the same
+ * URL, and of the same destination file, the transfer continues where it
+ * stopped. Otherwise the journal is dropped and the transfer starts from
+ * zero. Blocks while no slot is free, or while another download writes the
+ * same file.
+ *
+ * @param kind      Transfer kind.
+ * @param url       URL of the transfer.
+ * @param filepath  Destination file, NULL for updates.
+ * @param http_ctx  HTTP context of the transfer.
+ */
+static void resume_begin(http_resume_kind_t   kind,
+                         const char          *url,
+                         const char          *filepath,
+                         struct http_context *http_ctx)
+{
+    struct resume_context *rctx;
+    int                    slot;
+
+    k_mutex_lock(&resume_slot_lock, K_FOREVER);
+
+    while (true) {
+        if (kind == HTTP_RESUME_UPDATE) {
+            slot = resume_ctx[HTTP_RESUME_UPDATE_SLOT].busy
+                           ? -EBUSY
+                           : HTTP_RESUME_UPDATE_SLOT;
+        } else {
+            slot = resume_pick_slot(url, filepath);
+        }
+        if (slot >= 0) {
+            break;
+        }
+        k_condvar_wait(&resume_slot_free, &resume_slot_lock, K_FOREVER);
+    }
+
+    rctx  = &resume_ctx[slot];
+    *rctx = (struct resume_context){
+        .slot   = slot,
+        .busy   = true,
+        .active = true,
+    };
+
+    if (http_resume_load(slot, &rctx->jnl) == 0) {
+        struct http_resume_journal *jnl = &rctx->jnl;
+
+        if (strcmp(jnl->url, url) == 0 &&
+            (!filepath || strcmp(jnl->filepath, filepath) == 0) &&
+            jnl->validator[0] != '\0' && jnl->committed > 0 &&
+            (jnl->total == 0 || jnl->committed < jnl->total)) {
+            rctx->start = jnl->committed;
+        } else {
+            LOG_INF("Dropping the journal of another transfer");
+            http_resume_clear(slot);
+            memset(jnl, 0, sizeof(*jnl));
+        }
+    }
+
+    strncpy(rctx->jnl.url, url, sizeof(rctx->jnl.url) - 1);
+    if (filepath) {
+        strncpy(rctx->jnl.filepath, filepath, sizeof(rctx->jnl.filepath) - 1);
+    }
+
+    k_mutex_unlock(&resume_slot_lock);
+
+    http_ctx->resume  = rctx;
+    http_ctx->headers = &rctx->headers;
+}
+
+/**
+ * @brief Adds the resume headers and callbacks to a request.
+ *
+ * The Range request carries the validator of the journal in If-Range, so a
+ * resource that changed is sent whole with status 200.
+ *
+ * @param rctx Resume context of the transfer.
+ * @param req  Request to send.
+ */
+static void resume_set_request(struct resume_context *rctx,
+                               struct http_request   *req)
+{
+    req->http_cb = &http_header_settings;
+
+    if (!rctx->start) {
+        return;
+    }
+
+    http_range_headers(rctx->range,
+                       rctx->if_range,
+                       rctx->req_headers,
+                       rctx->start,
+                       0,
+                       rctx->jnl.validator);
+    req->header_fields = rctx->req_headers;
+
+    LOG_INF("Resuming transfer at %u bytes", rctx->start);
+}
+
+/**
+ * @brief Continues a file download from the part file.
+ *
+ * The part file is cut back to the journaled size, data written after the
+ * last journal update may not have reached the flash. Must be called after
+ * the hash calculation is started.
+ *
+ * @param http_ctx  HTTP context of the download.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int resume_prepare_file(struct http_context *http_ctx)
+{
+    struct resume_context   *rctx = http_ctx->resume;
+    struct download_context *ctx  = http_ctx->ctx.download;
+    struct fs_dirent         entry;
+    char                     path[HTTP_RESUME_PATH_MAX_LEN];
+
+    http_resume_part_path(rctx->slot, path);
+
+    if (rctx->start &&
+        (fs_stat(path, &entry) < 0 ||
+         entry.size < rctx->start)) {
+        LOG_WRN("Part file is shorter than the journal, starting over");
+        rctx->start = 0;
+    }
+
+    int ret = fs_truncate(&ctx->file, rctx->start);
+    if (ret < 0) {
+        LOG_ERR("Failed to truncate the part file: %d", ret);
+        return ret;
+    }
+
+    ret = fs_seek(&ctx->file, rctx->start, FS_SEEK_SET);
+    if (ret < 0) {
+        LOG_ERR("Failed to seek in the part file: %d", ret);
+        return ret;
+    }
+
+    ctx->filesize = rctx->start;
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    if (rctx->start) {
+        mbedtls_sha256_clone(&ctx->dwn_hash_ctx.hash_ctx, &rctx->jnl.hash);
+    }
+#endif
+
+    return 0;
+}
+
+#ifdef CONFIG_RPR_MODULE_DFU
+/**
+ * @brief Continues an update download in the update image slot.
+ *
+ * The write continues at the flash page of the journaled size. The hash
+ * state is not journaled for updates; the part of the image that is kept
+ * is hashed again from the slot. Must be called after the hash calculation
+ * is started.
+ *
+ * @param http_ctx  HTTP context of the download.
+ * @param buf       Buffer to read the slot with.
+ * @param size      Size of the buffer.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int
+resume_prepare_update(struct http_context *http_ctx, uint8_t *buf, size_t size)
+{
+    struct resume_context *rctx = http_ctx->resume;
+    struct update_context *ctx  = http_ctx->ctx.update;
+    size_t                 offset = rctx->start;
+
+    if (!rctx->start) {
+        return dfu_update_storage_init(&ctx->dfu_ctx);
+    }
+
+    int ret = dfu_update_storage_resume(&ctx->dfu_ctx, &offset);
+    if (ret < 0) {
+        LOG_WRN("Unable to resume the update, starting over");
+        rctx->start = 0;
+        return dfu_update_storage_init(&ctx->dfu_ctx);
+    }
+
+    rctx->start   = offset;
+    ctx->filesize = offset;
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    for (size_t pos = 0; pos < offset; pos += size) {
+        size_t len = MIN(size, offset - pos);
+
+        ret = dfu_update_slot_read(pos, buf, len);
+        if (ret < 0) {
+            return ret;
+        }
+        mbedtls_sha256_update(&ctx->dwn_hash_ctx.hash_ctx, buf, len);
+    }
+#endif
+
+    return 0;
+}
+#endif // CONFIG_RPR_MODULE_DFU
+
+/**
+ * @brief Throws away the data of a transfer that cannot be continued.
+ *
+ * @param http_ctx  HTTP context of the transfer.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int resume_restart(struct http_context *http_ctx)
+{
+    int ret = -EINVAL;
+
+    if (http_ctx->type == HTTP_CTX_DOWNLOAD) {
+        struct download_context *ctx = http_ctx->ctx.download;
+
+#ifdef CONFIG_RPR_WRITE_BEHIND
+        write_behind_flush(&ctx->wb);
+        write_behind_open(&ctx->wb, &ctx->file, 0);
+#endif
+        ret = fs_truncate(&ctx->file, 0);
+        if (ret == 0) {
+            ret = fs_seek(&ctx->file, 0, FS_SEEK_SET);
+        }
+        ctx->filesize = 0;
+#ifdef CONFIG_RPR_HASH_CALCULATION
+        mbedtls_sha256_starts(&ctx->dwn_hash_ctx.hash_ctx, 0);
+#endif
+    }
+#ifdef CONFIG_RPR_MODULE_DFU
+    else if (http_ctx->type == HTTP_CTX_UPDATE) {
+        struct update_context *ctx = http_ctx->ctx.update;
+
+        ret           = dfu_update_storage_init(&ctx->dfu_ctx);
+        ctx->filesize = 0;
+#ifdef CONFIG_RPR_HASH_CALCULATION
+        mbedtls_sha256_starts(&ctx->dwn_hash_ctx.hash_ctx, 0);
+#endif
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+        ctx->received = 0;
+        dfu_decompress_init(ctx->unpack, update_sink, ctx);
+#endif
+    }
+#endif
+
+    return ret;
+}
+
+/**
+ * @brief Checks that a response continues the journaled data.
+ *
+ * Called for every body fragment; the status and headers are checked on
+ * the first one. A 206 response must start at the offset that was asked
+ * for. A 200 response to a Range request means the resource changed, the
+ * data received so far is thrown away. The validator of a 200 response is
+ * taken into the journal, a resource without a strong ETag or a
+ * Last-Modified date cannot be resumed.
+ *
+ * @param http_ctx  HTTP context of the transfer.
+ * @param rsp       Received response fragment.
+ *
+ * @return true to store the fragment, false to drop it.
+ */
+static bool resume_check_body(struct http_context  *http_ctx,
+                              struct http_response *rsp)
+{
+    struct resume_context *rctx = http_ctx->resume;
+
+    rctx->jnl.received += rsp->body_frag_len;
+
+    if (rctx->checked) {
+        return !rctx->failed;
+    }
+
+    rctx->checked = true;
+
+    if (rsp->http_status_code == HTTP_STATUS_PARTIAL) {
+        uint32_t first = 0;
+        uint32_t total = 0;
+
+        if (http_headers_range(&rctx->headers, &first, &total) < 0 ||
+            !rctx->start || first != rctx->start) {
+            LOG_ERR("Unexpected range \"%s\", expected %u",
+                    rctx->headers.value[HTTP_HDR_CONTENT_RANGE],
+                    rctx->start);
+            rctx->failed = true;
+            return false;
+        }
+
+        if (total) {
+            rctx->jnl.total = total;
+        }
+
+        http_stats_count(&conn_stats.resumed);
+        return true;
+    }
+
+    if (rsp->http_status_code != HTTP_STATUS_OK) {
+        rctx->failed = true;
+        return false;
+    }
+
+    if (rctx->start) {
+        LOG_WRN("Resource changed, downloading it from the start");
+        http_stats_count(&conn_stats.restarted);
+        rctx->start = 0;
+
+        if (resume_restart(http_ctx) < 0) {
+            LOG_ERR("Unable to restart the transfer");
+            rctx->failed = true;
+            return false;
+        }
+    }
+
+    rctx->jnl.committed = 0;
+    rctx->jnl.total     = rsp->content_length;
+
+    const char *validator = http_headers_validator(&rctx->headers);
+
+    if (validator) {
+        strncpy(rctx->jnl.validator,
+                validator,
+                sizeof(rctx->jnl.validator) - 1);
+    } else {
+        LOG_INF("No validator in the response, transfer cannot be resumed");
+        rctx->active = false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Stores the progress of a transfer in the journal.
+ *
+ * File data is synced to the flash first; for updates only the data the
+ * image writer has flushed to the slot counts.
+ *
+ * @param http_ctx  HTTP context of the transfer.
+ */
+static void resume_checkpoint(struct http_context *http_ctx)
+{
+    struct resume_context *rctx = http_ctx->resume;
+
+    if (!rctx || !rctx->active || !rctx->checked || rctx->failed) {
+        return;
+    }
+
+    if (http_ctx->type == HTTP_CTX_DOWNLOAD) {
+        struct download_context *ctx = http_ctx->ctx.download;
+
+#ifdef CONFIG_RPR_WRITE_BEHIND
+        if (write_behind_flush(&ctx->wb) < 0) {
+            return;
+        }
+#endif
+
+        int ret = fs_sync(&ctx->file);
+        if (ret < 0) {
+            LOG_WRN("Failed to sync the part file: %d", ret);
+            return;
+        }
+
+        rctx->jnl.committed = ctx->filesize;
+#ifdef CONFIG_RPR_HASH_CALCULATION
+        mbedtls_sha256_clone(&rctx->jnl.hash, &ctx->dwn_hash_ctx.hash_ctx);
+#endif
+    }
+#ifdef CONFIG_RPR_MODULE_DFU
+    else if (http_ctx->type == HTTP_CTX_UPDATE) {
+        struct update_context *ctx = http_ctx->ctx.update;
+
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+        /* Image bytes are no offset into a compressed stream */
+        if (dfu_decompress_is_compressed(ctx->unpack)) {
+            return;
+        }
+#endif
+        rctx->jnl.committed =
+                rctx->start + dfu_storage_bytes_written(&ctx->dfu_ctx);
+    }
+#endif
+
+    rctx->checkpoint = rctx->jnl.received;
+    http_resume_save(rctx->slot, &rctx->jnl);
+}
+
+/**
+ * @brief Ends a journaled transfer and releases its journal slot.
+ *
+ * A completed transfer drops the journal and adds the bytes it received
+ * more than once to the statistics. A transfer that failed on the network
+ * or on a server error keeps the journal for the next attempt; any other
+ * failure drops it. The part file of a dropped file journal is deleted.
+ *
+ * @param http_ctx  HTTP context of the transfer.
+ * @param result    Result of the transfer.
+ * @param size      Size of the completed data.
+ *
+ * @return true if the data received so far is kept for the next attempt.
+ */
+static bool
+resume_end(struct http_context *http_ctx, http_status_t result, size_t size)
+{
+    struct resume_context *rctx = http_ctx->resume;
+    bool                   keep;
+
+    if (result == HTTP_CLIENT_OK) {
+        uint32_t again = rctx->jnl.received > size ? rctx->jnl.received - size
+                                                   : 0;
+
+        k_mutex_lock(&http_stats_lock, K_FOREVER);
+        conn_stats.retransferred += again;
+        k_mutex_unlock(&http_stats_lock);
+
+        if (again) {
+            LOG_INF("Transfer complete, %u bytes received more than once",
+                    again);
+        }
+        keep = false;
+    } else if (result == HTTP_BAD_STATUS_CODE) {
+        /* The resource is gone or the range was refused */
+        keep = *http_ctx->http_status_code >= RESUME_SERVER_ERROR_MIN;
+    } else if (result == HTTP_ERR_DFU_HASH_NOT_MATCH) {
+        keep = false;
+    } else {
+        keep = !rctx->failed;
+    }
+
+    if (keep && rctx->active) {
+        LOG_INF("Transfer journaled at %u of %u bytes",
+                rctx->jnl.committed,
+                rctx->jnl.total);
+    } else {
+        http_resume_clear(rctx->slot);
+        keep = false;
+
+        if (rctx->slot != HTTP_RESUME_UPDATE_SLOT) {
+            char path[HTTP_RESUME_PATH_MAX_LEN];
+
+            /* Before the slot can be taken by the next download */
+            http_resume_part_path(rctx->slot, path);
+            fs_unlink(path);
+        }
+    }
+
+    http_ctx->resume  = NULL;
+    http_ctx->headers = NULL;
+
+    k_mutex_lock(&resume_slot_lock, K_FOREVER);
+    rctx->busy = false;
+    k_condvar_broadcast(&resume_slot_free);
+    k_mutex_unlock(&resume_slot_lock);
+
+    return keep;
+}
+#endif // CONFIG_RPR_HTTP_RESUME
+
+/**
+ * @brief Passes a fragment of a response body to the caller of a GET or
+ *        POST request.
+ *
+ * @param rsp_ctx Response context of the request.
+ * @param data    Fragment of the body.
+ * @param len     Length of the fragment.
+ */
+static void
+get_context_append(struct get_context *rsp_ctx, const uint8_t *data, size_t len)
+{
+    size_t available = rsp_ctx->buffer_capacity - rsp_ctx->response_len;
+
+    if (rsp_ctx->body_cb) {
+        rsp_ctx->body_cb(data, len, rsp_ctx->user_data);
+        rsp_ctx->response_len += len;
+    } else if (available >= len) {
+        memcpy(&rsp_ctx->response_buffer[rsp_ctx->response_len], data, len);
+        rsp_ctx->response_len += len;
+    } else {
+        LOG_WRN("Response buffer overflow, truncating response");
+    }
+}
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+/**
+ * @brief Sets up the cache for a request and makes the request conditional.
+ *
+ * The validators of the URL are sent if its cached copy is the file at
+ * @p path, or for a GET response, the body file of the URL. A request that
+ * already has header fields, such as a resumed download, is sent as it
+ * is. Each request has a context of its own; while
+ * CONFIG_RPR_HTTP_CACHE_TRANSFERS others are running, the request is sent
+ * unconditionally and its response is not cached.
+ *
+ * @param url       URL of the request.
+ * @param path      Destination file of a download, NULL for a GET request.
+ * @param http_ctx  HTTP context of the request.
+ * @param req       Request to send.
+ *
+ * @return Cache context of the request, NULL if none is free.
+ */
+struct cache_context *cache_begin(const char          *url,
+                                  const char          *path,
+                                  struct http_context *http_ctx,
+                                  struct http_request *req)
+{
+    struct cache_context *cctx;
+
+    if (k_mem_slab_alloc(&cache_slab, (void **)&cctx, K_NO_WAIT) != 0) {
+        LOG_INF("No free cache context, %s is not cached", url);
+        return NULL;
+    }
+
+    struct http_cache_entry *entry = &cctx->entry;
+
+    memset(cctx, 0, sizeof(*cctx));
+    cctx->url = url;
+
+    if (!path) {
+        http_cache_body_path(url, cctx->body_path);
+        http_cache_temp_path(cctx->temp_path);
+        path = cctx->body_path;
+
+        fs_file_t_init(&cctx->body);
+        cctx->body_open =
+                http_cache_open_temp(cctx->temp_path, &cctx->body) == 0;
+    }
+    cctx->path = path;
+
+    if (!http_ctx->headers) {
+        http_ctx->headers = &cctx->headers;
+    }
+    cctx->hdrs      = http_ctx->headers;
+    http_ctx->cache = cctx;
+    req->http_cb    = &http_header_settings;
+
+    if (req->header_fields || http_cache_lookup(url, entry) < 0 ||
+        strcmp(entry->path, path) != 0) {
+        return cctx;
+    }
+
+    int i = 0;
+
+    if (entry->etag[0] != '\0') {
+        snprintf(cctx->if_none_match,
+                 HTTP_CONDITIONAL_MAX_LEN,
+                 "If-None-Match: %s\r\n",
+                 entry->etag);
+        cctx->req_headers[i++] = cctx->if_none_match;
+    }
+    if (entry->last_modified[0] != '\0') {
+        snprintf(cctx->if_modified_since,
+                 HTTP_CONDITIONAL_MAX_LEN,
+                 "If-Modified-Since: %s\r\n",
+                 entry->last_modified);
+        cctx->req_headers[i++] = cctx->if_modified_since;
+    }
+    cctx->req_headers[i] = NULL;
+
+    req->header_fields = cctx->req_headers;
+    cctx->conditional  = true;
+    cctx->size         = entry->size;
+
+    return cctx;
+}
+
+/**
+ * @brief Stores a fragment of a GET response body in the cache.
+ *
+ * A body that does not fit CONFIG_RPR_HTTP_CACHE_BODY_MAX_LEN, or cannot
+ * be written, is not cached.
+ *
+ * @param cctx Cache context of the request.
+ * @param rsp  Received response fragment.
+ */
+static void cache_body_write(struct cache_context *cctx,
+                             struct http_response *rsp)
+{
+    if (!cctx->body_open || rsp->http_status_code != HTTP_STATUS_OK) {
+        return;
+    }
+
+    int ret = -EFBIG;
+
+    if (cctx->body_len + rsp->body_frag_len <= CACHE_BODY_MAX_LEN) {
+        ret = fs_write(
+                &cctx->body, rsp->body_frag_start, rsp->body_frag_len);
+    }
+
+    if (ret != rsp->body_frag_len) {
+        LOG_INF("Response to %s is not cached: %d", cctx->url, ret);
+        fs_close(&cctx->body);
+        cctx->body_open = false;
+        return;
+    }
+
+    cctx->body_len += ret;
+}
+
+/**
+ * @brief Stores the validators of a full response in the cache.
+ *
+ * A response without validators drops the URL from the cache.
+ *
+ * @param entry Buffer to build the entry in.
+ * @param url   URL of the request.
+ * @param hdrs  Headers of the response.
+ * @param path  File holding the body.
+ * @param size  Size of the body.
+ */
+static void cache_store(struct http_cache_entry   *entry,
+                        const char                *url,
+                        const struct http_headers *hdrs,
+                        const char                *path,
+                        size_t                     size)
+{
+    memset(entry, 0, sizeof(*entry));
+    strncpy(entry->url, url, sizeof(entry->url) - 1);
+    strncpy(entry->path, path, sizeof(entry->path) - 1);
+    strncpy(entry->etag, hdrs->value[HTTP_HDR_ETAG], sizeof(entry->etag) - 1);
+    strncpy(entry->last_modified,
+            hdrs->value[HTTP_HDR_LAST_MODIFIED],
+            sizeof(entry->last_modified) - 1);
+    entry->size = size;
+
+    if (entry->etag[0] == '\0' && entry->last_modified[0] == '\0') {
+        LOG_DBG("No validator in the response, %s is not cached", url);
+        http_cache_forget(url);
+    } else if (http_cache_store(entry) == 0) {
+        http_cache_count(url, false, 0);
+    }
+}
+
+/**
+ * @brief Stores the validators of a downloaded file in the cache.
+ *
+ * Called once the download callback is done with the file: the size of
+ * the file it leaves, which may have been rewritten, is what a later
+ * lookup checks.
+ *
+ * @param entry Buffer to build the entry in.
+ * @param url   URL of the request.
+ * @param hdrs  Headers of the response.
+ * @param path  Downloaded file.
+ */
+void cache_store_file(struct http_cache_entry   *entry,
+                      const char                *url,
+                      const struct http_headers *hdrs,
+                      const char                *path)
+{
+    struct fs_dirent dirent;
+
+    if (fs_stat(path, &dirent) < 0) {
+        http_cache_forget(url);
+        return;
+    }
+
+    cache_store(entry, url, hdrs, path, dirent.size);
+}
+
+/**
+ * @brief Checks for a 304 Not Modified answer to a conditional request.
+ *
+ * A hit is counted for the URL.
+ *
+ * @param cctx   Cache context of the request.
+ * @param status HTTP status of the response.
+ *
+ * @return true if the cached copy is current.
+ */
+bool cache_not_modified(struct cache_context *cctx, uint16_t status)
+{
+    if (!cctx || !cctx->conditional || status != HTTP_STATUS_NOT_MODIFIED) {
+        return false;
+    }
+
+    LOG_INF("Not modified, %u bytes kept in %s", cctx->size, cctx->path);
+    http_cache_count(cctx->url, true, cctx->size);
+
+    return true;
+}
+
+/**
+ * @brief Caches a GET response that was received in full.
+ *
+ * The body is moved to the body file of the URL.
+ *
+ * @param cctx Cache context of the request.
+ * @param size Size of the body.
+ */
+static void cache_complete(struct cache_context *cctx, size_t size)
+{
+    if (!cctx->body_open || cctx->body_len != size) {
+        http_cache_forget(cctx->url);
+        return;
+    }
+
+    fs_close(&cctx->body);
+    cctx->body_open = false;
+
+    fs_unlink(cctx->body_path);
+    int ret = fs_rename(cctx->temp_path, cctx->body_path);
+    if (ret < 0) {
+        LOG_WRN("Failed to store %s: %d", cctx->body_path, ret);
+        http_cache_forget(cctx->url);
+        return;
+    }
+
+    cache_store(&cctx->entry, cctx->url, cctx->hdrs, cctx->path, size);
+}
+
+/**
+ * @brief Passes the cached body of a GET response to the caller.
+ *
+ * @param cctx    Cache context of the request.
+ * @param get_ctx Response context of the request.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int cache_replay(struct cache_context *cctx, struct get_context *get_ctx)
+{
+    struct fs_file_t file;
+    uint8_t          buf[CACHE_REPLAY_CHUNK];
+
+    fs_file_t_init(&file);
+    int ret = fs_open(&file, cctx->path, FS_O_READ);
+
+    if (ret == 0) {
+        while ((ret = fs_read(&file, buf, sizeof(buf))) > 0) {
+            get_context_append(get_ctx, buf, ret);
+        }
+        fs_close(&file);
+    }
+
+    if (ret < 0) {
+        LOG_ERR("Failed to read %s: %d", cctx->path, ret);
+        http_cache_forget(cctx->url);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Releases the cache context of a request.
+ *
+ * @param http_ctx HTTP context of the request.
+ */
+void cache_end(struct http_context *http_ctx)
+{
+    struct cache_context *cctx = http_ctx->cache;
+
+    if (!cctx) {
+        return;
+    }
+
+    if (cctx->body_open) {
+        fs_close(&cctx->body);
+    }
+    if (cctx->path == cctx->body_path) {
+        fs_unlink(cctx->temp_path);
+    }
+
+    if (http_ctx->headers == &cctx->headers) {
+        http_ctx->headers = NULL;
+    }
+    http_ctx->cache = NULL;
+
+    k_mem_slab_free(&cache_slab, cctx);
+}
+#endif // CONFIG_RPR_HTTP_CACHE
+
 /**
  * @brief HTTP response callback function for handling incoming data fragments.
  * It handles three types of HTTP context: GET, POST, and DOWNLOAD.
  *
  * - For GET and POST: Appends received body fragment to the provided response buffer.
- * - For DOWNLOAD: Writes the received fragment directly to a file via `fs_write()`.
+ * - For DOWNLOAD: Writes the received fragment directly to a file via `fs_write()`,
+ *   or through the flash I/O scheduler when `CONFIG_RPR_FLASH_QOS` is enabled.
+ *   With `CONFIG_RPR_WRITE_BEHIND` the fragment is queued for the writer thread.
  * - For UPDATE: Writes data directly to the DFU (firmware upgrade) storage and updates progress.
+ *   With `CONFIG_RPR_DFU_COMPRESSED` the data goes through the decompressor,
+ *   which writes and hashes the image in update_sink().
+ * - For SEGMENT: Writes the fragment to the file or slot region of the segment.
+ * - For DELTA: Applies the fragment of a delta patch to the update slot.
  *
  * If hash calculation is enabled via `CONFIG_RPR_HASH_CALCULATION`, it updates the SHA-256 digest
  * incrementally for `DOWNLOAD` and `UPDATE` contexts.
  *
+ * With `CONFIG_RPR_HTTP_RESUME`, journaled transfers check the first fragment
+ * against the journal and store their progress every
+ * `CONFIG_RPR_HTTP_RESUME_CHECKPOINT_KB`.
+ *
  * @param rsp         Pointer to the received HTTP response fragment.
  * @param final_data  Indicates if this is the final callback call for the request.
  * @param user_data   Pointer to the associated `http_context` used for request and buffer management.
  */
-static void response_cb(struct http_response *rsp,
-                        enum http_final_call  final_data,
-                        void                 *user_data)
+void response_cb(struct http_response *rsp,
+                 enum http_final_call  final_data,
+                 void                 *user_data)
 {
-    if (!rsp || !user_data || !rsp->body_found)
+    if (!rsp || !user_data)
         return;
 
     struct http_context *http_ctx = user_data;
 
+    if (http_ctx->sent_ms) {
+        http_ctx->timing.response_ms =
+                (uint32_t)(k_uptime_get() - http_ctx->sent_ms);
+        http_ctx->sent_ms = 0;
+    }
+
+    if (!rsp->body_found) {
+        /* Responses without a body, such as 304 Not Modified */
+        if (final_data == HTTP_DATA_FINAL) {
+            *http_ctx->http_status_code = rsp->http_status_code;
+        }
+        return;
+    }
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+    if (http_ctx->resume && !resume_check_body(http_ctx, rsp)) {
+        *http_ctx->http_status_code = rsp->http_status_code;
+        return;
+    }
+#endif
+
     if (http_ctx->type == HTTP_CTX_GET || http_ctx->type == HTTP_CTX_POST) {
 
         struct get_context *rsp_ctx;
@@ -462,21 +2489,28 @@ static void response_cb(struct http_response *rsp,
         } else {
             rsp_ctx = &http_ctx->ctx.post->response;
         }
-        size_t available = rsp_ctx->buffer_capacity - rsp_ctx->response_len;
 
-        if (available >= rsp->body_frag_len) {
-            memcpy(&rsp_ctx->response_buffer[rsp_ctx->response_len],
-                   rsp->body_frag_start,
-                   rsp->body_frag_len);
-            rsp_ctx->response_len += rsp->body_frag_len;
-        } else {
-            LOG_WRN("Response buffer overflow, truncating response");
+        get_context_append(
+                rsp_ctx, rsp->body_frag_start, rsp->body_frag_len);
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+        if (http_ctx->cache) {
+            cache_body_write(http_ctx->cache, rsp);
         }
+#endif
     } else if (http_ctx->type == HTTP_CTX_DOWNLOAD) {
         struct download_context *ctx = http_ctx->ctx.download;
 
+#if defined(CONFIG_RPR_WRITE_BEHIND)
+        int ret = write_behind_write(
+                &ctx->wb, rsp->body_frag_start, rsp->body_frag_len);
+#elif defined(CONFIG_RPR_FLASH_QOS)
+        int ret = flash_qos_write(
+                &ctx->file, rsp->body_frag_start, rsp->body_frag_len);
+#else
         int ret =
                 fs_write(&ctx->file, rsp->body_frag_start, rsp->body_frag_len);
+#endif
 
         if (ret >= 0) {
             ctx->filesize += ret;
@@ -484,14 +2518,23 @@ static void response_cb(struct http_response *rsp,
             LOG_ERR("fs_write failed: %d", ret);
         }
 #ifdef CONFIG_RPR_HASH_CALCULATION
-        mbedtls_md_update(&ctx->dwn_hash_ctx.hash_ctx,
-                          rsp->body_frag_start,
-                          rsp->body_frag_len);
+        mbedtls_sha256_update(&ctx->dwn_hash_ctx.hash_ctx,
+                              rsp->body_frag_start,
+                              rsp->body_frag_len);
 #endif
     } else if (http_ctx->type == HTTP_CTX_UPDATE) {
         struct update_context *ctx = http_ctx->ctx.update;
         int                    ret = -1;
 
+#if defined(CONFIG_RPR_DFU_COMPRESSED)
+        ret = dfu_decompress_write(
+                ctx->unpack, rsp->body_frag_start, rsp->body_frag_len);
+        ctx->received += rsp->body_frag_len;
+
+        if (ret < 0) {
+            LOG_ERR("dfu_decompress_write failed: %d", ret);
+        }
+#else
 #ifdef CONFIG_RPR_MODULE_DFU
         ret = dfu_storage_write(&ctx->dfu_ctx,
                                 rsp->body_frag_start,
@@ -505,13 +2548,41 @@ static void response_cb(struct http_response *rsp,
             LOG_ERR("dfu_storage_write failed: %d", ret);
         }
 #ifdef CONFIG_RPR_HASH_CALCULATION
-        mbedtls_md_update(&ctx->dwn_hash_ctx.hash_ctx,
-                          rsp->body_frag_start,
-                          rsp->body_frag_len);
+        mbedtls_sha256_update(&ctx->dwn_hash_ctx.hash_ctx,
+                              rsp->body_frag_start,
+                              rsp->body_frag_len);
+#endif
+#endif // CONFIG_RPR_DFU_COMPRESSED
+    }
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+    else if (http_ctx->type == HTTP_CTX_SEGMENT) {
+        segment_store(http_ctx->ctx.segment, rsp);
+    }
 #endif
-    } else
+#ifdef CONFIG_RPR_DFU_DELTA
+    else if (http_ctx->type == HTTP_CTX_DELTA) {
+        struct delta_context *ctx = http_ctx->ctx.delta;
+
+        /* An error page is not a patch, the status is checked afterwards */
+        if (rsp->http_status_code == HTTP_STATUS_OK) {
+            dfu_delta_write(
+                    &ctx->delta, rsp->body_frag_start, rsp->body_frag_len);
+            ctx->received += rsp->body_frag_len;
+        }
+    }
+#endif
+    else
         LOG_ERR("Unknown context type in response_cb");
 
+#ifdef CONFIG_RPR_HTTP_RESUME
+    struct resume_context *rctx = http_ctx->resume;
+
+    if (rctx &&
+        rctx->jnl.received - rctx->checkpoint >= RESUME_CHECKPOINT_BYTES) {
+        resume_checkpoint(http_ctx);
+    }
+#endif
+
     *http_ctx->http_status_code = rsp->http_status_code;
 
     if (final_data == HTTP_DATA_FINAL && http_ctx->http_status_code) {
@@ -528,6 +2599,8 @@ static void response_cb(struct http_response *rsp,
  *
  * Parses the provided URL and attempts to connect a socket.
  * This function supports both HTTP and HTTPS connections, based on the scheme in the URL.
+ * With CONFIG_RPR_HTTP_POOL, a kept-alive connection to the same host is taken
+ * instead if there is one.
  *
  * @param url        The full HTTP or HTTPS URL to connect to.
  * @param sock       Pointer to an integer where the connected socket file descriptor will be stored.
@@ -535,7 +2608,7 @@ static void response_cb(struct http_response *rsp,
  *
  * @return HTTP_CLIENT_OK on success, or appropriate `http_status_t` error code on failure.
  */
-static http_status_t
+http_status_t
 setup_http_client(const char *url, int *sock, struct http_context *http_ctx)
 {
     if (!url || !sock || !http_ctx) {
@@ -553,15 +2626,111 @@ setup_http_client(const char *url, int *sock, struct http_context *http_ctx)
         return ret_status;
     }
 
-    ret_status = connect_socket(sock, http_ctx);
+    http_ctx->start_ms = k_uptime_get();
+
+#ifdef CONFIG_RPR_HTTP_POOL
+    http_ctx->conn = http_pool_acquire(&http_ctx->url_context);
+    if (http_ctx->conn) {
+        *sock                   = http_ctx->conn->sock;
+        http_ctx->timing.reused = true;
+        LOG_DBG("Reusing connection %d", *sock);
+        return HTTP_CLIENT_OK;
+    }
+#endif
+
+    ret_status =
+            connect_socket(sock, &http_ctx->url_context, &http_ctx->timing);
     if (ret_status != HTTP_SOCK_OK) {
         LOG_ERR("Failed to connect socket (code %d)", ret_status);
         return ret_status;
     }
+
+#ifdef CONFIG_RPR_HTTP_POOL
+    http_ctx->conn = http_pool_claim(&http_ctx->url_context, *sock);
+#endif
+
     LOG_DBG("HTTP client setup completed successfully");
     return HTTP_CLIENT_OK;
 }
 
+/**
+ * @brief Sends a request on a connection from setup_http_client() and gives
+ *        up the connection.
+ *
+ * The connection is kept for the next request if the response was complete
+ * and the server did not ask to close it. A kept-alive connection that the
+ * server closed in the meantime fails before any response arrives; the
+ * request is then sent again on a new connection. It is not sent again once
+ * a status line or data reached the callbacks, nor if it is a POST, which
+ * the server may have handled already.
+ *
+ * @param sock      Socket returned by setup_http_client().
+ * @param req       Request to send.
+ * @param http_ctx  HTTP context of the request.
+ *
+ * @return Result of http_client_req().
+ */
+int
+send_request(int sock, struct http_request *req, struct http_context *http_ctx)
+{
+    http_ctx->sent_ms = k_uptime_get();
+
+    int ret = http_client_req(sock, req, HTTP_TIMEOUT_MS, http_ctx);
+
+#ifdef CONFIG_RPR_HTTP_POOL
+    if (http_ctx->timing.reused && req->method != HTTP_POST &&
+        req->internal.response.http_status_code == 0 && http_ctx->sent_ms) {
+        LOG_INF("Kept-alive connection closed by server, reconnecting");
+        http_stats_count(&conn_stats.retries);
+        release_socket(sock, http_ctx, false);
+        http_ctx->timing.reused = false;
+
+        if (connect_socket(&sock, &http_ctx->url_context, &http_ctx->timing) !=
+            HTTP_SOCK_OK) {
+            return ret < 0 ? ret : -ENOTCONN;
+        }
+        http_ctx->conn = http_pool_claim(&http_ctx->url_context, sock);
+
+        memset(&req->internal, 0, sizeof(req->internal));
+        http_ctx->sent_ms = k_uptime_get();
+        ret = http_client_req(sock, req, HTTP_TIMEOUT_MS, http_ctx);
+    }
+#endif
+
+    bool keep = ret >= 0 && req->internal.response.message_complete &&
+                http_should_keep_alive(&req->internal.parser);
+
+    release_socket(sock, http_ctx, keep);
+
+    struct http_request_timing *timing = &http_ctx->timing;
+
+    timing->total_ms = (uint32_t)(k_uptime_get() - http_ctx->start_ms);
+
+    k_mutex_lock(&http_stats_lock, K_FOREVER);
+    conn_stats.requests++;
+    if (timing->reused) {
+        conn_stats.reused++;
+        conn_stats.saved_ms +=
+                conn_stats.setup_ms / MAX(conn_stats.connects, 1U);
+    }
+    last_timing = *timing;
+    k_mutex_unlock(&http_stats_lock);
+
+    LOG_INF("%s%s: %s connection, dns %u ms, connect %u ms, "
+            "response %u ms, total %u ms",
+            http_ctx->url_context.host,
+            http_ctx->url_context.path,
+            timing->reused        ? "kept-alive"
+            : timing->tls_resumed ? "resumed TLS"
+                                  : "new",
+            timing->dns_ms,
+            timing->connect_ms,
+            timing->response_ms,
+            timing->total_ms);
+
+    return ret;
+}
+
 /**
  * @brief Downloads a file from the specified HTTP/HTTPS URL and saves it to the local filesystem.
  *
@@ -570,6 +2739,8 @@ setup_http_client(const char *url, int *sock, struct http_context *http_ctx)
  * TLS setup for HTTPS URLs, certificate registration, socket connection, and file creation.
  *
  * If enabled, also computes and prints the SHA-256 hash of the downloaded content.
+ * With CONFIG_RPR_HTTP_RESUME the download is journaled and may continue an
+ * earlier one, see resume_begin().
  *
  * @param url               Full HTTP or HTTPS URL of the file to download.
  * @param base_dir          Base folder path where the file will be saved.
@@ -616,16 +2787,7 @@ http_status_t http_download_file_request(const char *url,
 
 #ifdef CONFIG_RPR_HASH_CALCULATION
     struct http_dwn_hash_context *dwn_hash_ctx = &dl_ctx.dwn_hash_ctx;
-    dwn_hash_ctx->hash_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
-    if (!dwn_hash_ctx->hash_info) {
-        LOG_ERR("Unable to request hash type from mbedTLS");
-    }
-
-    mbedtls_md_init(&dwn_hash_ctx->hash_ctx);
-    if (mbedtls_md_setup(&dwn_hash_ctx->hash_ctx, dwn_hash_ctx->hash_info, 0) <
-        0) {
-        LOG_ERR("Can't setup mbedTLS hash engine");
-    }
+    mbedtls_sha256_init(&dwn_hash_ctx->hash_ctx);
 #endif
 
     uint8_t recv_buf[CONFIG_RPR_HTTP_RECV_BUFFER_SIZE];
@@ -640,52 +2802,171 @@ http_status_t http_download_file_request(const char *url,
         .recv_buf_len = sizeof(recv_buf),
     };
 
+#ifdef CONFIG_RPR_HTTP_RESUME
+    char path[HTTP_RESUME_PATH_MAX_LEN];
+
+    resume_begin(HTTP_RESUME_FILE, url, dl_ctx.filepath, &ctx);
+    http_resume_part_path(ctx.resume->slot, path);
+#else
+    char path[DOWNLOAD_TEMP_PATH_MAX_LEN];
+
+    /* The file is replaced only by a complete download */
+    snprintf(path, sizeof(path), "%s" DOWNLOAD_TEMP_SUFFIX, dl_ctx.filepath);
+#endif
+    int ret;
+
     fs_file_t_init(&dl_ctx.file);
-    if (fs_open(&dl_ctx.file, dl_ctx.filepath, FS_O_CREATE | FS_O_WRITE) < 0) {
-        LOG_ERR("Failed to open file for writing: %s", dl_ctx.filepath);
+#ifdef CONFIG_RPR_HTTP_RESUME
+    ret = http_resume_open_part(ctx.resume->slot, &dl_ctx.file);
+#else
+    fs_unlink(path); /* Left over by a power loss */
+    ret = fs_open(&dl_ctx.file, path, FS_O_CREATE | FS_O_WRITE);
+#endif
+    if (ret < 0) {
+        LOG_ERR("Failed to open file for writing: %s", path);
+        release_socket(sock, &ctx, true);
+#ifdef CONFIG_RPR_HTTP_RESUME
+        resume_end(&ctx, HTTP_ERR_FILE_OPEN, 0);
+#endif
+        return HTTP_ERR_FILE_OPEN;
+    }
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    mbedtls_sha256_starts(&dwn_hash_ctx->hash_ctx, 0);
+#endif
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+    if (resume_prepare_file(&ctx) < 0) {
+        fs_close(&dl_ctx.file);
+        release_socket(sock, &ctx, true);
+        resume_end(&ctx, HTTP_ERR_FILE_OPEN, 0);
         return HTTP_ERR_FILE_OPEN;
     }
 
-#ifdef CONFIG_RPR_HASH_CALCULATION
-    mbedtls_md_starts(&dwn_hash_ctx->hash_ctx);
+    resume_set_request(ctx.resume, &req);
+#endif
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+    cache_begin(url, dl_ctx.filepath, &ctx, &req);
+#endif
+
+#ifdef CONFIG_RPR_WRITE_BEHIND
+    write_behind_open(&dl_ctx.wb, &dl_ctx.file, dl_ctx.filesize);
 #endif
 
     LOG_INF("Starting file download...");
 
     *http_status_code = INTERNAL_SERVER_ERROR;
 
-    int ret = http_client_req(sock, &req, HTTP_TIMEOUT_MS, &ctx);
-    close(sock);
+    ret = send_request(sock, &req, &ctx);
+
+#ifdef CONFIG_RPR_WRITE_BEHIND
+    int wb_ret = write_behind_flush(&dl_ctx.wb);
+    if (wb_ret < 0) {
+        LOG_ERR("Failed to write the download: %d", wb_ret);
+        ret = ret < 0 ? ret : wb_ret;
+    }
+#endif
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+    if (ret < 0) {
+        resume_checkpoint(&ctx);
+    }
+#endif
+
     fs_close(&dl_ctx.file);
 
 #ifdef CONFIG_RPR_HASH_CALCULATION
-    mbedtls_md_finish(&dwn_hash_ctx->hash_ctx, dwn_hash_ctx->response_hash);
-    mbedtls_md_free(&dwn_hash_ctx->hash_ctx);
+    mbedtls_sha256_finish(&dwn_hash_ctx->hash_ctx, dwn_hash_ctx->response_hash);
+    mbedtls_sha256_free(&dwn_hash_ctx->hash_ctx);
+#endif
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+    if (ret >= 0 && cache_not_modified(ctx.cache, *http_status_code)) {
+        /* Nothing was written, the file is kept as it is */
+        cache_end(&ctx);
+#ifdef CONFIG_RPR_HTTP_RESUME
+        resume_end(&ctx, HTTP_CLIENT_OK, 0);
+#else
+        fs_unlink(path);
+#endif
+        LOG_INF("File not modified: %s", dl_ctx.filepath);
+        return HTTP_CLIENT_OK;
+    }
 #endif
 
     if (ret < 0) {
         LOG_ERR("HTTP client request failed with code %d", ret);
-        fs_unlink(dl_ctx.filepath);
+#ifdef CONFIG_RPR_HTTP_CACHE
+        cache_end(&ctx);
+#endif
+#ifdef CONFIG_RPR_HTTP_RESUME
+        resume_end(&ctx, HTTP_ERR_CLIENT_REQUEST, 0);
+#else
+        fs_unlink(path);
+#endif
         return HTTP_ERR_CLIENT_REQUEST;
     }
 
-    if (*http_status_code != HTTP_STATUS_OK) {
+    bool status_ok = *http_status_code == HTTP_STATUS_OK;
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+    status_ok = (status_ok || *http_status_code == HTTP_STATUS_PARTIAL) &&
+                !ctx.resume->failed;
+#endif
+
+    if (!status_ok) {
         if (*http_status_code == INTERNAL_SERVER_ERROR)
             LOG_WRN("Unexpected internal server error: %d", *http_status_code);
         else
             LOG_WRN("Unexpected HTTP status: %d", *http_status_code);
 
-        fs_unlink(dl_ctx.filepath);
+#ifdef CONFIG_RPR_HTTP_CACHE
+        cache_end(&ctx);
+#endif
+#ifdef CONFIG_RPR_HTTP_RESUME
+        resume_end(&ctx, HTTP_BAD_STATUS_CODE, 0);
+#else
+        fs_unlink(path);
+#endif
         return HTTP_BAD_STATUS_CODE;
     }
 
+    /* Replaces the old file, which is kept if the download fails */
+    ret = fs_rename(path, dl_ctx.filepath);
+#ifdef CONFIG_RPR_HTTP_RESUME
+    /* Drops the part file if it could not be moved */
+    resume_end(&ctx, HTTP_CLIENT_OK, dl_ctx.filesize);
+#endif
+    if (ret < 0) {
+        LOG_ERR("Failed to move the download to %s: %d", dl_ctx.filepath, ret);
+#ifndef CONFIG_RPR_HTTP_RESUME
+        fs_unlink(path);
+#endif
+#ifdef CONFIG_RPR_HTTP_CACHE
+        cache_end(&ctx);
+#endif
+        return HTTP_ERR_FILE_OPEN;
+    }
+
     LOG_INF("Download complete. Size: %u Bytes (%u KiB)",
             dl_ctx.filesize,
             bytes2KiB(dl_ctx.filesize));
 
 #ifdef CONFIG_RPR_HASH_CALCULATION
-    int mbedtls_hash_len = mbedtls_md_get_size(dwn_hash_ctx->hash_info);
-    print_hash(dwn_hash_ctx->response_hash, mbedtls_hash_len);
+    print_hash(dwn_hash_ctx->response_hash, HASH_SIZE_MAX_LEN);
+#endif
+
+    if (download_callback) {
+        download_callback(dl_ctx.filepath);
+    }
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+    if (ctx.cache) {
+        cache_store_file(
+                &ctx.cache->entry, url, ctx.cache->hdrs, dl_ctx.filepath);
+    }
+    cache_end(&ctx);
 #endif
 
     return HTTP_CLIENT_OK;
@@ -696,6 +2977,10 @@ http_status_t http_download_file_request(const char *url,
  *
  * This function performs a GET request using the provided `url` and writes the response body
  * into the buffer defined in `get_ctx`. The HTTP status code is written to `http_status_code`.
+ * If `body_cb` is set in `get_ctx`, the body is passed to it fragment by fragment instead and
+ * no buffer is needed, so a response of any length can be parsed as it arrives.
+ * With CONFIG_RPR_HTTP_CACHE and `cache` set in `get_ctx`, the request is conditional; on
+ * 304 Not Modified the cached body is passed as if received and the status code is 304.
  *
  * @param url               The target HTTP or HTTPS URL.
  * @param get_ctx           Pointer to a get_context structure containing the buffer and its size.
@@ -708,8 +2993,9 @@ http_status_t http_get_request(const char         *url,
                                uint16_t           *http_status_code)
 {
 
-    if (!url || !get_ctx || !get_ctx->response_buffer || !http_status_code ||
-        get_ctx->buffer_capacity == 0) {
+    if (!url || !get_ctx || !http_status_code ||
+        (!get_ctx->body_cb &&
+         (!get_ctx->response_buffer || get_ctx->buffer_capacity == 0))) {
         LOG_ERR("Invalid arguments for GET request");
         return HTTP_ERR_INVALID_PARAM;
     }
@@ -743,16 +3029,44 @@ http_status_t http_get_request(const char         *url,
         .recv_buf_len = sizeof(recv_buf),
     };
 
+#ifdef CONFIG_RPR_HTTP_CACHE
+    struct cache_context *cache        = NULL;
+    bool                  not_modified = false;
+
+    if (get_ctx->cache) {
+        cache = cache_begin(url, NULL, &ctx, &req);
+    }
+#endif
+
     LOG_INF("Sending GET request...");
     *http_status_code = INTERNAL_SERVER_ERROR;
-    int ret           = http_client_req(sock, &req, HTTP_TIMEOUT_MS, &ctx);
-    close(sock);
+    int ret           = send_request(sock, &req, &ctx);
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+    if (cache) {
+        if (ret >= 0 && *http_status_code == HTTP_STATUS_OK) {
+            cache_complete(cache, get_ctx->response_len);
+        } else if (ret >= 0 && cache_not_modified(cache, *http_status_code)) {
+            not_modified = true;
+            ret          = cache_replay(cache, get_ctx);
+        }
+        cache_end(&ctx);
+    }
+#endif
 
     if (ret < 0) {
         LOG_ERR("HTTP GET failed: %d", ret);
         return HTTP_ERR_CLIENT_REQUEST;
     }
 
+#ifdef CONFIG_RPR_HTTP_CACHE
+    if (not_modified) {
+        LOG_INF("GET request not modified. Passed %zu cached bytes.",
+                get_ctx->response_len);
+        return HTTP_CLIENT_OK;
+    }
+#endif
+
     if (*http_status_code != HTTP_STATUS_OK) {
         if (*http_status_code == INTERNAL_SERVER_ERROR)
             LOG_WRN("Unexpected internal server error: %d", *http_status_code);
@@ -828,8 +3142,7 @@ http_status_t http_post_request(const char          *url,
 
     *http_status_code = INTERNAL_SERVER_ERROR;
 
-    int ret = http_client_req(sock, &req, HTTP_TIMEOUT_MS, &ctx);
-    close(sock);
+    int ret = send_request(sock, &req, &ctx);
 
     if (ret < 0) {
         LOG_ERR("HTTP POST failed: %d", ret);
@@ -853,32 +3166,24 @@ http_status_t http_post_request(const char          *url,
 
 #ifdef CONFIG_RPR_MODULE_DFU
 /**
- * @brief Download and flash a firmware update via HTTP(S).
- *
- * Performs an HTTP GET request to download a firmware image from the specified
- * URL and writes the data directly into the device's DFU (Device Firmware Upgrade)
- * flash partition. Optionally computes the SHA-256 hash of the downloaded image and
- * verifies it against the hash of the flashed image if integrity check is enabled.
+ * @brief Downloads and flashes a firmware update, see
+ *        http_download_update_request().
  *
  * @param url               Full HTTP or HTTPS URL of the file to download.
  * @param http_status_code  Pointer to store the HTTP response status code.
  *
  * @return HTTP_CLIENT_OK on success, or an appropriate `http_status_t` error code on failure.
  */
-http_status_t http_download_update_request(const char *url,
-                                           uint16_t   *http_status_code)
+static http_status_t update_request(const char *url, uint16_t *http_status_code)
 {
-
-    if (!url || !http_status_code) {
-        LOG_ERR("Invalid arguments for download UPDATE request");
-        return HTTP_ERR_INVALID_PARAM;
-    }
-
     http_status_t ret_status;
     int           sock = -1;
 
     struct update_context upd_ctx = {
         .filesize = 0,
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+        .unpack   = &update_unpack,
+#endif
     };
 
     struct http_context ctx = {
@@ -897,16 +3202,8 @@ http_status_t http_download_update_request(const char *url,
 
 #ifdef CONFIG_RPR_HASH_CALCULATION
     struct http_dwn_hash_context *dwn_hash_ctx = &upd_ctx.dwn_hash_ctx;
-    dwn_hash_ctx->hash_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
-    if (!dwn_hash_ctx->hash_info) {
-        LOG_ERR("Unable to request hash type from mbedTLS");
-    }
-
-    mbedtls_md_init(&dwn_hash_ctx->hash_ctx);
-    if (mbedtls_md_setup(&dwn_hash_ctx->hash_ctx, dwn_hash_ctx->hash_info, 0) <
-        0) {
-        LOG_ERR("Can't setup mbedTLS hash engine");
-    }
+    mbedtls_sha256_init(&dwn_hash_ctx->hash_ctx);
+    mbedtls_sha256_starts(&dwn_hash_ctx->hash_ctx, 0);
 #endif
 
     uint8_t recv_buf[CONFIG_RPR_HTTP_RECV_BUFFER_SIZE];
@@ -921,49 +3218,119 @@ http_status_t http_download_update_request(const char *url,
         .recv_buf_len = sizeof(recv_buf),
     };
 
+#ifdef CONFIG_RPR_HTTP_RESUME
+    resume_begin(HTTP_RESUME_UPDATE, url, NULL, &ctx);
+
+    int ret = resume_prepare_update(&ctx, recv_buf, sizeof(recv_buf));
+#else
     int ret = dfu_update_storage_init(&upd_ctx.dfu_ctx);
+#endif
 
     if (ret) {
         LOG_ERR("Unable init flash storage: %d", ret);
+        release_socket(sock, &ctx, true);
+#ifdef CONFIG_RPR_HTTP_RESUME
+        resume_end(&ctx, HTTP_ERR_DFU_INIT, 0);
+#endif
+#ifdef CONFIG_RPR_HASH_CALCULATION
+        mbedtls_sha256_free(&dwn_hash_ctx->hash_ctx);
+#endif
         return HTTP_ERR_DFU_INIT;
     }
 
-#ifdef CONFIG_RPR_HASH_CALCULATION
-    mbedtls_md_starts(&dwn_hash_ctx->hash_ctx);
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+    dfu_decompress_init(upd_ctx.unpack, update_sink, &upd_ctx);
+#endif
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+    resume_set_request(ctx.resume, &req);
 #endif
 
     LOG_INF("Starting update download...");
 
     *http_status_code = INTERNAL_SERVER_ERROR;
 
-    ret = http_client_req(sock, &req, HTTP_TIMEOUT_MS, &ctx);
+    ret = send_request(sock, &req, &ctx);
+
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+    /* The tail of the image is still in the window of the decoder */
+    int unpack_ret = 0;
+
+    if (ret >= 0) {
+        unpack_ret = dfu_decompress_finish(upd_ctx.unpack);
+        if (unpack_ret == 0) {
+            unpack_ret = dfu_storage_write(&upd_ctx.dfu_ctx, NULL, 0, true);
+        }
+    }
+#endif
 
 #ifdef CONFIG_RPR_HASH_CALCULATION
-    mbedtls_md_finish(&dwn_hash_ctx->hash_ctx, dwn_hash_ctx->response_hash);
-    mbedtls_md_free(&dwn_hash_ctx->hash_ctx);
+    mbedtls_sha256_finish(&dwn_hash_ctx->hash_ctx, dwn_hash_ctx->response_hash);
+    mbedtls_sha256_free(&dwn_hash_ctx->hash_ctx);
 #endif
 
     if (ret < 0) {
         LOG_ERR("HTTP client request failed with code %d", ret);
+#ifdef CONFIG_RPR_HTTP_RESUME
+        resume_checkpoint(&ctx);
+        resume_end(&ctx, HTTP_ERR_CLIENT_REQUEST, 0);
+#endif
         return HTTP_ERR_CLIENT_REQUEST;
     }
 
-    if (*http_status_code != HTTP_STATUS_OK) {
+    bool status_ok = *http_status_code == HTTP_STATUS_OK;
+
+#ifdef CONFIG_RPR_HTTP_RESUME
+    status_ok = (status_ok || *http_status_code == HTTP_STATUS_PARTIAL) &&
+                !ctx.resume->failed;
+#endif
+
+    if (!status_ok) {
         if (*http_status_code == INTERNAL_SERVER_ERROR)
             LOG_WRN("Unexpected internal server error: %d", *http_status_code);
         else
             LOG_WRN("Unexpected HTTP status: %d", *http_status_code);
 
+#ifdef CONFIG_RPR_HTTP_RESUME
+        resume_end(&ctx, HTTP_BAD_STATUS_CODE, 0);
+#endif
         return HTTP_BAD_STATUS_CODE;
     }
 
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+    if (unpack_ret < 0) {
+        LOG_ERR("Unable to decompress the update: %d", unpack_ret);
+#ifdef CONFIG_RPR_HTTP_RESUME
+        resume_end(&ctx, HTTP_ERR_DFU_HASH_NOT_MATCH, 0);
+#endif
+        return HTTP_ERR_DFU_HASH_NOT_MATCH;
+    }
+
+    if (dfu_decompress_is_compressed(upd_ctx.unpack)) {
+        LOG_INF("Compressed update: %u Bytes received for %u Bytes of image "
+                "(%u%%) in %u ms, decoder RAM %u Bytes",
+                (uint32_t)upd_ctx.received,
+                (uint32_t)upd_ctx.filesize,
+                (uint32_t)(upd_ctx.received * 100 /
+                           MAX(upd_ctx.filesize, 1)),
+                ctx.timing.total_ms,
+                (uint32_t)sizeof(*upd_ctx.unpack));
+
+        k_mutex_lock(&http_stats_lock, K_FOREVER);
+        conn_stats.packed_updates++;
+        conn_stats.packed_bytes += upd_ctx.received;
+        conn_stats.packed_image += upd_ctx.filesize;
+        conn_stats.packed_ms += ctx.timing.total_ms;
+        k_mutex_unlock(&http_stats_lock);
+    }
+#endif
+
     LOG_INF("Download update complete. Size: %u Bytes (%u KiB)",
             upd_ctx.filesize,
             bytes2KiB(upd_ctx.filesize));
 
 #ifdef CONFIG_RPR_HASH_CALCULATION
-    int mbedtls_hash_len = mbedtls_md_get_size(dwn_hash_ctx->hash_info);
-    print_hash(dwn_hash_ctx->response_hash, mbedtls_hash_len);
+    print_hash(dwn_hash_ctx->response_hash, HASH_SIZE_MAX_LEN);
 
 #ifdef CONFIG_RPR_IMAGE_INTEGRITY_CHECK
 
@@ -973,12 +3340,297 @@ http_status_t http_download_update_request(const char *url,
     if (ret < 0) {
         LOG_ERR("The hash of the flashed and downloaded images do not match! %d",
                 ret);
+#ifdef CONFIG_RPR_HTTP_RESUME
+        resume_end(&ctx, HTTP_ERR_DFU_HASH_NOT_MATCH, 0);
+#endif
         return HTTP_ERR_DFU_HASH_NOT_MATCH;
     }
 
 #endif // CONFIG_RPR_IMAGE_INTEGRITY_CHECK
 #endif // CONFIG_RPR_HASH_CALCULATION
 
+#ifdef CONFIG_RPR_HTTP_RESUME
+    resume_end(&ctx, HTTP_CLIENT_OK, upd_ctx.filesize);
+#endif
+
+    return HTTP_CLIENT_OK;
+}
+
+/**
+ * @brief Download and flash a firmware update via HTTP(S).
+ *
+ * Performs an HTTP GET request to download a firmware image from the specified
+ * URL and writes the data directly into the device's DFU (Device Firmware Upgrade)
+ * flash partition. Optionally computes the SHA-256 hash of the downloaded image and
+ * verifies it against the hash of the flashed image if integrity check is enabled.
+ * With CONFIG_RPR_HTTP_RESUME the download is journaled and may continue an
+ * earlier one, see resume_begin().
+ * With CONFIG_RPR_DFU_COMPRESSED the image may also be compressed by
+ * script/generate_compressed.py; it is decompressed while it is received
+ * and the hash is taken over the decompressed image. A compressed download
+ * is not checkpointed, it restarts from zero.
+ *
+ * @param url               Full HTTP or HTTPS URL of the file to download.
+ * @param http_status_code  Pointer to store the HTTP response status code.
+ *
+ * @return HTTP_CLIENT_OK on success, or an appropriate `http_status_t` error code on failure.
+ */
+http_status_t http_download_update_request(const char *url,
+                                           uint16_t   *http_status_code)
+{
+    if (!url || !http_status_code) {
+        LOG_ERR("Invalid arguments for download UPDATE request");
+        return HTTP_ERR_INVALID_PARAM;
+    }
+
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+    k_mutex_lock(&update_unpack_lock, K_FOREVER);
+#endif
+
+    http_status_t ret_status = update_request(url, http_status_code);
+
+#ifdef CONFIG_RPR_DFU_COMPRESSED
+    k_mutex_unlock(&update_unpack_lock);
+#endif
+
+    return ret_status;
+}
+
+#ifdef CONFIG_RPR_DFU_DELTA
+/**
+ * @brief Downloads a delta patch and applies it to the update slot.
+ *
+ * The patch is applied while it is received: the running image is read
+ * from slot0 and the rebuilt image is written to slot1, then checked
+ * against the target hash of the patch with dfu_update_flash_img_check().
+ * Delta downloads are not journaled for CONFIG_RPR_HTTP_RESUME.
+ *
+ * @param url               Full HTTP or HTTPS URL of the patch.
+ * @param http_status_code  Pointer to store the HTTP response status code.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_ERR_DFU_INIT if the patch is not
+ *         made for the running image or is malformed, or another
+ *         `http_status_t` error code on failure.
+ */
+http_status_t http_download_update_delta(const char *url,
+                                         uint16_t   *http_status_code)
+{
+    if (!url || !http_status_code) {
+        LOG_ERR("Invalid arguments for download DELTA request");
+        return HTTP_ERR_INVALID_PARAM;
+    }
+
+    http_status_t ret_status;
+    int           sock = -1;
+
+    struct delta_context dl_ctx = {
+        .received = 0,
+    };
+
+    struct http_context ctx = {
+        .type             = HTTP_CTX_DELTA,
+        .http_status_code = http_status_code,
+        .ctx.delta        = &dl_ctx,
+    };
+
+    ret_status = setup_http_client(url, &sock, &ctx);
+
+    if (ret_status != HTTP_CLIENT_OK) {
+        LOG_ERR("HTTP setup failed (code %d)", ret_status);
+        return ret_status;
+    }
+
+    int ret = dfu_update_storage_init(&dl_ctx.dfu_ctx);
+
+    if (ret == 0) {
+        ret = dfu_delta_init(&dl_ctx.delta, &dl_ctx.dfu_ctx);
+    }
+
+    if (ret) {
+        LOG_ERR("Unable init flash storage: %d", ret);
+        release_socket(sock, &ctx, true);
+        return HTTP_ERR_DFU_INIT;
+    }
+
+    uint8_t recv_buf[CONFIG_RPR_HTTP_RECV_BUFFER_SIZE];
+
+    struct http_request req = {
+        .method       = HTTP_GET,
+        .url          = ctx.url_context.path,
+        .host         = ctx.url_context.host,
+        .protocol     = "HTTP/1.1",
+        .response     = response_cb,
+        .recv_buf     = recv_buf,
+        .recv_buf_len = sizeof(recv_buf),
+    };
+
+    LOG_INF("Starting delta update download...");
+
+    *http_status_code = INTERNAL_SERVER_ERROR;
+
+    ret = send_request(sock, &req, &ctx);
+
+    if (ret < 0) {
+        LOG_ERR("HTTP client request failed with code %d", ret);
+        dfu_delta_finish(&dl_ctx.delta);
+        return HTTP_ERR_CLIENT_REQUEST;
+    }
+
+    if (*http_status_code != HTTP_STATUS_OK) {
+        LOG_WRN("Unexpected HTTP status: %d", *http_status_code);
+        dfu_delta_finish(&dl_ctx.delta);
+        return HTTP_BAD_STATUS_CODE;
+    }
+
+    ret = dfu_delta_finish(&dl_ctx.delta);
+
+    if (ret == -EBADMSG || ret == -ESTALE) {
+        return HTTP_ERR_DFU_INIT;
+    } else if (ret < 0) {
+        LOG_ERR("The rebuilt image does not match the patch! %d", ret);
+        return HTTP_ERR_DFU_HASH_NOT_MATCH;
+    }
+
+    size_t image = dfu_storage_bytes_written(&dl_ctx.dfu_ctx);
+
+    LOG_INF("Delta update complete. Patch: %u Bytes, image: %u Bytes (%u%%)",
+            (uint32_t)dl_ctx.received,
+            (uint32_t)image,
+            (uint32_t)(dl_ctx.received * 100 / MAX(image, 1)));
+
+    k_mutex_lock(&http_stats_lock, K_FOREVER);
+    conn_stats.delta_updates++;
+    conn_stats.delta_bytes += dl_ctx.received;
+    conn_stats.delta_image += image;
+    k_mutex_unlock(&http_stats_lock);
+
     return HTTP_CLIENT_OK;
 }
+#endif // CONFIG_RPR_DFU_DELTA
 #endif //CONFIG_RPR_MODULE_DFU
+
+
+/**
+ * @brief Gets the timings of the last completed request.
+ *
+ * @param timing Pointer to store the timings.
+ */
+void http_get_last_timing(struct http_request_timing *timing)
+{
+    if (!timing) {
+        return;
+    }
+
+    k_mutex_lock(&http_stats_lock, K_FOREVER);
+    *timing = last_timing;
+    k_mutex_unlock(&http_stats_lock);
+}
+
+/**
+ * @brief Gets the connection statistics of the module.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void http_get_conn_stats(struct http_conn_stats *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    k_mutex_lock(&http_stats_lock, K_FOREVER);
+    *stats = conn_stats;
+    k_mutex_unlock(&http_stats_lock);
+
+    stats->open = 0;
+
+#ifdef CONFIG_RPR_HTTP_POOL
+    k_mutex_lock(&pool.lock, K_FOREVER);
+    for (int i = 0; i < POOL_SIZE; i++) {
+        if (pool.conn[i].state == HTTP_POOL_IDLE ||
+            pool.conn[i].state == HTTP_POOL_BUSY) {
+            stats->open++;
+        }
+    }
+    k_mutex_unlock(&pool.lock);
+#endif
+}
+
+#ifdef CONFIG_RPR_HTTP_POOL
+/**
+ * @brief Opens a connection to the host of a URL ahead of the first request.
+ *
+ * @param url HTTP or HTTPS URL, only the host, port and scheme are used.
+ *
+ * @return 0 if queued, -EALREADY if the host already has a connection,
+ *         -ENOMEM if the pool is full, -EINVAL if the URL is invalid.
+ */
+int http_pool_prewarm(const char *url)
+{
+    struct http_context http_ctx = { .type = HTTP_CTX_NONE };
+
+    if (!url || parse_url(url, &http_ctx) != HTTP_URL_OK) {
+        return -EINVAL;
+    }
+
+    struct http_pool_conn *slot = NULL;
+    int                    ret  = -ENOMEM;
+
+    k_mutex_lock(&pool.lock, K_FOREVER);
+    for (int i = 0; i < POOL_SIZE; i++) {
+        struct http_pool_conn *conn = &pool.conn[i];
+
+        if (conn->state == HTTP_POOL_FREE) {
+            slot = slot ? slot : conn;
+        } else if (http_pool_match(conn, &http_ctx.url_context)) {
+            ret  = -EALREADY;
+            slot = NULL;
+            break;
+        }
+    }
+
+    if (slot) {
+        if (http_pool_assign(slot, &http_ctx.url_context)) {
+            slot->state = HTTP_POOL_PREWARM;
+            ret         = 0;
+        } else {
+            ret = -EINVAL;
+        }
+    }
+    k_mutex_unlock(&pool.lock);
+
+    if (ret == 0) {
+        LOG_DBG("Pre-warming %s:%s",
+                http_ctx.url_context.host,
+                http_ctx.url_context.port);
+        k_sem_give(&pool.wake);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Closes all kept-alive connections.
+ */
+void http_pool_flush(void)
+{
+    k_mutex_lock(&pool.lock, K_FOREVER);
+
+    /* Busy and connecting sockets are closed when they are given back */
+    pool.generation++;
+
+    for (int i = 0; i < POOL_SIZE; i++) {
+        struct http_pool_conn *conn = &pool.conn[i];
+
+        if (conn->state == HTTP_POOL_IDLE) {
+            http_pool_close(conn);
+        } else if (conn->state == HTTP_POOL_PREWARM) {
+            conn->state = HTTP_POOL_FREE;
+        }
+    }
+
+    k_condvar_broadcast(&pool.changed);
+    k_mutex_unlock(&pool.lock);
+
+    LOG_INF("Connection pool flushed");
+}
+#endif // CONFIG_RPR_HTTP_POOL
@@ -21,6 +21,7 @@
 #ifndef _HTTP_MODULE_H_
 #define _HTTP_MODULE_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -42,10 +43,24 @@ typedef enum {
     HTTP_ERR_SOCK_CONNECT = -3
 } http_status_t;
 
+/**
+ * @brief Receives a response body as it arrives.
+ *
+ * @param data      Fragment of the body.
+ * @param len       Length of the fragment.
+ * @param user_data User data given in the get_context.
+ */
+typedef void (*http_body_cb_t)(const uint8_t *data,
+                               size_t         len,
+                               void          *user_data);
+
 struct get_context {
-    char  *response_buffer;
-    size_t buffer_capacity;
-    size_t response_len;
+    char          *response_buffer;
+    size_t         buffer_capacity;
+    size_t         response_len;
+    http_body_cb_t body_cb;   /* If set, the body is passed here instead */
+    void          *user_data; /* User data for body_cb */
+    bool           cache;     /* Conditional GET, needs CONFIG_RPR_HTTP_CACHE */
 };
 
 struct post_context {
@@ -55,6 +70,58 @@ struct post_context {
     const char       **headers;
 };
 
+struct http_request_timing {
+    bool     reused;      /* Sent on a kept-alive connection */
+    bool     tls_resumed; /* A cached TLS session was offered */
+    uint32_t dns_ms;      /* Name resolution */
+    uint32_t connect_ms;  /* TCP connect, with the TLS handshake for HTTPS */
+    uint32_t response_ms; /* Request sent until the first response data */
+    uint32_t total_ms;    /* Setup, request and response */
+};
+
+struct http_conn_stats {
+    uint32_t requests;        /* Requests sent */
+    uint32_t reused;          /* Requests sent on a kept-alive connection */
+    uint32_t connects;        /* New connections, pre-warmed ones included */
+    uint32_t prewarmed;       /* Connections opened by http_pool_prewarm() */
+    uint32_t retries;         /* Kept-alive connections closed by the server */
+    uint32_t expired;         /* Connections closed after the idle timeout */
+    uint32_t open;            /* Connections currently kept in the pool */
+    uint32_t setup_ms;        /* Time spent in name resolution and connect */
+    uint32_t saved_ms;        /* Setup time saved by reuse, estimated */
+    uint32_t dns_hits;        /* Resolutions answered by the cache */
+    uint32_t dns_stale;       /* Expired addresses served while refreshing */
+    uint32_t dns_negative;    /* Requests failed by a cached failure */
+    uint32_t tls_full;        /* TLS handshakes without a cached session */
+    uint32_t tls_full_ms;     /* Connect time of those, handshake included */
+    uint32_t tls_resumed;     /* TLS handshakes offering a cached session */
+    uint32_t tls_resumed_ms;  /* Connect time of those */
+    uint32_t resumed;         /* Downloads continued with a Range request */
+    uint32_t restarted;       /* Resumes refused because the resource changed */
+    uint32_t retransferred;   /* Bytes received twice by completed downloads */
+    uint32_t segmented;       /* Downloads completed in segments */
+    uint32_t segment_retries; /* Segment requests repeated after a failure */
+    uint32_t delta_updates;   /* Updates rebuilt from a delta patch */
+    uint32_t delta_bytes;     /* Patch bytes received by those */
+    uint32_t delta_image;     /* Image bytes the patches rebuilt */
+    uint32_t packed_updates;  /* Updates received compressed */
+    uint32_t packed_bytes;    /* Compressed bytes received by those */
+    uint32_t packed_image;    /* Image bytes they decompressed to */
+    uint32_t packed_ms;       /* Transfer time of those */
+};
+
+typedef void (*http_download_callback_t)(const char *filepath);
+
+/**
+ * @brief Register a callback for completed file downloads.
+ *
+ * The callback runs in the downloading thread after the file is closed,
+ * before http_download_file_request() returns.
+ *
+ * @param cb Callback function, NULL to remove it.
+ */
+void http_register_download_callback(http_download_callback_t cb);
+
 /**
  * @brief Downloads a file from the specified HTTP/HTTPS URL and saves it to the local filesystem.
  *
@@ -64,6 +131,11 @@ struct post_context {
  *
  * If enabled, also computes and prints the SHA-256 hash of the downloaded content.
  *
+ * The data goes to a temporary file that replaces the file once complete, an
+ * existing file is kept if the download fails. With CONFIG_RPR_HTTP_RESUME
+ * the temporary file is a journaled part file. A download that failed on the network is continued by
+ * the next call with the same URL and folder; the status code is then 206.
+ *
  * @param url               Full HTTP or HTTPS URL of the file to download.
  * @param base_dir          Base folder path where the file will be saved.
  * @param http_status_code  Pointer to store the HTTP response status code.
@@ -79,6 +151,8 @@ http_status_t http_download_file_request(const char *url,
  *
  * This function performs a GET request using the provided `url` and writes the response body
  * into the buffer defined in `get_ctx`. The HTTP status code is written to `http_status_code`.
+ * If `body_cb` is set in `get_ctx`, the body is passed to it fragment by fragment instead and
+ * no buffer is needed, so a response of any length can be parsed as it arrives.
  *
  * @param url               The target HTTP or HTTPS URL.
  * @param get_ctx           Pointer to a get_context structure containing the buffer and its size.
@@ -116,6 +190,15 @@ http_status_t http_post_request(const char          *url,
  * flash partition. Optionally computes the SHA-256 hash of the downloaded image and
  * verifies it against the hash of the flashed image if integrity check is enabled.
  *
+ * With CONFIG_RPR_HTTP_RESUME a download that failed on the network is
+ * continued by the next call with the same URL, from the start of the flash
+ * page it stopped in; the status code is then 206.
+ *
+ * With CONFIG_RPR_DFU_COMPRESSED the image may be compressed by
+ * script/generate_compressed.py; it is decompressed on the fly and the
+ * hash is taken over the decompressed image. Compressed downloads restart
+ * from zero instead of continuing.
+ *
  * @param url               Full HTTP or HTTPS URL of the file to download.
  * @param http_status_code  Pointer to store the HTTP response status code.
  *
@@ -125,4 +208,115 @@ http_status_t http_download_update_request(const char *url,
                                            uint16_t   *http_status_code);
 #endif //CONFIG_RPR_MODULE_DFU
 
+#ifdef CONFIG_RPR_HTTP_SEGMENTED
+/**
+ * @brief Downloads a file with several concurrent Range requests.
+ *
+ * A HEAD request gets the size and the validator of the file. The file is
+ * split into up to `segments` parts of at least CONFIG_RPR_HTTP_SEGMENT_MIN_KB,
+ * each requested on a connection and thread of its own with If-Range, and
+ * retried from where it stopped. The parts are joined into the file once
+ * all are complete; the hash is computed over the joined file.
+ *
+ * Falls back to http_download_file_request() if the server does not accept
+ * ranges, the file is too small to split or the HEAD request fails.
+ * Segmented downloads are not journaled for CONFIG_RPR_HTTP_RESUME.
+ *
+ * @param url               Full HTTP or HTTPS URL of the file to download.
+ * @param base_dir          Base folder path where the file will be saved.
+ * @param http_status_code  Pointer to store the HTTP response status code.
+ * @param segments          Number of connections to use, at most
+ *                          CONFIG_RPR_HTTP_SEGMENTS.
+ *
+ * @return HTTP_CLIENT_OK on success, or an appropriate `http_status_t` error code on failure.
+ */
+http_status_t http_download_file_segmented(const char *url,
+                                           const char *base_dir,
+                                           uint16_t   *http_status_code,
+                                           int         segments);
+
+#ifdef CONFIG_RPR_MODULE_DFU
+/**
+ * @brief Downloads a firmware update image with several concurrent Range
+ *        requests.
+ *
+ * Works like http_download_file_segmented(). The slot is erased once and
+ * each segment writes its own flash page aligned region of it. The hash is
+ * read back from the slot once all segments are complete.
+ *
+ * @param url               Full HTTP or HTTPS URL of the file to download.
+ * @param http_status_code  Pointer to store the HTTP response status code.
+ * @param segments          Number of connections to use, at most
+ *                          CONFIG_RPR_HTTP_SEGMENTS.
+ *
+ * @return HTTP_CLIENT_OK on success, or an appropriate `http_status_t` error code on failure.
+ */
+http_status_t http_download_update_segmented(const char *url,
+                                             uint16_t   *http_status_code,
+                                             int         segments);
+#endif // CONFIG_RPR_MODULE_DFU
+#endif // CONFIG_RPR_HTTP_SEGMENTED
+
+#ifdef CONFIG_RPR_DFU_DELTA
+/**
+ * @brief Downloads a delta patch and applies it to the update slot.
+ *
+ * The patch, made by script/generate_delta.py, rebuilds the new image from
+ * the running one in slot0 while it is received. The rebuilt image is
+ * checked against the target hash of the patch with the integrity check of
+ * full updates. Delta downloads are not journaled for CONFIG_RPR_HTTP_RESUME.
+ *
+ * @param url               Full HTTP or HTTPS URL of the patch.
+ * @param http_status_code  Pointer to store the HTTP response status code.
+ *
+ * @return HTTP_CLIENT_OK on success, HTTP_ERR_DFU_INIT if the patch is not
+ *         made for the running image or is malformed, or another
+ *         `http_status_t` error code on failure.
+ */
+http_status_t http_download_update_delta(const char *url,
+                                         uint16_t   *http_status_code);
+#endif // CONFIG_RPR_DFU_DELTA
+
+/**
+ * @brief Gets the timings of the last completed request.
+ *
+ * @param timing Pointer to store the timings.
+ */
+void http_get_last_timing(struct http_request_timing *timing);
+
+/**
+ * @brief Gets the connection statistics of the module.
+ *
+ * The pool counters stay 0 unless CONFIG_RPR_HTTP_POOL is enabled, the
+ * DNS counters unless CONFIG_RPR_HTTP_DNS_CACHE is enabled, the TLS
+ * counters unless CONFIG_RPR_HTTP_TLS_SESSION_CACHE is enabled.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void http_get_conn_stats(struct http_conn_stats *stats);
+
+#ifdef CONFIG_RPR_HTTP_POOL
+/**
+ * @brief Opens a connection to the host of a URL ahead of the first request.
+ *
+ * Returns at once; the connection is made by the pool thread and kept
+ * until a request to the same host, port and scheme takes it, or until
+ * the idle timeout closes it.
+ *
+ * @param url HTTP or HTTPS URL, only the host, port and scheme are used.
+ *
+ * @return 0 if queued, -EALREADY if the host already has a connection,
+ *         -ENOMEM if the pool is full, -EINVAL if the URL is invalid.
+ */
+int http_pool_prewarm(const char *url);
+
+/**
+ * @brief Closes all kept-alive connections.
+ *
+ * Call when the network interface goes down. Connections in use are
+ * closed when their request completes.
+ */
+void http_pool_flush(void);
+#endif // CONFIG_RPR_HTTP_POOL
+
 #endif /* _HTTP_MODULE_H_ */
\ No newline at end of file
@@ -0,0 +1,741 @@
+/**
+ * @file http_outbox.c
+ * @brief Durable queue of outgoing messages, delivered in batched POSTs.
+ *
+ * The queue is an append-only ring of fixed-size slots in one file. A
+ * message gets the next sequence number and is written to the slot of
+ * that number, with a CRC; a write cut by a power loss leaves a slot that
+ * fails the check and is dropped. The highest acknowledged sequence number
+ * is kept in a separate record, written whole when a batch is
+ * acknowledged. At start the slots are scanned for the highest sequence
+ * number, so only this record has to be rewritten during delivery.
+ *
+ * The record also keeps the epoch of the sequence numbers. A new epoch is
+ * taken when the queue file or the record is lost, as numbers may then be
+ * used again; the server keeps the numbers it has seen per device and
+ * epoch.
+ *
+ * When the ring is full, a new message overwrites the oldest one.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/random/random.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "http_module.h"
+#include "http_outbox.h"
+#include "dev_info.h"
+
+LOG_MODULE_DECLARE(http_module, CONFIG_RPR_MODULE_HTTP_LOG_LEVEL);
+
+#define OUTBOX_DIR         CONFIG_RPR_HTTP_OUTBOX_DIR
+#define OUTBOX_DATA_PATH   OUTBOX_DIR "/outbox.dat"
+#define OUTBOX_STATE_PATH  OUTBOX_DIR "/outbox.ack"
+#define OUTBOX_SLOTS       CONFIG_RPR_HTTP_OUTBOX_SLOTS
+#define OUTBOX_MSG_LEN     CONFIG_RPR_HTTP_OUTBOX_MESSAGE_MAX_LEN
+#define OUTBOX_BATCH_MAX   CONFIG_RPR_HTTP_OUTBOX_BATCH_MAX
+#define OUTBOX_PAYLOAD_LEN CONFIG_RPR_HTTP_OUTBOX_PAYLOAD_MAX_LEN
+#define OUTBOX_LINGER_MS   CONFIG_RPR_HTTP_OUTBOX_LINGER_MS
+
+#define OUTBOX_RECORD_MAGIC       0x584F4252 /* "RBOX" */
+#define OUTBOX_STATE_MAGIC        0x4B434152 /* "RACK" */
+#define OUTBOX_RESPONSE_LEN       128
+#define OUTBOX_DEVICE_ID_LEN      (CONFIG_RPR_DEVICE_ID_BIN_MAX_SIZE * 2 + 1)
+#define OUTBOX_BATCH_HEAD \
+    "{\"device\":\"%s\",\"epoch\":%u,\"first\":%u,\"messages\":["
+#define OUTBOX_BATCH_HEAD_MAX_LEN (64 + OUTBOX_DEVICE_ID_LEN)
+#define OUTBOX_BATCH_TAIL         "]}"
+#define OUTBOX_STATUS_TIMEOUT     408
+#define OUTBOX_STATUS_TOO_MANY    429
+
+BUILD_ASSERT(OUTBOX_PAYLOAD_LEN >= OUTBOX_BATCH_HEAD_MAX_LEN + OUTBOX_MSG_LEN +
+                                          sizeof(OUTBOX_BATCH_TAIL),
+             "The batch payload must hold the longest message");
+
+struct outbox_record {
+    uint32_t magic;
+    uint32_t seq;       /* Sequence number, from 1 */
+    uint32_t boot;      /* Boot the message was queued in */
+    uint32_t queued_ms; /* Uptime when queued */
+    uint32_t len;       /* Length of the message */
+    uint32_t crc;       /* CRC-32 of the fields above and the message */
+    char     msg[OUTBOX_MSG_LEN];
+};
+
+struct outbox_state {
+    uint32_t magic;
+    uint32_t acked; /* Highest acknowledged sequence number */
+    uint32_t boot;  /* Number of starts of the queue */
+    uint32_t epoch; /* Of the sequence numbers, never 0 */
+};
+
+struct outbox_batch {
+    uint32_t first;      /* Sequence number of the first message */
+    uint32_t count;      /* Messages in the payload */
+    size_t   len;        /* Length of the payload */
+    uint32_t msg_bytes;  /* Message bytes in the payload */
+    uint32_t timed;      /* Messages queued in this boot */
+    uint64_t queued_sum; /* Sum of their queue times */
+    uint32_t queued_min; /* Earliest of their queue times */
+};
+
+static struct fs_file_t         outbox_file;
+static struct http_outbox_stats outbox_stats;
+static uint32_t                 outbox_boot;
+static uint32_t                 outbox_epoch;
+static uint32_t                 outbox_head; /* Oldest unacknowledged */
+static uint32_t                 outbox_next; /* For the next message */
+static bool                     outbox_started;
+static bool                     outbox_online;
+static int64_t                  outbox_last_push_ms;
+static int64_t                  outbox_retry_at_ms; /* 0 if no retry due */
+static char                     outbox_url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
+static char                     outbox_payload[OUTBOX_PAYLOAD_LEN];
+static char                     outbox_response[OUTBOX_RESPONSE_LEN];
+static char                     outbox_device[OUTBOX_DEVICE_ID_LEN];
+
+K_MUTEX_DEFINE(outbox_lock);
+K_SEM_DEFINE(outbox_wake, 0, 1);
+
+K_THREAD_STACK_DEFINE(outbox_stack, CONFIG_RPR_HTTP_OUTBOX_THREAD_STACK_SIZE);
+static struct k_thread outbox_thread;
+
+/**
+ * @brief Computes the CRC of a record.
+ *
+ * @param rec Record with its length set.
+ *
+ * @return CRC-32 of the header fields before the CRC and the message.
+ */
+static uint32_t outbox_crc(const struct outbox_record *rec)
+{
+    uint32_t crc = crc32_ieee((const uint8_t *)rec,
+                              offsetof(struct outbox_record, crc));
+
+    return crc32_ieee_update(crc, (const uint8_t *)rec->msg, rec->len);
+}
+
+/**
+ * @brief Moves the queue file to the slot of a sequence number.
+ *
+ * @param seq Sequence number.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int outbox_seek(uint32_t seq)
+{
+    off_t offset = (off_t)(seq % OUTBOX_SLOTS) * sizeof(struct outbox_record);
+
+    return fs_seek(&outbox_file, offset, FS_SEEK_SET);
+}
+
+/**
+ * @brief Reads the message of a sequence number.
+ *
+ * @param seq Sequence number.
+ * @param rec Pointer to store the record.
+ *
+ * @return 0 on success, -ENOENT if the slot holds no valid record of this
+ *         sequence number, negative error code otherwise.
+ */
+static int outbox_read(uint32_t seq, struct outbox_record *rec)
+{
+    int ret = outbox_seek(seq);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = fs_read(&outbox_file, rec, sizeof(*rec));
+    if (ret < 0) {
+        return ret;
+    }
+
+    size_t header = offsetof(struct outbox_record, msg);
+
+    if (ret < header || rec->magic != OUTBOX_RECORD_MAGIC ||
+        rec->seq != seq || rec->len > OUTBOX_MSG_LEN ||
+        ret < header + rec->len || rec->crc != outbox_crc(rec)) {
+        return -ENOENT;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Stores the highest acknowledged sequence number.
+ *
+ * @param acked Sequence number.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int outbox_save_state(uint32_t acked)
+{
+    struct outbox_state state = {
+        .magic = OUTBOX_STATE_MAGIC,
+        .acked = acked,
+        .boot  = outbox_boot,
+        .epoch = outbox_epoch,
+    };
+    struct fs_file_t file;
+
+    fs_file_t_init(&file);
+    int ret = fs_open(&file, OUTBOX_STATE_PATH, FS_O_CREATE | FS_O_WRITE);
+    if (ret < 0) {
+        LOG_ERR("Failed to open %s: %d", OUTBOX_STATE_PATH, ret);
+        return ret;
+    }
+
+    ret = fs_write(&file, &state, sizeof(state));
+    fs_close(&file);
+
+    if (ret != sizeof(state)) {
+        LOG_ERR("Failed to write %s: %d", OUTBOX_STATE_PATH, ret);
+        return ret < 0 ? ret : -EIO;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Opens the queue file and finds the messages left in it.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int outbox_load(void)
+{
+    struct outbox_state state = { 0 };
+    struct fs_file_t    file;
+    struct fs_dirent    entry;
+
+    int ret = fs_mkdir(OUTBOX_DIR);
+    if (ret < 0 && ret != -EEXIST) {
+        LOG_ERR("Failed to create %s: %d", OUTBOX_DIR, ret);
+        return ret;
+    }
+
+    fs_file_t_init(&file);
+    if (fs_open(&file, OUTBOX_STATE_PATH, FS_O_READ) == 0) {
+        ret = fs_read(&file, &state, sizeof(state));
+        fs_close(&file);
+
+        if (ret != sizeof(state) || state.magic != OUTBOX_STATE_MAGIC) {
+            LOG_WRN("Ignoring invalid %s", OUTBOX_STATE_PATH);
+            memset(&state, 0, sizeof(state));
+        }
+    }
+
+    if (state.epoch == 0) {
+        /* Nothing tells which epochs were used, a random one is unlikely
+         * to be one of them */
+        state.epoch = sys_rand32_get() | 1;
+    } else if (fs_stat(OUTBOX_DATA_PATH, &entry) < 0) {
+        /* The numbers after the acknowledged one are used again */
+        state.epoch = state.epoch + 1 ? state.epoch + 1 : 1;
+    }
+    outbox_epoch = state.epoch;
+
+    fs_file_t_init(&outbox_file);
+    ret = fs_open(&outbox_file, OUTBOX_DATA_PATH, FS_O_CREATE | FS_O_RDWR);
+    if (ret < 0) {
+        LOG_ERR("Failed to open %s: %d", OUTBOX_DATA_PATH, ret);
+        return ret;
+    }
+
+    uint32_t last = state.acked;
+
+    for (uint32_t slot = 0; slot < OUTBOX_SLOTS; slot++) {
+        struct outbox_record rec;
+        off_t                offset = (off_t)slot * sizeof(rec);
+
+        if (fs_seek(&outbox_file, offset, FS_SEEK_SET) < 0 ||
+            fs_read(&outbox_file, &rec, sizeof(rec)) <= 0) {
+            break;
+        }
+        if (rec.magic == OUTBOX_RECORD_MAGIC &&
+            rec.seq % OUTBOX_SLOTS == slot && rec.seq > last) {
+            last = rec.seq;
+        }
+    }
+
+    outbox_next = last + 1;
+    outbox_head = state.acked + 1;
+    if (outbox_next - outbox_head > OUTBOX_SLOTS) {
+        outbox_head = outbox_next - OUTBOX_SLOTS;
+    }
+
+    outbox_boot = state.boot + 1;
+    ret         = outbox_save_state(outbox_head - 1);
+    if (ret < 0) {
+        fs_close(&outbox_file);
+        return ret;
+    }
+
+    LOG_INF("Outbox: %u messages left, next %u, epoch %u",
+            outbox_next - outbox_head,
+            outbox_next,
+            outbox_epoch);
+    return 0;
+}
+
+/**
+ * @brief Collects the oldest queued messages into the batch payload.
+ *
+ * A damaged message at the start of the queue is dropped. A damaged one
+ * after others ends the batch, so the messages of a batch always have
+ * consecutive sequence numbers.
+ *
+ * @param batch Pointer to store the batch.
+ */
+static void outbox_build(struct outbox_batch *batch)
+{
+    struct outbox_record rec;
+
+    memset(batch, 0, sizeof(*batch));
+
+    k_mutex_lock(&outbox_lock, K_FOREVER);
+
+    for (uint32_t seq = outbox_head;
+         seq != outbox_next && batch->count < OUTBOX_BATCH_MAX;
+         seq++) {
+        if (outbox_read(seq, &rec) < 0) {
+            if (batch->count > 0) {
+                break;
+            }
+            LOG_WRN("Dropping damaged message %u", seq);
+            outbox_head = seq + 1;
+            outbox_stats.dropped++;
+            continue;
+        }
+
+        if (batch->count == 0) {
+            batch->first = seq;
+            batch->len   = snprintf(outbox_payload,
+                                  OUTBOX_PAYLOAD_LEN,
+                                  OUTBOX_BATCH_HEAD,
+                                  outbox_device,
+                                  outbox_epoch,
+                                  seq);
+        }
+
+        size_t sep = batch->count > 0 ? 1 : 0;
+
+        if (batch->len + sep + rec.len + sizeof(OUTBOX_BATCH_TAIL) >
+            OUTBOX_PAYLOAD_LEN) {
+            break;
+        }
+
+        if (sep) {
+            outbox_payload[batch->len++] = ',';
+        }
+        memcpy(&outbox_payload[batch->len], rec.msg, rec.len);
+        batch->len += rec.len;
+        batch->msg_bytes += rec.len;
+        batch->count++;
+
+        if (rec.boot == outbox_boot) {
+            if (batch->timed == 0 || rec.queued_ms < batch->queued_min) {
+                batch->queued_min = rec.queued_ms;
+            }
+            batch->queued_sum += rec.queued_ms;
+            batch->timed++;
+        }
+    }
+
+    k_mutex_unlock(&outbox_lock);
+
+    if (batch->count > 0) {
+        memcpy(&outbox_payload[batch->len],
+               OUTBOX_BATCH_TAIL,
+               sizeof(OUTBOX_BATCH_TAIL));
+        batch->len += sizeof(OUTBOX_BATCH_TAIL) - 1;
+    }
+}
+
+/**
+ * @brief Removes the messages of an acknowledged or rejected batch from the
+ *        queue.
+ *
+ * @param batch      Acknowledged or rejected batch.
+ * @param request_ms Duration of the request.
+ * @param delivered  false if the server rejected the batch.
+ */
+static void outbox_ack(const struct outbox_batch *batch,
+                       uint32_t                   request_ms,
+                       bool                       delivered)
+{
+    uint32_t now  = (uint32_t)k_uptime_get();
+    uint32_t last = batch->first + batch->count;
+
+    k_mutex_lock(&outbox_lock, K_FOREVER);
+
+    /* The head may have passed the batch if the ring was overwritten */
+    if ((int32_t)(last - outbox_head) > 0) {
+        outbox_head = last;
+        outbox_save_state(last - 1);
+    }
+
+    outbox_stats.backoff_ms = 0;
+    outbox_retry_at_ms      = 0;
+
+    if (!delivered) {
+        outbox_stats.rejected += batch->count;
+        k_mutex_unlock(&outbox_lock);
+        return;
+    }
+
+    outbox_stats.delivered += batch->count;
+    outbox_stats.batches++;
+    outbox_stats.payload_bytes += batch->len;
+    outbox_stats.message_bytes += batch->msg_bytes;
+    outbox_stats.request_ms += request_ms;
+
+    if (batch->timed > 0) {
+        outbox_stats.latency_ms +=
+                (uint32_t)((uint64_t)now * batch->timed - batch->queued_sum);
+        outbox_stats.latency_count += batch->timed;
+        outbox_stats.max_latency_ms = MAX(outbox_stats.max_latency_ms,
+                                          now - batch->queued_min);
+    }
+
+    k_mutex_unlock(&outbox_lock);
+}
+
+/**
+ * @brief Tells whether the server refused a batch for good.
+ *
+ * A client error other than a timeout or a rate limit would be returned
+ * for every retry of the same batch.
+ *
+ * @param ret              Result of the request.
+ * @param http_status_code Status code of the response.
+ *
+ * @return true if the batch must not be retried.
+ */
+static bool outbox_rejected(http_status_t ret, uint16_t http_status_code)
+{
+    return ret == HTTP_BAD_STATUS_CODE && http_status_code >= 400 &&
+           http_status_code < 500 &&
+           http_status_code != OUTBOX_STATUS_TIMEOUT &&
+           http_status_code != OUTBOX_STATUS_TOO_MANY;
+}
+
+/**
+ * @brief Schedules the retry of a failed batch.
+ *
+ * The delay doubles with every failure up to the maximum; a random part
+ * of up to half of it keeps devices that lost the network together from
+ * retrying at the same time.
+ *
+ * @return Delay before the retry.
+ */
+static uint32_t outbox_backoff(void)
+{
+    k_mutex_lock(&outbox_lock, K_FOREVER);
+
+    uint32_t backoff = outbox_stats.backoff_ms * 2;
+
+    backoff = CLAMP(backoff,
+                    CONFIG_RPR_HTTP_OUTBOX_RETRY_MIN_MS,
+                    CONFIG_RPR_HTTP_OUTBOX_RETRY_MAX_MS);
+
+    uint32_t delay = backoff / 2 + sys_rand32_get() % (backoff / 2 + 1);
+
+    outbox_stats.backoff_ms = backoff;
+    outbox_stats.failures++;
+    outbox_retry_at_ms = k_uptime_get() + delay;
+
+    k_mutex_unlock(&outbox_lock);
+
+    return delay;
+}
+
+/**
+ * @brief Sends the next batch if it is due.
+ *
+ * @return Time to wait before the next call, unless woken earlier.
+ */
+static k_timeout_t outbox_deliver(void)
+{
+    k_mutex_lock(&outbox_lock, K_FOREVER);
+
+    int64_t  now     = k_uptime_get();
+    uint32_t pending = outbox_next - outbox_head;
+    int64_t  wait_ms = 0;
+
+    if (!outbox_online || pending == 0) {
+        k_mutex_unlock(&outbox_lock);
+        return K_FOREVER;
+    }
+
+    if (outbox_retry_at_ms > now) {
+        wait_ms = outbox_retry_at_ms - now;
+    } else if (pending < OUTBOX_BATCH_MAX &&
+               now - outbox_last_push_ms < OUTBOX_LINGER_MS) {
+        /* Give messages queued together the chance to share a request */
+        wait_ms = OUTBOX_LINGER_MS - (now - outbox_last_push_ms);
+    }
+
+    k_mutex_unlock(&outbox_lock);
+
+    if (wait_ms > 0) {
+        return K_MSEC(wait_ms);
+    }
+
+    struct outbox_batch batch;
+
+    outbox_build(&batch);
+    if (batch.count == 0) {
+        return K_NO_WAIT;
+    }
+
+    const char *headers[] = { "Content-Type: application/json\r\n", NULL };
+    uint16_t    http_status_code = 0;
+
+    struct post_context post_ctx = {
+        .response = {
+            .response_buffer = outbox_response,
+            .buffer_capacity = sizeof(outbox_response),
+        },
+        .payload     = outbox_payload,
+        .payload_len = batch.len,
+        .headers     = headers,
+    };
+
+    LOG_DBG("Posting messages %u to %u, %zu bytes",
+            batch.first,
+            batch.first + batch.count - 1,
+            batch.len);
+
+    int64_t       start = k_uptime_get();
+    http_status_t ret =
+            http_post_request(outbox_url, &post_ctx, &http_status_code);
+
+    if (outbox_rejected(ret, http_status_code)) {
+        outbox_ack(&batch, (uint32_t)(k_uptime_get() - start), false);
+
+        LOG_ERR("Messages %u to %u rejected (HTTP %u), dropped",
+                batch.first,
+                batch.first + batch.count - 1,
+                http_status_code);
+        return K_NO_WAIT;
+    }
+
+    if (ret != HTTP_CLIENT_OK) {
+        uint32_t delay = outbox_backoff();
+
+        LOG_WRN("Batch of %u messages not delivered (error %d, HTTP %u), "
+                "retry in %u ms",
+                batch.count,
+                ret,
+                http_status_code,
+                delay);
+        return K_MSEC(delay);
+    }
+
+    outbox_ack(&batch, (uint32_t)(k_uptime_get() - start), true);
+
+    LOG_INF("Delivered messages %u to %u",
+            batch.first,
+            batch.first + batch.count - 1);
+    return K_NO_WAIT;
+}
+
+/**
+ * @brief Delivery thread.
+ */
+static void outbox_run(void *p1, void *p2, void *p3)
+{
+    k_timeout_t wait = K_NO_WAIT;
+
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1) {
+        k_sem_take(&outbox_wake, wait);
+        wait = outbox_deliver();
+    }
+}
+
+/**
+ * @brief Opens the queue and starts the delivery thread.
+ *
+ * Messages left from before a reboot are delivered first.
+ *
+ * @param url Endpoint the batches are posted to, copied.
+ *
+ * @return 0 on success, -EALREADY if already started, -EINVAL if the URL
+ *         is too long, -ENODEV if the device ID is not available, negative
+ *         errno code if the queue cannot be opened.
+ */
+int http_outbox_init(const char *url)
+{
+    if (!url || strlen(url) >= sizeof(outbox_url)) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&outbox_lock, K_FOREVER);
+
+    if (outbox_started) {
+        k_mutex_unlock(&outbox_lock);
+        return -EALREADY;
+    }
+
+    size_t      len    = 0;
+    const char *dev_id = dev_info_get_device_id_str(&len);
+
+    if (len == 0 || !dev_id) {
+        LOG_ERR("Failed to retrieve device ID");
+        k_mutex_unlock(&outbox_lock);
+        return -ENODEV;
+    }
+    strncpy(outbox_device, dev_id, sizeof(outbox_device) - 1);
+
+    int ret = outbox_load();
+    if (ret < 0) {
+        k_mutex_unlock(&outbox_lock);
+        return ret;
+    }
+
+    strcpy(outbox_url, url);
+    outbox_started = true;
+
+    k_mutex_unlock(&outbox_lock);
+
+    k_thread_create(&outbox_thread,
+                    outbox_stack,
+                    K_THREAD_STACK_SIZEOF(outbox_stack),
+                    outbox_run,
+                    NULL,
+                    NULL,
+                    NULL,
+                    CONFIG_RPR_HTTP_OUTBOX_THREAD_PRIORITY,
+                    0,
+                    K_NO_WAIT);
+    k_thread_name_set(&outbox_thread, "http_outbox");
+
+    return 0;
+}
+
+/**
+ * @brief Queues a message.
+ *
+ * The message is on the filesystem when the call returns. If the queue is
+ * full, the oldest message is dropped.
+ *
+ * @param msg JSON value to send, such as an object.
+ *
+ * @return 0 on success, -EMSGSIZE if the message is longer than
+ *         CONFIG_RPR_HTTP_OUTBOX_MESSAGE_MAX_LEN, -ENODEV if the queue is
+ *         not started, negative errno code if it cannot be written.
+ */
+int http_outbox_push(const char *msg)
+{
+    struct outbox_record rec;
+    size_t               len = msg ? strlen(msg) : 0;
+
+    if (len == 0) {
+        return -EINVAL;
+    }
+    if (len > OUTBOX_MSG_LEN) {
+        return -EMSGSIZE;
+    }
+
+    k_mutex_lock(&outbox_lock, K_FOREVER);
+
+    if (!outbox_started) {
+        k_mutex_unlock(&outbox_lock);
+        return -ENODEV;
+    }
+
+    if (outbox_next - outbox_head == OUTBOX_SLOTS) {
+        LOG_WRN("Outbox full, dropping message %u", outbox_head);
+        outbox_head++;
+        outbox_stats.dropped++;
+    }
+
+    int64_t now = k_uptime_get();
+
+    rec.magic     = OUTBOX_RECORD_MAGIC;
+    rec.seq       = outbox_next;
+    rec.boot      = outbox_boot;
+    rec.queued_ms = (uint32_t)now;
+    rec.len       = len;
+    memcpy(rec.msg, msg, len);
+    rec.crc = outbox_crc(&rec);
+
+    size_t size = offsetof(struct outbox_record, msg) + len;
+
+    int ret = outbox_seek(rec.seq);
+    if (ret == 0) {
+        ret = fs_write(&outbox_file, &rec, size);
+    }
+    if (ret >= 0) {
+        ret = ret == size ? fs_sync(&outbox_file) : -EIO;
+    }
+
+    if (ret < 0) {
+        k_mutex_unlock(&outbox_lock);
+        LOG_ERR("Failed to queue message: %d", ret);
+        return ret;
+    }
+
+    outbox_next++;
+    outbox_stats.queued++;
+    outbox_last_push_ms = now;
+
+    k_mutex_unlock(&outbox_lock);
+
+    k_sem_give(&outbox_wake);
+    return 0;
+}
+
+/**
+ * @brief Tells the queue whether the network is up.
+ *
+ * Delivery stops while offline and starts at once when back online, the
+ * retry delay is reset.
+ *
+ * @param online true when connected.
+ */
+void http_outbox_set_online(bool online)
+{
+    k_mutex_lock(&outbox_lock, K_FOREVER);
+
+    outbox_online = online;
+    if (online) {
+        outbox_stats.backoff_ms = 0;
+        outbox_retry_at_ms      = 0;
+    }
+
+    k_mutex_unlock(&outbox_lock);
+
+    k_sem_give(&outbox_wake);
+}
+
+/**
+ * @brief Gets the statistics of the queue.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void http_outbox_get_stats(struct http_outbox_stats *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    k_mutex_lock(&outbox_lock, K_FOREVER);
+    *stats         = outbox_stats;
+    stats->pending = outbox_next - outbox_head;
+    k_mutex_unlock(&outbox_lock);
+}
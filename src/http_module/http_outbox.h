@@ -0,0 +1,99 @@
+/**
+ * @file http_outbox.h
+ * @brief Durable queue of outgoing messages, delivered in batched POSTs.
+ *
+ * Messages are stored on the filesystem before the call returns, so they
+ * survive a lost connection and a reboot. A thread sends the queued
+ * messages while the network is up, many of them per POST request, and
+ * drops them only once the server has answered with HTTP 200. A failed
+ * request is retried with an exponential backoff, except for a 4xx answer
+ * other than 408 or 429: such a batch would never be accepted and is
+ * dropped.
+ *
+ * The body of a batch is a JSON object with the device ID, the epoch of
+ * the sequence numbers, the sequence number of its first message and the
+ * messages, each a JSON value given by the caller:
+ *   {"device":"0a1b2c","epoch":3,"first":17,
+ *    "messages":[{"message":"a"},{"message":"b"}]}
+ * The messages of a batch have consecutive sequence numbers.
+ *
+ * Acknowledgement contract: an HTTP 200 answer acknowledges every message
+ * of the batch, the device never sends them again. A batch may be sent
+ * again if the answer is lost, so the server keeps, per device and epoch,
+ * the sequence numbers it has seen and drops the repeated ones. Numbers
+ * only grow within an epoch. A new epoch, which is not ordered with the
+ * earlier ones, starts when the queue state was lost on the device; its
+ * numbers may start over at 1.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _HTTP_OUTBOX_H_
+#define _HTTP_OUTBOX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct http_outbox_stats {
+    uint32_t queued;         /* Messages accepted */
+    uint32_t delivered;      /* Messages acknowledged by the server */
+    uint32_t dropped;        /* Overwritten or damaged before delivery */
+    uint32_t rejected;       /* Refused by the server, not retried */
+    uint32_t pending;        /* Messages waiting for delivery */
+    uint32_t batches;        /* Acknowledged POST requests */
+    uint32_t failures;       /* Failed POST requests */
+    uint32_t payload_bytes;  /* Bodies of the acknowledged requests */
+    uint32_t message_bytes;  /* Messages in these bodies */
+    uint32_t request_ms;     /* Time of the acknowledged requests */
+    uint32_t latency_ms;     /* Queued to acknowledged, summed */
+    uint32_t latency_count;  /* Messages in latency_ms */
+    uint32_t max_latency_ms; /* Longest queued to acknowledged time */
+    uint32_t backoff_ms;     /* Delay before the next retry, 0 if none */
+};
+
+/**
+ * @brief Opens the queue and starts the delivery thread.
+ *
+ * Messages left from before a reboot are delivered first.
+ *
+ * @param url Endpoint the batches are posted to, copied.
+ *
+ * @return 0 on success, -EALREADY if already started, -EINVAL if the URL
+ *         is too long, -ENODEV if the device ID is not available, negative
+ *         errno code if the queue cannot be opened.
+ */
+int http_outbox_init(const char *url);
+
+/**
+ * @brief Queues a message.
+ *
+ * The message is on the filesystem when the call returns. If the queue is
+ * full, the oldest message is dropped.
+ *
+ * @param msg JSON value to send, such as an object.
+ *
+ * @return 0 on success, -EMSGSIZE if the message is longer than
+ *         CONFIG_RPR_HTTP_OUTBOX_MESSAGE_MAX_LEN, -ENODEV if the queue is
+ *         not started, negative errno code if it cannot be written.
+ */
+int http_outbox_push(const char *msg);
+
+/**
+ * @brief Tells the queue whether the network is up.
+ *
+ * Delivery stops while offline and starts at once when back online, the
+ * retry delay is reset.
+ *
+ * @param online true when connected.
+ */
+void http_outbox_set_online(bool online);
+
+/**
+ * @brief Gets the statistics of the queue.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void http_outbox_get_stats(struct http_outbox_stats *stats);
+
+#endif /* _HTTP_OUTBOX_H_ */
@@ -0,0 +1,213 @@
+/**
+ * @file http_resume.c
+ * @brief Progress journal of interrupted HTTP downloads.
+ *
+ * Records are fixed-size binary files in CONFIG_RPR_HTTP_RESUME_DIR, one
+ * per slot. A record is always written whole and LittleFS makes
+ * the new content visible on close, so a power loss leaves either the old
+ * or the new record.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/logging/log.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "http_resume.h"
+
+LOG_MODULE_DECLARE(http_module, CONFIG_RPR_MODULE_HTTP_LOG_LEVEL);
+
+#define RESUME_DIR   CONFIG_RPR_HTTP_RESUME_DIR
+#define RESUME_MAGIC 0x4A524448 /* "HDRJ" */
+
+#define RESUME_FILE_JOURNAL RESUME_DIR "/file%d.jnl"
+#define RESUME_FILE_PART    RESUME_DIR "/file%d.part"
+#define RESUME_UPDATE_PATH  RESUME_DIR "/update.jnl"
+
+/**
+ * @brief Creates the directory of the journals if it does not exist.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int resume_mkdir(void)
+{
+    int ret = fs_mkdir(RESUME_DIR);
+
+    if (ret < 0 && ret != -EEXIST) {
+        LOG_ERR("Failed to create %s: %d", RESUME_DIR, ret);
+        return ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Gets the path of the journal of a slot.
+ *
+ * @param slot Journal slot.
+ * @param path Buffer to store the path.
+ *
+ * @return 0 on success, -EINVAL if there is no such slot.
+ */
+static int resume_journal_path(int slot, char path[HTTP_RESUME_PATH_MAX_LEN])
+{
+    if (slot < 0 || slot >= HTTP_RESUME_SLOTS) {
+        return -EINVAL;
+    }
+
+    if (slot == HTTP_RESUME_UPDATE_SLOT) {
+        strcpy(path, RESUME_UPDATE_PATH);
+    } else {
+        snprintf(path, HTTP_RESUME_PATH_MAX_LEN, RESUME_FILE_JOURNAL, slot);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Loads the journal of a slot.
+ *
+ * @param slot Journal slot, HTTP_RESUME_UPDATE_SLOT for updates.
+ * @param jnl  Pointer to store the record.
+ *
+ * @return 0 on success, -ENOENT if there is no valid record, negative
+ *         error code otherwise.
+ */
+int http_resume_load(int slot, struct http_resume_journal *jnl)
+{
+    char path[HTTP_RESUME_PATH_MAX_LEN];
+
+    if (!jnl || resume_journal_path(slot, path) < 0) {
+        return -EINVAL;
+    }
+
+    struct fs_file_t file;
+
+    fs_file_t_init(&file);
+    int ret = fs_open(&file, path, FS_O_READ);
+    if (ret < 0) {
+        return -ENOENT;
+    }
+
+    ret = fs_read(&file, jnl, sizeof(*jnl));
+    fs_close(&file);
+
+    if (ret != sizeof(*jnl) || jnl->magic != RESUME_MAGIC ||
+        jnl->size != sizeof(*jnl)) {
+        LOG_WRN("Ignoring invalid journal %s", path);
+        return -ENOENT;
+    }
+
+    jnl->url[sizeof(jnl->url) - 1]             = '\0';
+    jnl->filepath[sizeof(jnl->filepath) - 1]   = '\0';
+    jnl->validator[sizeof(jnl->validator) - 1] = '\0';
+
+    return 0;
+}
+
+/**
+ * @brief Stores the journal of a slot.
+ *
+ * @param slot Journal slot, HTTP_RESUME_UPDATE_SLOT for updates.
+ * @param jnl  Record to store.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int http_resume_save(int slot, const struct http_resume_journal *jnl)
+{
+    char path[HTTP_RESUME_PATH_MAX_LEN];
+
+    if (!jnl || resume_journal_path(slot, path) < 0) {
+        return -EINVAL;
+    }
+
+    struct http_resume_journal record = *jnl;
+    struct fs_file_t           file;
+
+    record.magic = RESUME_MAGIC;
+    record.size  = sizeof(record);
+
+    int ret = resume_mkdir();
+    if (ret < 0) {
+        return ret;
+    }
+
+    fs_file_t_init(&file);
+    ret = fs_open(&file, path, FS_O_CREATE | FS_O_WRITE);
+    if (ret < 0) {
+        LOG_ERR("Failed to open %s: %d", path, ret);
+        return ret;
+    }
+
+    ret = fs_write(&file, &record, sizeof(record));
+    fs_close(&file);
+
+    if (ret != sizeof(record)) {
+        LOG_ERR("Failed to write %s: %d", path, ret);
+        return ret < 0 ? ret : -EIO;
+    }
+
+    LOG_DBG("Journal %s: %u bytes committed", path, record.committed);
+    return 0;
+}
+
+/**
+ * @brief Deletes the journal of a slot.
+ *
+ * @param slot Journal slot, HTTP_RESUME_UPDATE_SLOT for updates.
+ */
+void http_resume_clear(int slot)
+{
+    char path[HTTP_RESUME_PATH_MAX_LEN];
+
+    if (resume_journal_path(slot, path) < 0) {
+        return;
+    }
+
+    int ret = fs_unlink(path);
+    if (ret < 0 && ret != -ENOENT) {
+        LOG_WRN("Failed to delete %s: %d", path, ret);
+    }
+}
+
+/**
+ * @brief Opens the part file of a file download slot for writing.
+ *
+ * @param slot File download slot.
+ * @param file File object to open, initialized with fs_file_t_init().
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int http_resume_open_part(int slot, struct fs_file_t *file)
+{
+    char path[HTTP_RESUME_PATH_MAX_LEN];
+
+    if (slot < 0 || slot >= HTTP_RESUME_FILE_SLOTS) {
+        return -EINVAL;
+    }
+
+    int ret = resume_mkdir();
+    if (ret < 0) {
+        return ret;
+    }
+
+    http_resume_part_path(slot, path);
+
+    return fs_open(file, path, FS_O_CREATE | FS_O_WRITE);
+}
+
+/**
+ * @brief Gets the path of the part file of a file download slot.
+ *
+ * @param slot File download slot.
+ * @param path Buffer to store the path.
+ */
+void http_resume_part_path(int slot, char path[HTTP_RESUME_PATH_MAX_LEN])
+{
+    snprintf(path, HTTP_RESUME_PATH_MAX_LEN, RESUME_FILE_PART, slot);
+}
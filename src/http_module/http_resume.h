@@ -0,0 +1,110 @@
+/**
+ * @file http_resume.h
+ * @brief Progress journal of interrupted HTTP downloads.
+ *
+ * A download that may be resumed keeps a small record on LittleFS: the URL,
+ * the validator of the resource (ETag, or Last-Modified), the number of
+ * bytes stored for good and, for file downloads, the SHA-256 state after
+ * them. The next download of the same URL continues with a Range request
+ * from the journal instead of starting from zero.
+ *
+ * There are CONFIG_RPR_HTTP_RESUME_FILE_SLOTS journals for file
+ * downloads, each with a part file the download goes to until it is
+ * complete, and one journal for updates. A slot is used by one transfer
+ * at a time.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _HTTP_RESUME_H_
+#define _HTTP_RESUME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/fs/fs.h>
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+#include "mbedtls/sha256.h"
+#endif
+
+#define HTTP_RESUME_VALIDATOR_MAX_LEN 64
+#define HTTP_RESUME_PATH_MAX_LEN \
+    (CONFIG_RPR_FOLDER_PATH_MAX_LEN + CONFIG_RPR_FILENAME_MAX_LEN)
+
+#define HTTP_RESUME_FILE_SLOTS  CONFIG_RPR_HTTP_RESUME_FILE_SLOTS
+#define HTTP_RESUME_UPDATE_SLOT HTTP_RESUME_FILE_SLOTS /* After the files */
+#define HTTP_RESUME_SLOTS       (HTTP_RESUME_FILE_SLOTS + 1)
+
+typedef enum {
+    HTTP_RESUME_FILE = 0,
+    HTTP_RESUME_UPDATE,
+    HTTP_RESUME_KIND_COUNT,
+} http_resume_kind_t;
+
+struct http_resume_journal {
+    uint32_t magic;
+    uint32_t size; /* Record size, a layout change drops old records */
+    char     url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
+    char     filepath[HTTP_RESUME_PATH_MAX_LEN]; /* File downloads only */
+    char     validator[HTTP_RESUME_VALIDATOR_MAX_LEN];
+    uint32_t total;     /* Size of the resource, 0 if unknown */
+    uint32_t committed; /* Bytes stored for good */
+    uint32_t received;  /* Bytes received over all attempts */
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    mbedtls_sha256_context hash; /* State after the committed bytes */
+#endif
+};
+
+/**
+ * @brief Reads the journal of a slot.
+ *
+ * @param slot Journal slot, HTTP_RESUME_UPDATE_SLOT for updates.
+ * @param jnl  Pointer to store the record.
+ *
+ * @return 0 on success, -ENOENT if there is no valid record, negative
+ *         error code otherwise.
+ */
+int http_resume_load(int slot, struct http_resume_journal *jnl);
+
+/**
+ * @brief Writes the journal of a slot.
+ *
+ * The record is replaced as a whole, LittleFS commits it when the file
+ * is closed.
+ *
+ * @param slot Journal slot, HTTP_RESUME_UPDATE_SLOT for updates.
+ * @param jnl  Record to store.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int http_resume_save(int slot, const struct http_resume_journal *jnl);
+
+/**
+ * @brief Deletes the journal of a slot.
+ *
+ * @param slot Journal slot, HTTP_RESUME_UPDATE_SLOT for updates.
+ */
+void http_resume_clear(int slot);
+
+/**
+ * @brief Opens the part file of a file download slot for writing.
+ *
+ * The file is created if it does not exist; its content is kept.
+ *
+ * @param slot File download slot.
+ * @param file File object to open, initialized with fs_file_t_init().
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int http_resume_open_part(int slot, struct fs_file_t *file);
+
+/**
+ * @brief Gets the path of the part file of a file download slot.
+ *
+ * @param slot File download slot.
+ * @param path Buffer to store the path.
+ */
+void http_resume_part_path(int slot, char path[HTTP_RESUME_PATH_MAX_LEN]);
+
+#endif /* _HTTP_RESUME_H_ */
@@ -0,0 +1,1030 @@
+/**
+ * @file http_segmented.c
+ * @brief Segmented downloads over several connections.
+ *
+ * A HEAD request gets the size, the validator and the range support of the
+ * resource, which is then split into segments requested with Range and
+ * If-Range on connections of their own, one thread each. A segment that
+ * fails is requested again from where it stopped.
+ *
+ * The segments of a file go to part files in the destination folder. Once
+ * all are complete they are joined into the first one, which replaces the
+ * destination file; a failed download leaves the destination as it was.
+ * The segments of an update image are written to their regions of the
+ * update slot.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/http/client.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "http_module.h"
+#include "http_internal.h"
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+#include "mbedtls/sha256.h"
+#endif
+
+#ifdef CONFIG_RPR_MODULE_DFU
+#include "dfu_manager.h"
+#endif
+
+#ifdef CONFIG_RPR_FLASH_QOS
+#include "flash_qos.h"
+#endif
+
+LOG_MODULE_DECLARE(http_module, CONFIG_RPR_MODULE_HTTP_LOG_LEVEL);
+
+#define SEGMENTS_MAX      CONFIG_RPR_HTTP_SEGMENTS
+#define SEGMENT_MIN_BYTES (CONFIG_RPR_HTTP_SEGMENT_MIN_KB * 1024)
+#define SEGMENT_PART_NAME ".seg"
+
+struct segmented_download;
+
+struct segment_context {
+    struct segmented_download *dl;
+    int                        index;
+    uint32_t                   start;   /* First byte of the segment */
+    uint32_t                   end;     /* Byte after the segment */
+    uint32_t                   done;    /* Bytes stored */
+    bool                       checked; /* Status of the response checked */
+    bool                       failed;  /* Response does not continue it */
+    uint16_t                   status;  /* Status code of the last response */
+    int                        result;
+    struct http_headers        headers;
+    char                       path[FULL_FILE_PATH_MAX_LEN];
+    struct fs_file_t           file;
+#ifdef CONFIG_RPR_MODULE_DFU
+    struct dfu_segment_context flash;
+    uint32_t                   flash_base; /* Segment offset of the stream */
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    mbedtls_sha256_context hash;   /* Of the bytes received for the segment */
+    uint32_t               hashed; /* Segment bytes in the hash */
+#endif
+#endif
+    /* Request headers */
+    char        range[HTTP_RANGE_MAX_LEN];
+    char        if_range[HTTP_IF_RANGE_MAX_LEN];
+    const char *req_headers[3];
+    uint8_t     recv_buf[CONFIG_RPR_HTTP_RECV_BUFFER_SIZE];
+};
+
+struct segmented_download {
+    http_context_type_t    type; /* HTTP_CTX_DOWNLOAD or HTTP_CTX_UPDATE */
+    const char            *url;
+    const char            *folder_path; /* NULL for an update */
+    char                   filepath[FULL_FILE_PATH_MAX_LEN];
+    uint32_t               total;
+    bool                   ranges; /* Server accepts byte ranges */
+    char                   validator[HTTP_HEADER_VALUE_MAX_LEN];
+    atomic_t               abort; /* A segment failed for good */
+    int                    count;
+    struct segment_context seg[SEGMENTS_MAX];
+#ifdef CONFIG_RPR_HTTP_CACHE
+    struct http_cache_entry cache_entry;
+#endif
+#ifdef CONFIG_RPR_MODULE_DFU
+    struct dfu_storage_context dfu_ctx;
+#endif
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    unsigned char hash[HASH_SIZE_MAX_LEN]; /* Of the whole resource */
+#endif
+};
+
+/* One segmented download at a time, its state is too large for a stack */
+static struct segmented_download segmented;
+K_MUTEX_DEFINE(segmented_lock);
+
+K_THREAD_STACK_ARRAY_DEFINE(segment_stacks,
+                            SEGMENTS_MAX,
+                            CONFIG_RPR_HTTP_SEGMENT_THREAD_STACK_SIZE);
+static struct k_thread segment_threads[SEGMENTS_MAX];
+
+/**
+ * @brief Stores a fragment of the response to a segment request.
+ *
+ * The first fragment must be the 206 response for the range that was asked
+ * for; any other response marks the segment as failed and is dropped.
+ *
+ * @param seg Segment the request belongs to.
+ * @param rsp Received response fragment.
+ */
+void segment_store(struct segment_context *seg, struct http_response *rsp)
+{
+    if (!seg->checked) {
+        uint32_t first = 0;
+        uint32_t total = 0;
+
+        seg->checked = true;
+
+        if (rsp->http_status_code != HTTP_STATUS_PARTIAL ||
+            http_headers_range(&seg->headers, &first, &total) < 0 ||
+            first != seg->start + seg->done ||
+            (total && total != seg->dl->total)) {
+            LOG_ERR("Segment %d: unexpected response %u \"%s\"",
+                    seg->index,
+                    rsp->http_status_code,
+                    seg->headers.value[HTTP_HDR_CONTENT_RANGE]);
+            seg->failed = true;
+        }
+    }
+
+    if (seg->failed) {
+        return;
+    }
+
+    size_t len = MIN(rsp->body_frag_len, seg->end - seg->start - seg->done);
+    int    ret;
+
+#ifdef CONFIG_RPR_MODULE_DFU
+    if (seg->dl->type == HTTP_CTX_UPDATE) {
+        ret = dfu_update_segment_write(
+                &seg->flash, rsp->body_frag_start, len, false);
+        ret = ret < 0 ? ret : len;
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+        /* A retry resends the bytes after the flash boundary, the ones
+         * already hashed are skipped */
+        if (ret > 0 && seg->done + len > seg->hashed) {
+            size_t skip = seg->hashed - seg->done;
+
+            mbedtls_sha256_update(
+                    &seg->hash, rsp->body_frag_start + skip, len - skip);
+            seg->hashed = seg->done + len;
+        }
+#endif
+    } else
+#endif
+    {
+#ifdef CONFIG_RPR_FLASH_QOS
+        ret = flash_qos_write(&seg->file, rsp->body_frag_start, len);
+#else
+        ret = fs_write(&seg->file, rsp->body_frag_start, len);
+#endif
+    }
+
+    if (ret < 0) {
+        LOG_ERR("Segment %d: write failed: %d", seg->index, ret);
+        seg->failed = true;
+        return;
+    }
+
+    seg->done += ret;
+}
+
+/**
+ * @brief Asks the server for the size, the validator and the range support
+ *        of a resource with a HEAD request.
+ *
+ * @param dl               Segmented download, the URL is set.
+ * @param http_status_code Pointer to store the HTTP response status code.
+ *
+ * @return HTTP_CLIENT_OK on success, or an appropriate `http_status_t` error
+ *         code on failure.
+ */
+static http_status_t
+segmented_probe(struct segmented_download *dl, uint16_t *http_status_code)
+{
+    struct segment_context *seg  = &dl->seg[0];
+    int                     sock = -1;
+
+    struct http_context ctx = {
+        .type             = HTTP_CTX_NONE,
+        .http_status_code = http_status_code,
+        .headers          = &seg->headers,
+    };
+
+    http_status_t ret_status = setup_http_client(dl->url, &sock, &ctx);
+
+    if (ret_status != HTTP_CLIENT_OK) {
+        LOG_ERR("HTTP setup failed (code %d)", ret_status);
+        return ret_status;
+    }
+
+    if (dl->type == HTTP_CTX_DOWNLOAD) {
+        ret_status = download_filepath(
+                dl->folder_path, ctx.url_context.path, dl->filepath);
+        if (ret_status != HTTP_URL_OK) {
+            release_socket(sock, &ctx, true);
+            return ret_status;
+        }
+    }
+
+    struct http_request req = {
+        .method       = HTTP_HEAD,
+        .url          = ctx.url_context.path,
+        .host         = ctx.url_context.host,
+        .protocol     = "HTTP/1.1",
+        .response     = response_cb,
+        .http_cb      = &http_header_settings,
+        .recv_buf     = seg->recv_buf,
+        .recv_buf_len = sizeof(seg->recv_buf),
+    };
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+    if (dl->type == HTTP_CTX_DOWNLOAD) {
+        cache_begin(dl->url, dl->filepath, &ctx, &req);
+    }
+#endif
+
+    int ret = send_request(sock, &req, &ctx);
+
+    /* The response has no body, response_cb() does not store the status */
+    *http_status_code = req.internal.response.http_status_code;
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+    if (ctx.cache) {
+        bool not_modified =
+                ret >= 0 && cache_not_modified(ctx.cache, *http_status_code);
+
+        cache_end(&ctx);
+        if (not_modified) {
+            return HTTP_CLIENT_OK;
+        }
+    }
+#endif
+
+    if (ret < 0) {
+        LOG_ERR("HTTP client request failed with code %d", ret);
+        return HTTP_ERR_CLIENT_REQUEST;
+    }
+
+    if (*http_status_code != HTTP_STATUS_OK) {
+        LOG_WRN("Unexpected HTTP status: %d", *http_status_code);
+        return HTTP_BAD_STATUS_CODE;
+    }
+
+    const char *validator = http_headers_validator(&seg->headers);
+
+    dl->total  = req.internal.response.content_length;
+    dl->ranges = strcasecmp(seg->headers.value[HTTP_HDR_ACCEPT_RANGES],
+                            "bytes") == 0;
+    if (validator) {
+        strncpy(dl->validator, validator, sizeof(dl->validator) - 1);
+    }
+
+    return HTTP_CLIENT_OK;
+}
+
+/**
+ * @brief Splits a resource into segments of about the same size.
+ *
+ * Segments of an update image start on a flash page, so that each one can
+ * be written by its own flash stream.
+ *
+ * @param dl       Segmented download, the size is known.
+ * @param segments Number of segments asked for.
+ *
+ * @return Number of segments, less than 2 if the resource is not split.
+ */
+static int segmented_split(struct segmented_download *dl, int segments)
+{
+    int      count = MIN(segments, SEGMENTS_MAX);
+    uint32_t prev  = 0;
+
+    count = MIN(count, (int)(dl->total / SEGMENT_MIN_BYTES));
+
+    for (int i = 0; i < count; i++) {
+        struct segment_context *seg   = &dl->seg[i];
+        size_t                  start = (uint64_t)dl->total * i / count;
+
+#ifdef CONFIG_RPR_MODULE_DFU
+        if (dl->type == HTTP_CTX_UPDATE &&
+            dfu_update_slot_page_start(start, &start) < 0) {
+            return 0;
+        }
+#endif
+
+        if (i > 0) {
+            if (start <= prev) {
+                return 0;
+            }
+            dl->seg[i - 1].end = start;
+        }
+
+        seg->dl    = dl;
+        seg->index = i;
+        seg->start = start;
+        prev       = start;
+    }
+
+    if (count > 0) {
+        dl->seg[count - 1].end = dl->total;
+    }
+
+    dl->count = count;
+
+    return count;
+}
+
+/**
+ * @brief Prepares a segmented download.
+ *
+ * @param dl               Segmented download to set up.
+ * @param type             HTTP_CTX_DOWNLOAD or HTTP_CTX_UPDATE.
+ * @param url              URL of the resource.
+ * @param base_dir         Folder of a file download, NULL for an update.
+ * @param segments         Number of segments asked for.
+ * @param http_status_code Pointer to store the HTTP response status code.
+ *
+ * @return true if the resource is downloaded in segments, false if it must
+ *         be downloaded over a single connection.
+ */
+static bool segmented_begin(struct segmented_download *dl,
+                            http_context_type_t        type,
+                            const char                *url,
+                            const char                *base_dir,
+                            int                        segments,
+                            uint16_t                  *http_status_code)
+{
+    memset(dl, 0, sizeof(*dl));
+    dl->type        = type;
+    dl->url         = url;
+    dl->folder_path = base_dir;
+
+    if (segments < 2 ||
+        segmented_probe(dl, http_status_code) != HTTP_CLIENT_OK) {
+        return false;
+    }
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+    if (*http_status_code == HTTP_STATUS_NOT_MODIFIED) {
+        return false;
+    }
+#endif
+
+    if (!dl->ranges) {
+        LOG_INF("Server does not accept ranges, using a single connection");
+        return false;
+    }
+
+    if (segmented_split(dl, segments) < 2) {
+        LOG_INF("%u bytes are not split, using a single connection",
+                dl->total);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Positions the storage of a segment where its data continues.
+ *
+ * @param seg Segment to open.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int segment_open(struct segment_context *seg)
+{
+#ifdef CONFIG_RPR_MODULE_DFU
+    if (seg->dl->type == HTTP_CTX_UPDATE) {
+        size_t offset = seg->start + seg->done;
+
+        /* Pages an earlier attempt programmed must be erased again */
+        int ret = dfu_update_segment_init(
+                &seg->flash, &offset, seg->end, seg->done > 0);
+        if (ret == 0) {
+            seg->flash_base = offset - seg->start;
+            seg->done       = seg->flash_base;
+        }
+
+        return ret;
+    }
+#endif
+
+    return fs_seek(&seg->file, seg->done, FS_SEEK_SET);
+}
+
+/**
+ * @brief Settles the storage of a segment after a request.
+ *
+ * A complete segment of an update image is flushed. Otherwise the data
+ * still in the flash stream buffer is lost, and the segment continues
+ * after the data that reached the flash.
+ *
+ * @param seg Segment of the request.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int segment_sync(struct segment_context *seg)
+{
+#ifdef CONFIG_RPR_MODULE_DFU
+    if (seg->dl->type == HTTP_CTX_UPDATE) {
+        if (seg->done == seg->end - seg->start) {
+            return dfu_update_segment_write(&seg->flash, NULL, 0, true);
+        }
+
+        seg->done = seg->flash_base +
+                    dfu_update_segment_bytes_written(&seg->flash);
+    }
+#endif
+
+    return 0;
+}
+
+/**
+ * @brief Requests the rest of a segment on a connection of its own.
+ *
+ * @param seg Segment to request.
+ *
+ * @return 0 once the segment is complete, -EAGAIN if the request may be
+ *         retried, other negative error code if the download cannot
+ *         continue.
+ */
+static int segment_request(struct segment_context *seg)
+{
+    struct segmented_download *dl   = seg->dl;
+    int                        sock = -1;
+
+    struct http_context ctx = {
+        .type             = HTTP_CTX_SEGMENT,
+        .http_status_code = &seg->status,
+        .ctx.segment      = seg,
+        .headers          = &seg->headers,
+    };
+
+    int ret = segment_open(seg);
+    if (ret < 0) {
+        LOG_ERR("Segment %d: storage not available: %d", seg->index, ret);
+        return ret;
+    }
+
+    if (setup_http_client(dl->url, &sock, &ctx) != HTTP_CLIENT_OK) {
+        return -EAGAIN;
+    }
+
+    memset(&seg->headers, 0, sizeof(seg->headers));
+    seg->checked = false;
+    seg->failed  = false;
+    seg->status  = 0;
+
+    http_range_headers(seg->range,
+                       seg->if_range,
+                       seg->req_headers,
+                       seg->start + seg->done,
+                       seg->end - 1,
+                       dl->validator);
+
+    struct http_request req = {
+        .method        = HTTP_GET,
+        .url           = ctx.url_context.path,
+        .host          = ctx.url_context.host,
+        .protocol      = "HTTP/1.1",
+        .header_fields = seg->req_headers,
+        .response      = response_cb,
+        .http_cb       = &http_header_settings,
+        .recv_buf      = seg->recv_buf,
+        .recv_buf_len  = sizeof(seg->recv_buf),
+    };
+
+    ret = send_request(sock, &req, &ctx);
+
+    bool complete = seg->done == seg->end - seg->start;
+    int  sync     = segment_sync(seg);
+
+    if (sync < 0) {
+        return sync;
+    }
+
+    if (complete) {
+        return 0;
+    }
+
+    if (ret < 0) {
+        LOG_WRN("Segment %d: request failed: %d", seg->index, ret);
+        return -EAGAIN;
+    }
+
+    if (seg->failed && seg->status != HTTP_STATUS_PARTIAL &&
+        seg->status < INTERNAL_SERVER_ERROR) {
+        /* The resource changed or the server stopped serving ranges */
+        return -EBADMSG;
+    }
+
+    LOG_WRN("Segment %d: ended at %u of %u",
+            seg->index,
+            seg->start + seg->done,
+            seg->end);
+
+    return -EAGAIN;
+}
+
+/**
+ * @brief Segment thread, requests its segment until it is complete or the
+ *        retries are used up.
+ *
+ * @param p1 Segment to download.
+ * @param p2 Unused.
+ * @param p3 Unused.
+ */
+static void segment_thread(void *p1, void *p2, void *p3)
+{
+    struct segment_context *seg = p1;
+
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    for (int attempt = 0;; attempt++) {
+        seg->result = segment_request(seg);
+
+        if (seg->result != -EAGAIN ||
+            attempt == CONFIG_RPR_HTTP_SEGMENT_RETRIES ||
+            atomic_get(&seg->dl->abort)) {
+            break;
+        }
+
+        http_stats_count(&conn_stats.segment_retries);
+        LOG_WRN("Segment %d: retrying from %u",
+                seg->index,
+                seg->start + seg->done);
+    }
+
+    if (seg->result < 0) {
+        atomic_set(&seg->dl->abort, 1);
+    }
+}
+
+/**
+ * @brief Downloads all segments concurrently, one thread each.
+ *
+ * @param dl Segmented download with its storage opened.
+ *
+ * @return 0 if all segments are complete, negative error code otherwise.
+ */
+static int segmented_run(struct segmented_download *dl)
+{
+    int ret = 0;
+
+    atomic_set(&dl->abort, 0);
+
+    for (int i = 0; i < dl->count; i++) {
+        k_thread_create(&segment_threads[i],
+                        segment_stacks[i],
+                        K_THREAD_STACK_SIZEOF(segment_stacks[i]),
+                        segment_thread,
+                        &dl->seg[i],
+                        NULL,
+                        NULL,
+                        CONFIG_RPR_HTTP_SEGMENT_THREAD_PRIORITY,
+                        0,
+                        K_NO_WAIT);
+        k_thread_name_set(&segment_threads[i], "http_segment");
+    }
+
+    for (int i = 0; i < dl->count; i++) {
+        k_thread_join(&segment_threads[i], K_FOREVER);
+
+        if (dl->seg[i].result < 0 && ret == 0) {
+            ret = dl->seg[i].result;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Gets the result of a segmented download that failed.
+ *
+ * @param dl               Segmented download.
+ * @param http_status_code Pointer to store the status of the failed segment.
+ *
+ * @return HTTP_BAD_STATUS_CODE if the server refused a segment,
+ *         HTTP_ERR_CLIENT_REQUEST otherwise.
+ */
+static http_status_t
+segmented_status(struct segmented_download *dl, uint16_t *http_status_code)
+{
+    for (int i = 0; i < dl->count; i++) {
+        struct segment_context *seg = &dl->seg[i];
+
+        if (seg->result == 0) {
+            continue;
+        }
+
+        LOG_ERR("Segment %d failed: %d, status %u",
+                i,
+                seg->result,
+                seg->status);
+        *http_status_code = seg->status ? seg->status : INTERNAL_SERVER_ERROR;
+
+        return seg->result == -EBADMSG ? HTTP_BAD_STATUS_CODE
+                                       : HTTP_ERR_CLIENT_REQUEST;
+    }
+
+    return HTTP_ERR_CLIENT_REQUEST;
+}
+
+/**
+ * @brief Appends the part files of the segments to the part file of the
+ *        first segment and removes them.
+ *
+ * With CONFIG_RPR_HASH_CALCULATION the whole file is hashed on the way.
+ *
+ * @param dl Segmented file download with all segments complete.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int segmented_join(struct segmented_download *dl)
+{
+    uint8_t         *buf  = dl->seg[0].recv_buf;
+    size_t           size = sizeof(dl->seg[0].recv_buf);
+    struct fs_file_t dst;
+    ssize_t          len = 0;
+
+    fs_file_t_init(&dst);
+
+    int ret = fs_open(&dst, dl->seg[0].path, FS_O_RDWR);
+    if (ret < 0) {
+        return ret;
+    }
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    mbedtls_sha256_context hash_ctx;
+
+    mbedtls_sha256_init(&hash_ctx);
+    mbedtls_sha256_starts(&hash_ctx, 0);
+
+    /* The first segment stays where it is, it is only read for the hash */
+    while ((len = fs_read(&dst, buf, size)) > 0) {
+        mbedtls_sha256_update(&hash_ctx, buf, len);
+    }
+    ret = len;
+#else
+    ret = fs_seek(&dst, 0, FS_SEEK_END);
+#endif
+
+    for (int i = 1; i < dl->count && ret >= 0; i++) {
+        struct fs_file_t src;
+
+        fs_file_t_init(&src);
+
+        ret = fs_open(&src, dl->seg[i].path, FS_O_READ);
+        if (ret < 0) {
+            break;
+        }
+
+        while ((len = fs_read(&src, buf, size)) > 0) {
+#ifdef CONFIG_RPR_HASH_CALCULATION
+            mbedtls_sha256_update(&hash_ctx, buf, len);
+#endif
+            ret = fs_write(&dst, buf, len);
+            if (ret != len) {
+                ret = ret < 0 ? ret : -ENOSPC;
+                break;
+            }
+        }
+
+        ret = len < 0 ? len : ret;
+
+        fs_close(&src);
+        fs_unlink(dl->seg[i].path);
+    }
+
+    fs_close(&dst);
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    mbedtls_sha256_finish(&hash_ctx, dl->hash);
+    mbedtls_sha256_free(&hash_ctx);
+#endif
+
+    return ret < 0 ? ret : 0;
+}
+
+/**
+ * @brief Downloads the segments of a file and joins them.
+ *
+ * Each segment is written to a part file in the destination folder.
+ * Writing into the middle of a LittleFS file rewrites the rest of it, so
+ * the file is not preallocated. The joined file replaces the destination
+ * file only when complete; on failure the part files are removed and the
+ * destination file is left as it was.
+ *
+ * @param dl               Segmented file download.
+ * @param http_status_code Pointer to store the status of a failed segment.
+ *
+ * @return HTTP_CLIENT_OK on success, or an appropriate `http_status_t` error
+ *         code on failure.
+ */
+static http_status_t segmented_file(struct segmented_download *dl,
+                                    uint16_t                  *http_status_code)
+{
+    http_status_t ret_status = HTTP_CLIENT_OK;
+    int           opened     = 0;
+    int           ret        = 0;
+
+    for (; opened < dl->count; opened++) {
+        struct segment_context *seg = &dl->seg[opened];
+
+        snprintf(seg->path,
+                 sizeof(seg->path),
+                 "%s/" SEGMENT_PART_NAME "%d",
+                 dl->folder_path,
+                 opened);
+
+        fs_file_t_init(&seg->file);
+
+        ret = fs_open(&seg->file, seg->path, FS_O_CREATE | FS_O_WRITE);
+        if (ret < 0) {
+            LOG_ERR("Failed to open file for writing: %s", seg->path);
+            break;
+        }
+
+        ret = fs_truncate(&seg->file, 0);
+        if (ret < 0) {
+            LOG_ERR("Failed to truncate %s: %d", seg->path, ret);
+            fs_close(&seg->file);
+            break;
+        }
+    }
+
+    if (ret < 0) {
+        ret_status = HTTP_ERR_FILE_OPEN;
+    } else if (segmented_run(dl) < 0) {
+        ret_status = segmented_status(dl, http_status_code);
+    }
+
+    for (int i = 0; i < opened; i++) {
+        fs_close(&dl->seg[i].file);
+    }
+
+    if (ret_status == HTTP_CLIENT_OK) {
+        ret = segmented_join(dl);
+        if (ret < 0) {
+            LOG_ERR("Failed to join the segments: %d", ret);
+            ret_status = HTTP_ERR_FILE_OPEN;
+        }
+    }
+
+    if (ret_status == HTTP_CLIENT_OK) {
+        /* Replaces the old file, which is kept if the download fails */
+        ret = fs_rename(dl->seg[0].path, dl->filepath);
+        if (ret < 0) {
+            LOG_ERR("Failed to move the download to %s: %d",
+                    dl->filepath,
+                    ret);
+            ret_status = HTTP_ERR_FILE_OPEN;
+        }
+    }
+
+    if (ret_status != HTTP_CLIENT_OK) {
+        for (int i = 0; i < opened; i++) {
+            fs_unlink(dl->seg[i].path);
+        }
+    }
+
+    return ret_status;
+}
+
+/**
+ * @brief Downloads a file with several concurrent Range requests.
+ *
+ * @param url               Full HTTP or HTTPS URL of the file to download.
+ * @param base_dir          Base folder path where the file will be saved.
+ * @param http_status_code  Pointer to store the HTTP response status code.
+ * @param segments          Number of connections to use.
+ *
+ * @return HTTP_CLIENT_OK on success, or an appropriate `http_status_t` error code on failure.
+ */
+http_status_t http_download_file_segmented(const char *url,
+                                           const char *base_dir,
+                                           uint16_t   *http_status_code,
+                                           int         segments)
+{
+    if (!url || !base_dir || !http_status_code) {
+        LOG_ERR("Invalid arguments for segmented DOWNLOAD request");
+        return HTTP_ERR_INVALID_PARAM;
+    }
+
+    if (strlen(base_dir) >= CONFIG_RPR_FOLDER_PATH_MAX_LEN) {
+        LOG_ERR("Folder path is too long");
+        return HTTP_ERR_INVALID_PARAM;
+    }
+
+    struct segmented_download *dl = &segmented;
+
+    k_mutex_lock(&segmented_lock, K_FOREVER);
+
+    if (!segmented_begin(dl,
+                         HTTP_CTX_DOWNLOAD,
+                         url,
+                         base_dir,
+                         segments,
+                         http_status_code)) {
+        k_mutex_unlock(&segmented_lock);
+#ifdef CONFIG_RPR_HTTP_CACHE
+        if (*http_status_code == HTTP_STATUS_NOT_MODIFIED) {
+            return HTTP_CLIENT_OK;
+        }
+#endif
+        return http_download_file_request(url, base_dir, http_status_code);
+    }
+
+    LOG_INF("Starting file download in %d segments...", dl->count);
+
+    http_status_t ret_status = segmented_file(dl, http_status_code);
+
+    if (ret_status == HTTP_CLIENT_OK) {
+        *http_status_code = HTTP_STATUS_OK;
+        http_stats_count(&conn_stats.segmented);
+
+        LOG_INF("Download complete. Size: %u Bytes (%u KiB)",
+                dl->total,
+                bytes2KiB(dl->total));
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+        print_hash(dl->hash, HASH_SIZE_MAX_LEN);
+#endif
+
+        if (download_callback) {
+            download_callback(dl->filepath);
+        }
+
+#ifdef CONFIG_RPR_HTTP_CACHE
+        cache_store_file(&dl->cache_entry,
+                         url,
+                         &dl->seg[0].headers,
+                         dl->filepath);
+#endif
+    }
+
+    k_mutex_unlock(&segmented_lock);
+
+    return ret_status;
+}
+
+#ifdef CONFIG_RPR_MODULE_DFU
+#ifdef CONFIG_RPR_HASH_CALCULATION
+/**
+ * @brief Starts or releases the hashes of the received segment bytes.
+ *
+ * @param dl    Segmented update download.
+ * @param start true to start the hashes, false to release them.
+ */
+static void segmented_hash_setup(struct segmented_download *dl, bool start)
+{
+    for (int i = 0; i < dl->count; i++) {
+        if (start) {
+            mbedtls_sha256_init(&dl->seg[i].hash);
+            mbedtls_sha256_starts(&dl->seg[i].hash, 0);
+        } else {
+            mbedtls_sha256_free(&dl->seg[i].hash);
+        }
+    }
+}
+
+/**
+ * @brief Checks the image written to the update slot against the received
+ *        bytes.
+ *
+ * Each segment range is read back from the slot and its hash compared with
+ * the hash of the bytes received for the segment. The hash of the whole
+ * image is computed on the same pass.
+ *
+ * @param dl Segmented update download with all segments complete.
+ *
+ * @return 0 if every segment matches, -EBADMSG on a mismatch, other
+ *         negative error code if the slot cannot be read.
+ */
+static int segmented_check_slot(struct segmented_download *dl)
+{
+    uint8_t               *buf  = dl->seg[0].recv_buf;
+    size_t                 size = sizeof(dl->seg[0].recv_buf);
+    mbedtls_sha256_context hash_ctx;
+    mbedtls_sha256_context seg_ctx;
+    unsigned char          received[HASH_SIZE_MAX_LEN];
+    unsigned char          stored[HASH_SIZE_MAX_LEN];
+    int                    ret = 0;
+
+    mbedtls_sha256_init(&hash_ctx);
+    mbedtls_sha256_starts(&hash_ctx, 0);
+
+    for (int i = 0; i < dl->count && ret == 0; i++) {
+        struct segment_context *seg = &dl->seg[i];
+
+        mbedtls_sha256_init(&seg_ctx);
+        mbedtls_sha256_starts(&seg_ctx, 0);
+
+        for (uint32_t offset = seg->start; offset < seg->end && ret == 0;
+             offset += size) {
+            size_t len = MIN(size, seg->end - offset);
+
+            ret = dfu_update_slot_read(offset, buf, len);
+            if (ret == 0) {
+                mbedtls_sha256_update(&seg_ctx, buf, len);
+                mbedtls_sha256_update(&hash_ctx, buf, len);
+            }
+        }
+
+        mbedtls_sha256_finish(&seg_ctx, stored);
+        mbedtls_sha256_free(&seg_ctx);
+        mbedtls_sha256_finish(&seg->hash, received);
+
+        if (ret == 0 && memcmp(stored, received, HASH_SIZE_MAX_LEN) != 0) {
+            LOG_ERR("Segment %d: slot does not match the received data", i);
+            ret = -EBADMSG;
+        }
+    }
+
+    mbedtls_sha256_finish(&hash_ctx, dl->hash);
+    mbedtls_sha256_free(&hash_ctx);
+
+    return ret;
+}
+#endif // CONFIG_RPR_HASH_CALCULATION
+
+/**
+ * @brief Downloads a firmware update image with several concurrent Range
+ *        requests.
+ *
+ * @param url               Full HTTP or HTTPS URL of the file to download.
+ * @param http_status_code  Pointer to store the HTTP response status code.
+ * @param segments          Number of connections to use.
+ *
+ * @return HTTP_CLIENT_OK on success, or an appropriate `http_status_t` error code on failure.
+ */
+http_status_t http_download_update_segmented(const char *url,
+                                             uint16_t   *http_status_code,
+                                             int         segments)
+{
+    if (!url || !http_status_code) {
+        LOG_ERR("Invalid arguments for segmented UPDATE request");
+        return HTTP_ERR_INVALID_PARAM;
+    }
+
+    struct segmented_download *dl = &segmented;
+
+    k_mutex_lock(&segmented_lock, K_FOREVER);
+
+    if (!segmented_begin(
+                dl, HTTP_CTX_UPDATE, url, NULL, segments, http_status_code)) {
+        k_mutex_unlock(&segmented_lock);
+        return http_download_update_request(url, http_status_code);
+    }
+
+    http_status_t ret_status = HTTP_CLIENT_OK;
+
+    int ret = dfu_update_storage_init(&dl->dfu_ctx);
+    if (ret) {
+        LOG_ERR("Unable init flash storage: %d", ret);
+        k_mutex_unlock(&segmented_lock);
+        return HTTP_ERR_DFU_INIT;
+    }
+
+    LOG_INF("Starting update download in %d segments...", dl->count);
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    segmented_hash_setup(dl, true);
+#endif
+
+    if (segmented_run(dl) < 0) {
+        ret_status = segmented_status(dl, http_status_code);
+#ifdef CONFIG_RPR_HASH_CALCULATION
+        segmented_hash_setup(dl, false);
+#endif
+        k_mutex_unlock(&segmented_lock);
+        return ret_status;
+    }
+
+    *http_status_code = HTTP_STATUS_OK;
+    http_stats_count(&conn_stats.segmented);
+
+    LOG_INF("Download update complete. Size: %u Bytes (%u KiB)",
+            dl->total,
+            bytes2KiB(dl->total));
+
+#ifdef CONFIG_RPR_HASH_CALCULATION
+    ret = segmented_check_slot(dl);
+    segmented_hash_setup(dl, false);
+
+    if (ret == -EBADMSG) {
+        ret_status = HTTP_ERR_DFU_HASH_NOT_MATCH;
+    } else if (ret < 0) {
+        LOG_ERR("Unable to read back the update image: %d", ret);
+        ret_status = HTTP_ERR_DFU_INIT;
+    } else {
+        print_hash(dl->hash, HASH_SIZE_MAX_LEN);
+
+#ifdef CONFIG_RPR_IMAGE_INTEGRITY_CHECK
+        /* Every segment in the slot matched its received bytes, so the
+         * slot hash is the hash of the downloaded image */
+        if (dfu_update_flash_img_check(&dl->dfu_ctx, dl->hash, dl->total) <
+            0) {
+            ret_status = HTTP_ERR_DFU_HASH_NOT_MATCH;
+        }
+#endif
+    }
+#endif // CONFIG_RPR_HASH_CALCULATION
+
+    k_mutex_unlock(&segmented_lock);
+
+    return ret_status;
+}
+#endif // CONFIG_RPR_MODULE_DFU
@@ -0,0 +1,1081 @@
+/**
+ * @file http_sync.c
+ * @brief Synchronisation of a file directory with a manifest on a server.
+ *
+ * The files installed by the last sync are kept in a catalog, with the
+ * size and the hash the manifest gave for them. A file is current if the
+ * catalog holds the hash of the manifest and the file has its size; a
+ * file missing from the catalog is hashed and kept if it matches, so a
+ * lost catalog costs reading the files but not downloading them.
+ *
+ * Downloads go to a staging directory on the same file system. The commit
+ * writes a journal holding the new catalog, with every record flagged as
+ * staged or removed, and then moves the staged files in, deletes the
+ * removed ones, writes the catalog and deletes the journal. Every step can
+ * be repeated, so a journal found at start is applied again; a journal
+ * that fails its CRC was never complete and is dropped.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mbedtls/sha256.h"
+
+#include "http_json.h"
+#include "http_module.h"
+#include "http_sync.h"
+
+LOG_MODULE_DECLARE(http_module, CONFIG_RPR_MODULE_HTTP_LOG_LEVEL);
+
+#define SYNC_DIR          CONFIG_RPR_HTTP_SYNC_DIR
+#define SYNC_STAGE_DIR    SYNC_DIR "/stage"
+#define SYNC_CATALOG_PATH SYNC_DIR "/catalog.dat"
+#define SYNC_JOURNAL_PATH SYNC_DIR "/journal.dat"
+#define SYNC_MAX_FILES    CONFIG_RPR_HTTP_SYNC_MAX_FILES
+#define SYNC_NAME_LEN     CONFIG_RPR_FILENAME_MAX_LEN
+#define SYNC_DIR_LEN      CONFIG_RPR_FOLDER_PATH_MAX_LEN
+#define SYNC_PATH_LEN     (SYNC_DIR_LEN + SYNC_NAME_LEN)
+#define SYNC_HASH_LEN     32
+#define SYNC_READ_CHUNK   256
+
+#define SYNC_CATALOG_MAGIC 0x47544143 /* "CATG" */
+#define SYNC_JOURNAL_MAGIC 0x4C4E524A /* "JRNL" */
+
+#define SYNC_FILE_STAGED  BIT(0) /* Downloaded, moved in by the commit */
+#define SYNC_FILE_REMOVED BIT(1) /* Obsolete, deleted by the commit */
+#define SYNC_FILE_FETCH   BIT(2) /* Not current, to be downloaded */
+
+BUILD_ASSERT(sizeof(SYNC_STAGE_DIR) <= SYNC_DIR_LEN,
+             "The staging directory must fit a folder path");
+
+struct sync_file {
+    char     name[SYNC_NAME_LEN];
+    uint8_t  sha256[SYNC_HASH_LEN];
+    uint32_t size;
+    uint32_t priority; /* Download order, lower first */
+    uint32_t flags;    /* SYNC_FILE_*, 0 in the catalog */
+};
+
+struct sync_header {
+    uint32_t magic;
+    uint32_t version; /* Library version */
+    uint32_t count;   /* Records that follow */
+    char     dir[SYNC_DIR_LEN];
+    uint32_t crc; /* CRC-32 of the records, then of the fields above */
+};
+
+struct sync_manifest {
+    uint32_t         version;
+    size_t           count;
+    bool             in_files;
+    bool             has_files;
+    bool             has_name;
+    bool             has_size;
+    bool             has_hash;
+    struct sync_file file; /* Entry being read */
+};
+
+static struct sync_file       sync_files[SYNC_MAX_FILES];   /* Manifest */
+static struct sync_file       sync_catalog[SYNC_MAX_FILES]; /* Installed */
+static uint16_t               sync_order[SYNC_MAX_FILES];   /* To fetch */
+static uint8_t                sync_buf[SYNC_READ_CHUNK];
+static struct http_sync_stats sync_stats;
+
+K_MUTEX_DEFINE(sync_lock);
+K_MUTEX_DEFINE(sync_stats_lock);
+
+/**
+ * @brief Creates a directory if it does not exist.
+ *
+ * @param path Full path of the directory.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int sync_mkdir(const char *path)
+{
+    int ret = fs_mkdir(path);
+
+    if (ret < 0 && ret != -EEXIST) {
+        LOG_ERR("Failed to create %s: %d", path, ret);
+        return ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Writes a whole buffer to a file.
+ *
+ * @param file Open file.
+ * @param data Data to write.
+ * @param len  Length of the data.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int sync_write(struct fs_file_t *file, const void *data, size_t len)
+{
+    ssize_t ret = fs_write(file, data, len);
+
+    if (ret >= 0 && ret != len) {
+        ret = -ENOSPC;
+    }
+
+    return ret < 0 ? ret : 0;
+}
+
+/**
+ * @brief Finds a file by name.
+ *
+ * @param files Records to search.
+ * @param count Number of records.
+ * @param name  Name of the file.
+ *
+ * @return Index of the record, -1 if there is none.
+ */
+static int
+sync_find(const struct sync_file *files, size_t count, const char *name)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(files[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Checks that a file has the size and the hash of a record.
+ *
+ * @param path Full path of the file.
+ * @param file Expected size and hash.
+ *
+ * @return 0 if the file matches, -ENOENT if it does not exist, -EBADMSG
+ *         if it differs, negative error code if it cannot be read.
+ */
+static int sync_check_file(const char *path, const struct sync_file *file)
+{
+    struct fs_dirent       dirent;
+    struct fs_file_t       f;
+    mbedtls_sha256_context hash_ctx;
+    uint8_t                hash[SYNC_HASH_LEN];
+    ssize_t                len;
+
+    int ret = fs_stat(path, &dirent);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (dirent.type != FS_DIR_ENTRY_FILE || dirent.size != file->size) {
+        return -EBADMSG;
+    }
+
+    fs_file_t_init(&f);
+    ret = fs_open(&f, path, FS_O_READ);
+    if (ret < 0) {
+        return ret;
+    }
+
+    mbedtls_sha256_init(&hash_ctx);
+    mbedtls_sha256_starts(&hash_ctx, 0);
+
+    while ((len = fs_read(&f, sync_buf, sizeof(sync_buf))) > 0) {
+        mbedtls_sha256_update(&hash_ctx, sync_buf, len);
+    }
+
+    mbedtls_sha256_finish(&hash_ctx, hash);
+    mbedtls_sha256_free(&hash_ctx);
+    fs_close(&f);
+
+    if (len < 0) {
+        return len;
+    }
+
+    return memcmp(hash, file->sha256, SYNC_HASH_LEN) == 0 ? 0 : -EBADMSG;
+}
+
+/**
+ * @brief Reads a catalog or a journal and checks its CRC.
+ *
+ * @param file  File open at its start.
+ * @param magic Expected magic number.
+ * @param max   Largest number of records accepted.
+ * @param hdr   Pointer to store the header.
+ * @param files Array to store the records, NULL to only check them.
+ *
+ * @return 0 on success, -EBADMSG if the file is damaged or incomplete,
+ *         negative error code if it cannot be read.
+ */
+static int sync_read_table(struct fs_file_t   *file,
+                           uint32_t            magic,
+                           size_t              max,
+                           struct sync_header *hdr,
+                           struct sync_file   *files)
+{
+    struct sync_file rec;
+    uint32_t         crc = 0;
+
+    ssize_t len = fs_read(file, hdr, sizeof(*hdr));
+    if (len < 0) {
+        return len;
+    }
+
+    if (len != sizeof(*hdr) || hdr->magic != magic || hdr->count > max) {
+        return -EBADMSG;
+    }
+
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        struct sync_file *f = files ? &files[i] : &rec;
+
+        len = fs_read(file, f, sizeof(*f));
+        if (len < 0) {
+            return len;
+        }
+        if (len != sizeof(*f)) {
+            return -EBADMSG;
+        }
+
+        crc = crc32_ieee_update(crc, (const uint8_t *)f, sizeof(*f));
+        f->name[sizeof(f->name) - 1] = '\0';
+    }
+
+    crc = crc32_ieee_update(
+            crc, (const uint8_t *)hdr, offsetof(struct sync_header, crc));
+    if (crc != hdr->crc) {
+        return -EBADMSG;
+    }
+
+    hdr->dir[sizeof(hdr->dir) - 1] = '\0';
+
+    return 0;
+}
+
+/**
+ * @brief Reads the catalog of a directory.
+ *
+ * @param dir     Directory being synchronised.
+ * @param version Pointer to store the installed library version, 0 if none.
+ *
+ * @return Number of records read into sync_catalog, 0 if the catalog is
+ *         missing, damaged or belongs to another directory.
+ */
+static size_t sync_load_catalog(const char *dir, uint32_t *version)
+{
+    struct fs_file_t   file;
+    struct sync_header hdr;
+
+    *version = 0;
+
+    fs_file_t_init(&file);
+    if (fs_open(&file, SYNC_CATALOG_PATH, FS_O_READ) < 0) {
+        return 0;
+    }
+
+    int ret = sync_read_table(
+            &file, SYNC_CATALOG_MAGIC, SYNC_MAX_FILES, &hdr, sync_catalog);
+
+    fs_close(&file);
+
+    if (ret < 0) {
+        LOG_WRN("Sync catalog is not valid (%d), files are checked", ret);
+        return 0;
+    }
+
+    if (strcmp(hdr.dir, dir) != 0) {
+        return 0;
+    }
+
+    *version = hdr.version;
+    return hdr.count;
+}
+
+/**
+ * @brief Moves a staged file into the directory or deletes a removed one.
+ *
+ * Repeating it after it succeeded does nothing.
+ *
+ * @param dir Directory being synchronised.
+ * @param rec Record of the journal.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int sync_apply_file(const char *dir, const struct sync_file *rec)
+{
+    char             path[SYNC_PATH_LEN];
+    char             staged[SYNC_PATH_LEN];
+    struct fs_dirent dirent;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, rec->name);
+
+    if (rec->flags & SYNC_FILE_REMOVED) {
+        int ret = fs_unlink(path);
+
+        return ret == -ENOENT ? 0 : ret;
+    }
+
+    if (!(rec->flags & SYNC_FILE_STAGED)) {
+        return 0;
+    }
+
+    snprintf(staged, sizeof(staged), SYNC_STAGE_DIR "/%s", rec->name);
+
+    int ret = fs_rename(staged, path);
+
+    /* Moved before the journal was cut short */
+    if (ret == -ENOENT && fs_stat(path, &dirent) == 0) {
+        return 0;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Applies the journal if there is one.
+ *
+ * The catalog is written from the records that are not removed, with
+ * their flags cleared. The journal is deleted once all is done.
+ *
+ * @return 0 on success or if there is no complete journal, negative error
+ *         code otherwise; the journal is then kept for another attempt.
+ */
+static int sync_apply(void)
+{
+    struct fs_file_t   jnl;
+    struct fs_file_t   cat;
+    struct sync_header hdr;
+    struct sync_header cat_hdr = { .magic = SYNC_CATALOG_MAGIC };
+    struct sync_file   rec;
+
+    fs_file_t_init(&jnl);
+    int ret = fs_open(&jnl, SYNC_JOURNAL_PATH, FS_O_READ);
+    if (ret == -ENOENT) {
+        return 0;
+    }
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = sync_read_table(
+            &jnl, SYNC_JOURNAL_MAGIC, 2 * SYNC_MAX_FILES, &hdr, NULL);
+    if (ret == -EBADMSG) {
+        /* Cut before the commit, the old library stays */
+        fs_close(&jnl);
+        LOG_WRN("Dropping an incomplete sync journal");
+        return fs_unlink(SYNC_JOURNAL_PATH);
+    }
+    if (ret == 0) {
+        ret = fs_seek(&jnl, sizeof(hdr), FS_SEEK_SET);
+    }
+    if (ret < 0) {
+        fs_close(&jnl);
+        return ret;
+    }
+
+    LOG_INF("Committing library version %u of %s", hdr.version, hdr.dir);
+
+    cat_hdr.version = hdr.version;
+    memcpy(cat_hdr.dir, hdr.dir, sizeof(cat_hdr.dir));
+
+    fs_file_t_init(&cat);
+    ret = fs_open(&cat, SYNC_CATALOG_PATH, FS_O_CREATE | FS_O_WRITE);
+    if (ret < 0) {
+        fs_close(&jnl);
+        return ret;
+    }
+
+    /* The header is written again once the records are counted */
+    ret = fs_truncate(&cat, 0);
+    if (ret == 0) {
+        ret = sync_write(&cat, &cat_hdr, sizeof(cat_hdr));
+    }
+
+    for (uint32_t i = 0; i < hdr.count && ret == 0; i++) {
+        ssize_t len = fs_read(&jnl, &rec, sizeof(rec));
+        if (len != sizeof(rec)) {
+            ret = len < 0 ? len : -EIO;
+            break;
+        }
+        rec.name[sizeof(rec.name) - 1] = '\0';
+
+        ret = sync_apply_file(hdr.dir, &rec);
+        if (ret < 0) {
+            LOG_ERR("Failed to commit %s: %d", rec.name, ret);
+            break;
+        }
+
+        if (rec.flags & SYNC_FILE_REMOVED) {
+            continue;
+        }
+
+        rec.flags = 0;
+        cat_hdr.count++;
+        cat_hdr.crc = crc32_ieee_update(
+                cat_hdr.crc, (const uint8_t *)&rec, sizeof(rec));
+        ret = sync_write(&cat, &rec, sizeof(rec));
+    }
+
+    if (ret == 0) {
+        cat_hdr.crc = crc32_ieee_update(cat_hdr.crc,
+                                        (const uint8_t *)&cat_hdr,
+                                        offsetof(struct sync_header, crc));
+        ret = fs_seek(&cat, 0, FS_SEEK_SET);
+    }
+    if (ret == 0) {
+        ret = sync_write(&cat, &cat_hdr, sizeof(cat_hdr));
+    }
+
+    fs_close(&cat);
+    fs_close(&jnl);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    return fs_unlink(SYNC_JOURNAL_PATH);
+}
+
+/**
+ * @brief Writes the journal of a commit.
+ *
+ * @param dir     Directory being synchronised.
+ * @param version Library version of the manifest.
+ * @param count   Number of files in the manifest.
+ * @param catalog Number of records in the catalog.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int sync_write_journal(const char *dir,
+                              uint32_t    version,
+                              size_t      count,
+                              size_t      catalog)
+{
+    struct fs_file_t   file;
+    struct sync_header hdr = {
+        .magic   = SYNC_JOURNAL_MAGIC,
+        .version = version,
+        .count   = count,
+    };
+
+    strncpy(hdr.dir, dir, sizeof(hdr.dir) - 1);
+
+    for (size_t i = 0; i < count; i++) {
+        hdr.crc = crc32_ieee_update(hdr.crc,
+                                    (const uint8_t *)&sync_files[i],
+                                    sizeof(sync_files[i]));
+    }
+    for (size_t i = 0; i < catalog; i++) {
+        if (sync_catalog[i].flags & SYNC_FILE_REMOVED) {
+            hdr.count++;
+            hdr.crc = crc32_ieee_update(hdr.crc,
+                                        (const uint8_t *)&sync_catalog[i],
+                                        sizeof(sync_catalog[i]));
+        }
+    }
+    hdr.crc = crc32_ieee_update(
+            hdr.crc, (const uint8_t *)&hdr, offsetof(struct sync_header, crc));
+
+    fs_file_t_init(&file);
+    int ret = fs_open(&file, SYNC_JOURNAL_PATH, FS_O_CREATE | FS_O_WRITE);
+    if (ret < 0) {
+        LOG_ERR("Failed to open %s: %d", SYNC_JOURNAL_PATH, ret);
+        return ret;
+    }
+
+    ret = fs_truncate(&file, 0);
+    if (ret == 0) {
+        ret = sync_write(&file, &hdr, sizeof(hdr));
+    }
+    for (size_t i = 0; i < count && ret == 0; i++) {
+        ret = sync_write(&file, &sync_files[i], sizeof(sync_files[i]));
+    }
+    for (size_t i = 0; i < catalog && ret == 0; i++) {
+        if (sync_catalog[i].flags & SYNC_FILE_REMOVED) {
+            ret = sync_write(&file, &sync_catalog[i], sizeof(sync_catalog[i]));
+        }
+    }
+
+    /* The journal is complete once closed */
+    fs_close(&file);
+
+    if (ret < 0) {
+        LOG_ERR("Failed to write %s: %d", SYNC_JOURNAL_PATH, ret);
+        fs_unlink(SYNC_JOURNAL_PATH);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Parses a non-negative integer member of the manifest.
+ *
+ * @param tok   Number value.
+ * @param value Pointer to store the value.
+ *
+ * @return 0 on success, -EBADMSG if it is not a 32-bit unsigned integer.
+ */
+static int sync_parse_u32(const struct http_json_token *tok, uint32_t *value)
+{
+    char         *end;
+    unsigned long v;
+
+    if (tok->event != HTTP_JSON_NUMBER || tok->truncated ||
+        tok->value[0] == '-') {
+        return -EBADMSG;
+    }
+
+    v = strtoul(tok->value, &end, 10);
+    if (*end != '\0' || v > UINT32_MAX) {
+        return -EBADMSG;
+    }
+
+    *value = v;
+    return 0;
+}
+
+/**
+ * @brief Adds the entry read to the files of the manifest.
+ *
+ * @param man Manifest being parsed.
+ *
+ * @return 0 on success, -EBADMSG if the entry is incomplete, its name is
+ *         not a plain file name or is listed twice, -ENOMEM if there are
+ *         too many files.
+ */
+static int sync_manifest_add(struct sync_manifest *man)
+{
+    struct sync_file *file = &man->file;
+
+    if (!man->has_name || !man->has_size || !man->has_hash ||
+        strchr(file->name, '/') || strcmp(file->name, ".") == 0 ||
+        strcmp(file->name, "..") == 0) {
+        LOG_ERR("Manifest entry %zu is not valid", man->count + 1);
+        return -EBADMSG;
+    }
+
+    if (sync_find(sync_files, man->count, file->name) >= 0) {
+        LOG_ERR("%s is listed twice", file->name);
+        return -EBADMSG;
+    }
+
+    if (man->count >= SYNC_MAX_FILES) {
+        LOG_ERR("Manifest lists more than %d files", SYNC_MAX_FILES);
+        return -ENOMEM;
+    }
+
+    sync_files[man->count++] = *file;
+    return 0;
+}
+
+/**
+ * @brief Takes the version and the files of the manifest.
+ *
+ * @param tok       Parsed value.
+ * @param user_data Pointer to a sync_manifest structure.
+ *
+ * @return 0 to continue, negative error code if the manifest is not valid.
+ */
+static int sync_manifest_cb(const struct http_json_token *tok, void *user_data)
+{
+    struct sync_manifest *man  = user_data;
+    struct sync_file     *file = &man->file;
+
+    if (tok->depth == 1) {
+        if (tok->key && strcmp(tok->key, "version") == 0) {
+            return sync_parse_u32(tok, &man->version);
+        }
+        if (tok->event == HTTP_JSON_ARRAY_START && tok->key &&
+            strcmp(tok->key, "files") == 0) {
+            man->in_files  = true;
+            man->has_files = true;
+        } else if (tok->event == HTTP_JSON_ARRAY_END) {
+            man->in_files = false;
+        }
+        return 0;
+    }
+
+    if (!man->in_files) {
+        return 0;
+    }
+
+    if (tok->depth == 2 && tok->event == HTTP_JSON_OBJECT_START) {
+        memset(file, 0, sizeof(*file));
+        man->has_name = false;
+        man->has_size = false;
+        man->has_hash = false;
+    } else if (tok->depth == 2 && tok->event == HTTP_JSON_OBJECT_END) {
+        return sync_manifest_add(man);
+    } else if (tok->depth == 3 && tok->key) {
+        if (strcmp(tok->key, "name") == 0) {
+            if (tok->event != HTTP_JSON_STRING || tok->truncated ||
+                tok->len == 0 || tok->len >= sizeof(file->name)) {
+                return -EBADMSG;
+            }
+            memcpy(file->name, tok->value, tok->len);
+            man->has_name = true;
+        } else if (strcmp(tok->key, "size") == 0) {
+            man->has_size = true;
+            return sync_parse_u32(tok, &file->size);
+        } else if (strcmp(tok->key, "sha256") == 0) {
+            if (tok->event != HTTP_JSON_STRING ||
+                tok->len != 2 * SYNC_HASH_LEN ||
+                hex2bin(tok->value, tok->len, file->sha256, SYNC_HASH_LEN) !=
+                        SYNC_HASH_LEN) {
+                return -EBADMSG;
+            }
+            man->has_hash = true;
+        } else if (strcmp(tok->key, "priority") == 0) {
+            return sync_parse_u32(tok, &file->priority);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Passes a fragment of the manifest to the JSON parser.
+ *
+ * @param data      Fragment of the body.
+ * @param len       Length of the fragment.
+ * @param user_data Pointer to the http_json_parser.
+ */
+static void sync_manifest_body(const uint8_t *data, size_t len, void *user_data)
+{
+    /* Errors are kept by the parser and reported by http_json_finish() */
+    http_json_write(user_data, (const char *)data, len);
+}
+
+/**
+ * @brief Downloads and parses the manifest into sync_files.
+ *
+ * @param url URL of the manifest.
+ * @param man Pointer to store the manifest.
+ *
+ * @return 0 on success, -EIO if the request failed, -EBADMSG or -ENOMEM
+ *         if the manifest is not valid.
+ */
+static int sync_get_manifest(const char *url, struct sync_manifest *man)
+{
+    struct http_json_parser parser;
+    uint16_t                http_status_code = 0;
+
+    struct get_context get_ctx = {
+        .body_cb   = sync_manifest_body,
+        .user_data = &parser,
+        .cache     = true,
+    };
+
+    memset(man, 0, sizeof(*man));
+    http_json_init(&parser, sync_manifest_cb, man);
+
+    http_status_t ret = http_get_request(url, &get_ctx, &http_status_code);
+
+    if (ret != HTTP_CLIENT_OK ||
+        (http_status_code != 200 && http_status_code != 304)) {
+        LOG_ERR("Manifest request failed: ret=%d, status %u",
+                ret,
+                http_status_code);
+        return -EIO;
+    }
+
+    int err = http_json_finish(&parser);
+    if (err < 0) {
+        LOG_ERR("Manifest is not valid: %d", err);
+        return err;
+    }
+
+    if (!man->has_files) {
+        LOG_ERR("Manifest has no file list");
+        return -EBADMSG;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Orders the files to fetch by priority, then by size.
+ *
+ * @param count Number of entries in sync_order.
+ */
+static void sync_sort(size_t count)
+{
+    for (size_t i = 1; i < count; i++) {
+        uint16_t                index = sync_order[i];
+        const struct sync_file *file  = &sync_files[index];
+        size_t                  j     = i;
+
+        for (; j > 0; j--) {
+            const struct sync_file *prev = &sync_files[sync_order[j - 1]];
+
+            if (prev->priority < file->priority ||
+                (prev->priority == file->priority &&
+                 prev->size <= file->size)) {
+                break;
+            }
+            sync_order[j] = sync_order[j - 1];
+        }
+        sync_order[j] = index;
+    }
+}
+
+/**
+ * @brief Deletes the staged files no file to fetch is named after.
+ *
+ * The directory is read again after every deletion.
+ *
+ * @param count Number of files in the manifest.
+ */
+static void sync_clean_stage(size_t count)
+{
+    struct fs_dir_t  dir;
+    struct fs_dirent entry;
+    char             path[SYNC_PATH_LEN];
+    bool             found;
+
+    do {
+        found = false;
+
+        fs_dir_t_init(&dir);
+        if (fs_opendir(&dir, SYNC_STAGE_DIR) < 0) {
+            return;
+        }
+
+        while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != '\0') {
+            if (entry.type != FS_DIR_ENTRY_FILE) {
+                continue;
+            }
+
+            int i = sync_find(sync_files, count, entry.name);
+            if (i < 0 || !(sync_files[i].flags & SYNC_FILE_FETCH)) {
+                found = true;
+                break;
+            }
+        }
+
+        fs_closedir(&dir);
+
+        if (found) {
+            snprintf(path, sizeof(path), SYNC_STAGE_DIR "/%s", entry.name);
+            LOG_DBG("Dropping staged %s", entry.name);
+            found = fs_unlink(path) == 0;
+        }
+    } while (found);
+}
+
+/**
+ * @brief Checks that the files to fetch fit on the file system.
+ *
+ * @param count Number of entries in sync_order.
+ *
+ * @return 0 if they fit, -ENOSPC if they do not, negative error code if
+ *         the free space cannot be read.
+ */
+static int sync_check_space(size_t count)
+{
+    struct fs_statvfs st;
+    uint32_t          blocks = 0;
+
+    int ret = fs_statvfs(SYNC_DIR, &st);
+    if (ret < 0) {
+        return ret;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const struct sync_file *file = &sync_files[sync_order[i]];
+
+        if (!(file->flags & SYNC_FILE_STAGED)) {
+            blocks += DIV_ROUND_UP(file->size, st.f_frsize);
+        }
+    }
+
+    if (blocks > st.f_bfree) {
+        LOG_ERR("%u blocks to fetch, %lu free", blocks, st.f_bfree);
+        return -ENOSPC;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Downloads a file into the staging directory and checks it.
+ *
+ * @param base_url URL the file name is appended to.
+ * @param file     File of the manifest.
+ *
+ * @return 0 on success, -EIO if the download failed, -EBADMSG if the file
+ *         does not match the manifest.
+ */
+static int sync_fetch(const char *base_url, const struct sync_file *file)
+{
+    char     url[CONFIG_RPR_HTTP_MAX_URL_LENGTH];
+    char     staged[SYNC_PATH_LEN];
+    uint16_t http_status_code = 0;
+
+    int len = snprintf(url, sizeof(url), "%s%s", base_url, file->name);
+    if (len < 0 || len >= sizeof(url)) {
+        LOG_ERR("URL of %s is too long", file->name);
+        return -EINVAL;
+    }
+
+    snprintf(staged, sizeof(staged), SYNC_STAGE_DIR "/%s", file->name);
+
+    LOG_INF("Fetching %s (%u bytes)", file->name, file->size);
+
+    http_status_t ret =
+            http_download_file_request(url, SYNC_STAGE_DIR, &http_status_code);
+    if (ret != HTTP_CLIENT_OK) {
+        LOG_ERR("Download of %s failed: %d", file->name, ret);
+        return -EIO;
+    }
+
+    int err = sync_check_file(staged, file);
+    if (err < 0) {
+        LOG_ERR("%s does not match the manifest: %d", file->name, err);
+        fs_unlink(staged);
+        return -EBADMSG;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Runs a sync with the lock held.
+ *
+ * @param manifest_url URL of the manifest.
+ * @param base_url     URL the file names are appended to.
+ * @param dir          Directory to synchronise.
+ * @param run          Statistics of the sync to fill.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+static int sync_run(const char             *manifest_url,
+                    const char             *base_url,
+                    const char             *dir,
+                    struct http_sync_stats *run)
+{
+    struct sync_manifest man;
+    char                 path[SYNC_PATH_LEN];
+    uint32_t             installed;
+    size_t               fetches = 0;
+
+    int ret = sync_apply();
+    if (ret < 0) {
+        LOG_ERR("Failed to apply the sync journal: %d", ret);
+        return ret;
+    }
+
+    ret = sync_mkdir(SYNC_DIR);
+    if (ret == 0) {
+        ret = sync_mkdir(SYNC_STAGE_DIR);
+    }
+    if (ret == 0) {
+        ret = sync_mkdir(dir);
+    }
+    if (ret < 0) {
+        return ret;
+    }
+
+    size_t catalog = sync_load_catalog(dir, &installed);
+
+    run->version = installed;
+
+    ret = sync_get_manifest(manifest_url, &man);
+    if (ret < 0) {
+        return ret;
+    }
+
+    run->files = man.count;
+
+    bool changed = man.version != installed || man.count != catalog;
+
+    for (size_t i = 0; i < man.count; i++) {
+        struct sync_file *file = &sync_files[i];
+        struct fs_dirent  dirent;
+
+        snprintf(path, sizeof(path), "%s/%s", dir, file->name);
+
+        int  c       = sync_find(sync_catalog, catalog, file->name);
+        bool current = c >= 0 && sync_catalog[c].size == file->size &&
+                       memcmp(sync_catalog[c].sha256,
+                              file->sha256,
+                              SYNC_HASH_LEN) == 0 &&
+                       fs_stat(path, &dirent) == 0 &&
+                       dirent.size == file->size;
+
+        if (!current) {
+            changed = true;
+
+            /* A matching file put there by other means is taken over */
+            if (sync_check_file(path, file) < 0) {
+                file->flags |= SYNC_FILE_FETCH;
+                sync_order[fetches++] = i;
+                continue;
+            }
+        }
+
+        run->kept++;
+        run->kept_bytes += file->size;
+    }
+
+    for (size_t i = 0; i < catalog; i++) {
+        if (sync_find(sync_files, man.count, sync_catalog[i].name) < 0) {
+            sync_catalog[i].flags = SYNC_FILE_REMOVED;
+            run->removed++;
+            changed = true;
+        }
+    }
+
+    if (!changed) {
+        LOG_INF("Library version %u is current", man.version);
+        return 0;
+    }
+
+    sync_clean_stage(man.count);
+    sync_sort(fetches);
+
+    /* What a failed sync left staged is not fetched again */
+    for (size_t i = 0; i < fetches; i++) {
+        struct sync_file *file = &sync_files[sync_order[i]];
+
+        snprintf(path, sizeof(path), SYNC_STAGE_DIR "/%s", file->name);
+
+        ret = sync_check_file(path, file);
+        if (ret == 0) {
+            file->flags |= SYNC_FILE_STAGED;
+            run->reused++;
+            run->kept_bytes += file->size;
+        } else if (ret != -ENOENT) {
+            fs_unlink(path);
+        }
+    }
+
+    ret = sync_check_space(fetches);
+    if (ret < 0) {
+        return ret;
+    }
+
+    for (size_t i = 0; i < fetches; i++) {
+        struct sync_file *file = &sync_files[sync_order[i]];
+
+        if (file->flags & SYNC_FILE_STAGED) {
+            continue;
+        }
+
+        ret = sync_fetch(base_url, file);
+        if (ret < 0) {
+            return ret;
+        }
+
+        file->flags |= SYNC_FILE_STAGED;
+        run->fetched++;
+        run->fetched_bytes += file->size;
+    }
+
+    ret = sync_write_journal(dir, man.version, man.count, catalog);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = sync_apply();
+    if (ret < 0) {
+        LOG_ERR("Failed to commit, retried at the next sync: %d", ret);
+        return ret;
+    }
+
+    run->version = man.version;
+
+    LOG_INF("Library version %u: %u kept, %u fetched, %u removed",
+            man.version,
+            run->kept + run->reused,
+            run->fetched,
+            run->removed);
+    return 0;
+}
+
+/**
+ * @brief Brings a directory in line with a manifest.
+ *
+ * @param manifest_url URL of the manifest.
+ * @param base_url     URL the file names are appended to for the download.
+ * @param dir          Directory to synchronise.
+ * @param stats        Pointer to store the statistics of the sync, may be
+ *                     NULL.
+ *
+ * @return 0 on success, -EBUSY if a sync is running, negative error code
+ *         otherwise.
+ */
+int http_sync_run(const char             *manifest_url,
+                  const char             *base_url,
+                  const char             *dir,
+                  struct http_sync_stats *stats)
+{
+    struct http_sync_stats run   = { 0 };
+    int64_t                start = k_uptime_get();
+
+    if (!manifest_url || !base_url || !dir || strlen(dir) >= SYNC_DIR_LEN) {
+        return -EINVAL;
+    }
+
+    if (k_mutex_lock(&sync_lock, K_NO_WAIT) != 0) {
+        return -EBUSY;
+    }
+
+    int ret = sync_run(manifest_url, base_url, dir, &run);
+
+    k_mutex_unlock(&sync_lock);
+
+    run.result      = ret;
+    run.duration_ms = k_uptime_get() - start;
+
+    k_mutex_lock(&sync_stats_lock, K_FOREVER);
+    sync_stats = run;
+    k_mutex_unlock(&sync_stats_lock);
+
+    if (stats) {
+        *stats = run;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Applies the journal of a sync cut by a power loss.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int http_sync_recover(void)
+{
+    k_mutex_lock(&sync_lock, K_FOREVER);
+
+    int ret = sync_apply();
+
+    k_mutex_unlock(&sync_lock);
+
+    if (ret < 0) {
+        LOG_ERR("Failed to apply the sync journal: %d", ret);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Gets the statistics of the last sync.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void http_sync_get_stats(struct http_sync_stats *stats)
+{
+    k_mutex_lock(&sync_stats_lock, K_FOREVER);
+    *stats = sync_stats;
+    k_mutex_unlock(&sync_stats_lock);
+}
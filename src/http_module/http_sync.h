@@ -0,0 +1,83 @@
+/**
+ * @file http_sync.h
+ * @brief Synchronisation of a file directory with a manifest on a server.
+ *
+ * The manifest lists the files the directory should hold, with their size
+ * and SHA-256 hash, and the version of the whole library:
+ *   {"version":7,"files":[{"name":"a.wav","size":1024,
+ *    "sha256":"<64 hex digits>","priority":0}]}
+ * The optional priority orders the downloads, lower first; files of the
+ * same priority are fetched smallest first.
+ *
+ * A sync downloads only the files that are new or changed, into a staging
+ * directory, and checks their hash. Files that an earlier sync installed
+ * and the manifest no longer lists are deleted; files put into the
+ * directory by other means are left alone. The changes are first written
+ * to a journal and then applied, so a power loss leaves either the old or
+ * the new library once the journal is replayed.
+ *
+ * @author Eugene K.
+ * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
+ */
+
+#ifndef _HTTP_SYNC_H_
+#define _HTTP_SYNC_H_
+
+#include <stdint.h>
+
+struct http_sync_stats {
+    uint32_t version;       /* Library version of the last commit */
+    uint32_t files;         /* Files in the manifest */
+    uint32_t kept;          /* Files that were already current */
+    uint32_t reused;        /* Files found complete in the staging area */
+    uint32_t fetched;       /* Files downloaded */
+    uint32_t removed;       /* Obsolete files deleted */
+    uint32_t kept_bytes;    /* Bytes not transferred, kept or reused */
+    uint32_t fetched_bytes; /* Bytes of the downloaded files */
+    uint32_t duration_ms;   /* Time of the sync */
+    int      result;        /* 0 or the error code of the sync */
+};
+
+/**
+ * @brief Brings a directory in line with a manifest.
+ *
+ * A journal left by an interrupted sync is applied first. Files already
+ * downloaded by a failed sync are kept in the staging directory and, with
+ * CONFIG_RPR_HTTP_RESUME, a cut download is continued, so the next call
+ * does not transfer them again.
+ *
+ * @param manifest_url URL of the manifest.
+ * @param base_url     URL the file names are appended to for the download.
+ * @param dir          Directory to synchronise.
+ * @param stats        Pointer to store the statistics of the sync, may be
+ *                     NULL.
+ *
+ * @return 0 on success, -EBUSY if a sync is running, -EIO if a request
+ *         failed, -EBADMSG if the manifest is malformed or a file does not
+ *         match it, -ENOMEM if the manifest lists more than
+ *         CONFIG_RPR_HTTP_SYNC_MAX_FILES files, -ENOSPC if the new files
+ *         do not fit, negative error code if the file system fails.
+ */
+int http_sync_run(const char             *manifest_url,
+                  const char             *base_url,
+                  const char             *dir,
+                  struct http_sync_stats *stats);
+
+/**
+ * @brief Applies the journal of a sync cut by a power loss.
+ *
+ * Does nothing if there is none. Call at start, once the file system is
+ * mounted.
+ *
+ * @return 0 on success, negative error code otherwise.
+ */
+int http_sync_recover(void);
+
+/**
+ * @brief Gets the statistics of the last sync.
+ *
+ * @param stats Pointer to store the statistics.
+ */
+void http_sync_get_stats(struct http_sync_stats *stats);
+
+#endif /* _HTTP_SYNC_H_ */
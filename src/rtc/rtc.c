@@ -12,10 +12,12 @@
  * @copyright (C) 2025 Alnicko Lab OU. All rights reserved.
  */
 
+#include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/sys/util.h>
 #include <zephyr/init.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/timeutil.h>
 #include <time.h>
 #include "rtc.h"
 
@@ -24,6 +26,9 @@ LOG_MODULE_REGISTER(rtc, CONFIG_RPR_MODULE_RTC_LOG_LEVEL);
 #define RTC_YEAR_OFFSET  1900
 #define RTC_MONTH_OFFSET 1
 
+#define RTC_SYNC_POLL_US  500
+#define RTC_SYNC_LIMIT_MS 1100
+
 #define RTC_DEVICE_NODE DT_ALIAS(rtc)
 #define RTC_DEVICE_SPEC DEVICE_DT_GET(RTC_DEVICE_NODE)
 
@@ -125,6 +130,82 @@ int get_date_time(struct rtc_time *rtc_data)
     return ret;
 }
 
+/**
+ * @brief Get the current RTC time as seconds since 1970-01-01.
+ *
+ * @param epoch Pointer to store the time.
+ *
+ * @return 0 on success, negative error code on failure.
+ */
+int get_epoch_time(int64_t *epoch)
+{
+    if (!rtc_cfg.is_ready) {
+        return -ENODEV;
+    }
+
+    if (!epoch) {
+        return -EINVAL;
+    }
+
+    struct rtc_time rtc_data;
+    int             ret = rtc_get_time(rtc_cfg.rtc, &rtc_data);
+    if (ret < 0) {
+        return ret;
+    }
+
+    *epoch = timeutil_timegm64(rtc_time_to_tm(&rtc_data));
+
+    return 0;
+}
+
+/**
+ * @brief Wait for the next RTC second boundary.
+ *
+ * The RTC only reports whole seconds, so the sub-second phase is found by
+ * polling until the second changes. The returned pair maps the RTC time
+ * to the system uptime with about one millisecond of error.
+ *
+ * @param epoch     Pointer to store the RTC time right after the boundary.
+ * @param uptime_us Pointer to store the uptime of the boundary in us.
+ *
+ * @return 0 on success, negative error code on failure.
+ */
+int rtc_sync_second(int64_t *epoch, int64_t *uptime_us)
+{
+    int64_t start;
+    int64_t now;
+    int     ret;
+
+    if (!epoch || !uptime_us) {
+        return -EINVAL;
+    }
+
+    ret = get_epoch_time(&start);
+    if (ret < 0) {
+        return ret;
+    }
+
+    int64_t deadline = k_uptime_get() + RTC_SYNC_LIMIT_MS;
+
+    do {
+        k_usleep(RTC_SYNC_POLL_US);
+
+        ret = get_epoch_time(&now);
+        if (ret < 0) {
+            return ret;
+        }
+
+        if (now != start) {
+            *epoch     = now;
+            *uptime_us = k_ticks_to_us_floor64(k_uptime_ticks());
+            return 0;
+        }
+    } while (k_uptime_get() < deadline);
+
+    LOG_ERR("RTC second did not change");
+    return -ETIMEDOUT;
+}
+
 /**
  * @brief Initialize the RTC module.
  *
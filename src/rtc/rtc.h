@@ -41,4 +41,27 @@ int set_date_time(struct rtc_time *rtc_data);
  */
 int get_date_time(struct rtc_time *rtc_data);
 
+/**
+ * @brief Get the current RTC time as seconds since 1970-01-01.
+ *
+ * @param epoch Pointer to store the time.
+ *
+ * @return 0 on success, negative error code on failure.
+ */
+int get_epoch_time(int64_t *epoch);
+
+/**
+ * @brief Wait for the next RTC second boundary.
+ *
+ * The RTC only reports whole seconds, so the sub-second phase is found by
+ * polling until the second changes. The returned pair maps the RTC time
+ * to the system uptime with about one millisecond of error.
+ *
+ * @param epoch     Pointer to store the RTC time right after the boundary.
+ * @param uptime_us Pointer to store the uptime of the boundary in us.
+ *
+ * @return 0 on success, negative error code on failure.
+ */
+int rtc_sync_second(int64_t *epoch, int64_t *uptime_us);
+
 #endif // __RTC_MODULE_H__
\ No newline at end of file